@@ -0,0 +1,15 @@
+#include <config.hpp>
+#include <utility.hpp>
+#include <benchmark/benchmark.h>
+
+
+int main(int argc, char **argv) {
+	Config::init("krisp_benchmarks");
+	Utility::set_test_mode();
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv))
+		return 1;
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
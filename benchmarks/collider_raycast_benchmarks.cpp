@@ -0,0 +1,97 @@
+#include <entity_component_system/ecs.hpp>
+#include <collision/collider.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int RAY_COUNT = 64;
+
+// Unit colliders scattered through a cube whose volume grows with the
+// collider count, so density (and therefore hits per ray) stays comparable
+struct ColliderScene
+{
+	explicit ColliderScene(const int64_t count)
+	{
+		std::mt19937 generator(1234);
+		const float extent = std::cbrt(static_cast<float>(count)) * 2.0f;
+		std::uniform_real_distribution<float> position(0.0f, extent);
+		ids.reserve(count);
+		for (int64_t index = 0; index < count; ++index)
+		{
+			const EntityID id = EntityID::generate_new_id();
+			ecs.add_transformation(id);
+			ecs.set_position(id, { position(generator), position(generator), position(generator) });
+			if (index % 2 == 0)
+				ecs.add_collider(id, std::make_unique<BoxCollider>());
+			else
+				ecs.add_collider(id, std::make_unique<SphereCollider>(Maths::Sphere(Maths::zero_vec, 0.5f)));
+			ids.push_back(id);
+		}
+
+		// picking rays cast from outside the volume, as a camera would
+		const glm::vec3 eye(extent * 0.5f, extent * 0.5f, -extent);
+		for (int index = 0; index < RAY_COUNT; ++index)
+		{
+			const glm::vec3 target(position(generator), position(generator), position(generator));
+			rays.emplace_back(eye, glm::normalize(target - eye));
+		}
+	}
+
+	ECS ecs;
+	std::vector<EntityID> ids;
+	std::vector<Maths::Ray> rays;
+};
+
+// Baseline: the candidate overload tests every collider individually
+void collider_raycast_linear_scan(benchmark::State& state)
+{
+	ColliderScene scene(state.range(0));
+	for (auto _ : state)
+		for (const auto& ray : scene.rays)
+			benchmark::DoNotOptimize(scene.ecs.raycast(ray, scene.ids));
+	state.SetItemsProcessed(state.iterations() * RAY_COUNT);
+}
+
+void collider_raycast_bvh(benchmark::State& state)
+{
+	ColliderScene scene(state.range(0));
+	// builds the BVH
+	scene.ecs.raycast(scene.rays.front());
+	for (auto _ : state)
+		for (const auto& ray : scene.rays)
+			benchmark::DoNotOptimize(scene.ecs.raycast(ray));
+	state.SetItemsProcessed(state.iterations() * RAY_COUNT);
+}
+
+// Moves 1% of the colliders before each batch of rays to include the cost of
+// refreshing their BVH leaves
+void collider_raycast_bvh_with_motion(benchmark::State& state)
+{
+	ColliderScene scene(state.range(0));
+	scene.ecs.raycast(scene.rays.front());
+	const size_t moving_count = std::max<size_t>(scene.ids.size() / 100, 1);
+	float offset = 0.0f;
+	for (auto _ : state)
+	{
+		offset = offset > 0.0f ? -0.25f : 0.25f;
+		for (size_t index = 0; index < moving_count; ++index)
+		{
+			const EntityID id = scene.ids[index * 100 % scene.ids.size()];
+			scene.ecs.set_position(id, scene.ecs.get_position(id) + glm::vec3(offset, 0.0f, 0.0f));
+		}
+		for (const auto& ray : scene.rays)
+			benchmark::DoNotOptimize(scene.ecs.raycast(ray));
+	}
+	state.SetItemsProcessed(state.iterations() * RAY_COUNT);
+}
+}
+
+BENCHMARK(collider_raycast_linear_scan)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(collider_raycast_bvh)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(collider_raycast_bvh_with_motion)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
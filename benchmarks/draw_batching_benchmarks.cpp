@@ -0,0 +1,86 @@
+#include <graphics_engine/render_draw_list.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+constexpr int TILESET_SIDE = 100;
+
+// A 100x100 grid of tiles in sort order, split evenly between the given number
+// of tile kinds, each kind with its own mesh
+struct TilesetScene
+{
+	explicit TilesetScene(const int64_t kind_count)
+	{
+		for (int64_t kind = 0; kind < kind_count; ++kind)
+			definitions.push_back(std::make_shared<const RenderableDefinition>(RenderableDefinition{
+				.pipeline_render_type = ERenderType::STANDARD,
+			}));
+
+		const int64_t tile_count = TILESET_SIDE * TILESET_SIDE;
+		items.reserve(tile_count);
+		for (int64_t index = 0; index < tile_count; ++index)
+		{
+			const int64_t kind = index * kind_count / tile_count;
+			const glm::vec3 position(static_cast<float>(index % TILESET_SIDE), 0.0f, static_cast<float>(index / TILESET_SIDE));
+			states.push_back({
+				.definition = definitions[kind],
+				.model_transform = glm::translate(glm::mat4(1.0f), position),
+			});
+			items.push_back({
+				.graphics_renderable = nullptr,
+				.renderable = definitions[kind].get(),
+				.sort_key = make_render_sort_key(*definitions[kind], static_cast<uint32_t>(kind), 0),
+				.state_index = static_cast<uint32_t>(index),
+			});
+		}
+		for (const GraphicsDrawItem& item : items)
+			list.push_back(&item);
+
+		const glm::mat4 view = glm::lookAtLH(glm::vec3(50.0f, 40.0f, -20.0f), glm::vec3(50.0f, 0.0f, 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		view_projection = glm::perspectiveLH(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 500.0f) * view;
+	}
+
+	std::vector<RenderableDefinitionPtr> definitions;
+	RenderableStateList states;
+	std::vector<GraphicsDrawItem> items;
+	std::vector<const GraphicsDrawItem*> list;
+	glm::mat4 view_projection;
+};
+
+void run_batching(benchmark::State& state, const bool instancing)
+{
+	TilesetScene scene(state.range(0));
+	DrawBatcher batcher(TILESET_SIDE * TILESET_SIDE);
+	std::vector<DrawBatch> batches;
+	const auto can_instance = [instancing](const GraphicsDrawItem&) { return instancing; };
+	for (auto _ : state)
+	{
+		batcher.clear();
+		batcher.batch(scene.list, scene.states, scene.view_projection, can_instance, batches);
+		benchmark::DoNotOptimize(batcher.get_instances().data());
+	}
+	state.counters["draw_calls"] = static_cast<double>(batches.size());
+	state.SetItemsProcessed(state.iterations() * scene.items.size());
+}
+
+// Baseline: every tile is its own draw, as before instancing
+void draw_batching_per_item(benchmark::State& state)
+{
+	run_batching(state, false);
+}
+
+// Includes packing each tile's transforms for the instance buffer
+void draw_batching_instanced(benchmark::State& state)
+{
+	run_batching(state, true);
+}
+}
+
+BENCHMARK(draw_batching_per_item)->Arg(1)->Arg(16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(draw_batching_instanced)->Arg(1)->Arg(16)->Unit(benchmark::kMicrosecond);
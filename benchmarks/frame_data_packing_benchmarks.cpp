@@ -0,0 +1,65 @@
+#include <graphics_engine/resource_manager/frame_data_ring.hpp>
+#include <shared_data_structures.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+namespace
+{
+constexpr uint32_t FRAME_COUNT = 3;
+// minUniformBufferOffsetAlignment is at most 256, which most desktop drivers report
+constexpr size_t OBJECT_DATA_ALIGNMENT = 256;
+constexpr size_t BONES_PER_SKELETON = 64;
+
+// Packs one frame of per-object data the way GraphicsEngineFrame does: a bone
+// palette for every tenth renderable, then the transforms of range(0)
+// renderables, cycling through the swapchain images. The writes go to plain
+// host memory standing in for the persistently mapped buffers.
+void frame_data_pack_renderables(benchmark::State& state)
+{
+	const auto renderable_count = static_cast<size_t>(state.range(0));
+	const size_t skeleton_count = renderable_count / 10;
+	const size_t object_region = renderable_count * OBJECT_DATA_ALIGNMENT;
+	const size_t bone_region = skeleton_count * BONES_PER_SKELETON * sizeof(SDS::Bone);
+	std::vector<std::byte> object_memory(FrameDataRing::get_buffer_size(object_region, FRAME_COUNT, OBJECT_DATA_ALIGNMENT));
+	std::vector<std::byte> bone_memory(FrameDataRing::get_buffer_size(bone_region, FRAME_COUNT, OBJECT_DATA_ALIGNMENT));
+	FrameDataRing object_ring(object_memory.data(), object_region, FRAME_COUNT, OBJECT_DATA_ALIGNMENT);
+	FrameDataRing bone_ring(bone_memory.data(), bone_region, FRAME_COUNT, OBJECT_DATA_ALIGNMENT);
+
+	std::vector<glm::mat4> models(renderable_count);
+	for (size_t i = 0; i < renderable_count; ++i)
+		models[i] = glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i), 0.0f, 0.0f));
+	const std::vector<SDS::Bone> bones(BONES_PER_SKELETON);
+	const glm::mat4 view_projection = glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 100.0f)
+		* glm::lookAt(glm::vec3(0.0f, 5.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::vector<uint32_t> bone_offsets(skeleton_count);
+	std::vector<uint32_t> object_offsets(renderable_count);
+
+	uint32_t frame = 0;
+	for (auto _ : state)
+	{
+		object_ring.begin_frame(frame);
+		bone_ring.begin_frame(frame);
+		for (size_t skeleton = 0; skeleton < skeleton_count; ++skeleton)
+			bone_offsets[skeleton] = bone_ring.write(bones.data(), bones.size() * sizeof(SDS::Bone));
+		SDS::ObjectData object_data{};
+		for (size_t i = 0; i < renderable_count; ++i)
+		{
+			object_data.model = models[i];
+			object_data.mvp = view_projection * models[i];
+			object_data.rot_mat = glm::mat3(models[i]);
+			object_offsets[i] = object_ring.write(&object_data, sizeof(object_data));
+		}
+		benchmark::DoNotOptimize(object_offsets.data());
+		benchmark::DoNotOptimize(bone_offsets.data());
+		benchmark::ClobberMemory();
+		frame = (frame + 1) % FRAME_COUNT;
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(renderable_count));
+}
+}
+
+BENCHMARK(frame_data_pack_renderables)->Arg(1000)->Arg(10000);
@@ -0,0 +1,84 @@
+#include <collision/frustum.hpp>
+#include <graphics_engine/render_draw_list.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Unit boxes scattered around a camera at the centre of the scene, which sees
+// roughly a sixth of them, and a point light beside it
+struct CullingScene
+{
+	explicit CullingScene(const int64_t count)
+	{
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		boxes.reserve(count);
+		for (int64_t index = 0; index < count; ++index)
+		{
+			const glm::vec3 centre(position(generator), position(generator), position(generator));
+			boxes.emplace_back(centre - glm::vec3(0.5f), centre + glm::vec3(0.5f));
+		}
+
+		const glm::mat4 view = glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		const glm::mat4 projection = glm::perspectiveLH(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+		frustums[0] = Frustum::from_view_projection(projection * view);
+		const auto shadow_view_projections = make_point_shadow_view_projections(glm::vec3(10.0f, 20.0f, 0.0f));
+		for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+			frustums[face + 1] = Frustum::from_view_projection(shadow_view_projections[face]);
+	}
+
+	std::vector<AABB> boxes;
+	// The camera and the six shadow cube map faces, as culled each frame
+	std::array<Frustum, 1 + POINT_SHADOW_FACE_COUNT> frustums;
+};
+
+// Baseline: one box and one frustum at a time
+void frustum_cull_scalar(benchmark::State& state)
+{
+	CullingScene scene(state.range(0));
+	std::vector<uint32_t> visible;
+	visible.reserve(scene.boxes.size());
+	for (auto _ : state)
+		for (const Frustum& frustum : scene.frustums)
+		{
+			visible.clear();
+			for (uint32_t index = 0; index < scene.boxes.size(); ++index)
+				if (frustum.intersects(scene.boxes[index]))
+					visible.push_back(index);
+			benchmark::DoNotOptimize(visible.data());
+		}
+	state.SetItemsProcessed(state.iterations() * scene.boxes.size() * scene.frustums.size());
+}
+
+// Includes refilling the culler, which the draw lists do every frame
+void frustum_cull_batched(benchmark::State& state)
+{
+	CullingScene scene(state.range(0));
+	FrustumCuller culler;
+	std::vector<uint32_t> visible;
+	visible.reserve(scene.boxes.size());
+	for (auto _ : state)
+	{
+		culler.clear();
+		culler.reserve(scene.boxes.size());
+		for (const AABB& box : scene.boxes)
+			culler.add(box);
+		for (const Frustum& frustum : scene.frustums)
+		{
+			culler.cull(frustum, visible);
+			benchmark::DoNotOptimize(visible.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * scene.boxes.size() * scene.frustums.size());
+}
+}
+
+BENCHMARK(frustum_cull_scalar)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(frustum_cull_batched)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,50 @@
+#include <graphics_engine/resource_manager/graphics_buffer.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t BUFFER_CAPACITY = 256 * 1024 * 1024;
+
+// Spawn/despawn churn against a buffer holding range(0) live slots of 1-64 KB,
+// such as meshes of objects spawned by particles or cleared Tetris lines: each
+// iteration frees a random slot and reserves one of a new size. The buffer
+// starts filled and fragmented by the same churn.
+void graphics_buffer_churn(benchmark::State& state)
+{
+	const auto live_count = static_cast<size_t>(state.range(0));
+	std::mt19937 random(42);
+	std::uniform_int_distribution<uint32_t> sizes(1024, 64 * 1024);
+	GraphicsBuffer buffer(nullptr, nullptr, BUFFER_CAPACITY, 16, "churn");
+
+	GraphicsBuffer::SlotID next_id = 0;
+	std::vector<GraphicsBuffer::SlotID> live;
+	for (size_t i = 0; i < live_count; ++i)
+	{
+		buffer.reserve_slot(next_id, sizes(random));
+		live.push_back(next_id++);
+	}
+	const auto churn_once = [&]()
+	{
+		const size_t index = random() % live.size();
+		buffer.free_slot(live[index]);
+		buffer.reserve_slot(next_id, sizes(random));
+		live[index] = next_id++;
+	};
+	for (size_t i = 0; i < live_count * 4; ++i)
+		churn_once();
+
+	for (auto _ : state)
+		churn_once();
+
+	const auto stats = buffer.get_stats();
+	state.counters["free_blocks"] = static_cast<double>(stats.free_block_count);
+	state.counters["fragmentation"] = stats.get_fragmentation();
+	state.SetItemsProcessed(state.iterations());
+}
+}
+
+BENCHMARK(graphics_buffer_churn)->Arg(1000)->Arg(3000);
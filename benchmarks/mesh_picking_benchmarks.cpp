@@ -0,0 +1,118 @@
+#include <collision/mesh_bvh.hpp>
+#include <renderable/mesh_factory.hpp>
+#include <task_pool.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int RAY_COUNT = 256;
+
+// Rays from a ring of viewpoints aimed at random points inside the bounds
+std::vector<Maths::Ray> generate_rays(const AABB& bounds)
+{
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const glm::vec3 centre = (bounds.min_bound + bounds.max_bound) * 0.5f;
+	const float radius = glm::length(bounds.max_bound - bounds.min_bound) * 2.0f;
+	std::vector<Maths::Ray> rays;
+	rays.reserve(RAY_COUNT);
+	for (int index = 0; index < RAY_COUNT; ++index)
+	{
+		const float angle = unit(generator) * 2.0f * glm::pi<float>();
+		const glm::vec3 eye = centre + glm::vec3(std::cos(angle), 0.5f, std::sin(angle)) * radius;
+		const glm::vec3 target = bounds.min_bound + (bounds.max_bound - bounds.min_bound) *
+			glm::vec3(unit(generator), unit(generator), unit(generator));
+		rays.emplace_back(eye, glm::normalize(target - eye));
+	}
+	return rays;
+}
+
+void raycast_all(benchmark::State& state, const MeshPickData& data)
+{
+	const auto rays = generate_rays(data.get_bounds());
+	for (auto _ : state)
+	{
+		for (const auto& ray : rays)
+		{
+			float closest_t = std::numeric_limits<float>::infinity();
+			benchmark::DoNotOptimize(data.raycast(ray, closest_t));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * RAY_COUNT);
+	state.counters["triangles"] = static_cast<double>(data.get_triangles().size());
+	state.counters["nodes"] = static_cast<double>(data.get_nodes().size());
+}
+
+// Closed, well-shaped surface, as typical for imported models
+void mesh_pick_sphere(benchmark::State& state)
+{
+	const MeshPtr mesh = MeshFactory::sphere(
+		MeshFactory::EVertexType::COLOR, MeshFactory::GenerationMethod::UV_SPHERE, static_cast<int>(state.range(0)));
+	raycast_all(state, mesh->get_pick_data());
+}
+
+// Overlapping, randomly sized triangles, which stress the SAH partitioning
+void mesh_pick_triangle_soup(benchmark::State& state)
+{
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+	const float extent = std::cbrt(static_cast<float>(state.range(0)));
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	for (int64_t triangle = 0; triangle < state.range(0); ++triangle)
+	{
+		const glm::vec3 centre = glm::vec3(offset(generator), offset(generator), offset(generator)) * extent;
+		for (int vertex = 0; vertex < 3; ++vertex)
+		{
+			indices.push_back(static_cast<uint32_t>(positions.size()));
+			positions.push_back(centre + glm::vec3(offset(generator), offset(generator), offset(generator)));
+		}
+	}
+	const MeshPickData data(positions, indices);
+	raycast_all(state, data);
+}
+
+// Second argument selects a serial build (0) or one split across the task pool (1)
+void mesh_pick_build(benchmark::State& state)
+{
+	const MeshPtr mesh = MeshFactory::sphere(
+		MeshFactory::EVertexType::COLOR, MeshFactory::GenerationMethod::UV_SPHERE, static_cast<int>(state.range(0)));
+	const MeshPickData& source = mesh->get_pick_data();
+	std::vector<uint32_t> indices;
+	indices.reserve(source.get_triangles().size() * 3);
+	for (const auto& triangle : source.get_triangles())
+		indices.insert(indices.end(), std::begin(triangle.vertices), std::end(triangle.vertices));
+	TaskPool* pool = state.range(1) ? &TaskPool::get_shared() : nullptr;
+	for (auto _ : state)
+		benchmark::DoNotOptimize(MeshPickData(source.get_positions(), indices, pool));
+	state.SetItemsProcessed(state.iterations() * source.get_triangles().size());
+}
+
+// Mesh construction as done by the resource loader; pick data is deferred to
+// the first query unless the second argument forces it
+void mesh_construction(benchmark::State& state)
+{
+	const MeshPtr source = MeshFactory::sphere(
+		MeshFactory::EVertexType::COLOR, MeshFactory::GenerationMethod::UV_SPHERE, static_cast<int>(state.range(0)));
+	const auto& vertices = static_cast<const ColorMesh&>(*source).get_vertices();
+	for (auto _ : state)
+	{
+		ColorMesh mesh(vertices, source->get_indices());
+		if (state.range(1))
+			benchmark::DoNotOptimize(&mesh.get_pick_data());
+		benchmark::DoNotOptimize(mesh.get_vertices_data());
+	}
+	state.SetItemsProcessed(state.iterations() * source->get_num_unique_vertices());
+}
+}
+
+BENCHMARK(mesh_pick_sphere)->Arg(512)->Arg(8'192)->Arg(131'072)->Unit(benchmark::kMicrosecond);
+BENCHMARK(mesh_pick_triangle_soup)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(mesh_pick_build)->ArgsProduct({ { 8'192, 131'072, 1'048'576 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(mesh_construction)->ArgsProduct({ { 131'072 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,77 @@
+#include <entity_component_system/ecs.hpp>
+#include <resource_loader/derived_data_cache.hpp>
+#include <resource_loader/resource_loader.hpp>
+#include <task_pool.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace
+{
+constexpr const char* MODELS[] = {
+	"static_mesh_textured.gltf",
+	"simple_test_model.gltf",
+	"multi_mesh_multi_primitive.gltf",
+	"skinned_normal_mapped.gltf",
+};
+
+// Loading the test models from their glTF sources, and again from a derived
+// data cache filled before timing starts
+void model_import(benchmark::State& state)
+{
+	const bool warm = state.range(0) != 0;
+	const auto directory = std::filesystem::temp_directory_path() / "krisp_benchmark_derived_data";
+	std::filesystem::remove_all(directory);
+	const auto cache = std::make_shared<DerivedDataCache>(directory);
+	ResourceLoader::set_derived_data_cache(warm ? cache : nullptr);
+	ECS ecs;
+	if (warm)
+		for (const auto* filename : MODELS)
+			ResourceLoader::load_model(ecs, filename);
+
+	for (auto _ : state)
+	{
+		for (const auto* filename : MODELS)
+		{
+			const auto model = ResourceLoader::load_model(ecs, filename);
+			benchmark::DoNotOptimize(model.meshes.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * std::size(MODELS));
+	state.counters["cache_hits"] = static_cast<double>(cache->get_stats().hits);
+
+	ResourceLoader::set_derived_data_cache(nullptr);
+	std::filesystem::remove_all(directory);
+}
+
+// Four copies of each test model imported at once through load_model_async,
+// without the cache, on pools of 1, 2, 4 and 8 workers
+void model_import_scaling(benchmark::State& state)
+{
+	constexpr int COPIES = 4;
+	TaskPool pool(static_cast<uint32_t>(state.range(0)));
+	ResourceLoader::LoadOptions options;
+	options.generate_missing_tangents = true;
+	options.use_derived_data_cache = false;
+	ECS ecs;
+	for (auto _ : state)
+	{
+		std::vector<ResourceLoader::PendingModel> pending;
+		for (int copy = 0; copy < COPIES; ++copy)
+			for (const auto* filename : MODELS)
+				pending.push_back(ResourceLoader::load_model_async(ecs, filename, options, pool));
+		for (auto& model : pending)
+		{
+			const auto loaded = model.get();
+			benchmark::DoNotOptimize(loaded.meshes.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * COPIES * std::size(MODELS));
+}
+}
+
+BENCHMARK(model_import)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(model_import_scaling)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,189 @@
+#include <entity_component_system/ecs.hpp>
+#include <entity_component_system/particle_system.hpp>
+#include <task_pool.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t PARTICLES_PER_EMITTER = 1000;
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+
+// Emits about as fast as particles die, so emitters stay close to full
+ParticleEmitterConfig make_config()
+{
+	ParticleEmitterConfig config;
+	config.max_particles = PARTICLES_PER_EMITTER;
+	config.emission_rate = PARTICLES_PER_EMITTER / 2.0f;
+	config.min_lifetime = 1.0f;
+	config.max_lifetime = 3.0f;
+	return config;
+}
+
+// The previous layout: one struct per particle, integrated one at a time,
+// compacted with remove_if and output with a full model matrix
+struct AosParticle
+{
+	glm::vec3 position;
+	glm::vec3 velocity;
+	glm::vec4 color;
+	float size;
+	float rotation;
+	float lifetime;
+	float rotation_speed;
+};
+
+struct AosInstance
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	float size;
+	float rotation;
+	glm::vec2 padding;
+};
+
+struct AosEmitter
+{
+	void emit(const uint32_t count, std::mt19937& generator)
+	{
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		for (uint32_t i = 0; i < count && particles.size() < config.max_particles; ++i)
+			particles.push_back({
+				.velocity = glm::vec3(unit(generator) * 2.0f - 1.0f, unit(generator), unit(generator) * 2.0f - 1.0f),
+				.color = config.start_color,
+				.size = config.min_size + unit(generator) * (config.max_size - config.min_size),
+				.rotation = unit(generator),
+				.lifetime = config.min_lifetime + unit(generator) * (config.max_lifetime - config.min_lifetime),
+				.rotation_speed = unit(generator),
+			});
+	}
+
+	void process(const float delta_time, std::mt19937& generator)
+	{
+		emission_accumulator += config.emission_rate * delta_time;
+		const auto emit_count = static_cast<uint32_t>(emission_accumulator);
+		emit(emit_count, generator);
+		emission_accumulator -= emit_count;
+		for (auto& particle : particles)
+		{
+			particle.position += particle.velocity * delta_time;
+			particle.rotation += particle.rotation_speed * delta_time;
+			particle.lifetime -= delta_time;
+			const float t = particle.lifetime / config.max_lifetime;
+			particle.color = config.start_color + t * (config.end_color - config.start_color);
+		}
+		particles.erase(
+			std::remove_if(particles.begin(), particles.end(),
+				[](const AosParticle& particle) { return particle.lifetime <= 0.0f; }),
+			particles.end());
+	}
+
+	ParticleEmitterConfig config = make_config();
+	std::vector<AosParticle> particles;
+	float emission_accumulator = 0.0f;
+};
+
+void particle_simulation_aos(benchmark::State& state)
+{
+	std::mt19937 generator(7);
+	std::vector<AosEmitter> emitters(state.range(0) / PARTICLES_PER_EMITTER);
+	for (auto& emitter : emitters)
+		emitter.emit(PARTICLES_PER_EMITTER, generator);
+	std::vector<AosInstance> instances;
+	size_t live_count = 0;
+	for (auto _ : state)
+	{
+		live_count = 0;
+		for (auto& emitter : emitters)
+		{
+			emitter.process(FRAME_TIME, generator);
+			live_count += emitter.particles.size();
+		}
+		instances.clear();
+		for (const auto& emitter : emitters)
+			for (const auto& particle : emitter.particles)
+				instances.push_back({
+					.model = glm::translate(glm::mat4(1.0f), particle.position),
+					.color = particle.color,
+					.size = particle.size,
+					.rotation = particle.rotation,
+				});
+		benchmark::DoNotOptimize(instances.data());
+	}
+	state.counters["live_particles"] = static_cast<double>(live_count);
+	state.SetItemsProcessed(state.iterations() * live_count);
+}
+
+// Includes writing the compact instances, as ParticleSystem::prepare_render_data does
+void particle_simulation_soa(benchmark::State& state)
+{
+	std::vector<std::unique_ptr<ParticleEmitter>> emitters;
+	for (int64_t index = 0; index < state.range(0) / PARTICLES_PER_EMITTER; ++index)
+	{
+		emitters.push_back(std::make_unique<ParticleEmitter>(make_config(), static_cast<uint64_t>(index)));
+		emitters.back()->emit(PARTICLES_PER_EMITTER, glm::vec3(0.0f));
+	}
+	std::vector<SDS::ParticleInstanceData> instances;
+	size_t live_count = 0;
+	for (auto _ : state)
+	{
+		live_count = 0;
+		for (auto& emitter : emitters)
+		{
+			emitter->process(FRAME_TIME, glm::vec3(0.0f));
+			live_count += emitter->size();
+		}
+		instances.resize(live_count);
+		size_t offset = 0;
+		for (const auto& emitter : emitters)
+		{
+			emitter->write_instances(instances.data() + offset);
+			offset += emitter->size();
+		}
+		benchmark::DoNotOptimize(instances.data());
+	}
+	state.counters["live_particles"] = static_cast<double>(live_count);
+	state.SetItemsProcessed(state.iterations() * live_count);
+}
+
+// 1M live particles over 1000 emitters, processed and output through the
+// particle system on pools of 1, 2, 4 and 8 workers
+void particle_system_scaling(benchmark::State& state)
+{
+	TaskPool pool(static_cast<uint32_t>(state.range(0)));
+	ECS ecs;
+	ecs.set_particle_task_pool(pool);
+	std::vector<std::unique_ptr<Object>> objects;
+	for (int index = 0; index < 1000; ++index)
+	{
+		objects.push_back(std::make_unique<Object>());
+		ecs.add_object(*objects.back());
+		ecs.spawn_particle_emitter(objects.back()->get_id(), make_config());
+	}
+	ParticleSystem& particles = ecs;
+	// long enough for the emitters to fill up
+	for (int tick = 0; tick < 180; ++tick)
+		particles.process(FRAME_TIME);
+
+	std::vector<SDS::ParticleInstanceData> instances;
+	for (auto _ : state)
+	{
+		particles.process(FRAME_TIME);
+		particles.prepare_render_data(instances);
+		benchmark::DoNotOptimize(instances.data());
+	}
+	state.counters["live_particles"] = static_cast<double>(instances.size());
+	state.SetItemsProcessed(state.iterations() * instances.size());
+}
+}
+
+BENCHMARK(particle_simulation_aos)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(particle_simulation_soa)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(particle_system_scaling)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,70 @@
+#include <entity_component_system/ecs.hpp>
+#include <render_frame_builder.hpp>
+#include <renderable/mesh_factory.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+// One renderable per object, sharing a mesh and material, like a large
+// tileset or prop-heavy level
+struct RenderableScene
+{
+	explicit RenderableScene(const int64_t count)
+	{
+		const auto renderable = Renderable::make_default(
+			ecs, ecs.get_mesh_system().add(MeshFactory::cube()));
+		objects.reserve(count);
+		for (int64_t index = 0; index < count; ++index)
+		{
+			objects.push_back(std::make_unique<Object>());
+			ecs.add_object(*objects.back());
+			ecs.set_position(objects.back()->get_id(), { static_cast<float>(index), 0.0f, 0.0f });
+			ecs.add_renderable(renderable, objects.back()->get_id());
+		}
+	}
+
+	ECS ecs;
+	std::vector<std::unique_ptr<Object>> objects;
+};
+
+// Moves 1% of the objects each tick, then builds and publishes a frame the
+// way GameEngine does
+void render_frame_build_with_sparse_motion(benchmark::State& state)
+{
+	RenderableScene scene(state.range(0));
+	RenderFrameBuilder builder;
+	RenderFramePool pool;
+	RenderFrameMailbox mailbox;
+	std::mt19937 generator(7);
+	const size_t moved_count = std::max<size_t>(1, scene.objects.size() / 100);
+	float offset = 0.0f;
+
+	// the first build mirrors every renderable and is not representative
+	auto first = pool.acquire();
+	builder.build(scene.ecs, *first);
+	mailbox.publish_completed(std::move(first));
+	for (auto _ : state)
+	{
+		offset += 0.01f;
+		for (size_t moved = 0; moved < moved_count; ++moved)
+		{
+			const auto& object = *scene.objects[generator() % scene.objects.size()];
+			scene.ecs.set_position(object.get_id(), { offset, 1.0f, 0.0f });
+		}
+		scene.ecs.update_world_transforms();
+		auto frame = pool.acquire();
+		builder.build(scene.ecs, *frame);
+		mailbox.publish_completed(std::move(frame));
+	}
+	state.SetItemsProcessed(state.iterations() * scene.objects.size());
+}
+}
+
+BENCHMARK(render_frame_build_with_sparse_motion)
+	->Arg(1'000)->Arg(10'000)->Arg(50'000)->Unit(benchmark::kMicrosecond);
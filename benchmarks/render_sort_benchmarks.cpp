@@ -0,0 +1,155 @@
+#include <graphics_engine/render_draw_list.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+// Draw items spread over two pipelines, 200 meshes and 50 material sets,
+// each with a distance from the camera
+struct SortScene
+{
+	explicit SortScene(const int64_t count)
+	{
+		std::mt19937 generator(99);
+		std::uniform_int_distribution<int> render_type(1, 2);
+		std::uniform_int_distribution<uint64_t> mesh(0, 199);
+		std::uniform_int_distribution<uint64_t> material(0, 49);
+		std::uniform_real_distribution<float> distance(0.0f, 10000.0f);
+		items.reserve(count);
+		for (int64_t index = 0; index < count; ++index)
+			items.push_back({
+				.render_type = static_cast<ERenderType>(render_type(generator)),
+				.mesh_id = MeshID(mesh(generator)),
+				.material_id = MaterialID(material(generator)),
+				.renderable_id = RenderableID(static_cast<uint64_t>(index)),
+				.distance_squared = distance(generator),
+			});
+	}
+
+	struct Item
+	{
+		ERenderType render_type;
+		MeshID mesh_id;
+		MaterialID material_id;
+		RenderableID renderable_id;
+		float distance_squared;
+	};
+	std::vector<Item> items;
+};
+
+// The previous key: descriptive fields with a vector of material IDs,
+// compared field by field
+struct TupleSortKey
+{
+	ERenderType render_type;
+	MeshID mesh_id;
+	std::vector<MaterialID> material_ids;
+	RenderableID renderable_id;
+
+	bool operator<(const TupleSortKey& other) const
+	{
+		return std::tie(render_type, mesh_id, material_ids, renderable_id)
+			< std::tie(other.render_type, other.mesh_id, other.material_ids, other.renderable_id);
+	}
+};
+
+// Baseline: builds a key per item and sorts them by comparison
+void render_sort_tuple_keys(benchmark::State& state)
+{
+	SortScene scene(state.range(0));
+	std::vector<TupleSortKey> keys;
+	keys.reserve(scene.items.size());
+	for (auto _ : state)
+	{
+		keys.clear();
+		for (const auto& item : scene.items)
+			keys.push_back({
+				.render_type = item.render_type,
+				.mesh_id = item.mesh_id,
+				.material_ids = { item.material_id },
+				.renderable_id = item.renderable_id,
+			});
+		std::ranges::sort(keys);
+		benchmark::DoNotOptimize(keys.data());
+	}
+	state.SetItemsProcessed(state.iterations() * scene.items.size());
+}
+
+// Packs a key per item and radix sorts them. IDs stand in for the ranks
+// rebuild assigns.
+void render_sort_packed_keys(benchmark::State& state)
+{
+	SortScene scene(state.range(0));
+	std::vector<DrawSortEntry> entries;
+	std::vector<DrawSortEntry> scratch;
+	entries.reserve(scene.items.size());
+	for (auto _ : state)
+	{
+		entries.clear();
+		for (uint32_t index = 0; index < scene.items.size(); ++index)
+		{
+			const auto& item = scene.items[index];
+			const RenderableDefinition definition{ .pipeline_render_type = item.render_type };
+			const uint64_t key = make_render_sort_key(
+				definition,
+				static_cast<uint32_t>(item.mesh_id.get_underlying()),
+				static_cast<uint32_t>(item.material_id.get_underlying())).value;
+			entries.push_back({ .key = key, .index = index });
+		}
+		radix_sort(entries, scratch);
+		benchmark::DoNotOptimize(entries.data());
+	}
+	state.SetItemsProcessed(state.iterations() * scene.items.size());
+}
+
+// Baseline: back to front by comparison, as the blended passes sorted before
+void blended_sort_comparison(benchmark::State& state)
+{
+	SortScene scene(state.range(0));
+	std::vector<const SortScene::Item*> order;
+	order.reserve(scene.items.size());
+	for (auto _ : state)
+	{
+		order.clear();
+		for (const auto& item : scene.items)
+			order.push_back(&item);
+		std::ranges::sort(order, [](const SortScene::Item* lhs, const SortScene::Item* rhs) {
+			if (lhs->distance_squared != rhs->distance_squared)
+				return lhs->distance_squared > rhs->distance_squared;
+			return lhs->renderable_id < rhs->renderable_id;
+		});
+		benchmark::DoNotOptimize(order.data());
+	}
+	state.SetItemsProcessed(state.iterations() * scene.items.size());
+}
+
+void blended_sort_radix(benchmark::State& state)
+{
+	SortScene scene(state.range(0));
+	std::vector<DrawSortEntry> entries;
+	std::vector<DrawSortEntry> scratch;
+	entries.reserve(scene.items.size());
+	for (auto _ : state)
+	{
+		entries.clear();
+		for (uint32_t index = 0; index < scene.items.size(); ++index)
+			entries.push_back({
+				.key = make_blended_sort_key(scene.items[index].distance_squared, index),
+				.index = index,
+			});
+		radix_sort(entries, scratch);
+		benchmark::DoNotOptimize(entries.data());
+	}
+	state.SetItemsProcessed(state.iterations() * scene.items.size());
+}
+}
+
+BENCHMARK(render_sort_tuple_keys)->Arg(50'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(render_sort_packed_keys)->Arg(50'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(blended_sort_comparison)->Arg(50'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(blended_sort_radix)->Arg(50'000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,140 @@
+#include <entity_component_system/ecs.hpp>
+#include <renderable/material.hpp>
+#include <renderable/mesh.hpp>
+#include <serialization/scene_resources.hpp>
+#include <serialization/serializer.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+// 16 meshes of 256k textured vertices and 16 2048x2048 RGBA8 textures: about
+// 490 MB of generated .dat files
+constexpr int RESOURCE_COUNT = 16;
+constexpr size_t MESH_VERTICES = 256 * 1024;
+constexpr uint32_t TEXTURE_SIZE = 2048;
+
+struct GeneratedSave
+{
+	std::filesystem::path directory;
+	Deserializer document;
+};
+
+const GeneratedSave& generated_save()
+{
+	static const GeneratedSave save = [] {
+		auto directory = std::filesystem::temp_directory_path() / "krisp_scene_resource_benchmarks";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		ECS ecs;
+		Serializer document;
+		SceneResourceWriter writer(document, ecs, directory);
+		auto references = document.sequence("references");
+		for (int resource = 0; resource < RESOURCE_COUNT; ++resource)
+		{
+			TexVertices vertices(MESH_VERTICES);
+			for (size_t index = 0; index < vertices.size(); ++index)
+				vertices[index].pos = glm::vec3(static_cast<float>(index), static_cast<float>(resource), 0.0f);
+			VertexIndices indices(MESH_VERTICES);
+			for (size_t index = 0; index < indices.size(); ++index)
+				indices[index] = static_cast<uint32_t>(index);
+			auto mesh = ecs.get_mesh_system().add(std::make_unique<TexMesh>(std::move(vertices), std::move(indices)));
+			writer.write_mesh_reference(references.append_map(), mesh->get_id());
+
+			auto texture = std::make_unique<TextureMaterial>();
+			texture->width = TEXTURE_SIZE;
+			texture->height = TEXTURE_SIZE;
+			texture->channels = 4;
+			texture->data_len = size_t(TEXTURE_SIZE) * TEXTURE_SIZE * 4;
+			texture->mip_sizes = { texture->data_len };
+			texture->source = "generated";
+			texture->data = std::make_unique<OwnedTextureData>(
+				std::vector<std::byte>(texture->data_len, static_cast<std::byte>(resource)));
+			auto material = ecs.get_material_system().add(std::move(texture));
+			writer.write_material_reference(references.append_map(), material->get_id());
+		}
+		return GeneratedSave{ directory, Deserializer::parse_binary(document.emit_binary()) };
+	}();
+	return save;
+}
+
+// Reads a kB field of /proc/self/status, in MB
+double status_mb(const std::string& field)
+{
+	std::ifstream status("/proc/self/status");
+	std::string name;
+	double kilobytes = 0.0;
+	while (status >> name)
+	{
+		if (name == field + ":" && status >> kilobytes)
+			return kilobytes / 1024.0;
+		status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	}
+	return 0.0;
+}
+
+// Generating the save peaks far above either loader, so the high-water mark is
+// reset once the save exists and the benchmark reports how far it rose
+void reset_peak_rss()
+{
+	std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+void report_peak_rss(benchmark::State& state, const double resident_before)
+{
+	state.counters["peak_rss_growth_mb"] = status_mb("VmHWM") - resident_before;
+}
+
+// Restores every generated mesh and texture, as loading the save does
+void scene_resource_load(benchmark::State& state)
+{
+	const auto& save = generated_save();
+	reset_peak_rss();
+	const double resident_before = status_mb("VmRSS");
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto ecs = std::make_unique<ECS>();
+		state.ResumeTiming();
+		SceneResourceReader resources(*ecs, save.directory);
+		resources.prepare(save.document);
+		state.PauseTiming();
+		ecs.reset();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * RESOURCE_COUNT * 2);
+	report_peak_rss(state, resident_before);
+}
+
+// Reads the same files into owned buffers, as the reader did before it mapped
+// them, for comparison with scene_resource_load
+void scene_resource_read_copy(benchmark::State& state)
+{
+	const auto& save = generated_save();
+	reset_peak_rss();
+	const double resident_before = status_mb("VmRSS");
+	for (auto _ : state)
+	{
+		std::vector<std::vector<std::byte>> files;
+		for (const auto& entry : std::filesystem::directory_iterator(save.directory))
+		{
+			std::ifstream stream(entry.path(), std::ios::binary);
+			auto& bytes = files.emplace_back(std::filesystem::file_size(entry.path()));
+			stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		}
+		benchmark::DoNotOptimize(files.data());
+	}
+	state.SetItemsProcessed(state.iterations() * RESOURCE_COUNT * 2);
+	report_peak_rss(state, resident_before);
+}
+}
+
+BENCHMARK(scene_resource_load)->Unit(benchmark::kMillisecond);
+BENCHMARK(scene_resource_read_copy)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,123 @@
+#include <collision/collider.hpp>
+#include <entity_component_system/ecs.hpp>
+#include <serialization/scene_resources.hpp>
+#include <serialization/serializer.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+const std::filesystem::path& resource_directory()
+{
+	static const auto directory = [] {
+		auto path = std::filesystem::temp_directory_path() / "krisp_scene_serialization_benchmarks";
+		std::filesystem::create_directories(path);
+		return path;
+	}();
+	return directory;
+}
+
+// Arg 1 selects the document format: 0 is YAML, 1 binary
+SerializationFormat document_format(const benchmark::State& state)
+{
+	return state.range(1) == 0 ? SerializationFormat::Yaml : SerializationFormat::Binary;
+}
+
+// Every entity has a transform and most hang off an earlier one; every other
+// entity also has a clickable sphere collider, as props in a level would
+void populate(ECS& ecs, const int64_t count)
+{
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> offset(-50.0f, 50.0f);
+	for (int64_t index = 0; index < count; ++index)
+	{
+		const EntityID id(static_cast<uint64_t>(index + 1));
+		ecs.add_transformation(id);
+		ecs.set_relative_position(id, { offset(generator), offset(generator), offset(generator) });
+		if (index > 0 && generator() % 4 != 0)
+			ecs.attach_to(id, EntityID(static_cast<uint64_t>(generator() % index + 1)));
+		if (index % 2 == 0)
+		{
+			ecs.add_collider(id, std::make_unique<SphereCollider>(Maths::Sphere(glm::vec3(0.0f), 0.5f)));
+			ecs.add_clickable_entity(id);
+		}
+	}
+}
+
+Serializer serialize_scene(const ECS& ecs)
+{
+	Serializer document;
+	SceneResourceWriter resources(document, ecs, resource_directory());
+	auto saved_ecs = document.map("ecs");
+	ecs.serialize(saved_ecs, resources);
+	return document;
+}
+
+// Builds the document and encodes it, as save_scene does before writing
+void scene_save(benchmark::State& state)
+{
+	ECS ecs;
+	populate(ecs, state.range(0));
+	const auto format = document_format(state);
+	std::size_t bytes = 0;
+	for (auto _ : state)
+	{
+		const auto document = serialize_scene(ecs);
+		if (format == SerializationFormat::Binary)
+		{
+			const auto encoded = document.emit_binary();
+			bytes = encoded.size();
+			benchmark::DoNotOptimize(encoded.data());
+		}
+		else
+		{
+			const auto encoded = document.emit();
+			bytes = encoded.size();
+			benchmark::DoNotOptimize(encoded.data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+// Parses an encoded scene and restores it into an empty ECS
+void scene_load(benchmark::State& state)
+{
+	const auto format = document_format(state);
+	std::string yaml;
+	std::vector<std::byte> binary;
+	{
+		ECS source;
+		populate(source, state.range(0));
+		const auto document = serialize_scene(source);
+		if (format == SerializationFormat::Binary)
+			binary = document.emit_binary();
+		else
+			yaml = document.emit();
+	}
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto ecs = std::make_unique<ECS>();
+		state.ResumeTiming();
+		const auto document = format == SerializationFormat::Binary
+			? Deserializer::parse_binary(binary) : Deserializer::parse(yaml);
+		SceneResourceReader resources(*ecs, resource_directory());
+		resources.prepare(document);
+		ecs->deserialize(document.child("ecs"), resources);
+		state.PauseTiming();
+		ecs.reset();
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(scene_save)->ArgsProduct({ { 10'000, 100'000 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(scene_load)->ArgsProduct({ { 10'000, 100'000 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,232 @@
+#include <entity_component_system/ecs.hpp>
+#include <entity_component_system/skeletal.hpp>
+#include <render_frame_builder.hpp>
+#include <renderable/mesh_factory.hpp>
+#include <task_pool.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr size_t SKELETON_COUNT = 500;
+constexpr size_t BONE_COUNT = 60;
+constexpr float CLIP_SECS = 2.0f;
+constexpr float KEYS_PER_SEC = 30.0f;
+constexpr float TICK_SECS = 1.0f / 60.0f;
+
+// Skeletons sharing one clip that keys every bone's translation, rotation and
+// scale 30 times a second, each playing it from a different point
+struct AnimatedCrowd
+{
+	AnimatedCrowd()
+	{
+		std::mt19937 generator(77);
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+		bones.resize(BONE_COUNT);
+		for (size_t bone = 0; bone < BONE_COUNT; ++bone)
+		{
+			bones[bone].name = "bone" + std::to_string(bone);
+			bones[bone].parent_node = bone == 0 ? Bone::NO_PARENT : static_cast<uint32_t>(bone - 1);
+		}
+
+		const int key_count = static_cast<int>(CLIP_SECS * KEYS_PER_SEC) + 1;
+		bone_animations.resize(BONE_COUNT);
+		for (auto& animation : bone_animations)
+		{
+			animation.animation_start_secs = 0.0f;
+			animation.animation_end_secs = CLIP_SECS;
+			const glm::vec3 axis = glm::normalize(glm::vec3(offset(generator), offset(generator), 1.0f));
+			for (int key = 0; key < key_count; ++key)
+			{
+				const float secs = static_cast<float>(key) / KEYS_PER_SEC;
+				const auto rotation = glm::angleAxis(std::sin(secs * 3.0f) + offset(generator) * 0.1f, axis);
+				animation.translation_track.keys.push_back(
+					{ secs, glm::vec3(offset(generator), offset(generator), offset(generator)), {}, {} });
+				animation.rotation_track.keys.push_back(
+					{ secs, glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w), {}, {} });
+				animation.scale_track.keys.push_back(
+					{ secs, glm::vec3(1.0f + offset(generator) * 0.1f), {}, {} });
+			}
+		}
+		clip = CompiledAnimationClip(bone_animations);
+
+		skeletons.reserve(SKELETON_COUNT);
+		for (size_t skeleton = 0; skeleton < SKELETON_COUNT; ++skeleton)
+		{
+			skeletons.emplace_back(bones);
+			phases.push_back(CLIP_SECS * static_cast<float>(skeleton) / SKELETON_COUNT);
+		}
+	}
+
+	float playback_secs(const size_t skeleton) const
+	{
+		return std::fmod(elapsed_secs + phases[skeleton], CLIP_SECS);
+	}
+
+	std::vector<Bone> bones;
+	std::vector<BoneAnimation> bone_animations;
+	CompiledAnimationClip clip;
+	std::vector<SkeletalComponent> skeletons;
+	std::vector<float> phases;
+	float elapsed_secs = 0.0f;
+};
+
+// Baseline: searching every track each tick and building a fresh pose, as
+// the animation system did before clips were compiled
+void skeletal_animation_per_track(benchmark::State& state)
+{
+	AnimatedCrowd crowd;
+	for (auto _ : state)
+	{
+		crowd.elapsed_secs += TICK_SECS;
+		for (size_t skeleton = 0; skeleton < SKELETON_COUNT; ++skeleton)
+		{
+			auto& component = crowd.skeletons[skeleton];
+			std::vector<Maths::Transform> target_pose;
+			target_pose.reserve(BONE_COUNT);
+			for (const auto& bone : component.get_bones())
+				target_pose.push_back(bone.original_transform);
+			for (size_t bone = 0; bone < BONE_COUNT; ++bone)
+				crowd.bone_animations[bone].get_transform(crowd.playback_secs(skeleton), target_pose[bone]);
+			for (size_t bone = 0; bone < BONE_COUNT; ++bone)
+				component.get_bone_local_transform(bone) = target_pose[bone];
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * SKELETON_COUNT * BONE_COUNT);
+}
+
+void skeletal_animation_compiled(benchmark::State& state)
+{
+	AnimatedCrowd crowd;
+	std::vector<AnimationCursor> cursors(SKELETON_COUNT);
+	std::vector<AnimationPose> poses(SKELETON_COUNT);
+	for (auto _ : state)
+	{
+		crowd.elapsed_secs += TICK_SECS;
+		for (size_t skeleton = 0; skeleton < SKELETON_COUNT; ++skeleton)
+		{
+			auto& component = crowd.skeletons[skeleton];
+			crowd.clip.sample(crowd.playback_secs(skeleton), cursors[skeleton],
+				component.get_rest_pose(), poses[skeleton]);
+			component.set_local_pose(poses[skeleton]);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * SKELETON_COUNT * BONE_COUNT);
+}
+
+// Sampling alone, without writing the poses back to the skeletons
+void skeletal_animation_compiled_sampling(benchmark::State& state)
+{
+	AnimatedCrowd crowd;
+	std::vector<AnimationCursor> cursors(SKELETON_COUNT);
+	std::vector<AnimationPose> poses(SKELETON_COUNT);
+	for (auto _ : state)
+	{
+		crowd.elapsed_secs += TICK_SECS;
+		for (size_t skeleton = 0; skeleton < SKELETON_COUNT; ++skeleton)
+		{
+			crowd.clip.sample(crowd.playback_secs(skeleton), cursors[skeleton],
+				crowd.skeletons[skeleton].get_rest_pose(), poses[skeleton]);
+			benchmark::DoNotOptimize(poses[skeleton].rotations[0].data());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * SKELETON_COUNT * BONE_COUNT);
+}
+
+// The whole per-tick skeletal pipeline for the crowd, each skeleton skinning
+// a renderable: sampling and blending in the animation system, then hierarchy
+// composition and skinning matrices in the frame builder, on pools of 1, 2, 4
+// and 8 workers
+void skeletal_pipeline_scaling(benchmark::State& state)
+{
+	TaskPool pool(static_cast<uint32_t>(state.range(0)));
+	AnimatedCrowd crowd;
+	ECS ecs;
+	ecs.set_skeletal_task_pool(pool);
+	RenderFrameBuilder builder;
+	builder.set_task_pool(pool);
+	const AnimationID animation_id = ecs.add_skeletal_animation(
+		"crowd", std::vector<BoneAnimation>(crowd.bone_animations), make_skeletal_rig_signature(crowd.bones));
+	auto renderable = Renderable::make_default(ecs, ecs.get_mesh_system().add(MeshFactory::cube()));
+	renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+	std::vector<std::unique_ptr<Object>> objects;
+	for (size_t skeleton = 0; skeleton < SKELETON_COUNT; ++skeleton)
+	{
+		objects.push_back(std::make_unique<Object>());
+		ecs.add_object(*objects.back());
+		const SkeletonID skeleton_id = ecs.add_skeleton(crowd.bones);
+		ecs.add_renderable(renderable, objects.back()->get_id(), skeleton_id);
+		ecs.play_animation(skeleton_id, animation_id, true);
+		ecs.seek_animation(skeleton_id, crowd.phases[skeleton]);
+	}
+
+	SkeletalAnimationSystem& animation = ecs;
+	RenderFramePool frames;
+	for (auto _ : state)
+	{
+		animation.process(TICK_SECS);
+		auto frame = frames.acquire();
+		builder.build(ecs, *frame);
+		benchmark::DoNotOptimize(frame->skeletons.data());
+	}
+	state.SetItemsProcessed(state.iterations() * SKELETON_COUNT * BONE_COUNT);
+}
+
+// One animation tick for 1000 skeletons spread evenly out to 150 units from
+// the viewpoint, without and with the default animation LODs, which sample
+// the nearest tenth every tick, the next sixth every other tick and the next
+// two fifths every fourth tick without their leaf bones, and freeze the rest
+void skeletal_animation_lod(benchmark::State& state)
+{
+	constexpr size_t LOD_SKELETON_COUNT = 1000;
+	constexpr float MAX_DISTANCE = 150.0f;
+	TaskPool pool(0);
+	AnimatedCrowd crowd;
+	ECS ecs;
+	ecs.set_skeletal_task_pool(pool);
+	const AnimationID animation_id = ecs.add_skeletal_animation(
+		"crowd", std::vector<BoneAnimation>(crowd.bone_animations), make_skeletal_rig_signature(crowd.bones));
+	auto renderable = Renderable::make_default(ecs, ecs.get_mesh_system().add(MeshFactory::cube()));
+	renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+	std::vector<std::unique_ptr<Object>> objects;
+	for (size_t skeleton = 0; skeleton < LOD_SKELETON_COUNT; ++skeleton)
+	{
+		const float distance = MAX_DISTANCE * static_cast<float>(skeleton) / LOD_SKELETON_COUNT;
+		const float angle = static_cast<float>(skeleton) * 2.4f;
+		objects.push_back(std::make_unique<Object>());
+		ecs.add_object(*objects.back());
+		ecs.set_position(objects.back()->get_id(),
+			glm::vec3(std::cos(angle) * distance, 0.0f, std::sin(angle) * distance));
+		const SkeletonID skeleton_id = ecs.add_skeleton(crowd.bones);
+		ecs.add_renderable(renderable, objects.back()->get_id(), skeleton_id);
+		ecs.play_animation(skeleton_id, animation_id, true);
+		ecs.seek_animation(skeleton_id, CLIP_SECS * static_cast<float>(skeleton) / LOD_SKELETON_COUNT);
+	}
+	ecs.set_animation_lod_settings({ .enabled = state.range(0) != 0 });
+	ecs.set_animation_lod_viewpoint(glm::vec3(0.0f));
+
+	SkeletalAnimationSystem& animation = ecs;
+	size_t sampled = 0;
+	for (auto _ : state)
+	{
+		animation.process(TICK_SECS);
+		sampled += ecs.get_animation_lod_counters().sampled;
+	}
+	state.counters["sampled_per_tick"] = benchmark::Counter(
+		static_cast<double>(sampled), benchmark::Counter::kAvgIterations);
+	state.SetItemsProcessed(state.iterations() * LOD_SKELETON_COUNT);
+}
+}
+
+BENCHMARK(skeletal_animation_per_track)->Unit(benchmark::kMicrosecond);
+BENCHMARK(skeletal_animation_compiled)->Unit(benchmark::kMicrosecond);
+BENCHMARK(skeletal_animation_compiled_sampling)->Unit(benchmark::kMicrosecond);
+BENCHMARK(skeletal_pipeline_scaling)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(skeletal_animation_lod)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
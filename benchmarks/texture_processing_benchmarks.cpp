@@ -0,0 +1,119 @@
+#include <renderable/texture_processor.hpp>
+#include <task_pool.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t IMAGE_SIZE = 1024;
+
+// Smooth gradients under fine noise and a few hard edges, roughly like
+// photographic albedo, with alpha following one of the gradients
+std::vector<std::byte> make_image()
+{
+	std::vector<std::byte> pixels(static_cast<size_t>(IMAGE_SIZE) * IMAGE_SIZE * 4);
+	uint32_t noise = 12345;
+	for (uint32_t y = 0; y < IMAGE_SIZE; ++y)
+	{
+		for (uint32_t x = 0; x < IMAGE_SIZE; ++x)
+		{
+			noise = noise * 1664525u + 1013904223u;
+			const int grain = static_cast<int>(noise >> 29) - 4;
+			const bool stripe = (x / 64 + y / 96) % 5 == 0;
+			const auto channel = [&](const float value)
+			{
+				return static_cast<std::byte>(std::clamp(static_cast<int>(value) + grain, 0, 255));
+			};
+			std::byte* pixel = pixels.data() + (static_cast<size_t>(y) * IMAGE_SIZE + x) * 4;
+			pixel[0] = channel(stripe ? 230.0f : 128.0f + 100.0f * std::sin(x * 0.01f));
+			pixel[1] = channel(static_cast<float>(y) * 255.0f / IMAGE_SIZE);
+			pixel[2] = channel(stripe ? 40.0f : 128.0f + 100.0f * std::cos((x + y) * 0.007f));
+			pixel[3] = channel(static_cast<float>(x) * 255.0f / IMAGE_SIZE);
+		}
+	}
+	return pixels;
+}
+
+double psnr(const std::vector<std::byte>& expected, const std::vector<std::byte>& actual, const size_t channels)
+{
+	double squared_error = 0.0;
+	size_t count = 0;
+	for (size_t index = 0; index < expected.size(); ++index)
+	{
+		if (index % 4 >= channels)
+			continue;
+		const double difference = std::to_integer<int>(expected[index]) - std::to_integer<int>(actual[index]);
+		squared_error += difference * difference;
+		++count;
+	}
+	return 10.0 * std::log10(255.0 * 255.0 * static_cast<double>(count) / std::max(squared_error, 1e-9));
+}
+
+// A complete sRGB mip chain of the 1024x1024 image, box and Kaiser filtered
+void texture_mip_generation(benchmark::State& state)
+{
+	TaskPool pool(0);
+	const auto pixels = make_image();
+	const auto filter = state.range(0) == 0
+		? TextureProcessor::EMipFilter::BOX : TextureProcessor::EMipFilter::KAISER;
+	for (auto _ : state)
+	{
+		auto chain = TextureProcessor::generate_mips(
+			pixels, IMAGE_SIZE, IMAGE_SIZE, ETextureSemantic::BASE_COLOR, filter, pool);
+		benchmark::DoNotOptimize(chain.data.data());
+	}
+	state.SetItemsProcessed(state.iterations() * IMAGE_SIZE * IMAGE_SIZE);
+}
+
+// Encoding the image into BC1, BC3, BC5 and BC7 on one thread, with the PSNR
+// of the decoded result over the channels each format stores
+void texture_block_compression(benchmark::State& state)
+{
+	constexpr ETextureFormat FORMATS[] = {
+		ETextureFormat::BC1, ETextureFormat::BC3, ETextureFormat::BC5, ETextureFormat::BC7 };
+	constexpr size_t CHANNELS[] = { 3, 4, 2, 4 };
+	TaskPool pool(0);
+	const auto pixels = make_image();
+	const ETextureFormat format = FORMATS[state.range(0)];
+	std::vector<std::byte> blocks(TextureProcessor::get_level_size(format, IMAGE_SIZE, IMAGE_SIZE));
+	for (auto _ : state)
+	{
+		TextureProcessor::compress_level(format, pixels, IMAGE_SIZE, IMAGE_SIZE, blocks, pool);
+		benchmark::DoNotOptimize(blocks.data());
+	}
+	state.SetItemsProcessed(state.iterations() * IMAGE_SIZE * IMAGE_SIZE);
+
+	std::vector<std::byte> decoded(pixels.size());
+	TextureProcessor::decompress_level(format, blocks, IMAGE_SIZE, IMAGE_SIZE, decoded);
+	state.counters["psnr_db"] = psnr(pixels, decoded, CHANNELS[state.range(0)]);
+}
+
+// The whole default pipeline for a base colour texture, Kaiser mips then BC7,
+// on pools of 1, 2, 4 and 8 workers
+void texture_processing_scaling(benchmark::State& state)
+{
+	TaskPool pool(static_cast<uint32_t>(state.range(0)));
+	const auto pixels = make_image();
+	for (auto _ : state)
+	{
+		TextureMaterial texture;
+		texture.width = IMAGE_SIZE;
+		texture.height = IMAGE_SIZE;
+		texture.data_len = pixels.size();
+		texture.mip_sizes = { pixels.size() };
+		texture.data = std::make_unique<OwnedTextureData>(pixels);
+		TextureProcessor::process(texture, {}, pool);
+		benchmark::DoNotOptimize(texture.data->get());
+	}
+	state.SetItemsProcessed(state.iterations() * IMAGE_SIZE * IMAGE_SIZE);
+}
+}
+
+BENCHMARK(texture_mip_generation)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(texture_block_compression)->Arg(0)->Arg(1)->Arg(2)->Arg(3)->Unit(benchmark::kMillisecond);
+BENCHMARK(texture_processing_scaling)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
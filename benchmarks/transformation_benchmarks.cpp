@@ -0,0 +1,177 @@
+#include <entity_component_system/transformation_system.hpp>
+
+#include <benchmark/benchmark.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t MAX_DEPTH = 12;
+constexpr int READ_COUNT = 1'024;
+
+// A forest in which each entity attaches to a random earlier one, producing
+// everything from flat tilesets to deep equipment and bone chains
+struct TransformHierarchy
+{
+	explicit TransformHierarchy(const int64_t count)
+	{
+		std::mt19937 generator(99);
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+		std::vector<uint32_t> depths;
+		ids.reserve(count);
+		depths.reserve(count);
+		for (int64_t index = 0; index < count; ++index)
+		{
+			const EntityID id(static_cast<uint64_t>(index + 1));
+			transformations.add_transformation(id);
+			transformations.set_relative_position(id, { offset(generator), offset(generator), offset(generator) });
+			uint32_t depth = 0;
+			if (!ids.empty() && generator() % 5 != 0)
+			{
+				const size_t parent = generator() % ids.size();
+				if (depths[parent] < MAX_DEPTH && transformations.attach_to(id, ids[parent]))
+					depth = depths[parent] + 1;
+			}
+			if (depth == 0)
+				roots.push_back(id);
+			ids.push_back(id);
+			depths.push_back(depth);
+		}
+		transformations.update_world_transforms();
+
+		read_order.resize(READ_COUNT);
+		for (auto& id : read_order)
+			id = ids[generator() % ids.size()];
+	}
+
+	// Moves a tenth of the roots, invalidating their subtrees
+	void move_roots(const float offset)
+	{
+		for (size_t index = 0; index < roots.size(); index += 10)
+			transformations.set_relative_position(roots[index], { offset, 0.0f, 0.0f });
+	}
+
+	TransformationSystem transformations;
+	std::vector<EntityID> ids;
+	std::vector<EntityID> roots;
+	std::vector<EntityID> read_order;
+};
+
+// Each read synchronises its stale ancestors on demand
+void transform_random_reads_after_motion(benchmark::State& state)
+{
+	TransformHierarchy hierarchy(state.range(0));
+	float offset = 0.0f;
+	for (auto _ : state)
+	{
+		hierarchy.move_roots(offset += 0.01f);
+		for (const EntityID id : hierarchy.read_order)
+			benchmark::DoNotOptimize(hierarchy.transformations.get_transform(id));
+	}
+	state.SetItemsProcessed(state.iterations() * READ_COUNT);
+}
+
+// Random reads of a hierarchy without stale transforms
+void transform_random_reads_synchronised(benchmark::State& state)
+{
+	TransformHierarchy hierarchy(state.range(0));
+	for (auto _ : state)
+		for (const EntityID id : hierarchy.read_order)
+			benchmark::DoNotOptimize(hierarchy.transformations.get_transform(id));
+	state.SetItemsProcessed(state.iterations() * READ_COUNT);
+}
+
+// Invalidates subtrees and recomputes them in one parent-first sweep
+void transform_batch_update(benchmark::State& state)
+{
+	TransformHierarchy hierarchy(state.range(0));
+	float offset = 0.0f;
+	for (auto _ : state)
+	{
+		hierarchy.move_roots(offset += 0.01f);
+		hierarchy.transformations.update_world_transforms();
+	}
+	state.SetItemsProcessed(state.iterations() * hierarchy.ids.size());
+}
+
+// Moves transforms whose state came in as a matrix, as physics and imported
+// poses do, then reads the matrix back for rendering
+void maths_transform_set_pos_after_set_mat4(benchmark::State& state)
+{
+	constexpr int COUNT = 1'024;
+	const glm::mat4 pose = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f))
+		* glm::mat4_cast(glm::angleAxis(0.4f, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f))))
+		* glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+	std::vector<Maths::Transform> transforms(COUNT);
+	float offset = 0.0f;
+	for (auto _ : state)
+	{
+		offset += 0.01f;
+		for (auto& transform : transforms)
+		{
+			transform.set_mat4(pose);
+			transform.set_pos(glm::vec3(offset, 0.0f, 0.0f));
+			benchmark::DoNotOptimize(transform.get_mat4());
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * COUNT);
+}
+
+// Sets the world position of every root (0) or of every attached entity (1)
+void transform_set_position(benchmark::State& state)
+{
+	TransformHierarchy hierarchy(100'000);
+	std::vector<EntityID> moved;
+	for (const EntityID id : hierarchy.ids)
+		if (hierarchy.transformations.get_parent_id(id).has_value() == (state.range(0) == 1))
+			moved.push_back(id);
+	float offset = 0.0f;
+	for (auto _ : state)
+	{
+		offset += 0.01f;
+		for (const EntityID id : moved)
+			hierarchy.transformations.set_position(id, { offset, 0.0f, 0.0f });
+	}
+	state.SetItemsProcessed(state.iterations() * moved.size());
+}
+
+// Publishes a pose per root the way physics synchronisation does, through
+// separate position and rotation setters (0) or one batched call (1)
+void transform_set_poses(benchmark::State& state)
+{
+	TransformHierarchy hierarchy(100'000);
+	const auto& ids = hierarchy.roots;
+	std::vector<glm::vec3> positions(ids.size());
+	std::vector<glm::quat> rotations(ids.size());
+	float offset = 0.0f;
+	for (auto _ : state)
+	{
+		offset += 0.01f;
+		for (size_t index = 0; index < ids.size(); ++index)
+		{
+			positions[index] = glm::vec3(offset, static_cast<float>(index), 0.0f);
+			rotations[index] = glm::angleAxis(offset, Maths::up_vec);
+		}
+		if (state.range(0) == 1)
+		{
+			hierarchy.transformations.set_poses(ids, positions, rotations);
+			continue;
+		}
+		for (size_t index = 0; index < ids.size(); ++index)
+		{
+			hierarchy.transformations.set_position(ids[index], positions[index]);
+			hierarchy.transformations.set_rotation(ids[index], rotations[index]);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * ids.size());
+}
+}
+
+BENCHMARK(transform_random_reads_after_motion)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(transform_random_reads_synchronised)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(transform_batch_update)->Arg(10'000)->Arg(100'000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(maths_transform_set_pos_after_set_mat4)->Unit(benchmark::kMicrosecond);
+BENCHMARK(transform_set_position)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(transform_set_poses)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
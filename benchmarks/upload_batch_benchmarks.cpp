@@ -0,0 +1,57 @@
+#include <graphics_engine/resource_manager/upload_batch.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace
+{
+constexpr size_t STAGING_CAPACITY = 64 * 1024 * 1024;
+
+VkBuffer fake_buffer(const uintptr_t id)
+{
+	return reinterpret_cast<VkBuffer>(id);
+}
+
+// Records a scene load's worth of vertex and index uploads: range(0) meshes,
+// each a 48 KB vertex copy and a 12 KB index copy into shared buffers. This is
+// the host side of one batched submission; the previous path recorded and
+// waited on one command buffer per copy instead.
+void upload_batch_record_scene(benchmark::State& state)
+{
+	const auto mesh_count = static_cast<size_t>(state.range(0));
+	constexpr size_t VERTEX_BYTES = 48 * 1024;
+	constexpr size_t INDEX_BYTES = 12 * 1024;
+	const auto staging = fake_buffer(1);
+	const auto vertices = fake_buffer(2);
+	const auto indices = fake_buffer(3);
+
+	StagingRing ring(STAGING_CAPACITY);
+	UploadBatch batch;
+	for (auto _ : state)
+	{
+		for (size_t mesh = 0; mesh < mesh_count; ++mesh)
+		{
+			auto vertex_offset = ring.allocate(VERTEX_BYTES, 4);
+			auto index_offset = ring.allocate(INDEX_BYTES, 4);
+			if (!vertex_offset || !index_offset)
+			{
+				// a real queue would flush and wait here
+				ring.release_until(ring.get_head());
+				vertex_offset = ring.allocate(VERTEX_BYTES, 4);
+				index_offset = ring.allocate(INDEX_BYTES, 4);
+			}
+			batch.add_buffer_copy(staging, vertices, VkBufferCopy{ *vertex_offset, mesh * VERTEX_BYTES, VERTEX_BYTES });
+			batch.add_buffer_copy(staging, indices, VkBufferCopy{ *index_offset, mesh * INDEX_BYTES, INDEX_BYTES });
+		}
+		benchmark::DoNotOptimize(batch.get_passes().data());
+		state.counters["regions"] = static_cast<double>(batch.get_passes()[0].buffers[0].regions.size()
+			+ batch.get_passes()[0].buffers[1].regions.size());
+		batch.clear();
+		ring.release_until(ring.get_head());
+	}
+	state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(mesh_count) * 2);
+}
+}
+
+BENCHMARK(upload_batch_record_scene)->Arg(100)->Arg(1000);
@@ -29,6 +29,7 @@ class vulkan_conan(ConanFile):
         # docking release and update the bundled GLFW/Vulkan backends with it.
         "imgui/1.92.8-docking",
         "gtest/1.15.0",
+        "benchmark/1.9.1",
         "yaml-cpp/0.8.0",
         "magic_enum/0.8.2",
         "perlinnoise/3.0.0",
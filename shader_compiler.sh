@@ -39,6 +39,7 @@ compile_shader_dir()
 	mkdir -p "$build_dir"
 
 	compile_if_file_exists "$src_dir" "$build_dir" vertex_shader -fshader-stage=vertex
+	compile_if_file_exists "$src_dir" "$build_dir" instanced_vertex_shader -fshader-stage=vertex
 	compile_if_file_exists "$src_dir" "$build_dir" geometry_shader -fshader-stage=geometry
 	compile_if_file_exists "$src_dir" "$build_dir" fragment_shader -fshader-stage=fragment
 	compile_if_file_exists "$src_dir" "$build_dir" raygen_shader -fshader-stage=rgen --target-env=vulkan1.2
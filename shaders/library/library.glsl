@@ -55,6 +55,16 @@ vec3 orient_pbr_normal(
 	return double_sided != 0 && !front_facing ? -normal : normal;
 }
 
+// Tangent-space normal from the x and y channels alone, so two-channel BC5
+// normal maps sample the same as RGBA8 ones
+vec3 get_pbr_tangent_normal(
+	sampler2D normal_sampler,
+	const vec2 tex_coord)
+{
+	const vec2 xy = texture(normal_sampler, tex_coord).xy * 2.0 - 1.0;
+	return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
 vec3 get_pbr_emissive(
 	const MaterialData material,
 	sampler2D emissive_sampler,
@@ -0,0 +1,25 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../library/library.glsl"
+
+// keep in mind that some types such as dvec3 uses 2 slots therefore we need the next layout location to be 2 indices after
+layout(location=0) in vec3 in_position; // vertex pos
+layout(location=3) in vec3 in_normal; // vertex normal
+
+layout(location=2) out vec3 surface_normal;
+layout(location=4) out vec3 frag_pos;
+
+layout(std430, set=RASTERIZATION_INSTANCE_SET_OFFSET, binding=RASTERIZATION_INSTANCE_DATA_BINDING) readonly buffer InstanceDataBuffer
+{
+	InstanceData data[];
+} instances;
+
+void main()
+{
+	const InstanceData instance = instances.data[gl_InstanceIndex];
+	gl_Position = instance.mvp * vec4(in_position, 1.0);
+	surface_normal = transpose(inverse(mat3(instance.model))) * in_normal;
+	frag_pos = (instance.model * vec4(in_position, 1.0)).xyz;
+}
@@ -72,7 +72,7 @@ void main()
 		const vec3 tangent = normalize(surface_tangent.xyz
 			- geometric_normal * dot(surface_tangent.xyz, geometric_normal));
 		const vec3 bitangent = cross(geometric_normal, tangent) * surface_tangent.w;
-		vec3 tangent_normal = texture(normal_sampler, frag_tex_coord).xyz * 2.0 - 1.0;
+		vec3 tangent_normal = get_pbr_tangent_normal(normal_sampler, frag_tex_coord);
 		tangent_normal.xy *= material.normal_scale;
 		shading_normal = normalize(mat3(tangent, bitangent, geometric_normal) * tangent_normal);
 	}
@@ -0,0 +1,33 @@
+#version 450
+
+#include "../../library/library.glsl"
+
+// keep in mind that some types such as dvec3 uses 2 slots therefore we need the next layout location to be 2 indices after
+layout(location = 0) in vec3 in_position;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec3 inNormal;
+layout(location = 4) in vec4 inTangent;
+
+layout(location=0) out vec2 frag_tex_coord;
+layout(location=1) out vec3 surface_normal;
+layout(location=2) out vec3 frag_pos;
+layout(location=3) out vec4 surface_tangent;
+
+layout(std430, set=RASTERIZATION_INSTANCE_SET_OFFSET, binding=RASTERIZATION_INSTANCE_DATA_BINDING) readonly buffer InstanceDataBuffer
+{
+	InstanceData data[];
+} instances;
+
+void main()
+{
+	const InstanceData instance = instances.data[gl_InstanceIndex];
+	gl_Position = instance.mvp * vec4(in_position, 1.0);
+
+	const mat3 model_matrix = mat3(instance.model);
+	frag_tex_coord = inTexCoord;
+	surface_normal = transpose(inverse(model_matrix)) * inNormal;
+	const float tangent_handedness = determinant(model_matrix) < 0.0
+		? -inTangent.w : inTangent.w;
+	surface_tangent = vec4(model_matrix * inTangent.xyz, tangent_handedness);
+	frag_pos = (instance.model * vec4(in_position, 1.0)).xyz;
+}
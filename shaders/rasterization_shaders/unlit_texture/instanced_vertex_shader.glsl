@@ -0,0 +1,19 @@
+#version 450
+
+#include "../../library/library.glsl"
+
+layout(location = 0) in vec3 in_position;
+layout(location = 2) in vec2 in_tex_coord;
+
+layout(location = 0) out vec2 frag_tex_coord;
+
+layout(std430, set=RASTERIZATION_INSTANCE_SET_OFFSET, binding=RASTERIZATION_INSTANCE_DATA_BINDING) readonly buffer InstanceDataBuffer
+{
+	InstanceData data[];
+} instances;
+
+void main()
+{
+	gl_Position = instances.data[gl_InstanceIndex].mvp * vec4(in_position, 1.0);
+	frag_tex_coord = in_tex_coord;
+}
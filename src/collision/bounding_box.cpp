@@ -2,6 +2,7 @@
 
 #include "objects/object.hpp"
 
+#include <algorithm>
 #include <limits>
 
 
@@ -22,6 +23,23 @@ void AABB::min_max(const AABB& other)
 	max_bound.z = std::max(max_bound.z, other.max_bound.z);
 }
 
+AABB AABB::transformed(const glm::mat4& transform) const
+{
+	glm::vec3 new_min(transform[3]);
+	glm::vec3 new_max(transform[3]);
+	for (int column = 0; column < 3; ++column)
+	{
+		for (int row = 0; row < 3; ++row)
+		{
+			const float a = transform[column][row] * min_bound[column];
+			const float b = transform[column][row] * max_bound[column];
+			new_min[row] += std::min(a, b);
+			new_max[row] += std::max(a, b);
+		}
+	}
+	return AABB(new_min, new_max);
+}
+
 bool AABB::check_collision(const Maths::Ray& ray) const
 {
 	glm::vec3 intersection;
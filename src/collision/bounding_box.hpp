@@ -3,6 +3,7 @@
 #include "maths.hpp"
 
 #include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
 
 #include <vector>
 
@@ -19,6 +20,9 @@ struct AABB
 	bool check_collision(const Maths::Ray& ray) const;
 	bool check_collision(const Maths::Ray& ray, glm::vec3& intersection) const;
 
+	// Returns the axis-aligned bounds of this box after an affine transform
+	AABB transformed(const glm::mat4& transform) const;
+
 	AABB operator+(const glm::vec3& vec) const
 	{
 		return AABB(min_bound+vec, max_bound+vec);
@@ -41,31 +41,6 @@ glm::quat quad_normal_to_rotation(const glm::vec3& normal)
 	return glm::quat_cast(glm::mat3(tangent, bitangent, normalized_normal));
 }
 
-bool ray_triangle_intersection(const Maths::Ray& ray,
-	const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2,
-	float& out_t)
-{
-	const glm::vec3 edge1 = p1 - p0;
-	const glm::vec3 edge2 = p2 - p0;
-	const glm::vec3 p = glm::cross(ray.direction, edge2);
-	const float determinant = glm::dot(edge1, p);
-	if (Maths::absf(determinant) <= Maths::ACCEPTABLE_FLOATING_PT_DIFF)
-		return false;
-
-	const float inverse_determinant = 1.0f / determinant;
-	const glm::vec3 origin_to_triangle = ray.origin - p0;
-	const float u = glm::dot(origin_to_triangle, p) * inverse_determinant;
-	if (u < 0.0f || u > 1.0f)
-		return false;
-	const glm::vec3 q = glm::cross(origin_to_triangle, edge1);
-	const float v = glm::dot(ray.direction, q) * inverse_determinant;
-	if (v < 0.0f || u + v > 1.0f)
-		return false;
-
-	out_t = glm::dot(edge2, q) * inverse_determinant;
-	return out_t >= 0.0f;
-}
-
 }
 
 Object& RayCollider::spawn_debug_object(GameEngine& engine) const
@@ -161,6 +136,18 @@ bool QuadCollider::check_collision(const RayCollider& ray, glm::vec3& out_inters
 	return is_point_in_quad_bounds(out_intersection, quad);
 }
 
+std::optional<AABB> QuadCollider::get_bounds() const
+{
+	const auto quad = get_data();
+	const glm::vec3 normal = glm::normalize(quad.normal);
+	const glm::vec3 ref_axis = glm::abs(normal.y) > 0.99f ? Maths::right_vec : Maths::up_vec;
+	const glm::vec3 tangent = glm::normalize(glm::cross(ref_axis, normal));
+	const glm::vec3 bitangent = glm::normalize(glm::cross(normal, tangent));
+	const glm::vec3 half_extent =
+		glm::abs(tangent) * (0.5f * quad.size.x) + glm::abs(bitangent) * (0.5f * quad.size.y);
+	return AABB(quad.offset - half_extent, quad.offset + half_extent);
+}
+
 bool QuadCollider::is_point_in_quad_bounds(const glm::vec3& point, const Maths::Quad& quad) const
 {
 	const glm::vec3 normal = glm::normalize(quad.normal);
@@ -188,6 +175,13 @@ Maths::Sphere SphereCollider::get_data() const
 	return sphere;
 }
 
+std::optional<AABB> SphereCollider::get_bounds() const
+{
+	const auto sphere = get_data();
+	const glm::vec3 radius(Maths::absf(sphere.radius));
+	return AABB(sphere.origin - radius, sphere.origin + radius);
+}
+
 Object& SphereCollider::spawn_debug_object(GameEngine& engine) const
 {
 	Object& obj = spawn_debug_renderable_object(engine, make_debug_renderable(
@@ -282,6 +276,12 @@ bool CapsuleCollider::check_collision(const RayCollider& ray, glm::vec3& out_int
 	return true;
 }
 
+std::optional<AABB> CapsuleCollider::get_bounds() const
+{
+	return AABB(glm::vec3(-radius, 0.0f, -radius), glm::vec3(radius, height, radius))
+		.transformed(get_temporary_transform().get_mat4());
+}
+
 Object& CapsuleCollider::spawn_debug_object(GameEngine& engine) const
 {
 	Object& obj = spawn_debug_renderable_object(engine,
@@ -321,6 +321,11 @@ bool BoxCollider::check_collision(const RayCollider& ray, glm::vec3& out_interse
 	return true;
 }
 
+std::optional<AABB> BoxCollider::get_bounds() const
+{
+	return data.transformed(get_temporary_transform().get_mat4());
+}
+
 Object& BoxCollider::spawn_debug_object(GameEngine& engine) const
 {
 	auto& ecs = engine.get_ecs();
@@ -356,46 +361,7 @@ bool MeshCollider::check_collision(const RayCollider& ray, glm::vec3& out_inters
 	bool collided = false;
 	float closest_t = std::numeric_limits<float>::infinity();
 	for (const auto& mesh : meshes)
-	{
-		const MeshPickData& data = mesh->get().get_pick_data();
-		if (!data.has_triangles())
-			continue;
-		glm::vec3 unused_intersection;
-		if (!data.get_bounds().check_collision(local_ray, unused_intersection))
-			continue;
-
-		std::vector<uint32_t> stack{ 0 };
-		const auto& nodes = data.get_nodes();
-		const auto& positions = data.get_positions();
-		const auto& triangles = data.get_triangles();
-		const auto& triangle_indices = data.get_triangle_indices();
-		while (!stack.empty())
-		{
-			const MeshBvhNode& node = nodes[stack.back()];
-			stack.pop_back();
-			if (!node.bounds.check_collision(local_ray, unused_intersection))
-				continue;
-			if (!node.is_leaf())
-			{
-				stack.push_back(node.first);
-				stack.push_back(node.second);
-				continue;
-			}
-
-			for (uint32_t i = 0; i < node.count; ++i)
-			{
-				const auto& triangle = triangles[triangle_indices[node.first + i]];
-				float t;
-				if (ray_triangle_intersection(local_ray,
-					positions[triangle.vertices[0]], positions[triangle.vertices[1]], positions[triangle.vertices[2]], t) &&
-					t < closest_t)
-				{
-					closest_t = t;
-					collided = true;
-				}
-			}
-		}
-	}
+		collided = mesh->get().get_pick_data().raycast(local_ray, closest_t) || collided;
 
 	if (!collided)
 		return false;
@@ -403,6 +369,24 @@ bool MeshCollider::check_collision(const RayCollider& ray, glm::vec3& out_inters
 	return true;
 }
 
+std::optional<AABB> MeshCollider::get_bounds() const
+{
+	std::optional<AABB> bounds;
+	for (const auto& mesh : meshes)
+	{
+		const auto& data = mesh->get().get_pick_data();
+		if (!data.has_bounds())
+			continue;
+		if (!bounds)
+			bounds = data.get_bounds();
+		else
+			bounds->min_max(data.get_bounds());
+	}
+	if (!bounds)
+		return std::nullopt;
+	return bounds->transformed(get_temporary_transform().get_mat4());
+}
+
 Object& MeshCollider::spawn_debug_object(GameEngine& engine) const
 {
 	Object& obj = spawn_debug_renderable_object(engine,
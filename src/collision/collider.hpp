@@ -7,6 +7,7 @@
 
 #include <glm/vec2.hpp>
 
+#include <optional>
 #include <vector>
 
 class GameEngine;
@@ -27,6 +28,9 @@ struct Collider
 	virtual ~Collider() = default;
 	virtual ECollider get_type() const = 0;
 	virtual void apply_transform(const Maths::Transform& transform) {}
+	// World-space bounds under the temporary transform. Colliders without finite
+	// bounds return nullopt and are tested individually by ColliderSystem::raycast.
+	virtual std::optional<AABB> get_bounds() const { return std::nullopt; }
 	virtual Object& spawn_debug_object(GameEngine& engine) const = 0;
 	virtual void update_debug_object(GameEngine& engine, Object& object) const = 0;
 
@@ -61,6 +65,7 @@ struct QuadCollider : public Collider
 	QuadCollider() = default;
 	QuadCollider(const Maths::Plane& plane, const glm::vec2& size) : data(plane.offset, plane.normal, size) {}
 	virtual ECollider get_type() const override { return ECollider::QUAD; }
+	virtual std::optional<AABB> get_bounds() const override;
 	virtual Object& spawn_debug_object(GameEngine& engine) const override;
 	virtual void update_debug_object(GameEngine& engine, Object& object) const override;
 
@@ -80,6 +85,7 @@ struct SphereCollider : public Collider
 	SphereCollider() = default;
 	SphereCollider(const Maths::Sphere& sphere) : data(sphere) {}
 	virtual ECollider get_type() const override { return ECollider::SPHERE; }
+	virtual std::optional<AABB> get_bounds() const override;
 	virtual Object& spawn_debug_object(GameEngine& engine) const override;
 	virtual void update_debug_object(GameEngine& engine, Object& object) const override;
 	Maths::Sphere get_data() const;
@@ -95,6 +101,7 @@ struct CapsuleCollider : public Collider
 {
 	CapsuleCollider(float radius, float height);
 	virtual ECollider get_type() const override { return ECollider::CAPSULE; }
+	virtual std::optional<AABB> get_bounds() const override;
 	virtual Object& spawn_debug_object(GameEngine& engine) const override;
 	virtual void update_debug_object(GameEngine& engine, Object& object) const override;
 
@@ -115,6 +122,7 @@ struct BoxCollider : public Collider
 	BoxCollider() = default;
 	BoxCollider(const AABB& bounds) : data(bounds) {}
 	virtual ECollider get_type() const override { return ECollider::BOX; }
+	virtual std::optional<AABB> get_bounds() const override;
 	virtual Object& spawn_debug_object(GameEngine& engine) const override;
 	virtual void update_debug_object(GameEngine& engine, Object& object) const override;
 
@@ -132,6 +140,7 @@ struct MeshCollider : public Collider
 {
 	explicit MeshCollider(std::vector<MeshHandle> meshes) : meshes(std::move(meshes)) {}
 	virtual ECollider get_type() const override { return ECollider::MESH; }
+	virtual std::optional<AABB> get_bounds() const override;
 	virtual Object& spawn_debug_object(GameEngine& engine) const override;
 	virtual void update_debug_object(GameEngine& engine, Object& object) const override;
 
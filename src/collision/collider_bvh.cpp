@@ -0,0 +1,343 @@
+#include "collider_bvh.hpp"
+
+#include <algorithm>
+
+
+namespace
+{
+AABB combine(const AABB& first, const AABB& second)
+{
+	AABB combined = first;
+	combined.min_max(second);
+	return combined;
+}
+
+// Half the surface area is sufficient for comparing insertion costs
+float half_area(const AABB& bounds)
+{
+	const glm::vec3 size = bounds.max_bound - bounds.min_bound;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+bool contains(const AABB& outer, const AABB& inner)
+{
+	return outer.min_bound.x <= inner.min_bound.x
+		&& outer.min_bound.y <= inner.min_bound.y
+		&& outer.min_bound.z <= inner.min_bound.z
+		&& outer.max_bound.x >= inner.max_bound.x
+		&& outer.max_bound.y >= inner.max_bound.y
+		&& outer.max_bound.z >= inner.max_bound.z;
+}
+
+AABB enlarge(const AABB& bounds, const float margin)
+{
+	return AABB(bounds.min_bound - glm::vec3(margin), bounds.max_bound + glm::vec3(margin));
+}
+}
+
+
+uint32_t ColliderBvh::insert(const EntityID id, const AABB& bounds)
+{
+	const uint32_t leaf = allocate_node();
+	nodes[leaf].bounds = enlarge(bounds, LEAF_MARGIN);
+	nodes[leaf].id = id;
+	insert_leaf(leaf);
+	++leaf_count;
+	return leaf;
+}
+
+void ColliderBvh::remove(const uint32_t leaf)
+{
+	remove_leaf(leaf);
+	free_node(leaf);
+	--leaf_count;
+}
+
+bool ColliderBvh::update(const uint32_t leaf, const AABB& bounds)
+{
+	// Keep the leaf in place while its stored bounds still contain the new bounds
+	// without being excessively loose, e.g. after an object shrinks
+	const AABB& stored = nodes[leaf].bounds;
+	if (contains(stored, bounds) && contains(enlarge(bounds, 4.0f * LEAF_MARGIN), stored))
+		return false;
+
+	remove_leaf(leaf);
+	nodes[leaf].bounds = enlarge(bounds, LEAF_MARGIN);
+	insert_leaf(leaf);
+	return true;
+}
+
+void ColliderBvh::clear()
+{
+	nodes.clear();
+	root = NULL_NODE;
+	free_list = NULL_NODE;
+	leaf_count = 0;
+}
+
+uint32_t ColliderBvh::get_height() const
+{
+	return root == NULL_NODE ? 0 : static_cast<uint32_t>(nodes[root].height) + 1;
+}
+
+ColliderBvh::PreparedRay ColliderBvh::prepare_ray(const Maths::Ray& ray)
+{
+	PreparedRay prepared;
+	prepared.origin = ray.origin;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		prepared.parallel[axis] =
+			Maths::absf(ray.direction[axis]) <= std::numeric_limits<float>::epsilon();
+		prepared.inverse_direction[axis] = prepared.parallel[axis] ? 0.0f : 1.0f / ray.direction[axis];
+	}
+	return prepared;
+}
+
+std::optional<float> ColliderBvh::entry_distance(const PreparedRay& ray, const AABB& bounds)
+{
+	float near_t = -std::numeric_limits<float>::infinity();
+	float far_t = std::numeric_limits<float>::infinity();
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const float origin = ray.origin[axis];
+		if (ray.parallel[axis])
+		{
+			if (origin < bounds.min_bound[axis] || origin > bounds.max_bound[axis])
+				return std::nullopt;
+			continue;
+		}
+
+		float t0 = (bounds.min_bound[axis] - origin) * ray.inverse_direction[axis];
+		float t1 = (bounds.max_bound[axis] - origin) * ray.inverse_direction[axis];
+		if (t0 > t1)
+			std::swap(t0, t1);
+		near_t = std::max(near_t, t0);
+		far_t = std::min(far_t, t1);
+		if (near_t > far_t)
+			return std::nullopt;
+	}
+
+	if (far_t < 0.0f)
+		return std::nullopt;
+	return std::max(near_t, 0.0f);
+}
+
+uint32_t ColliderBvh::allocate_node()
+{
+	if (free_list == NULL_NODE)
+	{
+		nodes.emplace_back();
+		return static_cast<uint32_t>(nodes.size() - 1);
+	}
+
+	const uint32_t node = free_list;
+	free_list = nodes[node].parent;
+	nodes[node] = Node();
+	return node;
+}
+
+void ColliderBvh::free_node(const uint32_t node)
+{
+	nodes[node].parent = free_list;
+	nodes[node].height = -1;
+	free_list = node;
+}
+
+void ColliderBvh::insert_leaf(const uint32_t leaf)
+{
+	if (root == NULL_NODE)
+	{
+		root = leaf;
+		nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+
+	// Descend towards the sibling that minimises the added surface area
+	const AABB leaf_bounds = nodes[leaf].bounds;
+	uint32_t index = root;
+	while (!nodes[index].is_leaf())
+	{
+		const Node& node = nodes[index];
+		const float area = half_area(node.bounds);
+		const float combined_area = half_area(combine(node.bounds, leaf_bounds));
+		// cost of creating a new parent for this node and the new leaf
+		const float cost = 2.0f * combined_area;
+		// minimum cost of pushing the leaf further down the tree
+		const float inheritance_cost = 2.0f * (combined_area - area);
+
+		const auto child_cost = [&](const uint32_t child)
+		{
+			const float enlarged_area = half_area(combine(nodes[child].bounds, leaf_bounds));
+			return nodes[child].is_leaf()
+				? enlarged_area + inheritance_cost
+				: enlarged_area - half_area(nodes[child].bounds) + inheritance_cost;
+		};
+		const float first_cost = child_cost(node.children[0]);
+		const float second_cost = child_cost(node.children[1]);
+		if (cost < first_cost && cost < second_cost)
+			break;
+		index = first_cost < second_cost ? node.children[0] : node.children[1];
+	}
+
+	const uint32_t sibling = index;
+	const uint32_t old_parent = nodes[sibling].parent;
+	const uint32_t new_parent = allocate_node();
+	nodes[new_parent].parent = old_parent;
+	nodes[new_parent].bounds = combine(leaf_bounds, nodes[sibling].bounds);
+	nodes[new_parent].height = nodes[sibling].height + 1;
+	nodes[new_parent].children[0] = sibling;
+	nodes[new_parent].children[1] = leaf;
+	nodes[sibling].parent = new_parent;
+	nodes[leaf].parent = new_parent;
+	if (old_parent == NULL_NODE)
+		root = new_parent;
+	else if (nodes[old_parent].children[0] == sibling)
+		nodes[old_parent].children[0] = new_parent;
+	else
+		nodes[old_parent].children[1] = new_parent;
+
+	refit_ancestors(nodes[leaf].parent);
+}
+
+void ColliderBvh::remove_leaf(const uint32_t leaf)
+{
+	if (leaf == root)
+	{
+		root = NULL_NODE;
+		return;
+	}
+
+	const uint32_t parent = nodes[leaf].parent;
+	const uint32_t grandparent = nodes[parent].parent;
+	const uint32_t sibling = nodes[parent].children[0] == leaf
+		? nodes[parent].children[1]
+		: nodes[parent].children[0];
+	free_node(parent);
+	if (grandparent == NULL_NODE)
+	{
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+		return;
+	}
+
+	if (nodes[grandparent].children[0] == parent)
+		nodes[grandparent].children[0] = sibling;
+	else
+		nodes[grandparent].children[1] = sibling;
+	nodes[sibling].parent = grandparent;
+	refit_ancestors(grandparent);
+}
+
+void ColliderBvh::refit_ancestors(uint32_t index)
+{
+	while (index != NULL_NODE)
+	{
+		index = balance(index);
+		Node& node = nodes[index];
+		const Node& first = nodes[node.children[0]];
+		const Node& second = nodes[node.children[1]];
+		node.height = 1 + std::max(first.height, second.height);
+		node.bounds = combine(first.bounds, second.bounds);
+		index = node.parent;
+	}
+}
+
+// Performs a left or right rotation if the node is imbalanced and returns the
+// index of the subtree's new root
+uint32_t ColliderBvh::balance(const uint32_t a)
+{
+	Node& node_a = nodes[a];
+	if (node_a.is_leaf() || node_a.height < 2)
+		return a;
+
+	const uint32_t b = node_a.children[0];
+	const uint32_t c = node_a.children[1];
+	Node& node_b = nodes[b];
+	Node& node_c = nodes[c];
+	const int32_t imbalance = node_c.height - node_b.height;
+
+	const auto replace_in_parent = [this](const uint32_t old_child, const uint32_t new_child)
+	{
+		const uint32_t parent = nodes[new_child].parent;
+		if (parent == NULL_NODE)
+			root = new_child;
+		else if (nodes[parent].children[0] == old_child)
+			nodes[parent].children[0] = new_child;
+		else
+			nodes[parent].children[1] = new_child;
+	};
+
+	// rotate c up
+	if (imbalance > 1)
+	{
+		const uint32_t f = node_c.children[0];
+		const uint32_t g = node_c.children[1];
+		Node& node_f = nodes[f];
+		Node& node_g = nodes[g];
+
+		node_c.children[0] = a;
+		node_c.parent = node_a.parent;
+		node_a.parent = c;
+		replace_in_parent(a, c);
+
+		if (node_f.height > node_g.height)
+		{
+			node_c.children[1] = f;
+			node_a.children[1] = g;
+			node_g.parent = a;
+			node_a.bounds = combine(node_b.bounds, node_g.bounds);
+			node_c.bounds = combine(node_a.bounds, node_f.bounds);
+			node_a.height = 1 + std::max(node_b.height, node_g.height);
+			node_c.height = 1 + std::max(node_a.height, node_f.height);
+		}
+		else
+		{
+			node_c.children[1] = g;
+			node_a.children[1] = f;
+			node_f.parent = a;
+			node_a.bounds = combine(node_b.bounds, node_f.bounds);
+			node_c.bounds = combine(node_a.bounds, node_g.bounds);
+			node_a.height = 1 + std::max(node_b.height, node_f.height);
+			node_c.height = 1 + std::max(node_a.height, node_g.height);
+		}
+		return c;
+	}
+
+	// rotate b up
+	if (imbalance < -1)
+	{
+		const uint32_t d = node_b.children[0];
+		const uint32_t e = node_b.children[1];
+		Node& node_d = nodes[d];
+		Node& node_e = nodes[e];
+
+		node_b.children[0] = a;
+		node_b.parent = node_a.parent;
+		node_a.parent = b;
+		replace_in_parent(a, b);
+
+		if (node_d.height > node_e.height)
+		{
+			node_b.children[1] = d;
+			node_a.children[0] = e;
+			node_e.parent = a;
+			node_a.bounds = combine(node_c.bounds, node_e.bounds);
+			node_b.bounds = combine(node_a.bounds, node_d.bounds);
+			node_a.height = 1 + std::max(node_c.height, node_e.height);
+			node_b.height = 1 + std::max(node_a.height, node_d.height);
+		}
+		else
+		{
+			node_b.children[1] = e;
+			node_a.children[0] = d;
+			node_d.parent = a;
+			node_a.bounds = combine(node_c.bounds, node_d.bounds);
+			node_b.bounds = combine(node_a.bounds, node_e.bounds);
+			node_a.height = 1 + std::max(node_c.height, node_d.height);
+			node_b.height = 1 + std::max(node_a.height, node_e.height);
+		}
+		return b;
+	}
+
+	return a;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "collision/bounding_box.hpp"
+#include "identifications.hpp"
+#include "maths.hpp"
+
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+
+// Incrementally maintained world-space AABB tree over collider bounds. Leaves
+// store enlarged bounds so that small motions only require a bounds check;
+// leaves that escape them are reinserted, and the tree is kept balanced with
+// AVL-style rotations.
+class ColliderBvh
+{
+public:
+	static constexpr uint32_t NULL_NODE = std::numeric_limits<uint32_t>::max();
+	// Absolute margin added to every side of a leaf's bounds
+	static constexpr float LEAF_MARGIN = 0.1f;
+
+	uint32_t insert(EntityID id, const AABB& bounds);
+	void remove(uint32_t leaf);
+	// Returns true if the leaf had to be reinserted
+	bool update(uint32_t leaf, const AABB& bounds);
+	void clear();
+
+	uint32_t size() const { return leaf_count; }
+	bool empty() const { return leaf_count == 0; }
+	uint32_t get_height() const;
+	const AABB& get_leaf_bounds(uint32_t leaf) const { return nodes[leaf].bounds; }
+	EntityID get_leaf_id(uint32_t leaf) const { return nodes[leaf].id; }
+
+	// Visits leaves whose bounds the ray enters no later than max_t (in units of
+	// the ray direction), nearer children first. The visitor receives the leaf's
+	// entity and returns the new max_t, which lets traversal skip every subtree
+	// beyond the closest confirmed hit.
+	template<typename Visitor>
+	void raycast(const Maths::Ray& ray, float max_t, Visitor&& visitor) const;
+
+private:
+	struct Node
+	{
+		AABB bounds;
+		EntityID id;
+		// Doubles as the free list link for unused nodes
+		uint32_t parent = NULL_NODE;
+		uint32_t children[2] = { NULL_NODE, NULL_NODE };
+		int32_t height = 0;
+
+		bool is_leaf() const { return children[0] == NULL_NODE; }
+	};
+
+	struct PreparedRay
+	{
+		glm::vec3 origin;
+		glm::vec3 inverse_direction;
+		bool parallel[3];
+	};
+
+	static PreparedRay prepare_ray(const Maths::Ray& ray);
+	// Returns the parametric distance at which the ray enters the bounds,
+	// clamped to zero when the origin is inside, or nullopt on a miss
+	static std::optional<float> entry_distance(const PreparedRay& ray, const AABB& bounds);
+
+	uint32_t allocate_node();
+	void free_node(uint32_t node);
+	void insert_leaf(uint32_t leaf);
+	void remove_leaf(uint32_t leaf);
+	uint32_t balance(uint32_t node);
+	void refit_ancestors(uint32_t node);
+
+	std::vector<Node> nodes;
+	uint32_t root = NULL_NODE;
+	uint32_t free_list = NULL_NODE;
+	uint32_t leaf_count = 0;
+	mutable std::vector<std::pair<uint32_t, float>> traversal_stack;
+};
+
+template<typename Visitor>
+void ColliderBvh::raycast(const Maths::Ray& ray, float max_t, Visitor&& visitor) const
+{
+	if (root == NULL_NODE)
+		return;
+	const PreparedRay prepared = prepare_ray(ray);
+	const auto root_entry = entry_distance(prepared, nodes[root].bounds);
+	if (!root_entry || *root_entry > max_t)
+		return;
+
+	traversal_stack.clear();
+	traversal_stack.emplace_back(root, *root_entry);
+	while (!traversal_stack.empty())
+	{
+		const auto [index, entry] = traversal_stack.back();
+		traversal_stack.pop_back();
+		// max_t may have shrunk since this node was pushed
+		if (entry > max_t)
+			continue;
+
+		const Node& node = nodes[index];
+		if (node.is_leaf())
+		{
+			max_t = visitor(node.id, max_t);
+			continue;
+		}
+
+		const auto first = entry_distance(prepared, nodes[node.children[0]].bounds);
+		const auto second = entry_distance(prepared, nodes[node.children[1]].bounds);
+		const bool first_valid = first && *first <= max_t;
+		const bool second_valid = second && *second <= max_t;
+		if (first_valid && second_valid)
+		{
+			// push the farther child first so that the nearer one is visited next
+			if (*first <= *second)
+			{
+				traversal_stack.emplace_back(node.children[1], *second);
+				traversal_stack.emplace_back(node.children[0], *first);
+			}
+			else
+			{
+				traversal_stack.emplace_back(node.children[0], *first);
+				traversal_stack.emplace_back(node.children[1], *second);
+			}
+		}
+		else if (first_valid)
+			traversal_stack.emplace_back(node.children[0], *first);
+		else if (second_valid)
+			traversal_stack.emplace_back(node.children[1], *second);
+	}
+}
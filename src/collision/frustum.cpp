@@ -0,0 +1,122 @@
+#include "frustum.hpp"
+
+#include <immintrin.h>
+
+#include <bit>
+#include <cmath>
+
+
+Frustum Frustum::from_view_projection(const glm::mat4& view_projection)
+{
+	const auto row = [&view_projection](const int index) {
+		return glm::vec4(
+			view_projection[0][index],
+			view_projection[1][index],
+			view_projection[2][index],
+			view_projection[3][index]);
+	};
+	const glm::vec4 x = row(0);
+	const glm::vec4 y = row(1);
+	const glm::vec4 z = row(2);
+	const glm::vec4 w = row(3);
+	return { .planes = { w + x, w - x, w + y, w - y, z, w - z } };
+}
+
+bool Frustum::intersects(const AABB& bounds) const
+{
+	const glm::vec3 centre = (bounds.min_bound + bounds.max_bound) * 0.5f;
+	const glm::vec3 extent = (bounds.max_bound - bounds.min_bound) * 0.5f;
+	for (const glm::vec4& plane : planes)
+	{
+		// the distance of the box's most inward corner along the plane normal
+		const float distance = plane.x * centre.x + plane.y * centre.y + plane.z * centre.z + plane.w;
+		const float radius = std::abs(plane.x) * extent.x
+			+ std::abs(plane.y) * extent.y
+			+ std::abs(plane.z) * extent.z;
+		if (distance + radius < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+void FrustumCuller::clear()
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		centres[axis].clear();
+		extents[axis].clear();
+	}
+	count = 0;
+}
+
+void FrustumCuller::reserve(const size_t reserved_count)
+{
+	const size_t padded_count = (reserved_count + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		centres[axis].reserve(padded_count);
+		extents[axis].reserve(padded_count);
+	}
+}
+
+uint32_t FrustumCuller::add(const AABB& bounds)
+{
+	if (count % BATCH_SIZE == 0)
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			centres[axis].resize(count + BATCH_SIZE, 0.0f);
+			extents[axis].resize(count + BATCH_SIZE, 0.0f);
+		}
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		centres[axis][count] = (bounds.min_bound[axis] + bounds.max_bound[axis]) * 0.5f;
+		extents[axis][count] = (bounds.max_bound[axis] - bounds.min_bound[axis]) * 0.5f;
+	}
+	return count++;
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	__m256 normals[6][3];
+	__m256 abs_normals[6][3];
+	__m256 distances[6];
+	for (int plane = 0; plane < 6; ++plane)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			normals[plane][axis] = _mm256_set1_ps(frustum.planes[plane][axis]);
+			abs_normals[plane][axis] = _mm256_set1_ps(std::abs(frustum.planes[plane][axis]));
+		}
+		distances[plane] = _mm256_set1_ps(frustum.planes[plane].w);
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+	for (uint32_t first = 0; first < count; first += BATCH_SIZE)
+	{
+		const __m256 centre_x = _mm256_loadu_ps(centres[0].data() + first);
+		const __m256 centre_y = _mm256_loadu_ps(centres[1].data() + first);
+		const __m256 centre_z = _mm256_loadu_ps(centres[2].data() + first);
+		const __m256 extent_x = _mm256_loadu_ps(extents[0].data() + first);
+		const __m256 extent_y = _mm256_loadu_ps(extents[1].data() + first);
+		const __m256 extent_z = _mm256_loadu_ps(extents[2].data() + first);
+
+		int inside = (1 << BATCH_SIZE) - 1;
+		for (int plane = 0; plane < 6 && inside != 0; ++plane)
+		{
+			__m256 distance = _mm256_fmadd_ps(normals[plane][0], centre_x, distances[plane]);
+			distance = _mm256_fmadd_ps(normals[plane][1], centre_y, distance);
+			distance = _mm256_fmadd_ps(normals[plane][2], centre_z, distance);
+			distance = _mm256_fmadd_ps(abs_normals[plane][0], extent_x, distance);
+			distance = _mm256_fmadd_ps(abs_normals[plane][1], extent_y, distance);
+			distance = _mm256_fmadd_ps(abs_normals[plane][2], extent_z, distance);
+			inside &= _mm256_movemask_ps(_mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+
+		// padding lanes of the final batch are not boxes
+		if (count - first < BATCH_SIZE)
+			inside &= (1 << (count - first)) - 1;
+		for (; inside != 0; inside &= inside - 1)
+			visible.push_back(first + static_cast<uint32_t>(std::countr_zero(static_cast<unsigned>(inside))));
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "collision/bounding_box.hpp"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+// The six planes bounding a view volume. Each plane is (normal, distance) with
+// the normal facing inwards, so points inside satisfy dot(normal, p) + distance >= 0.
+struct Frustum
+{
+	// Extracts the planes of a view-projection matrix whose clip-space depth
+	// runs from 0 to 1, as with GLM_FORCE_DEPTH_ZERO_TO_ONE
+	static Frustum from_view_projection(const glm::mat4& view_projection);
+
+	// Conservative: a box outside the frustum but not wholly behind any single
+	// plane, typically near a corner, is reported as intersecting
+	bool intersects(const AABB& bounds) const;
+
+	std::array<glm::vec4, 6> planes;
+};
+
+// World-space boxes stored as centres and half extents in structure-of-arrays
+// order, so that a frustum can be tested against eight of them at a time.
+class FrustumCuller
+{
+public:
+	static constexpr uint32_t BATCH_SIZE = 8;
+
+	void clear();
+	void reserve(size_t count);
+	// Returns the index cull reports the box under
+	uint32_t add(const AABB& bounds);
+	uint32_t size() const { return count; }
+
+	// Replaces visible with the indices of the boxes that intersect the
+	// frustum, in ascending order. Same test as Frustum::intersects.
+	void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+private:
+	// Padded to a whole number of batches
+	std::vector<float> centres[3];
+	std::vector<float> extents[3];
+	uint32_t count = 0;
+};
@@ -1,38 +1,323 @@
 #include "mesh_bvh.hpp"
+#include "task_pool.hpp"
+
+#include <immintrin.h>
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <limits>
+#include <stdexcept>
 
 namespace
 {
-constexpr uint32_t LEAF_TRIANGLE_COUNT = 8;
+constexpr uint32_t SAH_BIN_COUNT = 16;
+// Larger ranges are always split, even if SAH prefers a leaf
+constexpr uint32_t MAX_LEAF_TRIANGLE_COUNT = 8;
+constexpr uint32_t TRIANGLE_BATCH_SIZE = 4;
+// Cost of visiting a node relative to one batch of triangle tests
+constexpr float TRAVERSAL_COST = 1.0f;
+constexpr uint32_t INLINE_TRAVERSAL_DEPTH = 64;
+// Ranges at least this large are split across the task pool
+constexpr uint32_t PARALLEL_BUILD_TRIANGLE_COUNT = 16'384;
+
+AABB empty_bounds()
+{
+	return AABB(glm::vec3(std::numeric_limits<float>::infinity()),
+		glm::vec3(-std::numeric_limits<float>::infinity()));
+}
+
+void grow(AABB& bounds, const glm::vec3& point)
+{
+	bounds.min_bound = glm::min(bounds.min_bound, point);
+	bounds.max_bound = glm::max(bounds.max_bound, point);
+}
+
+// Half the surface area is sufficient for comparing split costs
+float half_area(const AABB& bounds)
+{
+	const glm::vec3 size = glm::max(bounds.max_bound - bounds.min_bound, glm::vec3(0.0f));
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+float leaf_cost(const uint32_t count)
+{
+	return static_cast<float>((count + TRIANGLE_BATCH_SIZE - 1) / TRIANGLE_BATCH_SIZE);
+}
+
+struct BuildTask
+{
+	uint32_t first;
+	uint32_t count;
+	// Node whose offset must point at this task's node, if it is a right child
+	uint32_t parent;
+	uint32_t depth;
+};
 
-AABB triangle_bounds(const std::vector<glm::vec3>& positions, const uint32_t* triangle)
+struct Bin
 {
-	AABB bounds(positions[triangle[0]], positions[triangle[0]]);
-	for (int i = 1; i < 3; ++i)
+	AABB bounds = empty_bounds();
+	uint32_t count = 0;
+};
+
+// Binned SAH builder. Subtrees over disjoint triangle ranges only touch their
+// own part of `order`, so large ranges can be built concurrently and spliced.
+struct NodeBuilder
+{
+	std::vector<AABB> triangle_bounds;
+	std::vector<glm::vec3> centroids;
+	std::vector<uint32_t> order;
+
+	// Partitions order[first, first + count) and returns the size of the left
+	// half, or zero if the range should become a leaf
+	uint32_t split(const uint32_t first, const uint32_t count, const AABB& node_bounds)
 	{
-		const auto& point = positions[triangle[i]];
-		bounds.min_bound = glm::min(bounds.min_bound, point);
-		bounds.max_bound = glm::max(bounds.max_bound, point);
+		if (count == 1)
+			return 0;
+
+		AABB centroid_bounds = empty_bounds();
+		for (uint32_t i = first; i < first + count; ++i)
+			grow(centroid_bounds, centroids[order[i]]);
+
+		// Evaluate every bin boundary on every axis
+		float best_cost = std::numeric_limits<float>::infinity();
+		int best_axis = -1;
+		uint32_t best_split = 0;
+		const glm::vec3 centroid_extent = centroid_bounds.max_bound - centroid_bounds.min_bound;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (centroid_extent[axis] <= std::numeric_limits<float>::epsilon())
+				continue;
+			const float bin_scale = SAH_BIN_COUNT / centroid_extent[axis];
+			std::array<Bin, SAH_BIN_COUNT> bins;
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const uint32_t bin = std::min(SAH_BIN_COUNT - 1, static_cast<uint32_t>(
+					(centroids[order[i]][axis] - centroid_bounds.min_bound[axis]) * bin_scale));
+				bins[bin].bounds.min_max(triangle_bounds[order[i]]);
+				++bins[bin].count;
+			}
+
+			// Sweep from the right to record the cost of every right-hand side
+			std::array<float, SAH_BIN_COUNT> right_costs;
+			AABB right_bounds = empty_bounds();
+			uint32_t right_count = 0;
+			for (uint32_t bin = SAH_BIN_COUNT - 1; bin > 0; --bin)
+			{
+				right_bounds.min_max(bins[bin].bounds);
+				right_count += bins[bin].count;
+				right_costs[bin] = right_count ? half_area(right_bounds) * leaf_cost(right_count) : 0.0f;
+			}
+
+			AABB left_bounds = empty_bounds();
+			uint32_t left_count = 0;
+			for (uint32_t split = 1; split < SAH_BIN_COUNT; ++split)
+			{
+				left_bounds.min_max(bins[split - 1].bounds);
+				left_count += bins[split - 1].count;
+				if (left_count == 0 || left_count == count)
+					continue;
+				const float cost = half_area(left_bounds) * leaf_cost(left_count) + right_costs[split];
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = split;
+				}
+			}
+		}
+
+		const float node_area = half_area(node_bounds);
+		const float split_cost = node_area > 0.0f
+			? TRAVERSAL_COST + best_cost / node_area
+			: std::numeric_limits<float>::infinity();
+		if (split_cost >= leaf_cost(count) && count <= MAX_LEAF_TRIANGLE_COUNT)
+			return 0;
+
+		const auto begin = order.begin() + first;
+		const auto end = begin + count;
+		auto middle = begin;
+		if (best_axis >= 0)
+		{
+			const float bin_scale = SAH_BIN_COUNT / centroid_extent[best_axis];
+			middle = std::partition(begin, end, [&](const uint32_t triangle)
+			{
+				const uint32_t bin = std::min(SAH_BIN_COUNT - 1, static_cast<uint32_t>(
+					(centroids[triangle][best_axis] - centroid_bounds.min_bound[best_axis]) * bin_scale));
+				return bin < best_split;
+			});
+		}
+		if (middle == begin || middle == end)
+		{
+			// Coincident centroids: fall back to an object median on the longest axis
+			const glm::vec3 extent = node_bounds.max_bound - node_bounds.min_bound;
+			const int axis = extent.y > extent.x && extent.y >= extent.z ? 1 : (extent.z > extent.x ? 2 : 0);
+			middle = begin + count / 2;
+			std::nth_element(begin, middle, end, [&](const uint32_t left, const uint32_t right)
+			{
+				return centroids[left][axis] < centroids[right][axis];
+			});
+		}
+		return static_cast<uint32_t>(middle - begin);
+	}
+
+	AABB range_bounds(const uint32_t first, const uint32_t count) const
+	{
+		AABB bounds = empty_bounds();
+		for (uint32_t i = first; i < first + count; ++i)
+			bounds.min_max(triangle_bounds[order[i]]);
+		return bounds;
+	}
+
+	// Appends the subtree for the range to `nodes`, with child offsets relative
+	// to the front of `nodes`, and returns its depth. Nodes are emitted
+	// depth-first from an explicit task stack, so degenerate inputs cannot
+	// exhaust the call stack.
+	uint32_t build(const uint32_t first, const uint32_t count, std::vector<MeshBvhNode>& nodes)
+	{
+		nodes.reserve(nodes.size() + 2 * count - 1);
+		uint32_t depth = 0;
+		std::vector<BuildTask> tasks{ { first, count, std::numeric_limits<uint32_t>::max(), 1 } };
+		while (!tasks.empty())
+		{
+			const BuildTask task = tasks.back();
+			tasks.pop_back();
+			depth = std::max(depth, task.depth);
+
+			const uint32_t node_index = static_cast<uint32_t>(nodes.size());
+			if (task.parent != std::numeric_limits<uint32_t>::max())
+				nodes[task.parent].offset = node_index;
+
+			const AABB node_bounds = range_bounds(task.first, task.count);
+			nodes.push_back({ .min_bound = node_bounds.min_bound, .offset = task.first,
+				.max_bound = node_bounds.max_bound, .count = task.count });
+			const uint32_t left_count = split(task.first, task.count, node_bounds);
+			if (left_count == 0)
+				continue;
+
+			nodes[node_index].offset = 0;
+			nodes[node_index].count = 0;
+			// The right child is pushed first so that the left child directly follows its parent
+			tasks.push_back({ task.first + left_count, task.count - left_count, node_index, task.depth + 1 });
+			tasks.push_back({ task.first, left_count, std::numeric_limits<uint32_t>::max(), task.depth + 1 });
+		}
+		return depth;
 	}
-	return bounds;
+
+	// Builds the two halves of large ranges as a two-range parallel_for, so a
+	// worker may take one and the caller runs no unrelated queued task. Each
+	// half is built into its own array and then spliced behind the parent,
+	// which only needs its interior offsets shifted because leaf offsets index
+	// triangles.
+	uint32_t build_parallel(TaskPool& pool, const uint32_t first, const uint32_t count, std::vector<MeshBvhNode>& nodes)
+	{
+		if (count < PARALLEL_BUILD_TRIANGLE_COUNT)
+			return build(first, count, nodes);
+
+		const AABB node_bounds = range_bounds(first, count);
+		const uint32_t left_count = split(first, count, node_bounds);
+		std::vector<MeshBvhNode> left_nodes;
+		std::vector<MeshBvhNode> right_nodes;
+		uint32_t left_depth = 0;
+		uint32_t right_depth = 0;
+		pool.parallel_for(2, 1, [&](const size_t half, const size_t last)
+		{
+			for (size_t index = half; index < last; ++index)
+			{
+				if (index == 0)
+					left_depth = build_parallel(pool, first, left_count, left_nodes);
+				else
+					right_depth = build_parallel(pool, first + left_count, count - left_count, right_nodes);
+			}
+		});
+
+		const uint32_t right_index = static_cast<uint32_t>(1 + left_nodes.size());
+		nodes.reserve(1 + left_nodes.size() + right_nodes.size());
+		nodes.push_back({ .min_bound = node_bounds.min_bound, .offset = right_index,
+			.max_bound = node_bounds.max_bound, .count = 0 });
+		const auto append = [&](const std::vector<MeshBvhNode>& children, const uint32_t base)
+		{
+			for (MeshBvhNode node : children)
+			{
+				if (!node.is_leaf())
+					node.offset += base;
+				nodes.push_back(node);
+			}
+		};
+		append(left_nodes, 1);
+		append(right_nodes, right_index);
+		return 1 + std::max(left_depth, right_depth);
+	}
+};
+
+// Horizontal reductions over the x, y and z lanes
+float min3(const __m128 value)
+{
+	const __m128 xy = _mm_min_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(_mm_min_ss(xy, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 2, 2))));
+}
+
+float max3(const __m128 value)
+{
+	const __m128 xy = _mm_max_ss(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(_mm_max_ss(xy, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 2, 2))));
 }
+
+float min4(const __m128 value)
+{
+	const __m128 half = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(_mm_min_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(2, 3, 0, 1))));
 }
 
-MeshPickData::MeshPickData(std::vector<glm::vec3> positions, const std::vector<uint32_t>& indices) :
-	positions(std::move(positions))
+struct SimdRay
 {
-	if (!this->positions.empty())
+	explicit SimdRay(const Maths::Ray& ray)
 	{
-		bounds = AABB(this->positions.front(), this->positions.front());
-		for (const auto& point : this->positions)
+		origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+		// A huge finite reciprocal keeps parallel axes free of 0 * inf NaNs while
+		// still rejecting origins outside the slab
+		float inverse[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float direction = ray.direction[axis];
+			inverse[axis] = Maths::absf(direction) <= std::numeric_limits<float>::epsilon()
+				? std::copysign(std::numeric_limits<float>::max(), direction)
+				: 1.0f / direction;
+		}
+		inverse_direction = _mm_setr_ps(inverse[0], inverse[1], inverse[2], 0.0f);
+		for (int axis = 0; axis < 3; ++axis)
 		{
-			bounds.min_bound = glm::min(bounds.min_bound, point);
-			bounds.max_bound = glm::max(bounds.max_bound, point);
+			origin_lanes[axis] = _mm_set1_ps(ray.origin[axis]);
+			direction_lanes[axis] = _mm_set1_ps(ray.direction[axis]);
 		}
-		has_local_bounds = true;
 	}
+
+	// Returns the distance at which the ray enters the node, clamped to zero, or
+	// infinity on a miss or when the node lies beyond max_t
+	float entry_distance(const MeshBvhNode& node, const float max_t) const
+	{
+		// the w lanes hold the node's offset and count, so clear them first
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 min_bound = _mm_blend_ps(_mm_loadu_ps(&node.min_bound.x), zero, 0b1000);
+		const __m128 max_bound = _mm_blend_ps(_mm_loadu_ps(&node.max_bound.x), zero, 0b1000);
+		const __m128 t0 = _mm_mul_ps(_mm_sub_ps(min_bound, origin), inverse_direction);
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(max_bound, origin), inverse_direction);
+		const float near_t = std::max(max3(_mm_min_ps(t0, t1)), 0.0f);
+		const float far_t = std::min(min3(_mm_max_ps(t0, t1)), max_t);
+		return near_t <= far_t ? near_t : std::numeric_limits<float>::infinity();
+	}
+
+	__m128 origin;
+	__m128 inverse_direction;
+	__m128 origin_lanes[3];
+	__m128 direction_lanes[3];
+};
+}
+
+MeshPickData::MeshPickData(std::vector<glm::vec3> positions, const std::vector<uint32_t>& indices, TaskPool* pool) :
+	positions(std::move(positions))
+{
+	compute_bounds();
 	for (uint32_t offset = 0; offset + 2 < indices.size(); offset += 3)
 	{
 		if (indices[offset] < this->positions.size() &&
@@ -46,55 +331,230 @@ MeshPickData::MeshPickData(std::vector<glm::vec3> positions, const std::vector<u
 		}
 	}
 
-	triangle_indices.resize(triangles.size());
-	for (uint32_t i = 0; i < triangle_indices.size(); ++i)
-		triangle_indices[i] = i;
-	if (!triangle_indices.empty())
-		build_node(0, static_cast<uint32_t>(triangle_indices.size()));
+	if (!triangles.empty())
+		build_nodes(pool);
 }
 
-AABB MeshPickData::bounds_for_range(const uint32_t first, const uint32_t count) const
+MeshPickData::MeshPickData(std::vector<glm::vec3> positions, std::vector<MeshPickTriangle> triangles,
+	std::vector<MeshBvhNode> nodes) :
+	positions(std::move(positions)),
+	triangles(std::move(triangles)),
+	nodes(std::move(nodes))
 {
-	const auto& first_triangle = triangles[triangle_indices[first]];
-	AABB bounds = triangle_bounds(positions, first_triangle.vertices);
-	for (uint32_t i = 1; i < count; ++i)
+	for (const auto& triangle : this->triangles)
+		for (const uint32_t vertex : triangle.vertices)
+			if (vertex >= this->positions.size())
+				throw std::invalid_argument("MeshPickData: triangle references a missing vertex");
+	if (this->nodes.empty() != this->triangles.empty())
+		throw std::invalid_argument("MeshPickData: nodes do not match triangles");
+
+	// Children always follow their only parent, so walking the nodes in order
+	// can neither loop nor miss the depth of any subtree
+	std::vector<uint32_t> node_depths(this->nodes.size(), 0);
+	if (!this->nodes.empty())
+		node_depths[0] = 1;
+	for (uint32_t index = 0; index < this->nodes.size(); ++index)
 	{
-		const auto& triangle = triangles[triangle_indices[first + i]];
-		const AABB triangle_aabb = triangle_bounds(positions, triangle.vertices);
-		bounds.min_bound = glm::min(bounds.min_bound, triangle_aabb.min_bound);
-		bounds.max_bound = glm::max(bounds.max_bound, triangle_aabb.max_bound);
+		const MeshBvhNode& node = this->nodes[index];
+		if (node_depths[index] == 0)
+			throw std::invalid_argument("MeshPickData: BVH node is unreachable");
+		depth = std::max(depth, node_depths[index]);
+		if (node.is_leaf())
+		{
+			if (node.offset > this->triangles.size() || node.count > this->triangles.size() - node.offset)
+				throw std::invalid_argument("MeshPickData: BVH leaf references missing triangles");
+			continue;
+		}
+		if (index + 1 >= this->nodes.size() || node.offset <= index + 1 || node.offset >= this->nodes.size()
+			|| node_depths[index + 1] != 0 || node_depths[node.offset] != 0)
+			throw std::invalid_argument("MeshPickData: BVH node references invalid children");
+		node_depths[index + 1] = node_depths[index] + 1;
+		node_depths[node.offset] = node_depths[index] + 1;
 	}
-	return bounds;
+
+	compute_bounds();
+	fill_triangle_batches();
 }
 
-uint32_t MeshPickData::build_node(const uint32_t first, const uint32_t count)
-{
-	const uint32_t node_index = static_cast<uint32_t>(nodes.size());
-	nodes.push_back({ .bounds = bounds_for_range(first, count), .first = first, .count = count });
-	if (count <= LEAF_TRIANGLE_COUNT)
-		return node_index;
-
-	const glm::vec3 extent = nodes[node_index].bounds.max_bound - nodes[node_index].bounds.min_bound;
-	const int axis = extent.y > extent.x && extent.y >= extent.z ? 1 : (extent.z > extent.x ? 2 : 0);
-	const uint32_t middle = first + count / 2;
-	std::nth_element(
-		triangle_indices.begin() + first,
-		triangle_indices.begin() + middle,
-		triangle_indices.begin() + first + count,
-		[this, axis](const uint32_t left, const uint32_t right)
+void MeshPickData::compute_bounds()
+{
+	if (positions.empty())
+		return;
+	bounds = AABB(positions.front(), positions.front());
+	for (const auto& point : positions)
+	{
+		bounds.min_bound = glm::min(bounds.min_bound, point);
+		bounds.max_bound = glm::max(bounds.max_bound, point);
+	}
+	has_local_bounds = true;
+}
+
+void MeshPickData::build_nodes(TaskPool* pool)
+{
+	const uint32_t triangle_count = static_cast<uint32_t>(triangles.size());
+	NodeBuilder builder;
+	builder.triangle_bounds.resize(triangle_count);
+	builder.centroids.resize(triangle_count);
+	builder.order.resize(triangle_count);
+	for (uint32_t i = 0; i < triangle_count; ++i)
+	{
+		const auto& vertices = triangles[i].vertices;
+		builder.triangle_bounds[i] = AABB(positions[vertices[0]], positions[vertices[0]]);
+		grow(builder.triangle_bounds[i], positions[vertices[1]]);
+		grow(builder.triangle_bounds[i], positions[vertices[2]]);
+		builder.centroids[i] = (positions[vertices[0]] + positions[vertices[1]] + positions[vertices[2]]) / 3.0f;
+		builder.order[i] = i;
+	}
+
+	nodes.clear();
+	depth = pool && triangle_count >= PARALLEL_BUILD_TRIANGLE_COUNT
+		? builder.build_parallel(*pool, 0, triangle_count, nodes)
+		: builder.build(0, triangle_count, nodes);
+
+	const auto& order = builder.order;
+	std::vector<MeshPickTriangle> ordered_triangles(triangle_count);
+	for (uint32_t i = 0; i < triangle_count; ++i)
+		ordered_triangles[i] = triangles[order[i]];
+	triangles = std::move(ordered_triangles);
+	fill_triangle_batches();
+}
+
+void MeshPickData::fill_triangle_batches()
+{
+	const uint32_t triangle_count = static_cast<uint32_t>(triangles.size());
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		triangle_origins[axis].assign(triangle_count + TRIANGLE_BATCH_SIZE - 1, 0.0f);
+		triangle_edges1[axis].assign(triangle_count + TRIANGLE_BATCH_SIZE - 1, 0.0f);
+		triangle_edges2[axis].assign(triangle_count + TRIANGLE_BATCH_SIZE - 1, 0.0f);
+	}
+	for (uint32_t i = 0; i < triangle_count; ++i)
+	{
+		const auto& vertices = triangles[i].vertices;
+		const glm::vec3 edge1 = positions[vertices[1]] - positions[vertices[0]];
+		const glm::vec3 edge2 = positions[vertices[2]] - positions[vertices[0]];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			triangle_origins[axis][i] = positions[vertices[0]][axis];
+			triangle_edges1[axis][i] = edge1[axis];
+			triangle_edges2[axis][i] = edge2[axis];
+		}
+	}
+}
+
+bool MeshPickData::raycast(const Maths::Ray& ray, float& closest_t) const
+{
+	if (nodes.empty())
+		return false;
+
+	const SimdRay simd_ray(ray);
+	const float root_entry = simd_ray.entry_distance(nodes.front(), closest_t);
+	if (root_entry == std::numeric_limits<float>::infinity())
+		return false;
+
+	// Near-first traversal never holds more entries than the tree is deep
+	std::array<std::pair<uint32_t, float>, INLINE_TRAVERSAL_DEPTH> inline_stack;
+	std::vector<std::pair<uint32_t, float>> heap_stack;
+	std::pair<uint32_t, float>* stack = inline_stack.data();
+	if (depth >= INLINE_TRAVERSAL_DEPTH)
+	{
+		heap_stack.resize(depth + 1);
+		stack = heap_stack.data();
+	}
+	uint32_t stack_size = 0;
+	stack[stack_size++] = { 0, root_entry };
+
+	const __m128 epsilon = _mm_set1_ps(Maths::ACCEPTABLE_FLOATING_PT_DIFF);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	const __m128i lane_indices = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128* origin = simd_ray.origin_lanes;
+	const __m128* direction = simd_ray.direction_lanes;
+
+	bool collided = false;
+	while (stack_size != 0)
+	{
+		const auto [node_index, entry] = stack[--stack_size];
+		if (entry > closest_t)
+			continue;
+		const MeshBvhNode& node = nodes[node_index];
+		if (!node.is_leaf())
 		{
-			const auto centroid = [this, axis](const uint32_t triangle_index)
+			const uint32_t left = node_index + 1;
+			const uint32_t right = node.offset;
+			const float left_entry = simd_ray.entry_distance(nodes[left], closest_t);
+			const float right_entry = simd_ray.entry_distance(nodes[right], closest_t);
+			// push the farther child first so that the nearer one is visited next
+			if (left_entry <= right_entry)
 			{
-				const auto& triangle = triangles[triangle_index];
-				return (positions[triangle.vertices[0]][axis] + positions[triangle.vertices[1]][axis] + positions[triangle.vertices[2]][axis]) / 3.0f;
+				if (right_entry != std::numeric_limits<float>::infinity())
+					stack[stack_size++] = { right, right_entry };
+				if (left_entry != std::numeric_limits<float>::infinity())
+					stack[stack_size++] = { left, left_entry };
+			}
+			else
+			{
+				if (left_entry != std::numeric_limits<float>::infinity())
+					stack[stack_size++] = { left, left_entry };
+				stack[stack_size++] = { right, right_entry };
+			}
+			continue;
+		}
+
+		// Moller-Trumbore against four triangles at a time
+		for (uint32_t batch = 0; batch < node.count; batch += TRIANGLE_BATCH_SIZE)
+		{
+			const uint32_t first = node.offset + batch;
+			const __m128 valid = _mm_castsi128_ps(
+				_mm_cmpgt_epi32(_mm_set1_epi32(static_cast<int>(node.count - batch)), lane_indices));
+			__m128 v0[3], e1[3], e2[3];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				v0[axis] = _mm_loadu_ps(triangle_origins[axis].data() + first);
+				e1[axis] = _mm_loadu_ps(triangle_edges1[axis].data() + first);
+				e2[axis] = _mm_loadu_ps(triangle_edges2[axis].data() + first);
+			}
+
+			const __m128 p[3] = {
+				_mm_sub_ps(_mm_mul_ps(direction[1], e2[2]), _mm_mul_ps(direction[2], e2[1])),
+				_mm_sub_ps(_mm_mul_ps(direction[2], e2[0]), _mm_mul_ps(direction[0], e2[2])),
+				_mm_sub_ps(_mm_mul_ps(direction[0], e2[1]), _mm_mul_ps(direction[1], e2[0])),
 			};
-			return centroid(left) < centroid(right);
-		});
+			const __m128 determinant = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(e1[0], p[0]), _mm_mul_ps(e1[1], p[1])), _mm_mul_ps(e1[2], p[2]));
+			const __m128 inverse_determinant = _mm_div_ps(one, determinant);
+			const __m128 s[3] = {
+				_mm_sub_ps(origin[0], v0[0]),
+				_mm_sub_ps(origin[1], v0[1]),
+				_mm_sub_ps(origin[2], v0[2]),
+			};
+			const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(s[0], p[0]), _mm_mul_ps(s[1], p[1])), _mm_mul_ps(s[2], p[2])), inverse_determinant);
+			const __m128 q[3] = {
+				_mm_sub_ps(_mm_mul_ps(s[1], e1[2]), _mm_mul_ps(s[2], e1[1])),
+				_mm_sub_ps(_mm_mul_ps(s[2], e1[0]), _mm_mul_ps(s[0], e1[2])),
+				_mm_sub_ps(_mm_mul_ps(s[0], e1[1]), _mm_mul_ps(s[1], e1[0])),
+			};
+			const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(direction[0], q[0]), _mm_mul_ps(direction[1], q[1])), _mm_mul_ps(direction[2], q[2])),
+				inverse_determinant);
+			const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(e2[0], q[0]), _mm_mul_ps(e2[1], q[1])), _mm_mul_ps(e2[2], q[2])), inverse_determinant);
 
-	const uint32_t left_child = build_node(first, middle - first);
-	const uint32_t right_child = build_node(middle, first + count - middle);
-	nodes[node_index].first = left_child;
-	nodes[node_index].second = right_child;
-	nodes[node_index].count = 0;
-	return node_index;
+			__m128 hit = _mm_and_ps(valid, _mm_cmpgt_ps(_mm_andnot_ps(sign_mask, determinant), epsilon));
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+			hit = _mm_and_ps(hit, _mm_cmple_ps(u, one));
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+			hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+			hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_set1_ps(closest_t)));
+			if (_mm_movemask_ps(hit) == 0)
+				continue;
+			closest_t = min4(_mm_blendv_ps(infinity, t, hit));
+			collided = true;
+		}
+	}
+	return collided;
 }
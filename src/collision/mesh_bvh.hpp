@@ -1,21 +1,29 @@
 #pragma once
 
 #include "collision/bounding_box.hpp"
+#include "maths.hpp"
 
 #include <glm/vec3.hpp>
 
 #include <cstdint>
 #include <vector>
 
+class TaskPool;
+
+// Nodes are stored depth-first. An interior node's left child immediately
+// follows it and `offset` holds its right child; a leaf's `offset` is the first
+// triangle of its contiguous range.
 struct MeshBvhNode
 {
-	AABB bounds;
-	uint32_t first = 0;
-	uint32_t second = 0;
+	glm::vec3 min_bound;
+	uint32_t offset = 0;
+	glm::vec3 max_bound;
 	uint32_t count = 0;
 
 	bool is_leaf() const { return count != 0; }
+	AABB get_bounds() const { return AABB(min_bound, max_bound); }
 };
+static_assert(sizeof(MeshBvhNode) == 32);
 
 struct MeshPickTriangle
 {
@@ -27,24 +35,43 @@ class MeshPickData
 {
 public:
 	MeshPickData() = default;
-	MeshPickData(std::vector<glm::vec3> positions, const std::vector<uint32_t>& indices);
+	// Large meshes split their BVH build across the pool when one is given
+	MeshPickData(std::vector<glm::vec3> positions, const std::vector<uint32_t>& indices, TaskPool* pool = nullptr);
+	// Restores data built earlier, e.g. from the derived-data cache, without
+	// rebuilding the BVH. Throws std::invalid_argument unless the triangles and
+	// nodes form a valid tree over positions.
+	MeshPickData(std::vector<glm::vec3> positions, std::vector<MeshPickTriangle> triangles,
+		std::vector<MeshBvhNode> nodes);
 
 	bool has_bounds() const { return has_local_bounds; }
 	bool has_triangles() const { return !triangles.empty(); }
 	const AABB& get_bounds() const { return bounds; }
 	const std::vector<glm::vec3>& get_positions() const { return positions; }
+	// Triangles are ordered so that every leaf references a contiguous range
 	const std::vector<MeshPickTriangle>& get_triangles() const { return triangles; }
-	const std::vector<uint32_t>& get_triangle_indices() const { return triangle_indices; }
 	const std::vector<MeshBvhNode>& get_nodes() const { return nodes; }
 
+	// Finds the nearest triangle hit by the ray, in units of the ray's
+	// direction. Returns true and updates closest_t only when a hit is nearer
+	// than its incoming value.
+	bool raycast(const Maths::Ray& ray, float& closest_t) const;
+
 private:
-	uint32_t build_node(uint32_t first, uint32_t count);
-	AABB bounds_for_range(uint32_t first, uint32_t count) const;
+	void compute_bounds();
+	void build_nodes(TaskPool* pool);
+	void fill_triangle_batches();
 
 	std::vector<glm::vec3> positions;
 	AABB bounds;
 	bool has_local_bounds = false;
 	std::vector<MeshPickTriangle> triangles;
-	std::vector<uint32_t> triangle_indices;
 	std::vector<MeshBvhNode> nodes;
+	uint32_t depth = 0;
+
+	// Triangle origins and edges in structure-of-arrays order for the four-wide
+	// intersection kernel. Each array is padded by three lanes so that a leaf's
+	// final batch can always be loaded whole.
+	std::vector<float> triangle_origins[3];
+	std::vector<float> triangle_edges1[3];
+	std::vector<float> triangle_edges2[3];
 };
@@ -55,3 +55,9 @@ bool Config::is_raytracing_enabled()
 	assert(!config_node.IsNull());
 	return config_node["raytracing"].as<bool>(true);
 }
+
+bool Config::is_derived_data_cache_enabled()
+{
+	assert(!config_node.IsNull());
+	return config_node["derived_data_cache"].as<bool>(false);
+}
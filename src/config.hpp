@@ -11,4 +11,5 @@ public:
 	static bool enable_logging();
 	static std::pair<int, int> get_window_pos();
 	static bool is_raytracing_enabled();
+	static bool is_derived_data_cache_enabled();
 };
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include "animation_clip.hpp"
+#include "skeletal.hpp"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace
+{
+constexpr float QUANTIZED_ROTATION_SCALE = 32767.0f;
+
+size_t padded_size(const size_t count)
+{
+	return (count + AnimationPose::BATCH_SIZE - 1) / AnimationPose::BATCH_SIZE * AnimationPose::BATCH_SIZE;
+}
+
+int16_t quantize_rotation_component(const float value)
+{
+	return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * QUANTIZED_ROTATION_SCALE));
+}
+
+// Interpolates each bone from towards to, with weights(channel, first_bone)
+// giving the translation, rotation and scale weights of a batch
+template<typename Weights>
+void interpolate_poses(const AnimationPose& from, const AnimationPose& to, Weights weights, AnimationPose& out)
+{
+	const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+	const size_t count = padded_size(out.size());
+	for (size_t first = 0; first < count; first += AnimationPose::BATCH_SIZE)
+	{
+		const __m256 translation_weight = weights(0, first);
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const __m256 a = _mm256_loadu_ps(from.translations[axis].data() + first);
+			const __m256 b = _mm256_loadu_ps(to.translations[axis].data() + first);
+			_mm256_storeu_ps(out.translations[axis].data() + first,
+				_mm256_fmadd_ps(translation_weight, _mm256_sub_ps(b, a), a));
+		}
+
+		const __m256 scale_weight = weights(2, first);
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const __m256 a = _mm256_loadu_ps(from.scales[axis].data() + first);
+			const __m256 b = _mm256_loadu_ps(to.scales[axis].data() + first);
+			_mm256_storeu_ps(out.scales[axis].data() + first,
+				_mm256_fmadd_ps(scale_weight, _mm256_sub_ps(b, a), a));
+		}
+
+		const __m256 rotation_weight = weights(1, first);
+		__m256 a[4];
+		__m256 b[4];
+		__m256 dot = _mm256_setzero_ps();
+		for (int component = 0; component < 4; ++component)
+		{
+			a[component] = _mm256_loadu_ps(from.rotations[component].data() + first);
+			b[component] = _mm256_loadu_ps(to.rotations[component].data() + first);
+			dot = _mm256_fmadd_ps(a[component], b[component], dot);
+		}
+		// q and -q are the same rotation; blend towards whichever is nearer
+		const __m256 flip = _mm256_and_ps(dot, sign_mask);
+		__m256 blended[4];
+		__m256 length_squared = _mm256_setzero_ps();
+		for (int component = 0; component < 4; ++component)
+		{
+			const __m256 target = _mm256_xor_ps(b[component], flip);
+			blended[component] = _mm256_fmadd_ps(rotation_weight, _mm256_sub_ps(target, a[component]), a[component]);
+			length_squared = _mm256_fmadd_ps(blended[component], blended[component], length_squared);
+		}
+		const __m256 length = _mm256_sqrt_ps(length_squared);
+		for (int component = 0; component < 4; ++component)
+			_mm256_storeu_ps(out.rotations[component].data() + first, _mm256_div_ps(blended[component], length));
+	}
+}
+}
+
+
+void AnimationPose::resize(const size_t new_bone_count)
+{
+	bone_count = new_bone_count;
+	const size_t count = padded_size(bone_count);
+	for (auto& component : translations)
+		component.resize(count);
+	for (auto& component : rotations)
+		component.resize(count);
+	for (auto& component : scales)
+		component.resize(count);
+	// identity padding keeps the final batch's rotations normalizable
+	for (size_t bone = bone_count; bone < count; ++bone)
+		set(bone, glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+}
+
+glm::vec3 AnimationPose::get_translation(const size_t bone) const
+{
+	return { translations[0][bone], translations[1][bone], translations[2][bone] };
+}
+
+glm::quat AnimationPose::get_rotation(const size_t bone) const
+{
+	return { rotations[3][bone], rotations[0][bone], rotations[1][bone], rotations[2][bone] };
+}
+
+glm::vec3 AnimationPose::get_scale(const size_t bone) const
+{
+	return { scales[0][bone], scales[1][bone], scales[2][bone] };
+}
+
+void AnimationPose::set(
+	const size_t bone,
+	const glm::vec3& translation,
+	const glm::quat& rotation,
+	const glm::vec3& scale)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		translations[axis][bone] = translation[axis];
+		scales[axis][bone] = scale[axis];
+	}
+	rotations[0][bone] = rotation.x;
+	rotations[1][bone] = rotation.y;
+	rotations[2][bone] = rotation.z;
+	rotations[3][bone] = rotation.w;
+}
+
+void blend_poses(const AnimationPose& from, const AnimationPose& to, const float weight, AnimationPose& out)
+{
+	if (from.size() != to.size())
+		throw std::invalid_argument("blend_poses: poses have different bone counts");
+	out.resize(from.size());
+	const __m256 weights = _mm256_set1_ps(weight);
+	interpolate_poses(from, to, [weights](int, size_t) { return weights; }, out);
+}
+
+
+CompiledAnimationClip::CompiledAnimationClip(const std::vector<BoneAnimation>& bone_animations)
+{
+	bones.resize(bone_animations.size());
+	base_pose.resize(bone_animations.size());
+
+	const auto add_vector_track = [this](const Channel channel, const BoneAnimation::Track<glm::vec3>& source, Track& track)
+	{
+		const size_t value_index = channel == TRANSLATION ? 0 : 1;
+		track.first_key = static_cast<uint32_t>(key_times[channel].size());
+		track.key_count = static_cast<uint32_t>(source.keys.size());
+		track.interpolation = static_cast<uint8_t>(source.interpolation);
+		const bool cubic = source.interpolation == BoneAnimation::Interpolation::CUBIC_SPLINE;
+		if (cubic)
+			track.first_tangent = static_cast<uint32_t>(in_tangents[value_index][0].size());
+		for (const auto& key : source.keys)
+		{
+			key_times[channel].push_back(key.animation_stage_secs);
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				vector_values[value_index][axis].push_back(key.value[axis]);
+				if (!cubic)
+					continue;
+				in_tangents[value_index][axis].push_back(key.in_tangent[axis]);
+				out_tangents[value_index][axis].push_back(key.out_tangent[axis]);
+			}
+		}
+	};
+
+	for (size_t bone = 0; bone < bone_animations.size(); ++bone)
+	{
+		const BoneAnimation& source = bone_animations[bone];
+		CompiledBone& compiled = bones[bone];
+		compiled.end_secs = source.animation_end_secs;
+		compiled.animated = !source.translation_track.keys.empty()
+			|| !source.rotation_track.keys.empty()
+			|| !source.scale_track.keys.empty();
+		base_pose.set(bone,
+			source.base_transform.get_pos(),
+			source.base_transform.get_orient(),
+			source.base_transform.get_scale());
+
+		add_vector_track(TRANSLATION, source.translation_track, compiled.tracks[TRANSLATION]);
+		add_vector_track(SCALE, source.scale_track, compiled.tracks[SCALE]);
+
+		Track& rotation = compiled.tracks[ROTATION];
+		rotation.first_key = static_cast<uint32_t>(key_times[ROTATION].size());
+		rotation.key_count = static_cast<uint32_t>(source.rotation_track.keys.size());
+		rotation.interpolation = static_cast<uint8_t>(source.rotation_track.interpolation);
+		for (const auto& key : source.rotation_track.keys)
+		{
+			key_times[ROTATION].push_back(key.animation_stage_secs);
+			const glm::quat value = glm::normalize(glm::quat(key.value.w, key.value.x, key.value.y, key.value.z));
+			rotation_values[0].push_back(quantize_rotation_component(value.x));
+			rotation_values[1].push_back(quantize_rotation_component(value.y));
+			rotation_values[2].push_back(quantize_rotation_component(value.z));
+			rotation_values[3].push_back(quantize_rotation_component(value.w));
+		}
+	}
+}
+
+uint32_t CompiledAnimationClip::find_segment(
+	const std::vector<float>& times,
+	const Track& track,
+	const float animation_stage_secs,
+	uint32_t& cached_key)
+{
+	// Callers have already clamped animation_stage_secs to lie strictly
+	// between the first and last keys
+	const float* track_times = times.data() + track.first_key;
+	uint32_t key = cached_key;
+	if (key + 1 >= track.key_count || track_times[key] > animation_stage_secs)
+	{
+		const float* second = std::upper_bound(track_times, track_times + track.key_count, animation_stage_secs);
+		key = static_cast<uint32_t>(second - track_times) - 1;
+	}
+	else
+	{
+		while (track_times[key + 1] <= animation_stage_secs)
+			++key;
+	}
+	cached_key = key;
+	return track.first_key + key;
+}
+
+void CompiledAnimationClip::sample_vector_track(
+	const Channel channel,
+	const size_t bone,
+	const float animation_stage_secs,
+	AnimationCursor& cursor,
+	AnimationPose& out) const
+{
+	const Track& track = bones[bone].tracks[channel];
+	const std::vector<float>& times = key_times[channel];
+	const size_t value_index = channel == TRANSLATION ? 0 : 1;
+	const auto& values = vector_values[value_index];
+	auto& from = channel == TRANSLATION ? out.translations : out.scales;
+	auto& to = channel == TRANSLATION ? cursor.segment_ends.translations : cursor.segment_ends.scales;
+	const auto hold = [&](const uint32_t key)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+			from[axis][bone] = to[axis][bone] = values[axis][key];
+		cursor.weights[channel][bone] = 0.0f;
+	};
+
+	const uint32_t last_key = track.first_key + track.key_count - 1;
+	if (track.key_count == 1 || animation_stage_secs <= times[track.first_key])
+		return hold(track.first_key);
+	if (animation_stage_secs >= times[last_key])
+		return hold(last_key);
+
+	const uint32_t key = find_segment(times, track, animation_stage_secs, cursor.keys[bone * CHANNEL_COUNT + channel]);
+	const auto interpolation = static_cast<BoneAnimation::Interpolation>(track.interpolation);
+	if (interpolation == BoneAnimation::Interpolation::STEP)
+		return hold(key);
+
+	const float duration = times[key + 1] - times[key];
+	const float t = (animation_stage_secs - times[key]) / duration;
+	if (interpolation == BoneAnimation::Interpolation::CUBIC_SPLINE)
+	{
+		const uint32_t tangent = track.first_tangent + (key - track.first_key);
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		for (int axis = 0; axis < 3; ++axis)
+			from[axis][bone] = to[axis][bone] = (2.0f * t3 - 3.0f * t2 + 1.0f) * values[axis][key]
+				+ (t3 - 2.0f * t2 + t) * duration * out_tangents[value_index][axis][tangent]
+				+ (-2.0f * t3 + 3.0f * t2) * values[axis][key + 1]
+				+ (t3 - t2) * duration * in_tangents[value_index][axis][tangent + 1];
+		cursor.weights[channel][bone] = 0.0f;
+		return;
+	}
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		from[axis][bone] = values[axis][key];
+		to[axis][bone] = values[axis][key + 1];
+	}
+	cursor.weights[channel][bone] = t;
+}
+
+void CompiledAnimationClip::sample_rotation_track(
+	const size_t bone,
+	const float animation_stage_secs,
+	AnimationCursor& cursor,
+	AnimationPose& out) const
+{
+	const Track& track = bones[bone].tracks[ROTATION];
+	const std::vector<float>& times = key_times[ROTATION];
+	const auto write = [&](const uint32_t from_key, const uint32_t to_key, const float weight)
+	{
+		for (int component = 0; component < 4; ++component)
+		{
+			out.rotations[component][bone] = rotation_values[component][from_key] / QUANTIZED_ROTATION_SCALE;
+			cursor.segment_ends.rotations[component][bone] = rotation_values[component][to_key] / QUANTIZED_ROTATION_SCALE;
+		}
+		cursor.weights[ROTATION][bone] = weight;
+	};
+
+	const uint32_t last_key = track.first_key + track.key_count - 1;
+	if (track.key_count == 1 || animation_stage_secs <= times[track.first_key])
+		return write(track.first_key, track.first_key, 0.0f);
+	if (animation_stage_secs >= times[last_key])
+		return write(last_key, last_key, 0.0f);
+
+	const uint32_t key = find_segment(times, track, animation_stage_secs, cursor.keys[bone * CHANNEL_COUNT + ROTATION]);
+	if (static_cast<BoneAnimation::Interpolation>(track.interpolation) == BoneAnimation::Interpolation::STEP)
+		return write(key, key, 0.0f);
+	// Cubic rotation tracks are interpolated linearly, as in BoneAnimation
+	write(key, key + 1, (animation_stage_secs - times[key]) / (times[key + 1] - times[key]));
+}
+
+void CompiledAnimationClip::sample(
+	const float animation_stage_secs,
+	AnimationCursor& cursor,
+	const AnimationPose& rest_pose,
+	AnimationPose& out,
+	const std::span<const uint8_t> bone_mask) const
+{
+	if (rest_pose.size() != bones.size())
+		throw std::invalid_argument("CompiledAnimationClip::sample: rest pose does not match the clip");
+	if (!bone_mask.empty() && bone_mask.size() != bones.size())
+		throw std::invalid_argument("CompiledAnimationClip::sample: bone mask does not match the clip");
+	out.resize(bones.size());
+	cursor.segment_ends.resize(bones.size());
+	cursor.keys.resize(bones.size() * CHANNEL_COUNT);
+	for (auto& weights : cursor.weights)
+		weights.assign(padded_size(bones.size()), 0.0f);
+
+	// Find each track's keys, leaving the pose at the earlier key in out and
+	// the later one in the cursor, then interpolate every bone at once
+	for (size_t bone = 0; bone < bones.size(); ++bone)
+	{
+		const CompiledBone& compiled = bones[bone];
+		const bool active = compiled.animated && animation_stage_secs <= compiled.end_secs
+			&& (bone_mask.empty() || bone_mask[bone] != 0);
+		const AnimationPose& source = active ? base_pose : rest_pose;
+		const glm::vec3 translation = source.get_translation(bone);
+		const glm::quat rotation = source.get_rotation(bone);
+		const glm::vec3 scale = source.get_scale(bone);
+		out.set(bone, translation, rotation, scale);
+		cursor.segment_ends.set(bone, translation, rotation, scale);
+		if (!active)
+			continue;
+
+		if (compiled.tracks[TRANSLATION].key_count != 0)
+			sample_vector_track(TRANSLATION, bone, animation_stage_secs, cursor, out);
+		if (compiled.tracks[ROTATION].key_count != 0)
+			sample_rotation_track(bone, animation_stage_secs, cursor, out);
+		if (compiled.tracks[SCALE].key_count != 0)
+			sample_vector_track(SCALE, bone, animation_stage_secs, cursor, out);
+	}
+
+	interpolate_poses(out, cursor.segment_ends,
+		[&cursor](const int channel, const size_t first) { return _mm256_loadu_ps(cursor.weights[channel].data() + first); },
+		out);
+}
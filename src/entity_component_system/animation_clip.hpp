@@ -0,0 +1,123 @@
+#pragma once
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+struct BoneAnimation;
+
+// A skeleton's local bone transforms stored component by component, padded to
+// whole batches of eight bones so that poses are interpolated and blended
+// eight bones at a time.
+class AnimationPose
+{
+public:
+	static constexpr size_t BATCH_SIZE = 8;
+
+	// Keeps the capacity, so resizing to a size used before does not allocate
+	void resize(size_t bone_count);
+	size_t size() const { return bone_count; }
+
+	glm::vec3 get_translation(size_t bone) const;
+	glm::quat get_rotation(size_t bone) const;
+	glm::vec3 get_scale(size_t bone) const;
+	void set(size_t bone, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+	// x, y and z of each bone's translation
+	std::array<std::vector<float>, 3> translations;
+	// x, y, z and w of each bone's rotation
+	std::array<std::vector<float>, 4> rotations;
+	// x, y and z of each bone's scale
+	std::array<std::vector<float>, 3> scales;
+
+private:
+	size_t bone_count = 0;
+};
+
+// Blends from towards to by weight, taking the shorter way round for
+// rotations, which are normalized linear blends rather than slerps. out may
+// be either input.
+void blend_poses(const AnimationPose& from, const AnimationPose& to, float weight, AnimationPose& out);
+
+// Per-playback sampling state for one clip: the key each track was last
+// sampled at, so that sampling forward in time steps to the next keys instead
+// of searching for them, and the scratch the samples are interpolated from.
+struct AnimationCursor
+{
+	std::vector<uint32_t> keys;
+	AnimationPose segment_ends;
+	std::array<std::vector<float>, 3> weights;
+};
+
+// A skeletal animation compiled for sampling. Each bone's translation,
+// rotation and scale keys are stored track after track in bone order, with
+// key times and each value component in separate arrays. Rotations are
+// normalized and quantized to 16 bits per component; the other values and
+// every key time are kept exactly.
+class CompiledAnimationClip
+{
+public:
+	CompiledAnimationClip() = default;
+	explicit CompiledAnimationClip(const std::vector<BoneAnimation>& bone_animations);
+
+	size_t get_bone_count() const { return bones.size(); }
+
+	// Writes the pose at animation_stage_secs to out, following
+	// BoneAnimation::get_transform. Bones it returns false for take their
+	// transform from rest_pose, as do bones whose bone_mask entry is zero when
+	// a mask is given. Does not allocate once cursor and out have been used
+	// with this clip before.
+	void sample(float animation_stage_secs, AnimationCursor& cursor,
+		const AnimationPose& rest_pose, AnimationPose& out,
+		std::span<const uint8_t> bone_mask = {}) const;
+
+private:
+	enum Channel
+	{
+		TRANSLATION,
+		ROTATION,
+		SCALE,
+		CHANNEL_COUNT,
+	};
+
+	struct Track
+	{
+		uint32_t first_key = 0;
+		uint32_t key_count = 0;
+		// Into the tangent arrays, for cubic spline tracks only
+		uint32_t first_tangent = 0;
+		uint8_t interpolation = 0;
+	};
+
+	struct CompiledBone
+	{
+		float end_secs = 0.0f;
+		bool animated = false;
+		std::array<Track, CHANNEL_COUNT> tracks;
+	};
+
+	// Finds the key before animation_stage_secs, starting from the cached one
+	static uint32_t find_segment(const std::vector<float>& times, const Track& track,
+		float animation_stage_secs, uint32_t& cached_key);
+	void sample_vector_track(Channel channel, size_t bone, float animation_stage_secs,
+		AnimationCursor& cursor, AnimationPose& out) const;
+	void sample_rotation_track(size_t bone, float animation_stage_secs,
+		AnimationCursor& cursor, AnimationPose& out) const;
+
+	std::vector<CompiledBone> bones;
+	// The base transform of each bone, for channels without a track
+	AnimationPose base_pose;
+
+	std::array<std::vector<float>, CHANNEL_COUNT> key_times;
+	// Components of translation and scale keys, indexed by channel
+	std::array<std::array<std::vector<float>, 3>, 2> vector_values;
+	std::array<std::array<std::vector<float>, 3>, 2> in_tangents;
+	std::array<std::array<std::vector<float>, 3>, 2> out_tangents;
+	// Quantized x, y, z and w of each rotation key
+	std::array<std::vector<int16_t>, 4> rotation_values;
+};
@@ -8,6 +8,7 @@
 
 #include <quill/LogMacros.h>
 
+#include <cmath>
 #include <limits>
 #include <algorithm>
 #include <vector>
@@ -40,7 +41,11 @@ void ColliderSystem::add_collider(EntityID id, std::unique_ptr<Collider>&& colli
 	new_component.persistence = persistence;
 	new_component.collider->apply_transform(offset);
 
-	components.emplace(id, std::move(new_component));
+	if (components.emplace(id, std::move(new_component)).second
+		&& persistence == ColliderPersistence::Persistent)
+	{
+		dirty_colliders.insert(id);
+	}
 }
 
 void ColliderSystem::add_mesh_collider(const EntityID id, const ColliderPersistence persistence)
@@ -49,7 +54,11 @@ void ColliderSystem::add_mesh_collider(const EntityID id, const ColliderPersiste
 	bool has_triangles = false;
 	bool has_bounds = false;
 	AABB combined_bounds;
-	for (const auto renderable_id : get_ecs().get_renderable_ids(id))
+	const auto renderable_ids = get_ecs().get_renderable_ids(id);
+	// build the pick data of every mesh concurrently before inspecting it
+	for (const auto renderable_id : renderable_ids)
+		get_ecs().get_renderable(renderable_id).renderable.mesh_owner->get().prefetch_pick_data();
+	for (const auto renderable_id : renderable_ids)
 	{
 		const auto& renderable = get_ecs().get_renderable(renderable_id).renderable;
 		const auto& pick_data = renderable.mesh_owner->get().get_pick_data();
@@ -74,6 +83,52 @@ void ColliderSystem::add_mesh_collider(const EntityID id, const ColliderPersiste
 		LOG_WARNING(Utility::get_logger(), "ColliderSystem: Entity {} has no pickable mesh geometry", id.get_underlying());
 }
 
+void ColliderSystem::erase_collider(const EntityID id)
+{
+	if (components.erase(id) == 0)
+		return;
+	if (const auto leaf = bvh_leaves.find(id); leaf != bvh_leaves.end())
+	{
+		bvh.remove(leaf->second);
+		bvh_leaves.erase(leaf);
+	}
+	unbounded_colliders.erase(id);
+	dirty_colliders.erase(id);
+}
+
+void ColliderSystem::invalidate_collider_bounds(const EntityID id)
+{
+	const auto it = components.find(id);
+	if (it != components.end() && it->second.persistence == ColliderPersistence::Persistent)
+		dirty_colliders.insert(id);
+}
+
+void ColliderSystem::refresh_collider_bounds() const
+{
+	for (const EntityID id : dirty_colliders)
+	{
+		const std::optional<AABB> bounds = get_collider(id)->get_bounds();
+		const auto leaf = bvh_leaves.find(id);
+		if (!bounds)
+		{
+			if (leaf != bvh_leaves.end())
+			{
+				bvh.remove(leaf->second);
+				bvh_leaves.erase(leaf);
+			}
+			unbounded_colliders.insert(id);
+			continue;
+		}
+
+		unbounded_colliders.erase(id);
+		if (leaf != bvh_leaves.end())
+			bvh.update(leaf->second, *bounds);
+		else
+			bvh_leaves.emplace(id, bvh.insert(id, *bounds));
+	}
+	dirty_colliders.clear();
+}
+
 const Collider* ColliderSystem::get_collider(EntityID id) const
 {
 	auto it = components.find(id);
@@ -228,30 +283,50 @@ void ColliderSystem::deserialize(const Deserializer& in, SceneResourceReader& re
 		restored.emplace(id, std::move(component));
 	}
 	components = std::move(restored);
+
+	bvh.clear();
+	bvh_leaves.clear();
+	unbounded_colliders.clear();
+	dirty_colliders.clear();
+	for (const auto& [id, component] : components)
+		if (component.persistence == ColliderPersistence::Persistent)
+			dirty_colliders.insert(id);
 }
 
 DetectedEntityCollision ColliderSystem::raycast(const Maths::Ray& ray, const std::optional<EntityID> ignored) const
 {
+	refresh_collider_bounds();
+
 	DetectedEntityCollision result;
 	float closest_distance = std::numeric_limits<float>::infinity();
 	RayCollider ray_collider(ray);
-	for (const auto& [id, component] : components)
+	const auto test_collider = [&](const EntityID id)
 	{
-		if (component.persistence == ColliderPersistence::Transient)
-			continue;
 		if (ignored && id == *ignored)
-			continue;
+			return;
 		const Collider* collider = get_collider(id);
 		const CollisionResult hit = CollisionDetector::check_collision(&ray_collider, collider);
 		if (!hit.bCollided)
-			continue;
+			return;
 		const float distance = glm::distance2(ray.origin, hit.intersection);
 		if (distance < closest_distance)
 		{
 			closest_distance = distance;
 			result = { true, id, hit.intersection };
 		}
-	}
+	};
+
+	for (const EntityID id : unbounded_colliders)
+		test_collider(id);
+
+	// BVH distances are measured in multiples of the unnormalised ray direction
+	const float direction_length2 = glm::length2(ray.direction);
+	bvh.raycast(ray, std::numeric_limits<float>::infinity(),
+		[&](const EntityID id, const float max_t)
+		{
+			test_collider(id);
+			return std::min(max_t, std::sqrt(closest_distance / direction_length2));
+		});
 	return result;
 }
 
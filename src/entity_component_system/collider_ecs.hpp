@@ -2,10 +2,12 @@
 
 #include "identifications.hpp"
 #include "collision/collider.hpp"
+#include "collision/collider_bvh.hpp"
 #include "maths.hpp"
 #include "common.hpp"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <optional>
 #include <span>
@@ -36,21 +38,36 @@ public:
 	void add_collider(EntityID id, std::unique_ptr<Collider>&& collider,
 		const Maths::Transform& offset, ColliderPersistence persistence);
 	void add_mesh_collider(EntityID id, ColliderPersistence persistence = ColliderPersistence::Persistent);
-	void remove_collider(EntityID id) { components.erase(id); }
+	void remove_collider(EntityID id) { erase_collider(id); }
 	bool has_collider(EntityID id) const { return components.contains(id); }
 
 	const Collider* get_collider(EntityID id) const;
 	// Returns the nearest registered collider hit by the ray. The optional entity
 	// filter is used by character controllers so they do not hit themselves.
+	// Persistent colliders are found through a world-space BVH that is refreshed
+	// lazily for colliders whose transforms changed since the previous query.
 	DetectedEntityCollision raycast(const Maths::Ray& ray, std::optional<EntityID> ignored = std::nullopt) const;
+	// Tests every candidate individually, without consulting the BVH
 	DetectedEntityCollision raycast(const Maths::Ray& ray, std::span<const EntityID> candidates) const;
 	const std::unordered_map<EntityID, ColliderComponent>& get_all_colliders() const { return components; }
 	void serialize(Serializer& out, SceneResourceWriter& resources) const;
 	void deserialize(const Deserializer& in, SceneResourceReader& resources);
 
 protected:
-	void remove_entity(EntityID id) { components.erase(id); }
+	void remove_entity(EntityID id) { erase_collider(id); }
+	// Called whenever the world transform of an entity may have changed
+	void invalidate_collider_bounds(EntityID id);
 
 private:
+	void erase_collider(EntityID id);
+	void refresh_collider_bounds() const;
+
 	std::unordered_map<EntityID, ColliderComponent> components;
+
+	// Broad phase over persistent colliders. Entries are refreshed on the next
+	// raycast, so repeated transform edits between queries cost one update.
+	mutable ColliderBvh bvh;
+	mutable std::unordered_map<EntityID, uint32_t> bvh_leaves;
+	mutable std::unordered_set<EntityID> unbounded_colliders;
+	mutable std::unordered_set<EntityID> dirty_colliders;
 };
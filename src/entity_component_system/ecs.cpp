@@ -91,6 +91,12 @@ void ECS::reset_preserving_transient_transformations()
 	restore_renderables(std::move(renderables));
 }
 
+void ECS::on_world_transform_changed(const EntityID id)
+{
+	ColliderSystem::invalidate_collider_bounds(id);
+	RenderableSystem::on_entity_transform_changed(id);
+}
+
 Object& ECS::get_object(const ObjectID id)
 {
 	assert(objects.find(id) != objects.end());
@@ -70,6 +70,9 @@ public:
 	void serialize(Serializer& out, SceneResourceWriter& resources) const;
 	void deserialize(const Deserializer& in, SceneResourceReader& resources);
 
+protected:
+	virtual void on_world_transform_changed(EntityID id) override;
+
 private:
 	MeshSystem mesh_system;
 	MaterialSystem material_system;
@@ -1,20 +1,40 @@
 #include "particle_system.hpp"
 #include "ecs.hpp"
 #include "maths.hpp"
+#include "task_pool.hpp"
+
+#include <immintrin.h>
 
 #include <algorithm>
-#include <random>
+#include <bit>
+
 
+namespace
+{
+// Fewer particles than this are processed on the calling thread
+constexpr size_t MIN_PARTICLES_PER_TASK = 4096;
+}
 
-ParticleSystem::Emitter::Emitter(const ParticleEmitterConfig& config, ECS& ecs, const EntityID parent_id) :
+ParticleEmitter::ParticleEmitter(const ParticleEmitterConfig& config, uint64_t seed) :
 	config(config),
-	ecs(ecs),
-	parent_id(parent_id)
+	random(seed)
 {
-	particles.reserve(config.max_particles);
+	const uint32_t capacity = (config.max_particles + BATCH_SIZE - 1) / BATCH_SIZE * BATCH_SIZE;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		positions[axis].resize(capacity, 0.0f);
+		velocities[axis].resize(capacity, 0.0f);
+	}
+	for (auto& channel : colors)
+		channel.resize(capacity, 0.0f);
+	sizes.resize(capacity, 0.0f);
+	rotations.resize(capacity, 0.0f);
+	rotation_speeds.resize(capacity, 0.0f);
+	lifetimes.resize(capacity, 0.0f);
+	dead_indices.reserve(config.max_particles);
 }
 
-void ParticleSystem::Emitter::process(float delta_time)
+void ParticleEmitter::process(float delta_time, const glm::vec3& spawn_position)
 {
 	if (enabled)
 	{
@@ -23,87 +43,216 @@ void ParticleSystem::Emitter::process(float delta_time)
 		uint32_t emit_count = static_cast<uint32_t>(emission_accumulator);
 		if (emit_count > 0)
 		{
-			emit(emit_count);
+			emit(emit_count, spawn_position);
 			emission_accumulator -= emit_count;
 		}
 	}
 
-	// Update existing particles
-	for (auto& particle : particles)
+	integrate(delta_time);
+	remove_dead();
+}
+
+void ParticleEmitter::emit(uint32_t emit_count, const glm::vec3& spawn_position)
+{
+	for (uint32_t i = 0; i < emit_count && count < config.max_particles; ++i, ++count)
 	{
-		particle.position += particle.velocity * delta_time;
-		particle.rotation += particle.rotation_speed * delta_time;
-		particle.lifetime -= delta_time;
-		
-		// Interpolate color based on lifetime
-		float t = particle.lifetime / config.max_lifetime;
-		particle.color = Maths::lerp(config.start_color, config.end_color, t);
+		const glm::vec3 velocity = random.uniform(config.velocity_min, config.velocity_max);
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			positions[axis][count] = spawn_position[axis];
+			velocities[axis][count] = velocity[axis];
+		}
+		for (int channel = 0; channel < 4; ++channel)
+			colors[channel][count] = config.start_color[channel];
+		sizes[count] = random.uniform(config.min_size, config.max_size);
+		rotations[count] = random.uniform(0.0f, Maths::PI * 2.0f);
+		lifetimes[count] = random.uniform(config.min_lifetime, config.max_lifetime);
+		rotation_speeds[count] = random.uniform(config.rotation_speed_min, config.rotation_speed_max);
 	}
+}
 
-	// Remove dead particles 
-	// this feels extremely expensive, can definitely improve upon
-	particles.erase(
-		std::remove_if(particles.begin(), particles.end(),
-			[](const Particle& p) { return p.lifetime <= 0.0f; }),
-		particles.end()
-	);
+void ParticleEmitter::integrate(float delta_time)
+{
+	// The color interpolates from start to end by lifetime / max_lifetime,
+	// folded into one multiply-add per channel
+	const __m256 step = _mm256_set1_ps(delta_time);
+	__m256 color_starts[4];
+	__m256 color_slopes[4];
+	for (int channel = 0; channel < 4; ++channel)
+	{
+		color_starts[channel] = _mm256_set1_ps(config.start_color[channel]);
+		color_slopes[channel] = _mm256_set1_ps(
+			(config.end_color[channel] - config.start_color[channel]) / config.max_lifetime);
+	}
+
+	// Padding lanes of the final batch are integrated too, which is harmless
+	for (uint32_t first = 0; first < count; first += BATCH_SIZE)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const __m256 position = _mm256_loadu_ps(positions[axis].data() + first);
+			const __m256 velocity = _mm256_loadu_ps(velocities[axis].data() + first);
+			_mm256_storeu_ps(positions[axis].data() + first, _mm256_fmadd_ps(velocity, step, position));
+		}
+
+		const __m256 rotation = _mm256_loadu_ps(rotations.data() + first);
+		const __m256 rotation_speed = _mm256_loadu_ps(rotation_speeds.data() + first);
+		_mm256_storeu_ps(rotations.data() + first, _mm256_fmadd_ps(rotation_speed, step, rotation));
+
+		const __m256 lifetime = _mm256_sub_ps(_mm256_loadu_ps(lifetimes.data() + first), step);
+		_mm256_storeu_ps(lifetimes.data() + first, lifetime);
+		for (int channel = 0; channel < 4; ++channel)
+			_mm256_storeu_ps(colors[channel].data() + first,
+				_mm256_fmadd_ps(lifetime, color_slopes[channel], color_starts[channel]));
+	}
+}
+
+void ParticleEmitter::remove_dead()
+{
+	dead_indices.clear();
+	const __m256 zero = _mm256_setzero_ps();
+	for (uint32_t first = 0; first < count; first += BATCH_SIZE)
+	{
+		int dead = _mm256_movemask_ps(
+			_mm256_cmp_ps(_mm256_loadu_ps(lifetimes.data() + first), zero, _CMP_LE_OQ));
+		// padding lanes of the final batch are not particles
+		if (count - first < BATCH_SIZE)
+			dead &= (1 << (count - first)) - 1;
+		for (; dead != 0; dead &= dead - 1)
+			dead_indices.push_back(first + static_cast<uint32_t>(std::countr_zero(static_cast<unsigned>(dead))));
+	}
+
+	// Highest first, so that the last particle is alive whenever it fills a gap
+	for (auto index = dead_indices.rbegin(); index != dead_indices.rend(); ++index)
+	{
+		--count;
+		if (*index != count)
+			move_particle(count, *index);
+	}
+}
+
+void ParticleEmitter::move_particle(uint32_t from, uint32_t to)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		positions[axis][to] = positions[axis][from];
+		velocities[axis][to] = velocities[axis][from];
+	}
+	for (auto& channel : colors)
+		channel[to] = channel[from];
+	sizes[to] = sizes[from];
+	rotations[to] = rotations[from];
+	rotation_speeds[to] = rotation_speeds[from];
+	lifetimes[to] = lifetimes[from];
 }
 
-void ParticleSystem::Emitter::emit(uint32_t count)
+void ParticleEmitter::write_instances(SDS::ParticleInstanceData* out) const
 {
-	for (uint32_t i = 0; i < count && particles.size() < config.max_particles; ++i)
+	for (uint32_t index = 0; index < count; ++index)
 	{
-		particles.push_back(Particle{
-			.position = ecs.get_position(parent_id),
-			.velocity = Maths::random_uniform(config.velocity_min, config.velocity_max),
-			.color = config.start_color,
-			.size = Maths::random_uniform(config.min_size, config.max_size),
-			.rotation = Maths::random_uniform(0.0f, Maths::PI * 2.0f),
-			.lifetime = Maths::random_uniform(config.min_lifetime, config.max_lifetime),
-			.rotation_speed = Maths::random_uniform(config.rotation_speed_min, config.rotation_speed_max)
-		});
+		out[index] = SDS::ParticleInstanceData{
+			.position = glm::vec3(positions[0][index], positions[1][index], positions[2][index]),
+			.size = sizes[index],
+			.color = glm::vec4(colors[0][index], colors[1][index], colors[2][index], colors[3][index]),
+			.rotation = rotations[index],
+		};
+	}
+}
+
+template<typename Function>
+void ParticleSystem::for_each_emitter_range(const Function& function) const
+{
+	TaskPool& pool = get_particle_task_pool();
+	size_t particle_count = 0;
+	for (const auto& entry : emitters)
+	{
+		particle_count += entry.emitter->size();
+	}
+	// several ranges per thread, so that threads with cheap ranges take more
+	const size_t range_particles = std::max<size_t>(
+		MIN_PARTICLES_PER_TASK, particle_count / ((pool.get_worker_count() + 1) * 4));
+
+	emitter_range_bounds.clear();
+	emitter_range_bounds.push_back(0);
+	size_t range_count = 0;
+	for (size_t index = 0; index + 1 < emitters.size(); ++index)
+	{
+		range_count += emitters[index].emitter->size();
+		if (range_count >= range_particles)
+		{
+			emitter_range_bounds.push_back(index + 1);
+			range_count = 0;
+		}
 	}
+	emitter_range_bounds.push_back(emitters.size());
+
+	pool.parallel_for(emitter_range_bounds.size() - 1, 1, [&](const size_t first, const size_t last)
+	{
+		function(emitter_range_bounds[first], emitter_range_bounds[last]);
+	});
 }
 
 void ParticleSystem::process(float delta_time)
 {
-	for (auto& [_, emitter] : emitters)
+	// The ECS is read here rather than from the workers
+	spawn_positions.clear();
+	for (const auto& entry : emitters)
 	{
-		emitter->process(delta_time);
+		spawn_positions.push_back(get_ecs().get_position(entry.entity_id));
 	}
+
+	for_each_emitter_range([&](size_t first, size_t last) {
+		for (size_t index = first; index < last; ++index)
+		{
+			emitters[index].emitter->process(delta_time, spawn_positions[index]);
+		}
+	});
 	
 	// Remove dead emitters (non-looping emitters with no particles)
 	std::erase_if(emitters,
-		[](const auto& p) { return !p.second->is_alive(); }
+		[](const EmitterEntry& entry) { return !entry.emitter->is_alive(); }
 	);
 }
 
 void ParticleSystem::spawn_particle_emitter(EntityID entity_id, const ParticleEmitterConfig& config)
 {
-	assert(emitters.find(entity_id) == emitters.end() && "Entity already has a particle emitter!");
-	emitters.emplace(entity_id, std::make_unique<Emitter>(config, get_ecs(), entity_id));
+	assert(std::ranges::none_of(emitters, [entity_id](const EmitterEntry& entry) { return entry.entity_id == entity_id; })
+		&& "Entity already has a particle emitter!");
+	emitters.push_back({
+		.entity_id = entity_id,
+		.emitter = std::make_unique<ParticleEmitter>(config, spawned_emitter_count++),
+	});
 }
 
 void ParticleSystem::remove_entity(EntityID entity_id)
 {
-	emitters.erase(entity_id);
+	std::erase_if(emitters,
+		[entity_id](const EmitterEntry& entry) { return entry.entity_id == entity_id; }
+	);
 }
 
 void ParticleSystem::prepare_render_data(
 	std::vector<SDS::ParticleInstanceData>& out_instance_data) const
 {
-	out_instance_data.clear();
-	
-	for (const auto& [_, emitter] : emitters)
+	// Each emitter writes its own range, found by a prefix sum of their sizes
+	instance_offsets.clear();
+	size_t instance_count = 0;
+	for (const auto& entry : emitters)
 	{
-		for (const auto& particle : emitter->particles)
+		instance_offsets.push_back(instance_count);
+		instance_count += entry.emitter->size();
+	}
+	out_instance_data.resize(instance_count);
+
+	for_each_emitter_range([&](size_t first, size_t last) {
+		for (size_t index = first; index < last; ++index)
 		{
-			out_instance_data.push_back(SDS::ParticleInstanceData{
-				.model = glm::translate(glm::mat4(1.0f), particle.position),
-				.color = particle.color,
-				.size = particle.size,
-				.rotation = particle.rotation
-			});
+			emitters[index].emitter->write_instances(out_instance_data.data() + instance_offsets[index]);
 		}
-	}
+	});
+}
+
+TaskPool& ParticleSystem::get_particle_task_pool() const
+{
+	return task_pool ? *task_pool : TaskPool::get_shared();
 }
@@ -4,12 +4,12 @@
 #include "renderable/material.hpp"
 #include "identifications.hpp"
 #include "objects/object.hpp"
+#include "maths.hpp"
 
 #include <glm/glm.hpp>
 
 #include <vector>
 #include <memory>
-#include <functional>
 #include <optional>
 #include <unordered_map>
 
@@ -32,11 +32,60 @@ struct ParticleEmitterConfig
 	std::optional<MaterialID> material_id; // Optional texture
 };
 
+// An emitter's live particles in structure-of-arrays order, padded to whole
+// batches of eight so that they are integrated eight at a time. Dead particles
+// are replaced by the last live one, so particle order is not preserved.
+// Randomness comes from the emitter's own stream, so emitters can be processed
+// on any thread and still give the same particles for the same seed.
+class ParticleEmitter
+{
+public:
+	static constexpr uint32_t BATCH_SIZE = 8;
+
+	ParticleEmitter(const ParticleEmitterConfig& config, uint64_t seed);
+
+	// Emits at spawn_position according to the emission rate, then advances
+	// every particle and removes the dead ones
+	void process(float delta_time, const glm::vec3& spawn_position);
+	void emit(uint32_t emit_count, const glm::vec3& spawn_position);
+
+	// Writes one instance per live particle, out must hold size() of them
+	void write_instances(SDS::ParticleInstanceData* out) const;
+
+	uint32_t size() const { return count; }
+	bool is_alive() const { return config.loop || count > 0; }
+	const ParticleEmitterConfig& get_config() const { return config; }
+
+	bool enabled = true;
+
+private:
+	void integrate(float delta_time);
+	void remove_dead();
+	void move_particle(uint32_t from, uint32_t to);
+
+	ParticleEmitterConfig config;
+	Maths::CounterRandom random;
+	float emission_accumulator = 0.0f;
+	uint32_t count = 0;
+
+	// Each holds max_particles rounded up to a whole batch
+	std::vector<float> positions[3];
+	std::vector<float> velocities[3];
+	std::vector<float> colors[4];
+	std::vector<float> sizes;
+	std::vector<float> rotations;
+	std::vector<float> rotation_speeds;
+	std::vector<float> lifetimes;		// Remaining lifetime
+	std::vector<uint32_t> dead_indices;
+};
+
 class ECS;
+class TaskPool;
 
 class ParticleSystem
 {
 public:
+	// Processes the emitters in parallel on the particle task pool
 	void process(float delta_time);
 	
 	void spawn_particle_emitter(EntityID entity_id, const ParticleEmitterConfig& config);
@@ -46,38 +95,32 @@ public:
 
 	void remove_entity(EntityID id);
 
+	// TaskPool::get_shared() unless set
+	void set_particle_task_pool(TaskPool& pool) { task_pool = &pool; }
+
 protected:
 	virtual ECS& get_ecs() = 0;
 	virtual const ECS& get_ecs() const = 0;
 
 private:
-	struct Particle
+	struct EmitterEntry
 	{
-		glm::vec3 position;
-		glm::vec3 velocity;
-		glm::vec4 color;
-		float size;
-		float rotation;
-		float lifetime;       // Remaining lifetime
-		float rotation_speed;
+		EntityID entity_id;
+		std::unique_ptr<ParticleEmitter> emitter;
 	};
 
-	struct Emitter
-	{
-		Emitter(const ParticleEmitterConfig& config, ECS& ecs, EntityID parent_id);
-
-		void process(float delta_time);
-		void emit(uint32_t count);
-		
-		bool is_alive() const { return config.loop || !particles.empty(); }
-
-		ParticleEmitterConfig config;
-		std::vector<Particle> particles;
-		float emission_accumulator = 0.0f;
-		bool enabled = true;
-		ECS& ecs;
-		EntityID parent_id;
-	};
+	TaskPool& get_particle_task_pool() const;
+	// Runs function over consecutive ranges of emitters holding roughly equal
+	// numbers of particles, on the task pool when there are enough of them
+	template<typename Function>
+	void for_each_emitter_range(const Function& function) const;
 
-	std::unordered_map<EntityID, std::unique_ptr<Emitter>> emitters;
+	// In spawn order, which with the seeds below makes the output reproducible
+	std::vector<EmitterEntry> emitters;
+	uint64_t spawned_emitter_count = 0;
+	TaskPool* task_pool = nullptr;
+	// Per-tick scratch, kept to reuse its capacity
+	std::vector<glm::vec3> spawn_positions;
+	mutable std::vector<size_t> instance_offsets;
+	mutable std::vector<size_t> emitter_range_bounds;
 };
@@ -193,6 +193,8 @@ public:
 	std::vector<PhysicsContactEvent> events, pending_events;
 	std::mutex event_mutex;
 	float accumulator = 0.0f;
+	// reused each step to hand dynamic body poses to the ECS in one batch
+	std::vector<EntityID> synced_ids; std::vector<glm::vec3> synced_positions; std::vector<glm::quat> synced_rotations;
 };
 
 ::PhysicsSystem::PhysicsSystem() : impl(std::make_unique<Impl>()) {}
@@ -248,7 +250,7 @@ void ::PhysicsSystem::teleport_body(EntityID id, glm::vec3 p, glm::quat q, bool
 	auto& r = impl->bodies.at(id); auto& api = impl->world.GetBodyInterface();
 	api.SetPositionAndRotation(r.body, to_jolt_r(p), to_jolt(q), EActivation::Activate);
 	if (reset) { api.SetLinearVelocity(r.body, Vec3::sZero()); api.SetAngularVelocity(r.body, Vec3::sZero()); }
-	r.published_position = p; r.published_rotation = q; get_ecs().set_position(id, p); get_ecs().set_rotation(id, q);
+	r.published_position = p; r.published_rotation = q; get_ecs().set_pose(id, p, q);
 }
 void ::PhysicsSystem::set_linear_velocity(EntityID id, glm::vec3 v) { impl->world.GetBodyInterface().SetLinearVelocity(impl->bodies.at(id).body, to_jolt(v)); }
 glm::vec3 PhysicsSystem::get_linear_velocity(EntityID id) const { return to_glm(impl->world.GetBodyInterface().GetLinearVelocity(impl->bodies.at(id).body)); }
@@ -282,10 +284,12 @@ void ::PhysicsSystem::process(float dt)
 		impl->world.Update(1.0f / 60.0f, 1, &impl->allocator, impl->jobs.get());
 		impl->accumulator -= 1.0f / 60.0f;
 	}
+	impl->synced_ids.clear(); impl->synced_positions.clear(); impl->synced_rotations.clear();
 	for (auto& [id, r] : impl->bodies) if (r.definition.motion == PhysicsMotionType::Dynamic && api.IsAdded(r.body)) {
 		r.published_position = to_glm(Vec3(api.GetPosition(r.body))); r.published_rotation = {api.GetRotation(r.body).GetW(), api.GetRotation(r.body).GetX(), api.GetRotation(r.body).GetY(), api.GetRotation(r.body).GetZ()};
-		get_ecs().set_position(id, r.published_position); get_ecs().set_rotation(id, r.published_rotation);
+		impl->synced_ids.push_back(id); impl->synced_positions.push_back(r.published_position); impl->synced_rotations.push_back(r.published_rotation);
 	}
+	get_ecs().set_poses(impl->synced_ids, impl->synced_positions, impl->synced_rotations);
 	std::scoped_lock lock(impl->event_mutex); impl->events = std::move(impl->pending_events); impl->pending_events.clear();
 }
 
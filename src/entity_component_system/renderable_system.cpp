@@ -12,10 +12,13 @@
 #include <limits>
 #include <ranges>
 #include <stdexcept>
+#include <utility>
 
 
 namespace
 {
+constexpr size_t MIN_TRACKED_CHANGE_LIMIT = 1'024;
+
 void write_source(Serializer out, const ImportedResourceProvenance& source)
 {
 	out.write("path", source.source);
@@ -113,6 +116,7 @@ RenderableID RenderableSystem::add_renderable(
 		.object_id = object_id,
 		.skeleton_id = skeleton_id,
 	});
+	request_full_refresh();
 	return id;
 }
 
@@ -180,6 +184,7 @@ bool RenderableSystem::remove_renderable(const RenderableID id)
 		return false;
 	notify_removing(id);
 	renderables.erase(id);
+	request_full_refresh();
 	return true;
 }
 
@@ -200,6 +205,7 @@ RenderableID RenderableSystem::replace_renderable(
 	});
 	notify_replacing(id, replacement_id);
 	renderables.erase(id);
+	request_full_refresh();
 	return replacement_id;
 }
 
@@ -220,6 +226,7 @@ RenderableID RenderableSystem::replace_renderable_with_clone(
 	});
 	notify_removing(target_id);
 	renderables.erase(target_id);
+	request_full_refresh();
 	return replacement_id;
 }
 
@@ -227,6 +234,8 @@ void RenderableSystem::set_renderable_local_transform(
 	const RenderableID id, Maths::Transform transform)
 {
 	renderables.at(id).renderable.local_transform = std::move(transform);
+	if (is_tracking_changes())
+		pending_changes.renderables.push_back(id);
 }
 
 void RenderableSystem::remove_object_renderables(const ObjectID id)
@@ -249,6 +258,7 @@ RenderableSystem::AttachmentMap RenderableSystem::take_renderables_if(
 		else
 			++it;
 	}
+	request_full_refresh();
 	return taken;
 }
 
@@ -256,11 +266,14 @@ void RenderableSystem::restore_renderables(AttachmentMap values)
 {
 	for (auto& node : values)
 		renderables.insert(std::move(node));
+	request_full_refresh();
 }
 
 void RenderableSystem::set_renderable_visibility(const RenderableID id, const bool visible)
 {
 	renderables.at(id).visible = visible;
+	if (is_tracking_changes())
+		pending_changes.renderables.push_back(id);
 }
 
 glm::mat4 RenderableSystem::get_renderable_transform(const RenderableID id) const
@@ -277,6 +290,42 @@ bool RenderableSystem::get_renderable_visibility(const RenderableID id) const
 		&& (!attachment.object_id || get_ecs().get_object(*attachment.object_id).get_visibility());
 }
 
+void RenderableSystem::on_entity_transform_changed(const EntityID id)
+{
+	if (is_tracking_changes())
+		pending_changes.entities.push_back(id);
+}
+
+void RenderableSystem::request_full_refresh()
+{
+	pending_changes.full_refresh = true;
+	pending_changes.renderables.clear();
+	pending_changes.entities.clear();
+}
+
+bool RenderableSystem::is_tracking_changes()
+{
+	if (pending_changes.full_refresh)
+		return false;
+	// past this many changes refreshing everything is cheaper, and it bounds
+	// the backlog when nothing collects changes
+	if (pending_changes.renderables.size() + pending_changes.entities.size()
+		>= std::max<size_t>(renderables.size(), MIN_TRACKED_CHANGE_LIMIT))
+	{
+		request_full_refresh();
+		return false;
+	}
+	return true;
+}
+
+void RenderableSystem::collect_renderable_changes(RenderableChanges& changes)
+{
+	changes.renderables.clear();
+	changes.entities.clear();
+	std::swap(changes, pending_changes);
+	pending_changes.full_refresh = false;
+}
+
 bool RenderableSystem::references_skeleton(const SkeletonID id) const
 {
 	return std::ranges::any_of(renderables, [id](const auto& entry) {
@@ -392,4 +441,6 @@ void RenderableSystem::deserialize(const Deserializer& in, SceneResourceReader&
 			notify_removing(id);
 	}
 	renderables = std::move(restored);
+	// transforms were restored without change notifications
+	request_full_refresh();
 }
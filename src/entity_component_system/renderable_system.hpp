@@ -23,6 +23,19 @@ struct RenderableAttachment
 	bool visible = true;
 };
 
+// Changes to apply to a mirror of the renderables, such as the render frame
+// builder's, accumulated since it last collected them
+struct RenderableChanges
+{
+	// Renderables were added, removed or replaced, or so much changed that
+	// everything mirrored should be rebuilt
+	bool full_refresh = false;
+	// Renderables whose local transform or visibility changed
+	std::vector<RenderableID> renderables;
+	// Entities whose world transform changed, renderable owners or not
+	std::vector<EntityID> entities;
+};
+
 class RenderableSystem
 {
 public:
@@ -43,6 +56,7 @@ public:
 
 	bool has_renderable(RenderableID id) const { return renderables.contains(id); }
 	const RenderableAttachment& get_renderable(RenderableID id) const { return renderables.at(id); }
+	const std::unordered_map<RenderableID, RenderableAttachment>& get_renderables() const { return renderables; }
 	std::vector<RenderableID> get_renderable_ids() const;
 	std::vector<RenderableID> get_renderable_ids(ObjectID object_id) const;
 
@@ -60,6 +74,11 @@ public:
 	bool get_renderable_visibility(RenderableID id) const;
 
 	bool references_skeleton(SkeletonID id) const;
+	// Moves the accumulated changes into changes, whose previous contents are
+	// discarded and whose buffers are reused for the next accumulation. A
+	// single consumer is supported.
+	void collect_renderable_changes(RenderableChanges& changes);
+
 	void serialize(Serializer& out, SceneResourceWriter& resources) const;
 	void deserialize(const Deserializer& in, SceneResourceReader& resources);
 
@@ -68,12 +87,16 @@ protected:
 	AttachmentMap take_renderables_if(const std::function<bool(ObjectID)>& predicate);
 	void restore_renderables(AttachmentMap values);
 	void remove_object_renderables(ObjectID id);
+	void on_entity_transform_changed(EntityID id);
 
 private:
 	void validate_attachment(const Renderable& renderable,
 		std::optional<ObjectID> object_id, std::optional<SkeletonID> skeleton_id) const;
 	void notify_removing(RenderableID id);
 	void notify_replacing(RenderableID old_id, RenderableID new_id);
+	void request_full_refresh();
+	bool is_tracking_changes();
 
 	AttachmentMap renderables;
+	RenderableChanges pending_changes{ .full_refresh = true };
 };
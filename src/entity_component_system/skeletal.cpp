@@ -1,12 +1,16 @@
 #include "skeletal.hpp"
 #include "ecs.hpp"
+#include "render_frame.hpp"
 #include "serialization/resource_provenance.hpp"
+#include "task_pool.hpp"
 
 #include <stdexcept>
 #include <ranges>
 #include <algorithm>
 #include <cmath>
-#include <functional>
+#include <optional>
+#include <span>
+#include <tuple>
 #include <unordered_map>
 
 
@@ -137,33 +141,18 @@ SkeletalRigSignature make_skeletal_rig_signature(const std::vector<Bone>& bones)
 std::vector<SDS::Bone> SkeletalComponent::get_bones_data() const
 {
 	std::vector<SDS::Bone> final_bones_data(bones.size());
-	std::vector<bool> resolved(bones.size(), false);
-	std::function<void(uint32_t)> resolve = [&](const uint32_t index)
+	for (const uint32_t index : parent_first_order)
 	{
-		if (resolved[index])
-			return;
 		const auto& bone = bones[index];
-		if (bone.parent_node != Bone::NO_PARENT)
-		{
-			if (bone.parent_node >= bones.size())
-				throw std::runtime_error("SkeletalComponent: invalid bone parent index");
-			resolve(bone.parent_node);
-			final_bones_data[index].final_transform =
-				final_bones_data[bone.parent_node].final_transform * bone.relative_transform.get_mat4();
-		}
-		else
-		{
-			final_bones_data[index].final_transform = bone.relative_transform.get_mat4();
-		}
-		final_bones_data[index].inverse_transform = bone.inverse_bind_pose.get_mat4();
-		resolved[index] = true;
-	};
-	for (uint32_t i = 0; i < bones.size(); ++i)
-		resolve(i);
+		final_bones_data[index].final_transform = bone.parent_node == Bone::NO_PARENT
+			? bone.relative_transform.get_mat4()
+			: final_bones_data[bone.parent_node].final_transform * bone.relative_transform.get_mat4();
+	}
 
 	for (uint32_t i = 0; i < bones.size(); i++)
 	{
-		final_bones_data[i].final_transform *= bones[i].inverse_bind_pose.get_mat4();
+		final_bones_data[i].inverse_transform = bones[i].inverse_bind_pose.get_mat4();
+		final_bones_data[i].final_transform *= final_bones_data[i].inverse_transform;
 	}
 
 	return final_bones_data;
@@ -171,32 +160,35 @@ std::vector<SDS::Bone> SkeletalComponent::get_bones_data() const
 
 std::vector<glm::mat4> SkeletalComponent::get_model_space_bone_transforms() const
 {
-	std::vector<glm::mat4> transforms(bones.size());
-	std::vector<bool> resolved(bones.size(), false);
-	std::function<void(uint32_t)> resolve = [&](const uint32_t index)
+	std::vector<glm::mat4> transforms;
+	get_model_space_bone_transforms(transforms);
+	return transforms;
+}
+
+void SkeletalComponent::get_model_space_bone_transforms(std::vector<glm::mat4>& transforms) const
+{
+	transforms.resize(bones.size());
+	for (const uint32_t index : parent_first_order)
 	{
-		if (resolved[index])
-			return;
 		const auto& bone = bones[index];
-		if (bone.parent_node != Bone::NO_PARENT)
-		{
-			if (bone.parent_node >= bones.size())
-				throw std::runtime_error("SkeletalComponent: invalid bone parent index");
-			resolve(bone.parent_node);
-			transforms[index] = transforms[bone.parent_node] * bone.relative_transform.get_mat4();
-		}
-		else
-			transforms[index] = bone.relative_transform.get_mat4();
-		resolved[index] = true;
-	};
-	for (uint32_t i = 0; i < bones.size(); ++i)
-		resolve(i);
-	return transforms;
+		transforms[index] = bone.parent_node == Bone::NO_PARENT
+			? bone.relative_transform.get_mat4()
+			: transforms[bone.parent_node] * bone.relative_transform.get_mat4();
+	}
 }
 
 SkeletalRenderStateSnapshot SkeletalComponent::snapshot_render_state() const
 {
 	SkeletalRenderStateSnapshot snapshot;
+	snapshot_render_state(snapshot);
+	return snapshot;
+}
+
+void SkeletalComponent::snapshot_render_state(SkeletalRenderStateSnapshot& snapshot) const
+{
+	snapshot.parent_indices.clear();
+	snapshot.inverse_bind_poses.clear();
+	snapshot.local_transforms.clear();
 	snapshot.parent_indices.reserve(bones.size());
 	snapshot.inverse_bind_poses.reserve(bones.size());
 	snapshot.local_transforms.reserve(bones.size());
@@ -206,7 +198,6 @@ SkeletalRenderStateSnapshot SkeletalComponent::snapshot_render_state() const
 		snapshot.inverse_bind_poses.push_back(bone.inverse_bind_pose.get_mat4());
 		snapshot.local_transforms.push_back(bone.relative_transform.get_mat4());
 	}
-	return snapshot;
 }
 
 void SkeletalComponent::reset_pose()
@@ -215,6 +206,49 @@ void SkeletalComponent::reset_pose()
 		bone.relative_transform = bone.original_transform;
 }
 
+void SkeletalComponent::get_local_pose(AnimationPose& pose) const
+{
+	pose.resize(bones.size());
+	for (size_t index = 0; index < bones.size(); ++index)
+	{
+		const auto& transform = bones[index].relative_transform;
+		pose.set(index, transform.get_pos(), transform.get_orient(), transform.get_scale());
+	}
+}
+
+void SkeletalComponent::set_local_pose(const AnimationPose& pose)
+{
+	if (pose.size() != bones.size())
+		throw std::invalid_argument("SkeletalComponent::set_local_pose: pose does not match the skeleton");
+	for (size_t index = 0; index < bones.size(); ++index)
+		bones[index].relative_transform = Maths::Transform(
+			pose.get_translation(index), pose.get_scale(index), pose.get_rotation(index));
+}
+
+void SkeletalComponent::cache_bone_layout()
+{
+	std::vector<uint32_t> parent_indices;
+	parent_indices.reserve(bones.size());
+	for (const auto& bone : bones)
+		parent_indices.push_back(bone.parent_node);
+	parent_first_order = make_parent_first_order(parent_indices);
+	inner_bone_mask.assign(bones.size(), 0);
+	for (size_t index = 0; index < bones.size(); ++index)
+	{
+		if (bones[index].parent_node == Bone::NO_PARENT)
+			inner_bone_mask[index] = 1;
+		else
+			inner_bone_mask[bones[index].parent_node] = 1;
+	}
+
+	rest_pose.resize(bones.size());
+	for (size_t index = 0; index < bones.size(); ++index)
+	{
+		const auto& transform = bones[index].original_transform;
+		rest_pose.set(index, transform.get_pos(), transform.get_orient(), transform.get_scale());
+	}
+}
+
 bool BoneAnimation::get_transform(const float animation_stage_secs, Maths::Transform& out_transform) const
 {
 	if (translation_track.keys.empty() && rotation_track.keys.empty() && scale_track.keys.empty())
@@ -293,25 +327,50 @@ bool SkeletalSystem::detach_entity_from_bone(const Entity attached)
 	return bone_attachments.erase(attached) > 0;
 }
 
+TaskPool& SkeletalSystem::get_skeletal_task_pool() const
+{
+	return task_pool ? *task_pool : TaskPool::get_shared();
+}
+
 void SkeletalSystem::process(const float)
 {
-	std::unordered_map<SkeletonID, std::vector<glm::mat4>> model_space_poses;
-	for (const auto& [attached, attachment] : bone_attachments)
+	const auto get_source_skeleton = [this](const BoneAttachment& attachment) -> std::optional<SkeletonID>
 	{
 		if (!get_ecs().has_renderable(attachment.source_renderable))
+			return std::nullopt;
+		return get_ecs().get_renderable(attachment.source_renderable).skeleton_id;
+	};
+
+	posed_skeletons.clear();
+	for (const auto& [_, attachment] : bone_attachments)
+		if (const auto skeleton_id = get_source_skeleton(attachment))
+			posed_skeletons.push_back(*skeleton_id);
+	std::ranges::sort(posed_skeletons);
+	const auto duplicates = std::ranges::unique(posed_skeletons);
+	posed_skeletons.erase(duplicates.begin(), duplicates.end());
+	if (model_space_poses.size() < posed_skeletons.size())
+		model_space_poses.resize(posed_skeletons.size());
+
+	// each skeleton is composed once however many entities are attached to it
+	get_skeletal_task_pool().parallel_for(posed_skeletons.size(), MIN_SKELETONS_PER_TASK,
+		[this](const size_t first, const size_t last)
+		{
+			for (size_t index = first; index < last; ++index)
+				skeletons.at(posed_skeletons[index]).get_model_space_bone_transforms(model_space_poses[index]);
+		});
+
+	for (const auto& [attached, attachment] : bone_attachments)
+	{
+		const auto skeleton_id = get_source_skeleton(attachment);
+		if (!skeleton_id)
 			continue;
-		const auto& source = get_ecs().get_renderable(attachment.source_renderable);
-		if (!source.skeleton_id)
-			continue;
-		auto [pose, inserted] = model_space_poses.try_emplace(*source.skeleton_id);
-		if (inserted)
-			pose->second = get_skeletal_component(*source.skeleton_id).get_model_space_bone_transforms();
-		if (attachment.bone_index >= pose->second.size())
+		const auto& pose = model_space_poses[std::ranges::lower_bound(posed_skeletons, *skeleton_id) - posed_skeletons.begin()];
+		if (attachment.bone_index >= pose.size())
 			continue;
 
 		get_ecs().set_transform(attached,
 			get_ecs().get_renderable_transform(attachment.source_renderable) *
-			pose->second[attachment.bone_index] *
+			pose[attachment.bone_index] *
 			attachment.local_transform.get_mat4());
 	}
 }
@@ -348,7 +407,13 @@ void SkeletalSystem::on_renderable_replaced(
 
 void SkeletalAnimationSystem::process(const float delta_secs)
 {
+	using Action = AnimationState::Lod::Action;
+	if (lod_settings.enabled)
+		update_animation_lods();
+	lod_counters = {};
 	std::vector<SkeletonID> skeletons_to_remove;
+	posing_skeletons.clear();
+	due_skeletons.clear();
 	for (const auto& [skeleton_id, animation_id] : active_animations)
 	{
 		AnimationState& state = animation_states[skeleton_id];
@@ -374,7 +439,79 @@ void SkeletalAnimationSystem::process(const float delta_secs)
 		{
 			state.fade->elapsed_secs += std::abs(delta_secs * state.playback_speed);
 		}
-		apply_animation_pose(skeleton_id);
+
+		auto& lod = state.lod;
+		if (!lod_settings.enabled)
+			lod.level = EAnimationLod::FULL;
+		++lod_counters.skeletons[static_cast<size_t>(lod.level)];
+		if (lod.level == EAnimationLod::FROZEN)
+		{
+			lod.sampled = false;
+			lod.ticks_since_sample = 0;
+			continue;
+		}
+		++lod.ticks_since_sample;
+		// A skeleton brought nearer is sampled at its new rate straight away
+		if (!lod.sampled || lod.ticks_since_sample >= std::min(lod.interval, get_lod_update_interval(lod.level)))
+		{
+			due_skeletons.push_back(skeleton_id);
+		}
+		else if (lod.interpolated)
+		{
+			lod.action = Action::BLEND;
+			posing_skeletons.push_back(skeleton_id);
+		}
+	}
+
+	const size_t max_updates = lod_settings.enabled ? lod_settings.max_updates_per_tick : due_skeletons.size();
+	if (due_skeletons.size() > max_updates)
+	{
+		// against the interval that made the skeleton due, which is below its
+		// last one when it has just been brought nearer
+		const auto overdue_ticks = [this](const AnimationState::Lod& lod)
+		{
+			const auto ticks = static_cast<int64_t>(lod.ticks_since_sample);
+			return lod.sampled ? ticks - std::min(lod.interval, get_lod_update_interval(lod.level)) : ticks;
+		};
+		const auto sampled_before = [&](const SkeletonID lhs, const SkeletonID rhs)
+		{
+			const auto& lhs_lod = animation_states.at(lhs).lod;
+			const auto& rhs_lod = animation_states.at(rhs).lod;
+			return std::tuple(overdue_ticks(rhs_lod), lhs_lod.distance, lhs)
+				< std::tuple(overdue_ticks(lhs_lod), rhs_lod.distance, rhs);
+		};
+		std::ranges::nth_element(due_skeletons, due_skeletons.begin() + max_updates, sampled_before);
+		for (size_t index = max_updates; index < due_skeletons.size(); ++index)
+		{
+			// Shows the last sample once, then holds it until sampled again
+			auto& lod = animation_states.at(due_skeletons[index]).lod;
+			if (lod.sampled && lod.interpolated && lod.ticks_since_sample == lod.interval)
+			{
+				lod.action = Action::BLEND;
+				posing_skeletons.push_back(due_skeletons[index]);
+			}
+		}
+		lod_counters.deferred = due_skeletons.size() - max_updates;
+		due_skeletons.resize(max_updates);
+	}
+	lod_counters.interpolated = posing_skeletons.size();
+	lod_counters.sampled = due_skeletons.size();
+	for (const SkeletonID skeleton_id : due_skeletons)
+	{
+		animation_states.at(skeleton_id).lod.action = Action::SAMPLE;
+		posing_skeletons.push_back(skeleton_id);
+	}
+
+	// sampling and blending touch only each skeleton's own state and bones
+	get_ecs().get_skeletal_task_pool().parallel_for(posing_skeletons.size(), SkeletalSystem::MIN_SKELETONS_PER_TASK,
+		[this, delta_secs](const size_t first, const size_t last)
+		{
+			for (size_t index = first; index < last; ++index)
+				update_animation_pose(posing_skeletons[index], delta_secs);
+		});
+	for (const SkeletonID skeleton_id : posing_skeletons)
+	{
+		AnimationState& state = animation_states.at(skeleton_id);
 		if (state.fade && state.fade->elapsed_secs >= state.fade->duration_secs)
 			state.fade.reset();
 	}
@@ -386,45 +523,131 @@ void SkeletalAnimationSystem::process(const float delta_secs)
 	});
 }
 
-void SkeletalAnimationSystem::apply_animation_pose(const SkeletonID skeleton_id)
+void SkeletalAnimationSystem::update_animation_lods()
+{
+	for (auto& [_, state] : animation_states)
+	{
+		state.lod.distance = std::numeric_limits<float>::infinity();
+		state.lod.referenced = false;
+	}
+	for (const auto& [renderable_id, attachment] : get_ecs().get_renderables())
+	{
+		if (!attachment.skeleton_id)
+			continue;
+		const auto state = animation_states.find(*attachment.skeleton_id);
+		if (state == animation_states.end())
+			continue;
+		auto& lod = state->second.lod;
+		lod.referenced = true;
+		if (lod_settings.freeze_invisible && !get_ecs().get_renderable_visibility(renderable_id))
+			continue;
+		const glm::vec3 position = get_ecs().get_renderable_transform(renderable_id)[3];
+		lod.distance = std::min(lod.distance, glm::distance(position, lod_viewpoint));
+	}
+	for (auto& [_, state] : animation_states)
+	{
+		auto& lod = state.lod;
+		if (!lod.referenced)
+			lod.distance = 0.0f;
+		const auto level = std::ranges::count_if(lod_settings.distances,
+			[&lod](const float distance) { return lod.distance > distance; });
+		lod.level = static_cast<EAnimationLod>(level);
+	}
+}
+
+void SkeletalAnimationSystem::update_animation_pose(const SkeletonID skeleton_id, const float delta_secs)
 {
-	const auto animation_id = active_animations.at(skeleton_id);
-	const auto& animation = animations.at(animation_id);
 	auto& state = animation_states.at(skeleton_id);
+	auto& lod = state.lod;
 	auto& component = get_ecs().get_skeletal_component(skeleton_id);
-	const auto& bones = component.get_bones();
-	std::vector<Maths::Transform> target_pose;
-	target_pose.reserve(bones.size());
-	for (const auto& bone : bones)
-		target_pose.push_back(bone.original_transform);
-	for (size_t bone_idx = 0; bone_idx < bones.size(); ++bone_idx)
-		animation.bone_animations[bone_idx].get_transform(
-			state.current_animation_elapsed_secs, target_pose[bone_idx]);
-
-	if (!state.fade)
+	if (lod.action == AnimationState::Lod::Action::BLEND)
 	{
-		for (size_t bone_idx = 0; bone_idx < bones.size(); ++bone_idx)
-			component.get_bone_local_transform(bone_idx) = target_pose[bone_idx];
+		const float weight = static_cast<float>(lod.ticks_since_sample) / static_cast<float>(lod.interval);
+		if (weight >= 1.0f)
+		{
+			component.set_local_pose(state.pose);
+			return;
+		}
+		blend_poses(lod.from, state.pose, weight, lod.blended);
+		component.set_local_pose(lod.blended);
 		return;
 	}
 
-	const float blend = std::clamp(
-		state.fade->elapsed_secs / state.fade->duration_secs, 0.0f, 1.0f);
-	for (size_t bone_idx = 0; bone_idx < bones.size(); ++bone_idx)
+	const uint32_t interval = get_lod_update_interval(lod.level);
+	const bool skip_leaf_bones = lod_settings.enabled && lod.level >= lod_settings.skip_leaf_bones_from;
+	const bool interpolate = lod_settings.enabled && lod_settings.interpolate && interval > 1;
+	if (interpolate)
+	{
+		// Blends over the next interval from the pose at the playback time to
+		// the one sampled for the end of it, which is the last sample when
+		// updates have been continuous
+		if (!lod.sampled || !lod.interpolated || lod.ticks_since_sample != lod.interval)
+			sample_animation_pose(skeleton_id, 0.0f, skip_leaf_bones);
+		component.set_local_pose(state.pose);
+		std::swap(lod.from, state.pose);
+		sample_animation_pose(skeleton_id, static_cast<float>(interval) * delta_secs * state.playback_speed,
+			skip_leaf_bones);
+	}
+	else
+	{
+		sample_animation_pose(skeleton_id, 0.0f, skip_leaf_bones);
+		component.set_local_pose(state.pose);
+	}
+	lod.sampled = true;
+	lod.interpolated = interpolate;
+	lod.interval = interval;
+	lod.ticks_since_sample = 0;
+}
+
+uint32_t SkeletalAnimationSystem::get_lod_update_interval(const EAnimationLod level) const
+{
+	if (!lod_settings.enabled || level == EAnimationLod::FROZEN)
+		return 1;
+	return std::max(lod_settings.update_intervals[static_cast<size_t>(level)], 1u);
+}
+
+void SkeletalAnimationSystem::sample_animation_pose(
+	const SkeletonID skeleton_id, const float lookahead_secs, const bool skip_leaf_bones)
+{
+	const auto animation_id = active_animations.at(skeleton_id);
+	const auto& animation = animations.at(animation_id);
+	auto& state = animation_states.at(skeleton_id);
+	const auto& component = get_ecs().get_skeletal_component(skeleton_id);
+	float animation_stage_secs = state.current_animation_elapsed_secs + lookahead_secs;
+	if (lookahead_secs != 0.0f)
 	{
-		auto& result = component.get_bone_local_transform(bone_idx);
-		const auto& source = state.fade->source_pose[bone_idx];
-		const auto& target = target_pose[bone_idx];
-		result.set_pos(glm::mix(source.get_pos(), target.get_pos(), blend));
-		result.set_scale(glm::mix(source.get_scale(), target.get_scale(), blend));
-		auto target_orientation = target.get_orient();
-		if (glm::dot(source.get_orient(), target_orientation) < 0.0f)
-			target_orientation = -target_orientation;
-		result.set_orient(glm::normalize(glm::slerp(
-			source.get_orient(), target_orientation, blend)));
+		const float duration_secs = animation_duration(animation);
+		if (state.should_loop && duration_secs > 0.0f)
+		{
+			animation_stage_secs = std::fmod(animation_stage_secs, duration_secs);
+			if (animation_stage_secs < 0.0f)
+				animation_stage_secs += duration_secs;
+		}
+		else
+		{
+			animation_stage_secs = std::clamp(animation_stage_secs, 0.0f, duration_secs);
+		}
+	}
+	animation.clip.sample(animation_stage_secs, state.cursor, component.get_rest_pose(), state.pose,
+		skip_leaf_bones ? std::span<const uint8_t>(component.get_inner_bone_mask()) : std::span<const uint8_t>());
+
+	if (state.fade)
+	{
+		const float blend = std::clamp(
+			(state.fade->elapsed_secs + std::abs(lookahead_secs)) / state.fade->duration_secs, 0.0f, 1.0f);
+		blend_poses(state.fade->source_pose, state.pose, blend, state.pose);
 	}
 }
 
+void SkeletalAnimationSystem::apply_animation_pose(const SkeletonID skeleton_id)
+{
+	sample_animation_pose(skeleton_id, 0.0f, false);
+	auto& state = animation_states.at(skeleton_id);
+	get_ecs().get_skeletal_component(skeleton_id).set_local_pose(state.pose);
+	// LOD updates restart from the pose set here
+	state.lod.sampled = false;
+}
+
 AnimationID SkeletalAnimationSystem::add_skeletal_animation(
 	const std::string& name,
 	std::vector<BoneAnimation>&& bone_animations,
@@ -439,6 +662,7 @@ AnimationID SkeletalAnimationSystem::add_skeletal_animation(
 	animation.source = std::move(source);
 	animation.rig_signature = std::move(rig_signature);
 	animation.bone_animations = std::move(bone_animations);
+	animation.clip = CompiledAnimationClip(animation.bone_animations);
 	const auto id = AnimationID::generate_new_id();
 	animations.emplace(id, std::move(animation));
 
@@ -503,11 +727,7 @@ bool SkeletalAnimationSystem::crossfade_animation(
 
 	AnimationState::Fade fade;
 	fade.duration_secs = transition_secs;
-	auto& component = get_ecs().get_skeletal_component(skeleton_id);
-	const auto& bones = component.get_bones();
-	fade.source_pose.reserve(bones.size());
-	for (const auto& bone : bones)
-		fade.source_pose.push_back(bone.relative_transform);
+	get_ecs().get_skeletal_component(skeleton_id).get_local_pose(fade.source_pose);
 
 	active_animations.insert_or_assign(skeleton_id, animation_id);
 	AnimationState state;
@@ -569,6 +789,14 @@ float SkeletalAnimationSystem::get_animation_duration(const AnimationID animatio
 	return animation_duration(animations.at(animation_id));
 }
 
+std::optional<EAnimationLod> SkeletalAnimationSystem::get_animation_lod(const SkeletonID skeleton_id) const
+{
+	const auto state = animation_states.find(skeleton_id);
+	if (state == animation_states.end())
+		return std::nullopt;
+	return state->second.lod.level;
+}
+
 std::optional<SkeletalAnimationSystem::AnimationPlayback>
 SkeletalAnimationSystem::get_animation_playback(const SkeletonID skeleton_id) const
 {
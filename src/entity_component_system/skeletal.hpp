@@ -1,9 +1,12 @@
 #pragma once
 
+#include "animation_clip.hpp"
 #include "identifications.hpp"
 #include "shared_data_structures.hpp"
 #include "maths.hpp"
 
+#include <array>
+#include <limits>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -16,6 +19,7 @@ class ECS;
 class Serializer;
 class Deserializer;
 class SceneResourceReader;
+class TaskPool;
 
 struct Bone
 {
@@ -80,6 +84,8 @@ struct SkeletalAnimation
 	std::string name;
 	std::string source;
 	SkeletalRigSignature rig_signature;
+	// bone_animations compiled for per-tick sampling
+	CompiledAnimationClip clip;
 };
 
 // A coherent render-facing copy of the game-thread-owned local pose.
@@ -94,9 +100,15 @@ struct SkeletalComponent
 {
 public:
 	SkeletalComponent() = default;
-	SkeletalComponent(const std::vector<Bone>& bones) : bones(bones) {}
-	SkeletalComponent(const SkeletalComponent& other) : bones(other.bones) {}
-	SkeletalComponent(SkeletalComponent&& other) noexcept : bones(std::move(other.bones)) {}
+	SkeletalComponent(const std::vector<Bone>& bones) : bones(bones) { cache_bone_layout(); }
+	SkeletalComponent(const SkeletalComponent& other) :
+		bones(other.bones), parent_first_order(other.parent_first_order),
+		inner_bone_mask(other.inner_bone_mask), rest_pose(other.rest_pose) {}
+	SkeletalComponent(SkeletalComponent&& other) noexcept :
+		bones(std::move(other.bones)),
+		parent_first_order(std::move(other.parent_first_order)),
+		inner_bone_mask(std::move(other.inner_bone_mask)),
+		rest_pose(std::move(other.rest_pose)) {}
 	SkeletalComponent& operator=(const SkeletalComponent&) = delete;
 	SkeletalComponent& operator=(SkeletalComponent&&) = delete;
 
@@ -111,14 +123,32 @@ public:
 		return bones.at(index).relative_transform;
 	}
 	void reset_pose();
+	// The original transforms of the bones
+	const AnimationPose& get_rest_pose() const { return rest_pose; }
+	// Bone indices with every parent before its children
+	const std::vector<uint32_t>& get_parent_first_order() const { return parent_first_order; }
+	// 1 for roots and bones with children, 0 for leaf bones
+	const std::vector<uint8_t>& get_inner_bone_mask() const { return inner_bone_mask; }
+	// Overwrites pose with the local transforms, reusing its buffers
+	void get_local_pose(AnimationPose& pose) const;
+	void set_local_pose(const AnimationPose& pose);
 	// Bone transforms after hierarchy composition, before inverse bind-pose
 	// multiplication. These are suitable for gameplay pose adjustments such as IK.
 	std::vector<glm::mat4> get_model_space_bone_transforms() const;
+	// Overwrites transforms, reusing its buffer
+	void get_model_space_bone_transforms(std::vector<glm::mat4>& transforms) const;
 	std::vector<SDS::Bone> get_bones_data() const;
 	SkeletalRenderStateSnapshot snapshot_render_state() const;
+	// Overwrites snapshot, reusing its buffers
+	void snapshot_render_state(SkeletalRenderStateSnapshot& snapshot) const;
 
 private:
+	void cache_bone_layout();
+
 	std::vector<Bone> bones;
+	std::vector<uint32_t> parent_first_order;
+	std::vector<uint8_t> inner_bone_mask;
+	AnimationPose rest_pose;
 };
 
 class SkeletalSystem
@@ -146,6 +176,12 @@ public:
 	void serialize(Serializer& out) const;
 	void deserialize(const Deserializer& in, SceneResourceReader& resources);
 	void deserialize_bone_attachments(const Deserializer& in, SceneResourceReader& resources);
+	// Used for per-skeleton work by this and SkeletalAnimationSystem;
+	// TaskPool::get_shared() unless set
+	void set_skeletal_task_pool(TaskPool& pool) { task_pool = &pool; }
+	TaskPool& get_skeletal_task_pool() const;
+
+	static constexpr size_t MIN_SKELETONS_PER_TASK = 16;
 
 protected:
 	void remove_entity(Entity id);
@@ -160,6 +196,52 @@ private:
 
 	std::unordered_map<SkeletonID, SkeletalComponent> skeletons;
 	std::unordered_map<Entity, BoneAttachment> bone_attachments;
+	TaskPool* task_pool = nullptr;
+	// Skeletons with attachments, sorted, and their model-space poses; kept
+	// between ticks to reuse their buffers
+	std::vector<SkeletonID> posed_skeletons;
+	std::vector<std::vector<glm::mat4>> model_space_poses;
+};
+
+// How often an animated skeleton is posed, from every tick to not at all
+enum class EAnimationLod
+{
+	FULL,
+	REDUCED,
+	LOW,
+	FROZEN,
+};
+
+struct AnimationLodSettings
+{
+	static constexpr size_t LEVEL_COUNT = 4;
+
+	// Off by default, posing every animated skeleton every tick
+	bool enabled = false;
+	// Camera distances beyond which skeletons drop to REDUCED, LOW and FROZEN
+	std::array<float, LEVEL_COUNT - 1> distances = { 15.0f, 40.0f, 100.0f };
+	// Ticks between the poses sampled at FULL, REDUCED and LOW
+	std::array<uint32_t, LEVEL_COUNT - 1> update_intervals = { 1, 2, 4 };
+	// Blend towards a pose sampled ahead on the ticks between samples rather
+	// than holding the last one
+	bool interpolate = true;
+	// From this LOD on leaf bones keep their rest pose
+	EAnimationLod skip_leaf_bones_from = EAnimationLod::LOW;
+	// Freeze skeletons whose renderables are all hidden
+	bool freeze_invisible = true;
+	// Skeletons due beyond this many samples in a tick wait for later ticks,
+	// the most overdue and then the nearest sampled first
+	size_t max_updates_per_tick = std::numeric_limits<size_t>::max();
+};
+
+struct AnimationLodCounters
+{
+	// Playing skeletons at each LOD in the last tick
+	std::array<size_t, AnimationLodSettings::LEVEL_COUNT> skeletons{};
+	size_t sampled = 0;
+	size_t interpolated = 0;
+	// Due skeletons left for later ticks by max_updates_per_tick
+	size_t deferred = 0;
 };
 
 class SkeletalAnimationSystem
@@ -204,26 +286,72 @@ public:
 	void serialize(Serializer& out) const;
 	void deserialize(const Deserializer& in, SceneResourceReader& resources);
 
+	// A skeleton's LOD follows the nearest visible renderable skinned by it;
+	// skeletons without renderables are posed at FULL
+	void set_animation_lod_settings(const AnimationLodSettings& settings) { lod_settings = settings; }
+	const AnimationLodSettings& get_animation_lod_settings() const { return lod_settings; }
+	// Where LOD distances are measured from, usually the camera, for the next tick
+	void set_animation_lod_viewpoint(const glm::vec3& viewpoint) { lod_viewpoint = viewpoint; }
+	std::optional<EAnimationLod> get_animation_lod(SkeletonID skeleton_id) const;
+	const AnimationLodCounters& get_animation_lod_counters() const { return lod_counters; }
+
 private:
 	struct AnimationState
 	{
 		struct Fade
 		{
-			std::vector<Maths::Transform> source_pose;
+			AnimationPose source_pose;
 			float elapsed_secs = 0.0f;
 			float duration_secs = 0.0f;
 		};
 
+		struct Lod
+		{
+			enum class Action
+			{
+				SAMPLE,
+				BLEND,
+			};
+
+			EAnimationLod level = EAnimationLod::FULL;
+			float distance = 0.0f;
+			bool referenced = false;
+			Action action = Action::SAMPLE;
+			// Whether pose holds a sample to keep blending towards
+			bool sampled = false;
+			bool interpolated = false;
+			uint32_t interval = 1;
+			uint32_t ticks_since_sample = 0;
+			// The pose shown when pose was sampled, and the blend of the two
+			AnimationPose from;
+			AnimationPose blended;
+		};
+
 		bool should_loop = false;
 		bool paused = false;
 		float playback_speed = DEFAULT_PLAYBACK_SPEED;
 		float current_animation_elapsed_secs = 0.0f;
 		std::optional<Fade> fade;
+		AnimationCursor cursor;
+		// Scratch for the sampled pose, kept to avoid allocating every tick.
+		// Sampled ahead of the playback time while interpolating.
+		AnimationPose pose;
+		Lod lod;
 	};
 
 	void apply_animation_pose(SkeletonID skeleton_id);
+	void sample_animation_pose(SkeletonID skeleton_id, float lookahead_secs, bool skip_leaf_bones);
+	void update_animation_pose(SkeletonID skeleton_id, float delta_secs);
+	void update_animation_lods();
+	uint32_t get_lod_update_interval(EAnimationLod level) const;
 
 	std::unordered_map<AnimationID, SkeletalAnimation> animations;
 	std::unordered_map<SkeletonID, AnimationID> active_animations;
 	std::unordered_map<SkeletonID, AnimationState> animation_states;
+	AnimationLodSettings lod_settings;
+	glm::vec3 lod_viewpoint{ 0.0f };
+	AnimationLodCounters lod_counters;
+	// Skeletons posed and skeletons due a sample in the current tick
+	std::vector<SkeletonID> posing_skeletons;
+	std::vector<SkeletonID> due_skeletons;
 };
@@ -354,6 +354,7 @@ void SkeletalAnimationSystem::deserialize(const Deserializer& in, SceneResourceR
 			bone.scale_track = read_track<glm::vec3>(bone_in, "scale_track", Serialization::read_vec3);
 			animation.bone_animations.push_back(std::move(bone));
 		}
+		animation.clip = CompiledAnimationClip(animation.bone_animations);
 		if (!restored_animations.emplace(id, std::move(animation)).second)
 			throw SerializationError("Duplicate animation ID at $.skeletal_animation_system.animations["
 				+ std::to_string(index) + "].animation_id");
@@ -99,6 +99,11 @@ void TransformationComponent::set_rotation(const glm::quat& rotation)
 	owner->set_rotation(get_entity_id(), rotation);
 }
 
+void TransformationComponent::set_pose(const glm::vec3& position, const glm::quat& rotation)
+{
+	owner->set_pose(get_entity_id(), position, rotation);
+}
+
 void TransformationComponent::set_relative_transform(const glm::mat4& transform)
 {
 	owner->set_relative_transform(get_entity_id(), transform);
@@ -142,10 +147,9 @@ void TransformationComponent::detach_all_children()
 	owner->detach_all_children(get_entity_id());
 }
 
-TransformationSystem::TransformationSystem(TransformationSystem&& other) noexcept :
-	components(std::move(other.components))
+TransformationSystem::TransformationSystem(TransformationSystem&& other) noexcept
 {
-	rebind_components();
+	*this = std::move(other);
 }
 
 TransformationSystem& TransformationSystem::operator=(TransformationSystem&& other) noexcept
@@ -153,6 +157,18 @@ TransformationSystem& TransformationSystem::operator=(TransformationSystem&& oth
 	if (this == &other)
 		return *this;
 	components = std::move(other.components);
+	slot_entities = std::move(other.slot_entities);
+	local_transforms = std::move(other.local_transforms);
+	world_transforms = std::move(other.world_transforms);
+	world_dirty = std::move(other.world_dirty);
+	parent_slots = std::move(other.parent_slots);
+	first_child_slots = std::move(other.first_child_slots);
+	next_sibling_slots = std::move(other.next_sibling_slots);
+	previous_sibling_slots = std::move(other.previous_sibling_slots);
+	free_slots = std::move(other.free_slots);
+	update_order = std::move(other.update_order);
+	update_order_stale = other.update_order_stale;
+	has_dirty_world = other.has_dirty_world;
 	rebind_components();
 	return *this;
 }
@@ -167,12 +183,84 @@ void TransformationSystem::add_transformation(
 	const EntityID id,
 	const TransformationPersistence persistence)
 {
+	if (components.contains(id))
+		return;
+	const uint32_t slot = allocate_slot(id);
 	components.try_emplace(
 		id,
 		TransformationComponent::ConstructionKey{},
 		*this,
 		id,
-		persistence);
+		persistence,
+		slot);
+}
+
+uint32_t TransformationSystem::allocate_slot(const EntityID id)
+{
+	uint32_t slot;
+	if (free_slots.empty())
+	{
+		slot = static_cast<uint32_t>(slot_entities.size());
+		slot_entities.push_back(id);
+		local_transforms.emplace_back();
+		world_transforms.emplace_back();
+		world_dirty.push_back(0);
+		parent_slots.push_back(NULL_SLOT);
+		first_child_slots.push_back(NULL_SLOT);
+		next_sibling_slots.push_back(NULL_SLOT);
+		previous_sibling_slots.push_back(NULL_SLOT);
+	}
+	else
+	{
+		slot = free_slots.back();
+		free_slots.pop_back();
+		slot_entities[slot] = id;
+	}
+	// a new root may be appended without breaking the parent-first order
+	if (!update_order_stale)
+		update_order.push_back(slot);
+	return slot;
+}
+
+void TransformationSystem::free_slot(const uint32_t slot)
+{
+	local_transforms[slot] = Maths::Transform();
+	world_transforms[slot] = Maths::Transform();
+	world_dirty[slot] = 0;
+	parent_slots[slot] = NULL_SLOT;
+	first_child_slots[slot] = NULL_SLOT;
+	next_sibling_slots[slot] = NULL_SLOT;
+	previous_sibling_slots[slot] = NULL_SLOT;
+	free_slots.push_back(slot);
+	update_order_stale = true;
+}
+
+void TransformationSystem::link_child(const uint32_t parent, const uint32_t child)
+{
+	parent_slots[child] = parent;
+	previous_sibling_slots[child] = NULL_SLOT;
+	next_sibling_slots[child] = first_child_slots[parent];
+	if (first_child_slots[parent] != NULL_SLOT)
+		previous_sibling_slots[first_child_slots[parent]] = child;
+	first_child_slots[parent] = child;
+	// the child may precede its new parent in the update order
+	update_order_stale = true;
+}
+
+void TransformationSystem::unlink_child(const uint32_t child)
+{
+	const uint32_t parent = parent_slots[child];
+	const uint32_t previous = previous_sibling_slots[child];
+	const uint32_t next = next_sibling_slots[child];
+	if (previous != NULL_SLOT)
+		next_sibling_slots[previous] = next;
+	else
+		first_child_slots[parent] = next;
+	if (next != NULL_SLOT)
+		previous_sibling_slots[next] = previous;
+	parent_slots[child] = NULL_SLOT;
+	previous_sibling_slots[child] = NULL_SLOT;
+	next_sibling_slots[child] = NULL_SLOT;
 }
 
 TransformationComponent& TransformationSystem::get_transformation(const EntityID id)
@@ -201,190 +289,322 @@ const TransformationComponent& TransformationSystem::component(const EntityID id
 	return found->second;
 }
 
-const Maths::Transform& TransformationSystem::synced_world_transform(const EntityID id) const
+// Requires the parent's world transform to be up to date
+void TransformationSystem::compose_world_transform(const uint32_t slot) const
 {
-	auto& transform = components.at(id);
-	if (!transform.world_dirty)
-		return transform.world_transform;
-
-	if (transform.parent)
-		transform.world_transform.set_mat4(
-			synced_world_transform(*transform.parent).get_mat4()
-			* transform.local_transform.get_mat4());
+	const uint32_t parent = parent_slots[slot];
+	if (parent != NULL_SLOT)
+		world_transforms[slot].set_mat4(
+			world_transforms[parent].get_mat4() * local_transforms[slot].get_mat4());
 	else
-		transform.world_transform = transform.local_transform;
-	transform.world_dirty = false;
-	return transform.world_transform;
+		world_transforms[slot] = local_transforms[slot];
+	world_dirty[slot] = 0;
+}
+
+const Maths::Transform& TransformationSystem::synced_world_transform(const uint32_t slot) const
+{
+	if (!world_dirty[slot])
+		return world_transforms[slot];
+
+	// stale ancestors form a contiguous chain upwards from this slot
+	scratch_slots.clear();
+	for (uint32_t current = slot; current != NULL_SLOT && world_dirty[current]; current = parent_slots[current])
+		scratch_slots.push_back(current);
+	for (auto it = scratch_slots.rbegin(); it != scratch_slots.rend(); ++it)
+		compose_world_transform(*it);
+	return world_transforms[slot];
+}
+
+void TransformationSystem::rebuild_update_order() const
+{
+	update_order.clear();
+	update_order.reserve(components.size());
+	for (const auto& transform : components | std::views::values)
+		if (parent_slots[transform.slot] == NULL_SLOT)
+			update_order.push_back(transform.slot);
+	// breadth-first expansion keeps every parent ahead of its children
+	for (size_t index = 0; index < update_order.size(); ++index)
+		for (uint32_t child = first_child_slots[update_order[index]]; child != NULL_SLOT;
+			child = next_sibling_slots[child])
+			update_order.push_back(child);
+	update_order_stale = false;
+}
+
+void TransformationSystem::update_world_transforms() const
+{
+	if (!has_dirty_world)
+		return;
+	if (update_order_stale)
+		rebuild_update_order();
+	for (const uint32_t slot : update_order)
+		if (world_dirty[slot])
+			compose_world_transform(slot);
+	has_dirty_world = false;
 }
 
-void TransformationSystem::invalidate(const EntityID id)
+void TransformationSystem::invalidate(const uint32_t slot)
 {
-	auto& transform = component(id);
-	transform.world_dirty = true;
-	for (const auto child : transform.children)
-		invalidate(child);
+	world_dirty[slot] = 1;
+	has_dirty_world = true;
+	on_world_transform_changed(slot_entities[slot]);
+	invalidate_children(slot);
 }
 
-void TransformationSystem::invalidate_children(const EntityID id)
+void TransformationSystem::invalidate_children(const uint32_t slot)
 {
-	for (const auto child : component(id).children)
-		invalidate(child);
+	// change callbacks may set transforms and so walk on top of this one
+	const size_t base = invalidation_stack.size();
+	for (uint32_t child = first_child_slots[slot]; child != NULL_SLOT; child = next_sibling_slots[child])
+		invalidation_stack.push_back(child);
+	while (invalidation_stack.size() > base)
+	{
+		const uint32_t current = invalidation_stack.back();
+		invalidation_stack.pop_back();
+		// an already stale subtree has been invalidated and reported since it
+		// was last synchronised
+		if (world_dirty[current])
+			continue;
+		world_dirty[current] = 1;
+		has_dirty_world = true;
+		on_world_transform_changed(slot_entities[current]);
+		for (uint32_t child = first_child_slots[current]; child != NULL_SLOT; child = next_sibling_slots[child])
+			invalidation_stack.push_back(child);
+	}
 }
 
 Maths::Transform TransformationSystem::get_maths_transform(const EntityID id) const
 {
-	component(id);
-	return synced_world_transform(id);
+	return synced_world_transform(component(id).slot);
 }
 
 glm::mat4 TransformationSystem::get_transform(const EntityID id) const
 {
-	component(id);
-	return synced_world_transform(id).get_mat4();
+	return synced_world_transform(component(id).slot).get_mat4();
 }
 
 glm::vec3 TransformationSystem::get_position(const EntityID id) const
 {
-	component(id);
-	return synced_world_transform(id).get_pos();
+	return synced_world_transform(component(id).slot).get_pos();
 }
 
 glm::vec3 TransformationSystem::get_scale(const EntityID id) const
 {
-	component(id);
-	return synced_world_transform(id).get_scale();
+	return synced_world_transform(component(id).slot).get_scale();
 }
 
 glm::quat TransformationSystem::get_rotation(const EntityID id) const
 {
-	component(id);
-	return synced_world_transform(id).get_orient();
+	return synced_world_transform(component(id).slot).get_orient();
 }
 
 void TransformationSystem::set_transform(const EntityID id, const glm::mat4& value)
 {
-	auto& transform = component(id);
-	transform.world_transform.set_mat4(value);
-	transform.local_transform.set_mat4(transform.parent
-		? glm::inverse(get_transform(*transform.parent)) * value
+	const uint32_t slot = component(id).slot;
+	const uint32_t parent = parent_slots[slot];
+	// synchronising the parent also leaves every ancestor up to date
+	local_transforms[slot].set_mat4(parent != NULL_SLOT
+		? glm::inverse(synced_world_transform(parent).get_mat4()) * value
 		: value);
-	transform.world_dirty = false;
-	invalidate_children(id);
+	world_transforms[slot].set_mat4(value);
+	world_dirty[slot] = 0;
+	on_world_transform_changed(id);
+	invalidate_children(slot);
+}
+
+// Changing only the world translation leaves the local rotation and scale
+// untouched, so just the local translation needs solving for
+void TransformationSystem::set_world_position(const uint32_t slot, const glm::vec3& value)
+{
+	// synchronising the entity also leaves every ancestor up to date
+	synced_world_transform(slot);
+	const uint32_t parent = parent_slots[slot];
+	local_transforms[slot].set_pos(parent != NULL_SLOT
+		? glm::vec3(glm::inverse(world_transforms[parent].get_mat4()) * glm::vec4(value, 1.0f))
+		: value);
+	world_transforms[slot].set_pos(value);
+}
+
+void TransformationSystem::set_world_pose(const uint32_t slot, const glm::vec3& position, const glm::quat& rotation)
+{
+	synced_world_transform(slot);
+	const uint32_t parent = parent_slots[slot];
+	if (parent == NULL_SLOT)
+	{
+		// a root's local transform is its world transform
+		local_transforms[slot].set_orient(rotation);
+		local_transforms[slot].set_pos(position);
+		world_transforms[slot] = local_transforms[slot];
+		return;
+	}
+	Maths::Transform& world = world_transforms[slot];
+	world.set_orient(rotation);
+	world.set_pos(position);
+	local_transforms[slot].set_mat4(glm::inverse(world_transforms[parent].get_mat4()) * world.get_mat4());
 }
 
 void TransformationSystem::set_position(const EntityID id, const glm::vec3& value)
 {
-	auto world = get_maths_transform(id);
-	world.set_pos(value);
-	set_transform(id, world.get_mat4());
+	const uint32_t slot = component(id).slot;
+	set_world_position(slot, value);
+	on_world_transform_changed(id);
+	invalidate_children(slot);
 }
 
 void TransformationSystem::set_scale(const EntityID id, const glm::vec3& value)
 {
-	auto world = get_maths_transform(id);
+	const uint32_t slot = component(id).slot;
+	if (parent_slots[slot] == NULL_SLOT)
+	{
+		set_relative_scale(id, value);
+		return;
+	}
+	auto world = synced_world_transform(slot);
 	world.set_scale(value);
 	set_transform(id, world.get_mat4());
 }
 
 void TransformationSystem::set_rotation(const EntityID id, const glm::quat& value)
 {
-	auto world = get_maths_transform(id);
+	const uint32_t slot = component(id).slot;
+	if (parent_slots[slot] == NULL_SLOT)
+	{
+		set_relative_rotation(id, value);
+		return;
+	}
+	auto world = synced_world_transform(slot);
 	world.set_orient(value);
 	set_transform(id, world.get_mat4());
 }
 
+void TransformationSystem::set_pose(const EntityID id, const glm::vec3& position, const glm::quat& rotation)
+{
+	const uint32_t slot = component(id).slot;
+	set_world_pose(slot, position, rotation);
+	on_world_transform_changed(id);
+	invalidate_children(slot);
+}
+
+void TransformationSystem::set_positions(
+	const std::span<const EntityID> ids,
+	const std::span<const glm::vec3> positions)
+{
+	if (ids.size() != positions.size())
+		throw std::invalid_argument("TransformationSystem::set_positions: mismatched span sizes");
+	for (size_t index = 0; index < ids.size(); ++index)
+		set_position(ids[index], positions[index]);
+}
+
+void TransformationSystem::set_poses(
+	const std::span<const EntityID> ids,
+	const std::span<const glm::vec3> positions,
+	const std::span<const glm::quat> rotations)
+{
+	if (ids.size() != positions.size() || ids.size() != rotations.size())
+		throw std::invalid_argument("TransformationSystem::set_poses: mismatched span sizes");
+	for (size_t index = 0; index < ids.size(); ++index)
+		set_pose(ids[index], positions[index], rotations[index]);
+}
+
 glm::mat4 TransformationSystem::get_relative_transform(const EntityID id) const
 {
-	return component(id).local_transform.get_mat4();
+	return local_transforms[component(id).slot].get_mat4();
 }
 
 glm::vec3 TransformationSystem::get_relative_position(const EntityID id) const
 {
-	return component(id).local_transform.get_pos();
+	return local_transforms[component(id).slot].get_pos();
 }
 
 glm::vec3 TransformationSystem::get_relative_scale(const EntityID id) const
 {
-	return component(id).local_transform.get_scale();
+	return local_transforms[component(id).slot].get_scale();
 }
 
 glm::quat TransformationSystem::get_relative_rotation(const EntityID id) const
 {
-	return component(id).local_transform.get_orient();
+	return local_transforms[component(id).slot].get_orient();
 }
 
 void TransformationSystem::set_relative_transform(const EntityID id, const glm::mat4& value)
 {
-	component(id).local_transform.set_mat4(value);
-	invalidate(id);
+	const uint32_t slot = component(id).slot;
+	local_transforms[slot].set_mat4(value);
+	invalidate(slot);
 }
 
 void TransformationSystem::set_relative_position(const EntityID id, const glm::vec3& value)
 {
-	component(id).local_transform.set_pos(value);
-	invalidate(id);
+	const uint32_t slot = component(id).slot;
+	local_transforms[slot].set_pos(value);
+	invalidate(slot);
 }
 
 void TransformationSystem::set_relative_scale(const EntityID id, const glm::vec3& value)
 {
-	component(id).local_transform.set_scale(value);
-	invalidate(id);
+	const uint32_t slot = component(id).slot;
+	local_transforms[slot].set_scale(value);
+	invalidate(slot);
 }
 
 void TransformationSystem::set_relative_rotation(const EntityID id, const glm::quat& value)
 {
-	component(id).local_transform.set_orient(value);
-	invalidate(id);
+	const uint32_t slot = component(id).slot;
+	local_transforms[slot].set_orient(value);
+	invalidate(slot);
 }
 
 bool TransformationSystem::attach_to(const EntityID child, const EntityID parent)
 {
-	auto& child_transform = component(child);
-	component(parent);
+	const uint32_t child_slot = component(child).slot;
+	const uint32_t parent_slot = component(parent).slot;
 	if (child == parent)
 		return false;
-	for (auto ancestor = std::optional<EntityID>(parent); ancestor;
-		ancestor = component(*ancestor).parent)
-		if (*ancestor == child)
+	for (uint32_t ancestor = parent_slot; ancestor != NULL_SLOT; ancestor = parent_slots[ancestor])
+		if (ancestor == child_slot)
 			return false;
-	if (child_transform.parent == parent)
+	if (parent_slots[child_slot] == parent_slot)
 		return true;
 
-	const auto world = get_transform(child);
-	if (child_transform.parent)
-		component(*child_transform.parent).children.erase(child);
-	child_transform.parent = parent;
-	component(parent).children.insert(child);
-	child_transform.local_transform.set_mat4(glm::inverse(get_transform(parent)) * world);
-	child_transform.world_transform.set_mat4(world);
-	child_transform.world_dirty = false;
+	const glm::mat4 world = synced_world_transform(child_slot).get_mat4();
+	const glm::mat4 parent_world = synced_world_transform(parent_slot).get_mat4();
+	if (parent_slots[child_slot] != NULL_SLOT)
+		unlink_child(child_slot);
+	link_child(parent_slot, child_slot);
+	local_transforms[child_slot].set_mat4(glm::inverse(parent_world) * world);
+	world_transforms[child_slot].set_mat4(world);
+	world_dirty[child_slot] = 0;
 	return true;
 }
 
 bool TransformationSystem::detach_from(const EntityID child)
 {
-	auto& child_transform = component(child);
-	if (!child_transform.parent)
+	const uint32_t child_slot = component(child).slot;
+	if (parent_slots[child_slot] == NULL_SLOT)
 		return false;
-	const auto world = get_transform(child);
-	component(*child_transform.parent).children.erase(child);
-	child_transform.parent.reset();
-	child_transform.local_transform.set_mat4(world);
-	child_transform.world_transform.set_mat4(world);
-	child_transform.world_dirty = false;
+	const glm::mat4 world = synced_world_transform(child_slot).get_mat4();
+	unlink_child(child_slot);
+	local_transforms[child_slot].set_mat4(world);
+	world_transforms[child_slot].set_mat4(world);
+	world_dirty[child_slot] = 0;
 	return true;
 }
 
 void TransformationSystem::detach_all_children(const EntityID parent)
 {
-	auto children = component(parent).children;
+	const uint32_t parent_slot = component(parent).slot;
+	std::vector<EntityID> children;
+	for (uint32_t child = first_child_slots[parent_slot]; child != NULL_SLOT; child = next_sibling_slots[child])
+		children.push_back(slot_entities[child]);
 	for (const auto child : children)
 		detach_from(child);
 }
 
 std::optional<EntityID> TransformationSystem::get_parent_id(const EntityID child) const
 {
-	return component(child).parent;
+	const uint32_t parent = parent_slots[component(child).slot];
+	if (parent == NULL_SLOT)
+		return std::nullopt;
+	return slot_entities[parent];
 }
 
 void TransformationSystem::remove_transformation(const EntityID id)
@@ -393,6 +613,7 @@ void TransformationSystem::remove_transformation(const EntityID id)
 		return;
 	detach_all_children(id);
 	detach_from(id);
+	free_slot(component(id).slot);
 	components.erase(id);
 }
 
@@ -408,26 +629,33 @@ void TransformationSystem::serialize(Serializer& out) const
 	for (std::size_t index = 0; index < ids.size(); ++index)
 	{
 		const auto id = ids[index];
-		const auto& transform = component(id);
+		const uint32_t slot = component(id).slot;
 		auto entry = serialized.append_map();
 		entry.write("entity_id", id.get_underlying());
-		if (transform.parent)
+		if (const auto parent = get_parent_id(id))
 		{
-			if (component(*transform.parent).persistence != TransformationPersistence::Persistent)
+			if (component(*parent).persistence != TransformationPersistence::Persistent)
 				throw SerializationError(
 					"Persistent transformation has a transient parent at "
 					+ transformation_path(index, "parent_id"));
-			entry.write("parent_id", transform.parent->get_underlying());
+			entry.write("parent_id", parent->get_underlying());
 		}
 		else
 			entry.write_null("parent_id");
-		Serialization::write_transform(entry, "local_transform", transform.local_transform);
+		Serialization::write_transform(entry, "local_transform", local_transforms[slot]);
 	}
 }
 
 void TransformationSystem::deserialize(const Deserializer& in)
 {
 	TransformationSystem restored;
+	struct ParentLink
+	{
+		std::size_t index;
+		EntityID child;
+		EntityID parent;
+	};
+	std::vector<ParentLink> parents;
 	const auto entries = in.child("transformation_system").elements();
 	for (std::size_t index = 0; index < entries.size(); ++index)
 	{
@@ -438,35 +666,34 @@ void TransformationSystem::deserialize(const Deserializer& in)
 				"Duplicate transformation entity at "
 				+ transformation_path(index, "entity_id"));
 		restored.add_transformation(id);
-		auto& transform = restored.component(id);
-		transform.local_transform = Serialization::read_transform(entry, "local_transform");
-		transform.world_transform = transform.local_transform;
+		const uint32_t slot = restored.component(id).slot;
+		restored.local_transforms[slot] = Serialization::read_transform(entry, "local_transform");
+		restored.world_transforms[slot] = restored.local_transforms[slot];
 		const auto parent = entry.child("parent_id");
 		if (parent.kind() != SerializationKind::Null)
-			transform.parent = EntityID(parent.as<std::uint64_t>());
+			parents.push_back({ index, id, EntityID(parent.as<std::uint64_t>()) });
 	}
 
-	for (std::size_t index = 0; index < entries.size(); ++index)
+	for (const auto& [index, id, parent] : parents)
 	{
-		const EntityID id(entries[index].read<std::uint64_t>("entity_id"));
-		auto& transform = restored.component(id);
-		if (!transform.parent)
-			continue;
-		if (!restored.components.contains(*transform.parent))
+		if (!restored.components.contains(parent))
 			throw SerializationError(
 				"Missing transformation parent at "
 				+ transformation_path(index, "parent_id"));
-		restored.component(*transform.parent).children.insert(id);
-		transform.world_dirty = true;
+		const uint32_t slot = restored.component(id).slot;
+		restored.link_child(restored.component(parent).slot, slot);
+		restored.world_dirty[slot] = 1;
+		restored.has_dirty_world = true;
 	}
 
 	for (std::size_t index = 0; index < entries.size(); ++index)
 	{
 		const EntityID id(entries[index].read<std::uint64_t>("entity_id"));
-		std::unordered_set<EntityID> visited;
-		for (auto current = std::optional<EntityID>(id); current;
-			current = restored.component(*current).parent)
-			if (!visited.insert(*current).second)
+		// a chain longer than the number of transformations must revisit one
+		std::size_t steps = 0;
+		for (uint32_t current = restored.component(id).slot; current != NULL_SLOT;
+			current = restored.parent_slots[current])
+			if (++steps > restored.components.size())
 				throw SerializationError(
 					"Cyclic transformation hierarchy at "
 					+ transformation_path(index, "parent_id"));
@@ -480,13 +707,14 @@ void TransformationSystem::deserialize(const Deserializer& in)
 				"Persistent transformation conflicts with transient entity "
 				+ std::to_string(id.get_underlying()));
 		transients.add_transformation(id, transform.persistence);
-		auto& destination = transients.component(id);
-		destination.local_transform = transform.local_transform;
-		destination.world_transform = transform.world_transform;
-		destination.parent = transform.parent;
-		destination.children = transform.children;
-		destination.world_dirty = transform.world_dirty;
+		const uint32_t slot = transients.component(id).slot;
+		transients.local_transforms[slot] = restored.local_transforms[transform.slot];
+		transients.world_transforms[slot] = restored.world_transforms[transform.slot];
+		transients.world_dirty[slot] = restored.world_dirty[transform.slot];
 	}
+	for (const auto& [index, id, parent] : parents)
+		transients.link_child(transients.component(parent).slot, transients.component(id).slot);
+	transients.has_dirty_world = transients.has_dirty_world || restored.has_dirty_world;
 	*this = std::move(transients);
 }
 
@@ -498,23 +726,21 @@ TransformationSystem TransformationSystem::snapshot_transient_transformations()
 		if (transform.persistence != TransformationPersistence::Transient)
 			continue;
 		result.add_transformation(id, TransformationPersistence::Transient);
-		auto& copy = result.component(id);
-		copy.local_transform = transform.local_transform;
-		copy.world_transform = synced_world_transform(id);
-		copy.parent = transform.parent;
-		copy.world_dirty = transform.world_dirty;
+		const uint32_t slot = result.component(id).slot;
+		result.local_transforms[slot] = local_transforms[transform.slot];
+		result.world_transforms[slot] = synced_world_transform(transform.slot);
 	}
-	for (auto& [id, transform] : result.components)
+	for (const auto& [id, transform] : result.components)
 	{
-		if (!transform.parent || !result.components.contains(*transform.parent))
+		const auto parent = get_parent_id(id);
+		if (!parent || !result.components.contains(*parent))
 		{
-			transform.parent.reset();
-			transform.local_transform = transform.world_transform;
-			transform.world_dirty = false;
+			result.local_transforms[transform.slot] = result.world_transforms[transform.slot];
 			continue;
 		}
-		result.component(*transform.parent).children.insert(id);
-		transform.world_dirty = true;
+		result.link_child(result.component(*parent).slot, transform.slot);
+		result.world_dirty[transform.slot] = 1;
+		result.has_dirty_world = true;
 	}
 	return result;
 }
@@ -6,9 +6,12 @@
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <cstdint>
+#include <limits>
 #include <optional>
+#include <span>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 
 class Serializer;
@@ -38,10 +41,12 @@ public:
 		const ConstructionKey&,
 		TransformationSystem& owner,
 		EntityID entity_id,
-		TransformationPersistence persistence) :
+		TransformationPersistence persistence,
+		uint32_t slot) :
 		owner(&owner),
 		entity_id(entity_id),
-		persistence(persistence)
+		persistence(persistence),
+		slot(slot)
 	{}
 
 	EntityID get_entity_id() const { return entity_id; }
@@ -63,6 +68,7 @@ public:
 	void set_scale(float uniform_scale);
 	void set_scale(const glm::vec3& scale);
 	void set_rotation(const glm::quat& rotation);
+	void set_pose(const glm::vec3& position, const glm::quat& rotation);
 
 	void set_relative_transform(const glm::mat4& transform);
 	void set_relative_position(const glm::vec3& position);
@@ -79,12 +85,9 @@ private:
 
 	TransformationSystem* owner;
 	EntityID entity_id;
-	Maths::Transform local_transform;
-	mutable Maths::Transform world_transform;
-	std::optional<EntityID> parent;
-	std::unordered_set<EntityID> children;
-	mutable bool world_dirty = false;
 	TransformationPersistence persistence;
+	// Index into the owning system's dense transform storage
+	uint32_t slot;
 };
 
 class TransformationSystem
@@ -119,6 +122,15 @@ public:
 	void set_scale(EntityID id, float uniform_scale) { set_scale(id, glm::vec3(uniform_scale)); }
 	void set_scale(EntityID id, const glm::vec3& scale);
 	void set_rotation(EntityID id, const glm::quat& rotation);
+	// Sets world position and rotation together, keeping the world scale
+	void set_pose(EntityID id, const glm::vec3& position, const glm::quat& rotation);
+	// Batched forms for moving many entities at once, e.g. syncing physics
+	// bodies. Each span must have one element per id.
+	void set_positions(std::span<const EntityID> ids, std::span<const glm::vec3> positions);
+	void set_poses(
+		std::span<const EntityID> ids,
+		std::span<const glm::vec3> positions,
+		std::span<const glm::quat> rotations);
 
 	glm::mat4 get_relative_transform(EntityID id) const;
 	glm::vec3 get_relative_position(EntityID id) const;
@@ -140,14 +152,59 @@ public:
 
 	TransformationSystem take_transient_transformations() const;
 
+	// Recomputes every stale world transform in one parent-before-child sweep.
+	// Reads are correct without it, but running it ahead of bulk reads such as
+	// building a render frame turns each of them into an array lookup.
+	void update_world_transforms() const;
+
+protected:
+	// Invoked when an entity's world transform changes, including changes
+	// inherited from an ancestor. Bulk replacement through deserialize and move
+	// assignment does not invoke it.
+	virtual void on_world_transform_changed(EntityID id) {}
+
 private:
+	static constexpr uint32_t NULL_SLOT = std::numeric_limits<uint32_t>::max();
+
 	TransformationComponent& component(EntityID id);
 	const TransformationComponent& component(EntityID id) const;
-	const Maths::Transform& synced_world_transform(EntityID id) const;
-	void invalidate(EntityID id);
-	void invalidate_children(EntityID id);
+	uint32_t allocate_slot(EntityID id);
+	void free_slot(uint32_t slot);
+	void link_child(uint32_t parent, uint32_t child);
+	void unlink_child(uint32_t child);
+	void rebuild_update_order() const;
+	void compose_world_transform(uint32_t slot) const;
+	const Maths::Transform& synced_world_transform(uint32_t slot) const;
+	void set_world_position(uint32_t slot, const glm::vec3& position);
+	void set_world_pose(uint32_t slot, const glm::vec3& position, const glm::quat& rotation);
+	void invalidate(uint32_t slot);
+	void invalidate_children(uint32_t slot);
 	void rebind_components();
 	TransformationSystem snapshot_transient_transformations() const;
 
 	std::unordered_map<EntityID, TransformationComponent> components;
+
+	// Dense storage indexed by slot. A slot is stable for its entity's lifetime
+	// and reused after removal. Children form an intrusive doubly linked list so
+	// that hierarchy walks never hash. A stale world transform implies stale
+	// world transforms throughout its subtree.
+	std::vector<EntityID> slot_entities;
+	std::vector<Maths::Transform> local_transforms;
+	mutable std::vector<Maths::Transform> world_transforms;
+	mutable std::vector<uint8_t> world_dirty;
+	std::vector<uint32_t> parent_slots;
+	std::vector<uint32_t> first_child_slots;
+	std::vector<uint32_t> next_sibling_slots;
+	std::vector<uint32_t> previous_sibling_slots;
+	std::vector<uint32_t> free_slots;
+
+	// Live slots with every parent ahead of its children; rebuilt after
+	// attachments or removals invalidate it
+	mutable std::vector<uint32_t> update_order;
+	mutable bool update_order_stale = false;
+	mutable bool has_dirty_world = false;
+	mutable std::vector<uint32_t> scratch_slots;
+	// Subtree walk of invalidate_children, kept apart from scratch_slots as
+	// change callbacks may read transforms mid-walk
+	std::vector<uint32_t> invalidation_stack;
 };
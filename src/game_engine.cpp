@@ -23,6 +23,8 @@
 #include "serialization/resource_provenance.hpp"
 #include "serialization/scene_resources.hpp"
 #include "save_file_store.hpp"
+#include "resource_loader/derived_data_cache.hpp"
+#include "config.hpp"
 #include "constants.hpp"
 
 #include <glm/glm.hpp>
@@ -34,6 +36,7 @@
 #include <iostream>
 #include <ranges>
 #include <fstream>
+#include <span>
 #include <sstream>
 #include <vector>
 #include <thread>
@@ -61,6 +64,9 @@ GameEngine::GameEngine(std::unique_ptr<App::Window> win,
 
 void GameEngine::init()
 {
+	if (Config::is_derived_data_cache_enabled())
+		ResourceLoader::set_derived_data_cache(
+			std::make_shared<DerivedDataCache>(Utility::get_derived_data_path()));
 	graphics_engine->bind_resource_systems(
 		ecs.get_mesh_system(), ecs.get_material_system());
 	graphics_engine->set_application_ui_manager(&application_ui_manager);
@@ -270,6 +276,7 @@ void GameEngine::main_loop(const float time_delta)
 			camera->update_follow();
 		}
 		application->on_pre_tick(*this, time_delta);
+		ecs.set_animation_lod_viewpoint(camera->get_position());
 		ecs.process(time_delta);
 		experimental->process(time_delta);
 		application->on_tick(*this, time_delta);
@@ -407,8 +414,9 @@ void GameEngine::spawn_cubemap(
 	renderable.mesh_owner = std::move(mesh_owner);
 	for (const auto texture_name : { "right", "left", "top", "bottom", "front", "back" })
 	{
+		// environment lighting filters the faces on the CPU from their RGBA8 pixels
 		renderable.material_owners.push_back(ResourceLoader::fetch_texture(ecs.get_material_system(),
-			fmt::format("skybox/{}.jpg", texture_name)));
+			fmt::format("skybox/{}.jpg", texture_name), ETextureSemantic::BASE_COLOR, ETextureProcessing::NONE));
 	}
 	auto& object = spawn_object<Object>();
 	attach_renderable(object.get_id(), std::move(renderable));
@@ -709,7 +717,7 @@ Maths::Ray GameEngine::get_mouse_ray() const
 
 Gizmo& GameEngine::get_gizmo() { return *gizmo; }
 
-void GameEngine::save_scene(const std::string_view save_name) const
+void GameEngine::save_scene(const std::string_view save_name, const SerializationFormat format) const
 {
 	const auto path = SaveFileStore(Utility::get_saves_path()).path_for_overwrite(save_name);
 	std::filesystem::create_directories(path.parent_path());
@@ -749,16 +757,24 @@ void GameEngine::save_scene(const std::string_view save_name) const
 		auto saved_ecs = document.map("ecs");
 		ecs.serialize(saved_ecs, resources);
 
-		const auto temporary = staging / "scene.yaml.tmp";
+		const std::string scene_file(format == SerializationFormat::Binary
+			? SaveFileStore::BINARY_SCENE_FILE : SaveFileStore::YAML_SCENE_FILE);
+		const auto temporary = staging / (scene_file + ".tmp");
 		{
 			std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
 			if (!stream)
 				throw SerializationError("Unable to open scene temporary file: " + temporary.string());
-			stream << document.emit();
+			if (format == SerializationFormat::Binary)
+			{
+				const auto bytes = document.emit_binary();
+				stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			}
+			else
+				stream << document.emit();
 			if (!stream)
 				throw SerializationError("Unable to write scene temporary file: " + temporary.string());
 		}
-		std::filesystem::rename(temporary, staging / "scene.yaml");
+		std::filesystem::rename(temporary, staging / scene_file);
 		if (std::filesystem::exists(path))
 			std::filesystem::rename(path, backup);
 		try
@@ -781,12 +797,18 @@ void GameEngine::save_scene(const std::string_view save_name) const
 void GameEngine::load_scene(const std::string_view save_name)
 {
 	const auto path = SaveFileStore(Utility::get_saves_path()).path_for_overwrite(save_name);
-	std::ifstream stream(path / "scene.yaml", std::ios::binary);
+	const auto scene_file = SaveFileStore::find_scene(path);
+	if (scene_file.empty())
+		throw SerializationError("Unable to open scene: " + (path / SaveFileStore::BINARY_SCENE_FILE).string());
+	std::ifstream stream(scene_file, std::ios::binary);
 	if (!stream)
-		throw SerializationError("Unable to open scene: " + (path / "scene.yaml").string());
+		throw SerializationError("Unable to open scene: " + scene_file.string());
 	std::ostringstream contents;
 	contents << stream.rdbuf();
-	const auto document = Deserializer::parse(contents.str());
+	const auto bytes = contents.view();
+	const auto document = scene_file.filename() == SaveFileStore::BINARY_SCENE_FILE
+		? Deserializer::parse_binary(std::as_bytes(std::span(bytes.data(), bytes.size())))
+		: Deserializer::parse(bytes);
 
 	std::vector<Deserializer> saved_objects;
 	std::unordered_map<ObjectID, bool> ids;
@@ -12,7 +12,9 @@
 #include "entity_component_system/ecs.hpp"
 #include "graphics_engine/engine_base.hpp"
 #include "render_frame.hpp"
+#include "render_frame_builder.hpp"
 #include "renderable/render_types.hpp"
+#include "serialization/serializer.hpp"
 
 #include <atomic>
 #include <thread>
@@ -104,13 +106,17 @@ protected:
 	GameEngine(std::unique_ptr<App::Window> window,
 			   std::unique_ptr<IApplication> application,
 			   std::unique_ptr<GraphicsEngineBase> graphics_engine);
+	// The end of main_loop: builds a frame from the ECS and hands it to the
+	// graphics engine
+	void publish_completed_render_frame();
 
 public:
 	void run();
 	void main_loop(const float time_delta);
 	void shutdown() { shutdown_impl(); }
 	void reset_scene();
-	void save_scene(std::string_view save_name) const;
+	// Saves are binary; YAML exports a readable copy of the same scene
+	void save_scene(std::string_view save_name, SerializationFormat format = SerializationFormat::Binary) const;
 	void load_scene(std::string_view save_name);
 
 	template<typename object_t, typename... Args>
@@ -189,8 +195,8 @@ private:
 	std::unique_ptr<Experimental> experimental;
 	std::queue<ObjectID> entities_to_delete;
 	std::unordered_set<ObjectID> pending_deletions;
-	std::unordered_map<RenderableID, RenderableDefinitionPtr> renderable_definitions;
-	std::unordered_map<SkeletonID, RenderSkeletonDefinitionPtr> render_skeleton_definitions;
+	RenderFrameBuilder render_frame_builder;
+	RenderFramePool render_frame_pool;
 	RenderViewState render_view_state;
 	uint64_t next_render_frame_number = 0;
 
@@ -200,12 +206,7 @@ private:
 	void reset_scene_state();
 	void shutdown_impl();
 	void process_objs_to_delete();
-	void publish_completed_render_frame();
-	RenderFrame build_render_frame();
-	RenderableDefinitionPtr get_renderable_definition(
-		RenderableID id, const RenderableAttachment& attachment);
-	RenderSkeletonDefinitionPtr get_render_skeleton_definition(
-		SkeletonID id, const SkeletalRenderStateSnapshot& snapshot);
+	void build_render_frame(RenderFrame& frame);
 	void validate_renderable_resources(const Renderable& renderable) const;
 	std::unique_ptr<Analytics> TPS_counter;
 	float tps;
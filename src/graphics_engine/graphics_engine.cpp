@@ -2,6 +2,7 @@
 
 #include "graphics_engine.hpp"
 #include "video_recorder.hpp"
+#include "pipeline/pipeline_permutations.hpp"
 
 #include "shared_data_structures.hpp"
 #include "analytics.hpp"
@@ -41,6 +42,8 @@ GraphicsEngine::GraphicsEngine(App::Window& window_) :
 		[this](float fps) {
 			set_fps(fps = float(1e6) / fps);
 		}, 1, CSTS::TRACKER_LOG_PERIOD_SECONDS);
+	// compiled while loading rather than on the first frame that draws each material
+	pipeline_mgr.precompile_pipelines(PipelinePermutations::for_materials().enumerate());
 }
 
 GraphicsEngine::~GraphicsEngine()
@@ -48,15 +51,6 @@ GraphicsEngine::~GraphicsEngine()
 	fmt::print("GraphicsEngine: cleaning up\n");
 	vkDeviceWaitIdle(get_logical_device());
 	renderables.clear();
-	for (const auto& [id, frame_allocation_count] : graphics_skeleton_frame_counts)
-	{
-		for (uint32_t frame_index = 0;
-			frame_index < frame_allocation_count; ++frame_index)
-		{
-			get_rsrc_mgr().free_buffer(SkeletonFrameID{id, frame_index});
-		}
-	}
-	graphics_skeleton_frame_counts.clear();
 	for (auto& resources : retirement_queue.release_all())
 		release_retired_resources(std::move(resources));
 }
@@ -71,6 +65,7 @@ SubmissionSerial GraphicsEngine::register_graphics_submission()
 void GraphicsEngine::complete_graphics_submission(const SubmissionSerial serial)
 {
 	completed_submission_serial = std::max(completed_submission_serial, serial);
+	get_rsrc_mgr().release_completed_uploads(completed_submission_serial);
 	for (auto& resources : retirement_queue.release_completed(completed_submission_serial))
 		release_retired_resources(std::move(resources));
 }
@@ -122,6 +117,18 @@ QueueFamilyIndices GraphicsEngine::findQueueFamilies(VkPhysicalDevice device) {
 		}
 	}
 
+	// a family with transfer but neither graphics nor compute is usually a
+	// dedicated copy engine, which uploads can use without stalling rendering
+	for (uint32_t i = 0; i < queueFamilies.size(); i++)
+	{
+		const VkQueueFlags flags = queueFamilies[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+		{
+			indices.transferFamily = i;
+			break;
+		}
+	}
+
 	return indices;
 }
 
@@ -148,6 +155,7 @@ void GraphicsEngine::run() {
 				continue;
 			}
 
+			cull_draw_lists();
 			gui_manager.draw();
 
 			// raytracing_component.process();
@@ -174,16 +182,21 @@ void GraphicsEngine::accept_latest_render_frame()
 		return;
 
 	const RenderFramePtr next_frame = publication->current;
-	for (const auto& state : next_frame->renderables)
-		if (!state.definition)
-			throw std::runtime_error("GraphicsEngine: renderable definition is empty");
+	// renderables with the definitions of the accepted frame were validated
+	// and indexed when it was accepted
+	const bool same_renderables = accepted_render_frame
+		&& next_frame->renderables.has_same_definitions(accepted_render_frame->renderables);
+	if (!same_renderables)
+		for (const auto& state : next_frame->renderables)
+			if (!state.definition)
+				throw std::runtime_error("GraphicsEngine: renderable definition is empty");
 	for (const auto& pose : next_frame->skeletons)
 		if (!pose.definition)
 			throw std::runtime_error("GraphicsEngine: skeleton definition is empty");
 	bool topology_changed = !accepted_render_frame
 		|| accepted_render_frame->renderables.size() != next_frame->renderables.size()
 		|| accepted_render_frame->skeletons.size() != next_frame->skeletons.size();
-	if (!topology_changed)
+	if (!topology_changed && !same_renderables)
 	{
 		for (const auto& state : next_frame->renderables)
 			if (!renderables.contains(state.definition->id))
@@ -192,24 +205,18 @@ void GraphicsEngine::accept_latest_render_frame()
 				break;
 			}
 	}
-	if (!topology_changed)
-	{
-		for (const auto& pose : next_frame->skeletons)
-			if (!graphics_skeleton_frame_counts.contains(pose.definition->id))
-			{
-				topology_changed = true;
-				break;
-			}
-	}
 
 	accepted_render_frame = next_frame;
-	renderable_indices.clear();
-	renderable_indices.reserve(accepted_render_frame->renderables.size());
-	for (uint32_t index = 0; index < accepted_render_frame->renderables.size(); ++index)
+	if (!same_renderables)
 	{
-		const auto& state = accepted_render_frame->renderables[index];
-		if (!renderable_indices.emplace(state.definition->id, index).second)
-			throw std::runtime_error("GraphicsEngine: duplicate renderable ID");
+		renderable_indices.clear();
+		renderable_indices.reserve(accepted_render_frame->renderables.size());
+		for (uint32_t index = 0; index < accepted_render_frame->renderables.size(); ++index)
+		{
+			const auto& state = accepted_render_frame->renderables[index];
+			if (!renderable_indices.emplace(state.definition->id, index).second)
+				throw std::runtime_error("GraphicsEngine: duplicate renderable ID");
+		}
 	}
 
 	render_skeleton_indices.clear();
@@ -227,11 +234,25 @@ void GraphicsEngine::accept_latest_render_frame()
 			throw std::runtime_error("GraphicsEngine: renderable references a missing skeleton");
 		}
 
-	if (!topology_changed)
-		return;
-
-	reconcile_topology(*accepted_render_frame);
+	if (topology_changed)
+		reconcile_topology(*accepted_render_frame);
+	if (topology_changed || !same_renderables)
+		draw_lists.index_states(renderable_indices);
+}
 
+void GraphicsEngine::cull_draw_lists()
+{
+	const RenderFrame& frame = *accepted_render_frame;
+	const auto shadow_view_projections =
+		make_point_shadow_view_projections(shadow_light_position(frame));
+	std::array<Frustum, POINT_SHADOW_FACE_COUNT> shadow_faces;
+	for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+		shadow_faces[face] = Frustum::from_view_projection(shadow_view_projections[face]);
+	draw_lists.cull(
+		frame.renderables,
+		frame.camera.position,
+		Frustum::from_view_projection(frame.camera.projection * frame.camera.view),
+		shadow_faces);
 }
 
 void GraphicsEngine::reconcile_topology(const RenderFrame& frame)
@@ -243,10 +264,6 @@ void GraphicsEngine::reconcile_topology(const RenderFrame& frame)
 	renderable_ids.reserve(frame.renderables.size());
 	for (const auto& state : frame.renderables)
 		renderable_ids.insert(state.definition->id);
-	std::unordered_set<SkeletonID> skeleton_ids;
-	skeleton_ids.reserve(frame.skeletons.size());
-	for (const auto& pose : frame.skeletons)
-		skeleton_ids.insert(pose.definition->id);
 
 	retired.renderables.reserve(renderables.size());
 	for (auto it = renderables.begin(); it != renderables.end();)
@@ -260,50 +277,8 @@ void GraphicsEngine::reconcile_topology(const RenderFrame& frame)
 		retired.renderables.push_back(removed.mapped()->take_graphics_resources());
 	}
 
-	retired.skeletons.reserve(graphics_skeleton_frame_counts.size());
-	for (auto it = graphics_skeleton_frame_counts.begin();
-		it != graphics_skeleton_frame_counts.end();)
-	{
-		if (skeleton_ids.contains(it->first))
-		{
-			++it;
-			continue;
-		}
-		auto removed = graphics_skeleton_frame_counts.extract(it++);
-		retired.skeletons.push_back(
-			GraphicsSkeletonResources{removed.key(), removed.mapped()});
-	}
 	enqueue_retirement(std::move(retired));
 
-	for (const auto& pose : frame.skeletons)
-	{
-		const SkeletonID id = pose.definition->id;
-		if (graphics_skeleton_frame_counts.contains(id))
-			continue;
-		const uint32_t frame_allocation_count = get_num_swapchain_images();
-		const size_t size = sizeof(SDS::Bone) * pose.definition->bones.size();
-		uint32_t reserved_frame_count = 0;
-		try
-		{
-			for (; reserved_frame_count < frame_allocation_count; ++reserved_frame_count)
-			{
-				get_rsrc_mgr().reserve_buffer(
-					SkeletonFrameID{id, reserved_frame_count}, size);
-			}
-		}
-		catch (...)
-		{
-			for (uint32_t frame_index = 0;
-				frame_index < reserved_frame_count; ++frame_index)
-			{
-				get_rsrc_mgr().free_buffer(
-					SkeletonFrameID{id, frame_index});
-			}
-			throw;
-		}
-		graphics_skeleton_frame_counts.emplace(id, frame_allocation_count);
-	}
-
 	for (const auto& state : frame.renderables)
 	{
 		if (renderables.contains(state.definition->id))
@@ -384,6 +359,9 @@ void GraphicsEngine::enqueue_retirement(RetiredGraphicsResources resources)
 {
 	if (resources.empty())
 		return;
+	// staged uploads may still target these resources, so submit them first
+	// and let the retirement wait for them too
+	get_rsrc_mgr().flush_uploads();
 	retirement_queue.enqueue(last_submitted_serial, std::move(resources));
 	for (auto& completed : retirement_queue.release_completed(completed_submission_serial))
 		release_retired_resources(std::move(completed));
@@ -391,26 +369,11 @@ void GraphicsEngine::enqueue_retirement(RetiredGraphicsResources resources)
 
 void GraphicsEngine::release_retired_resources(RetiredGraphicsResources resources)
 {
-	for (auto& renderable : resources.renderables)
+	for (const auto& renderable : resources.renderables)
 	{
-		for (uint32_t frame_index = 0;
-			frame_index < renderable.frame_allocation_count; ++frame_index)
-		{
-			get_rsrc_mgr().free_buffer(
-				RenderableFrameID{renderable.id, frame_index});
-		}
-		if (renderable.dset != VK_NULL_HANDLE)
-			get_rsrc_mgr().free_dset(renderable.dset);
-		get_rsrc_mgr().free_dsets(renderable.frame_dsets);
-	}
-	for (const auto& skeleton : resources.skeletons)
-	{
-		for (uint32_t frame_index = 0;
-			frame_index < skeleton.frame_allocation_count; ++frame_index)
-		{
-			get_rsrc_mgr().free_buffer(
-				SkeletonFrameID{skeleton.id, frame_index});
-		}
+		for (const VkDescriptorSet dset : { renderable.dset, renderable.frame_data_dset })
+			if (dset != VK_NULL_HANDLE)
+				get_rsrc_mgr().free_dset(dset);
 	}
 	for (const MaterialID id : resources.materials)
 	{
@@ -420,6 +383,9 @@ void GraphicsEngine::release_retired_resources(RetiredGraphicsResources resource
 	}
 	for (const MeshID id : resources.meshes)
 		get_rsrc_mgr().free_buffer(id);
+	// the freed slots are past their last submission, so blocks they emptied can go
+	if (!resources.materials.empty() || !resources.meshes.empty())
+		get_rsrc_mgr().release_idle_buffer_blocks();
 }
 
 int GraphicsEngine::find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags flags)
@@ -470,6 +436,9 @@ void GraphicsEngine::end_single_time_commands(VkCommandBuffer command_buffer)
 {
     vkEndCommandBuffer(command_buffer);
 
+	// one-off commands may read staged data, so the uploads go first
+	get_rsrc_mgr().flush_uploads();
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.commandBufferCount = 1;
@@ -734,8 +703,8 @@ VkFormat GraphicsEngine::find_depth_format()
 
 void GraphicsEngine::create_renderable_buffers(GraphicsRenderable &graphics_renderable)
 {
-	// vertex buffer doesn't change per frame so unlike uniform buffer it doesn't need to be
-	// per frame resource and therefore we only need 1 copy
+	// per frame object and bone data is packed into the frame data rings while the
+	// frame is recorded, so only the static buffers are written here
 	auto &rsrc_mgr = get_rsrc_mgr();
 	const auto &renderable = graphics_renderable.get_definition();
 	// reserve and write to mesh buffer (actually vertex and index buffers)
@@ -758,16 +727,6 @@ void GraphicsEngine::create_renderable_buffers(GraphicsRenderable &graphics_rend
 		break;
 	}
 
-	// these buffers are dynamic (changing between frames) and therefore requires duplicate buffers per swapchain image
-	const uint32_t frame_allocation_count = get_num_swapchain_images();
-	for (uint32_t frame_idx = 0; frame_idx < frame_allocation_count; ++frame_idx)
-	{
-		rsrc_mgr.reserve_buffer(
-			RenderableFrameID{graphics_renderable.get_id(), frame_idx},
-			sizeof(SDS::ObjectData));
-		graphics_renderable.record_frame_allocation();
-	}
-
 	// Ray-tracing buffer mapping is unsupported:
 	// SDS::BufferMapEntry buffer_map;
 	// buffer_map.vertex_offset =
@@ -778,54 +737,45 @@ void GraphicsEngine::create_renderable_buffers(GraphicsRenderable &graphics_rend
 
 void GraphicsEngine::create_renderable_dsets(GraphicsRenderable &graphics_renderable)
 {
-	const std::vector<VkDescriptorSetLayout> frame_layouts(
-		graphics_renderable.get_frame_allocation_count(),
-		get_rsrc_mgr().get_per_renderable_frame_dset_layout());
-	graphics_renderable.set_frame_dsets(get_rsrc_mgr().reserve_dsets(frame_layouts));
+	// a single set serves every frame: the dynamic offsets bound with it pick
+	// this frame's object data and bones out of the frame data rings
+	const VkDescriptorSet frame_data_dset =
+		get_rsrc_mgr().reserve_dset(get_rsrc_mgr().get_per_renderable_frame_dset_layout());
+	graphics_renderable.set_frame_data_dset(frame_data_dset);
+	std::vector<VkWriteDescriptorSet> frame_data_writes;
+
+	VkDescriptorBufferInfo object_data_info{};
+	object_data_info.buffer = get_rsrc_mgr().get_object_data_buffer();
+	object_data_info.offset = 0;
+	object_data_info.range = sizeof(SDS::ObjectData);
+	VkWriteDescriptorSet object_data_dset_write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+	object_data_dset_write.dstSet = frame_data_dset;
+	object_data_dset_write.dstBinding = SDS::RASTERIZATION_OBJECT_DATA_BINDING;
+	object_data_dset_write.dstArrayElement = 0;
+	object_data_dset_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	object_data_dset_write.descriptorCount = 1;
+	object_data_dset_write.pBufferInfo = &object_data_info;
+	frame_data_writes.push_back(object_data_dset_write);
+
+	// unskinned renderables still bind one bone so the dynamic descriptor is valid
 	const auto skeleton_id = graphics_renderable.get_skeleton_id();
-	for (uint32_t frame_idx = 0;
-		frame_idx < graphics_renderable.get_frame_allocation_count(); ++frame_idx)
-	{
-		const VkDescriptorSet new_descriptor_set =
-			graphics_renderable.get_frame_dset(frame_idx);
-		std::vector<VkWriteDescriptorSet> descriptor_writes;
-
-		VkDescriptorBufferInfo buffer_info{};
-		const GraphicsBuffer::Slot buffer_slot =
-			get_rsrc_mgr().get_buffer_slot(
-				RenderableFrameID{graphics_renderable.get_id(), frame_idx});
-		buffer_info.buffer = get_rsrc_mgr().get_uniform_buffer();
-		buffer_info.offset = buffer_slot.offset;
-		buffer_info.range = buffer_slot.size;
-		VkWriteDescriptorSet uniform_buffer_dset_write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-		uniform_buffer_dset_write.dstSet = new_descriptor_set;
-		uniform_buffer_dset_write.dstBinding = SDS::RASTERIZATION_OBJECT_DATA_BINDING;
-		uniform_buffer_dset_write.dstArrayElement = 0; // offset
-		uniform_buffer_dset_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uniform_buffer_dset_write.descriptorCount = 1;
-		uniform_buffer_dset_write.pBufferInfo = &buffer_info;
-		descriptor_writes.push_back(uniform_buffer_dset_write);
-
-		if (skeleton_id)
-		{
-			const GraphicsBuffer::Slot bone_slot =
-				get_rsrc_mgr().get_buffer_slot(SkeletonFrameID{*skeleton_id, frame_idx});
-			VkDescriptorBufferInfo bone_buffer_info{};
-			bone_buffer_info.buffer = get_rsrc_mgr().get_bone_buffer();
-			bone_buffer_info.offset = bone_slot.offset;
-			bone_buffer_info.range = bone_slot.size;
-			VkWriteDescriptorSet bone_buffer_dset_write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-			bone_buffer_dset_write.dstSet = new_descriptor_set;
-			bone_buffer_dset_write.dstBinding = SDS::RASTERIZATION_BONE_DATA_BINDING;
-			bone_buffer_dset_write.dstArrayElement = 0;
-			bone_buffer_dset_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-			bone_buffer_dset_write.descriptorCount = 1;
-			bone_buffer_dset_write.pBufferInfo = &bone_buffer_info;
-			descriptor_writes.push_back(bone_buffer_dset_write);
-		}
-
-		vkUpdateDescriptorSets(get_logical_device(), descriptor_writes.size(), descriptor_writes.data(), 0, nullptr);
-	}
+	const size_t bone_count = skeleton_id
+		? get_render_skeleton_pose(*skeleton_id).definition->bones.size()
+		: 1;
+	VkDescriptorBufferInfo bone_data_info{};
+	bone_data_info.buffer = get_rsrc_mgr().get_bone_data_buffer();
+	bone_data_info.offset = 0;
+	bone_data_info.range = sizeof(SDS::Bone) * std::max<size_t>(bone_count, 1);
+	VkWriteDescriptorSet bone_data_dset_write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+	bone_data_dset_write.dstSet = frame_data_dset;
+	bone_data_dset_write.dstBinding = SDS::RASTERIZATION_BONE_DATA_BINDING;
+	bone_data_dset_write.dstArrayElement = 0;
+	bone_data_dset_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	bone_data_dset_write.descriptorCount = 1;
+	bone_data_dset_write.pBufferInfo = &bone_data_info;
+	frame_data_writes.push_back(bone_data_dset_write);
+
+	vkUpdateDescriptorSets(get_logical_device(), frame_data_writes.size(), frame_data_writes.data(), 0, nullptr);
 
 	// TODO: we need to cache the dsets for each material/texture
 	const RenderableDefinition &renderable = graphics_renderable.get_definition();
@@ -836,26 +786,27 @@ void GraphicsEngine::create_renderable_dsets(GraphicsRenderable &graphics_render
 	std::vector<VkWriteDescriptorSet> descriptor_writes;
 
 	// TODO: after resolving above todo, need to move this within the below switch statement
-	const GraphicsBuffer::Slot mat_slot = [&]() {
+	const GraphicsBufferPool::Location mat_location = [&]() {
 		if (renderable.pipeline_render_type != ERenderType::COLOR
 			&& renderable.pipeline_render_type != ERenderType::STANDARD
 			&& renderable.pipeline_render_type != ERenderType::SKINNED
 			&& renderable.pipeline_render_type != ERenderType::SKINNED_COLOR)
 		{
 			// TODO: this needs to be properly fixed
-			GraphicsBuffer::Slot slot;
-			slot.offset = 0;
-			slot.size = 4; // this is just a dummy value
-			return slot;
+			GraphicsBufferPool::Location location{};
+			location.buffer = get_rsrc_mgr().get_placeholder_materials_buffer();
+			location.slot.offset = 0;
+			location.slot.size = 4; // this is just a dummy value
+			return location;
 		}
 
 		const PbrMatGroup materials(renderable.material_owners);
-		return get_rsrc_mgr().get_buffer_slot(renderable.material_owners.front()->get_id());
+		return get_rsrc_mgr().get_buffer_location(renderable.material_owners.front()->get_id());
 	}();
 	VkDescriptorBufferInfo material_buffer_info{};
-	material_buffer_info.buffer = get_rsrc_mgr().get_materials_buffer();
-	material_buffer_info.offset = mat_slot.offset;
-	material_buffer_info.range = mat_slot.size;
+	material_buffer_info.buffer = mat_location.buffer;
+	material_buffer_info.offset = mat_location.slot.offset;
+	material_buffer_info.range = mat_location.slot.size;
 	VkWriteDescriptorSet material_buffer_dset{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
 	material_buffer_dset.dstSet = new_descriptor_set;
 	material_buffer_dset.dstBinding = SDS::RASTERIZATION_MATERIAL_DATA_BINDING;
@@ -33,23 +33,15 @@ class Analytics;
 class GraphicsRenderable;
 class VideoRecorder;
 
-struct GraphicsSkeletonResources
-{
-	SkeletonID id;
-	uint32_t frame_allocation_count;
-};
-
 struct RetiredGraphicsResources
 {
 	std::vector<GraphicsRenderableResources> renderables;
-	std::vector<GraphicsSkeletonResources> skeletons;
 	std::vector<MaterialID> materials;
 	std::vector<MeshID> meshes;
 
 	bool empty() const
 	{
-		return renderables.empty() && skeletons.empty()
-			&& materials.empty() && meshes.empty();
+		return renderables.empty() && materials.empty() && meshes.empty();
 	}
 };
 
@@ -86,6 +78,8 @@ public: // getters and setters
 	VkInstance& get_instance() { return instance.get(); }
 	VkQueue& get_present_queue() { return present_queue; }
 	VkQueue& get_graphics_queue() { return graphics_queue; }
+	// VK_NULL_HANDLE unless the device has a transfer-only queue family
+	VkQueue& get_transfer_queue() { return transfer_queue; }
 	VkSurfaceKHR& get_window_surface() { return instance.window_surface; }
 	GraphicsEngineSwapChain& get_swap_chain() { return swap_chain; }
 	uint32_t get_num_swapchain_images() { return swap_chain.get_num_images(); }
@@ -121,6 +115,10 @@ public: // getters and setters
 	{
 		return accepted_render_frame->skeletons.at(render_skeleton_indices.at(id));
 	}
+	uint32_t get_render_skeleton_index(SkeletonID id) const
+	{
+		return render_skeleton_indices.at(id);
+	}
 	SubmissionSerial register_graphics_submission();
 	void complete_graphics_submission(SubmissionSerial serial);
 
@@ -128,6 +126,7 @@ private:
 	std::atomic<bool> should_shutdown = false;
 	VkQueue graphics_queue;
 	VkQueue present_queue;
+	VkQueue transfer_queue = VK_NULL_HANDLE;
 	std::unordered_map<RenderableID, std::unique_ptr<GraphicsRenderable>> renderables;
 	GraphicsDrawLists draw_lists;
 	std::unique_ptr<Analytics> FPS_tracker;
@@ -189,7 +188,6 @@ private: // core components
 	RenderFramePtr accepted_render_frame;
 	std::unordered_map<RenderableID, uint32_t> renderable_indices;
 	std::unordered_map<SkeletonID, uint32_t> render_skeleton_indices;
-	std::unordered_map<SkeletonID, uint32_t> graphics_skeleton_frame_counts;
 	SubmissionRetirementQueue<RetiredGraphicsResources> retirement_queue;
 	SubmissionSerial last_submitted_serial = 0;
 	SubmissionSerial completed_submission_serial = 0;
@@ -210,6 +208,7 @@ private: // core components
 
 private:
 	void accept_latest_render_frame();
+	void cull_draw_lists();
 	void configure_environment_lighting(const RenderFrame& frame);
 	void reconcile_topology(const RenderFrame& frame);
 	void retire_unused_resources();
@@ -2,6 +2,7 @@
 
 #include "graphics_engine.hpp"
 #include "queues.hpp"
+#include "resource_manager/descriptor_manager.hpp"
 #include "utility.hpp"
 
 #include <quill/LogMacros.h>
@@ -78,6 +79,14 @@ void GraphicsEngineDevice::pick_physical_device()
 		{
 			return false;
 		}
+		if (deviceProperties.limits.maxBoundDescriptorSets < GraphicsDescriptorManager::RASTERIZATION_DESCRIPTOR_SET_COUNT)
+		{
+			LOG_WARNING(Utility::get_logger(),
+				"GraphicsEngineDevice: {} binds {} descriptor sets at most, rasterization needs {}",
+				deviceProperties.deviceName, deviceProperties.limits.maxBoundDescriptorSets,
+				GraphicsDescriptorManager::RASTERIZATION_DESCRIPTOR_SET_COUNT);
+			return false;
+		}
 
 		VkFormatProperties hdr_format_properties{};
 		vkGetPhysicalDeviceFormatProperties(
@@ -139,8 +148,10 @@ void GraphicsEngineDevice::pick_physical_device()
 	}
 
 	if (physicalDevice == VK_NULL_HANDLE) {
-		throw std::runtime_error(
-			"failed to find a suitable GPU (HDR requires sampled RGBA16F color attachments)");
+		throw std::runtime_error(fmt::format(
+			"failed to find a suitable GPU (HDR requires sampled RGBA16F color attachments, "
+			"rasterization requires maxBoundDescriptorSets >= {})",
+			GraphicsDescriptorManager::RASTERIZATION_DESCRIPTOR_SET_COUNT));
 	}
 }
 
@@ -189,10 +200,12 @@ void GraphicsEngineDevice::create_logical_device()
 	std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
 	std::vector<uint32_t> unique_queue_families = [&indices]()
 	{
-		const std::set<uint32_t> unique_families{
+		std::set<uint32_t> unique_families{
 			indices.graphicsFamily.value(),
 			indices.presentFamily.value()
 		};
+		if (indices.transferFamily)
+			unique_families.insert(*indices.transferFamily);
 		return std::vector<uint32_t>(unique_families.begin(), unique_families.end());
 	}();
 
@@ -224,6 +237,8 @@ void GraphicsEngineDevice::create_logical_device()
 	// retrieves the queue handles
 	vkGetDeviceQueue(logical_device, indices.presentFamily.value(), 0, &get_graphics_engine().get_present_queue());
 	vkGetDeviceQueue(logical_device, indices.graphicsFamily.value(), 0, &get_graphics_engine().get_graphics_queue());
+	if (indices.transferFamily)
+		vkGetDeviceQueue(logical_device, *indices.transferFamily, 0, &get_graphics_engine().get_transfer_queue());
 }
 
 void GraphicsEngineDevice::print_physical_device_settings()
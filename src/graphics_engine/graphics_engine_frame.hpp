@@ -10,6 +10,7 @@
 
 #include <optional>
 #include <filesystem>
+#include <vector>
 
 
 class GraphicsEngineSwapChain;
@@ -66,6 +67,9 @@ private:
 
 	static int global_image_index;
 
+	// bone data offset of each skeleton in the render frame, reused between frames
+	std::vector<uint32_t> bone_data_offsets;
+
 	Analytics analytics;
 
 	std::optional<GraphicsBuffer> screenshot_staging_buffer;
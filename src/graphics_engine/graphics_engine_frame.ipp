@@ -154,6 +154,9 @@ void GraphicsEngineFrame::draw()
 		submission_serial.reset();
 	}
 
+	// this image's frame data region was last read by the submission waited on
+	// above, and the dynamic offsets must be known before recording
+	update_uniform_buffer();
 	update_command_buffer();
 
 	uint32_t swap_chain_image_index;
@@ -189,8 +192,6 @@ void GraphicsEngineFrame::draw()
 	// mark the image as now being in use by this frame
 	fence_image_inflight = fence_frame_inflight;
 
-	update_uniform_buffer();
-
 	//
 	// submitting the command buffer
 	//
@@ -214,6 +215,9 @@ void GraphicsEngineFrame::draw()
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = signal_semaphores;
 
+	// everything staged since the last frame goes in one submission ahead of it
+	get_rsrc_mgr().flush_uploads();
+
 	vkResetFences(get_logical_device(), 1, &fence_frame_inflight);
 	if (vkQueueSubmit(get_graphics_engine().get_graphics_queue(), 1, &submitInfo, fence_frame_inflight) != VK_SUCCESS)
 	{
@@ -262,74 +266,48 @@ void GraphicsEngineFrame::update_uniform_buffer()
 	gubo.view_pos = render_frame.camera.position;
 
 	// currently uses a single active light source
+	gubo.light_pos = shadow_light_position(render_frame);
 	if (render_frame.active_light)
 	{
 		const auto& light = *render_frame.active_light;
-		gubo.light_pos = light.position;
 		gubo.light_color = light.color;
 		gubo.light_intensity = light.intensity;
 	}
 	else
 	{
-		gubo.light_pos = glm::vec3(0.0f, 5.0f, 0.0f);
 		gubo.light_color = glm::vec3(0.0f);
 		gubo.light_intensity = 0.0f;
 	}
-	gubo.shadow_far_plane = 256.0f;
-
-	const std::array<glm::vec3, 6> SHADOW_DIRECTIONS = {
-		Maths::right_vec,
-		-Maths::right_vec,
-		Maths::up_vec,
-		-Maths::up_vec,
-		Maths::forward_vec,
-		-Maths::forward_vec
-	};
-	const std::array<glm::vec3, 6> SHADOW_UPS = {
-		Maths::up_vec,
-		Maths::up_vec,
-		-Maths::forward_vec,
-		Maths::forward_vec,
-		Maths::up_vec,
-		Maths::up_vec
-	};
+	gubo.shadow_far_plane = POINT_SHADOW_FAR_PLANE;
 
-	const glm::mat4 shadow_proj = glm::perspectiveLH(
-		Maths::deg2rad(90.0f),
-		1.0f,
-		0.1f,
-		gubo.shadow_far_plane);
-	for (int face_idx = 0; face_idx < 6; ++face_idx)
-	{
-		const glm::mat4 shadow_view = glm::lookAtLH(
-			gubo.light_pos,
-			gubo.light_pos + SHADOW_DIRECTIONS[face_idx],
-			SHADOW_UPS[face_idx]);
-		gubo.shadow_view_proj_mats[face_idx] = shadow_proj * shadow_view;
-	}
+	// must match the frustums GraphicsEngine::cull_draw_lists culls shadows with
+	const auto shadow_view_projections = make_point_shadow_view_projections(gubo.light_pos);
+	for (size_t face_idx = 0; face_idx < POINT_SHADOW_FACE_COUNT; ++face_idx)
+		gubo.shadow_view_proj_mats[face_idx] = shadow_view_projections[face_idx];
 
 	get_rsrc_mgr().write_to_global_uniform_buffer(image_index, gubo);
 
-	// Update the producer-composed transform for each renderable.
+	get_rsrc_mgr().begin_frame_data(image_index);
+
+	// Skeleton poses are shared by every bound renderable and packed once, from
+	// skinning matrices the producer composed.
+	bone_data_offsets.clear();
+	for (const auto& pose : render_frame.skeletons)
+		bone_data_offsets.push_back(get_rsrc_mgr().write_frame_data(pose.bones));
+
+	// Pack the producer-composed transform of each renderable after them.
 	SDS::ObjectData object_data{};
 	for (const auto& [_, graphics_renderable] : get_graphics_engine().get_renderables())
 	{
 		object_data.model = graphics_renderable->get_model_transform();
 		object_data.mvp = gubo.proj * gubo.view * object_data.model;
 		object_data.rot_mat = glm::mat3(object_data.model);
-		get_rsrc_mgr().write_to_buffer(
-			RenderableFrameID{graphics_renderable->get_id(), image_index},
-			object_data);
-	}
-
-	// Skeleton pose resources are shared by every bound renderable and updated once.
-	for (const auto& pose : render_frame.skeletons)
-	{
-		std::vector<SDS::Bone> bones =
-			compose_bone_transforms(pose.local_transforms, *pose.definition);
-		get_rsrc_mgr().write_to_buffer(
-			SkeletonFrameID(pose.definition->id, image_index),
-			bones);
+		const auto skeleton_id = graphics_renderable->get_skeleton_id();
+		graphics_renderable->set_frame_data_offsets({
+			get_rsrc_mgr().write_frame_data(object_data),
+			skeleton_id
+				? bone_data_offsets[get_graphics_engine().get_render_skeleton_index(*skeleton_id)]
+				: 0 });
 	}
 }
 
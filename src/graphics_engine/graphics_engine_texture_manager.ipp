@@ -17,10 +17,21 @@ VkFormat texture_format(const TextureMaterial& material)
 {
 	const bool linear = material.semantic == ETextureSemantic::NORMAL
 		|| material.semantic == ETextureSemantic::METALLIC_ROUGHNESS;
-	if (material.format == ETextureFormat::BC3)
+	switch (material.format)
 	{
+	case ETextureFormat::BC1:
+		return linear
+			? VK_FORMAT_BC1_RGBA_UNORM_BLOCK : VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+	case ETextureFormat::BC3:
 		return linear
 			? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK;
+	case ETextureFormat::BC5:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	case ETextureFormat::BC7:
+		return linear
+			? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+	case ETextureFormat::RGBA8:
+		break;
 	}
 	return linear
 		? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
@@ -364,13 +375,7 @@ GraphicsEngineTexture GraphicsEngineTextureManager::create_environment_texture(
 			image.layer_count,
 			view_type == VK_IMAGE_VIEW_TYPE_CUBE ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0,
 			mip_levels);
-		get_graphics_engine().transition_image_layout(
-			texture_image,
-			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			nullptr,
-			image.layer_count,
-			mip_levels);
+		// the upload leaves the image ready for sampling
 		get_rsrc_mgr().stage_data_to_image(
 			texture_image,
 			image.width,
@@ -382,13 +387,6 @@ GraphicsEngineTexture GraphicsEngineTextureManager::create_environment_texture(
 			},
 			image.layer_count,
 			image.mip_sizes);
-		get_graphics_engine().transition_image_layout(
-			texture_image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			nullptr,
-			image.layer_count,
-			mip_levels);
 		texture_image_view = get_graphics_engine().create_image_view(
 			texture_image,
 			VK_FORMAT_R8G8B8A8_UNORM,
@@ -447,12 +445,7 @@ glm::uvec3 GraphicsEngineTextureManager::create_texture_image(
 		0,
 		mip_levels);
 
-	// copy the staging buffer to the texture image,
-	// undefined image layout works because we don't care about the contents before performing copy
-	get_graphics_engine().transition_image_layout(
-		texture_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		nullptr, 1, mip_levels);
-
+	// the upload transitions the image for the copy and then for shader access
 	get_rsrc_mgr().stage_data_to_image(
 		texture_image,
 		material.width,
@@ -465,11 +458,6 @@ glm::uvec3 GraphicsEngineTextureManager::create_texture_image(
 		1,
 		material.mip_sizes);
 
-	// transition one more time for shader access
-	get_graphics_engine().transition_image_layout(
-		texture_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		nullptr, 1, mip_levels);
-
 	return glm::uvec3(material.width, material.height, material.channels);
 }
 
@@ -509,15 +497,7 @@ void GraphicsEngineTextureManager::create_cubemap_texture_image(
 		num_textures,
 		VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
 
-	// copy the staging buffer to the texture image,
-	// undefined image layout works because we don't care about the contents before performing copy
-	get_graphics_engine().transition_image_layout(
-		texture_image,
-		VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		nullptr,
-		num_textures);
-
+	// the upload transitions the image for the copy and then for shader access
 	get_rsrc_mgr().stage_data_to_image(
 		texture_image,
 		width,
@@ -539,14 +519,6 @@ void GraphicsEngineTextureManager::create_cubemap_texture_image(
 			}
 		},
 		num_textures);
-
-	// transition one more time for shader access
-	get_graphics_engine().transition_image_layout(
-		texture_image,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		nullptr,
-		num_textures);
 }
 
 VkSampler GraphicsEngineTextureManager::create_texture_sampler(PbrMaterial::TextureSampler sampler_type)
@@ -6,15 +6,15 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <array>
 #include <vector>
 
 
 struct GraphicsRenderableResources
 {
 	RenderableID id;
-	uint32_t frame_allocation_count = 0;
 	VkDescriptorSet dset = VK_NULL_HANDLE;
-	std::vector<VkDescriptorSet> frame_dsets;
+	VkDescriptorSet frame_data_dset = VK_NULL_HANDLE;
 };
 
 class GraphicsRenderable : public GraphicsEngineBaseModule
@@ -32,8 +32,6 @@ public:
 	GraphicsRenderable& operator=(GraphicsRenderable&&) = delete;
 
 	RenderableID get_id() const { return definition->id; }
-	uint32_t get_frame_allocation_count() const { return frame_allocation_count; }
-	void record_frame_allocation() { ++frame_allocation_count; }
 	GraphicsRenderableResources take_graphics_resources() noexcept;
 	std::optional<ObjectID> get_object_id() const { return definition->object_id; }
 	std::optional<SkeletonID> get_skeleton_id() const;
@@ -41,17 +39,18 @@ public:
 	bool get_visibility() const;
 	const glm::mat4& get_model_transform() const;
 
-	VkDescriptorSet get_frame_dset(uint8_t frame_index) const
-	{
-		return frame_dsets.at(frame_index);
-	}
-	void set_frame_dsets(std::vector<VkDescriptorSet> dsets) { frame_dsets = std::move(dsets); }
+	// Object data and bones of the frame being recorded, in binding order
+	using FrameDataOffsets = std::array<uint32_t, 2>;
+	VkDescriptorSet get_frame_data_dset() const { return frame_data_dset; }
+	void set_frame_data_dset(VkDescriptorSet value) { frame_data_dset = value; }
+	const FrameDataOffsets& get_frame_data_offsets() const { return frame_data_offsets; }
+	void set_frame_data_offsets(const FrameDataOffsets& offsets) { frame_data_offsets = offsets; }
 	VkDescriptorSet get_dset() const { return dset; }
 	void set_dset(VkDescriptorSet value) { dset = value; }
 
 private:
 	RenderableDefinitionPtr definition;
-	uint32_t frame_allocation_count;
 	VkDescriptorSet dset = VK_NULL_HANDLE;
-	std::vector<VkDescriptorSet> frame_dsets;
+	VkDescriptorSet frame_data_dset = VK_NULL_HANDLE;
+	FrameDataOffsets frame_data_offsets{};
 };
@@ -11,8 +11,7 @@ GraphicsRenderable::GraphicsRenderable(
 	GraphicsEngine& engine,
 	RenderableDefinitionPtr definition_) :
 	GraphicsEngineBaseModule(engine),
-	definition(std::move(definition_)),
-	frame_allocation_count(0)
+	definition(std::move(definition_))
 {
 	if (!definition)
 		throw std::invalid_argument("GraphicsRenderable: definition is empty");
@@ -21,27 +20,18 @@ GraphicsRenderable::GraphicsRenderable(
 
 GraphicsRenderable::~GraphicsRenderable()
 {
-	for (uint32_t frame_index = 0;
-		frame_index < frame_allocation_count; ++frame_index)
-	{
-		get_rsrc_mgr().free_buffer(
-			RenderableFrameID{get_id(), frame_index});
-	}
-	if (dset != VK_NULL_HANDLE)
-	{
-		std::vector<VkDescriptorSet> dsets{ dset };
-		get_rsrc_mgr().free_dsets(dsets);
-	}
-	get_rsrc_mgr().free_dsets(frame_dsets);
+	std::vector<VkDescriptorSet> dsets;
+	for (const VkDescriptorSet owned : { dset, frame_data_dset })
+		if (owned != VK_NULL_HANDLE)
+			dsets.push_back(owned);
+	get_rsrc_mgr().free_dsets(dsets);
 }
 
 GraphicsRenderableResources GraphicsRenderable::take_graphics_resources() noexcept
 {
-	GraphicsRenderableResources resources{
-		get_id(), frame_allocation_count, dset, std::move(frame_dsets)};
-	frame_allocation_count = 0;
+	GraphicsRenderableResources resources{ get_id(), dset, frame_data_dset };
 	dset = VK_NULL_HANDLE;
-	frame_dsets.clear();
+	frame_data_dset = VK_NULL_HANDLE;
 	return resources;
 }
 
@@ -158,7 +158,8 @@ void GraphicsEnginePipeline::initialise()
 	// RHS uses counter clockwise while LHS (which is our current system) uses clockwise
 	VkFrontFace front_face = get_front_face();
 
-	VkShaderModule vertex_shader = create_shader_module((shader_path / "vertex_shader.spv").string());
+	VkShaderModule vertex_shader = create_shader_module(
+		(shader_path / (instanced ? "instanced_vertex_shader.spv" : "vertex_shader.spv")).string());
 	VkShaderModule fragment_shader = create_shader_module((shader_path / "fragment_shader.spv").string());
 	VkShaderModule geometry_shader = VK_NULL_HANDLE;
 
@@ -318,10 +319,10 @@ void GraphicsEnginePipeline::initialise()
 	graphics_pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
 	graphics_pipeline_create_info.basePipelineIndex = -1;
 
-	// pipeline cache can be used to significantly speed up pipeline creation
+	// the cache lets pipelines compiled in earlier runs be reused
 	if (vkCreateGraphicsPipelines(
 		get_logical_device(), 
-		VK_NULL_HANDLE, 
+		get_graphics_engine().get_pipeline_mgr().get_pipeline_cache(), 
 		1, 
 		&graphics_pipeline_create_info, 
 		nullptr, 
@@ -20,6 +20,7 @@ public:
 	VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
 	void set_alpha_mode(const EAlphaMode mode) { alpha_mode = mode; }
 	void set_double_sided(const bool value) { double_sided = value; }
+	void set_instanced(const bool value) { instanced = value; }
 
 protected:
 	GraphicsEnginePipeline(GraphicsEngine& engine);
@@ -50,6 +51,8 @@ protected:
 	virtual void mod_color_blend_attachment(VkPipelineColorBlendAttachmentState& color_blend_attachment) const {}
 	EAlphaMode alpha_mode = EAlphaMode::OPAQUE;
 	bool double_sided = false;
+	// uses the shader directory's instanced_vertex_shader instead
+	bool instanced = false;
 
 private:
 	friend GraphicsEnginePipelineManager;
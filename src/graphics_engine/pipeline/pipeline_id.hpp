@@ -22,12 +22,15 @@ struct PipelineID
 	EAlphaMode alpha_mode = EAlphaMode::OPAQUE;
 	EShadingMode shading_mode = EShadingMode::LIT;
 	bool double_sided = false;
+	// reads transforms from the instance buffer rather than per renderable
+	bool instanced = false;
 
 	bool operator==(const PipelineID& other) const
 	{
 		return primary_pipeline_type == other.primary_pipeline_type && 
 			pipeline_modifier == other.pipeline_modifier && alpha_mode == other.alpha_mode
-			&& shading_mode == other.shading_mode && double_sided == other.double_sided;
+			&& shading_mode == other.shading_mode && double_sided == other.double_sided
+			&& instanced == other.instanced;
 	}
 };
 
@@ -40,6 +43,7 @@ struct std::hash<PipelineID>
 			(std::hash<int>()(static_cast<int>(pipeline_id.pipeline_modifier)) << 1) ^
 			(std::hash<int>()(static_cast<int>(pipeline_id.alpha_mode)) << 2) ^
 			(std::hash<int>()(static_cast<int>(pipeline_id.shading_mode)) << 3) ^
-			(std::hash<bool>()(pipeline_id.double_sided) << 4);
+			(std::hash<bool>()(pipeline_id.double_sided) << 4) ^
+			(std::hash<bool>()(pipeline_id.instanced) << 5);
 	}
 };
@@ -4,9 +4,11 @@
 #include "graphics_engine/graphics_engine_base_module.hpp"
 #include "renderable/render_types.hpp"
 #include "pipeline_id.hpp"
+#include "resource_loader/derived_data_cache.hpp"
 
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 
 class GraphicsEnginePipelineManager : public GraphicsEngineBaseModule
@@ -18,10 +20,20 @@ public:
 	~GraphicsEnginePipelineManager();
 
 	PipelineType* fetch_pipeline(PipelineID id);
+	// Creates the pipelines of ids not created yet on the shared task pool, so
+	// that their first draw does not compile them on the render thread.
+	// Pipelines that fail are logged and left for fetch_pipeline.
+	void precompile_pipelines(const std::vector<PipelineID>& ids);
 
 	VkPipelineLayout get_generic_pipeline_layout() const { return generic_pipeline_layout; }
+	VkPipelineCache get_pipeline_cache() const { return pipeline_cache; }
 
 private:
+	// The pipeline cache is kept in the derived data cache, keyed by the
+	// device and driver its contents were compiled for
+	void load_pipeline_cache();
+	void save_pipeline_cache();
+
 	std::unique_ptr<PipelineType> create_pipeline(PipelineID id);
 	template<typename PrimaryPipelineType>
 	std::unique_ptr<PipelineType> create_pipeline(PipelineID id);
@@ -30,4 +42,7 @@ private:
 	std::unordered_map<PipelineID, std::unique_ptr<PipelineType>> pipelines_by_id;
 
 	VkPipelineLayout generic_pipeline_layout = nullptr;
+	VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+	std::unique_ptr<DerivedDataCache> derived_data_cache;
+	DerivedDataCache::Key pipeline_cache_key;
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "pipeline_id.hpp"
 #include "pipeline_modifiers.hpp"
 #include "graphics_engine/graphics_engine.hpp"
+#include "config.hpp"
+#include "task_pool.hpp"
 #include "utility.hpp"
 #include "pipelines.hpp"
 
@@ -11,7 +13,9 @@
 #include <quill/LogMacros.h>
 
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <span>
 
 
 GraphicsEnginePipelineManager::GraphicsEnginePipelineManager(GraphicsEngine& engine) :
@@ -34,13 +38,129 @@ GraphicsEnginePipelineManager::GraphicsEnginePipelineManager(GraphicsEngine& eng
 	{
 		throw std::runtime_error("failed to create pipeline layout!");
 	}
+
+	load_pipeline_cache();
 }
 
 GraphicsEnginePipelineManager::~GraphicsEnginePipelineManager()
 {
+	save_pipeline_cache();
+	vkDestroyPipelineCache(get_logical_device(), pipeline_cache, nullptr);
 	vkDestroyPipelineLayout(get_logical_device(), generic_pipeline_layout, nullptr);
 }
 
+void GraphicsEnginePipelineManager::load_pipeline_cache()
+{
+	const VkPhysicalDeviceProperties& properties =
+		get_graphics_engine().get_device_module().get_physical_device_properties().properties;
+	pipeline_cache_key = DerivedDataCache::KeyBuilder()
+		.add("VkPipelineCache")
+		.add(std::as_bytes(std::span(properties.pipelineCacheUUID)))
+		.add(properties.vendorID)
+		.add(properties.deviceID)
+		.add(properties.driverVersion)
+		.build();
+	if (Config::is_derived_data_cache_enabled())
+		derived_data_cache = std::make_unique<DerivedDataCache>(Utility::get_derived_data_path());
+
+	const auto entry = derived_data_cache ? derived_data_cache->find(pipeline_cache_key) : nullptr;
+	VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	if (entry && entry->get_section_count() == 1)
+	{
+		create_info.initialDataSize = entry->get_section(0).size();
+		create_info.pInitialData = entry->get_section(0).data();
+	}
+	if (vkCreatePipelineCache(get_logical_device(), &create_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+	{
+		// drivers may reject data they did not write, so start over empty
+		LOG_WARNING(Utility::get_logger(), "GraphicsEnginePipelineManager: discarding unusable pipeline cache");
+		create_info.initialDataSize = 0;
+		create_info.pInitialData = nullptr;
+		if (vkCreatePipelineCache(get_logical_device(), &create_info, nullptr, &pipeline_cache) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+	LOG_INFO(Utility::get_logger(), "GraphicsEnginePipelineManager: loaded {} bytes of pipeline cache",
+		create_info.initialDataSize);
+}
+
+void GraphicsEnginePipelineManager::save_pipeline_cache()
+{
+	if (!derived_data_cache || pipeline_cache == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	size_t size = 0;
+	std::vector<std::byte> data;
+	// the size may grow between the two calls if pipelines are still being
+	// created, in which case the data is incomplete and not worth keeping
+	if (vkGetPipelineCacheData(get_logical_device(), pipeline_cache, &size, nullptr) != VK_SUCCESS || size == 0)
+	{
+		return;
+	}
+	data.resize(size);
+	if (vkGetPipelineCacheData(get_logical_device(), pipeline_cache, &size, data.data()) != VK_SUCCESS)
+	{
+		return;
+	}
+	data.resize(size);
+
+	DerivedDataCache::EntryWriter writer;
+	writer.add_owned_section(std::move(data));
+	if (derived_data_cache->store(pipeline_cache_key, writer))
+	{
+		LOG_INFO(Utility::get_logger(), "GraphicsEnginePipelineManager: saved {} bytes of pipeline cache", size);
+	}
+}
+
+void GraphicsEnginePipelineManager::precompile_pipelines(const std::vector<PipelineID>& ids)
+{
+	std::vector<PipelineID> missing;
+	for (const PipelineID& id : ids)
+	{
+		if (!pipelines_by_id.contains(id))
+		{
+			missing.push_back(id);
+		}
+	}
+
+	// workers only create pipelines; the map is filled in here once they are done
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::unique_ptr<PipelineType>> created(missing.size());
+	TaskPool::get_shared().parallel_for(missing.size(), 1, [&](const size_t first, const size_t last)
+	{
+		for (size_t index = first; index < last; ++index)
+		{
+			try
+			{
+				created[index] = create_pipeline(missing[index]);
+			}
+			catch (const std::exception& error)
+			{
+				LOG_WARNING(Utility::get_logger(), "precompile_pipelines: {} {} failed: {}",
+					magic_enum::enum_name(missing[index].primary_pipeline_type),
+					magic_enum::enum_name(missing[index].pipeline_modifier),
+					error.what());
+			}
+		}
+	});
+
+	size_t created_count = 0;
+	for (size_t index = 0; index < missing.size(); ++index)
+	{
+		if (created[index])
+		{
+			pipelines_by_id.emplace(missing[index], std::move(created[index]));
+			++created_count;
+		}
+	}
+	LOG_INFO(Utility::get_logger(), "precompiled {} of {} pipelines in {} ms",
+		created_count, missing.size(),
+		std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
 GraphicsEnginePipeline* GraphicsEnginePipelineManager::fetch_pipeline(PipelineID id)
 {
 	auto it = pipelines_by_id.find(id);
@@ -56,6 +176,17 @@ std::unique_ptr<GraphicsEnginePipeline> GraphicsEnginePipelineManager::create_pi
 {
 	std::unique_ptr<PipelineType> new_pipeline;
 
+	// only these have instanced vertex shaders
+	if (id.instanced && (id.pipeline_modifier != EPipelineModifier::NONE
+		|| (id.primary_pipeline_type != ERenderType::COLOR
+			&& id.primary_pipeline_type != ERenderType::STANDARD)))
+	{
+		LOG_WARNING(Utility::get_logger(), "create_pipeline failed, pipeline cannot be instanced: {} {}",
+			magic_enum::enum_name(id.primary_pipeline_type),
+			magic_enum::enum_name(id.pipeline_modifier));
+		return new_pipeline;
+	}
+
 	switch (id.primary_pipeline_type)
 	{
 	case ERenderType::COLOR:
@@ -96,6 +227,7 @@ std::unique_ptr<GraphicsEnginePipeline> GraphicsEnginePipelineManager::create_pi
 	{
 		new_pipeline->set_alpha_mode(id.alpha_mode);
 		new_pipeline->set_double_sided(id.double_sided);
+		new_pipeline->set_instanced(id.instanced);
 		new_pipeline->initialise();
 		LOG_INFO(Utility::get_logger(), "created pipeline with id: {} {} {}",
 			magic_enum::enum_name(id.primary_pipeline_type),
@@ -0,0 +1,71 @@
+#include "pipeline_permutations.hpp"
+
+
+namespace
+{
+bool is_material_render_type(const ERenderType type)
+{
+	return type == ERenderType::COLOR || type == ERenderType::STANDARD || is_skinned_render_type(type);
+}
+}
+
+std::vector<PipelineID> PipelinePermutations::enumerate() const
+{
+	std::vector<PipelineID> ids;
+	for (const ERenderType render_type : render_types)
+	for (const EPipelineModifier modifier : modifiers)
+	for (const EAlphaMode alpha_mode : alpha_modes)
+	for (const EShadingMode shading_mode : shading_modes)
+	for (const bool sided : double_sided)
+	for (const bool is_instanced : instanced)
+	{
+		const PipelineID id{
+			.primary_pipeline_type = render_type,
+			.pipeline_modifier = modifier,
+			.alpha_mode = alpha_mode,
+			.shading_mode = shading_mode,
+			.double_sided = sided,
+			.instanced = is_instanced,
+		};
+		if (is_valid(id))
+			ids.push_back(id);
+	}
+	return ids;
+}
+
+bool PipelinePermutations::is_valid(const PipelineID& id)
+{
+	switch (id.primary_pipeline_type)
+	{
+	case ERenderType::UNASSIGNED:
+	case ERenderType::RAYTRACING:
+		return false;
+	default:
+		break;
+	}
+	const bool material = is_material_render_type(id.primary_pipeline_type);
+	// modifiers need the vertex layouts only material pipelines have
+	if (id.pipeline_modifier != EPipelineModifier::NONE && !material)
+		return false;
+	// only these have instanced vertex shaders
+	if (id.instanced && (id.pipeline_modifier != EPipelineModifier::NONE
+		|| (id.primary_pipeline_type != ERenderType::COLOR && id.primary_pipeline_type != ERenderType::STANDARD)))
+		return false;
+	// renderers request every other pipeline as lit
+	if (id.shading_mode == EShadingMode::UNLIT)
+		return material && (id.pipeline_modifier == EPipelineModifier::NONE
+			|| id.pipeline_modifier == EPipelineModifier::POST_STENCIL);
+	return true;
+}
+
+PipelinePermutations PipelinePermutations::for_materials()
+{
+	return {
+		.render_types = { ERenderType::COLOR, ERenderType::STANDARD, ERenderType::SKINNED, ERenderType::SKINNED_COLOR },
+		.modifiers = { EPipelineModifier::NONE, EPipelineModifier::SHADOW_MAP },
+		.alpha_modes = { EAlphaMode::OPAQUE, EAlphaMode::MASK, EAlphaMode::BLEND },
+		.shading_modes = { EShadingMode::LIT, EShadingMode::UNLIT },
+		.double_sided = { false, true },
+		.instanced = { false, true },
+	};
+}
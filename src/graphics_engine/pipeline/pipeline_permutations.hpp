@@ -0,0 +1,27 @@
+#pragma once
+
+#include "pipeline_id.hpp"
+
+#include <vector>
+
+
+// Values of each PipelineID field to combine when precompiling pipelines.
+// Combinations that have no pipeline of their own, or that renderers never
+// request, are left out of enumerate().
+struct PipelinePermutations
+{
+	std::vector<ERenderType> render_types;
+	std::vector<EPipelineModifier> modifiers = { EPipelineModifier::NONE };
+	std::vector<EAlphaMode> alpha_modes = { EAlphaMode::OPAQUE };
+	std::vector<EShadingMode> shading_modes = { EShadingMode::LIT };
+	std::vector<bool> double_sided = { false };
+	std::vector<bool> instanced = { false };
+
+	std::vector<PipelineID> enumerate() const;
+
+	// Whether id names a pipeline GraphicsEnginePipelineManager can create
+	// and renderers can request; see Renderer::draw_renderable
+	static bool is_valid(const PipelineID& id);
+	// Every material pipeline drawn by the rasterization and shadow map renderers
+	static PipelinePermutations for_materials();
+};
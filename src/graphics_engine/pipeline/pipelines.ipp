@@ -699,7 +699,7 @@ std::vector<VkVertexInputAttributeDescription> ParticlePipeline::get_attribute_d
 	world_pos_attr.binding = 1;
 	world_pos_attr.location = 2;
 	world_pos_attr.format = VK_FORMAT_R32G32B32_SFLOAT;
-	world_pos_attr.offset = offsetof(SDS::ParticleInstanceData, model) + sizeof(glm::vec4) * 3; // Position is in 4th column of mat4
+	world_pos_attr.offset = offsetof(SDS::ParticleInstanceData, position);
 	attributes.push_back(world_pos_attr);
 
 	VkVertexInputAttributeDescription size_attr{};
@@ -10,6 +10,7 @@
 struct QueueFamilyIndices {
 	std::optional<uint32_t> graphicsFamily;
 	std::optional<uint32_t> presentFamily; // as in present image to the window surface
+	std::optional<uint32_t> transferFamily; // transfer only, if the device has such a family
 
 	bool isComplete()
 	{
@@ -2,29 +2,81 @@
 
 #include "graphics_renderable.hpp"
 
+#include "maths.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
 #include <algorithm>
-#include <ranges>
-#include <tuple>
-
-
-bool RenderSortKey::operator<(const RenderSortKey& other) const
-{
-	return std::tie(
-		render_type,
-		shading_mode,
-		alpha_mode,
-		double_sided,
-		mesh_id,
-		material_ids,
-		renderable_id)
-		< std::tie(
-		other.render_type,
-		other.shading_mode,
-		other.alpha_mode,
-		other.double_sided,
-		other.mesh_id,
-		other.material_ids,
-		other.renderable_id);
+#include <array>
+#include <bit>
+#include <stdexcept>
+#include <utility>
+
+
+namespace
+{
+constexpr uint32_t RENDER_TYPE_SHIFT = 59;
+constexpr uint32_t SHADING_MODE_SHIFT = 58;
+constexpr uint32_t ALPHA_MODE_SHIFT = 56;
+constexpr uint32_t DOUBLE_SIDED_SHIFT = 55;
+constexpr uint32_t MESH_RANK_SHIFT = RenderSortKey::RANK_BITS;
+constexpr uint32_t MATERIAL_SET_RANK_SHIFT = 0;
+
+uint32_t key_field(const uint64_t key, const uint32_t shift, const uint32_t bits)
+{
+	return static_cast<uint32_t>((key >> shift) & ((uint64_t(1) << bits) - 1));
+}
+
+size_t hash_material_set(const RenderableDefinition& renderable)
+{
+	size_t hash = renderable.material_owners.size();
+	for (const auto& owner : renderable.material_owners)
+	{
+		const size_t id_hash = std::hash<MaterialID>()(owner->get_id());
+		hash ^= id_hash + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+bool same_material_set(const RenderableDefinition& lhs, const RenderableDefinition& rhs)
+{
+	return std::ranges::equal(
+		lhs.material_owners,
+		rhs.material_owners,
+		{},
+		[](const MaterialHandle& owner) { return owner->get_id(); },
+		[](const MaterialHandle& owner) { return owner->get_id(); });
+}
+}
+
+ERenderType RenderSortKey::render_type() const
+{
+	return static_cast<ERenderType>(key_field(value, RENDER_TYPE_SHIFT, 5));
+}
+
+EShadingMode RenderSortKey::shading_mode() const
+{
+	return static_cast<EShadingMode>(key_field(value, SHADING_MODE_SHIFT, 1));
+}
+
+EAlphaMode RenderSortKey::alpha_mode() const
+{
+	return static_cast<EAlphaMode>(key_field(value, ALPHA_MODE_SHIFT, 2));
+}
+
+bool RenderSortKey::double_sided() const
+{
+	return key_field(value, DOUBLE_SIDED_SHIFT, 1) != 0;
+}
+
+uint32_t RenderSortKey::mesh_rank() const
+{
+	return key_field(value, MESH_RANK_SHIFT, RANK_BITS);
+}
+
+uint32_t RenderSortKey::material_set_rank() const
+{
+	return key_field(value, MATERIAL_SET_RANK_SHIFT, RANK_BITS);
 }
 
 EAlphaMode renderable_alpha_mode(const RenderableDefinition& renderable)
@@ -65,18 +117,19 @@ bool renderable_casts_shadow(const RenderableDefinition& renderable)
 }
 
 RenderSortKey make_render_sort_key(
-	const RenderableID renderable_id,
-	const RenderableDefinition& renderable)
-{
-	return {
-		.render_type = renderable.pipeline_render_type,
-		.shading_mode = renderable.shading_mode,
-		.alpha_mode = renderable_alpha_mode(renderable),
-		.double_sided = renderable_double_sided(renderable),
-		.mesh_id = renderable.get_mesh_id(),
-		.material_ids = renderable.get_material_ids(),
-		.renderable_id = renderable_id,
-	};
+	const RenderableDefinition& renderable,
+	const uint32_t mesh_rank,
+	const uint32_t material_set_rank)
+{
+	if (mesh_rank > RenderSortKey::MAX_RANK || material_set_rank > RenderSortKey::MAX_RANK)
+		throw std::out_of_range("Render sort key rank does not fit in its field");
+	return { .value =
+		uint64_t(renderable.pipeline_render_type) << RENDER_TYPE_SHIFT
+		| uint64_t(renderable.shading_mode) << SHADING_MODE_SHIFT
+		| uint64_t(renderable_alpha_mode(renderable)) << ALPHA_MODE_SHIFT
+		| uint64_t(renderable_double_sided(renderable)) << DOUBLE_SIDED_SHIFT
+		| uint64_t(mesh_rank) << MESH_RANK_SHIFT
+		| uint64_t(material_set_rank) << MATERIAL_SET_RANK_SHIFT };
 }
 
 float renderable_distance_squared(
@@ -87,6 +140,141 @@ float renderable_distance_squared(
 	return glm::dot(delta, delta);
 }
 
+uint64_t make_blended_sort_key(const float distance_squared, const uint32_t state_rank)
+{
+	const uint32_t distance_bits = std::bit_cast<uint32_t>(distance_squared);
+	return uint64_t(~distance_bits) << 32 | state_rank;
+}
+
+void radix_sort(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch)
+{
+	constexpr int PASS_COUNT = 8;
+	constexpr size_t BUCKET_COUNT = 256;
+	std::array<std::array<uint32_t, BUCKET_COUNT>, PASS_COUNT> counts{};
+	for (const DrawSortEntry& entry : entries)
+		for (int pass = 0; pass < PASS_COUNT; ++pass)
+			++counts[pass][(entry.key >> (pass * 8)) & 0xff];
+
+	scratch.resize(entries.size());
+	for (int pass = 0; pass < PASS_COUNT; ++pass)
+	{
+		auto& buckets = counts[pass];
+		const uint32_t shift = pass * 8;
+		if (entries.empty() || buckets[(entries.front().key >> shift) & 0xff] == entries.size())
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : buckets)
+			offset += std::exchange(bucket, offset);
+		for (const DrawSortEntry& entry : entries)
+			scratch[buckets[(entry.key >> shift) & 0xff]++] = entry;
+		entries.swap(scratch);
+	}
+}
+
+glm::vec3 shadow_light_position(const RenderFrame& frame)
+{
+	return frame.active_light ? frame.active_light->position : glm::vec3(0.0f, 5.0f, 0.0f);
+}
+
+std::array<glm::mat4, POINT_SHADOW_FACE_COUNT> make_point_shadow_view_projections(
+	const glm::vec3& light_position)
+{
+	const std::array<glm::vec3, POINT_SHADOW_FACE_COUNT> directions = {
+		Maths::right_vec,
+		-Maths::right_vec,
+		Maths::up_vec,
+		-Maths::up_vec,
+		Maths::forward_vec,
+		-Maths::forward_vec
+	};
+	const std::array<glm::vec3, POINT_SHADOW_FACE_COUNT> ups = {
+		Maths::up_vec,
+		Maths::up_vec,
+		-Maths::forward_vec,
+		Maths::forward_vec,
+		Maths::up_vec,
+		Maths::up_vec
+	};
+
+	const glm::mat4 projection = glm::perspectiveLH(
+		Maths::deg2rad(90.0f),
+		1.0f,
+		0.1f,
+		POINT_SHADOW_FAR_PLANE);
+	std::array<glm::mat4, POINT_SHADOW_FACE_COUNT> view_projections;
+	for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+		view_projections[face] = projection * glm::lookAtLH(
+			light_position,
+			light_position + directions[face],
+			ups[face]);
+	return view_projections;
+}
+
+bool renderable_instanceable(const RenderableDefinition& renderable)
+{
+	return (renderable.pipeline_render_type == ERenderType::COLOR
+		|| renderable.pipeline_render_type == ERenderType::STANDARD)
+		&& !renderable.skeleton_id;
+}
+
+bool can_share_instanced_draw(const GraphicsDrawItem& lhs, const GraphicsDrawItem& rhs)
+{
+	return lhs.sort_key == rhs.sort_key
+		&& lhs.renderable->opacity == rhs.renderable->opacity;
+}
+
+void DrawBatcher::batch(
+	const std::vector<const GraphicsDrawItem*>& list,
+	const RenderableStateList& states,
+	const glm::mat4& view_projection,
+	const std::function<bool(const GraphicsDrawItem&)>& can_instance,
+	std::vector<DrawBatch>& batches)
+{
+	batches.clear();
+	// The last batch may still grow into an instanced draw. Its first
+	// instance is packed up front and dropped again if nothing joins it.
+	bool open = false;
+	const auto close = [&] {
+		if (open && batches.back().instance_count == 1)
+			instances.pop_back();
+		else if (open)
+			batches.back().instanced = true;
+		open = false;
+	};
+
+	for (const GraphicsDrawItem* item : list)
+	{
+		const RenderableState& state = states[item->state_index];
+		if (!state.visible)
+			continue;
+
+		const bool instanceable = instances.size() < instance_capacity
+			&& renderable_instanceable(*item->renderable)
+			&& can_instance(*item);
+		if (instanceable && open && can_share_instanced_draw(*batches.back().item, *item))
+		{
+			++batches.back().instance_count;
+		}
+		else
+		{
+			close();
+			batches.push_back({
+				.item = item,
+				.first_instance = static_cast<uint32_t>(instances.size()),
+			});
+			open = instanceable;
+			if (!open)
+				continue;
+		}
+		instances.push_back({
+			.model = state.model_transform,
+			.mvp = view_projection * state.model_transform,
+		});
+	}
+	close();
+}
+
 void GraphicsDrawLists::rebuild(
 	const std::unordered_map<RenderableID, std::unique_ptr<GraphicsRenderable>>& renderables)
 {
@@ -98,13 +286,41 @@ void GraphicsDrawLists::rebuild(
 	shadow_items.clear();
 	items.reserve(renderables.size());
 
+	unsorted_renderables.clear();
+	sort_entries.clear();
 	for (const auto& [id, graphics_renderable] : renderables)
 	{
-		const auto& definition = graphics_renderable->get_definition();
+		sort_entries.push_back({
+			.key = id.get_underlying(),
+			.index = static_cast<uint32_t>(unsorted_renderables.size()),
+		});
+		unsorted_renderables.push_back(graphics_renderable.get());
+	}
+	radix_sort(sort_entries, sort_scratch);
+
+	// Ranking in renderable ID order makes the keys independent of the map's
+	// iteration order
+	mesh_ranks.clear();
+	material_set_ranks.clear();
+	material_set_owners.clear();
+	for (DrawSortEntry& entry : sort_entries)
+	{
+		const auto& definition = unsorted_renderables[entry.index]->get_definition();
+		entry.key = make_render_sort_key(
+			definition,
+			rank_mesh(definition),
+			rank_material_set(definition)).value;
+	}
+	// Stable, so equal keys stay in renderable ID order
+	radix_sort(sort_entries, sort_scratch);
+
+	for (const DrawSortEntry& entry : sort_entries)
+	{
+		const GraphicsRenderable* graphics_renderable = unsorted_renderables[entry.index];
 		items.push_back({
-			.graphics_renderable = graphics_renderable.get(),
-			.renderable = &definition,
-			.sort_key = make_render_sort_key(id, definition),
+			.graphics_renderable = graphics_renderable,
+			.renderable = &graphics_renderable->get_definition(),
+			.sort_key = { .value = entry.key },
 		});
 	}
 
@@ -128,11 +344,110 @@ void GraphicsDrawLists::rebuild(
 		if (renderable_casts_shadow(*item.renderable))
 			shadow_items.push_back(&item);
 	}
+}
 
-	const auto state_order = [](const GraphicsDrawItem* lhs, const GraphicsDrawItem* rhs) {
-		return lhs->sort_key < rhs->sort_key;
+uint32_t GraphicsDrawLists::rank_mesh(const RenderableDefinition& renderable)
+{
+	const auto rank = static_cast<uint32_t>(mesh_ranks.size());
+	return mesh_ranks.try_emplace(renderable.get_mesh_id(), rank).first->second;
+}
+
+uint32_t GraphicsDrawLists::rank_material_set(const RenderableDefinition& renderable)
+{
+	const size_t hash = hash_material_set(renderable);
+	const auto [first, last] = material_set_ranks.equal_range(hash);
+	for (auto it = first; it != last; ++it)
+		if (same_material_set(*material_set_owners[it->second], renderable))
+			return it->second;
+
+	const auto rank = static_cast<uint32_t>(material_set_owners.size());
+	material_set_ranks.emplace(hash, rank);
+	material_set_owners.push_back(&renderable);
+	return rank;
+}
+
+void GraphicsDrawLists::index_states(
+	const std::unordered_map<RenderableID, uint32_t>& state_indices)
+{
+	for (auto& item : items)
+		item.state_index = state_indices.at(item.renderable->id);
+}
+
+void GraphicsDrawLists::cull(
+	const RenderableStateList& states,
+	const glm::vec3& camera_position,
+	const Frustum& camera,
+	const std::array<Frustum, POINT_SHADOW_FACE_COUNT>& shadow_faces)
+{
+	constexpr uint8_t CAMERA_BIT = 1;
+	constexpr uint8_t SHADOW_BITS = ((1 << POINT_SHADOW_FACE_COUNT) - 1) << 1;
+	const auto shadow_face_bit = [](const size_t face) {
+		return static_cast<uint8_t>(1 << (face + 1));
 	};
-	std::ranges::sort(opaque_items, state_order);
-	std::ranges::sort(overlay_opaque_items, state_order);
-	std::ranges::sort(shadow_items, state_order);
+
+	item_visibility.assign(items.size(), 0);
+	bounded_items.clear();
+	culler.clear();
+	culler.reserve(items.size());
+	for (uint32_t index = 0; index < items.size(); ++index)
+	{
+		const auto& bounds = states[items[index].state_index].world_bounds;
+		if (!bounds)
+		{
+			item_visibility[index] = CAMERA_BIT | SHADOW_BITS;
+			continue;
+		}
+		culler.add(*bounds);
+		bounded_items.push_back(index);
+	}
+
+	const auto mark_visible = [this](const Frustum& frustum, const uint8_t bit) {
+		culler.cull(frustum, culled_boxes);
+		for (const uint32_t box : culled_boxes)
+			item_visibility[bounded_items[box]] |= bit;
+	};
+	mark_visible(camera, CAMERA_BIT);
+	for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+		mark_visible(shadow_faces[face], shadow_face_bit(face));
+
+	const auto filter = [this](
+		const std::vector<const GraphicsDrawItem*>& source,
+		std::vector<const GraphicsDrawItem*>& visible,
+		const uint8_t bits)
+	{
+		visible.clear();
+		for (const GraphicsDrawItem* item : source)
+			if (item_visibility[item - items.data()] & bits)
+				visible.push_back(item);
+	};
+	filter(opaque_items, visible_opaque_items, CAMERA_BIT);
+	filter(blended_items, visible_blended_items, CAMERA_BIT);
+	filter(overlay_opaque_items, visible_overlay_opaque_items, CAMERA_BIT);
+	filter(overlay_blended_items, visible_overlay_blended_items, CAMERA_BIT);
+	filter(shadow_items, visible_shadow_items, SHADOW_BITS);
+	for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+		filter(shadow_items, visible_shadow_face_items[face], shadow_face_bit(face));
+
+	sort_back_to_front(visible_blended_items, states, camera_position);
+	sort_back_to_front(visible_overlay_blended_items, states, camera_position);
+}
+
+void GraphicsDrawLists::sort_back_to_front(
+	std::vector<const GraphicsDrawItem*>& list,
+	const RenderableStateList& states,
+	const glm::vec3& camera_position)
+{
+	sort_entries.clear();
+	for (const GraphicsDrawItem* item : list)
+	{
+		// items are in state order, so an item's index is its state rank
+		const auto index = static_cast<uint32_t>(item - items.data());
+		const float distance = renderable_distance_squared(
+			camera_position,
+			states[item->state_index].model_transform);
+		sort_entries.push_back({ .key = make_blended_sort_key(distance, index), .index = index });
+	}
+	radix_sort(sort_entries, sort_scratch);
+	for (size_t position = 0; position < list.size(); ++position)
+		list[position] = &items[sort_entries[position].index];
 }
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "collision/frustum.hpp"
 #include "identifications.hpp"
 #include "render_frame.hpp"
+#include "shared_data_structures.hpp"
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
+#include <array>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -22,17 +26,25 @@ enum class RenderableDrawClass
 	OVERLAY_BLENDED,
 };
 
+// Pipeline state and bound resources packed into one integer, most
+// significant first: render type, shading mode, alpha mode, double-sidedness,
+// then the ranks of the mesh and of the material set among the drawn
+// renderables. Ascending keys group draws by pipeline, then by resources.
 struct RenderSortKey
 {
-	ERenderType render_type;
-	EShadingMode shading_mode;
-	EAlphaMode alpha_mode;
-	bool double_sided;
-	MeshID mesh_id;
-	std::vector<MaterialID> material_ids;
-	RenderableID renderable_id;
-
-	bool operator<(const RenderSortKey& other) const;
+	static constexpr uint32_t RANK_BITS = 24;
+	static constexpr uint32_t MAX_RANK = (1u << RANK_BITS) - 1;
+
+	ERenderType render_type() const;
+	EShadingMode shading_mode() const;
+	EAlphaMode alpha_mode() const;
+	bool double_sided() const;
+	uint32_t mesh_rank() const;
+	uint32_t material_set_rank() const;
+
+	auto operator<=>(const RenderSortKey& other) const = default;
+
+	uint64_t value = 0;
 };
 
 EAlphaMode renderable_alpha_mode(const RenderableDefinition& renderable);
@@ -41,17 +53,84 @@ bool renderable_double_sided(const RenderableDefinition& renderable);
 RenderableDrawClass classify_renderable(const RenderableDefinition& renderable);
 bool renderable_casts_shadow(const RenderableDefinition& renderable);
 RenderSortKey make_render_sort_key(
-	RenderableID renderable_id,
-	const RenderableDefinition& renderable);
+	const RenderableDefinition& renderable,
+	uint32_t mesh_rank,
+	uint32_t material_set_rank);
 float renderable_distance_squared(
 	const glm::vec3& camera_position,
 	const glm::mat4& model_transform);
+// Orders blended draws back to front, then by state_rank. Non-negative floats
+// compare like their bit patterns, so the distance needs no quantising.
+uint64_t make_blended_sort_key(float distance_squared, uint32_t state_rank);
+
+struct DrawSortEntry
+{
+	uint64_t key;
+	uint32_t index;
+};
+
+// Stable least significant digit radix sort on key, a byte per pass. Passes
+// over bytes every key shares are skipped. scratch is reused between calls.
+void radix_sort(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch);
+
+// The point light shadow map is a cube map with one face per axis direction
+inline constexpr size_t POINT_SHADOW_FACE_COUNT = 6;
+inline constexpr float POINT_SHADOW_FAR_PLANE = 256.0f;
+// Position shadows are rendered from, with a fixed fallback when the frame has
+// no active light
+glm::vec3 shadow_light_position(const RenderFrame& frame);
+std::array<glm::mat4, POINT_SHADOW_FACE_COUNT> make_point_shadow_view_projections(
+	const glm::vec3& light_position);
 
 struct GraphicsDrawItem
 {
 	const GraphicsRenderable* graphics_renderable;
 	const RenderableDefinition* renderable;
 	RenderSortKey sort_key;
+	// Index of the renderable's state in the accepted render frame
+	uint32_t state_index = 0;
+};
+
+// Whether the renderable's pipeline has an instanced variant
+bool renderable_instanceable(const RenderableDefinition& renderable);
+// Items with equal sort keys share pipeline state, mesh and materials, so one
+// instanced draw can stand in for both when their opacity matches too
+bool can_share_instanced_draw(const GraphicsDrawItem& lhs, const GraphicsDrawItem& rhs);
+
+// A draw of item, or with instanced set, an instanced draw of instance_count
+// items like it whose transforms start at first_instance in the instances
+struct DrawBatch
+{
+	const GraphicsDrawItem* item;
+	uint32_t first_instance = 0;
+	uint32_t instance_count = 1;
+	bool instanced = false;
+};
+
+// Coalesces consecutive draw items into instanced draws and packs their
+// per-instance transforms for a frame's instance buffer.
+class DrawBatcher
+{
+public:
+	explicit DrawBatcher(uint32_t instance_capacity) : instance_capacity(instance_capacity) {}
+
+	// Starts a frame, dropping the instances of the previous one
+	void clear() { instances.clear(); }
+	// Replaces batches with the visible items of list in order. Items that
+	// can_instance rejects, or that match neither neighbour, are drawn alone,
+	// as are all items once the instance capacity is reached.
+	void batch(
+		const std::vector<const GraphicsDrawItem*>& list,
+		const RenderableStateList& states,
+		const glm::mat4& view_projection,
+		const std::function<bool(const GraphicsDrawItem&)>& can_instance,
+		std::vector<DrawBatch>& batches);
+
+	const std::vector<SDS::InstanceData>& get_instances() const { return instances; }
+
+private:
+	uint32_t instance_capacity;
+	std::vector<SDS::InstanceData> instances;
 };
 
 class GraphicsDrawLists
@@ -60,6 +139,8 @@ public:
 	void rebuild(
 		const std::unordered_map<RenderableID, std::unique_ptr<GraphicsRenderable>>& renderables);
 
+	// In state order: ascending sort key, then ascending renderable ID. The
+	// lists below keep that order.
 	const std::vector<GraphicsDrawItem>& all() const { return items; }
 	const std::vector<const GraphicsDrawItem*>& opaque() const { return opaque_items; }
 	const std::vector<const GraphicsDrawItem*>& blended() const { return blended_items; }
@@ -73,11 +154,69 @@ public:
 	}
 	const std::vector<const GraphicsDrawItem*>& shadow() const { return shadow_items; }
 
+	// Points every item at its state in frames indexed by state_indices. Needed
+	// after rebuild and whenever the frame's renderable order changes.
+	void index_states(const std::unordered_map<RenderableID, uint32_t>& state_indices);
+	// Narrows the lists to the items whose world bounds intersect the camera
+	// frustum, and the shadow list to those inside any shadow cube map face.
+	// Items without bounds are always visible. The visible blended lists are
+	// sorted back to front from camera_position; the others keep state order.
+	void cull(
+		const RenderableStateList& states,
+		const glm::vec3& camera_position,
+		const Frustum& camera,
+		const std::array<Frustum, POINT_SHADOW_FACE_COUNT>& shadow_faces);
+	const std::vector<const GraphicsDrawItem*>& visible_opaque() const { return visible_opaque_items; }
+	const std::vector<const GraphicsDrawItem*>& visible_blended() const { return visible_blended_items; }
+	const std::vector<const GraphicsDrawItem*>& visible_overlay_opaque() const
+	{
+		return visible_overlay_opaque_items;
+	}
+	const std::vector<const GraphicsDrawItem*>& visible_overlay_blended() const
+	{
+		return visible_overlay_blended_items;
+	}
+	// Shadow casters inside one cube map face, or inside any of them
+	const std::vector<const GraphicsDrawItem*>& visible_shadow(size_t face) const
+	{
+		return visible_shadow_face_items.at(face);
+	}
+	const std::vector<const GraphicsDrawItem*>& visible_shadow() const { return visible_shadow_items; }
+
 private:
+	uint32_t rank_mesh(const RenderableDefinition& renderable);
+	uint32_t rank_material_set(const RenderableDefinition& renderable);
+	void sort_back_to_front(
+		std::vector<const GraphicsDrawItem*>& list,
+		const RenderableStateList& states,
+		const glm::vec3& camera_position);
+
 	std::vector<GraphicsDrawItem> items;
 	std::vector<const GraphicsDrawItem*> opaque_items;
 	std::vector<const GraphicsDrawItem*> blended_items;
 	std::vector<const GraphicsDrawItem*> overlay_opaque_items;
 	std::vector<const GraphicsDrawItem*> overlay_blended_items;
 	std::vector<const GraphicsDrawItem*> shadow_items;
+
+	// Per item, one bit for the camera and one for each shadow face
+	std::vector<uint8_t> item_visibility;
+	std::vector<uint32_t> bounded_items;
+	std::vector<uint32_t> culled_boxes;
+	FrustumCuller culler;
+	std::vector<const GraphicsDrawItem*> visible_opaque_items;
+	std::vector<const GraphicsDrawItem*> visible_blended_items;
+	std::vector<const GraphicsDrawItem*> visible_overlay_opaque_items;
+	std::vector<const GraphicsDrawItem*> visible_overlay_blended_items;
+	std::vector<const GraphicsDrawItem*> visible_shadow_items;
+	std::array<std::vector<const GraphicsDrawItem*>, POINT_SHADOW_FACE_COUNT> visible_shadow_face_items;
+
+	// Rebuild and sorting scratch, kept to avoid reallocating
+	std::vector<const GraphicsRenderable*> unsorted_renderables;
+	std::vector<DrawSortEntry> sort_entries;
+	std::vector<DrawSortEntry> sort_scratch;
+	// Ranks in order of first use, interned by ID and by a hash of the
+	// material IDs with the first renderable using each set to compare against
+	std::unordered_map<MeshID, uint32_t> mesh_ranks;
+	std::unordered_multimap<size_t, uint32_t> material_set_ranks;
+	std::vector<const RenderableDefinition*> material_set_owners;
 };
@@ -192,63 +192,64 @@ void RasterizationRenderer::submit_draw_commands(
 		const auto object_id = item.graphics_renderable->get_object_id();
 		return object_id && stenciled_ids.contains(*object_id);
 	};
-	const auto skip_regular_draw = [&](const GraphicsDrawItem& item) {
-		return !item.graphics_renderable->get_visibility();
-	};
 	const auto draw_item = [&](const GraphicsDrawItem& item, const DrawStyle style) {
 		draw_renderable(
 			command_buffer,
 			*item.renderable,
-			item.graphics_renderable->get_frame_dset(frame_index),
+			*item.graphics_renderable,
 			item.graphics_renderable->get_dset(),
 			style.modifier,
 			ERenderType::UNASSIGNED,
 			style.shading_override);
 	};
 
-	for (const GraphicsDrawItem* item : draw_lists.opaque())
-	{
-		if (skip_regular_draw(*item))
-			continue;
-		draw_item(*item, regular_style(*item));
-	}
-
-	const glm::vec3 camera_position =
-		get_graphics_engine().get_render_frame().camera.position;
-	const auto blended_order = [&camera_position](
-		const GraphicsDrawItem* lhs,
-		const GraphicsDrawItem* rhs)
-	{
-		const float lhs_distance = renderable_distance_squared(
-			camera_position,
-			lhs->graphics_renderable->get_model_transform());
-		const float rhs_distance = renderable_distance_squared(
-			camera_position,
-			rhs->graphics_renderable->get_model_transform());
-		if (lhs_distance != rhs_distance)
-			return lhs_distance > rhs_distance;
-		return lhs->sort_key < rhs->sort_key;
+	// Runs of identical renderables are drawn instanced. Stencil-selected and
+	// wireframe draws keep their per-renderable pipelines.
+	const RenderFrame& render_frame = get_graphics_engine().get_render_frame();
+	const glm::mat4 view_projection = render_frame.camera.projection * render_frame.camera.view;
+	const auto can_instance = [&](const GraphicsDrawItem& item) {
+		return regular_style(item).modifier == EPipelineModifier::NONE;
+	};
+	const auto draw_batches = [&](const std::vector<DrawBatch>& batches) {
+		for (const DrawBatch& batch : batches)
+		{
+			const DrawStyle style = regular_style(*batch.item);
+			if (batch.instanced)
+				draw_renderable_instances(
+					command_buffer,
+					*batch.item->renderable,
+					batch.item->graphics_renderable->get_dset(),
+					batch.first_instance,
+					batch.instance_count,
+					style.shading_override);
+			else
+				draw_item(*batch.item, style);
+		}
 	};
+	draw_batcher.clear();
+	draw_batcher.batch(draw_lists.visible_opaque(), render_frame.renderables, view_projection, can_instance, opaque_batches);
+	draw_batcher.batch(draw_lists.visible_blended(), render_frame.renderables, view_projection, can_instance, blended_batches);
+	draw_batcher.batch(draw_lists.visible_overlay_opaque(), render_frame.renderables, view_projection, can_instance, overlay_opaque_batches);
+	draw_batcher.batch(draw_lists.visible_overlay_blended(), render_frame.renderables, view_projection, can_instance, overlay_blended_batches);
+	get_rsrc_mgr().write_to_instance_buffer(frame_index, draw_batcher.get_instances());
+	const VkDescriptorSet instance_dset = get_rsrc_mgr().get_instance_dset(frame_index);
+	vkCmdBindDescriptorSets(command_buffer,
+							VK_PIPELINE_BIND_POINT_GRAPHICS,
+							get_graphics_engine().get_pipeline_mgr().get_generic_pipeline_layout(),
+							SDS::RASTERIZATION_INSTANCE_SET_OFFSET,
+							1,
+							&instance_dset,
+							0,
+							nullptr);
 
-	std::vector blended_items = draw_lists.blended();
-	std::ranges::sort(blended_items, blended_order);
-	for (const GraphicsDrawItem* item : blended_items)
-		if (!skip_regular_draw(*item))
-			draw_item(*item, regular_style(*item));
+	draw_batches(opaque_batches);
+	draw_batches(blended_batches);
 	
 	if (get_graphics_engine().get_render_mode() == ERenderMode::RASTERIZED)
 	{
-		std::vector<const GraphicsDrawItem*> stencil_items;
-		stencil_items.reserve(draw_lists.all().size());
 		for (const auto& item : draw_lists.all())
 			if (item.graphics_renderable->get_visibility() && is_stenciled(item))
-				stencil_items.push_back(&item);
-		std::ranges::sort(stencil_items, [](const auto* lhs, const auto* rhs) {
-			return lhs->sort_key < rhs->sort_key;
-		});
-
-		for (const GraphicsDrawItem* item : stencil_items)
-			draw_item(*item, DrawStyle{ .modifier = EPipelineModifier::STENCIL });
+				draw_item(item, DrawStyle{ .modifier = EPipelineModifier::STENCIL });
 	}
 
 	// Render overlay renderables (gizmos etc.) on top after clearing depth.
@@ -262,15 +263,8 @@ void RasterizationRenderer::submit_draw_commands(
 		clear_rect.layerCount = 1;
 		vkCmdClearAttachments(command_buffer, 1, &clear_depth, 1, &clear_rect);
 
-		for (const GraphicsDrawItem* item : draw_lists.overlay_opaque())
-			if (!skip_regular_draw(*item))
-				draw_item(*item, regular_style(*item));
-
-		std::vector overlay_blended_items = draw_lists.overlay_blended();
-		std::ranges::sort(overlay_blended_items, blended_order);
-		for (const GraphicsDrawItem* item : overlay_blended_items)
-			if (!skip_regular_draw(*item))
-				draw_item(*item, regular_style(*item));
+		draw_batches(overlay_opaque_batches);
+		draw_batches(overlay_blended_batches);
 	}
 
 	// Render particles within the same render pass (skip in wireframe mode)
@@ -8,6 +8,7 @@
 #include "particle_renderer.ipp"
 #include "renderer_manager.ipp"
 #include "graphics_engine/graphics_engine.hpp"
+#include "graphics_engine/graphics_renderable.hpp"
 #include "graphics_engine/render_draw_list.hpp"
 #include "renderable/mesh.hpp"
 #include "renderable/material_group.hpp"
@@ -44,7 +45,7 @@ void Renderer::reset_draw_state()
 
 void Renderer::draw_renderable(VkCommandBuffer command_buffer,
 							   const RenderableDefinition& renderable,
-							   const VkDescriptorSet& object_dset,
+							   const GraphicsRenderable& graphics_renderable,
 							   const VkDescriptorSet& renderable_dset,
 							   EPipelineModifier pipeline_modifier,
 							   ERenderType primary_pipeline_override,
@@ -56,11 +57,10 @@ void Renderer::draw_renderable(VkCommandBuffer command_buffer,
 		|| pipeline_modifier == EPipelineModifier::POST_STENCIL;
 	const auto shading_mode = shading_affects_pipeline
 		? shading_override.value_or(renderable.shading_mode) : EShadingMode::LIT;
-	const EAlphaMode alpha_mode = renderable_alpha_mode(renderable);
-	const auto* pipeline = get_graphics_engine().get_pipeline_mgr().fetch_pipeline({
+	const auto* pipeline = bind_pipeline(command_buffer, {
 		.primary_pipeline_type = primary_pipeline_type,
 		.pipeline_modifier = pipeline_modifier,
-		.alpha_mode = alpha_mode,
+		.alpha_mode = renderable_alpha_mode(renderable),
 		.shading_mode = shading_mode,
 		.double_sided = renderable_double_sided(renderable),
 	});
@@ -69,7 +69,62 @@ void Renderer::draw_renderable(VkCommandBuffer command_buffer,
 		return;
 	}
 
-	if (bound_pipeline != pipeline->graphics_pipeline)
+	// binds object and bone data dset at this frame's offsets
+	const VkDescriptorSet frame_data_dset = graphics_renderable.get_frame_data_dset();
+	const auto& frame_data_offsets = graphics_renderable.get_frame_data_offsets();
+	vkCmdBindDescriptorSets(command_buffer,
+							VK_PIPELINE_BIND_POINT_GRAPHICS,
+							pipeline->pipeline_layout,
+							SDS::RASTERIZATION_PER_RENDERABLE_FRAME_SET_OFFSET,	// see SDS for more info
+							1,
+							&frame_data_dset,
+							frame_data_offsets.size(),
+							frame_data_offsets.data());
+
+	const Mesh& mesh = bind_renderable_resources(
+		command_buffer, *pipeline, renderable, renderable_dset, primary_pipeline_type);
+	vkCmdDrawIndexed(command_buffer,
+					 mesh.get_num_vertex_indices(),
+					 1,		// instance count
+					 0,		// first index
+					 0,		// first vertex index (used for offsetting and defines the lowest value of gl_VertexIndex)
+					 0);	// first instance, used as offset for instance rendering, defines the lower value of gl_InstanceIndex
+}
+
+void Renderer::draw_renderable_instances(VkCommandBuffer command_buffer,
+										 const RenderableDefinition& renderable,
+										 const VkDescriptorSet& renderable_dset,
+										 uint32_t first_instance,
+										 uint32_t instance_count,
+										 const std::optional<EShadingMode> shading_override)
+{
+	const auto* pipeline = bind_pipeline(command_buffer, {
+		.primary_pipeline_type = renderable.pipeline_render_type,
+		.alpha_mode = renderable_alpha_mode(renderable),
+		.shading_mode = shading_override.value_or(renderable.shading_mode),
+		.double_sided = renderable_double_sided(renderable),
+		.instanced = true,
+	});
+	if (!pipeline)
+	{
+		return;
+	}
+
+	// transforms come from the instance buffer, see SDS::RASTERIZATION_INSTANCE_SET_OFFSET
+	const Mesh& mesh = bind_renderable_resources(
+		command_buffer, *pipeline, renderable, renderable_dset, renderable.pipeline_render_type);
+	vkCmdDrawIndexed(command_buffer,
+					 mesh.get_num_vertex_indices(),
+					 instance_count,
+					 0,
+					 0,
+					 first_instance);
+}
+
+const GraphicsEnginePipeline* Renderer::bind_pipeline(VkCommandBuffer command_buffer, const PipelineID& id)
+{
+	const auto* pipeline = get_graphics_engine().get_pipeline_mgr().fetch_pipeline(id);
+	if (pipeline && bound_pipeline != pipeline->graphics_pipeline)
 	{
 		vkCmdBindPipeline(
 			command_buffer,
@@ -77,31 +132,27 @@ void Renderer::draw_renderable(VkCommandBuffer command_buffer,
 			pipeline->graphics_pipeline);
 		bound_pipeline = pipeline->graphics_pipeline;
 	}
+	return pipeline;
+}
 
-	// binds uniform buffer dset
-	vkCmdBindDescriptorSets(command_buffer,
-							VK_PIPELINE_BIND_POINT_GRAPHICS,
-							pipeline->pipeline_layout,
-							SDS::RASTERIZATION_PER_RENDERABLE_FRAME_SET_OFFSET,	// see SDS for more info
-							1,
-							&object_dset,
-							0,
-							nullptr);
-
+const Mesh& Renderer::bind_renderable_resources(VkCommandBuffer command_buffer,
+												const GraphicsEnginePipeline& pipeline,
+												const RenderableDefinition& renderable,
+												const VkDescriptorSet& renderable_dset,
+												ERenderType primary_pipeline_type)
+{
 	const Mesh& mesh = renderable.get_mesh();
 	if (bound_mesh != mesh.get_id())
 	{
-		const VkDeviceSize buffer_offset =
-			get_rsrc_mgr().get_vertex_buffer_offset(mesh.get_id());
-		const VkBuffer buffer = get_rsrc_mgr().get_vertex_buffer();
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, &buffer, &buffer_offset);
+		const auto vertices = get_rsrc_mgr().get_vertex_buffer_location(mesh.get_id());
+		const VkDeviceSize buffer_offset = vertices.slot.offset;
+		vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertices.buffer, &buffer_offset);
 
-		const VkDeviceSize index_buffer_offset =
-			get_rsrc_mgr().get_index_buffer_offset(mesh.get_id());
+		const auto indices = get_rsrc_mgr().get_index_buffer_location(mesh.get_id());
 		vkCmdBindIndexBuffer(
 			command_buffer,
-			get_rsrc_mgr().get_index_buffer(),
-			index_buffer_offset,
+			indices.buffer,
+			indices.slot.offset,
 			VK_INDEX_TYPE_UINT32);
 		bound_mesh = mesh.get_id();
 	}
@@ -109,7 +160,7 @@ void Renderer::draw_renderable(VkCommandBuffer command_buffer,
 	// binds renderable specific dsets, i.e. material group
 	vkCmdBindDescriptorSets(command_buffer, 
 							VK_PIPELINE_BIND_POINT_GRAPHICS, 					// unlike vertex buffer, descriptor sets are not unique to the graphics pipeline, compute pipeline is also possible
-							pipeline->pipeline_layout, 
+							pipeline.pipeline_layout, 
 							SDS::RASTERIZATION_HIGH_FREQ_PER_SHAPE_SET_OFFSET,  // see SDS for more info
 							1,
 							&renderable_dset,
@@ -133,17 +184,12 @@ void Renderer::draw_renderable(VkCommandBuffer command_buffer,
 			.alpha_cutoff = renderable_alpha_cutoff(renderable),
 			.opacity = renderable.opacity,
 			.premultiplied_base_color = premultiplied_base_color,
-			.alpha_mode = static_cast<int>(alpha_mode),
+			.alpha_mode = static_cast<int>(renderable_alpha_mode(renderable)),
 			.double_sided = renderable_double_sided(renderable),
 		};
-		vkCmdPushConstants(command_buffer, pipeline->pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT,
+		vkCmdPushConstants(command_buffer, pipeline.pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT,
 			0, sizeof(alpha_data), &alpha_data);
 	}
 
-	vkCmdDrawIndexed(command_buffer,
-					 mesh.get_num_vertex_indices(),
-					 1,		// instance count
-					 0,		// first index
-					 0,		// first vertex index (used for offsetting and defines the lowest value of gl_VertexIndex)
-					 0);	// first instance, used as offset for instance rendering, defines the lower value of gl_InstanceIndex
-};
+	return mesh;
+}
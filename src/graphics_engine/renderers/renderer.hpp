@@ -26,6 +26,7 @@ enum class ERendererType
 };
 
 class GraphicsEnginePipeline;
+class GraphicsRenderable;
 
 // A renderer is simply anything that submits draw commands and fills up a command buffer
 // Each renderer can only have ONE renderpass and each renderpass must be unique to the renderer
@@ -50,11 +51,19 @@ public:
 	
 	virtual void draw_renderable(VkCommandBuffer command_buffer,
 								 const RenderableDefinition& renderable,
-								 const VkDescriptorSet& object_dset,
+								 const GraphicsRenderable& graphics_renderable,
 								 const VkDescriptorSet& renderable_dset,
 								 EPipelineModifier pipeline_modifier,
 								 ERenderType primary_pipeline_override = ERenderType::UNASSIGNED,
 								 std::optional<EShadingMode> shading_override = std::nullopt);
+	// Draws instance_count copies of renderable whose transforms are in the
+	// bound instance buffer from first_instance on
+	void draw_renderable_instances(VkCommandBuffer command_buffer,
+								   const RenderableDefinition& renderable,
+								   const VkDescriptorSet& renderable_dset,
+								   uint32_t first_instance,
+								   uint32_t instance_count,
+								   std::optional<EShadingMode> shading_override = std::nullopt);
 	void reset_draw_state();
 
 protected:
@@ -70,6 +79,15 @@ protected:
 	std::vector<VkFramebuffer> frame_buffers;
 
 private:
+	// null if the pipeline could not be created
+	const GraphicsEnginePipeline* bind_pipeline(VkCommandBuffer command_buffer, const PipelineID& id);
+	// binds the mesh and materials and pushes the alpha constants
+	const Mesh& bind_renderable_resources(VkCommandBuffer command_buffer,
+										  const GraphicsEnginePipeline& pipeline,
+										  const RenderableDefinition& renderable,
+										  const VkDescriptorSet& renderable_dset,
+										  ERenderType primary_pipeline_type);
+
 	VkPipeline bound_pipeline = VK_NULL_HANDLE;
 	std::optional<MeshID> bound_mesh;
 };
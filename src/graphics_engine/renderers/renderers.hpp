@@ -2,6 +2,8 @@
 
 #include "renderer.hpp"
 #include "constants.hpp"
+#include "graphics_engine/render_draw_list.hpp"
+#include "graphics_engine/resource_manager/graphics_buffer_manager.hpp"
 
 #include <optional>
 
@@ -39,6 +41,13 @@ private:
 	std::vector<VkDescriptorSet> shadow_map_dsets;
 
 	VkSampler shadow_map_sampler;
+
+	// Reused between frames to keep their capacity
+	DrawBatcher draw_batcher{ GraphicsBufferManager::MAX_DRAW_INSTANCES };
+	std::vector<DrawBatch> opaque_batches;
+	std::vector<DrawBatch> blended_batches;
+	std::vector<DrawBatch> overlay_opaque_batches;
+	std::vector<DrawBatch> overlay_blended_batches;
 };
 
 class PresentationRenderer : public Renderer
@@ -126,7 +126,9 @@ void ShadowMapRenderer::submit_draw_commands(VkCommandBuffer command_buffer,
 
 
 	const auto& frame = get_graphics_engine().get_render_frame();
-	for (const GraphicsDrawItem* item : get_graphics_engine().get_draw_lists().shadow())
+	// the geometry shader emits every triangle to all six faces, so casters
+	// inside any face's frustum are drawn once
+	for (const GraphicsDrawItem* item : get_graphics_engine().get_draw_lists().visible_shadow())
 	{
 		if (!item->graphics_renderable->get_visibility())
 			continue;
@@ -138,7 +140,7 @@ void ShadowMapRenderer::submit_draw_commands(VkCommandBuffer command_buffer,
 		draw_renderable(
 			command_buffer,
 			*item->renderable,
-			item->graphics_renderable->get_frame_dset(frame_index),
+			*item->graphics_renderable,
 			item->graphics_renderable->get_dset(),
 			EPipelineModifier::SHADOW_MAP);
 	}
@@ -40,11 +40,15 @@ public: // accessors for specific descriptors/layouts
 	// const VkDescriptorSetLayout& get_mesh_data_dset_layout() const { return mesh_data_dset_layout; }
 	// const VkDescriptorSetLayout& get_raytracing_tlas_dset_layout() const { return raytracing_tlas_dset_layout; }
 
+	// The instance buffer is the last set, so rasterization pipelines need
+	// a device whose maxBoundDescriptorSets is above the Vulkan minimum of 4
+	static constexpr uint32_t RASTERIZATION_DESCRIPTOR_SET_COUNT = 5;
 	std::vector<VkDescriptorSetLayout> get_rasterization_descriptor_set_layouts() const;
 	// For ray tracing:
 	// std::vector<VkDescriptorSetLayout> get_raytracing_descriptor_set_layouts() const;
 
 	VkDescriptorSet get_global_dset(uint32_t frame_idx) const { return global_dsets[frame_idx]; }
+	VkDescriptorSet get_instance_dset(uint32_t frame_idx) const { return instance_dsets[frame_idx]; }
 	void bind_environment_lighting(const EnvironmentLightingTextures& textures);
 	// For ray tracing:
 	// VkDescriptorSet get_mesh_data_dset() const { return mesh_data_dset; }
@@ -52,25 +56,29 @@ public: // accessors for specific descriptors/layouts
 private:
 	void setup_descriptor_set_layouts();
 	void allocate_global_dset(VkBuffer global_buffer, const std::vector<uint32_t>& global_buffer_offsets);
+	void allocate_instance_dsets(const GraphicsBufferManager& buffer_manager);
 	// For ray tracing:
 	// void allocate_mesh_data_dset(VkBuffer mapping_buffer, VkBuffer vertex_buffer, VkBuffer index_buffer);
 
 	static constexpr uint32_t MAX_LOW_FREQ_DESCRIPTOR_SETS =
 		CSTS::UPPERBOUND_SWAPCHAIN_IMAGES; // for GUBO i.e. camera & lighting
+	static constexpr uint32_t MAX_INSTANCE_DESCRIPTOR_SETS = CSTS::UPPERBOUND_SWAPCHAIN_IMAGES;
 	static constexpr uint32_t MAX_RENDERABLE_INSTANCES =
 		GraphicsBufferManager::NUM_EXPECTED_RENDERABLES
 		* CSTS::MAX_CONCURRENT_RENDER_RESOURCE_SETS;
+	// one per renderable, shared by every frame through dynamic offsets
 	static constexpr uint32_t MAX_RENDERABLE_FRAME_DESCRIPTOR_SETS =
-		MAX_RENDERABLE_INSTANCES * CSTS::UPPERBOUND_SWAPCHAIN_IMAGES;
+		MAX_RENDERABLE_INSTANCES;
 	static constexpr uint32_t MAX_RENDERABLE_DESCRIPTOR_SETS =
 		MAX_RENDERABLE_INSTANCES;
 	// For ray tracing:
 	// static constexpr int MAX_RAY_TRACING_DESCRIPTOR_SETS = 1000;
 	// static constexpr int MAX_MESH_DATA_DESCRIPTOR_SETS = 1;
-	static constexpr uint32_t MAX_UNIFORM_BUFFER_DESCRIPTORS =
-		MAX_LOW_FREQ_DESCRIPTOR_SETS + MAX_RENDERABLE_FRAME_DESCRIPTOR_SETS;
+	static constexpr uint32_t MAX_UNIFORM_BUFFER_DESCRIPTORS = MAX_LOW_FREQ_DESCRIPTOR_SETS;
 	static constexpr uint32_t MAX_STORAGE_BUFFER_DESCRIPTORS =
-		MAX_RENDERABLE_FRAME_DESCRIPTOR_SETS + MAX_RENDERABLE_DESCRIPTOR_SETS;
+		MAX_RENDERABLE_DESCRIPTOR_SETS + MAX_INSTANCE_DESCRIPTOR_SETS;
+	// object data and bones of the per-renderable frame sets
+	static constexpr uint32_t MAX_DYNAMIC_BUFFER_DESCRIPTORS = MAX_RENDERABLE_FRAME_DESCRIPTOR_SETS;
 	// Texture composition is rare and consumes one set per layer. Keep a small
 	// engine-wide allowance instead of reserving the layer maximum for every
 	// possible renderable.
@@ -82,6 +90,7 @@ private:
 	static constexpr uint32_t MAX_IMGUI_DESCRIPTOR_SETS = 50;
 	static constexpr uint32_t MAX_DESCRIPTOR_SETS =
 		MAX_LOW_FREQ_DESCRIPTOR_SETS
+		+ MAX_INSTANCE_DESCRIPTOR_SETS
 		+ MAX_RENDERABLE_FRAME_DESCRIPTOR_SETS
 		+ MAX_RENDERABLE_DESCRIPTOR_SETS
 		+ MAX_COMPOSITOR_DESCRIPTOR_SETS
@@ -100,12 +109,15 @@ private:
 	VkDescriptorSetLayout shadow_map_dset_layout;
 	VkDescriptorSetLayout per_renderable_frame_dset_layout;
 	VkDescriptorSetLayout renderable_dset_layout;
+	VkDescriptorSetLayout instance_dset_layout;
 	// For ray tracing:
 	// VkDescriptorSetLayout mesh_data_dset_layout;
 	// VkDescriptorSetLayout raytracing_tlas_dset_layout;
 
 	// 1 dset per swapchain frame, currently only used for camera and global lighting
 	std::vector<VkDescriptorSet> global_dsets;
+	// 1 dset per swapchain frame, over that frame's slot of the instance buffer
+	std::vector<VkDescriptorSet> instance_dsets;
 	// For ray tracing:
 	// VkDescriptorSet mesh_data_dset;
 
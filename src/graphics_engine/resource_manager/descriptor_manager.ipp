@@ -23,8 +23,9 @@ static constexpr VkDescriptorSetLayoutBinding get_generic_global_binding()
 
 static constexpr VkDescriptorSetLayoutBinding get_renderable_frame_transform_binding()
 {
+	// the frame's transform is picked with a dynamic offset when binding
 	VkDescriptorSetLayoutBinding ubo_layout_binding{};
-	ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	ubo_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 	ubo_layout_binding.binding = SDS::RASTERIZATION_OBJECT_DATA_BINDING;
 	ubo_layout_binding.descriptorCount = 1;
 	ubo_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT; // defines which shader stage the descriptor is going to be referenced
@@ -59,9 +60,10 @@ static constexpr VkDescriptorSetLayoutBinding get_generic_texture_binding(const
 
 static constexpr VkDescriptorSetLayoutBinding get_generic_bone_binding()
 {
-	// buffer of bone data containing transformation matrices
+	// buffer of bone data containing transformation matrices, picked per frame
+	// with a dynamic offset when binding
 	VkDescriptorSetLayoutBinding bone_layout_binding{};
-	bone_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bone_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
 	bone_layout_binding.binding = SDS::RASTERIZATION_BONE_DATA_BINDING;
 	bone_layout_binding.descriptorCount = 1;
 	bone_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
@@ -138,6 +140,18 @@ static constexpr VkDescriptorSetLayoutBinding get_generic_shadow_map_binding()
 	return shadow_map_binding;
 }
 
+static constexpr VkDescriptorSetLayoutBinding get_generic_instance_binding()
+{
+	VkDescriptorSetLayoutBinding instance_binding{};
+	instance_binding.binding = SDS::RASTERIZATION_INSTANCE_DATA_BINDING;
+	instance_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	instance_binding.descriptorCount = 1;
+	instance_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	instance_binding.pImmutableSamplers = nullptr;
+
+	return instance_binding;
+}
+
 GraphicsDescriptorManager::GraphicsDescriptorManager(
 	GraphicsEngine& engine,
 	const GraphicsBufferManager& buffer_manager) :
@@ -154,6 +168,7 @@ GraphicsDescriptorManager::GraphicsDescriptorManager(
 		return offsets;
 	};
 	allocate_global_dset(buffer_manager.get_global_uniform_buffer(), get_gubo_offsets());
+	allocate_instance_dsets(buffer_manager);
 	// For ray tracing:
 	// allocate_mesh_data_dset(
 	// 	buffer_manager.get_mapping_buffer(),
@@ -255,10 +270,21 @@ void GraphicsDescriptorManager::create_descriptor_pool()
 	storage_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 	storage_buffer_pool_size.descriptorCount = MAX_STORAGE_BUFFER_DESCRIPTORS;
 
+	// for per-frame object data and bones
+	VkDescriptorPoolSize dynamic_uniform_buffer_pool_size{};
+	dynamic_uniform_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	dynamic_uniform_buffer_pool_size.descriptorCount = MAX_DYNAMIC_BUFFER_DESCRIPTORS;
+
+	VkDescriptorPoolSize dynamic_storage_buffer_pool_size{};
+	dynamic_storage_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	dynamic_storage_buffer_pool_size.descriptorCount = MAX_DYNAMIC_BUFFER_DESCRIPTORS;
+
 	std::vector<VkDescriptorPoolSize> pool_sizes {
 		uniform_buffer_pool_size, 
 		combined_image_sampler_pool_size,
-		storage_buffer_pool_size
+		storage_buffer_pool_size,
+		dynamic_uniform_buffer_pool_size,
+		dynamic_storage_buffer_pool_size
 	};
 	// For ray tracing:
 	// pool_sizes.push_back(tlas_pool_size);
@@ -287,12 +313,15 @@ void GraphicsDescriptorManager::create_descriptor_pool()
 std::vector<VkDescriptorSetLayout> GraphicsDescriptorManager::
 	get_rasterization_descriptor_set_layouts() const
 {
-	return { 
+	std::vector<VkDescriptorSetLayout> layouts{ 
 		low_freq_dset_layout,
 		per_renderable_frame_dset_layout,
 		renderable_dset_layout, 
-		shadow_map_dset_layout
+		shadow_map_dset_layout,
+		instance_dset_layout
 	};
+	assert(layouts.size() == RASTERIZATION_DESCRIPTOR_SET_COUNT);
+	return layouts;
 }
 
 // For ray tracing:
@@ -323,6 +352,7 @@ void GraphicsDescriptorManager::setup_descriptor_set_layouts()
 		get_generic_texture_binding(SDS::RASTERIZATION_METALLIC_ROUGHNESS_TEXTURE_DATA_BINDING),
 		get_generic_texture_binding(SDS::RASTERIZATION_EMISSIVE_TEXTURE_DATA_BINDING) });
 	shadow_map_dset_layout = request_dset_layout({ get_generic_shadow_map_binding() });
+	instance_dset_layout = request_dset_layout({ get_generic_instance_binding() });
 	// For ray tracing:
 	// mesh_data_dset_layout = request_dset_layout({
 	// 	get_generic_mesh_data_buffer_map_binding(),
@@ -424,6 +454,30 @@ void GraphicsDescriptorManager::allocate_global_dset(VkBuffer global_buffer, con
 	}
 }
 
+void GraphicsDescriptorManager::allocate_instance_dsets(const GraphicsBufferManager& buffer_manager)
+{
+	instance_dsets = reserve_dsets(
+		std::vector<VkDescriptorSetLayout>(MAX_INSTANCE_DESCRIPTOR_SETS, instance_dset_layout));
+
+	for (uint32_t frame_idx = 0; frame_idx < instance_dsets.size(); ++frame_idx)
+	{
+		VkDescriptorBufferInfo buffer_info{};
+		buffer_info.buffer = buffer_manager.get_instance_buffer();
+		buffer_info.offset = buffer_manager.get_instance_buffer_offset(frame_idx);
+		buffer_info.range = sizeof(SDS::InstanceData) * GraphicsBufferManager::MAX_DRAW_INSTANCES;
+
+		VkWriteDescriptorSet dset_write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+		dset_write.dstSet = instance_dsets[frame_idx];
+		dset_write.dstBinding = SDS::RASTERIZATION_INSTANCE_DATA_BINDING;
+		dset_write.dstArrayElement = 0;
+		dset_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		dset_write.descriptorCount = 1;
+		dset_write.pBufferInfo = &buffer_info;
+
+		vkUpdateDescriptorSets(get_logical_device(), 1, &dset_write, 0, nullptr);
+	}
+}
+
 // For ray tracing:
 // void GraphicsDescriptorManager::allocate_mesh_data_dset(
 // 	VkBuffer mapping_buffer, VkBuffer vertex_buffer, VkBuffer index_buffer)
@@ -0,0 +1,62 @@
+#include "frame_data_ring.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+
+namespace
+{
+size_t align_up(const size_t value, const size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+FrameDataRing::FrameDataRing(
+	std::byte* memory,
+	const size_t region_capacity,
+	const uint32_t region_count,
+	const size_t alignment) :
+	memory(memory),
+	region_capacity(align_up(region_capacity, alignment)),
+	region_count(region_count),
+	alignment(alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		throw std::invalid_argument("FrameDataRing: alignment must be a power of two");
+	if (!memory || region_capacity == 0 || region_count == 0)
+		throw std::invalid_argument("FrameDataRing: no memory to hand out");
+	// offsets are handed to vkCmdBindDescriptorSets as uint32_t
+	if (get_buffer_size(region_capacity, region_count, alignment) > std::numeric_limits<uint32_t>::max())
+		throw std::invalid_argument("FrameDataRing: buffer too large for dynamic offsets");
+}
+
+void FrameDataRing::begin_frame(const uint32_t region)
+{
+	if (region >= region_count)
+		throw std::out_of_range("FrameDataRing: no such frame region");
+	region_start = region * region_capacity;
+	cursor = region_start;
+}
+
+FrameDataRing::Allocation FrameDataRing::allocate(const size_t size)
+{
+	const size_t start = align_up(cursor, alignment);
+	if (start + size > region_start + region_capacity)
+		throw std::runtime_error("FrameDataRing: frame region is full");
+	cursor = start + size;
+	return { static_cast<uint32_t>(start), memory + start };
+}
+
+uint32_t FrameDataRing::write(const void* data, const size_t size)
+{
+	const Allocation allocation = allocate(size);
+	std::memcpy(allocation.memory, data, size);
+	return allocation.offset;
+}
+
+size_t FrameDataRing::get_buffer_size(const size_t region_capacity, const uint32_t region_count, const size_t alignment)
+{
+	return align_up(region_capacity, alignment) * region_count;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Hands out space for data rewritten every frame, such as object transforms
+// and bone palettes, from a persistently mapped buffer. The buffer is split into
+// one region per swapchain image and each frame packs its data linearly into
+// its own region; shaders find an object's data through a dynamic descriptor
+// offset. A region is only rewritten once the frame that last used the same
+// swapchain image has finished.
+class FrameDataRing
+{
+public:
+	struct Allocation
+	{
+		// from the start of the buffer, usable as a dynamic offset
+		uint32_t offset;
+		std::byte* memory;
+	};
+
+	// memory must hold region_count regions of region_capacity bytes each,
+	// region_capacity rounded up to alignment (a power of two)
+	FrameDataRing(std::byte* memory, size_t region_capacity, uint32_t region_count, size_t alignment);
+
+	void begin_frame(uint32_t region);
+	// Throws if the frame's region is full
+	Allocation allocate(size_t size);
+	uint32_t write(const void* data, size_t size);
+
+	static size_t get_buffer_size(size_t region_capacity, uint32_t region_count, size_t alignment);
+	size_t get_region_capacity() const { return region_capacity; }
+	size_t get_region_used() const { return cursor - region_start; }
+	size_t get_alignment() const { return alignment; }
+
+private:
+	std::byte* memory;
+	const size_t region_capacity;
+	const uint32_t region_count;
+	const size_t alignment;
+	size_t region_start = 0;
+	size_t cursor = 0;
+};
@@ -1,6 +1,9 @@
 #include "graphics_buffer.hpp"
 
+#include <algorithm>
 #include <cstddef>
+#include <map>
+#include <stdexcept>
 #include <utility>
 
 
@@ -14,13 +17,9 @@ GraphicsBuffer::GraphicsBuffer(
 	memory(memory),
 	capacity(capacity),
 	alignment(alignment),
-	name(std::move(name))
+	name(std::move(name)),
+	allocator(capacity)
 {
-	Slot slot;
-	slot.offset = 0;
-	slot.size = capacity;
-	slot.capacity = capacity;
-	free_slots[slot.offset] = slot;
 }
 
 GraphicsBuffer::GraphicsBuffer(GraphicsBuffer&& other) noexcept :
@@ -30,7 +29,7 @@ GraphicsBuffer::GraphicsBuffer(GraphicsBuffer&& other) noexcept :
 	alignment(other.alignment),
 	name(std::move(other.name)),
 	filled_slots(std::move(other.filled_slots)),
-	free_slots(std::move(other.free_slots))
+	allocator(std::move(other.allocator))
 {
 	other.buffer = nullptr;
 	other.memory = nullptr;
@@ -64,54 +63,23 @@ void GraphicsBuffer::free_slot(const SlotID slot_id)
 		throw std::runtime_error("GraphicsBuffer::free_slot: Slot not found!");
 	}
 
-	Slot slot = it->second;
-	slot.size = slot.capacity;
+	allocator.free(it->second.offset);
+	filled_capacity -= it->second.capacity;
 	filled_slots.erase(it);
-	filled_capacity -= slot.capacity;
-
-	//
-	// Now do some housekeeping
-	//
-	
-	// Regarding interusage of size and capacity, in free_slots size==capacity so we use size only
-	// in filled_slots size!=capacity and capacity is more important
-
-	// check if there is a slot after, if so merge it
-	auto slot_after = free_slots.lower_bound(slot.offset);
-	if (slot_after != free_slots.end() && slot_after->second.offset == slot.offset + slot.size)
-	{
-		slot.size += slot_after->second.size;
-	} else
-	{
-		slot_after = free_slots.end();
-	}
-
-	// check if there is a slot before, if so merge it
-	auto slot_before = slot_after != free_slots.begin() ? std::prev(slot_after) : free_slots.end();
-	if (slot_before != free_slots.end() && 
-		slot_before->second.offset + slot_before->second.size == slot.offset)
-	{
-		slot.offset = slot_before->second.offset;
-		slot.size += slot_before->second.size;
-	} else
-	{
-		slot_before = free_slots.end();
-	}
-	
-	if (slot_after != free_slots.end())
-	{
-		free_slots.erase(slot_after);
-	}
+}
 
-	if (slot_before != free_slots.end())
+GraphicsBuffer::offset_t GraphicsBuffer::reserve_slot(const SlotID id, uint32_t size)
+{
+	const auto offset = try_reserve_slot(id, size);
+	if (!offset)
 	{
-		free_slots.erase(slot_before);
+		throw std::runtime_error("GraphicsBuffer::reserve_slot: no free slot of "
+			+ std::to_string(size) + " bytes in " + name);
 	}
-
-	free_slots[slot.offset] = slot;
+	return *offset;
 }
 
-GraphicsBuffer::offset_t GraphicsBuffer::reserve_slot(const SlotID id, uint32_t size)
+std::optional<GraphicsBuffer::offset_t> GraphicsBuffer::try_reserve_slot(const SlotID id, uint32_t size)
 {
 	if (filled_slots.find(id) != filled_slots.end())
 	{
@@ -121,32 +89,20 @@ GraphicsBuffer::offset_t GraphicsBuffer::reserve_slot(const SlotID id, uint32_t
 	// for alignment, we need to round up the size
 	// nice trick that only works with powers of 2: https://stackoverflow.com/questions/3407012/rounding-up-to-the-nearest-multiple-of-a-number
 	assert(alignment > 0 && (alignment & (alignment - 1)) == 0); // alignment must be a power of 2
-	const uint32_t slot_capacity = (size + alignment - 1) & ~(alignment - 1);
+	// empty slots still need an offset of their own
+	const uint32_t slot_capacity = std::max((size + alignment - 1) & ~(alignment - 1), alignment);
 
 	// alternatively a more generic one that works for non powers of two
 	// const uint32_t slot_capacity = ((size + alignment - 1) / alignment) * alignment;
 
-	// find the first slot that fits
-	auto it = std::find_if(free_slots.begin(), free_slots.end(), 
-		[slot_capacity](const auto& slot) { return slot.second.size >= slot_capacity; });
-
-	if (it == free_slots.end())
-	{
-		throw std::runtime_error("No free slot found!");
-	}
-
-	Slot slot = it->second;
-	free_slots.erase(it);
-
-	// if the slot is bigger than needed, split it
-	if (slot.size > slot_capacity)
+	const auto offset = allocator.allocate(slot_capacity, alignment);
+	if (!offset)
 	{
-		Slot new_free_slot;
-		new_free_slot.offset = slot.offset + slot_capacity;
-		new_free_slot.size = slot.size - slot_capacity;
-		free_slots[new_free_slot.offset] = new_free_slot;
+		return std::nullopt;
 	}
 
+	Slot slot;
+	slot.offset = *offset;
 	slot.size = size;
 	slot.capacity = slot_capacity;
 	filled_slots[id] = slot;
@@ -166,6 +122,18 @@ GraphicsBuffer::offset_t GraphicsBuffer::get_offset(const SlotID id) const
 	return it->second.offset;
 }
 
+std::vector<GraphicsBuffer::SlotMove> GraphicsBuffer::plan_defragmentation() const
+{
+	std::map<offset_t, SlotID> slot_ids;
+	for (const auto& [id, slot] : filled_slots)
+		slot_ids.emplace(slot.offset, id);
+
+	std::vector<SlotMove> moves;
+	for (const auto& move : allocator.plan_defragmentation())
+		moves.push_back({ slot_ids.at(move.from), move.from, move.to, move.size });
+	return moves;
+}
+
 GraphicsBuffer::Slot GraphicsBuffer::get_slot(const SlotID id) const
 {
 	auto it = filled_slots.find(id);
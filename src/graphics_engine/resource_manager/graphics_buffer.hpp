@@ -1,10 +1,13 @@
 #pragma once
 
+#include "tlsf_allocator.hpp"
+
 #include <vulkan/vulkan.hpp>
 
+#include <optional>
 #include <string>
 #include <unordered_map>
-#include <map>
+#include <vector>
 
 
 class GraphicsBuffer
@@ -33,8 +36,20 @@ public:
 		uint32_t capacity; // this is only for alignment requirements, for real data size refer to above
 	};
 
+	// Copying a slot's capacity from one offset to the other packs it towards
+	// the start of the buffer, see TlsfAllocator::plan_defragmentation
+	struct SlotMove
+	{
+		SlotID id;
+		offset_t from;
+		offset_t to;
+		uint32_t size;
+	};
+
 	void free_slot(SlotID slot_id);
 	offset_t reserve_slot(SlotID id, uint32_t size);
+	// Empty instead of throwing when no free block is large enough
+	std::optional<offset_t> try_reserve_slot(SlotID id, uint32_t size);
 	std::byte* map_slot(SlotID id, VkDevice device);
 	void unmap_slot(VkDevice device);
 
@@ -46,14 +61,16 @@ public:
 	const std::string& get_name() const { return name; }
 	Slot get_slot(SlotID id) const;
 	bool has_slot(SlotID id) const { return filled_slots.contains(id); }
+	TlsfAllocator::Stats get_stats() const { return allocator.get_stats(); }
+	// Reports the copies that would remove all free space between slots, nothing is moved
+	std::vector<SlotMove> plan_defragmentation() const;
 
 private:
 	// map of id to slot, id is typically object-id
 	std::unordered_map<SlotID, Slot> filled_slots;
 
-	// map of offset to slot, offset is the offset in the buffer
-	// these slots are unused and to ready to be picked
-	std::map<uint32_t, Slot> free_slots;
+	// hands out the offsets of slots, slot capacities are multiples of alignment
+	TlsfAllocator allocator;
 
 	VkBuffer buffer = nullptr;
 	VkDeviceMemory memory = nullptr;
@@ -2,9 +2,12 @@
 
 #include "constants.hpp"
 #include "graphics_engine/graphics_engine_base_module.hpp"
+#include "frame_data_ring.hpp"
 #include "graphics_buffer.hpp"
+#include "graphics_buffer_pool.hpp"
 #include "shared_data_structures.hpp"
 #include "identifications.hpp"
+#include "upload_queue.hpp"
 
 #include <vector>
 
@@ -12,53 +15,54 @@
 class Mesh;
 
 // Manages buffers associated with objects such as vertex buffer
-// Memory is virtualised so that the GPU sees a continuous memory space
+// Mesh and material data live in pools that grow by whole device memory
+// blocks, so their slots are addressed by block buffer and offset
 class GraphicsBufferManager : public GraphicsEngineBaseModule
 {
 public:
 	GraphicsBufferManager(GraphicsEngine& engine);
 	virtual ~GraphicsBufferManager() override;
 
-	void reserve_buffer(RenderableFrameID id, size_t size) { reserve_buffer(uniform_buffer, id.get_underlying(), size); }
-	void reserve_buffer(SkeletonFrameID id, size_t size) { reserve_buffer(bone_buffer, id.get_underlying(), size); }
-
-	void free_buffer(RenderableFrameID id) { free_buffer(uniform_buffer, id.get_underlying()); }
 	void free_buffer(MeshID id) { free_buffer(vertex_buffer, id.get_underlying()); free_buffer(index_buffer, id.get_underlying()); }
 	void free_buffer(MaterialID id) { free_buffer(materials_buffer, id.get_underlying()); }
-	void free_buffer(SkeletonFrameID id) { free_buffer(bone_buffer, id.get_underlying()); }
 
-	size_t get_vertex_buffer_offset(MeshID id) const { return vertex_buffer.get_offset(id.get_underlying()); }
-	size_t get_index_buffer_offset(MeshID id) const { return index_buffer.get_offset(id.get_underlying()); }
-	size_t get_buffer_offset(MaterialID id) const { return materials_buffer.get_offset(id.get_underlying()); }
-	size_t get_buffer_offset(SkeletonFrameID id) const { return bone_buffer.get_offset(id.get_underlying()); }
+	// Destroys pool blocks left empty, once their retired slots can no longer be in use
+	void release_idle_buffer_blocks();
+
+	GraphicsBufferPool::Location get_vertex_buffer_location(MeshID id) const { return vertex_buffer.get_location(id.get_underlying()); }
+	GraphicsBufferPool::Location get_index_buffer_location(MeshID id) const { return index_buffer.get_location(id.get_underlying()); }
+	GraphicsBufferPool::Location get_buffer_location(MaterialID id) const { return materials_buffer.get_location(id.get_underlying()); }
+	// For descriptors of renderables without materials
+	VkBuffer get_placeholder_materials_buffer() { return materials_buffer.get_first_buffer(); }
 	size_t get_global_uniform_buffer_offset(uint32_t id) const { return global_uniform_buffer.get_offset(id); }
+	size_t get_instance_buffer_offset(uint32_t frame_idx) const { return instance_buffer.get_offset(frame_idx); }
 
-	VkBuffer get_vertex_buffer() const { return vertex_buffer.get_buffer(); }
-	VkBuffer get_index_buffer() const { return index_buffer.get_buffer(); }
-	VkBuffer get_uniform_buffer() const { return uniform_buffer.get_buffer(); }
-	VkBuffer get_materials_buffer() const { return materials_buffer.get_buffer(); }
+	VkBuffer get_object_data_buffer() const { return object_data_buffer.get_buffer(); }
 	// For ray tracing:
 	// VkBuffer get_mapping_buffer() const { return mapping_buffer.get_buffer(); }
 	VkBuffer get_global_uniform_buffer() const { return global_uniform_buffer.get_buffer(); }
-	VkBuffer get_bone_buffer() const { return bone_buffer.get_buffer(); }
+	VkBuffer get_bone_data_buffer() const { return bone_data_buffer.get_buffer(); }
+	VkBuffer get_instance_buffer() const { return instance_buffer.get_buffer(); }
 
 	VkDeviceMemory get_global_uniform_buffer_memory() const { return global_uniform_buffer.get_memory(); }
 
 	// does both vertex and index buffer writing
 	void write_to_buffer(MeshID id, const Mesh& mesh);
 	void write_to_buffer(MaterialID id, const SDS::MaterialData& material);
-	void write_to_buffer(SkeletonFrameID id, const std::vector<SDS::Bone>& bones);
-	void write_to_buffer(RenderableFrameID id, const SDS::ObjectData& ubos);
 	void write_to_global_uniform_buffer(uint32_t id, const SDS::GlobalData& ubo);
+	// at most MAX_DRAW_INSTANCES instances
+	void write_to_instance_buffer(uint32_t frame_idx, const std::vector<SDS::InstanceData>& instances);
+
+	// Object transforms and bone palettes are packed anew every frame into the
+	// frame's region of a persistently mapped buffer. The returned offsets are
+	// the dynamic offsets to bind the per-renderable frame descriptor set with,
+	// and stay valid until the frame's swapchain image comes round again.
+	void begin_frame_data(uint32_t frame_idx);
+	uint32_t write_frame_data(const SDS::ObjectData& object_data) { return object_data_ring.write(&object_data, sizeof(object_data)); }
+	uint32_t write_frame_data(const std::vector<SDS::Bone>& bones) { return bone_data_ring.write(bones.data(), bones.size() * sizeof(bones[0])); }
 	// For ray tracing:
 	// void write_to_mapping_buffer(ObjectID id, const SDS::BufferMapEntry& entry);
 
-	GraphicsBuffer::Slot get_vertex_buffer_slot(MeshID id) const { return vertex_buffer.get_slot(id.get_underlying()); }
-	GraphicsBuffer::Slot get_index_buffer_slot(MeshID id) const { return index_buffer.get_slot(id.get_underlying()); }
-	GraphicsBuffer::Slot get_buffer_slot(RenderableFrameID id) const { return uniform_buffer.get_slot(id.get_underlying()); }
-	GraphicsBuffer::Slot get_buffer_slot(MaterialID id) const { return materials_buffer.get_slot(id.get_underlying()); }
-	GraphicsBuffer::Slot get_buffer_slot(SkeletonFrameID id) const { return bone_buffer.get_slot(id.get_underlying()); }
-
 	virtual GraphicsBuffer create_buffer(
 		size_t size, 
 		VkBufferUsageFlags usage_flags, 
@@ -74,12 +78,16 @@ public:
 		VkBuffer& buffer,
 		VkDeviceMemory& buffer_memory);
 
+	// Staged data is copied by the next upload submission: at the latest when
+	// the frame is submitted, or before any one-off command buffer runs
 	void stage_data_to_buffer(
 		VkBuffer destination_buffer,
 		const uint32_t destination_buffer_offset,
 		const uint32_t size,
 		const std::function<void(std::byte*)>& write_function);
-	
+
+	// The image must be in VK_IMAGE_LAYOUT_UNDEFINED and is left in
+	// VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
 	void stage_data_to_image(
 		VkImage destination_image,
 		const uint32_t width,
@@ -89,30 +97,49 @@ public:
 		const uint32_t layer_count = 1,
 		const std::vector<size_t>& mip_sizes = {}); // for cubemaps and mipmapped images
 
+	void flush_uploads() { upload_queue.flush(); }
+	void release_completed_uploads(SubmissionSerial completed_serial) { upload_queue.release_completed(completed_serial); }
+
 public:
 	static constexpr size_t NUM_EXPECTED_OBJECTS = 1e3;
-	static constexpr size_t NUM_EXPECTED_FRAMES = 3;
 	static constexpr size_t NUM_EXPECTED_RENDERABLES = NUM_EXPECTED_OBJECTS * 2;
 
-	// in bytes, takes average size different vertex types
-	static constexpr size_t VERTEX_BUFFER_CAPACITY = (sizeof(SDS::ColorVertex) + sizeof(SDS::TexVertex)) * 1e6;
-	static constexpr size_t INDEX_BUFFER_CAPACITY = sizeof(uint32_t) * 1e7;
-	static constexpr size_t UNIFORM_BUFFER_CAPACITY =
-		sizeof(SDS::ObjectData) * NUM_EXPECTED_RENDERABLES
-		* CSTS::UPPERBOUND_SWAPCHAIN_IMAGES
-		* CSTS::MAX_CONCURRENT_RENDER_RESOURCE_SETS;
-	static constexpr size_t MATERIALS_BUFFER_CAPACITY = sizeof(SDS::MaterialData) * NUM_EXPECTED_RENDERABLES;
+	// in bytes, pools start empty and add blocks of this size as they fill;
+	// a mesh larger than a block gets a block of its own
+	static constexpr uint32_t VERTEX_BLOCK_CAPACITY = 16 * 1024 * 1024;
+	static constexpr uint32_t INDEX_BLOCK_CAPACITY = 8 * 1024 * 1024;
+	static constexpr uint32_t MATERIALS_BLOCK_CAPACITY = sizeof(SDS::MaterialData) * 1024;
+	static constexpr uint32_t MAX_POOL_BLOCKS = 64;
+	// the largest minUniformBufferOffsetAlignment and
+	// minStorageBufferOffsetAlignment the spec allows
+	static constexpr size_t MAX_DYNAMIC_OFFSET_ALIGNMENT = 256;
+	// per swapchain frame; retired renderables take no space
+	static constexpr size_t MAX_FRAME_RENDERABLES = 16384;
+	static constexpr size_t OBJECT_DATA_REGION_CAPACITY = MAX_DYNAMIC_OFFSET_ALIGNMENT * MAX_FRAME_RENDERABLES;
 	// 100 is here to get around the min uniform buffer alignment requirement
 	static constexpr size_t GLOBAL_UNIFORM_BUFFER_CAPACITY = sizeof(SDS::GlobalData) * CSTS::UPPERBOUND_SWAPCHAIN_IMAGES * 100;
 	// For ray tracing:
 	// static constexpr size_t MAPPING_BUFFER_CAPACITY =
 	// 	sizeof(SDS::BufferMapEntry) * NUM_EXPECTED_OBJECTS * 10;
-	static constexpr size_t BONE_BUFFER_CAPACITY = sizeof(SDS::Bone) * 1e5 * NUM_EXPECTED_FRAMES;
-	static constexpr size_t INITIAL_STAGING_BUFFER_CAPACITY = 1e4; // staging buffer capacity dynamically grows
+	// per swapchain frame
+	static constexpr size_t BONE_DATA_REGION_CAPACITY = sizeof(SDS::Bone) * 65536;
+	// per swapchain frame, beyond which draws are no longer instanced
+	static constexpr uint32_t MAX_DRAW_INSTANCES = 16384;
+	static constexpr size_t INSTANCE_BUFFER_CAPACITY =
+		sizeof(SDS::InstanceData) * MAX_DRAW_INSTANCES * CSTS::UPPERBOUND_SWAPCHAIN_IMAGES;
+	// ring shared by all uploads; larger uploads get a staging buffer of their own
+	static constexpr size_t UPLOAD_STAGING_BUFFER_CAPACITY = 64 * 1024 * 1024;
 
 private:
-	void reserve_buffer(GraphicsBuffer& buffer, GraphicsBuffer::SlotID id, size_t size);
-	void free_buffer(GraphicsBuffer& buffer, GraphicsBuffer::SlotID id);
+	std::byte* map_persistently(const GraphicsBuffer& buffer);
+	GraphicsBufferPool create_buffer_pool(
+		std::string name,
+		uint32_t block_capacity,
+		uint32_t alignment,
+		VkBufferUsageFlags usage_flags,
+		VkMemoryPropertyFlags memory_flags);
+	GraphicsBufferPool::Location reserve_buffer(GraphicsBufferPool& pool, GraphicsBuffer::SlotID id, size_t size);
+	void free_buffer(GraphicsBufferPool& pool, GraphicsBuffer::SlotID id);
 	void update_buffer_stats();
 
 	// For ray tracing:
@@ -130,11 +157,12 @@ private:
 		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 	static constexpr VkBufferUsageFlags INDEX_BUFFER_USAGE_FLAGS =
 		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-	static constexpr VkBufferUsageFlags UNIFORM_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	static constexpr VkBufferUsageFlags OBJECT_DATA_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 	static constexpr VkBufferUsageFlags MATERIALS_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
 		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 	static constexpr VkBufferUsageFlags GLOBAL_UNIFORM_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-	static constexpr VkBufferUsageFlags BONE_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	static constexpr VkBufferUsageFlags BONE_DATA_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	static constexpr VkBufferUsageFlags INSTANCE_BUFFER_USAGE_FLAGS = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 	// For ray tracing:
 	// static constexpr VkBufferUsageFlags MAPPING_BUFFER_USAGE_FLAGS =
 	// 	VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
@@ -142,23 +170,31 @@ private:
 
 	static constexpr VkMemoryPropertyFlags VERTEX_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 	static constexpr VkMemoryPropertyFlags INDEX_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-	static constexpr VkMemoryPropertyFlags UNIFORM_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	static constexpr VkMemoryPropertyFlags OBJECT_DATA_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 	static constexpr VkMemoryPropertyFlags MATERIALS_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-	static constexpr VkMemoryPropertyFlags GLOBAL_UNIFORM_BUFFER_MEMORY_FLAGS = UNIFORM_BUFFER_MEMORY_FLAGS;
+	static constexpr VkMemoryPropertyFlags GLOBAL_UNIFORM_BUFFER_MEMORY_FLAGS = OBJECT_DATA_BUFFER_MEMORY_FLAGS;
 	// For ray tracing:
 	// static constexpr VkMemoryPropertyFlags MAPPING_BUFFER_MEMORY_FLAGS =
 	// 	VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-	static constexpr VkMemoryPropertyFlags BONE_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	static constexpr VkMemoryPropertyFlags BONE_DATA_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	static constexpr VkMemoryPropertyFlags INSTANCE_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 	static constexpr VkMemoryPropertyFlags STAGING_BUFFER_MEMORY_FLAGS = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-	GraphicsBuffer vertex_buffer;
-	GraphicsBuffer index_buffer;
-	GraphicsBuffer uniform_buffer;
-	GraphicsBuffer materials_buffer;
+	GraphicsBufferPool vertex_buffer;
+	GraphicsBufferPool index_buffer;
+	GraphicsBufferPool materials_buffer;
 	GraphicsBuffer global_uniform_buffer;
-	GraphicsBuffer staging_buffer;
-	GraphicsBuffer bone_buffer;
+	GraphicsBuffer instance_buffer;
+	GraphicsBuffer object_data_buffer;
+	GraphicsBuffer bone_data_buffer;
+	// host-visible buffers written every frame stay mapped for the lifetime of
+	// the manager
+	std::byte* global_uniform_memory;
+	std::byte* instance_memory;
+	FrameDataRing object_data_ring;
+	FrameDataRing bone_data_ring;
 	// For ray tracing:
 	// // Maps object IDs to offsets for the dormant ray-tracing path.
 	// AppendOnlyGraphicsBuffer mapping_buffer;
+	GraphicsUploadQueue upload_queue;
 };
@@ -2,35 +2,30 @@
 #include "renderable/mesh.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 
 
 GraphicsBufferManager::GraphicsBufferManager(GraphicsEngine& engine) :
 	GraphicsEngineBaseModule(engine),
-	vertex_buffer(create_buffer(
-		VERTEX_BUFFER_CAPACITY, 
-		VERTEX_BUFFER_USAGE_FLAGS, 
-		VERTEX_BUFFER_MEMORY_FLAGS, 
-		4, 
-		"vertex_buffer")),
-	index_buffer(create_buffer(
-		INDEX_BUFFER_CAPACITY, 
-		INDEX_BUFFER_USAGE_FLAGS, 
-		INDEX_BUFFER_MEMORY_FLAGS, 
-		4, 
-		"index_buffer")),
-	uniform_buffer(create_buffer(
-		UNIFORM_BUFFER_CAPACITY, 
-		UNIFORM_BUFFER_USAGE_FLAGS, 
-		UNIFORM_BUFFER_MEMORY_FLAGS, 
-		engine.get_device_module().get_physical_device_properties().properties.limits.minUniformBufferOffsetAlignment,
-		"uniform_buffer")),
-	materials_buffer(create_buffer(
-		MATERIALS_BUFFER_CAPACITY, 
-		MATERIALS_BUFFER_USAGE_FLAGS, 
-		MATERIALS_BUFFER_MEMORY_FLAGS, 
+	vertex_buffer(create_buffer_pool(
+		"vertex_buffer",
+		VERTEX_BLOCK_CAPACITY,
+		4,
+		VERTEX_BUFFER_USAGE_FLAGS,
+		VERTEX_BUFFER_MEMORY_FLAGS)),
+	index_buffer(create_buffer_pool(
+		"index_buffer",
+		INDEX_BLOCK_CAPACITY,
+		4,
+		INDEX_BUFFER_USAGE_FLAGS,
+		INDEX_BUFFER_MEMORY_FLAGS)),
+	materials_buffer(create_buffer_pool(
+		"materials_buffer",
+		MATERIALS_BLOCK_CAPACITY,
 		engine.get_device_module().get_physical_device_properties().properties.limits.minStorageBufferOffsetAlignment,
-		"materials_buffer")),
+		MATERIALS_BUFFER_USAGE_FLAGS,
+		MATERIALS_BUFFER_MEMORY_FLAGS)),
 	global_uniform_buffer(create_buffer(
 		GLOBAL_UNIFORM_BUFFER_CAPACITY, 
 		GLOBAL_UNIFORM_BUFFER_USAGE_FLAGS, 
@@ -44,51 +39,101 @@ GraphicsBufferManager::GraphicsBufferManager(GraphicsEngine& engine) :
 	// 	MAPPING_BUFFER_MEMORY_FLAGS,
 	// 	1,
 	// 	"mapping_buffer"), sizeof(SDS::BufferMapEntry)),
-	bone_buffer(create_buffer(
-		BONE_BUFFER_CAPACITY, 
-		BONE_BUFFER_USAGE_FLAGS, 
-		BONE_BUFFER_MEMORY_FLAGS, 
+	instance_buffer(create_buffer(
+		INSTANCE_BUFFER_CAPACITY,
+		INSTANCE_BUFFER_USAGE_FLAGS,
+		INSTANCE_BUFFER_MEMORY_FLAGS,
 		engine.get_device_module().get_physical_device_properties().properties.limits.minStorageBufferOffsetAlignment,
-		"bone_buffer")),
-	staging_buffer(create_buffer(
-		INITIAL_STAGING_BUFFER_CAPACITY, 
-		STAGING_BUFFER_USAGE_FLAGS, 
-		STAGING_BUFFER_MEMORY_FLAGS, 
-		1, 
+		"instance_buffer")),
+	object_data_buffer(create_buffer(
+		FrameDataRing::get_buffer_size(
+			OBJECT_DATA_REGION_CAPACITY,
+			CSTS::UPPERBOUND_SWAPCHAIN_IMAGES,
+			engine.get_device_module().get_physical_device_properties().properties.limits.minUniformBufferOffsetAlignment),
+		OBJECT_DATA_BUFFER_USAGE_FLAGS,
+		OBJECT_DATA_BUFFER_MEMORY_FLAGS,
+		1,
+		"object_data_buffer")),
+	bone_data_buffer(create_buffer(
+		FrameDataRing::get_buffer_size(
+			BONE_DATA_REGION_CAPACITY,
+			CSTS::UPPERBOUND_SWAPCHAIN_IMAGES,
+			engine.get_device_module().get_physical_device_properties().properties.limits.minStorageBufferOffsetAlignment),
+		BONE_DATA_BUFFER_USAGE_FLAGS,
+		BONE_DATA_BUFFER_MEMORY_FLAGS,
+		1,
+		"bone_data_buffer")),
+	global_uniform_memory(map_persistently(global_uniform_buffer)),
+	instance_memory(map_persistently(instance_buffer)),
+	object_data_ring(
+		map_persistently(object_data_buffer),
+		OBJECT_DATA_REGION_CAPACITY,
+		CSTS::UPPERBOUND_SWAPCHAIN_IMAGES,
+		engine.get_device_module().get_physical_device_properties().properties.limits.minUniformBufferOffsetAlignment),
+	bone_data_ring(
+		map_persistently(bone_data_buffer),
+		BONE_DATA_REGION_CAPACITY,
+		CSTS::UPPERBOUND_SWAPCHAIN_IMAGES,
+		engine.get_device_module().get_physical_device_properties().properties.limits.minStorageBufferOffsetAlignment),
+	upload_queue(engine, create_buffer(
+		UPLOAD_STAGING_BUFFER_CAPACITY,
+		STAGING_BUFFER_USAGE_FLAGS,
+		STAGING_BUFFER_MEMORY_FLAGS,
+		1,
 		"staging_buffer"))
 {
 	// reserve the first slot in the global uniform buffer for gubo (we only ever use 1 slot)
 	for (uint32_t frame_idx = 0; frame_idx < CSTS::UPPERBOUND_SWAPCHAIN_IMAGES; ++frame_idx)
 	{
 		global_uniform_buffer.reserve_slot(frame_idx, sizeof(SDS::GlobalData));
+		instance_buffer.reserve_slot(frame_idx, sizeof(SDS::InstanceData) * MAX_DRAW_INSTANCES);
 	}
 }
 
 GraphicsBufferManager::~GraphicsBufferManager() 
 {
+	for (const GraphicsBuffer* buffer : { &global_uniform_buffer, &instance_buffer, &object_data_buffer, &bone_data_buffer })
+	{
+		vkUnmapMemory(get_logical_device(), buffer->get_memory());
+	}
 	vertex_buffer.destroy(get_logical_device());
 	index_buffer.destroy(get_logical_device());
-	uniform_buffer.destroy(get_logical_device());
 	materials_buffer.destroy(get_logical_device());
 	global_uniform_buffer.destroy(get_logical_device());
 	// For ray tracing:
 	// mapping_buffer.destroy(get_logical_device());
-	bone_buffer.destroy(get_logical_device());
-	staging_buffer.destroy(get_logical_device());
+	instance_buffer.destroy(get_logical_device());
+	object_data_buffer.destroy(get_logical_device());
+	bone_data_buffer.destroy(get_logical_device());
 }
 
-void GraphicsBufferManager::write_to_buffer(RenderableFrameID id, const SDS::ObjectData& ubos)
+void GraphicsBufferManager::write_to_global_uniform_buffer(uint32_t id, const SDS::GlobalData& ubo)
 {
-	std::byte* mapped_memory = uniform_buffer.map_slot(id.get_underlying(), get_logical_device());
-	*reinterpret_cast<SDS::ObjectData*>(mapped_memory) = ubos;
-	uniform_buffer.unmap_slot(get_logical_device());
+	std::memcpy(global_uniform_memory + global_uniform_buffer.get_offset(id), &ubo, sizeof(ubo));
 }
 
-void GraphicsBufferManager::write_to_global_uniform_buffer(uint32_t id, const SDS::GlobalData& ubo)
+void GraphicsBufferManager::write_to_instance_buffer(
+	uint32_t frame_idx,
+	const std::vector<SDS::InstanceData>& instances)
 {
-	std::byte* mapped_memory = global_uniform_buffer.map_slot(id, get_logical_device());
-	*reinterpret_cast<SDS::GlobalData*>(mapped_memory) = ubo;
-	global_uniform_buffer.unmap_slot(get_logical_device());
+	assert(instances.size() <= MAX_DRAW_INSTANCES);
+	if (instances.empty())
+	{
+		return;
+	}
+
+	std::memcpy(
+		instance_memory + instance_buffer.get_offset(frame_idx),
+		instances.data(),
+		instances.size() * sizeof(instances[0]));
+}
+
+void GraphicsBufferManager::begin_frame_data(uint32_t frame_idx)
+{
+	// reports what the previous frame packed
+	update_buffer_stats();
+	object_data_ring.begin_frame(frame_idx);
+	bone_data_ring.begin_frame(frame_idx);
 }
 
 // For ray tracing:
@@ -107,14 +152,6 @@ void GraphicsBufferManager::write_to_global_uniform_buffer(uint32_t id, const SD
 // 	update_buffer_stats();
 // }
 
-void GraphicsBufferManager::write_to_buffer(SkeletonFrameID id, const std::vector<SDS::Bone>& bones)
-{
-	assert(!bones.empty());
-	std::byte* mapped_memory = bone_buffer.map_slot(id.get_underlying(), get_logical_device());
-	std::memcpy(mapped_memory, bones.data(), bones.size() * sizeof(bones[0]));
-	bone_buffer.unmap_slot(get_logical_device());
-}
-
 void GraphicsBufferManager::write_to_buffer(MaterialID id, const SDS::MaterialData& material)
 {
 	static std::unordered_set<MaterialID> cache;
@@ -123,10 +160,8 @@ void GraphicsBufferManager::write_to_buffer(MaterialID id, const SDS::MaterialDa
 		return;
 	}
 
-	reserve_buffer(materials_buffer, id.get_underlying(), sizeof(material));
-
-	const auto slot = materials_buffer.get_slot(id.get_underlying());
-	stage_data_to_buffer(materials_buffer.get_buffer(), slot.offset, slot.size,
+	const auto location = reserve_buffer(materials_buffer, id.get_underlying(), sizeof(material));
+	stage_data_to_buffer(location.buffer, location.slot.offset, location.slot.size,
 	[&material](std::byte* destination)
 	{
 		std::memcpy(destination, &material, sizeof(material));
@@ -141,19 +176,16 @@ void GraphicsBufferManager::write_to_buffer(MeshID id, const Mesh& mesh)
 		return;
 	}
 
-	reserve_buffer(vertex_buffer, id.get_underlying(), mesh.get_vertices_data_size());
-	reserve_buffer(index_buffer, id.get_underlying(), mesh.get_indices_data_size());
-
-	const auto vertex_slot = vertex_buffer.get_slot(id.get_underlying());
-	const auto index_slot = index_buffer.get_slot(id.get_underlying());
+	const auto vertices = reserve_buffer(vertex_buffer, id.get_underlying(), mesh.get_vertices_data_size());
+	const auto indices = reserve_buffer(index_buffer, id.get_underlying(), mesh.get_indices_data_size());
 
-	stage_data_to_buffer(vertex_buffer.get_buffer(), vertex_slot.offset, vertex_slot.size,
+	stage_data_to_buffer(vertices.buffer, vertices.slot.offset, vertices.slot.size,
 	[&mesh](std::byte* destination)
 	{
 		std::memcpy(destination, mesh.get_vertices_data(), mesh.get_vertices_data_size());
 	});
 
-	stage_data_to_buffer(index_buffer.get_buffer(), index_slot.offset, index_slot.size,
+	stage_data_to_buffer(indices.buffer, indices.slot.offset, indices.slot.size,
 	[&mesh](std::byte* destination)
 	{
 		std::memcpy(destination, mesh.get_indices_data(), mesh.get_indices_data_size());
@@ -247,37 +279,7 @@ void GraphicsBufferManager::stage_data_to_buffer(VkBuffer destination_buffer,
                                                                   const uint32_t size,
                                                                   const std::function<void(std::byte*)>& write_function)
 {
-	// TODO: this can be optimised:
-	// 1. something about using different queues https://www.reddit.com/r/vulkan/comments/pnweh0/vkcmdcopybuffer_performance_worse_on_nvidia_than/
-	if (staging_buffer.get_capacity() < size)
-	{
-		// recreate the staging buffer if it is too small
-		staging_buffer.destroy(get_logical_device());
-		new (&staging_buffer) GraphicsBuffer(create_buffer(
-			size,
-			STAGING_BUFFER_USAGE_FLAGS,
-			STAGING_BUFFER_MEMORY_FLAGS,
-			1,
-			"staging_buffer"));
-	}
-
-	// fill the staging buffer
-	void* mapped_data;
-	vkMapMemory(get_logical_device(), staging_buffer.get_memory(), 0, size, 0, &mapped_data);
-	write_function(reinterpret_cast<std::byte*>(mapped_data));
-	vkUnmapMemory(get_logical_device(), staging_buffer.get_memory());
-
-	// issue the command to copy from staging to device
-	VkCommandBuffer command_buffer = get_graphics_engine().begin_single_time_commands();
-
-	// actual copy command
-	VkBufferCopy copy_region{};
-	copy_region.srcOffset = 0;
-	copy_region.dstOffset = destination_buffer_offset;
-	copy_region.size = size;
-	vkCmdCopyBuffer(command_buffer, staging_buffer.get_buffer(), destination_buffer, 1, &copy_region);
-
-	get_graphics_engine().end_single_time_commands(command_buffer);
+	upload_queue.stage_buffer(destination_buffer, destination_buffer_offset, size, write_function);
 }
 
 void GraphicsBufferManager::stage_data_to_image(
@@ -289,92 +291,83 @@ void GraphicsBufferManager::stage_data_to_image(
 	const uint32_t layer_count,
 	const std::vector<size_t>& mip_sizes)
 {
-	// TODO: this can be optimised:
-	// 1. something about using different queues https://www.reddit.com/r/vulkan/comments/pnweh0/vkcmdcopybuffer_performance_worse_on_nvidia_than/
-	if (staging_buffer.get_capacity() < size)
-	{
-		// recreate the staging buffer if it is too small
-		staging_buffer.destroy(get_logical_device());
-		new (&staging_buffer) GraphicsBuffer(create_buffer(
-			size,
-			STAGING_BUFFER_USAGE_FLAGS,
-			STAGING_BUFFER_MEMORY_FLAGS,
-			1,
-			"staging_buffer"));
-	}
-
-	// fill the staging buffer
-	void* mapped_data;
-	vkMapMemory(get_logical_device(), staging_buffer.get_memory(), 0, size, 0, &mapped_data);
-	write_function(reinterpret_cast<std::byte*>(mapped_data));
-	vkUnmapMemory(get_logical_device(), staging_buffer.get_memory());
-
-	// issue the command to copy from staging to device
-	VkCommandBuffer command_buffer = get_graphics_engine().begin_single_time_commands();
+	upload_queue.stage_image(destination_image, width, height, size, write_function, layer_count, mip_sizes);
+}
 
-	std::vector<VkBufferImageCopy> regions;
-	const size_t region_count = mip_sizes.empty() ? 1 : mip_sizes.size();
-	regions.reserve(region_count);
-	VkDeviceSize offset = 0;
-	for (size_t mip = 0; mip < region_count; ++mip)
+std::byte* GraphicsBufferManager::map_persistently(const GraphicsBuffer& buffer)
+{
+	void* mapped_memory = nullptr;
+	if (vkMapMemory(get_logical_device(), buffer.get_memory(), 0, VK_WHOLE_SIZE, 0, &mapped_memory) != VK_SUCCESS
+		|| !mapped_memory)
 	{
-		VkBufferImageCopy region{};
-		region.bufferOffset = offset;
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = static_cast<uint32_t>(mip);
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = layer_count;
-		region.imageExtent = {
-			std::max(1u, width >> mip),
-			std::max(1u, height >> mip),
-			1
-		};
-		regions.push_back(region);
-		offset += mip_sizes.empty() ? size : mip_sizes[mip];
+		throw std::runtime_error("GraphicsBufferManager: failed to map " + buffer.get_name() + "!");
 	}
+	return static_cast<std::byte*>(mapped_memory);
+}
 
-	vkCmdCopyBufferToImage(
-		command_buffer,
-		staging_buffer.get_buffer(),
-		destination_image,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		static_cast<uint32_t>(regions.size()),
-		regions.data()
-	);
-
-	get_graphics_engine().end_single_time_commands(command_buffer);
+GraphicsBufferPool GraphicsBufferManager::create_buffer_pool(
+	std::string name,
+	const uint32_t block_capacity,
+	const uint32_t alignment,
+	const VkBufferUsageFlags usage_flags,
+	const VkMemoryPropertyFlags memory_flags)
+{
+	return GraphicsBufferPool(std::move(name), block_capacity, alignment, MAX_POOL_BLOCKS,
+		[this, usage_flags, memory_flags](const size_t capacity, const uint32_t block_alignment, std::string block_name)
+		{
+			return create_buffer(capacity, usage_flags, memory_flags, block_alignment, std::move(block_name));
+		});
 }
 
-void GraphicsBufferManager::reserve_buffer(
-	GraphicsBuffer& buffer, const GraphicsBuffer::SlotID id, const size_t size)
+GraphicsBufferPool::Location GraphicsBufferManager::reserve_buffer(
+	GraphicsBufferPool& pool, const GraphicsBuffer::SlotID id, const size_t size)
 {
-	buffer.reserve_slot(id, size);
+	const auto location = pool.reserve_slot(id, size);
 	update_buffer_stats();
+	return location;
 }
 
 void GraphicsBufferManager::free_buffer(
-	GraphicsBuffer& buffer, const GraphicsBuffer::SlotID id)
+	GraphicsBufferPool& pool, const GraphicsBuffer::SlotID id)
 {
-	if (!buffer.has_slot(id))
+	if (!pool.has_slot(id))
 	{
 		return;
 	}
 	
-	buffer.free_slot(id);
+	pool.free_slot(id);
 	update_buffer_stats();
 }
 
+void GraphicsBufferManager::release_idle_buffer_blocks()
+{
+	uint32_t released = 0;
+	for (GraphicsBufferPool* pool : { &vertex_buffer, &index_buffer, &materials_buffer })
+	{
+		released += pool->release_idle_blocks(get_logical_device());
+	}
+	if (released > 0)
+	{
+		update_buffer_stats();
+	}
+}
+
 void GraphicsBufferManager::update_buffer_stats()
 {
-	const std::vector<std::pair<size_t, size_t>> buffer_capacities =
+	const auto pool_capacity = [](const GraphicsBufferPool& pool)
+	{
+		const auto stats = pool.get_stats();
+		return GuiStatistics::BufferCapacity{ stats.capacity, stats.used, stats.block_count, stats.get_fragmentation() };
+	};
+	const std::vector<GuiStatistics::BufferCapacity> buffer_capacities =
 	{
-		{ vertex_buffer.get_filled_capacity(), vertex_buffer.get_capacity() },
-		{ index_buffer.get_filled_capacity(), index_buffer.get_capacity() },
-		{ uniform_buffer.get_filled_capacity(), uniform_buffer.get_capacity() },
-		{ materials_buffer.get_filled_capacity(), materials_buffer.get_capacity() },
+		pool_capacity(vertex_buffer),
+		pool_capacity(index_buffer),
+		{ object_data_ring.get_region_capacity(), object_data_ring.get_region_used() },
+		pool_capacity(materials_buffer),
 		// For ray tracing:
-		// { mapping_buffer.get_filled_capacity(), mapping_buffer.get_capacity() },
-		{ bone_buffer.get_filled_capacity(), bone_buffer.get_capacity() }
+		// { mapping_buffer.get_capacity(), mapping_buffer.get_filled_capacity() },
+		{ bone_data_ring.get_region_capacity(), bone_data_ring.get_region_used() }
 	};
 	get_graphics_engine().get_gui_manager().update_buffer_capacities(buffer_capacities);
 }
@@ -0,0 +1,157 @@
+#include "graphics_buffer_pool.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+
+GraphicsBufferPool::GraphicsBufferPool(
+	std::string name,
+	const uint32_t block_capacity,
+	const uint32_t alignment,
+	const uint32_t max_block_count,
+	BlockFactory create_block) :
+	name(std::move(name)),
+	block_capacity(block_capacity),
+	alignment(alignment),
+	max_block_count(max_block_count),
+	block_factory(std::move(create_block))
+{
+	if (block_capacity == 0 || max_block_count == 0)
+		throw std::invalid_argument("GraphicsBufferPool: " + this->name + " has no room for blocks");
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		throw std::invalid_argument("GraphicsBufferPool: alignment must be a power of two");
+}
+
+void GraphicsBufferPool::destroy(VkDevice device)
+{
+	for (auto& block : blocks)
+	{
+		if (block)
+		{
+			block->destroy(device);
+		}
+	}
+	blocks.clear();
+	slot_blocks.clear();
+}
+
+GraphicsBufferPool::Location GraphicsBufferPool::reserve_slot(const SlotID id, const uint32_t size)
+{
+	if (slot_blocks.contains(id))
+	{
+		throw std::runtime_error("GraphicsBufferPool: slot already exists in " + name);
+	}
+
+	for (uint32_t index = 0; index < blocks.size(); ++index)
+	{
+		if (blocks[index] && blocks[index]->try_reserve_slot(id, size))
+		{
+			slot_blocks.emplace(id, index);
+			return get_location(id);
+		}
+	}
+
+	// slots larger than a block get a block of their own
+	const uint64_t slot_capacity = std::max<uint64_t>(
+		(uint64_t{size} + alignment - 1) & ~uint64_t{alignment - 1}, alignment);
+	if (slot_capacity > UINT32_MAX)
+	{
+		throw std::runtime_error("GraphicsBufferPool: slot too large for " + name);
+	}
+	const uint32_t index = create_block(std::max(block_capacity, static_cast<uint32_t>(slot_capacity)));
+	blocks[index]->reserve_slot(id, size);
+	slot_blocks.emplace(id, index);
+	return get_location(id);
+}
+
+void GraphicsBufferPool::free_slot(const SlotID id)
+{
+	const auto it = slot_blocks.find(id);
+	if (it == slot_blocks.end())
+	{
+		throw std::runtime_error("GraphicsBufferPool::free_slot: Slot not found!");
+	}
+	blocks[it->second]->free_slot(id);
+	slot_blocks.erase(it);
+}
+
+uint32_t GraphicsBufferPool::release_idle_blocks(VkDevice device)
+{
+	uint32_t released = 0;
+	for (size_t index = 1; index < blocks.size(); ++index)
+	{
+		auto& block = blocks[index];
+		if (block && block->get_stats().allocation_count == 0)
+		{
+			block->destroy(device);
+			block.reset();
+			++released;
+		}
+	}
+	while (!blocks.empty() && !blocks.back())
+	{
+		blocks.pop_back();
+	}
+	return released;
+}
+
+GraphicsBufferPool::Location GraphicsBufferPool::get_location(const SlotID id) const
+{
+	const auto it = slot_blocks.find(id);
+	if (it == slot_blocks.end())
+	{
+		throw std::runtime_error("GraphicsBufferPool::get_location: Slot not found!");
+	}
+	const GraphicsBuffer& block = *blocks[it->second];
+	return { block.get_buffer(), block.get_slot(id), it->second };
+}
+
+VkBuffer GraphicsBufferPool::get_first_buffer()
+{
+	if (blocks.empty())
+	{
+		create_block(block_capacity);
+	}
+	return blocks.front()->get_buffer();
+}
+
+GraphicsBufferPool::Stats GraphicsBufferPool::get_stats() const
+{
+	Stats stats;
+	for (const auto& block : blocks)
+	{
+		if (!block)
+		{
+			continue;
+		}
+		const auto block_stats = block->get_stats();
+		stats.capacity += block_stats.capacity;
+		stats.used += block_stats.used;
+		stats.largest_free_block = std::max(stats.largest_free_block, block_stats.largest_free_block);
+		++stats.block_count;
+	}
+	return stats;
+}
+
+uint32_t GraphicsBufferPool::create_block(const uint32_t capacity)
+{
+	auto free_entry = std::find_if(blocks.begin(), blocks.end(),
+		[](const auto& block) { return !block.has_value(); });
+	const auto index = static_cast<uint32_t>(std::distance(blocks.begin(), free_entry));
+	if (free_entry == blocks.end() && blocks.size() >= max_block_count)
+	{
+		throw std::runtime_error("GraphicsBufferPool: " + name + " is out of blocks");
+	}
+
+	GraphicsBuffer block = block_factory(capacity, alignment, name + "[" + std::to_string(index) + "]");
+	if (free_entry == blocks.end())
+	{
+		blocks.emplace_back(std::move(block));
+	}
+	else
+	{
+		free_entry->emplace(std::move(block));
+	}
+	return index;
+}
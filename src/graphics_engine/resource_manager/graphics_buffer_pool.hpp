@@ -0,0 +1,85 @@
+#pragma once
+
+#include "graphics_buffer.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// A buffer made of as many device memory blocks as its slots need. Slots are
+// placed in the first block with room and a new block is created when none
+// has any; idle blocks can be released again. A slot never spans blocks, so
+// draws bind the block's buffer at the slot's offset within it.
+class GraphicsBufferPool
+{
+public:
+	using SlotID = GraphicsBuffer::SlotID;
+	// creates one block, same as GraphicsBufferManager::create_buffer with the usage bound
+	using BlockFactory = std::function<GraphicsBuffer(size_t capacity, uint32_t alignment, std::string name)>;
+
+	struct Location
+	{
+		VkBuffer buffer;
+		GraphicsBuffer::Slot slot;
+		uint32_t block;
+	};
+
+	struct Stats
+	{
+		size_t capacity = 0;
+		size_t used = 0;
+		size_t largest_free_block = 0;
+		uint32_t block_count = 0;
+
+		// 0 when the free space of all blocks is one block, approaching 1 as it splinters
+		float get_fragmentation() const
+		{
+			const size_t free = capacity - used;
+			return free == 0 ? 0.0f : 1.0f - static_cast<float>(largest_free_block) / static_cast<float>(free);
+		}
+	};
+
+	// block_capacity is the size of a new block unless a single slot needs more
+	GraphicsBufferPool(
+		std::string name,
+		uint32_t block_capacity,
+		uint32_t alignment,
+		uint32_t max_block_count,
+		BlockFactory create_block);
+	GraphicsBufferPool(const GraphicsBufferPool&) = delete;
+
+	void destroy(VkDevice device);
+
+	// Throws if the slot needs a new block and the pool already has max_block_count
+	Location reserve_slot(SlotID id, uint32_t size);
+	void free_slot(SlotID id);
+	// Destroys empty blocks other than the first and returns how many went.
+	// Only call once no submission still uses the freed slots.
+	uint32_t release_idle_blocks(VkDevice device);
+
+	bool has_slot(SlotID id) const { return slot_blocks.contains(id); }
+	Location get_location(SlotID id) const;
+	// Buffer of the first block, created if the pool is still empty. It is never
+	// released, so descriptors without a slot of their own can point at it.
+	VkBuffer get_first_buffer();
+	Stats get_stats() const;
+	const std::string& get_name() const { return name; }
+
+private:
+	uint32_t create_block(uint32_t capacity);
+
+	// indices stay put when blocks are released, so empty entries are reused
+	std::vector<std::optional<GraphicsBuffer>> blocks;
+	std::unordered_map<SlotID, uint32_t> slot_blocks;
+
+	const std::string name;
+	const uint32_t block_capacity;
+	const uint32_t alignment;
+	const uint32_t max_block_count;
+	BlockFactory block_factory;
+};
@@ -1,5 +1,6 @@
 #include "graphics_resource_manager.ipp"
 #include "graphics_buffer_manager.ipp"
+#include "upload_queue.ipp"
 #include "descriptor_manager.ipp"
 
 #include "game_engine.hpp"
\ No newline at end of file
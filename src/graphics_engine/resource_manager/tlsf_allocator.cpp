@@ -0,0 +1,269 @@
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+
+namespace
+{
+uint64_t align_up(const uint64_t value, const uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+TlsfAllocator::TlsfAllocator(const uint32_t capacity) :
+	capacity(capacity)
+{
+	for (auto& lists : free_lists)
+		lists.fill(NONE);
+	if (capacity > 0)
+		insert_free_block(create_block(0, capacity));
+}
+
+TlsfAllocator::Bin TlsfAllocator::bin_containing(const uint32_t size)
+{
+	if (size < SL_COUNT)
+		return { 0, size };
+	const uint32_t top_bit = std::bit_width(size) - 1;
+	return { top_bit - SL_LOG2 + 1, (size >> (top_bit - SL_LOG2)) - SL_COUNT };
+}
+
+std::optional<TlsfAllocator::Bin> TlsfAllocator::bin_fitting(const uint32_t size)
+{
+	if (size < SL_COUNT)
+		return Bin{ 0, size };
+	// round up to the next bin boundary so any block in the bin is large enough
+	const uint32_t top_bit = std::bit_width(size) - 1;
+	const uint64_t rounded = size + (uint64_t{1} << (top_bit - SL_LOG2)) - 1;
+	if (rounded > UINT32_MAX)
+		return std::nullopt;
+	return bin_containing(static_cast<uint32_t>(rounded));
+}
+
+uint32_t TlsfAllocator::find_free_block(Bin bin) const
+{
+	uint32_t second_level_map = second_level_bitmaps[bin.first_level] & (~0u << bin.second_level);
+	if (second_level_map == 0)
+	{
+		const uint32_t first_level_map = bin.first_level + 1 < 32
+			? first_level_bitmap & (~0u << (bin.first_level + 1)) : 0;
+		if (first_level_map == 0)
+			return NONE;
+		bin.first_level = std::countr_zero(first_level_map);
+		second_level_map = second_level_bitmaps[bin.first_level];
+	}
+	bin.second_level = std::countr_zero(second_level_map);
+	return free_lists[bin.first_level][bin.second_level];
+}
+
+uint32_t TlsfAllocator::find_free_block_in(const Bin bin, const uint32_t size, const uint32_t alignment) const
+{
+	for (uint32_t index = free_lists[bin.first_level][bin.second_level];
+		index != NONE; index = blocks[index].next_free)
+	{
+		if (fits(blocks[index], size, alignment))
+			return index;
+	}
+	return NONE;
+}
+
+bool TlsfAllocator::fits(const Block& block, const uint32_t size, const uint32_t alignment) const
+{
+	return align_up(block.offset, alignment) + size <= uint64_t{block.offset} + block.size;
+}
+
+std::optional<TlsfAllocator::offset_t> TlsfAllocator::allocate(const uint32_t size, const uint32_t alignment)
+{
+	if (size == 0)
+		throw std::invalid_argument("TlsfAllocator: size must be non-zero");
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		throw std::invalid_argument("TlsfAllocator: alignment must be a power of two");
+
+	uint32_t index = NONE;
+	if (const auto bin = bin_fitting(size))
+	{
+		index = find_free_block(*bin);
+		if (index != NONE && !fits(blocks[index], size, alignment))
+		{
+			// any block that large leaves room for the padding
+			const auto padded_bin = alignment > 1 && uint64_t{size} + alignment - 1 <= UINT32_MAX
+				? bin_fitting(size + alignment - 1) : std::nullopt;
+			index = padded_bin ? find_free_block(*padded_bin) : NONE;
+		}
+	}
+	// blocks in the bin size falls into may still fit, only this one list is searched
+	if (index == NONE)
+		index = find_free_block_in(bin_containing(size), size, alignment);
+	if (index == NONE)
+		return std::nullopt;
+
+	remove_free_block(index);
+	const auto aligned_offset = static_cast<offset_t>(align_up(blocks[index].offset, alignment));
+	if (const uint32_t padding = aligned_offset - blocks[index].offset; padding > 0)
+	{
+		// the padding stays free, the previous block can't be since free blocks are merged
+		const uint32_t allocated = create_block(aligned_offset, blocks[index].size - padding);
+		link_after(index, allocated);
+		blocks[index].size = padding;
+		insert_free_block(index);
+		index = allocated;
+	}
+	if (const uint32_t remainder = blocks[index].size - size; remainder > 0)
+	{
+		const uint32_t rest = create_block(aligned_offset + size, remainder);
+		link_after(index, rest);
+		blocks[index].size = size;
+		insert_free_block(rest);
+	}
+
+	Block& block = blocks[index];
+	block.free = false;
+	block.alignment = alignment;
+	allocations.emplace(block.offset, index);
+	used += block.size;
+	return block.offset;
+}
+
+void TlsfAllocator::free(const offset_t offset)
+{
+	const auto it = allocations.find(offset);
+	if (it == allocations.end())
+		throw std::out_of_range("TlsfAllocator: no allocation at offset");
+	uint32_t index = it->second;
+	allocations.erase(it);
+	used -= blocks[index].size;
+	blocks[index].free = true;
+
+	if (const uint32_t next = blocks[index].next_physical; next != NONE && blocks[next].free)
+	{
+		remove_free_block(next);
+		blocks[index].size += blocks[next].size;
+		release_block(next);
+	}
+	if (const uint32_t prev = blocks[index].prev_physical; prev != NONE && blocks[prev].free)
+	{
+		remove_free_block(prev);
+		blocks[prev].size += blocks[index].size;
+		release_block(index);
+		index = prev;
+	}
+	insert_free_block(index);
+}
+
+TlsfAllocator::Stats TlsfAllocator::get_stats() const
+{
+	Stats stats;
+	stats.capacity = capacity;
+	stats.used = used;
+	stats.free = capacity - used;
+	stats.free_block_count = free_block_count;
+	stats.allocation_count = static_cast<uint32_t>(allocations.size());
+	if (first_level_bitmap != 0)
+	{
+		// the largest block is in the highest non-empty bin
+		const uint32_t first_level = std::bit_width(first_level_bitmap) - 1;
+		const uint32_t second_level = std::bit_width(second_level_bitmaps[first_level]) - 1;
+		for (uint32_t index = free_lists[first_level][second_level];
+			index != NONE; index = blocks[index].next_free)
+		{
+			stats.largest_free_block = std::max<size_t>(stats.largest_free_block, blocks[index].size);
+		}
+	}
+	return stats;
+}
+
+std::vector<TlsfAllocator::Move> TlsfAllocator::plan_defragmentation() const
+{
+	std::vector<Move> moves;
+	if (blocks.empty())
+		return moves;
+	// the block at offset 0 is never merged into another
+	uint64_t packed_end = 0;
+	for (uint32_t index = 0; index != NONE; index = blocks[index].next_physical)
+	{
+		const Block& block = blocks[index];
+		if (block.free)
+			continue;
+		const auto to = static_cast<offset_t>(align_up(packed_end, block.alignment));
+		if (to != block.offset)
+			moves.push_back({ block.offset, to, block.size });
+		packed_end = uint64_t{to} + block.size;
+	}
+	return moves;
+}
+
+void TlsfAllocator::insert_free_block(const uint32_t index)
+{
+	Block& block = blocks[index];
+	const Bin bin = bin_containing(block.size);
+	uint32_t& head = free_lists[bin.first_level][bin.second_level];
+	block.free = true;
+	block.prev_free = NONE;
+	block.next_free = head;
+	if (head != NONE)
+		blocks[head].prev_free = index;
+	head = index;
+	first_level_bitmap |= 1u << bin.first_level;
+	second_level_bitmaps[bin.first_level] |= 1u << bin.second_level;
+	++free_block_count;
+}
+
+void TlsfAllocator::remove_free_block(const uint32_t index)
+{
+	Block& block = blocks[index];
+	const Bin bin = bin_containing(block.size);
+	if (block.prev_free != NONE)
+		blocks[block.prev_free].next_free = block.next_free;
+	else
+		free_lists[bin.first_level][bin.second_level] = block.next_free;
+	if (block.next_free != NONE)
+		blocks[block.next_free].prev_free = block.prev_free;
+	block.prev_free = NONE;
+	block.next_free = NONE;
+
+	if (free_lists[bin.first_level][bin.second_level] == NONE)
+	{
+		second_level_bitmaps[bin.first_level] &= ~(1u << bin.second_level);
+		if (second_level_bitmaps[bin.first_level] == 0)
+			first_level_bitmap &= ~(1u << bin.first_level);
+	}
+	--free_block_count;
+}
+
+uint32_t TlsfAllocator::create_block(const offset_t offset, const uint32_t size)
+{
+	Block block;
+	block.offset = offset;
+	block.size = size;
+	if (spare_blocks.empty())
+	{
+		blocks.push_back(block);
+		return static_cast<uint32_t>(blocks.size() - 1);
+	}
+	const uint32_t index = spare_blocks.back();
+	spare_blocks.pop_back();
+	blocks[index] = block;
+	return index;
+}
+
+void TlsfAllocator::link_after(const uint32_t index, const uint32_t new_index)
+{
+	const uint32_t next = blocks[index].next_physical;
+	blocks[new_index].prev_physical = index;
+	blocks[new_index].next_physical = next;
+	blocks[index].next_physical = new_index;
+	if (next != NONE)
+		blocks[next].prev_physical = new_index;
+}
+
+void TlsfAllocator::release_block(const uint32_t index)
+{
+	const Block& block = blocks[index];
+	if (block.prev_physical != NONE)
+		blocks[block.prev_physical].next_physical = block.next_physical;
+	if (block.next_physical != NONE)
+		blocks[block.next_physical].prev_physical = block.prev_physical;
+	spare_blocks.push_back(index);
+}
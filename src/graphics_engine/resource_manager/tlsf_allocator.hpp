@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+
+// Two-level segregated-fit (TLSF) allocator for ranges of a buffer. Free blocks
+// are binned by the power of two of their size and then by one of 16 linear
+// steps within it, and two bitmaps find a bin holding a large enough block in
+// constant time. Freed blocks merge with free neighbours straight away.
+// Only offsets are handed out, the allocator never touches the memory itself.
+class TlsfAllocator
+{
+public:
+	using offset_t = uint32_t;
+
+	struct Stats
+	{
+		size_t capacity = 0;
+		size_t used = 0;
+		size_t free = 0;
+		size_t largest_free_block = 0;
+		uint32_t free_block_count = 0;
+		uint32_t allocation_count = 0;
+
+		// 0 when all free space is one block, approaching 1 as it splinters
+		float get_fragmentation() const
+		{
+			return free == 0 ? 0.0f : 1.0f - static_cast<float>(largest_free_block) / static_cast<float>(free);
+		}
+	};
+
+	// Copying size bytes from one offset to the other packs the allocation
+	// towards the start of the buffer
+	struct Move
+	{
+		offset_t from;
+		offset_t to;
+		uint32_t size;
+	};
+
+	explicit TlsfAllocator(uint32_t capacity);
+
+	// Empty when no free block can hold size bytes at the alignment (a power of two)
+	std::optional<offset_t> allocate(uint32_t size, uint32_t alignment = 1);
+	void free(offset_t offset);
+
+	Stats get_stats() const;
+	// Moves packing every allocation towards offset 0 at its alignment, in
+	// ascending order. Applying them in order never overwrites data still to be
+	// moved, although a move may overlap its own source.
+	std::vector<Move> plan_defragmentation() const;
+
+private:
+	static constexpr uint32_t SL_LOG2 = 4;
+	static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+	// sizes below SL_COUNT share the first level, every other bit of a 32-bit size gets its own
+	static constexpr uint32_t FL_COUNT = 32 - SL_LOG2 + 1;
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	struct Block
+	{
+		offset_t offset;
+		uint32_t size;
+		uint32_t alignment = 1;
+		bool free = true;
+		// neighbours in the buffer
+		uint32_t prev_physical = NONE;
+		uint32_t next_physical = NONE;
+		// neighbours in the block's free list
+		uint32_t prev_free = NONE;
+		uint32_t next_free = NONE;
+	};
+
+	struct Bin
+	{
+		uint32_t first_level;
+		uint32_t second_level;
+	};
+
+	static Bin bin_containing(uint32_t size);
+	// the first bin whose every block holds at least size bytes
+	static std::optional<Bin> bin_fitting(uint32_t size);
+
+	uint32_t find_free_block(Bin bin) const;
+	uint32_t find_free_block_in(Bin bin, uint32_t size, uint32_t alignment) const;
+	bool fits(const Block& block, uint32_t size, uint32_t alignment) const;
+	void insert_free_block(uint32_t index);
+	void remove_free_block(uint32_t index);
+	uint32_t create_block(offset_t offset, uint32_t size);
+	// links new_index into the buffer right after index
+	void link_after(uint32_t index, uint32_t new_index);
+	// unlinks index from the buffer and recycles it
+	void release_block(uint32_t index);
+
+	std::vector<Block> blocks;
+	std::vector<uint32_t> spare_blocks;
+	std::unordered_map<offset_t, uint32_t> allocations;
+
+	uint32_t first_level_bitmap = 0;
+	std::array<uint32_t, FL_COUNT> second_level_bitmaps{};
+	std::array<std::array<uint32_t, SL_COUNT>, FL_COUNT> free_lists;
+
+	const uint32_t capacity;
+	size_t used = 0;
+	uint32_t free_block_count = 0;
+};
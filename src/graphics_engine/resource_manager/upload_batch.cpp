@@ -0,0 +1,112 @@
+#include "upload_batch.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+
+StagingRing::StagingRing(const size_t capacity) :
+	capacity(capacity)
+{
+	if (capacity == 0)
+		throw std::invalid_argument("StagingRing: capacity must not be zero");
+}
+
+std::optional<size_t> StagingRing::allocate(const size_t size, const size_t alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+		throw std::invalid_argument("StagingRing: alignment must be a power of two");
+	if (size > capacity)
+		return std::nullopt;
+
+	// an allocation never straddles the end of the buffer; if it would, the
+	// rest of the lap is skipped and it starts again at offset 0
+	Position start = head;
+	const size_t offset = static_cast<size_t>(start % capacity);
+	size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+	if (aligned > capacity || size > capacity - aligned)
+	{
+		start += capacity - offset;
+		aligned = 0;
+	}
+	else
+	{
+		start += aligned - offset;
+	}
+	if (start + size - tail > capacity)
+		return std::nullopt;
+
+	head = start + size;
+	return aligned;
+}
+
+void StagingRing::release_until(const Position position)
+{
+	if (position > head)
+		throw std::out_of_range("StagingRing: released space that was never allocated");
+	tail = std::max(tail, position);
+}
+
+void UploadBatch::add_buffer_copy(const VkBuffer source, const VkBuffer destination, const VkBufferCopy& region)
+{
+	if (region.size == 0)
+		return;
+	if (passes.empty() || overlaps_current_pass(destination, region))
+	{
+		passes.emplace_back();
+		written.clear();
+	}
+
+	auto& buffers = passes.back().buffers;
+	auto copies = std::find_if(buffers.begin(), buffers.end(), [source, destination](const BufferCopies& copies)
+	{
+		return copies.source == source && copies.destination == destination;
+	});
+	if (copies == buffers.end())
+		copies = buffers.insert(buffers.end(), BufferCopies{ source, destination, {} });
+
+	auto& regions = copies->regions;
+	if (!regions.empty()
+		&& regions.back().srcOffset + regions.back().size == region.srcOffset
+		&& regions.back().dstOffset + regions.back().size == region.dstOffset)
+	{
+		regions.back().size += region.size;
+	}
+	else
+	{
+		regions.push_back(region);
+	}
+	written[destination].emplace(region.dstOffset, region.dstOffset + region.size);
+	++copy_count;
+	byte_count += region.size;
+}
+
+void UploadBatch::add_image_copy(ImageCopies copies)
+{
+	copy_count += copies.regions.size();
+	byte_count += copies.size;
+	images.push_back(std::move(copies));
+}
+
+void UploadBatch::clear()
+{
+	passes.clear();
+	written.clear();
+	images.clear();
+	copy_count = 0;
+	byte_count = 0;
+}
+
+bool UploadBatch::overlaps_current_pass(const VkBuffer destination, const VkBufferCopy& region) const
+{
+	const auto ranges = written.find(destination);
+	if (ranges == written.end())
+		return false;
+	// ranges within a pass never overlap, so the last one starting before this
+	// region ends is the only candidate
+	auto range = ranges->second.lower_bound(region.dstOffset + region.size);
+	if (range == ranges->second.begin())
+		return false;
+	--range;
+	return range->second > region.dstOffset;
+}
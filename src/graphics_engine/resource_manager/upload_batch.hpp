@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+
+// Sub-allocates a persistently mapped staging buffer as a ring. Space is handed
+// out in submission order and handed back oldest first, once the submission
+// that read it has completed. Positions only ever grow, so a position taken
+// after a batch is recorded identifies all space up to and including it.
+class StagingRing
+{
+public:
+	using Position = uint64_t;
+
+	explicit StagingRing(size_t capacity);
+
+	// Offset into the staging buffer of size bytes aligned to alignment (a
+	// power of two), or std::nullopt until older submissions retire. Requests
+	// larger than the ring never fit.
+	std::optional<size_t> allocate(size_t size, size_t alignment = 1);
+	// Everything allocated before position is free again
+	void release_until(Position position);
+
+	Position get_head() const { return head; }
+	size_t get_capacity() const { return capacity; }
+	size_t get_used() const { return static_cast<size_t>(head - tail); }
+
+private:
+	const size_t capacity;
+	Position head = 0;
+	Position tail = 0;
+};
+
+// Copies recorded for one upload submission. Buffer copies are grouped into one
+// vkCmdCopyBuffer per source and destination pair, and copies that continue
+// the previous one in both buffers are merged into a single region. A copy
+// that overlaps a destination range already written in the batch starts a new
+// pass, which the recorder separates with a transfer barrier so that the later
+// write lands last.
+class UploadBatch
+{
+public:
+	struct BufferCopies
+	{
+		VkBuffer source;
+		VkBuffer destination;
+		std::vector<VkBufferCopy> regions;
+	};
+
+	struct ImageCopies
+	{
+		VkBuffer source;
+		VkImage destination;
+		uint32_t layer_count;
+		uint32_t mip_levels;
+		// bytes staged for all regions
+		VkDeviceSize size;
+		std::vector<VkBufferImageCopy> regions;
+	};
+
+	struct Pass
+	{
+		std::vector<BufferCopies> buffers;
+	};
+
+	void add_buffer_copy(VkBuffer source, VkBuffer destination, const VkBufferCopy& region);
+	// Images are expected to be new, so each one is copied exactly once
+	void add_image_copy(ImageCopies copies);
+	void clear();
+
+	bool empty() const { return passes.empty() && images.empty(); }
+	const std::vector<Pass>& get_passes() const { return passes; }
+	const std::vector<ImageCopies>& get_images() const { return images; }
+	size_t get_copy_count() const { return copy_count; }
+	size_t get_byte_count() const { return byte_count; }
+
+private:
+	bool overlaps_current_pass(VkBuffer destination, const VkBufferCopy& region) const;
+
+	std::vector<Pass> passes;
+	// destination ranges written in the current pass, keyed by start
+	std::unordered_map<VkBuffer, std::map<VkDeviceSize, VkDeviceSize>> written;
+	std::vector<ImageCopies> images;
+	size_t copy_count = 0;
+	size_t byte_count = 0;
+};
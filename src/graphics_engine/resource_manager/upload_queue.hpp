@@ -0,0 +1,106 @@
+#pragma once
+
+#include "graphics_engine/graphics_engine_base_module.hpp"
+#include "graphics_engine/submission_retirement_queue.hpp"
+#include "graphics_buffer.hpp"
+#include "upload_batch.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+// Uploads host data into device-local buffers and images without stalling the
+// graphics queue. Data is written into a persistently mapped staging ring and
+// the copies are collected into one batch, which flush() records and submits
+// as a single submission: once per frame, or earlier when a one-off command
+// that may read the data is about to run. Staging space is retired through
+// the engine's graphics submission serials.
+//
+// When the device has a transfer-only queue family the copies run there, and
+// a second, small graphics submission waits for them and acquires ownership of
+// the written ranges and images.
+class GraphicsUploadQueue : public GraphicsEngineBaseModule
+{
+public:
+	GraphicsUploadQueue(GraphicsEngine& engine, GraphicsBuffer staging_buffer);
+	GraphicsUploadQueue(const GraphicsUploadQueue&) = delete;
+	~GraphicsUploadQueue() override;
+
+	void stage_buffer(
+		VkBuffer destination,
+		VkDeviceSize destination_offset,
+		VkDeviceSize size,
+		const std::function<void(std::byte*)>& write_function);
+	// The image must be in VK_IMAGE_LAYOUT_UNDEFINED; it is in
+	// VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL once the upload has run
+	void stage_image(
+		VkImage destination,
+		uint32_t width,
+		uint32_t height,
+		size_t size,
+		const std::function<void(std::byte*)>& write_function,
+		uint32_t layer_count,
+		const std::vector<size_t>& mip_sizes);
+
+	// Submits everything staged since the last flush, if anything was
+	void flush();
+	// Gives back staging space and command buffers of uploads tagged with
+	// completed_serial or earlier
+	void release_completed(SubmissionSerial completed_serial);
+
+	bool has_dedicated_transfer_queue() const { return transfer_queue != VK_NULL_HANDLE; }
+
+	static constexpr size_t BUFFER_COPY_ALIGNMENT = 4;
+	// a multiple of every compressed block size
+	static constexpr size_t IMAGE_COPY_ALIGNMENT = 16;
+
+private:
+	struct InFlightUpload
+	{
+		StagingRing::Position ring_position;
+		VkFence fence = VK_NULL_HANDLE;
+		VkSemaphore transfer_finished = VK_NULL_HANDLE;
+		VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
+		VkCommandBuffer graphics_command_buffer = VK_NULL_HANDLE;
+		std::vector<GraphicsBuffer> dedicated_staging;
+	};
+
+	// Staging memory for size bytes, waiting for older uploads to retire if the
+	// ring is full. Uploads larger than the ring get a buffer of their own.
+	std::pair<VkBuffer, VkDeviceSize> allocate(size_t size, size_t alignment, std::byte*& memory);
+	void wait_for_oldest_upload();
+	// Completes uploads whose fences have signalled
+	void poll_fences();
+
+	VkCommandBuffer begin_command_buffer(VkCommandPool pool);
+	void record_copies(VkCommandBuffer command_buffer);
+	void record_transitions_to_transfer(VkCommandBuffer command_buffer);
+	// With one queue family this makes the copies visible to later graphics
+	// work; with two it is the release half of the ownership transfer, and
+	// record_acquire the other
+	void record_release(VkCommandBuffer command_buffer);
+	void record_acquire(VkCommandBuffer command_buffer);
+	void destroy(InFlightUpload& upload);
+
+	GraphicsBuffer staging_buffer;
+	std::byte* staging_memory = nullptr;
+	StagingRing ring;
+	UploadBatch batch;
+	std::vector<GraphicsBuffer> pending_dedicated_staging;
+
+	uint32_t graphics_family = 0;
+	uint32_t transfer_family = 0;
+	VkQueue transfer_queue = VK_NULL_HANDLE;
+	VkCommandPool graphics_command_pool = VK_NULL_HANDLE;
+	VkCommandPool transfer_command_pool = VK_NULL_HANDLE;
+
+	SubmissionRetirementQueue<InFlightUpload> in_flight;
+	// fences of in-flight uploads, oldest first
+	std::deque<std::pair<SubmissionSerial, VkFence>> pending_fences;
+};
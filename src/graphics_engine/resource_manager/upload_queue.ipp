@@ -0,0 +1,500 @@
+#include "upload_queue.hpp"
+#include "graphics_engine/graphics_engine.hpp"
+#include "graphics_engine/queues.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+namespace
+{
+// Stages at which uploaded buffers and images are read after the upload
+constexpr VkPipelineStageFlags UPLOAD_CONSUMER_STAGES =
+	VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+	VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+	VK_PIPELINE_STAGE_TRANSFER_BIT;
+constexpr VkAccessFlags UPLOAD_CONSUMER_ACCESS =
+	VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+	VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+VkCommandPool create_upload_command_pool(VkDevice device, const uint32_t queue_family)
+{
+	VkCommandPoolCreateInfo create_info{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+	create_info.queueFamilyIndex = queue_family;
+	create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	VkCommandPool pool;
+	if (vkCreateCommandPool(device, &create_info, nullptr, &pool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("GraphicsUploadQueue: failed to create command pool!");
+	}
+	return pool;
+}
+
+// One barrier per written range; ownership moves from src_family to
+// dst_family, or stays put when both are VK_QUEUE_FAMILY_IGNORED
+std::vector<VkBufferMemoryBarrier> buffer_barriers(
+	const UploadBatch& batch,
+	const VkAccessFlags src_access,
+	const VkAccessFlags dst_access,
+	const uint32_t src_family,
+	const uint32_t dst_family)
+{
+	std::vector<VkBufferMemoryBarrier> barriers;
+	for (const auto& pass : batch.get_passes())
+		for (const auto& copies : pass.buffers)
+			for (const auto& region : copies.regions)
+			{
+				VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+				barrier.srcAccessMask = src_access;
+				barrier.dstAccessMask = dst_access;
+				barrier.srcQueueFamilyIndex = src_family;
+				barrier.dstQueueFamilyIndex = dst_family;
+				barrier.buffer = copies.destination;
+				barrier.offset = region.dstOffset;
+				barrier.size = region.size;
+				barriers.push_back(barrier);
+			}
+	return barriers;
+}
+
+std::vector<VkImageMemoryBarrier> image_barriers(
+	const UploadBatch& batch,
+	const VkImageLayout old_layout,
+	const VkImageLayout new_layout,
+	const VkAccessFlags src_access,
+	const VkAccessFlags dst_access,
+	const uint32_t src_family = VK_QUEUE_FAMILY_IGNORED,
+	const uint32_t dst_family = VK_QUEUE_FAMILY_IGNORED)
+{
+	std::vector<VkImageMemoryBarrier> barriers;
+	barriers.reserve(batch.get_images().size());
+	for (const auto& image : batch.get_images())
+	{
+		VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+		barrier.oldLayout = old_layout;
+		barrier.newLayout = new_layout;
+		barrier.srcAccessMask = src_access;
+		barrier.dstAccessMask = dst_access;
+		barrier.srcQueueFamilyIndex = src_family;
+		barrier.dstQueueFamilyIndex = dst_family;
+		barrier.image = image.destination;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = image.mip_levels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = image.layer_count;
+		barriers.push_back(barrier);
+	}
+	return barriers;
+}
+}
+
+GraphicsUploadQueue::GraphicsUploadQueue(GraphicsEngine& engine, GraphicsBuffer staging) :
+	GraphicsEngineBaseModule(engine),
+	staging_buffer(std::move(staging)),
+	ring(staging_buffer.get_capacity())
+{
+	// the ring stays mapped for the lifetime of the queue
+	void* mapped_data = nullptr;
+	if (vkMapMemory(get_logical_device(), staging_buffer.get_memory(), 0, VK_WHOLE_SIZE, 0, &mapped_data) != VK_SUCCESS)
+	{
+		throw std::runtime_error("GraphicsUploadQueue: failed to map the staging buffer!");
+	}
+	staging_memory = static_cast<std::byte*>(mapped_data);
+
+	const QueueFamilyIndices families = engine.findQueueFamilies(get_physical_device());
+	graphics_family = families.graphicsFamily.value();
+	graphics_command_pool = create_upload_command_pool(get_logical_device(), graphics_family);
+	if (families.transferFamily && engine.get_transfer_queue() != VK_NULL_HANDLE)
+	{
+		transfer_family = *families.transferFamily;
+		transfer_queue = engine.get_transfer_queue();
+		transfer_command_pool = create_upload_command_pool(get_logical_device(), transfer_family);
+	}
+}
+
+GraphicsUploadQueue::~GraphicsUploadQueue()
+{
+	// the engine waits for the device to go idle before its modules are destroyed
+	for (auto& upload : in_flight.release_all())
+		destroy(upload);
+	for (auto& buffer : pending_dedicated_staging)
+		buffer.destroy(get_logical_device());
+	vkUnmapMemory(get_logical_device(), staging_buffer.get_memory());
+	staging_buffer.destroy(get_logical_device());
+	vkDestroyCommandPool(get_logical_device(), graphics_command_pool, nullptr);
+	if (transfer_command_pool)
+		vkDestroyCommandPool(get_logical_device(), transfer_command_pool, nullptr);
+}
+
+void GraphicsUploadQueue::stage_buffer(
+	const VkBuffer destination,
+	const VkDeviceSize destination_offset,
+	const VkDeviceSize size,
+	const std::function<void(std::byte*)>& write_function)
+{
+	if (size == 0)
+		return;
+	std::byte* memory;
+	const auto [source, source_offset] = allocate(static_cast<size_t>(size), BUFFER_COPY_ALIGNMENT, memory);
+	write_function(memory);
+
+	VkBufferCopy region{};
+	region.srcOffset = source_offset;
+	region.dstOffset = destination_offset;
+	region.size = size;
+	batch.add_buffer_copy(source, destination, region);
+}
+
+void GraphicsUploadQueue::stage_image(
+	const VkImage destination,
+	const uint32_t width,
+	const uint32_t height,
+	const size_t size,
+	const std::function<void(std::byte*)>& write_function,
+	const uint32_t layer_count,
+	const std::vector<size_t>& mip_sizes)
+{
+	std::byte* memory;
+	const auto [source, source_offset] = allocate(size, IMAGE_COPY_ALIGNMENT, memory);
+	write_function(memory);
+
+	UploadBatch::ImageCopies copies{
+		.source = source,
+		.destination = destination,
+		.layer_count = layer_count,
+		.mip_levels = mip_sizes.empty() ? 1 : static_cast<uint32_t>(mip_sizes.size()),
+		.size = size,
+		.regions = {},
+	};
+	VkDeviceSize offset = source_offset;
+	for (uint32_t mip = 0; mip < copies.mip_levels; ++mip)
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = mip;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layer_count;
+		region.imageExtent = {
+			std::max(1u, width >> mip),
+			std::max(1u, height >> mip),
+			1
+		};
+		copies.regions.push_back(region);
+		offset += mip_sizes.empty() ? size : mip_sizes[mip];
+	}
+	batch.add_image_copy(std::move(copies));
+}
+
+void GraphicsUploadQueue::flush()
+{
+	if (batch.empty())
+		return;
+
+	InFlightUpload upload;
+	upload.ring_position = ring.get_head();
+	upload.dedicated_staging = std::move(pending_dedicated_staging);
+	pending_dedicated_staging.clear();
+	try
+	{
+		VkFenceCreateInfo fence_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+		if (vkCreateFence(get_logical_device(), &fence_info, nullptr, &upload.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("GraphicsUploadQueue: failed to create fence!");
+		}
+
+		VkSubmitInfo graphics_submit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+		const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		if (has_dedicated_transfer_queue())
+		{
+			VkSemaphoreCreateInfo semaphore_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+			if (vkCreateSemaphore(get_logical_device(), &semaphore_info, nullptr, &upload.transfer_finished) != VK_SUCCESS)
+			{
+				throw std::runtime_error("GraphicsUploadQueue: failed to create semaphore!");
+			}
+
+			upload.transfer_command_buffer = begin_command_buffer(transfer_command_pool);
+			record_transitions_to_transfer(upload.transfer_command_buffer);
+			record_copies(upload.transfer_command_buffer);
+			record_release(upload.transfer_command_buffer);
+			vkEndCommandBuffer(upload.transfer_command_buffer);
+
+			VkSubmitInfo transfer_submit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+			transfer_submit.commandBufferCount = 1;
+			transfer_submit.pCommandBuffers = &upload.transfer_command_buffer;
+			transfer_submit.signalSemaphoreCount = 1;
+			transfer_submit.pSignalSemaphores = &upload.transfer_finished;
+			if (vkQueueSubmit(transfer_queue, 1, &transfer_submit, VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				throw std::runtime_error("GraphicsUploadQueue: failed to submit transfer commands!");
+			}
+
+			upload.graphics_command_buffer = begin_command_buffer(graphics_command_pool);
+			record_acquire(upload.graphics_command_buffer);
+			graphics_submit.waitSemaphoreCount = 1;
+			graphics_submit.pWaitSemaphores = &upload.transfer_finished;
+			graphics_submit.pWaitDstStageMask = &wait_stage;
+		}
+		else
+		{
+			upload.graphics_command_buffer = begin_command_buffer(graphics_command_pool);
+			record_transitions_to_transfer(upload.graphics_command_buffer);
+			record_copies(upload.graphics_command_buffer);
+			record_release(upload.graphics_command_buffer);
+		}
+		vkEndCommandBuffer(upload.graphics_command_buffer);
+
+		graphics_submit.commandBufferCount = 1;
+		graphics_submit.pCommandBuffers = &upload.graphics_command_buffer;
+		if (vkQueueSubmit(get_graphics_engine().get_graphics_queue(), 1, &graphics_submit, upload.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("GraphicsUploadQueue: failed to submit upload commands!");
+		}
+	}
+	catch (...)
+	{
+		vkQueueWaitIdle(get_graphics_engine().get_graphics_queue());
+		if (transfer_queue)
+			vkQueueWaitIdle(transfer_queue);
+		destroy(upload);
+		batch.clear();
+		throw;
+	}
+
+	const SubmissionSerial serial = get_graphics_engine().register_graphics_submission();
+	pending_fences.emplace_back(serial, upload.fence);
+	in_flight.enqueue(serial, std::move(upload));
+	batch.clear();
+}
+
+void GraphicsUploadQueue::release_completed(const SubmissionSerial completed_serial)
+{
+	while (!pending_fences.empty() && pending_fences.front().first <= completed_serial)
+		pending_fences.pop_front();
+	for (auto& upload : in_flight.release_completed(completed_serial))
+	{
+		ring.release_until(upload.ring_position);
+		destroy(upload);
+	}
+}
+
+std::pair<VkBuffer, VkDeviceSize> GraphicsUploadQueue::allocate(
+	const size_t size, const size_t alignment, std::byte*& memory)
+{
+	if (size > ring.get_capacity())
+	{
+		// rare enough, e.g. environment cube maps, that they are not worth a
+		// bigger ring
+		auto& buffer = pending_dedicated_staging.emplace_back(create_buffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			"upload_staging_buffer"));
+		void* mapped_data = nullptr;
+		if (vkMapMemory(get_logical_device(), buffer.get_memory(), 0, VK_WHOLE_SIZE, 0, &mapped_data) != VK_SUCCESS)
+		{
+			throw std::runtime_error("GraphicsUploadQueue: failed to map a staging buffer!");
+		}
+		memory = static_cast<std::byte*>(mapped_data);
+		return { buffer.get_buffer(), 0 };
+	}
+
+	poll_fences();
+	std::optional<size_t> offset;
+	while (!(offset = ring.allocate(size, alignment)))
+	{
+		// every byte of the ring is waiting to be copied; submit what is
+		// recorded and wait for the oldest upload rather than the whole queue
+		flush();
+		wait_for_oldest_upload();
+	}
+	memory = staging_memory + *offset;
+	return { staging_buffer.get_buffer(), *offset };
+}
+
+void GraphicsUploadQueue::wait_for_oldest_upload()
+{
+	if (pending_fences.empty())
+	{
+		throw std::logic_error("GraphicsUploadQueue: staging ring is full with no upload in flight");
+	}
+	if (vkWaitForFences(
+			get_logical_device(), 1, &pending_fences.front().second, VK_TRUE,
+			std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+	{
+		throw std::runtime_error("GraphicsUploadQueue: failed to wait for an upload!");
+	}
+	poll_fences();
+}
+
+void GraphicsUploadQueue::poll_fences()
+{
+	std::optional<SubmissionSerial> completed;
+	for (const auto& [serial, fence] : pending_fences)
+	{
+		if (vkGetFenceStatus(get_logical_device(), fence) != VK_SUCCESS)
+			break;
+		completed = serial;
+	}
+	// only this queue's resources are released here; the engine learns of
+	// completed serials from its frame fences
+	if (completed)
+		release_completed(*completed);
+}
+
+VkCommandBuffer GraphicsUploadQueue::begin_command_buffer(const VkCommandPool pool)
+{
+	VkCommandBufferAllocateInfo allocation_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+	allocation_info.commandPool = pool;
+	allocation_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocation_info.commandBufferCount = 1;
+	VkCommandBuffer command_buffer;
+	if (vkAllocateCommandBuffers(get_logical_device(), &allocation_info, &command_buffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("GraphicsUploadQueue: failed to allocate command buffer!");
+	}
+
+	VkCommandBufferBeginInfo begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(command_buffer, &begin_info);
+	return command_buffer;
+}
+
+void GraphicsUploadQueue::record_copies(const VkCommandBuffer command_buffer)
+{
+	const auto& passes = batch.get_passes();
+	for (size_t pass = 0; pass < passes.size(); ++pass)
+	{
+		if (pass > 0)
+		{
+			// this pass rewrites a range an earlier pass wrote
+			VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				command_buffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+		for (const auto& copies : passes[pass].buffers)
+		{
+			vkCmdCopyBuffer(
+				command_buffer,
+				copies.source,
+				copies.destination,
+				static_cast<uint32_t>(copies.regions.size()),
+				copies.regions.data());
+		}
+	}
+	for (const auto& image : batch.get_images())
+	{
+		vkCmdCopyBufferToImage(
+			command_buffer,
+			image.source,
+			image.destination,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(image.regions.size()),
+			image.regions.data());
+	}
+}
+
+void GraphicsUploadQueue::record_transitions_to_transfer(const VkCommandBuffer command_buffer)
+{
+	// undefined layout works because the images are about to be overwritten
+	const auto barriers = image_barriers(
+		batch,
+		VK_IMAGE_LAYOUT_UNDEFINED,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0,
+		VK_ACCESS_TRANSFER_WRITE_BIT);
+	if (barriers.empty())
+		return;
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr,
+		static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void GraphicsUploadQueue::record_release(const VkCommandBuffer command_buffer)
+{
+	if (!has_dedicated_transfer_queue())
+	{
+		VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = UPLOAD_CONSUMER_ACCESS;
+		const auto images = image_barriers(
+			batch,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT);
+		vkCmdPipelineBarrier(
+			command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			UPLOAD_CONSUMER_STAGES,
+			0, 1, &barrier, 0, nullptr,
+			static_cast<uint32_t>(images.size()), images.data());
+		return;
+	}
+
+	const auto buffers = buffer_barriers(
+		batch, VK_ACCESS_TRANSFER_WRITE_BIT, 0, transfer_family, graphics_family);
+	const auto images = image_barriers(
+		batch,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT,
+		0,
+		transfer_family,
+		graphics_family);
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr,
+		static_cast<uint32_t>(buffers.size()), buffers.data(),
+		static_cast<uint32_t>(images.size()), images.data());
+}
+
+void GraphicsUploadQueue::record_acquire(const VkCommandBuffer command_buffer)
+{
+	// matches record_release, including the layout transition
+	const auto buffers = buffer_barriers(
+		batch, 0, UPLOAD_CONSUMER_ACCESS, transfer_family, graphics_family);
+	const auto images = image_barriers(
+		batch,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		0,
+		VK_ACCESS_SHADER_READ_BIT,
+		transfer_family,
+		graphics_family);
+	vkCmdPipelineBarrier(
+		command_buffer,
+		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+		UPLOAD_CONSUMER_STAGES,
+		0, 0, nullptr,
+		static_cast<uint32_t>(buffers.size()), buffers.data(),
+		static_cast<uint32_t>(images.size()), images.data());
+}
+
+void GraphicsUploadQueue::destroy(InFlightUpload& upload)
+{
+	if (upload.transfer_command_buffer)
+		vkFreeCommandBuffers(get_logical_device(), transfer_command_pool, 1, &upload.transfer_command_buffer);
+	if (upload.graphics_command_buffer)
+		vkFreeCommandBuffers(get_logical_device(), graphics_command_pool, 1, &upload.graphics_command_buffer);
+	if (upload.transfer_finished)
+		vkDestroySemaphore(get_logical_device(), upload.transfer_finished, nullptr);
+	if (upload.fence)
+		vkDestroyFence(get_logical_device(), upload.fence, nullptr);
+	for (auto& buffer : upload.dedicated_staging)
+		buffer.destroy(get_logical_device());
+	upload = InFlightUpload{};
+}
@@ -93,7 +93,7 @@ public:
 		return persistent_windows;
 	}
 
-	void update_buffer_capacities(const std::vector<std::pair<size_t, size_t>>& capacities)
+	void update_buffer_capacities(const std::vector<GuiStatistics::BufferCapacity>& capacities)
 	{
 		statistics.update_buffer_capacities(capacities);
 	}
@@ -226,8 +226,7 @@ void GuiDebug::refresh_physics_visualiser(GameEngine& engine)
 				PhysicsVisual{object.get_id(), body.body_id}).first;
 		}
 		auto& transform = ecs.get_transformation(found->second.object);
-		transform.set_position(body.position);
-		transform.set_rotation(body.rotation);
+		transform.set_pose(body.position, body.rotation);
 	}
 
 	for (auto it = physics_visuals.begin(); it != physics_visuals.end(); ) {
@@ -99,6 +99,9 @@ void GuiSaveManager::draw()
 		ImGui::BeginDisabled(pending.has_value());
 		if (ImGui::Button("Save"))
 			queue(Action::SAVE, name_buffer.data());
+		ImGui::SameLine();
+		if (ImGui::Button("Export YAML"))
+			queue(Action::EXPORT_YAML, name_buffer.data());
 		ImGui::EndDisabled();
 		ImGui::SameLine();
 		ImGui::BeginDisabled(!selected || pending.has_value());
@@ -139,6 +142,10 @@ void GuiSaveManager::process(GameEngine& engine)
 					engine.save_scene(request->name);
 					result = "Saved '" + request->name + "'.";
 					break;
+				case Action::EXPORT_YAML:
+					engine.save_scene(request->name, SerializationFormat::Yaml);
+					result = "Exported '" + request->name + "' as YAML.";
+					break;
 				case Action::LOAD:
 					engine.load_scene(request->name);
 					result = "Loaded '" + request->name + "'.";
@@ -508,6 +515,11 @@ void GuiStatistics::draw()
 			ImVec2(0.0f, 0.0f),
 			label.data());
 		ImGui::SameLine(); ImGui::Text("%.2f Mb", float(capacity.total_capacity) * bytes_to_mb);
+		if (capacity.block_count > 0)
+		{
+			ImGui::SameLine();
+			ImGui::Text("%u blocks, %.0f%% fragmented", capacity.block_count, capacity.fragmentation * 100.0f);
+		}
 	}
 
 	}
@@ -515,16 +527,13 @@ void GuiStatistics::draw()
 }
 
 void GuiStatistics::update_buffer_capacities(
-	const std::vector<std::pair<size_t, size_t>>& buffer_capacities)
+	const std::vector<BufferCapacity>& buffer_capacities)
 {
 	assert(buffer_capacities.size() == this->buffer_capacities.size());
 
 	for (size_t i = 0; i < buffer_capacities.size(); ++i)
 	{
-		auto& [label, capacity] = this->buffer_capacities[i];
-		const auto& capacity_pair = buffer_capacities[i];
-		capacity.filled_capacity = capacity_pair.first;
-		capacity.total_capacity = capacity_pair.second;
+		this->buffer_capacities[i].second = buffer_capacities[i];
 	}
 }
 
@@ -131,7 +131,7 @@ public:
 	void process(GameEngine& engine) override;
 
 private:
-	enum class Action { SAVE, LOAD, DELETE_SAVE };
+	enum class Action { SAVE, EXPORT_YAML, LOAD, DELETE_SAVE };
 	struct Request { Action action; std::string name; };
 
 	void queue(Action action, const std::string& name);
@@ -199,23 +199,27 @@ public:
 	virtual void process(GameEngine& engine) override;
 	virtual void draw() override;
 
-	void update_buffer_capacities(const std::vector<std::pair<size_t, size_t>>& buffer_capacities);
-
-private:
 	struct BufferCapacity
 	{
 		size_t total_capacity = 0;
 		size_t filled_capacity = 0;
+		// 0 for buffers that do not grow
+		uint32_t block_count = 0;
+		float fragmentation = 0.0f;
 	};
 
+	void update_buffer_capacities(const std::vector<BufferCapacity>& buffer_capacities);
+
+private:
+
 	std::vector<std::pair<std::string, BufferCapacity>> buffer_capacities = {
 		{ "vertex buffer", {} },
 		{ "index buffer", {} },
-		{ "uniform buffer", {} },
+		{ "object data (per frame)", {} },
 		{ "materials buffer", {} },
 		// For ray tracing:
 		// { "mapping buffer", {} },
-		{ "bone buffer", {} }
+		{ "bone data (per frame)", {} }
 	};
 };
 
@@ -2,6 +2,7 @@
 
 #include "constants.hpp"
 
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
@@ -21,17 +22,19 @@ public:
 
 	uint64_t get_underlying() const { return id; }
 
+	// Safe to call from any thread, as meshes and materials are constructed
+	// on task pool workers while importing
 	static GenericID generate_new_id()
 	{
-		return GenericID(global_id++);
+		return GenericID(global_id.fetch_add(1, std::memory_order_relaxed));
 	}
 
-	static uint64_t get_next_id() { return global_id; }
-	static void set_next_id(const uint64_t next_id) { global_id = next_id; }
+	static uint64_t get_next_id() { return global_id.load(std::memory_order_relaxed); }
+	static void set_next_id(const uint64_t next_id) { global_id.store(next_id, std::memory_order_relaxed); }
 
 private:
 	uint64_t id;
-	static inline uint64_t global_id = 0;
+	static inline std::atomic<uint64_t> global_id = 0;
 };
 
 template<typename Tag>
@@ -432,8 +432,7 @@ void Gizmo::select_object(Object* obj)
 	selected_object = obj;
 	auto& gizmo_transform = transformation(engine, *this);
 	auto& selected_transform = transformation(engine, *selected_object);
-	gizmo_transform.set_position(selected_transform.get_position());
-	gizmo_transform.set_rotation(selected_transform.get_rotation());
+	gizmo_transform.set_pose(selected_transform.get_position(), selected_transform.get_rotation());
 	selected_transform.attach_to(gizmo_transform);
 
 	isActive = true;
@@ -0,0 +1,52 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path& path)
+{
+	const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (descriptor < 0)
+		return std::nullopt;
+	struct stat status {};
+	void* mapping = MAP_FAILED;
+	size_t size = 0;
+	if (::fstat(descriptor, &status) == 0 && status.st_size > 0)
+	{
+		size = static_cast<size_t>(status.st_size);
+		mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+	}
+	::close(descriptor);
+	if (mapping == MAP_FAILED)
+		return std::nullopt;
+	return MappedFile(static_cast<std::byte*>(mapping), size);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	mapping(std::exchange(other.mapping, nullptr)),
+	mapping_size(std::exchange(other.mapping_size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (mapping)
+			::munmap(mapping, mapping_size);
+		mapping = std::exchange(other.mapping, nullptr);
+		mapping_size = std::exchange(other.mapping_size, 0);
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	if (mapping)
+		::munmap(mapping, mapping_size);
+}
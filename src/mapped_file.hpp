@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+
+// A whole file mapped copy-on-write. Pages are read from the page cache when
+// first touched, and writes through data() stay private to this process. The
+// file may be renamed or unlinked while mapped, but must not be truncated.
+class MappedFile
+{
+public:
+	// std::nullopt if the file cannot be opened or mapped, or is empty
+	static std::optional<MappedFile> open(const std::filesystem::path& path);
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	std::byte* data() const { return mapping; }
+	size_t size() const { return mapping_size; }
+	std::span<const std::byte> bytes() const { return { mapping, mapping_size }; }
+
+private:
+	MappedFile(std::byte* mapping, size_t mapping_size) : mapping(mapping), mapping_size(mapping_size) {}
+
+	std::byte* mapping = nullptr;
+	size_t mapping_size = 0;
+};
@@ -70,6 +70,40 @@ namespace Maths
 
 	template glm::vec4 lerp<glm::vec4>(glm::vec4 a, glm::vec4 b, float t);
 
+	// The SplitMix64 finalizer
+	static uint64_t mix_bits(uint64_t value)
+	{
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+
+	// Scrambled so that nearby seeds do not give overlapping streams
+	CounterRandom::CounterRandom(uint64_t seed) :
+		key(mix_bits(seed))
+	{
+	}
+
+	uint64_t CounterRandom::next()
+	{
+		return mix_bits(key + ++counter * 0x9e3779b97f4a7c15ull);
+	}
+
+	float CounterRandom::uniform(float min, float max)
+	{
+		// the top 24 bits, exactly representable as a float
+		const float unit = static_cast<float>(next() >> 40) * 0x1.0p-24f;
+		return min + unit * (max - min);
+	}
+
+	glm::vec3 CounterRandom::uniform(const glm::vec3& min, const glm::vec3& max)
+	{
+		const float x = uniform(min.x, max.x);
+		const float y = uniform(min.y, max.y);
+		const float z = uniform(min.z, max.z);
+		return { x, y, z };
+	}
+
 	// taken from http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-17-quaternions/
 	glm::quat RotationBetweenVectors(const glm::vec3& start, const glm::vec3& end)
 	{
@@ -325,17 +359,38 @@ namespace Maths
 		}
 	}
 
+	// While the matrix is current, each setter rewrites only the columns it
+	// affects and leaves the other components to be decomposed on demand
+
 	void Transform::set_pos(const glm::vec3& new_pos)
 	{
-		update_components_from_mat4();
 		position = new_pos;
-		is_up_to_date_flags |= 0b1000;
-		is_up_to_date_flags &= 0b1110;
+		set_not_old(0b1000);
+		if (!is_old(0b0001))
+			transform[3] = glm::vec4(new_pos, 1.0f);
 	}
 
 	void Transform::set_scale(const glm::vec3& new_scale)
 	{
-		update_components_from_mat4();
+		if (!is_old(0b0001))
+		{
+			const glm::vec3 old_scale = get_scale();
+			const auto is_degenerate = [](const glm::vec3& s)
+			{
+				return absf(s.x) <= ACCEPTABLE_FLOATING_PT_DIFF || absf(s.y) <= ACCEPTABLE_FLOATING_PT_DIFF
+					|| absf(s.z) <= ACCEPTABLE_FLOATING_PT_DIFF;
+			};
+			if (!is_degenerate(old_scale) && !is_degenerate(new_scale))
+			{
+				for (int axis = 0; axis < 3; ++axis)
+					transform[axis] *= new_scale[axis] / old_scale[axis];
+				scale = new_scale;
+				return;
+			}
+			// a collapsed axis loses its direction, so keep the decomposed
+			// components and rebuild the matrix from them
+			update_components_from_mat4();
+		}
 		scale = new_scale;
 		is_up_to_date_flags |= 0b0100;
 		is_up_to_date_flags &= 0b1110;
@@ -343,7 +398,16 @@ namespace Maths
 
 	void Transform::set_orient(const glm::quat& new_orient)
 	{
-		update_components_from_mat4();
+		if (!is_old(0b0001))
+		{
+			const glm::vec3 current_scale = get_scale();
+			const glm::mat3 rotation = glm::mat3_cast(glm::normalize(new_orient));
+			for (int axis = 0; axis < 3; ++axis)
+				transform[axis] = glm::vec4(rotation[axis] * current_scale[axis], 0.0f);
+			orientation = new_orient;
+			set_not_old(0b0010);
+			return;
+		}
 		orientation = new_orient;
 		is_up_to_date_flags |= 0b0010;
 		is_up_to_date_flags &= 0b1110;
@@ -353,10 +417,7 @@ namespace Maths
 	{
 		transform = new_transform;
 		is_up_to_date_flags = 0b0001;
-		get_pos();
-		get_orient();
-		get_scale();
-	}	
+	}
 
 	std::optional<glm::vec3> ray_sphere_collision(const Sphere& sphere, const Ray& ray)
 	{
@@ -7,6 +7,7 @@
 
 #include <optional>
 #include <cmath>
+#include <cstdint>
 
 
 namespace Maths
@@ -24,6 +25,23 @@ namespace Maths
 	template<class T>
 	T lerp(T a, T b, float t);
 
+	// Counter-based generator: the nth draw depends only on the key and n, so a
+	// stream gives the same values whichever thread draws from it
+	class CounterRandom
+	{
+	public:
+		explicit CounterRandom(uint64_t seed);
+
+		uint64_t next();
+		// In [min, max)
+		float uniform(float min, float max);
+		glm::vec3 uniform(const glm::vec3& min, const glm::vec3& max);
+
+	private:
+		uint64_t key;
+		uint64_t counter = 0;
+	};
+
 	constexpr float deg2rad(float deg) { return PI * deg / 180.0f; }
 	constexpr float rad2deg(float rad) { return rad * 180.0f / PI; }
 
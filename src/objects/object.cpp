@@ -29,4 +29,5 @@ void Object::deserialize(const Deserializer& in)
 	ObjectID::set_next_id(std::max(ObjectID::get_next_id(), restored_id + 1));
 	name = in.read<std::string>("name");
 	bVisible = in.read<bool>("visible");
+	++visibility_generation;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "identifications.hpp"
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -24,9 +26,21 @@ public:
 	virtual void serialize(Serializer& out) const;
 	virtual void deserialize(const Deserializer& in);
 
-	virtual void toggle_visibility() { bVisible = !bVisible; }
-	virtual void set_visibility(bool isVisible) { bVisible = isVisible; }
+	virtual void toggle_visibility()
+	{
+		bVisible = !bVisible;
+		++visibility_generation;
+	}
+	virtual void set_visibility(bool isVisible)
+	{
+		if (bVisible != isVisible)
+			++visibility_generation;
+		bVisible = isVisible;
+	}
 	bool get_visibility() const { return bVisible; }
+	// Advances whenever any object's visibility changes, so that mirrors of
+	// object state only re-read visibility after it may have changed
+	static uint64_t get_visibility_generation() { return visibility_generation.load(std::memory_order_relaxed); }
 	void set_transient(bool transient) { transient_object = transient; }
 	bool is_transient() const { return transient_object; }
 
@@ -40,4 +54,6 @@ private:
 
 	bool bVisible = true;
 	bool transient_object = false;
+
+	static inline std::atomic<uint64_t> visibility_generation = 0;
 };
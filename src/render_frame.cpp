@@ -1,52 +1,194 @@
 #include "render_frame.hpp"
 
-#include <functional>
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
+#include <utility>
 
 
-std::vector<glm::mat4> compose_transform_hierarchy(
-	const std::span<const glm::mat4> local_transforms,
-	const std::span<const uint32_t> parent_indices)
+RenderableStateList::RenderableStateList(const std::initializer_list<RenderableState> states)
 {
-	if (local_transforms.size() != parent_indices.size())
-		throw std::invalid_argument("compose_transform_hierarchy: transform and parent counts differ");
+	for (const auto& state : states)
+		push_back(state);
+}
 
-	const size_t count = local_transforms.size();
-	for (const uint32_t parent : parent_indices)
-		if (parent != RENDER_FRAME_NO_PARENT && parent >= count)
-			throw std::invalid_argument("compose_transform_hierarchy: invalid parent index");
+RenderableStateList::RenderableStateList(const RenderableStateList& other) :
+	chunks(other.chunks),
+	count(other.count)
+{}
+
+RenderableStateList& RenderableStateList::operator=(const RenderableStateList& other)
+{
+	// assigning element-wise keeps the capacity of the chunk table
+	chunks = other.chunks;
+	count = other.count;
+	return *this;
+}
+
+const RenderableState& RenderableStateList::at(const size_t index) const
+{
+	if (index >= count)
+		throw std::out_of_range("RenderableStateList::at: index out of range");
+	return (*this)[index];
+}
+
+void RenderableStateList::push_back(RenderableState state)
+{
+	if (count % CHUNK_SIZE == 0)
+		chunks.push_back(take_spare_chunk());
+	writable_chunk(chunks.size() - 1).push_back(std::move(state));
+	++count;
+}
+
+void RenderableStateList::clear()
+{
+	chunks.clear();
+	count = 0;
+}
 
-	enum class ResolutionState : uint8_t
+RenderableState& RenderableStateList::edit(const size_t index)
+{
+	return writable_chunk(index / CHUNK_SIZE)[index % CHUNK_SIZE];
+}
+
+void RenderableStateList::recycle_released_chunks()
+{
+	std::erase_if(retired_chunks, [this](std::shared_ptr<Chunk>& chunk) {
+		if (chunk.use_count() != 1)
+			return false;
+		// pairs with the release of the last other owner, see writable_chunk
+		std::atomic_thread_fence(std::memory_order_acquire);
+		chunk->clear();
+		spare_chunks.push_back(std::move(chunk));
+		return true;
+	});
+}
+
+bool RenderableStateList::has_same_definitions(const RenderableStateList& other) const
+{
+	if (count != other.count)
+		return false;
+	for (size_t chunk_index = 0; chunk_index < chunks.size(); ++chunk_index)
 	{
-		UNRESOLVED,
-		RESOLVING,
-		RESOLVED,
-	};
+		const Chunk& chunk = *chunks[chunk_index];
+		const Chunk& other_chunk = *other.chunks[chunk_index];
+		if (&chunk == &other_chunk)
+			continue;
+		for (size_t index = 0; index < chunk.size(); ++index)
+			if (chunk[index].definition != other_chunk[index].definition)
+				return false;
+	}
+	return true;
+}
 
-	std::vector<glm::mat4> composed(count);
-	std::vector<ResolutionState> states(count, ResolutionState::UNRESOLVED);
-	std::function<void(uint32_t)> resolve = [&](const uint32_t index)
+RenderableStateList::Chunk& RenderableStateList::writable_chunk(const size_t chunk_index)
+{
+	auto& chunk = chunks[chunk_index];
+	if (chunk.use_count() != 1)
 	{
-		if (states[index] == ResolutionState::RESOLVED)
-			return;
-		if (states[index] == ResolutionState::RESOLVING)
-			throw std::invalid_argument("compose_transform_hierarchy: parent cycle");
+		auto copy = take_spare_chunk();
+		copy->assign(chunk->begin(), chunk->end());
+		retired_chunks.push_back(std::exchange(chunk, std::move(copy)));
+	}
+	else
+	{
+		// pairs with the release of the last other owner, which may have been
+		// reading the chunk on another thread
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+	return *chunk;
+}
 
-		states[index] = ResolutionState::RESOLVING;
-		const uint32_t parent = parent_indices[index];
-		if (parent == RENDER_FRAME_NO_PARENT)
-			composed[index] = local_transforms[index];
+std::shared_ptr<RenderableStateList::Chunk> RenderableStateList::take_spare_chunk()
+{
+	if (spare_chunks.empty())
+	{
+		auto chunk = std::make_shared<Chunk>();
+		chunk->reserve(CHUNK_SIZE);
+		return chunk;
+	}
+	auto chunk = std::move(spare_chunks.back());
+	spare_chunks.pop_back();
+	return chunk;
+}
+
+std::shared_ptr<RenderFrame> RenderFramePool::acquire()
+{
+	std::shared_ptr<RenderFrame> acquired;
+	for (const auto& frame : frames)
+	{
+		if (frame.use_count() != 1)
+			continue;
+		// pairs with the release of the last consumer
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!acquired)
+			acquired = frame;
 		else
 		{
-			resolve(parent);
-			composed[index] = composed[parent] * local_transforms[index];
+			// idle frames would otherwise keep shared chunks from being recycled
+			frame->renderables.clear();
 		}
-		states[index] = ResolutionState::RESOLVED;
+	}
+	if (!acquired)
+		acquired = frames.emplace_back(std::make_shared<RenderFrame>());
+	return acquired;
+}
+
+std::vector<uint32_t> make_parent_first_order(const std::span<const uint32_t> parent_indices)
+{
+	const size_t count = parent_indices.size();
+	for (const uint32_t parent : parent_indices)
+		if (parent != RENDER_FRAME_NO_PARENT && parent >= count)
+			throw std::invalid_argument("make_parent_first_order: invalid parent index");
+
+	enum class PlacementState : uint8_t
+	{
+		UNPLACED,
+		PLACING,
+		PLACED,
 	};
 
+	std::vector<PlacementState> states(count, PlacementState::UNPLACED);
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	std::vector<uint32_t> chain;
 	for (uint32_t index = 0; index < count; ++index)
-		resolve(index);
+	{
+		// climb to the nearest placed ancestor, then place the chain from the top
+		for (uint32_t node = index;
+			node != RENDER_FRAME_NO_PARENT && states[node] != PlacementState::PLACED;
+			node = parent_indices[node])
+		{
+			if (states[node] == PlacementState::PLACING)
+				throw std::invalid_argument("make_parent_first_order: parent cycle");
+			states[node] = PlacementState::PLACING;
+			chain.push_back(node);
+		}
+		for (auto node = chain.rbegin(); node != chain.rend(); ++node)
+		{
+			order.push_back(*node);
+			states[*node] = PlacementState::PLACED;
+		}
+		chain.clear();
+	}
+	return order;
+}
+
+std::vector<glm::mat4> compose_transform_hierarchy(
+	const std::span<const glm::mat4> local_transforms,
+	const std::span<const uint32_t> parent_indices)
+{
+	if (local_transforms.size() != parent_indices.size())
+		throw std::invalid_argument("compose_transform_hierarchy: transform and parent counts differ");
 
+	std::vector<glm::mat4> composed(local_transforms.size());
+	for (const uint32_t index : make_parent_first_order(parent_indices))
+	{
+		const uint32_t parent = parent_indices[index];
+		composed[index] = parent == RENDER_FRAME_NO_PARENT
+			? local_transforms[index]
+			: composed[parent] * local_transforms[index];
+	}
 	return composed;
 }
 
@@ -59,15 +201,39 @@ std::vector<SDS::Bone> compose_bone_transforms(
 	for (const auto& bone : definition.bones)
 		parent_indices.push_back(bone.parent_index);
 
-	const auto model_transforms = compose_transform_hierarchy(local_transforms, parent_indices);
+	RenderSkeletonDefinition ordered{
+		.id = definition.id,
+		.bones = definition.bones,
+		.parent_first_order = make_parent_first_order(parent_indices),
+	};
 	std::vector<SDS::Bone> result(definition.bones.size());
-	for (size_t index = 0; index < definition.bones.size(); ++index)
+	compose_bone_transforms(local_transforms, ordered, result);
+	return result;
+}
+
+void compose_bone_transforms(
+	const std::span<const glm::mat4> local_transforms,
+	const RenderSkeletonDefinition& definition,
+	const std::span<SDS::Bone> out)
+{
+	const size_t count = definition.bones.size();
+	if (local_transforms.size() != count || out.size() != count
+		|| definition.parent_first_order.size() != count)
+		throw std::invalid_argument("compose_bone_transforms: pose and skeleton sizes differ");
+
+	// final_transform holds the model-space transform until every child has used it
+	for (const uint32_t index : definition.parent_first_order)
 	{
-		result[index].inverse_transform = definition.bones[index].inverse_bind_pose;
-		result[index].final_transform =
-			model_transforms[index] * definition.bones[index].inverse_bind_pose;
+		const uint32_t parent = definition.bones[index].parent_index;
+		out[index].final_transform = parent == RENDER_FRAME_NO_PARENT
+			? local_transforms[index]
+			: out[parent].final_transform * local_transforms[index];
+	}
+	for (size_t index = 0; index < count; ++index)
+	{
+		out[index].inverse_transform = definition.bones[index].inverse_bind_pose;
+		out[index].final_transform *= definition.bones[index].inverse_bind_pose;
 	}
-	return result;
 }
 
 void RenderFrameMailbox::publish_completed(RenderFramePtr frame)
@@ -75,70 +241,89 @@ void RenderFrameMailbox::publish_completed(RenderFramePtr frame)
 	if (!frame)
 		throw std::invalid_argument("RenderFrameMailbox::publish_completed: frame is empty");
 
+	const CompletedRenderFramesPtr previous_publication =
+		latest.load(std::memory_order_acquire);
+	// definitions identical to the previous publication were validated then
+	const bool same_renderables = previous_publication
+		&& frame->renderables.has_same_definitions(previous_publication->current->renderables);
 	std::unordered_map<RenderableID, const RenderableDefinition*>
 		next_renderable_definitions;
-	next_renderable_definitions.reserve(frame->renderables.size());
-	for (const auto& state : frame->renderables)
+	if (!same_renderables)
 	{
-		if (!state.definition)
-			throw std::invalid_argument(
-				"RenderFrameMailbox::publish_completed: renderable definition is empty");
-		const RenderableID id = state.definition->id;
-		if (!next_renderable_definitions.emplace(id, state.definition.get()).second)
-			throw std::logic_error(
-				"RenderFrameMailbox::publish_completed: duplicate renderable ID");
-		if (const auto active = active_renderable_definitions.find(id);
-			active != active_renderable_definitions.end())
+		next_renderable_definitions.reserve(frame->renderables.size());
+		for (const auto& state : frame->renderables)
 		{
-			if (active->second != state.definition.get())
+			if (!state.definition)
+				throw std::invalid_argument(
+					"RenderFrameMailbox::publish_completed: renderable definition is empty");
+			const RenderableID id = state.definition->id;
+			if (!next_renderable_definitions.emplace(id, state.definition.get()).second)
 				throw std::logic_error(
-					"RenderFrameMailbox::publish_completed: renderable definition changed for an existing ID");
-		}
-		else if (seen_renderable_ids.contains(id))
-		{
-			throw std::logic_error(
-				"RenderFrameMailbox::publish_completed: retired renderable ID was reintroduced");
+					"RenderFrameMailbox::publish_completed: duplicate renderable ID");
+			if (const auto active = active_renderable_definitions.find(id);
+				active != active_renderable_definitions.end())
+			{
+				if (active->second != state.definition.get())
+					throw std::logic_error(
+						"RenderFrameMailbox::publish_completed: renderable definition changed for an existing ID");
+			}
+			else if (seen_renderable_ids.contains(id))
+			{
+				throw std::logic_error(
+					"RenderFrameMailbox::publish_completed: retired renderable ID was reintroduced");
+			}
 		}
 	}
 
+	// likewise for skeleton definitions compared in order
+	const bool same_skeletons = previous_publication
+		&& std::ranges::equal(
+			frame->skeletons, previous_publication->current->skeletons, {},
+			&RenderSkeletonPose::definition, &RenderSkeletonPose::definition);
 	std::unordered_map<SkeletonID, const RenderSkeletonDefinition*>
 		next_skeleton_definitions;
-	next_skeleton_definitions.reserve(frame->skeletons.size());
-	for (const auto& pose : frame->skeletons)
+	if (!same_skeletons)
 	{
-		if (!pose.definition)
-			throw std::invalid_argument(
-				"RenderFrameMailbox::publish_completed: skeleton definition is empty");
-		const SkeletonID id = pose.definition->id;
-		if (!next_skeleton_definitions.emplace(id, pose.definition.get()).second)
-			throw std::logic_error(
-				"RenderFrameMailbox::publish_completed: duplicate skeleton ID");
-		if (const auto active = active_skeleton_definitions.find(id);
-			active != active_skeleton_definitions.end())
+		next_skeleton_definitions.reserve(frame->skeletons.size());
+		for (const auto& pose : frame->skeletons)
 		{
-			if (active->second != pose.definition.get())
+			if (!pose.definition)
+				throw std::invalid_argument(
+					"RenderFrameMailbox::publish_completed: skeleton definition is empty");
+			const SkeletonID id = pose.definition->id;
+			if (!next_skeleton_definitions.emplace(id, pose.definition.get()).second)
 				throw std::logic_error(
-					"RenderFrameMailbox::publish_completed: skeleton definition changed for an existing ID");
-		}
-		else if (seen_skeleton_ids.contains(id))
-		{
-			throw std::logic_error(
-				"RenderFrameMailbox::publish_completed: retired skeleton ID was reintroduced");
+					"RenderFrameMailbox::publish_completed: duplicate skeleton ID");
+			if (const auto active = active_skeleton_definitions.find(id);
+				active != active_skeleton_definitions.end())
+			{
+				if (active->second != pose.definition.get())
+					throw std::logic_error(
+						"RenderFrameMailbox::publish_completed: skeleton definition changed for an existing ID");
+			}
+			else if (seen_skeleton_ids.contains(id))
+			{
+				throw std::logic_error(
+					"RenderFrameMailbox::publish_completed: retired skeleton ID was reintroduced");
+			}
 		}
 	}
 
-	const CompletedRenderFramesPtr previous_publication =
-		latest.load(std::memory_order_acquire);
-	auto publication = std::make_shared<const CompletedRenderFrames>(CompletedRenderFrames{
-		.current = std::move(frame),
-		.previous = previous_publication ? previous_publication->current : nullptr,
-	});
-	for (const auto& [id, _] : next_renderable_definitions)
-		seen_renderable_ids.insert(id);
-	for (const auto& [id, _] : next_skeleton_definitions)
-		seen_skeleton_ids.insert(id);
-	active_renderable_definitions = std::move(next_renderable_definitions);
-	active_skeleton_definitions = std::move(next_skeleton_definitions);
+	auto publication = acquire_publication();
+	publication->current = std::move(frame);
+	publication->previous = previous_publication ? previous_publication->current : nullptr;
+	if (!same_renderables)
+	{
+		for (const auto& [id, _] : next_renderable_definitions)
+			seen_renderable_ids.insert(id);
+		active_renderable_definitions = std::move(next_renderable_definitions);
+	}
+	if (!same_skeletons)
+	{
+		for (const auto& [id, _] : next_skeleton_definitions)
+			seen_skeleton_ids.insert(id);
+		active_skeleton_definitions = std::move(next_skeleton_definitions);
+	}
 	latest.store(std::move(publication), std::memory_order_release);
 }
 
@@ -146,3 +331,26 @@ CompletedRenderFramesPtr RenderFrameMailbox::load_latest() const
 {
 	return latest.load(std::memory_order_acquire);
 }
+
+std::shared_ptr<CompletedRenderFrames> RenderFrameMailbox::acquire_publication()
+{
+	std::shared_ptr<CompletedRenderFrames> acquired;
+	for (const auto& publication : publications)
+	{
+		if (publication.use_count() != 1)
+			continue;
+		// pairs with the release of the last consumer
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!acquired)
+			acquired = publication;
+		else
+		{
+			// release the frames of idle publications so the producer can reuse them
+			publication->current.reset();
+			publication->previous.reset();
+		}
+	}
+	if (!acquired)
+		acquired = publications.emplace_back(std::make_shared<CompletedRenderFrames>());
+	return acquired;
+}
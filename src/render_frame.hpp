@@ -1,5 +1,6 @@
 #pragma once
 
+#include "collision/bounding_box.hpp"
 #include "entity_component_system/material_system.hpp"
 #include "entity_component_system/mesh_system.hpp"
 #include "identifications.hpp"
@@ -10,8 +11,11 @@
 #include <glm/vec3.hpp>
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <optional>
@@ -39,6 +43,9 @@ struct RenderableDefinition
 	MeshHandle mesh_owner;
 	std::vector<MaterialHandle> material_owners;
 	std::optional<std::filesystem::path> environment_lighting_asset;
+	// Mesh bounds for culling. Empty for renderables that are never culled,
+	// such as skinned meshes, whose poses can leave their bind-pose bounds.
+	std::optional<AABB> local_bounds;
 
 	MeshID get_mesh_id() const { return mesh_owner->get_id(); }
 	// Direct owner-based access keeps graphics reads off the mutable registries.
@@ -83,6 +90,103 @@ struct RenderableState
 	RenderableDefinitionPtr definition;
 	glm::mat4 model_transform{ 1.0f };
 	bool visible = true;
+	// definition->local_bounds under model_transform
+	std::optional<AABB> world_bounds;
+};
+
+// Renderable states stored in fixed-size chunks. Copies share chunks, and a
+// chunk is duplicated only when written while shared, so a frame built from
+// the previous one shares every chunk that did not change. Chunks replaced by
+// such writes are kept and reused once no copy refers to them any more.
+class RenderableStateList
+{
+public:
+	static constexpr size_t CHUNK_SIZE = 64;
+
+	class const_iterator
+	{
+	public:
+		using iterator_concept = std::random_access_iterator_tag;
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = RenderableState;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const RenderableState*;
+		using reference = const RenderableState&;
+
+		const_iterator() = default;
+
+		reference operator*() const { return (*list)[index]; }
+		pointer operator->() const { return &(*list)[index]; }
+		reference operator[](difference_type offset) const { return (*list)[index + offset]; }
+		const_iterator& operator++() { ++index; return *this; }
+		const_iterator operator++(int) { auto previous = *this; ++index; return previous; }
+		const_iterator& operator--() { --index; return *this; }
+		const_iterator operator--(int) { auto previous = *this; --index; return previous; }
+		const_iterator& operator+=(difference_type offset) { index += offset; return *this; }
+		const_iterator& operator-=(difference_type offset) { index -= offset; return *this; }
+		friend const_iterator operator+(const_iterator it, difference_type offset) { return it += offset; }
+		friend const_iterator operator+(difference_type offset, const_iterator it) { return it += offset; }
+		friend const_iterator operator-(const_iterator it, difference_type offset) { return it -= offset; }
+		friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs)
+		{
+			return lhs.index - rhs.index;
+		}
+		bool operator==(const const_iterator& other) const { return index == other.index; }
+		auto operator<=>(const const_iterator& other) const { return index <=> other.index; }
+
+	private:
+		friend class RenderableStateList;
+		const_iterator(const RenderableStateList* list, difference_type index) : list(list), index(index) {}
+
+		const RenderableStateList* list = nullptr;
+		difference_type index = 0;
+	};
+	using iterator = const_iterator;
+	using value_type = RenderableState;
+	using size_type = size_t;
+
+	RenderableStateList() = default;
+	RenderableStateList(std::initializer_list<RenderableState> states);
+	// Copies share the states but not the replaced chunks kept for reuse
+	RenderableStateList(const RenderableStateList& other);
+	RenderableStateList& operator=(const RenderableStateList& other);
+	RenderableStateList(RenderableStateList&&) noexcept = default;
+	RenderableStateList& operator=(RenderableStateList&&) noexcept = default;
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	const RenderableState& operator[](size_t index) const
+	{
+		return (*chunks[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+	}
+	const RenderableState& at(size_t index) const;
+	const_iterator begin() const { return { this, 0 }; }
+	const_iterator end() const { return { this, static_cast<std::ptrdiff_t>(count) }; }
+
+	void push_back(RenderableState state);
+	// Keeps the capacity of the chunk table but releases every chunk
+	void clear();
+	// Copies the containing chunk first if another list still shares it
+	RenderableState& edit(size_t index);
+	// Makes replaced chunks that no other list refers to any more available to
+	// later writes, instead of allocating new ones
+	void recycle_released_chunks();
+	// Whether both lists hold the same definitions in the same order. Chunks
+	// the lists share are not read.
+	bool has_same_definitions(const RenderableStateList& other) const;
+
+private:
+	using Chunk = std::vector<RenderableState>;
+
+	Chunk& writable_chunk(size_t chunk_index);
+	std::shared_ptr<Chunk> take_spare_chunk();
+
+	std::vector<std::shared_ptr<Chunk>> chunks;
+	size_t count = 0;
+	// Chunks replaced while other lists still shared them, and those of them
+	// found released, emptied and ready for reuse
+	std::vector<std::shared_ptr<Chunk>> retired_chunks;
+	std::vector<std::shared_ptr<Chunk>> spare_chunks;
 };
 
 // Bind-pose topology is definition data; animated local transforms live in
@@ -98,15 +202,20 @@ struct RenderSkeletonDefinition
 {
 	SkeletonID id;
 	std::vector<RenderBoneDefinition> bones;
+	// Indices into bones with every parent before its children, see
+	// make_parent_first_order
+	std::vector<uint32_t> parent_first_order;
 };
 
 using RenderSkeletonDefinitionPtr = std::shared_ptr<const RenderSkeletonDefinition>;
 
-// local_transforms has the same order and size as definition->bones.
+// local_transforms and bones have the same order and size as definition->bones.
 struct RenderSkeletonPose
 {
 	RenderSkeletonDefinitionPtr definition;
 	std::vector<glm::mat4> local_transforms;
+	// Skinning matrices composed from local_transforms, ready to upload
+	std::vector<SDS::Bone> bones;
 };
 
 struct RenderCameraState
@@ -140,7 +249,7 @@ struct RenderFrame
 	uint64_t frame_number = 0;
 	RenderViewState view;
 	RenderCameraState camera;
-	std::vector<RenderableState> renderables;
+	RenderableStateList renderables;
 	std::vector<RenderSkeletonPose> skeletons;
 	std::vector<SDS::ParticleInstanceData> particles;
 	std::optional<RenderLightState> active_light;
@@ -148,6 +257,31 @@ struct RenderFrame
 
 using RenderFramePtr = std::shared_ptr<const RenderFrame>;
 
+// Hands out frames for the producer to fill, reusing frames every consumer
+// has released so their containers keep their capacity. Only the producer
+// thread may use a pool.
+class RenderFramePool
+{
+public:
+	RenderFramePool() = default;
+	RenderFramePool(const RenderFramePool&) = delete;
+	RenderFramePool& operator=(const RenderFramePool&) = delete;
+
+	// Returns a frame nothing else refers to. Its contents are left over from
+	// an earlier use, so the caller must assign every field.
+	std::shared_ptr<RenderFrame> acquire();
+	// Number of frames allocated so far, both in use and released
+	size_t size() const { return frames.size(); }
+
+private:
+	std::vector<std::shared_ptr<RenderFrame>> frames;
+};
+
+// Orders the indices of a hierarchy so that each parent precedes its children,
+// letting transforms be composed in one pass. Throws std::invalid_argument for
+// invalid parents or cycles.
+std::vector<uint32_t> make_parent_first_order(std::span<const uint32_t> parent_indices);
+
 // Composes parent-before-child model transforms regardless of input ordering.
 // Throws std::invalid_argument for mismatched counts, invalid parents, or cycles.
 std::vector<glm::mat4> compose_transform_hierarchy(
@@ -155,9 +289,15 @@ std::vector<glm::mat4> compose_transform_hierarchy(
 	std::span<const uint32_t> parent_indices);
 
 // Produces shader-ready bone transforms: composed pose * inverse bind pose.
+// Derives the composition order from the bones' parents.
 std::vector<SDS::Bone> compose_bone_transforms(
 	std::span<const glm::mat4> local_transforms,
 	const RenderSkeletonDefinition& definition);
+// As above, into out and in definition.parent_first_order, without allocating
+void compose_bone_transforms(
+	std::span<const glm::mat4> local_transforms,
+	const RenderSkeletonDefinition& definition,
+	std::span<SDS::Bone> out);
 
 // previous is empty for the first publication, then refers to the frame that
 // was current immediately before the latest publication.
@@ -188,7 +328,11 @@ public:
 	CompletedRenderFramesPtr load_latest() const;
 
 private:
+	std::shared_ptr<CompletedRenderFrames> acquire_publication();
+
 	std::atomic<CompletedRenderFramesPtr> latest;
+	// Publication objects, reused once no consumer retains them
+	std::vector<std::shared_ptr<CompletedRenderFrames>> publications;
 	std::unordered_map<RenderableID, const RenderableDefinition*>
 		active_renderable_definitions;
 	std::unordered_map<SkeletonID, const RenderSkeletonDefinition*>
@@ -0,0 +1,273 @@
+#include "render_frame_builder.hpp"
+
+#include "entity_component_system/ecs.hpp"
+#include "task_pool.hpp"
+
+#include <glm/vector_relational.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_set>
+
+
+namespace
+{
+bool matrices_equal(const glm::mat4& lhs, const glm::mat4& rhs)
+{
+	for (glm::length_t column = 0; column < 4; ++column)
+		if (!glm::all(glm::equal(lhs[column], rhs[column])))
+			return false;
+	return true;
+}
+
+bool renderable_matches(
+	const RenderableDefinition& definition,
+	const RenderableID id,
+	const RenderableAttachment& attachment)
+{
+	const auto& renderable = attachment.renderable;
+	return definition.pipeline_render_type == renderable.pipeline_render_type
+		&& definition.shading_mode == renderable.shading_mode
+		&& definition.opacity == renderable.opacity
+		&& definition.casts_shadow == renderable.casts_shadow
+		&& definition.render_on_top == renderable.render_on_top
+		&& definition.id == id
+		&& definition.object_id == attachment.object_id
+		&& definition.skeleton_id == attachment.skeleton_id
+		&& definition.mesh_owner == renderable.mesh_owner
+		&& definition.material_owners == renderable.material_owners
+		&& definition.environment_lighting_asset == renderable.environment_lighting_asset;
+}
+
+std::optional<AABB> get_local_bounds(const Renderable& renderable)
+{
+	if (is_skinned_render_type(renderable.pipeline_render_type)
+		|| renderable.pipeline_render_type == ERenderType::CUBEMAP)
+		return std::nullopt;
+	return renderable.mesh_owner->get().get_local_bounds();
+}
+
+std::optional<AABB> get_world_bounds(
+	const RenderableDefinition& definition,
+	const glm::mat4& model_transform)
+{
+	if (!definition.local_bounds)
+		return std::nullopt;
+	return definition.local_bounds->transformed(model_transform);
+}
+
+RenderableDefinition make_renderable_definition(
+	const RenderableID id,
+	const RenderableAttachment& attachment)
+{
+	const auto& renderable = attachment.renderable;
+	return {
+		.pipeline_render_type = renderable.pipeline_render_type,
+		.shading_mode = renderable.shading_mode,
+		.opacity = renderable.opacity,
+		.casts_shadow = renderable.casts_shadow,
+		.render_on_top = renderable.render_on_top,
+		.id = id,
+		.object_id = attachment.object_id,
+		.skeleton_id = attachment.skeleton_id,
+		.mesh_owner = renderable.mesh_owner,
+		.material_owners = renderable.material_owners,
+		.environment_lighting_asset = renderable.environment_lighting_asset,
+		.local_bounds = get_local_bounds(renderable),
+	};
+}
+
+bool skeleton_definition_matches(
+	const RenderSkeletonDefinition& definition,
+	const SkeletalComponent& component)
+{
+	const auto& bones = component.get_bones();
+	if (definition.bones.size() != bones.size())
+		return false;
+
+	for (size_t index = 0; index < definition.bones.size(); ++index)
+		if (definition.bones[index].parent_index != bones[index].parent_node
+			|| !matrices_equal(
+				definition.bones[index].inverse_bind_pose,
+				bones[index].inverse_bind_pose.get_mat4()))
+			return false;
+	return true;
+}
+}
+
+
+RenderableDefinitionPtr RenderFrameBuilder::get_renderable_definition(
+	const RenderableID id,
+	const RenderableAttachment& attachment)
+{
+	const auto cached = renderable_definitions.find(id);
+	if (cached != renderable_definitions.end())
+	{
+		if (!renderable_matches(*cached->second, id, attachment))
+			throw std::logic_error(
+				"RenderFrameBuilder: renderable topology changed without replacing its ID");
+		return cached->second;
+	}
+
+	auto definition = std::make_shared<const RenderableDefinition>(
+		make_renderable_definition(id, attachment));
+	renderable_definitions.insert_or_assign(id, definition);
+	return definition;
+}
+
+RenderSkeletonDefinitionPtr RenderFrameBuilder::get_render_skeleton_definition(
+	const SkeletonID id,
+	const SkeletalComponent& component)
+{
+	// cached definitions are checked against the skeleton as its pose is composed
+	if (const auto cached = render_skeleton_definitions.find(id); cached != render_skeleton_definitions.end())
+		return cached->second;
+
+	const auto& bones = component.get_bones();
+	std::vector<RenderBoneDefinition> bone_definitions;
+	bone_definitions.reserve(bones.size());
+	for (const auto& bone : bones)
+		bone_definitions.push_back({
+			.parent_index = bone.parent_node,
+			.inverse_bind_pose = bone.inverse_bind_pose.get_mat4(),
+		});
+
+	auto definition = std::make_shared<const RenderSkeletonDefinition>(RenderSkeletonDefinition{
+		.id = id,
+		.bones = std::move(bone_definitions),
+		.parent_first_order = component.get_parent_first_order(),
+	});
+	render_skeleton_definitions.insert_or_assign(id, definition);
+	return definition;
+}
+
+TaskPool& RenderFrameBuilder::get_task_pool() const
+{
+	return task_pool ? *task_pool : TaskPool::get_shared();
+}
+
+void RenderFrameBuilder::build(ECS& ecs, RenderFrame& frame)
+{
+	states.recycle_released_chunks();
+	ecs.collect_renderable_changes(changes);
+	const uint64_t visibility_generation = Object::get_visibility_generation();
+	if (changes.full_refresh)
+		rebuild(ecs);
+	else if (visibility_generation != object_visibility_generation)
+	{
+		// visibility is not reported per object, so re-read every grouped renderable
+		for (const auto& [_, first] : first_object_states)
+			for (uint32_t index = first; index != NO_STATE; index = next_object_states[index])
+				refresh(ecs, index);
+		for (const RenderableID id : changes.renderables)
+			refresh(ecs, state_indices.at(id));
+	}
+	else
+	{
+		for (const RenderableID id : changes.renderables)
+			refresh(ecs, state_indices.at(id));
+		for (const EntityID id : changes.entities)
+			if (const auto first = first_object_states.find(id); first != first_object_states.end())
+				for (uint32_t index = first->second; index != NO_STATE; index = next_object_states[index])
+					refresh(ecs, index);
+	}
+	object_visibility_generation = visibility_generation;
+
+	frame.renderables = states;
+	// assigned in place so a recycled frame keeps its pose buffers
+	frame.skeletons.resize(attached_skeletons.size());
+	for (size_t index = 0; index < attached_skeletons.size(); ++index)
+	{
+		const SkeletonID id = attached_skeletons[index];
+		frame.skeletons[index].definition = get_render_skeleton_definition(id, ecs.get_skeletal_component(id));
+	}
+	// each range reads only its own skeletons and writes only their poses
+	const ECS& skeletons = ecs;
+	get_task_pool().parallel_for(attached_skeletons.size(), MIN_SKELETONS_PER_TASK,
+		[&skeletons, &frame, this](const size_t first, const size_t last)
+		{
+			for (size_t index = first; index < last; ++index)
+			{
+				const auto& component = skeletons.get_skeletal_component(attached_skeletons[index]);
+				auto& pose = frame.skeletons[index];
+				if (!skeleton_definition_matches(*pose.definition, component))
+					throw std::logic_error(
+						"RenderFrameBuilder: skeleton topology changed without replacing its ID");
+				const auto& bones = component.get_bones();
+				pose.local_transforms.resize(bones.size());
+				for (size_t bone = 0; bone < bones.size(); ++bone)
+					pose.local_transforms[bone] = bones[bone].relative_transform.get_mat4();
+				pose.bones.resize(bones.size());
+				compose_bone_transforms(pose.local_transforms, *pose.definition, pose.bones);
+			}
+		});
+}
+
+void RenderFrameBuilder::rebuild(const ECS& ecs)
+{
+	const auto renderable_ids = ecs.get_renderable_ids();
+	states.clear();
+	state_indices.clear();
+	state_indices.reserve(renderable_ids.size());
+	first_object_states.clear();
+	next_object_states.assign(renderable_ids.size(), NO_STATE);
+	attached_skeletons.clear();
+	for (uint32_t index = 0; index < renderable_ids.size(); ++index)
+	{
+		const RenderableID id = renderable_ids[index];
+		const auto& attachment = ecs.get_renderable(id);
+		if (attachment.skeleton_id)
+			attached_skeletons.push_back(*attachment.skeleton_id);
+		if (attachment.object_id)
+		{
+			// prepend, keeping each object's list in descending index order
+			const auto [first, inserted] = first_object_states.try_emplace(*attachment.object_id, index);
+			if (!inserted)
+			{
+				next_object_states[index] = first->second;
+				first->second = index;
+			}
+		}
+		state_indices.emplace(id, index);
+		auto definition = get_renderable_definition(id, attachment);
+		const glm::mat4 model_transform = ecs.get_renderable_transform(id);
+		auto world_bounds = get_world_bounds(*definition, model_transform);
+		states.push_back({
+			.definition = std::move(definition),
+			.model_transform = model_transform,
+			.visible = ecs.get_renderable_visibility(id),
+			.world_bounds = std::move(world_bounds),
+		});
+	}
+
+	std::ranges::sort(attached_skeletons);
+	const auto unique_skeletons = std::ranges::unique(attached_skeletons);
+	attached_skeletons.erase(unique_skeletons.begin(), attached_skeletons.end());
+
+	std::erase_if(renderable_definitions, [&ecs](const auto& entry) {
+		return !ecs.has_renderable(entry.first);
+	});
+	const auto live_skeleton_ids = ecs.get_skeleton_ids();
+	const std::unordered_set<SkeletonID> live_skeletons(
+		live_skeleton_ids.begin(), live_skeleton_ids.end());
+	std::erase_if(render_skeleton_definitions, [&live_skeletons](const auto& entry) {
+		return !live_skeletons.contains(entry.first);
+	});
+}
+
+void RenderFrameBuilder::refresh(const ECS& ecs, const uint32_t index)
+{
+	const RenderableID id = states[index].definition->id;
+	const glm::mat4 model_transform = ecs.get_renderable_transform(id);
+	const bool visible = ecs.get_renderable_visibility(id);
+	// leave chunks shared with published frames untouched where possible
+	if (states[index].visible == visible && matrices_equal(states[index].model_transform, model_transform))
+		return;
+	auto& state = states.edit(index);
+	if (!matrices_equal(state.model_transform, model_transform))
+		state.world_bounds = get_world_bounds(*state.definition, model_transform);
+	state.model_transform = model_transform;
+	state.visible = visible;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "render_frame.hpp"
+#include "entity_component_system/renderable_system.hpp"
+#include "entity_component_system/skeletal.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+
+class ECS;
+class TaskPool;
+
+// Mirrors the ECS renderables and skeletons into render frame form. After the
+// first build only renderables reported as changed are recomputed, and each
+// frame shares the unchanged chunks of renderable state with the previous one.
+class RenderFrameBuilder
+{
+public:
+	RenderFrameBuilder() = default;
+	RenderFrameBuilder(const RenderFrameBuilder&) = delete;
+	RenderFrameBuilder& operator=(const RenderFrameBuilder&) = delete;
+
+	// Fills frame.renderables and frame.skeletons, overwriting their previous
+	// contents in place so a pooled frame does not reallocate them. Skeleton
+	// poses and skinning matrices are composed in parallel. World transforms
+	// should be up to date, see TransformationSystem::update_world_transforms.
+	void build(ECS& ecs, RenderFrame& frame);
+
+	// TaskPool::get_shared() unless set
+	void set_task_pool(TaskPool& pool) { task_pool = &pool; }
+
+private:
+	static constexpr uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+	static constexpr size_t MIN_SKELETONS_PER_TASK = 16;
+
+	void rebuild(const ECS& ecs);
+	void refresh(const ECS& ecs, uint32_t index);
+	RenderableDefinitionPtr get_renderable_definition(
+		RenderableID id, const RenderableAttachment& attachment);
+	RenderSkeletonDefinitionPtr get_render_skeleton_definition(
+		SkeletonID id, const SkeletalComponent& component);
+	TaskPool& get_task_pool() const;
+
+	RenderableStateList states;
+	RenderableChanges changes;
+	std::unordered_map<RenderableID, uint32_t> state_indices;
+	// States of the renderables grouped under each object, as intrusive lists
+	std::unordered_map<EntityID, uint32_t> first_object_states;
+	std::vector<uint32_t> next_object_states;
+	std::vector<SkeletonID> attached_skeletons;
+	TaskPool* task_pool = nullptr;
+	uint64_t object_visibility_generation = 0;
+
+	std::unordered_map<RenderableID, RenderableDefinitionPtr> renderable_definitions;
+	std::unordered_map<SkeletonID, RenderSkeletonDefinitionPtr> render_skeleton_definitions;
+};
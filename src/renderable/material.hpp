@@ -178,6 +178,10 @@ enum class ETextureFormat
 {
 	RGBA8,
 	BC3,
+	BC1,
+	// two channel, for normal maps whose z is reconstructed when sampled
+	BC5,
+	BC7,
 };
 
 struct SampledMaterial : public Material
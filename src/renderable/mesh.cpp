@@ -0,0 +1,87 @@
+#include "mesh.hpp"
+#include "task_pool.hpp"
+
+
+const MeshPickData& Mesh::get_pick_data() const
+{
+	std::unique_lock lock(pick_data_cache->mutex);
+	while (!pick_data_cache->data)
+	{
+		// Published before building, so that other callers wait on it and
+		// the build runs without the lock
+		if (!pick_data_cache->pending)
+			pick_data_cache->pending = make_pick_data_build();
+		const auto build = pick_data_cache->pending;
+		lock.unlock();
+		// builds here unless a prefetch task already started, and then only
+		// waits for that task rather than running other queued work
+		build->run();
+		build->result.wait();
+		lock.lock();
+		// set_indices may have replaced the pending build while unlocked
+		if (!pick_data_cache->data && pick_data_cache->pending == build)
+		{
+			pick_data_cache->pending.reset();
+			// a failed build is not cached, so the next call tries again
+			pick_data_cache->data = build->result.get();
+		}
+	}
+	return *pick_data_cache->data;
+}
+
+void Mesh::prefetch_pick_data() const
+{
+	std::lock_guard lock(pick_data_cache->mutex);
+	if (pick_data_cache->data || pick_data_cache->pending)
+		return;
+	// The build owns copies so the mesh may be moved or destroyed meanwhile
+	pick_data_cache->pending = make_pick_data_build();
+	TaskPool::get_shared().submit([build = pick_data_cache->pending]() { build->run(); });
+}
+
+bool Mesh::is_pick_data_ready() const
+{
+	std::lock_guard lock(pick_data_cache->mutex);
+	return pick_data_cache->data
+		|| (pick_data_cache->pending
+			&& pick_data_cache->pending->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+}
+
+std::shared_ptr<Mesh::PickDataBuild> Mesh::make_pick_data_build() const
+{
+	auto build = std::make_shared<PickDataBuild>();
+	build->positions = get_pick_positions();
+	build->indices = indices;
+	return build;
+}
+
+void Mesh::PickDataBuild::run()
+{
+	if (claimed.test_and_set())
+		return;
+	try
+	{
+		// Large meshes still use the pool to split their build
+		promise.set_value(std::make_shared<const MeshPickData>(
+			std::move(positions), indices, &TaskPool::get_shared()));
+	}
+	catch (...)
+	{
+		promise.set_exception(std::current_exception());
+	}
+}
+
+void Mesh::restore_pick_data(std::vector<MeshPickTriangle> triangles, std::vector<MeshBvhNode> nodes)
+{
+	auto data = std::make_shared<const MeshPickData>(get_pick_positions(), std::move(triangles), std::move(nodes));
+	std::lock_guard lock(pick_data_cache->mutex);
+	pick_data_cache->data = std::move(data);
+	pick_data_cache->pending.reset();
+}
+
+void Mesh::reset_pick_data()
+{
+	std::lock_guard lock(pick_data_cache->mutex);
+	pick_data_cache->data.reset();
+	pick_data_cache->pending.reset();
+}
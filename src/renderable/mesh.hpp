@@ -7,15 +7,21 @@
 #include <glm/glm.hpp>
 
 #include <vector>
+#include <atomic>
 #include <memory>
 #include <algorithm>
 #include <cmath>
 #include <ranges>
+#include <future>
+#include <mutex>
+#include <optional>
 
 
 struct Mesh 
 {
 public:
+	Mesh() = default;
+	Mesh(Mesh&& mesh) noexcept = default;
 	virtual ~Mesh() = default;
 	MeshID get_id() const { return id; }
 
@@ -23,7 +29,7 @@ public:
 	void set_indices(std::vector<uint32_t>&& indices)
 	{
 		this->indices = std::move(indices);
-		pick_data = MeshPickData(pick_data.get_positions(), this->indices);
+		reset_pick_data();
 	}
 
 	virtual uint32_t get_num_unique_vertices() const = 0;
@@ -33,24 +39,55 @@ public:
 	const std::byte* get_indices_data() const { return reinterpret_cast<const std::byte*>(indices.data()); }
 	virtual size_t get_vertices_data_size() const = 0;
 	size_t get_indices_data_size() const { return indices.size() * sizeof(uint32_t); }
-	const MeshPickData& get_pick_data() const { return pick_data; }
+
+	// Bounds of all vertices, computed with them; std::nullopt without vertices.
+	// Cheap, unlike the bounds of get_pick_data(), which builds its BVH.
+	const std::optional<AABB>& get_local_bounds() const { return local_bounds; }
+
+	// Pick data is built on first use, on the calling thread, unless a prefetch
+	// task has already started it, in which case this waits for that task.
+	// Safe to call from several threads.
+	const MeshPickData& get_pick_data() const;
+	// Starts building pick data on the shared task pool, e.g. right after loading
+	// meshes that are likely to be picked. Does nothing if it already exists.
+	void prefetch_pick_data() const;
+	bool is_pick_data_ready() const;
+	// Adopts a BVH built earlier over this mesh's current vertices and indices.
+	// Throws std::invalid_argument if it does not fit the vertices.
+	void restore_pick_data(std::vector<MeshPickTriangle> triangles, std::vector<MeshBvhNode> nodes);
 
 protected:
 	std::vector<uint32_t> indices;
+	std::optional<AABB> local_bounds;
+
+	virtual std::vector<glm::vec3> get_pick_positions() const = 0;
+	void reset_pick_data();
 
-	template<typename VertexType>
-	void set_pick_vertices(const std::vector<VertexType>& vertices)
+private:
+	// Run by a prefetch task or by a caller waiting for it, whichever claims
+	// it first, so waiting callers never run unrelated queued tasks
+	struct PickDataBuild
 	{
+		std::atomic_flag claimed;
 		std::vector<glm::vec3> positions;
-		positions.reserve(vertices.size());
-		for (const auto& vertex : vertices)
-			positions.push_back(vertex.pos);
-		pick_data = MeshPickData(std::move(positions), indices);
-	}
+		std::vector<uint32_t> indices;
+		std::promise<std::shared_ptr<const MeshPickData>> promise;
+		std::shared_future<std::shared_ptr<const MeshPickData>> result = promise.get_future().share();
+
+		void run();
+	};
+	struct PickDataCache
+	{
+		std::mutex mutex;
+		std::shared_ptr<const MeshPickData> data;
+		std::shared_ptr<PickDataBuild> pending;
+	};
+
+	// Snapshots the current vertices and indices; call with the cache locked
+	std::shared_ptr<PickDataBuild> make_pick_data_build() const;
 
-private:
 	const MeshID id = MeshID::generate_new_id();
-	MeshPickData pick_data;
+	std::unique_ptr<PickDataCache> pick_data_cache = std::make_unique<PickDataCache>();
 };
 
 template<typename VertexType_>
@@ -64,13 +101,13 @@ public:
 		vertices(vertices)
 	{
 		this->indices = indices;
-		this->set_pick_vertices(this->vertices);
+		compute_local_bounds();
 	}
 	DerivedMesh(std::vector<VertexType_>&& vertices, std::vector<uint32_t>&& indices) : 
 		vertices(std::move(vertices))
 	{
 		this->indices = std::move(indices);
-		this->set_pick_vertices(this->vertices);
+		compute_local_bounds();
 	}
 	DerivedMesh(const DerivedMesh& mesh) = delete;
 	DerivedMesh& operator=(const DerivedMesh& mesh) = default;
@@ -81,7 +118,30 @@ public:
 	virtual const std::byte* get_vertices_data() const override { return reinterpret_cast<const std::byte*>(vertices.data()); }
 	virtual size_t get_vertices_data_size() const override { return vertices.size() * sizeof(VertexType_); }
 
+protected:
+	virtual std::vector<glm::vec3> get_pick_positions() const override
+	{
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertices.size());
+		for (const auto& vertex : vertices)
+			positions.push_back(vertex.pos);
+		return positions;
+	}
+
 private:
+	void compute_local_bounds()
+	{
+		if (vertices.empty())
+			return;
+		AABB bounds(vertices.front().pos, vertices.front().pos);
+		for (const auto& vertex : vertices)
+		{
+			bounds.min_bound = glm::min(bounds.min_bound, vertex.pos);
+			bounds.max_bound = glm::max(bounds.max_bound, vertex.pos);
+		}
+		local_bounds = bounds;
+	}
+
 	std::vector<VertexType_> vertices;
 };
 
@@ -0,0 +1,966 @@
+#include "texture_processor.hpp"
+#include "task_pool.hpp"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace
+{
+constexpr float PI = 3.14159265358979323846f;
+constexpr uint32_t CHANNEL_COUNT = 4;
+constexpr uint32_t BLOCK_DIMENSION = 4;
+constexpr uint32_t BLOCK_PIXEL_COUNT = BLOCK_DIMENSION * BLOCK_DIMENSION;
+constexpr size_t MIN_ROWS_PER_TASK = 8;
+constexpr size_t MIN_BLOCK_ROWS_PER_TASK = 2;
+// Kaiser filter half width in destination texels, and window shape
+constexpr float KAISER_RADIUS = 3.0f;
+constexpr float KAISER_BETA = 4.0f;
+// Endpoint fits refined by least squares after the initial principal axis fit
+constexpr int ENDPOINT_REFINEMENTS = 2;
+constexpr std::array<uint32_t, 16> BC7_WEIGHTS = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+constexpr uint32_t BC7_MODE_6 = 1u << 6;
+
+const std::array<float, 256> SRGB_TO_LINEAR = []
+{
+	std::array<float, 256> values;
+	for (size_t index = 0; index < values.size(); ++index)
+	{
+		const float value = static_cast<float>(index) / 255.0f;
+		values[index] = value <= 0.04045f
+			? value / 12.92f
+			: std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+	return values;
+}();
+
+// Linear values quantized finely enough that every sRGB value round trips
+constexpr size_t LINEAR_TO_SRGB_STEPS = 16384;
+const std::vector<uint8_t> LINEAR_TO_SRGB = []
+{
+	std::vector<uint8_t> values(LINEAR_TO_SRGB_STEPS);
+	for (size_t index = 0; index < values.size(); ++index)
+	{
+		const float value = static_cast<float>(index) / (LINEAR_TO_SRGB_STEPS - 1);
+		const float encoded = value <= 0.0031308f
+			? value * 12.92f
+			: 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		values[index] = static_cast<uint8_t>(std::lround(std::clamp(encoded, 0.0f, 1.0f) * 255.0f));
+	}
+	return values;
+}();
+
+using Color = std::array<float, CHANNEL_COUNT>;
+
+std::byte quantize(const float value)
+{
+	return static_cast<std::byte>(static_cast<uint8_t>(
+		std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f)));
+}
+
+size_t get_block_size(const ETextureFormat format)
+{
+	return format == ETextureFormat::BC1 ? 8 : 16;
+}
+
+void validate_level(const std::span<const std::byte> pixels, const uint32_t width, const uint32_t height)
+{
+	if (width == 0 || height == 0 || pixels.size() != static_cast<size_t>(width) * height * CHANNEL_COUNT)
+		throw std::invalid_argument("TextureProcessor: level size does not match its dimensions");
+}
+
+// Mip generation
+
+// RGBA8 pixels as floats that filter linearly: linear colour for sRGB
+// semantics, vectors in [-1, 1] for normals
+std::vector<float> decode_level(const std::span<const std::byte> pixels, const ETextureSemantic semantic)
+{
+	const bool srgb = TextureProcessor::is_srgb(semantic);
+	const bool normal = semantic == ETextureSemantic::NORMAL;
+	std::vector<float> values(pixels.size());
+	for (size_t index = 0; index < pixels.size(); ++index)
+	{
+		const uint8_t value = std::to_integer<uint8_t>(pixels[index]);
+		const bool alpha = index % CHANNEL_COUNT == CHANNEL_COUNT - 1;
+		if (srgb && !alpha)
+			values[index] = SRGB_TO_LINEAR[value];
+		else if (normal && !alpha)
+			values[index] = static_cast<float>(value) / 255.0f * 2.0f - 1.0f;
+		else
+			values[index] = static_cast<float>(value) / 255.0f;
+	}
+	return values;
+}
+
+// Clamps the ringing of sharp filters, and renormalizes normals so the next
+// level is filtered from unit vectors
+void finish_level(std::vector<float>& values, const ETextureSemantic semantic)
+{
+	for (size_t pixel = 0; pixel < values.size(); pixel += CHANNEL_COUNT)
+	{
+		float* value = values.data() + pixel;
+		if (semantic == ETextureSemantic::NORMAL)
+		{
+			const float length = std::sqrt(value[0] * value[0] + value[1] * value[1] + value[2] * value[2]);
+			if (length > 1e-6f)
+			{
+				for (uint32_t channel = 0; channel < 3; ++channel)
+					value[channel] /= length;
+			}
+			else
+			{
+				value[0] = 0.0f;
+				value[1] = 0.0f;
+				value[2] = 1.0f;
+			}
+		}
+		else
+		{
+			for (uint32_t channel = 0; channel < 3; ++channel)
+				value[channel] = std::clamp(value[channel], 0.0f, 1.0f);
+		}
+		value[3] = std::clamp(value[3], 0.0f, 1.0f);
+	}
+}
+
+void encode_level(const std::vector<float>& values, const ETextureSemantic semantic, std::byte* pixels)
+{
+	const bool srgb = TextureProcessor::is_srgb(semantic);
+	const bool normal = semantic == ETextureSemantic::NORMAL;
+	for (size_t index = 0; index < values.size(); ++index)
+	{
+		const bool alpha = index % CHANNEL_COUNT == CHANNEL_COUNT - 1;
+		if (srgb && !alpha)
+			pixels[index] = static_cast<std::byte>(LINEAR_TO_SRGB[static_cast<size_t>(
+				std::lround(std::clamp(values[index], 0.0f, 1.0f) * (LINEAR_TO_SRGB_STEPS - 1)))]);
+		else if (normal && !alpha)
+			pixels[index] = quantize(values[index] * 0.5f + 0.5f);
+		else
+			pixels[index] = quantize(values[index]);
+	}
+}
+
+float bessel_i0(const float value)
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	const float half = value * 0.5f;
+	for (int k = 1; k < 32 && term > sum * 1e-7f; ++k)
+	{
+		term *= (half / static_cast<float>(k)) * (half / static_cast<float>(k));
+		sum += term;
+	}
+	return sum;
+}
+
+// offset in destination texels
+float kaiser_weight(const float offset)
+{
+	if (std::abs(offset) >= KAISER_RADIUS)
+		return 0.0f;
+	const float sinc = offset == 0.0f ? 1.0f : std::sin(PI * offset) / (PI * offset);
+	const float window = offset / KAISER_RADIUS;
+	return sinc * bessel_i0(KAISER_BETA * std::sqrt(1.0f - window * window)) / bessel_i0(KAISER_BETA);
+}
+
+// The same number of weighted source texels for every destination texel along
+// one axis, with indices clamped to the edge
+struct AxisTaps
+{
+	uint32_t tap_count = 0;
+	std::vector<uint32_t> indices;
+	std::vector<float> weights;
+};
+
+AxisTaps make_axis_taps(const uint32_t source_size, const uint32_t target_size,
+	const TextureProcessor::EMipFilter filter)
+{
+	const float scale = static_cast<float>(source_size) / static_cast<float>(target_size);
+	const bool box = filter == TextureProcessor::EMipFilter::BOX;
+	const float support = (box ? 0.5f : KAISER_RADIUS) * scale;
+
+	AxisTaps taps;
+	taps.tap_count = static_cast<uint32_t>(std::ceil(support * 2.0f)) + 1;
+	taps.indices.reserve(static_cast<size_t>(target_size) * taps.tap_count);
+	taps.weights.reserve(static_cast<size_t>(target_size) * taps.tap_count);
+	for (uint32_t target = 0; target < target_size; ++target)
+	{
+		const float centre = (static_cast<float>(target) + 0.5f) * scale;
+		const int first = static_cast<int>(std::floor(centre - support));
+		const size_t begin = taps.weights.size();
+		float total = 0.0f;
+		for (uint32_t tap = 0; tap < taps.tap_count; ++tap)
+		{
+			const int source = first + static_cast<int>(tap);
+			const float weight = box
+				? std::max(0.0f, std::min(static_cast<float>(source + 1), centre + support)
+					- std::max(static_cast<float>(source), centre - support))
+				: kaiser_weight((static_cast<float>(source) + 0.5f - centre) / scale);
+			taps.indices.push_back(static_cast<uint32_t>(std::clamp(source, 0, static_cast<int>(source_size) - 1)));
+			taps.weights.push_back(weight);
+			total += weight;
+		}
+		for (size_t tap = begin; tap < taps.weights.size(); ++tap)
+			taps.weights[tap] /= total;
+	}
+	return taps;
+}
+
+// Separable resampling: rows into scratch, then columns of scratch rows
+void resample(const std::vector<float>& source, const uint32_t source_width, const uint32_t source_height,
+	std::vector<float>& target, const uint32_t target_width, const uint32_t target_height,
+	const TextureProcessor::EMipFilter filter, std::vector<float>& scratch, TaskPool& pool)
+{
+	const AxisTaps columns = make_axis_taps(source_width, target_width, filter);
+	const AxisTaps rows = make_axis_taps(source_height, target_height, filter);
+
+	scratch.resize(static_cast<size_t>(target_width) * source_height * CHANNEL_COUNT);
+	pool.parallel_for(source_height, MIN_ROWS_PER_TASK, [&](const size_t first, const size_t last)
+	{
+		for (size_t row = first; row < last; ++row)
+		{
+			const float* in = source.data() + row * source_width * CHANNEL_COUNT;
+			float* out = scratch.data() + row * target_width * CHANNEL_COUNT;
+			for (uint32_t column = 0; column < target_width; ++column)
+			{
+				const uint32_t* indices = columns.indices.data() + static_cast<size_t>(column) * columns.tap_count;
+				const float* weights = columns.weights.data() + static_cast<size_t>(column) * columns.tap_count;
+				__m128 sum = _mm_setzero_ps();
+				for (uint32_t tap = 0; tap < columns.tap_count; ++tap)
+					sum = _mm_fmadd_ps(_mm_loadu_ps(in + indices[tap] * CHANNEL_COUNT), _mm_set1_ps(weights[tap]), sum);
+				_mm_storeu_ps(out + column * CHANNEL_COUNT, sum);
+			}
+		}
+	});
+
+	const size_t row_length = static_cast<size_t>(target_width) * CHANNEL_COUNT;
+	target.resize(row_length * target_height);
+	pool.parallel_for(target_height, MIN_ROWS_PER_TASK, [&](const size_t first, const size_t last)
+	{
+		for (size_t row = first; row < last; ++row)
+		{
+			float* out = target.data() + row * row_length;
+			std::fill(out, out + row_length, 0.0f);
+			for (uint32_t tap = 0; tap < rows.tap_count; ++tap)
+			{
+				const size_t tap_index = row * rows.tap_count + tap;
+				const float* in = scratch.data() + rows.indices[tap_index] * row_length;
+				const float weight = rows.weights[tap_index];
+				const __m256 weights = _mm256_set1_ps(weight);
+				size_t index = 0;
+				for (; index + 8 <= row_length; index += 8)
+					_mm256_storeu_ps(out + index,
+						_mm256_fmadd_ps(_mm256_loadu_ps(in + index), weights, _mm256_loadu_ps(out + index)));
+				for (; index < row_length; ++index)
+					out[index] += in[index] * weight;
+			}
+		}
+	});
+}
+
+// Block encoding
+
+// A 4x4 block, channel by channel so eight pixels load at once
+struct Block
+{
+	alignas(32) std::array<std::array<float, BLOCK_PIXEL_COUNT>, CHANNEL_COUNT> channels;
+};
+
+using BlockIndices = std::array<uint8_t, BLOCK_PIXEL_COUNT>;
+
+void load_block(const std::span<const std::byte> pixels, const uint32_t width, const uint32_t height,
+	const uint32_t block_x, const uint32_t block_y, Block& block)
+{
+	for (uint32_t y = 0; y < BLOCK_DIMENSION; ++y)
+	{
+		const uint32_t source_y = std::min(block_y * BLOCK_DIMENSION + y, height - 1);
+		for (uint32_t x = 0; x < BLOCK_DIMENSION; ++x)
+		{
+			const uint32_t source_x = std::min(block_x * BLOCK_DIMENSION + x, width - 1);
+			const std::byte* pixel = pixels.data() + (static_cast<size_t>(source_y) * width + source_x) * CHANNEL_COUNT;
+			for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+				block.channels[channel][y * BLOCK_DIMENSION + x] = static_cast<float>(std::to_integer<uint8_t>(pixel[channel]));
+		}
+	}
+}
+
+// Assigns every pixel its nearest palette entry over channels
+// [first_channel, first_channel + channel_count), returning the summed
+// squared error
+float fit_indices(const Block& block, const uint32_t first_channel, const uint32_t channel_count,
+	const std::span<const Color> palette, BlockIndices& indices)
+{
+	__m256 best_errors[2] = { _mm256_set1_ps(std::numeric_limits<float>::max()),
+		_mm256_set1_ps(std::numeric_limits<float>::max()) };
+	__m256 best_entries[2] = { _mm256_setzero_ps(), _mm256_setzero_ps() };
+	for (size_t entry = 0; entry < palette.size(); ++entry)
+	{
+		const __m256 entry_index = _mm256_set1_ps(static_cast<float>(entry));
+		for (size_t half = 0; half < 2; ++half)
+		{
+			__m256 error = _mm256_setzero_ps();
+			for (uint32_t channel = first_channel; channel < first_channel + channel_count; ++channel)
+			{
+				const __m256 difference = _mm256_sub_ps(
+					_mm256_load_ps(block.channels[channel].data() + half * 8), _mm256_set1_ps(palette[entry][channel]));
+				error = _mm256_fmadd_ps(difference, difference, error);
+			}
+			const __m256 closer = _mm256_cmp_ps(error, best_errors[half], _CMP_LT_OQ);
+			best_errors[half] = _mm256_blendv_ps(best_errors[half], error, closer);
+			best_entries[half] = _mm256_blendv_ps(best_entries[half], entry_index, closer);
+		}
+	}
+
+	alignas(32) std::array<float, BLOCK_PIXEL_COUNT> errors;
+	alignas(32) std::array<float, BLOCK_PIXEL_COUNT> entries;
+	for (size_t half = 0; half < 2; ++half)
+	{
+		_mm256_store_ps(errors.data() + half * 8, best_errors[half]);
+		_mm256_store_ps(entries.data() + half * 8, best_entries[half]);
+	}
+	float total = 0.0f;
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+	{
+		indices[pixel] = static_cast<uint8_t>(entries[pixel]);
+		total += errors[pixel];
+	}
+	return total;
+}
+
+// Endpoints at the extremes of the pixels' projections onto their principal
+// axis, found by power iteration on the covariance
+void fit_principal_endpoints(const Block& block, const uint32_t channel_count, Color& start, Color& end)
+{
+	Color mean {};
+	for (uint32_t channel = 0; channel < channel_count; ++channel)
+	{
+		for (const float value : block.channels[channel])
+			mean[channel] += value;
+		mean[channel] /= BLOCK_PIXEL_COUNT;
+	}
+
+	std::array<Color, CHANNEL_COUNT> covariance {};
+	Color axis {};
+	for (uint32_t row = 0; row < channel_count; ++row)
+	{
+		const auto [low, high] = std::minmax_element(block.channels[row].begin(), block.channels[row].end());
+		axis[row] = *high - *low;
+		for (uint32_t column = 0; column < channel_count; ++column)
+		{
+			for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+				covariance[row][column] += (block.channels[row][pixel] - mean[row])
+					* (block.channels[column][pixel] - mean[column]);
+		}
+	}
+
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		Color next {};
+		float length = 0.0f;
+		for (uint32_t row = 0; row < channel_count; ++row)
+		{
+			for (uint32_t column = 0; column < channel_count; ++column)
+				next[row] += covariance[row][column] * axis[column];
+			length = std::max(length, std::abs(next[row]));
+		}
+		if (length <= 0.0f)
+			break;
+		for (uint32_t channel = 0; channel < channel_count; ++channel)
+			axis[channel] = next[channel] / length;
+	}
+
+	float length = 0.0f;
+	for (uint32_t channel = 0; channel < channel_count; ++channel)
+		length += axis[channel] * axis[channel];
+	start = mean;
+	end = mean;
+	if (length <= 0.0f)
+		return;
+	length = std::sqrt(length);
+
+	float min_projection = std::numeric_limits<float>::max();
+	float max_projection = std::numeric_limits<float>::lowest();
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+	{
+		float projection = 0.0f;
+		for (uint32_t channel = 0; channel < channel_count; ++channel)
+			projection += (block.channels[channel][pixel] - mean[channel]) * axis[channel] / length;
+		min_projection = std::min(min_projection, projection);
+		max_projection = std::max(max_projection, projection);
+	}
+	for (uint32_t channel = 0; channel < channel_count; ++channel)
+	{
+		start[channel] = std::clamp(mean[channel] + axis[channel] / length * min_projection, 0.0f, 255.0f);
+		end[channel] = std::clamp(mean[channel] + axis[channel] / length * max_projection, 0.0f, 255.0f);
+	}
+}
+
+// Least squares endpoints for the current indices, where index_weights gives
+// each index's blend from start towards end. Returns false when the indices
+// do not constrain both endpoints.
+bool refine_endpoints(const Block& block, const uint32_t channel_count, const BlockIndices& indices,
+	const std::span<const float> index_weights, Color& start, Color& end)
+{
+	float start_start = 0.0f;
+	float start_end = 0.0f;
+	float end_end = 0.0f;
+	Color start_sum {};
+	Color end_sum {};
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+	{
+		const float weight = index_weights[indices[pixel]];
+		const float inverse = 1.0f - weight;
+		start_start += inverse * inverse;
+		start_end += inverse * weight;
+		end_end += weight * weight;
+		for (uint32_t channel = 0; channel < channel_count; ++channel)
+		{
+			start_sum[channel] += inverse * block.channels[channel][pixel];
+			end_sum[channel] += weight * block.channels[channel][pixel];
+		}
+	}
+	const float determinant = start_start * end_end - start_end * start_end;
+	if (std::abs(determinant) < 1e-4f)
+		return false;
+	for (uint32_t channel = 0; channel < channel_count; ++channel)
+	{
+		start[channel] = std::clamp(
+			(end_end * start_sum[channel] - start_end * end_sum[channel]) / determinant, 0.0f, 255.0f);
+		end[channel] = std::clamp(
+			(start_start * end_sum[channel] - start_end * start_sum[channel]) / determinant, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+void write_bits(std::byte* out, const uint64_t bits, const size_t byte_count)
+{
+	for (size_t index = 0; index < byte_count; ++index)
+		out[index] = static_cast<std::byte>(bits >> (index * 8));
+}
+
+uint64_t read_bits(const std::byte* in, const size_t byte_count)
+{
+	uint64_t bits = 0;
+	for (size_t index = 0; index < byte_count; ++index)
+		bits |= static_cast<uint64_t>(std::to_integer<uint8_t>(in[index])) << (index * 8);
+	return bits;
+}
+
+uint16_t pack_565(const Color& color)
+{
+	const auto scale = [](const float value, const int max)
+	{
+		return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 255.0f) * max / 255.0f));
+	};
+	return static_cast<uint16_t>((scale(color[0], 31) << 11) | (scale(color[1], 63) << 5) | scale(color[2], 31));
+}
+
+Color unpack_565(const uint16_t packed)
+{
+	const uint32_t red = packed >> 11;
+	const uint32_t green = (packed >> 5) & 63;
+	const uint32_t blue = packed & 31;
+	return {
+		static_cast<float>((red << 3) | (red >> 2)),
+		static_cast<float>((green << 2) | (green >> 4)),
+		static_cast<float>((blue << 3) | (blue >> 2)),
+		255.0f,
+	};
+}
+
+// Four colour BC1 palette, as BC3 colour blocks always decode
+std::array<Color, 4> make_color_palette(const uint16_t color0, const uint16_t color1)
+{
+	std::array<Color, 4> palette = { unpack_565(color0), unpack_565(color1) };
+	for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+	{
+		palette[2][channel] = std::floor((2.0f * palette[0][channel] + palette[1][channel]) / 3.0f);
+		palette[3][channel] = std::floor((palette[0][channel] + 2.0f * palette[1][channel]) / 3.0f);
+	}
+	return palette;
+}
+
+// Opaque four colour BC1 block of the block's RGB
+void encode_color_block(const Block& block, std::byte* out)
+{
+	static constexpr std::array<float, 4> INDEX_WEIGHTS = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	Color start;
+	Color end;
+	fit_principal_endpoints(block, 3, start, end);
+	float best_error = std::numeric_limits<float>::max();
+	uint16_t best_colors[2] = {};
+	BlockIndices best_indices {};
+	for (int iteration = 0; iteration <= ENDPOINT_REFINEMENTS; ++iteration)
+	{
+		uint16_t color0 = pack_565(end);
+		uint16_t color1 = pack_565(start);
+		// color0 > color1 selects four colour mode
+		if (color0 < color1)
+			std::swap(color0, color1);
+		const auto palette = make_color_palette(color0, color1);
+		BlockIndices indices;
+		// equal endpoints decode as three colour mode, where only index 0 is safe
+		const float error = fit_indices(block, 0, 3,
+			std::span<const Color>(palette.data(), color0 == color1 ? 1 : palette.size()), indices);
+		if (error < best_error)
+		{
+			best_error = error;
+			best_colors[0] = color0;
+			best_colors[1] = color1;
+			best_indices = indices;
+		}
+		if (error == 0.0f || color0 == color1
+			|| !refine_endpoints(block, 3, indices, INDEX_WEIGHTS, end, start))
+			break;
+	}
+
+	uint64_t bits = 0;
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+		bits |= static_cast<uint64_t>(best_indices[pixel]) << (pixel * 2);
+	write_bits(out, best_colors[0] | (static_cast<uint64_t>(best_colors[1]) << 16) | (bits << 32), 8);
+}
+
+std::array<float, 8> make_single_channel_palette(const uint32_t value0, const uint32_t value1)
+{
+	std::array<float, 8> palette = { static_cast<float>(value0), static_cast<float>(value1) };
+	if (value0 > value1)
+	{
+		for (uint32_t index = 2; index < 8; ++index)
+			palette[index] = static_cast<float>(((8 - index) * value0 + (index - 1) * value1 + 3) / 7);
+	}
+	else
+	{
+		for (uint32_t index = 2; index < 6; ++index)
+			palette[index] = static_cast<float>(((6 - index) * value0 + (index - 1) * value1 + 2) / 5);
+		palette[6] = 0.0f;
+		palette[7] = 255.0f;
+	}
+	return palette;
+}
+
+// BC4 block of one channel, spanning its range in eight steps
+void encode_single_channel_block(const Block& block, const uint32_t channel, std::byte* out)
+{
+	const auto [low, high] = std::minmax_element(block.channels[channel].begin(), block.channels[channel].end());
+	const auto value0 = static_cast<uint32_t>(std::lround(*high));
+	const auto value1 = static_cast<uint32_t>(std::lround(*low));
+	BlockIndices indices {};
+	if (value0 != value1)
+	{
+		const auto values = make_single_channel_palette(value0, value1);
+		std::array<Color, 8> palette {};
+		for (size_t index = 0; index < palette.size(); ++index)
+			palette[index][channel] = values[index];
+		fit_indices(block, channel, 1, palette, indices);
+	}
+
+	uint64_t bits = value0 | (value1 << 8);
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+		bits |= static_cast<uint64_t>(indices[pixel]) << (16 + pixel * 3);
+	write_bits(out, bits, 8);
+}
+
+// Least significant bit first, as BC7 packs its fields
+struct BitStream
+{
+	std::array<uint64_t, 2> words {};
+	uint32_t position = 0;
+
+	void write(const uint32_t value, const uint32_t count)
+	{
+		for (uint32_t bit = 0; bit < count; ++bit, ++position)
+			words[position / 64] |= static_cast<uint64_t>((value >> bit) & 1) << (position % 64);
+	}
+
+	uint32_t read(const uint32_t count)
+	{
+		uint32_t value = 0;
+		for (uint32_t bit = 0; bit < count; ++bit, ++position)
+			value |= static_cast<uint32_t>((words[position / 64] >> (position % 64)) & 1) << bit;
+		return value;
+	}
+};
+
+// Seven bit endpoint channels sharing a p-bit
+struct Bc7Endpoint
+{
+	std::array<uint32_t, CHANNEL_COUNT> values {};
+	uint32_t p_bit = 0;
+
+	uint32_t get_channel(const uint32_t channel) const { return (values[channel] << 1) | p_bit; }
+};
+
+Bc7Endpoint quantize_bc7_endpoint(const Color& color, const uint32_t p_bit)
+{
+	Bc7Endpoint endpoint { .p_bit = p_bit };
+	for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+		endpoint.values[channel] = static_cast<uint32_t>(std::clamp<long>(
+			std::lround((color[channel] - static_cast<float>(p_bit)) * 0.5f), 0, 127));
+	return endpoint;
+}
+
+std::array<Color, 16> make_bc7_palette(const Bc7Endpoint& endpoint0, const Bc7Endpoint& endpoint1)
+{
+	std::array<Color, 16> palette;
+	for (size_t index = 0; index < palette.size(); ++index)
+	{
+		for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+			palette[index][channel] = static_cast<float>(((64 - BC7_WEIGHTS[index]) * endpoint0.get_channel(channel)
+				+ BC7_WEIGHTS[index] * endpoint1.get_channel(channel) + 32) >> 6);
+	}
+	return palette;
+}
+
+// Mode 6 BC7 block: one RGBA line with sixteen steps
+void encode_bc7_block(const Block& block, std::byte* out)
+{
+	static const std::array<float, 16> INDEX_WEIGHTS = []
+	{
+		std::array<float, 16> weights;
+		for (size_t index = 0; index < weights.size(); ++index)
+			weights[index] = static_cast<float>(BC7_WEIGHTS[index]) / 64.0f;
+		return weights;
+	}();
+
+	Color start;
+	Color end;
+	fit_principal_endpoints(block, CHANNEL_COUNT, start, end);
+	float best_error = std::numeric_limits<float>::max();
+	Bc7Endpoint best_endpoints[2];
+	BlockIndices best_indices {};
+	for (int iteration = 0; iteration <= ENDPOINT_REFINEMENTS; ++iteration)
+	{
+		// every p-bit pair, since mixing them reaches odd and even values the
+		// endpoints cannot hold alone
+		float error = std::numeric_limits<float>::max();
+		BlockIndices indices;
+		for (uint32_t p_bits = 0; p_bits < 4; ++p_bits)
+		{
+			const Bc7Endpoint endpoint0 = quantize_bc7_endpoint(start, p_bits & 1);
+			const Bc7Endpoint endpoint1 = quantize_bc7_endpoint(end, p_bits >> 1);
+			BlockIndices candidate;
+			const float candidate_error = fit_indices(
+				block, 0, CHANNEL_COUNT, make_bc7_palette(endpoint0, endpoint1), candidate);
+			if (candidate_error < error)
+			{
+				error = candidate_error;
+				indices = candidate;
+			}
+			if (candidate_error < best_error)
+			{
+				best_error = candidate_error;
+				best_endpoints[0] = endpoint0;
+				best_endpoints[1] = endpoint1;
+				best_indices = candidate;
+			}
+		}
+		if (error == 0.0f || !refine_endpoints(block, CHANNEL_COUNT, indices, INDEX_WEIGHTS, start, end))
+			break;
+	}
+
+	// the first index drops its top bit, so it must be below 8
+	if (best_indices[0] >= 8)
+	{
+		std::swap(best_endpoints[0], best_endpoints[1]);
+		for (auto& index : best_indices)
+			index = static_cast<uint8_t>(15 - index);
+	}
+
+	BitStream bits;
+	bits.write(BC7_MODE_6, 7);
+	for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+	{
+		bits.write(best_endpoints[0].values[channel], 7);
+		bits.write(best_endpoints[1].values[channel], 7);
+	}
+	bits.write(best_endpoints[0].p_bit, 1);
+	bits.write(best_endpoints[1].p_bit, 1);
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+		bits.write(best_indices[pixel], pixel == 0 ? 3 : 4);
+	write_bits(out, bits.words[0], 8);
+	write_bits(out + 8, bits.words[1], 8);
+}
+
+// Block decoding, into 16 RGBA pixels
+
+using DecodedBlock = std::array<std::array<uint8_t, CHANNEL_COUNT>, BLOCK_PIXEL_COUNT>;
+
+void decode_color_block(const std::byte* in, const bool four_colour_only, DecodedBlock& pixels)
+{
+	const uint64_t bits = read_bits(in, 8);
+	const auto color0 = static_cast<uint16_t>(bits);
+	const auto color1 = static_cast<uint16_t>(bits >> 16);
+	std::array<Color, 4> palette = make_color_palette(color0, color1);
+	if (!four_colour_only && color0 <= color1)
+	{
+		for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+			palette[2][channel] = std::floor((palette[0][channel] + palette[1][channel]) / 2.0f);
+		palette[3] = {};
+	}
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+	{
+		const auto& color = palette[(bits >> (32 + pixel * 2)) & 3];
+		for (uint32_t channel = 0; channel < 3; ++channel)
+			pixels[pixel][channel] = static_cast<uint8_t>(color[channel]);
+		if (!four_colour_only)
+			pixels[pixel][3] = static_cast<uint8_t>(color[3]);
+	}
+}
+
+void decode_single_channel_block(const std::byte* in, const uint32_t channel, DecodedBlock& pixels)
+{
+	const uint64_t bits = read_bits(in, 8);
+	const auto palette = make_single_channel_palette(bits & 0xff, (bits >> 8) & 0xff);
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+		pixels[pixel][channel] = static_cast<uint8_t>(palette[(bits >> (16 + pixel * 3)) & 7]);
+}
+
+void decode_bc7_block(const std::byte* in, DecodedBlock& pixels)
+{
+	BitStream bits;
+	bits.words = { read_bits(in, 8), read_bits(in + 8, 8) };
+	if (bits.read(7) != BC7_MODE_6)
+		throw std::invalid_argument("TextureProcessor: only mode 6 BC7 blocks can be decoded");
+	Bc7Endpoint endpoints[2];
+	for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+	{
+		endpoints[0].values[channel] = bits.read(7);
+		endpoints[1].values[channel] = bits.read(7);
+	}
+	endpoints[0].p_bit = bits.read(1);
+	endpoints[1].p_bit = bits.read(1);
+	const auto palette = make_bc7_palette(endpoints[0], endpoints[1]);
+	for (uint32_t pixel = 0; pixel < BLOCK_PIXEL_COUNT; ++pixel)
+	{
+		const auto& color = palette[bits.read(pixel == 0 ? 3 : 4)];
+		for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+			pixels[pixel][channel] = static_cast<uint8_t>(color[channel]);
+	}
+}
+}
+
+bool TextureProcessor::is_srgb(const ETextureSemantic semantic)
+{
+	return semantic == ETextureSemantic::BASE_COLOR || semantic == ETextureSemantic::EMISSIVE;
+}
+
+ETextureFormat TextureProcessor::select_format(
+	const ETextureSemantic semantic, const bool has_alpha, const Settings& settings)
+{
+	if (!settings.compress)
+		return ETextureFormat::RGBA8;
+	if (semantic == ETextureSemantic::NORMAL)
+		return ETextureFormat::BC5;
+	if (settings.prefer_bc7)
+		return ETextureFormat::BC7;
+	return has_alpha ? ETextureFormat::BC3 : ETextureFormat::BC1;
+}
+
+uint32_t TextureProcessor::get_mip_count(const uint32_t width, const uint32_t height)
+{
+	return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+}
+
+size_t TextureProcessor::get_level_size(const ETextureFormat format, const uint32_t width, const uint32_t height)
+{
+	if (format == ETextureFormat::RGBA8)
+		return static_cast<size_t>(width) * height * CHANNEL_COUNT;
+	const size_t blocks_wide = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const size_t blocks_high = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	return blocks_wide * blocks_high * get_block_size(format);
+}
+
+TextureMipChain TextureProcessor::generate_mips(const std::span<const std::byte> pixels,
+	const uint32_t width, const uint32_t height, const ETextureSemantic semantic,
+	const EMipFilter filter, TaskPool& pool)
+{
+	validate_level(pixels, width, height);
+	const uint32_t mip_count = get_mip_count(width, height);
+	TextureMipChain chain;
+	chain.mip_sizes.reserve(mip_count);
+	chain.data.reserve(pixels.size() + pixels.size() / 3 + CHANNEL_COUNT * mip_count);
+	chain.data.assign(pixels.begin(), pixels.end());
+	chain.mip_sizes.push_back(pixels.size());
+
+	std::vector<float> level = decode_level(pixels, semantic);
+	std::vector<float> next;
+	std::vector<float> scratch;
+	uint32_t level_width = width;
+	uint32_t level_height = height;
+	for (uint32_t mip = 1; mip < mip_count; ++mip)
+	{
+		const uint32_t next_width = std::max(level_width / 2, 1u);
+		const uint32_t next_height = std::max(level_height / 2, 1u);
+		resample(level, level_width, level_height, next, next_width, next_height, filter, scratch, pool);
+		finish_level(next, semantic);
+
+		const size_t offset = chain.data.size();
+		chain.data.resize(offset + next.size());
+		encode_level(next, semantic, chain.data.data() + offset);
+		chain.mip_sizes.push_back(next.size());
+
+		std::swap(level, next);
+		level_width = next_width;
+		level_height = next_height;
+	}
+	return chain;
+}
+
+void TextureProcessor::compress_level(const ETextureFormat format, const std::span<const std::byte> pixels,
+	const uint32_t width, const uint32_t height, const std::span<std::byte> blocks, TaskPool& pool)
+{
+	if (format == ETextureFormat::RGBA8)
+		throw std::invalid_argument("TextureProcessor: RGBA8 is not a block format");
+	validate_level(pixels, width, height);
+	if (blocks.size() != get_level_size(format, width, height))
+		throw std::invalid_argument("TextureProcessor: block storage does not match the level size");
+
+	const uint32_t blocks_wide = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const uint32_t blocks_high = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const size_t block_size = get_block_size(format);
+	pool.parallel_for(blocks_high, MIN_BLOCK_ROWS_PER_TASK, [&](const size_t first, const size_t last)
+	{
+		Block block;
+		for (size_t block_y = first; block_y < last; ++block_y)
+		{
+			for (uint32_t block_x = 0; block_x < blocks_wide; ++block_x)
+			{
+				load_block(pixels, width, height, block_x, static_cast<uint32_t>(block_y), block);
+				std::byte* out = blocks.data() + (block_y * blocks_wide + block_x) * block_size;
+				switch (format)
+				{
+				case ETextureFormat::BC1:
+					encode_color_block(block, out);
+					break;
+				case ETextureFormat::BC3:
+					encode_single_channel_block(block, 3, out);
+					encode_color_block(block, out + 8);
+					break;
+				case ETextureFormat::BC5:
+					encode_single_channel_block(block, 0, out);
+					encode_single_channel_block(block, 1, out + 8);
+					break;
+				case ETextureFormat::BC7:
+					encode_bc7_block(block, out);
+					break;
+				case ETextureFormat::RGBA8:
+					break;
+				}
+			}
+		}
+	});
+}
+
+void TextureProcessor::decompress_level(const ETextureFormat format, const std::span<const std::byte> blocks,
+	const uint32_t width, const uint32_t height, const std::span<std::byte> pixels)
+{
+	if (format == ETextureFormat::RGBA8)
+		throw std::invalid_argument("TextureProcessor: RGBA8 is not a block format");
+	validate_level(pixels, width, height);
+	if (blocks.size() != get_level_size(format, width, height))
+		throw std::invalid_argument("TextureProcessor: block storage does not match the level size");
+
+	const uint32_t blocks_wide = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const uint32_t blocks_high = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+	const size_t block_size = get_block_size(format);
+	DecodedBlock decoded;
+	for (uint32_t block_y = 0; block_y < blocks_high; ++block_y)
+	{
+		for (uint32_t block_x = 0; block_x < blocks_wide; ++block_x)
+		{
+			const std::byte* in = blocks.data() + (static_cast<size_t>(block_y) * blocks_wide + block_x) * block_size;
+			for (auto& pixel : decoded)
+				pixel = { 0, 0, 0, 255 };
+			switch (format)
+			{
+			case ETextureFormat::BC1:
+				decode_color_block(in, false, decoded);
+				break;
+			case ETextureFormat::BC3:
+				decode_single_channel_block(in, 3, decoded);
+				decode_color_block(in + 8, true, decoded);
+				break;
+			case ETextureFormat::BC5:
+				decode_single_channel_block(in, 0, decoded);
+				decode_single_channel_block(in + 8, 1, decoded);
+				break;
+			case ETextureFormat::BC7:
+				decode_bc7_block(in, decoded);
+				break;
+			case ETextureFormat::RGBA8:
+				break;
+			}
+
+			for (uint32_t y = 0; y < BLOCK_DIMENSION && block_y * BLOCK_DIMENSION + y < height; ++y)
+			{
+				for (uint32_t x = 0; x < BLOCK_DIMENSION && block_x * BLOCK_DIMENSION + x < width; ++x)
+				{
+					const size_t offset = ((static_cast<size_t>(block_y) * BLOCK_DIMENSION + y) * width
+						+ block_x * BLOCK_DIMENSION + x) * CHANNEL_COUNT;
+					for (uint32_t channel = 0; channel < CHANNEL_COUNT; ++channel)
+						pixels[offset + channel] = static_cast<std::byte>(decoded[y * BLOCK_DIMENSION + x][channel]);
+				}
+			}
+		}
+	}
+}
+
+void TextureProcessor::process(TextureMaterial& material, const Settings& settings)
+{
+	process(material, settings, TaskPool::get_shared());
+}
+
+void TextureProcessor::process(TextureMaterial& material, const Settings& settings, TaskPool& pool)
+{
+	if (material.format != ETextureFormat::RGBA8 || material.channels != CHANNEL_COUNT || !material.data
+		|| material.mip_sizes.size() > 1 || material.width == 0 || material.height == 0
+		|| material.data_len != static_cast<size_t>(material.width) * material.height * CHANNEL_COUNT)
+		throw std::invalid_argument("TextureProcessor: expected a single level of RGBA8 pixels");
+	if (!settings.generate_mips && !settings.compress)
+		return;
+
+	const std::span<const std::byte> pixels(material.data->get(), material.data_len);
+	bool has_alpha = false;
+	for (size_t index = CHANNEL_COUNT - 1; index < pixels.size() && !has_alpha; index += CHANNEL_COUNT)
+		has_alpha = std::to_integer<uint8_t>(pixels[index]) != 255;
+	const ETextureFormat format = select_format(material.semantic, has_alpha, settings);
+
+	TextureMipChain chain = settings.generate_mips
+		? generate_mips(pixels, material.width, material.height, material.semantic, settings.mip_filter, pool)
+		: TextureMipChain { { pixels.begin(), pixels.end() }, { pixels.size() } };
+	if (format != ETextureFormat::RGBA8)
+	{
+		TextureMipChain compressed;
+		for (size_t mip = 0; mip < chain.mip_sizes.size(); ++mip)
+			compressed.mip_sizes.push_back(get_level_size(format,
+				std::max(material.width >> mip, 1u), std::max(material.height >> mip, 1u)));
+		size_t compressed_size = 0;
+		for (const size_t size : compressed.mip_sizes)
+			compressed_size += size;
+		compressed.data.resize(compressed_size);
+
+		size_t source_offset = 0;
+		size_t target_offset = 0;
+		for (size_t mip = 0; mip < chain.mip_sizes.size(); ++mip)
+		{
+			compress_level(format, std::span<const std::byte>(chain.data).subspan(source_offset, chain.mip_sizes[mip]),
+				std::max(material.width >> mip, 1u), std::max(material.height >> mip, 1u),
+				std::span<std::byte>(compressed.data).subspan(target_offset, compressed.mip_sizes[mip]), pool);
+			source_offset += chain.mip_sizes[mip];
+			target_offset += compressed.mip_sizes[mip];
+		}
+		chain = std::move(compressed);
+	}
+
+	material.format = format;
+	material.data_len = chain.data.size();
+	material.mip_sizes = std::move(chain.mip_sizes);
+	material.data = std::make_unique<OwnedTextureData>(std::move(chain.data));
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "material.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+class TaskPool;
+
+// How loaders prepare decoded textures for the GPU
+enum class ETextureProcessing
+{
+	// A mip chain, block compressed as TextureProcessor::select_format picks
+	DEFAULT,
+	// A single level of RGBA8 pixels, as CPU consumers such as environment
+	// map processing need
+	NONE,
+};
+
+struct TextureMipChain
+{
+	// Levels from largest to smallest, each tightly packed
+	std::vector<std::byte> data;
+	std::vector<size_t> mip_sizes;
+};
+
+// Prepares decoded RGBA8 textures for sampling: generates mip chains filtered
+// in linear space and encodes them into BC formats chosen by semantic. Block
+// rows are encoded in parallel, and each block is fitted eight pixels at a
+// time.
+class TextureProcessor
+{
+public:
+	enum class EMipFilter
+	{
+		BOX,
+		// Kaiser-windowed sinc, sharper than box filtering
+		KAISER,
+	};
+
+	struct Settings
+	{
+		bool generate_mips = true;
+		EMipFilter mip_filter = EMipFilter::KAISER;
+		bool compress = true;
+		// BC7 for colour data. Otherwise BC1, or BC3 with alpha, which encode
+		// several times faster at lower quality.
+		bool prefer_bc7 = true;
+	};
+
+	// Base colour and emissive textures hold sRGB-encoded colour
+	static bool is_srgb(ETextureSemantic semantic);
+	// BC5 for normals; BC7, BC3 or BC1 for the rest
+	static ETextureFormat select_format(ETextureSemantic semantic, bool has_alpha, const Settings& settings);
+	static uint32_t get_mip_count(uint32_t width, uint32_t height);
+	// Bytes of one width by height level in format
+	static size_t get_level_size(ETextureFormat format, uint32_t width, uint32_t height);
+
+	// Downsamples RGBA8 pixels into a complete mip chain whose first level is
+	// a copy of pixels. Colour is filtered in linear space for sRGB semantics,
+	// and normal maps are renormalized at every level.
+	static TextureMipChain generate_mips(std::span<const std::byte> pixels, uint32_t width, uint32_t height,
+		ETextureSemantic semantic, EMipFilter filter, TaskPool& pool);
+	// Encodes one level of RGBA8 pixels into blocks, which must hold
+	// get_level_size bytes. Partial blocks at the edges repeat the edge pixels.
+	static void compress_level(ETextureFormat format, std::span<const std::byte> pixels,
+		uint32_t width, uint32_t height, std::span<std::byte> blocks, TaskPool& pool);
+	// Decodes one level back into RGBA8 pixels. Only mode 6 BC7 blocks, the
+	// mode compress_level writes, are supported.
+	static void decompress_level(ETextureFormat format, std::span<const std::byte> blocks,
+		uint32_t width, uint32_t height, std::span<std::byte> pixels);
+
+	// Replaces a single-level RGBA8 texture with its processed mip chain, on
+	// TaskPool::get_shared(). Throws std::invalid_argument for other textures.
+	static void process(TextureMaterial& material, const Settings& settings);
+	static void process(TextureMaterial& material, const Settings& settings, TaskPool& pool);
+};
@@ -0,0 +1,291 @@
+#include "derived_data_cache.hpp"
+#include "utility.hpp"
+
+#include <quill/LogMacros.h>
+#include <fmt/core.h>
+
+#include <unistd.h>
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+
+namespace
+{
+constexpr char ENTRY_MAGIC[4] = { 'K', 'D', 'D', 'C' };
+constexpr uint32_t ENTRY_VERSION = 1;
+// Seeds of the two halves of a key
+constexpr uint64_t LOW_SEED = 0;
+constexpr uint64_t HIGH_SEED = 0x6b72697370646463ull;
+
+struct EntryHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t key_low;
+	uint64_t key_high;
+	uint64_t section_count;
+};
+
+struct SectionRecord
+{
+	uint64_t offset;
+	uint64_t size;
+};
+
+// XXH64
+constexpr uint64_t PRIME1 = 0x9e3779b185ebca87ull;
+constexpr uint64_t PRIME2 = 0xc2b2ae3d27d4eb4full;
+constexpr uint64_t PRIME3 = 0x165667b19e3779f9ull;
+constexpr uint64_t PRIME4 = 0x85ebca77c2b2ae63ull;
+constexpr uint64_t PRIME5 = 0x27d4eb2f165667c5ull;
+
+uint64_t read_u64(const std::byte* bytes)
+{
+	uint64_t value;
+	std::memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+uint32_t read_u32(const std::byte* bytes)
+{
+	uint32_t value;
+	std::memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+uint64_t hash_round(uint64_t accumulator, const uint64_t input)
+{
+	accumulator += input * PRIME2;
+	return std::rotl(accumulator, 31) * PRIME1;
+}
+
+uint64_t merge_round(uint64_t accumulator, const uint64_t value)
+{
+	accumulator ^= hash_round(0, value);
+	return accumulator * PRIME1 + PRIME4;
+}
+
+uint64_t xxh64(const std::span<const std::byte> bytes, const uint64_t seed)
+{
+	const std::byte* input = bytes.data();
+	const std::byte* const end = input + bytes.size();
+	uint64_t hash;
+	if (bytes.size() >= 32)
+	{
+		uint64_t lanes[4] = { seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1 };
+		for (; input + 32 <= end; input += 32)
+			for (int lane = 0; lane < 4; ++lane)
+				lanes[lane] = hash_round(lanes[lane], read_u64(input + lane * 8));
+		hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+		for (const uint64_t lane : lanes)
+			hash = merge_round(hash, lane);
+	}
+	else
+		hash = seed + PRIME5;
+
+	hash += bytes.size();
+	for (; input + 8 <= end; input += 8)
+		hash = std::rotl(hash ^ hash_round(0, read_u64(input)), 27) * PRIME1 + PRIME4;
+	if (input + 4 <= end)
+	{
+		hash = std::rotl(hash ^ (read_u32(input) * PRIME1), 23) * PRIME2 + PRIME3;
+		input += 4;
+	}
+	for (; input < end; ++input)
+		hash = std::rotl(hash ^ (std::to_integer<uint64_t>(*input) * PRIME5), 11) * PRIME1;
+
+	hash ^= hash >> 33;
+	hash *= PRIME2;
+	hash ^= hash >> 29;
+	hash *= PRIME3;
+	return hash ^ (hash >> 32);
+}
+
+size_t align_section(const size_t offset)
+{
+	return (offset + DerivedDataCache::SECTION_ALIGNMENT - 1) / DerivedDataCache::SECTION_ALIGNMENT
+		* DerivedDataCache::SECTION_ALIGNMENT;
+}
+}
+
+std::string DerivedDataCache::Key::to_string() const
+{
+	return fmt::format("{:016x}{:016x}", high, low);
+}
+
+DerivedDataCache::KeyBuilder& DerivedDataCache::KeyBuilder::add(const std::span<const std::byte> bytes)
+{
+	// length prefixes keep adjacent fields from running into each other
+	add(static_cast<uint64_t>(bytes.size()));
+	material.insert(material.end(), bytes.begin(), bytes.end());
+	return *this;
+}
+
+DerivedDataCache::KeyBuilder& DerivedDataCache::KeyBuilder::add(const std::string_view text)
+{
+	return add(std::as_bytes(std::span(text.data(), text.size())));
+}
+
+DerivedDataCache::KeyBuilder& DerivedDataCache::KeyBuilder::add(const uint64_t value)
+{
+	const auto bytes = std::as_bytes(std::span(&value, 1));
+	material.insert(material.end(), bytes.begin(), bytes.end());
+	return *this;
+}
+
+DerivedDataCache::KeyBuilder& DerivedDataCache::KeyBuilder::add(const Key& key)
+{
+	return add(key.low).add(key.high);
+}
+
+DerivedDataCache::Key DerivedDataCache::KeyBuilder::build() const
+{
+	return hash(material);
+}
+
+uint32_t DerivedDataCache::EntryWriter::add_section(const std::span<const std::byte> bytes)
+{
+	sections.push_back(bytes);
+	return static_cast<uint32_t>(sections.size() - 1);
+}
+
+uint32_t DerivedDataCache::EntryWriter::add_owned_section(std::vector<std::byte> bytes)
+{
+	return add_section(owned_sections.emplace_back(std::move(bytes)));
+}
+
+DerivedDataCache::DerivedDataCache(std::filesystem::path directory) :
+	directory(std::move(directory))
+{
+}
+
+DerivedDataCache::Key DerivedDataCache::hash(const std::span<const std::byte> bytes)
+{
+	return { .low = xxh64(bytes, LOW_SEED), .high = xxh64(bytes, HIGH_SEED) };
+}
+
+std::optional<DerivedDataCache::Key> DerivedDataCache::hash_file(const std::filesystem::path& path)
+{
+	const auto file = MappedFile::open(path);
+	if (!file)
+	{
+		std::error_code error;
+		if (std::filesystem::is_regular_file(path, error) && std::filesystem::file_size(path, error) == 0)
+			return hash({});
+		return std::nullopt;
+	}
+	return hash(file->bytes());
+}
+
+std::shared_ptr<const DerivedDataCache::Entry> DerivedDataCache::find(const Key& key)
+{
+	auto file = MappedFile::open(get_entry_path(key));
+	if (!file)
+	{
+		++misses;
+		return nullptr;
+	}
+	// entries are mapped copy-on-write, so sections can be handed to consumers
+	// that take mutable pointers
+	std::shared_ptr<Entry> entry(new Entry(std::move(*file)));
+	const std::byte* mapping = entry->file.data();
+	const size_t size = entry->file.size();
+
+	EntryHeader header;
+	bool valid = size >= sizeof(header);
+	if (valid)
+	{
+		std::memcpy(&header, mapping, sizeof(header));
+		valid = std::memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0
+			&& header.version == ENTRY_VERSION && header.key_low == key.low && header.key_high == key.high
+			&& header.section_count <= (size - sizeof(header)) / sizeof(SectionRecord);
+	}
+	for (uint64_t section = 0; valid && section < header.section_count; ++section)
+	{
+		SectionRecord record;
+		std::memcpy(&record, mapping + sizeof(header) + section * sizeof(record), sizeof(record));
+		valid = record.offset % SECTION_ALIGNMENT == 0 && record.offset <= size && record.size <= size - record.offset;
+		if (valid)
+			entry->sections.emplace_back(mapping + record.offset, static_cast<size_t>(record.size));
+	}
+	if (!valid)
+	{
+		LOG_WARNING(Utility::get_logger(), "DerivedDataCache: ignoring malformed entry {}", key.to_string());
+		++misses;
+		return nullptr;
+	}
+	++hits;
+	return entry;
+}
+
+bool DerivedDataCache::store(const Key& key, const EntryWriter& writer)
+{
+	const auto path = get_entry_path(key);
+	const auto temporary = directory / fmt::format("{}.{}.{}.tmp",
+		key.to_string(), ::getpid(), temporary_sequence.fetch_add(1));
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	EntryHeader header{};
+	std::memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+	header.version = ENTRY_VERSION;
+	header.key_low = key.low;
+	header.key_high = key.high;
+	header.section_count = writer.sections.size();
+	std::vector<SectionRecord> records;
+	records.reserve(writer.sections.size());
+	size_t offset = align_section(sizeof(header) + writer.sections.size() * sizeof(SectionRecord));
+	for (const auto& section : writer.sections)
+	{
+		records.push_back({ .offset = offset, .size = section.size() });
+		offset = align_section(offset + section.size());
+	}
+
+	bool written = false;
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(records.data()),
+			static_cast<std::streamsize>(records.size() * sizeof(SectionRecord)));
+		const char padding[SECTION_ALIGNMENT] = {};
+		size_t position = sizeof(header) + records.size() * sizeof(SectionRecord);
+		for (size_t section = 0; section < records.size(); ++section)
+		{
+			stream.write(padding, static_cast<std::streamsize>(records[section].offset - position));
+			stream.write(reinterpret_cast<const char*>(writer.sections[section].data()),
+				static_cast<std::streamsize>(writer.sections[section].size()));
+			position = records[section].offset + records[section].size;
+		}
+		written = static_cast<bool>(stream);
+	}
+	error.clear();
+	if (written)
+		std::filesystem::rename(temporary, path, error);
+	if (!written || error)
+	{
+		LOG_WARNING(Utility::get_logger(), "DerivedDataCache: failed to store entry {} in '{}'",
+			key.to_string(), directory.string());
+		std::filesystem::remove(temporary, error);
+		return false;
+	}
+	++stores;
+	return true;
+}
+
+bool DerivedDataCache::contains(const Key& key) const
+{
+	std::error_code error;
+	return std::filesystem::is_regular_file(get_entry_path(key), error);
+}
+
+DerivedDataCache::Stats DerivedDataCache::get_stats() const
+{
+	return { .hits = hits.load(), .misses = misses.load(), .stores = stores.load() };
+}
+
+std::filesystem::path DerivedDataCache::get_entry_path(const Key& key) const
+{
+	return directory / (key.to_string() + ".kddc");
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// On-disk store of data derived from source assets, such as imported meshes
+// and processed textures. Entries are addressed by keys hashed from their
+// sources' contents and the settings used to derive them, so an entry never
+// goes stale; a changed source simply misses. Entries are memory-mapped when
+// found, letting large sections be used in place.
+class DerivedDataCache
+{
+public:
+	struct Key
+	{
+		uint64_t low = 0;
+		uint64_t high = 0;
+
+		std::string to_string() const;
+		auto operator<=>(const Key&) const = default;
+	};
+
+	// Accumulates everything an entry is derived from into one key
+	class KeyBuilder
+	{
+	public:
+		KeyBuilder& add(std::span<const std::byte> bytes);
+		KeyBuilder& add(std::string_view text);
+		KeyBuilder& add(uint64_t value);
+		KeyBuilder& add(const Key& key);
+		Key build() const;
+
+	private:
+		std::vector<std::byte> material;
+	};
+
+	// The sections of one stored entry, mapped read-only. Sections start on
+	// SECTION_ALIGNMENT boundaries and stay valid while the entry is alive.
+	class Entry
+	{
+	public:
+		Entry(const Entry&) = delete;
+		Entry& operator=(const Entry&) = delete;
+
+		size_t get_section_count() const { return sections.size(); }
+		// Throws std::out_of_range for a section the entry does not have
+		std::span<const std::byte> get_section(size_t index) const { return sections.at(index); }
+
+	private:
+		friend class DerivedDataCache;
+		explicit Entry(MappedFile file) : file(std::move(file)) {}
+
+		MappedFile file;
+		std::vector<std::span<const std::byte>> sections;
+	};
+
+	// Collects the sections of an entry to store
+	class EntryWriter
+	{
+	public:
+		// The bytes are only referenced, so they must outlive store()
+		uint32_t add_section(std::span<const std::byte> bytes);
+		uint32_t add_owned_section(std::vector<std::byte> bytes);
+
+	private:
+		friend class DerivedDataCache;
+		std::vector<std::span<const std::byte>> sections;
+		std::deque<std::vector<std::byte>> owned_sections;
+	};
+
+	struct Stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t stores = 0;
+	};
+
+	static constexpr size_t SECTION_ALIGNMENT = 64;
+
+	explicit DerivedDataCache(std::filesystem::path directory);
+
+	static Key hash(std::span<const std::byte> bytes);
+	// std::nullopt if the file cannot be read
+	static std::optional<Key> hash_file(const std::filesystem::path& path);
+
+	const std::filesystem::path& get_directory() const { return directory; }
+	// nullptr when the key has no entry, or its entry is unreadable
+	std::shared_ptr<const Entry> find(const Key& key);
+	// Writes the entry under a temporary name and renames it into place, so
+	// concurrent readers never see a partial entry. Returns false, after
+	// logging why, if the entry could not be written.
+	bool store(const Key& key, const EntryWriter& writer);
+	bool contains(const Key& key) const;
+	Stats get_stats() const;
+
+private:
+	std::filesystem::path get_entry_path(const Key& key) const;
+
+	std::filesystem::path directory;
+	std::atomic<uint64_t> hits = 0;
+	std::atomic<uint64_t> misses = 0;
+	std::atomic<uint64_t> stores = 0;
+	std::atomic<uint64_t> temporary_sequence = 0;
+};
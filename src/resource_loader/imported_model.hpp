@@ -0,0 +1,79 @@
+#pragma once
+
+#include "resource_loader.hpp"
+#include "renderable/material.hpp"
+#include "renderable/mesh.hpp"
+#include "renderable/renderable.hpp"
+#include "entity_component_system/skeletal.hpp"
+
+#include <glm/mat4x4.hpp>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+
+// Everything ResourceLoader::load_model derives from one glTF scene, before
+// any of it is added to an ECS. Cold loads build it from the parsed document
+// and warm loads read it back from the derived-data cache.
+struct ImportedTexture
+{
+	int image_index = -1;
+	TextureMaterial texture;
+};
+
+struct ImportedMaterial
+{
+	struct Slot
+	{
+		// Index into ImportedModel::textures, or -1 for an empty slot
+		int texture = -1;
+		PbrMaterial::TextureSampler sampler;
+	};
+
+	glm::vec4 base_color_factor{ 1.0f };
+	float metallic_factor = 1.0f;
+	float roughness_factor = 1.0f;
+	float normal_scale = 1.0f;
+	PbrMaterial::Properties properties;
+	// By ETextureSemantic
+	std::array<Slot, static_cast<size_t>(ETextureSemantic::COUNT)> slots;
+
+	bool has_textures() const
+	{
+		return std::ranges::any_of(slots, [](const Slot& slot) { return slot.texture >= 0; });
+	}
+};
+
+struct ImportedPrimitive
+{
+	MeshPtr mesh;
+	ERenderType render_type = ERenderType::COLOR;
+	// glTF material index, or -1 for the glTF default material
+	int material = -1;
+};
+
+// One mesh-node instance, as ResourceLoader::LoadedMesh
+struct ImportedNode
+{
+	std::string name;
+	int source_node = -1;
+	int source_skin = -1;
+	glm::mat4 world_transform{ 1.0f };
+	std::vector<ImportedPrimitive> primitives;
+};
+
+struct ImportedModel
+{
+	int scene_index = 0;
+	std::vector<ResourceLoader::ImportWarning> warnings;
+	std::vector<ImportedNode> nodes;
+	// By glTF skin index
+	std::map<int, std::vector<Bone>> skins;
+	// By glTF material index, for the materials the scene's primitives use
+	std::map<int, ImportedMaterial> materials;
+	// Each decoded once per image and semantic
+	std::vector<ImportedTexture> textures;
+};
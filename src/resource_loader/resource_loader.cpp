@@ -2,19 +2,30 @@
 #include "resource_loader_mesh.ipp"
 #include "resource_loader_animation.ipp"
 #include "resource_loader_material.ipp"
+#include "resource_loader_cache.ipp"
+#include "derived_data_cache.hpp"
+#include "imported_model.hpp"
 #include "entity_component_system/ecs.hpp"
 #include "entity_component_system/material_system.hpp"
 #include "entity_component_system/mesh_system.hpp"
 #include "serialization/resource_provenance.hpp"
+#include "task_pool.hpp"
 #include "utility.hpp"
 
 #include <tiny_gltf.h>
 #include <fmt/core.h>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <filesystem>
 #include <functional>
+#include <future>
+#include <iterator>
+#include <map>
 #include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
@@ -35,22 +46,37 @@ std::filesystem::path resolve_resource_filename(std::string_view filename, Resol
 }
 }
 
-ResourceLoader ResourceLoader::global_resource_loader;
+std::mutex ResourceLoader::derived_data_cache_mutex;
+std::shared_ptr<DerivedDataCache> ResourceLoader::derived_data_cache;
+
+void ResourceLoader::set_derived_data_cache(std::shared_ptr<DerivedDataCache> cache)
+{
+	std::lock_guard lock(derived_data_cache_mutex);
+	derived_data_cache = std::move(cache);
+}
+
+std::shared_ptr<DerivedDataCache> ResourceLoader::get_derived_data_cache()
+{
+	std::lock_guard lock(derived_data_cache_mutex);
+	return derived_data_cache;
+}
 
 MaterialHandle ResourceLoader::fetch_texture(
 	MaterialSystem& materials,
 	const std::string_view logical_resource_name,
-	const ETextureSemantic semantic)
+	const ETextureSemantic semantic,
+	const ETextureProcessing processing)
 {
 	if (semantic == ETextureSemantic::COUNT)
 		throw ResourceLoadError("ResourceLoader::fetch_texture: invalid texture semantic");
 	const auto resolved_file_path = resolve_resource_filename(logical_resource_name, Utility::get_texture);
-	auto owner = global_resource_loader.load_texture(
-		materials, resolved_file_path, logical_resource_name, semantic);
+	auto owner = load_texture(
+		materials, resolved_file_path, logical_resource_name, semantic, processing);
 	ResourceProvenance::register_material(owner->get_id(), {
 		.kind = EExternalResourceKind::Texture,
 		.source = std::string(logical_resource_name),
 		.texture_semantic = static_cast<int>(semantic),
+		.texture_processing = static_cast<int>(processing),
 	});
 	return owner;
 }
@@ -253,36 +279,199 @@ std::vector<Bone> load_bones(const tinygltf::Model& model, const int skin_index)
 	return bones;
 }
 
-void add_warning(ResourceLoader::LoadedModel& result, const ResourceLoader::LoadOptions& options, std::string message)
+void add_warning(
+	std::vector<ResourceLoader::ImportWarning>& warnings,
+	const ResourceLoader::LoadOptions& options,
+	std::string message)
 {
 	if (options.strict)
 		throw ResourceLoadError(message);
-	result.warnings.push_back({ std::move(message) });
-}
+	warnings.push_back({ std::move(message) });
 }
 
-ResourceLoader::LoadedModel ResourceLoader::load_model(
-	ECS& ecs,
-	const std::string_view filename,
-	const LoadOptions& options)
+// Builds one primitive's mesh. Touches nothing shared, so that primitives
+// can be built in parallel; warnings go to the primitive's own list.
+ImportedPrimitive import_gltf_primitive(
+	const tinygltf::Model& model,
+	const tinygltf::Primitive& primitive,
+	const bool skinned,
+	const std::map<int, ImportedMaterial>& materials,
+	const ResourceLoader::LoadOptions& options,
+	std::vector<ResourceLoader::ImportWarning>& warnings)
 {
-	try
+	const auto position_it = primitive.attributes.find("POSITION");
+	if (position_it == primitive.attributes.end())
+		throw ResourceLoadError("ResourceLoader: primitive is missing POSITION");
+	auto positions = GltfImport::read_vec3(model, position_it->second);
+	for (auto& position : positions)
+		position = GltfImport::to_krisp_basis(position);
+	auto indices = GltfImport::read_indices(model, primitive, positions.size());
+	if (primitive.mode != TINYGLTF_MODE_TRIANGLES)
+		add_warning(warnings, options, "ResourceLoader: converted a non-triangle primitive to triangles");
+	indices = GltfImport::triangles_from(primitive, std::move(indices), options.allow_non_triangle_primitives);
+	GltfImport::reverse_triangle_winding(indices);
+
+	std::vector<glm::vec3> normals;
+	if (GltfImport::has_attribute(primitive, "NORMAL"))
+	{
+		normals = GltfImport::read_vec3(model, primitive.attributes.at("NORMAL"));
+		for (auto& normal : normals)
+			normal = glm::normalize(GltfImport::to_krisp_basis(normal));
+	}
+	else if (options.generate_missing_normals)
 	{
-	const auto file_path = resolve_resource_filename(filename, Utility::get_model);
-	const std::string provenance_source(filename);
-	auto document = load_gltf_document(file_path);
-	auto& model = document.model;
+		add_warning(warnings, options, "ResourceLoader: generated missing normals");
+		normals = GltfImport::generate_normals(positions, indices);
+	}
+	else
+		throw ResourceLoadError("ResourceLoader: primitive is missing NORMAL");
+	if (positions.size() != normals.size())
+		throw ResourceLoadError("ResourceLoader: POSITION and NORMAL counts differ");
+
+	const auto material = materials.find(primitive.material);
+	const bool textured = material != materials.end() && material->second.has_textures();
+	const bool normal_mapped = textured
+		&& material->second.slots[static_cast<size_t>(ETextureSemantic::NORMAL)].texture >= 0;
+	std::vector<glm::vec2> texcoords;
+	std::vector<glm::vec4> tangents;
+	std::optional<GltfImport::TangentRemap> generated_tangents;
+	if (textured)
+	{
+		if (!GltfImport::has_attribute(primitive, "TEXCOORD_0"))
+			throw ResourceLoadError(
+				"ResourceLoader: textured primitive is missing TEXCOORD_0");
+		texcoords = GltfImport::read_vec2(model, primitive.attributes.at("TEXCOORD_0"));
+		if (texcoords.size() != positions.size())
+			throw ResourceLoadError(
+				"ResourceLoader: POSITION and TEXCOORD_0 counts differ");
+		if (GltfImport::has_attribute(primitive, "TANGENT"))
+		{
+			GltfImport::AccessorReader tangent_reader(
+				model, primitive.attributes.at("TANGENT"));
+			if (tangent_reader.accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+				throw ResourceLoadError("ResourceLoader: TANGENT must use float components");
+			tangents = GltfImport::read_vec4(model, primitive.attributes.at("TANGENT"));
+			if (tangents.size() != positions.size())
+				throw ResourceLoadError("ResourceLoader: POSITION and TANGENT counts differ");
+			for (size_t tangent_index = 0; tangent_index < tangents.size(); ++tangent_index)
+			{
+				auto& tangent = tangents[tangent_index];
+				const float length = glm::length(glm::vec3(tangent));
+				if (!std::isfinite(tangent.x) || !std::isfinite(tangent.y)
+					|| !std::isfinite(tangent.z) || !std::isfinite(tangent.w)
+					|| std::abs(length - 1.0f) > 0.001f
+					|| glm::length(glm::cross(glm::vec3(tangent), normals[tangent_index]))
+						< 0.00001f
+					|| std::abs(std::abs(tangent.w) - 1.0f) > 0.001f)
+					throw ResourceLoadError("ResourceLoader: TANGENT contains invalid values");
+				tangent = GltfImport::tangent_to_krisp_basis(tangent);
+			}
+		}
+		else if (normal_mapped)
+		{
+			if (!options.generate_missing_tangents)
+				throw ResourceLoadError(
+					"ResourceLoader: normal-mapped primitive is missing TANGENT");
+			add_warning(warnings, options, "ResourceLoader: generated missing tangents");
+			generated_tangents = GltfImport::generate_tangents(
+				positions, normals, texcoords, indices);
+		}
+		else
+		{
+			tangents.assign(positions.size(), glm::vec4(0.0f));
+		}
+	}
+	ImportedPrimitive imported_primitive;
+	imported_primitive.material = primitive.material;
+	if (skinned)
+	{
+		const bool has_additional_joint_set = std::any_of(
+			primitive.attributes.begin(), primitive.attributes.end(), [](const auto& attribute)
+		{
+			const auto& semantic = attribute.first;
+			return (semantic.starts_with("JOINTS_") && semantic != "JOINTS_0")
+				|| (semantic.starts_with("WEIGHTS_") && semantic != "WEIGHTS_0");
+		});
+		if (has_additional_joint_set)
+			throw ResourceLoadError(
+				"ResourceLoader: skinned primitive exceeds the maximum of 4 bone influences per vertex");
+		if (!GltfImport::has_attribute(primitive, "JOINTS_0") || !GltfImport::has_attribute(primitive, "WEIGHTS_0"))
+			throw ResourceLoadError("ResourceLoader: skinned primitive is missing JOINTS_0 or WEIGHTS_0");
+		auto joints = GltfImport::read_vec4(model, primitive.attributes.at("JOINTS_0"), false);
+		auto weights = GltfImport::read_vec4(model, primitive.attributes.at("WEIGHTS_0"));
+		if (joints.size() != positions.size() || weights.size() != positions.size())
+			throw ResourceLoadError("ResourceLoader: skinned vertex attribute counts differ");
+		if (textured)
+		{
+			if (generated_tangents)
+				imported_primitive.mesh = std::make_unique<SkinnedMesh>(load_skinned_vertices(
+					positions, normals, texcoords, *generated_tangents, joints, weights),
+					std::move(generated_tangents->indices));
+			else
+				imported_primitive.mesh = std::make_unique<SkinnedMesh>(load_skinned_vertices(
+					positions, normals, texcoords, tangents, joints, weights),
+					std::move(indices));
+			imported_primitive.render_type = ERenderType::SKINNED;
+		}
+		else
+		{
+			const std::vector<glm::vec2> empty_texcoords(
+				positions.size(), glm::vec2(0.0f));
+			const std::vector<glm::vec4> empty_tangents(
+				positions.size(), glm::vec4(0.0f));
+			imported_primitive.mesh = std::make_unique<SkinnedMesh>(load_skinned_vertices(
+				positions, normals, empty_texcoords, empty_tangents, joints, weights),
+				std::move(indices));
+			imported_primitive.render_type = ERenderType::SKINNED_COLOR;
+		}
+	}
+	else
+	{
+		if (textured)
+		{
+			if (generated_tangents)
+				imported_primitive.mesh = std::make_unique<TexMesh>(load_tex_vertices(
+					positions, normals, texcoords, *generated_tangents),
+					std::move(generated_tangents->indices));
+			else
+				imported_primitive.mesh = std::make_unique<TexMesh>(load_tex_vertices(
+					positions, normals, texcoords, tangents), std::move(indices));
+			imported_primitive.render_type = ERenderType::STANDARD;
+		}
+		else
+		{
+			imported_primitive.mesh = std::make_unique<ColorMesh>(
+				load_color_vertices(positions, normals), std::move(indices));
+			imported_primitive.render_type = ERenderType::COLOR;
+		}
+	}
+	if (options.prefetch_pick_data)
+		imported_primitive.mesh->get_pick_data();
+	return imported_primitive;
+}
+
+// Builds the selected scene's meshes, skeletons and materials without adding
+// anything to an ECS. Images are decoded and primitives built on the pool;
+// when several fail, the error reported is the one a serial import would
+// have met first among them, textures before primitives.
+ImportedModel import_gltf_model(
+	const GltfDocument& document,
+	const ResourceLoader::LoadOptions& options,
+	TaskPool& pool)
+{
+	const auto& model = document.model;
 	if (model.scenes.empty())
 		throw ResourceLoadError("ResourceLoader::load_model: model contains no scenes");
 
-	const int scene_index = options.scene_index.value_or(model.defaultScene >= 0 ? model.defaultScene : 0);
-	if (scene_index < 0 || scene_index >= static_cast<int>(model.scenes.size()))
+	ImportedModel imported;
+	imported.scene_index = options.scene_index.value_or(model.defaultScene >= 0 ? model.defaultScene : 0);
+	if (imported.scene_index < 0 || imported.scene_index >= static_cast<int>(model.scenes.size()))
 		throw ResourceLoadError("ResourceLoader::load_model: requested scene is out of range");
 
-	LoadedModel result;
+	auto& warnings = imported.warnings;
 	if (!document.warning.empty())
-		result.warnings.push_back({ document.warning });
-	const auto node_instances = collect_mesh_nodes(model, model.scenes[scene_index]);
+		warnings.push_back({ document.warning });
+	const auto node_instances = collect_mesh_nodes(model, model.scenes[imported.scene_index]);
 	std::unordered_set<int> used_materials;
 	for (const auto& instance : node_instances)
 	{
@@ -298,221 +487,240 @@ ResourceLoader::LoadedModel ResourceLoader::load_model(
 				used_materials.insert(primitive.material);
 			}
 	}
-	validate_gltf_materials(model, used_materials, result.warnings, options.strict);
+	validate_gltf_materials(model, used_materials, warnings, options.strict);
 	if (!model.animations.empty())
-		add_warning(result, options,
+		add_warning(warnings, options,
 			"ResourceLoader::load_model: animations were ignored; use ResourceLoader::load_animations to load them explicitly");
-	global_resource_loader.gltf_material_to_material.clear();
-	global_resource_loader.gltf_image_to_material.clear();
 
-	std::unordered_map<int, std::vector<Bone>> skins;
+	struct PrimitiveJob
+	{
+		size_t node;
+		const tinygltf::Primitive* primitive;
+		bool skinned;
+	};
+	std::vector<GltfTextureSource> texture_sources;
+	std::vector<PrimitiveJob> primitive_jobs;
 	for (const NodeInstance& instance : node_instances)
 	{
 		const auto& node = model.nodes.at(instance.node_index);
 		if (node.mesh < 0 || node.mesh >= static_cast<int>(model.meshes.size()))
 			throw ResourceLoadError("ResourceLoader::load_model: node references an invalid mesh");
 
-		LoadedMesh loaded_mesh;
-		loaded_mesh.name = node.name.empty() ? model.meshes[node.mesh].name : node.name;
-		loaded_mesh.source_node = instance.node_index;
-		loaded_mesh.source_skin = node.skin;
+		ImportedNode imported_node;
+		imported_node.name = node.name.empty() ? model.meshes[node.mesh].name : node.name;
+		imported_node.source_node = instance.node_index;
+		imported_node.source_skin = node.skin;
+		imported_node.world_transform = instance.world_transform;
 
-		std::optional<SkeletonID> skeleton;
-		if (node.skin >= 0)
+		const bool skinned = node.skin >= 0;
+		if (skinned)
 		{
 			if (node.skin >= static_cast<int>(model.skins.size()))
 				throw ResourceLoadError("ResourceLoader::load_model: node references an invalid skin");
-			auto it = skins.find(node.skin);
-			if (it == skins.end())
-				it = skins.emplace(node.skin, load_bones(model, node.skin)).first;
-			skeleton = ecs.add_skeleton(it->second);
-			ResourceProvenance::register_skeleton(*skeleton, {
-				.source = provenance_source, .scene = scene_index, .node = instance.node_index, .skin = node.skin });
-			loaded_mesh.skeleton_id = skeleton;
+			if (!imported.skins.contains(node.skin))
+				imported.skins.emplace(node.skin, load_bones(model, node.skin));
+		}
+
+		for (const auto& primitive : model.meshes[node.mesh].primitives)
+		{
+			import_gltf_material(model, primitive.material, imported, texture_sources);
+			primitive_jobs.push_back({ .node = imported.nodes.size(), .primitive = &primitive, .skinned = skinned });
 		}
+		imported.nodes.push_back(std::move(imported_node));
+	}
 
-		for (size_t primitive_index = 0; primitive_index < model.meshes[node.mesh].primitives.size(); ++primitive_index)
+	std::vector<std::optional<TextureMaterial>> textures(texture_sources.size());
+	std::vector<ImportedPrimitive> primitives(primitive_jobs.size());
+	std::vector<std::vector<ResourceLoader::ImportWarning>> primitive_warnings(primitive_jobs.size());
+	std::vector<std::exception_ptr> errors(textures.size() + primitive_jobs.size());
+	pool.parallel_for(errors.size(), 1, [&](const size_t first, const size_t last)
+	{
+		for (size_t job = first; job < last; ++job)
 		{
-			const auto& primitive = model.meshes[node.mesh].primitives[primitive_index];
-			const auto position_it = primitive.attributes.find("POSITION");
-			if (position_it == primitive.attributes.end())
-				throw ResourceLoadError("ResourceLoader: primitive is missing POSITION");
-			auto positions = GltfImport::read_vec3(model, position_it->second);
-			for (auto& position : positions)
-				position = GltfImport::to_krisp_basis(position);
-			auto indices = GltfImport::read_indices(model, primitive, positions.size());
-			if (primitive.mode != TINYGLTF_MODE_TRIANGLES)
-				add_warning(result, options, "ResourceLoader: converted a non-triangle primitive to triangles");
-			indices = GltfImport::triangles_from(primitive, std::move(indices), options.allow_non_triangle_primitives);
-			GltfImport::reverse_triangle_winding(indices);
-
-			std::vector<glm::vec3> normals;
-			if (GltfImport::has_attribute(primitive, "NORMAL"))
-			{
-				normals = GltfImport::read_vec3(model, primitive.attributes.at("NORMAL"));
-				for (auto& normal : normals)
-					normal = glm::normalize(GltfImport::to_krisp_basis(normal));
-			}
-			else if (options.generate_missing_normals)
-			{
-				add_warning(result, options, "ResourceLoader: generated missing normals");
-				normals = GltfImport::generate_normals(positions, indices);
-			}
-			else
-				throw ResourceLoadError("ResourceLoader: primitive is missing NORMAL");
-			if (positions.size() != normals.size())
-				throw ResourceLoadError("ResourceLoader: POSITION and NORMAL counts differ");
-
-			std::vector<MaterialHandle> material_owners;
-			const auto loaded_material = global_resource_loader.load_material(
-				ecs.get_material_system(), primitive, model, material_owners);
-			const auto* pbr_material = dynamic_cast<const PbrMaterial*>(
-				&material_owners.front()->get());
-			if (!pbr_material)
-				throw ResourceLoadError("ResourceLoader: glTF material is not PBR");
-			const bool textured = pbr_material->has_textures();
-			const bool normal_mapped = pbr_material->textures.normal.has_value();
-			std::vector<glm::vec2> texcoords;
-			std::vector<glm::vec4> tangents;
-			std::optional<GltfImport::TangentRemap> generated_tangents;
-			if (textured)
+			try
 			{
-				if (!GltfImport::has_attribute(primitive, "TEXCOORD_0"))
-					throw ResourceLoadError(
-						"ResourceLoader: textured primitive is missing TEXCOORD_0");
-				texcoords = GltfImport::read_vec2(model, primitive.attributes.at("TEXCOORD_0"));
-				if (texcoords.size() != positions.size())
-					throw ResourceLoadError(
-						"ResourceLoader: POSITION and TEXCOORD_0 counts differ");
-				if (GltfImport::has_attribute(primitive, "TANGENT"))
-				{
-					GltfImport::AccessorReader tangent_reader(
-						model, primitive.attributes.at("TANGENT"));
-					if (tangent_reader.accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
-						throw ResourceLoadError("ResourceLoader: TANGENT must use float components");
-					tangents = GltfImport::read_vec4(model, primitive.attributes.at("TANGENT"));
-					if (tangents.size() != positions.size())
-						throw ResourceLoadError("ResourceLoader: POSITION and TANGENT counts differ");
-					for (size_t tangent_index = 0; tangent_index < tangents.size(); ++tangent_index)
-					{
-						auto& tangent = tangents[tangent_index];
-						const float length = glm::length(glm::vec3(tangent));
-						if (!std::isfinite(tangent.x) || !std::isfinite(tangent.y)
-							|| !std::isfinite(tangent.z) || !std::isfinite(tangent.w)
-							|| std::abs(length - 1.0f) > 0.001f
-							|| glm::length(glm::cross(glm::vec3(tangent), normals[tangent_index]))
-								< 0.00001f
-							|| std::abs(std::abs(tangent.w) - 1.0f) > 0.001f)
-							throw ResourceLoadError("ResourceLoader: TANGENT contains invalid values");
-						tangent = GltfImport::tangent_to_krisp_basis(tangent);
-					}
-				}
-				else if (normal_mapped)
-				{
-					if (!options.generate_missing_tangents)
-						throw ResourceLoadError(
-							"ResourceLoader: normal-mapped primitive is missing TANGENT");
-					add_warning(result, options, "ResourceLoader: generated missing tangents");
-					generated_tangents = GltfImport::generate_tangents(
-						positions, normals, texcoords, indices);
-				}
+				if (job < textures.size())
+					textures[job].emplace(decode_gltf_texture(
+						model, texture_sources[job], options.texture_processing, pool));
 				else
 				{
-					tangents.assign(positions.size(), glm::vec4(0.0f));
+					const auto& primitive_job = primitive_jobs[job - textures.size()];
+					primitives[job - textures.size()] = import_gltf_primitive(model, *primitive_job.primitive,
+						primitive_job.skinned, imported.materials, options, primitive_warnings[job - textures.size()]);
 				}
 			}
-			Renderable renderable;
-			renderable.name = loaded_mesh.name;
-			MeshPtr mesh;
-			if (skeleton.has_value())
+			catch (...)
 			{
-				const bool has_additional_joint_set = std::any_of(
-					primitive.attributes.begin(), primitive.attributes.end(), [](const auto& attribute)
-				{
-					const auto& semantic = attribute.first;
-					return (semantic.starts_with("JOINTS_") && semantic != "JOINTS_0")
-						|| (semantic.starts_with("WEIGHTS_") && semantic != "WEIGHTS_0");
-				});
-				if (has_additional_joint_set)
-					throw ResourceLoadError(
-						"ResourceLoader: skinned primitive exceeds the maximum of 4 bone influences per vertex");
-				if (!GltfImport::has_attribute(primitive, "JOINTS_0") || !GltfImport::has_attribute(primitive, "WEIGHTS_0"))
-					throw ResourceLoadError("ResourceLoader: skinned primitive is missing JOINTS_0 or WEIGHTS_0");
-				auto joints = GltfImport::read_vec4(model, primitive.attributes.at("JOINTS_0"), false);
-				auto weights = GltfImport::read_vec4(model, primitive.attributes.at("WEIGHTS_0"));
-				if (joints.size() != positions.size() || weights.size() != positions.size())
-					throw ResourceLoadError("ResourceLoader: skinned vertex attribute counts differ");
-				if (textured)
-				{
-					if (generated_tangents)
-						mesh = std::make_unique<SkinnedMesh>(load_skinned_vertices(
-							positions, normals, texcoords, *generated_tangents, joints, weights),
-							std::move(generated_tangents->indices));
-					else
-						mesh = std::make_unique<SkinnedMesh>(load_skinned_vertices(
-							positions, normals, texcoords, tangents, joints, weights),
-							std::move(indices));
-					renderable.pipeline_render_type = ERenderType::SKINNED;
-				}
-				else
-				{
-					const std::vector<glm::vec2> empty_texcoords(
-						positions.size(), glm::vec2(0.0f));
-					const std::vector<glm::vec4> empty_tangents(
-						positions.size(), glm::vec4(0.0f));
-					mesh = std::make_unique<SkinnedMesh>(load_skinned_vertices(
-						positions, normals, empty_texcoords, empty_tangents, joints, weights),
-						std::move(indices));
-					renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
-				}
+				errors[job] = std::current_exception();
 			}
+		}
+	});
+	for (const auto& error : errors)
+		if (error)
+			std::rethrow_exception(error);
+
+	for (size_t texture = 0; texture < textures.size(); ++texture)
+		imported.textures.push_back({
+			.image_index = texture_sources[texture].image_index, .texture = std::move(*textures[texture]) });
+	for (size_t primitive = 0; primitive < primitives.size(); ++primitive)
+	{
+		imported.nodes[primitive_jobs[primitive].node].primitives.push_back(std::move(primitives[primitive]));
+		std::ranges::move(primitive_warnings[primitive], std::back_inserter(warnings));
+	}
+	if (imported.nodes.empty())
+		add_warning(warnings, options, "ResourceLoader: selected scene contains no mesh nodes");
+	return imported;
+}
+
+std::optional<PbrMaterial::TextureBinding>& get_texture_slot(
+	PbrMaterial::TextureSlots& slots,
+	const ETextureSemantic semantic)
+{
+	switch (semantic)
+	{
+	case ETextureSemantic::BASE_COLOR:
+		return slots.base_color;
+	case ETextureSemantic::METALLIC_ROUGHNESS:
+		return slots.metallic_roughness;
+	case ETextureSemantic::NORMAL:
+		return slots.normal;
+	case ETextureSemantic::EMISSIVE:
+		return slots.emissive;
+	default:
+		throw ResourceLoadError("ResourceLoader: invalid texture semantic");
+	}
+}
+
+// Adds an imported model's resources to the ECS. Every primitive of a glTF
+// material shares one PbrMaterial, and every material sampling an image with
+// the same semantic shares one TextureMaterial.
+ResourceLoader::LoadedModel instantiate_model(
+	ECS& ecs,
+	ImportedModel& imported,
+	const std::string& provenance_source,
+	const ResourceLoader::LoadOptions& options)
+{
+	auto& materials = ecs.get_material_system();
+	std::vector<MaterialHandle> texture_owners(imported.textures.size());
+	// The PbrMaterial first, then its textures
+	std::unordered_map<int, std::vector<MaterialHandle>> material_owners;
+	const auto add_material = [&](const int material_index)
+	{
+		const auto& material = imported.materials.at(material_index);
+		PbrMaterial::TextureSlots slots;
+		std::vector<MaterialHandle> owners;
+		for (size_t semantic = 0; semantic < material.slots.size(); ++semantic)
+		{
+			const auto& slot = material.slots[semantic];
+			if (slot.texture < 0)
+				continue;
+			auto& texture_owner = texture_owners.at(slot.texture);
+			if (!texture_owner)
+				texture_owner = materials.add(std::make_unique<TextureMaterial>(
+					std::move(imported.textures[slot.texture].texture)));
+			get_texture_slot(slots, static_cast<ETextureSemantic>(semantic)) =
+				PbrMaterial::TextureBinding{ texture_owner->get_id(), slot.sampler };
+			owners.push_back(texture_owner);
+		}
+		owners.insert(owners.begin(), materials.add(std::make_unique<PbrMaterial>(
+			material.base_color_factor,
+			material.metallic_factor,
+			material.roughness_factor,
+			std::move(slots),
+			material.normal_scale,
+			material.properties)));
+		return owners;
+	};
+
+	ResourceLoader::LoadedModel result;
+	result.warnings = std::move(imported.warnings);
+	for (auto& node : imported.nodes)
+	{
+		ResourceLoader::LoadedMesh loaded_mesh;
+		loaded_mesh.name = node.name;
+		loaded_mesh.source_node = node.source_node;
+		loaded_mesh.source_skin = node.source_skin;
+		if (node.source_skin >= 0)
+		{
+			const SkeletonID skeleton = ecs.add_skeleton(imported.skins.at(node.source_skin));
+			ResourceProvenance::register_skeleton(skeleton, {
+				.source = provenance_source, .scene = imported.scene_index, .node = node.source_node,
+				.skin = node.source_skin });
+			loaded_mesh.skeleton_id = skeleton;
+		}
+
+		for (size_t primitive_index = 0; primitive_index < node.primitives.size(); ++primitive_index)
+		{
+			auto& primitive = node.primitives[primitive_index];
+			Renderable renderable;
+			renderable.name = loaded_mesh.name;
+			renderable.pipeline_render_type = primitive.render_type;
+			if (primitive.material < 0)
+				renderable.material_owners.push_back(materials.add(std::make_unique<PbrMaterial>()));
 			else
 			{
-				if (textured)
-				{
-					if (generated_tangents)
-						mesh = std::make_unique<TexMesh>(load_tex_vertices(
-							positions, normals, texcoords, *generated_tangents),
-							std::move(generated_tangents->indices));
-					else
-						mesh = std::make_unique<TexMesh>(load_tex_vertices(
-							positions, normals, texcoords, tangents), std::move(indices));
-					renderable.pipeline_render_type = ERenderType::STANDARD;
-				}
-				else
-				{
-					mesh = std::make_unique<ColorMesh>(
-						load_color_vertices(positions, normals), std::move(indices));
-					renderable.pipeline_render_type = ERenderType::COLOR;
-				}
+				auto owners = material_owners.find(primitive.material);
+				if (owners == material_owners.end())
+					owners = material_owners.emplace(primitive.material, add_material(primitive.material)).first;
+				renderable.material_owners = owners->second;
 			}
-			renderable.mesh_owner = ecs.get_mesh_system().add(std::move(mesh));
+
+			renderable.mesh_owner = ecs.get_mesh_system().add(std::move(primitive.mesh));
+			if (options.prefetch_pick_data)
+				renderable.mesh_owner->get().prefetch_pick_data();
 			const auto mesh_id = renderable.mesh_owner->get_id();
 			ResourceProvenance::register_mesh(mesh_id, {
-				.source = provenance_source, .scene = scene_index, .node = instance.node_index,
-				.primitive = static_cast<int>(primitive_index), .material = primitive.material, .skin = node.skin });
-			ResourceProvenance::register_material(loaded_material.ids.front(), {
-				.source = provenance_source, .scene = scene_index, .material = primitive.material });
-			for (const auto& [material_id, image_index] : loaded_material.image_sources)
+				.source = provenance_source, .scene = imported.scene_index, .node = node.source_node,
+				.primitive = static_cast<int>(primitive_index), .material = primitive.material,
+				.skin = node.source_skin });
+			ResourceProvenance::register_material(renderable.material_owners.front()->get_id(), {
+				.source = provenance_source, .scene = imported.scene_index, .material = primitive.material });
+			if (primitive.material >= 0)
 			{
-				const auto* texture = dynamic_cast<const TextureMaterial*>(
-					&ecs.get_material_system().get(material_id));
-				if (!texture)
-					throw ResourceLoadError("ResourceLoader: cached glTF texture has the wrong type");
-				ResourceProvenance::register_material(material_id, {
-					.source = provenance_source, .scene = scene_index,
-					.image = image_index,
-					.texture_semantic = static_cast<int>(texture->semantic) });
+				for (const auto& slot : imported.materials.at(primitive.material).slots)
+				{
+					if (slot.texture < 0)
+						continue;
+					const auto& texture = static_cast<const TextureMaterial&>(
+						texture_owners[slot.texture]->get());
+					ResourceProvenance::register_material(texture.get_id(), {
+						.source = provenance_source, .scene = imported.scene_index,
+						.image = imported.textures[slot.texture].image_index,
+						.texture_semantic = static_cast<int>(texture.semantic) });
+				}
 			}
-			renderable.material_owners = std::move(material_owners);
-			renderable.local_transform.set_mat4(instance.world_transform);
+			renderable.local_transform.set_mat4(node.world_transform);
 			loaded_mesh.renderables.push_back(std::move(renderable));
 		}
 		result.meshes.push_back(std::move(loaded_mesh));
 	}
-	if (result.meshes.empty())
-		add_warning(result, options, "ResourceLoader: selected scene contains no mesh nodes");
 	return result;
+}
+
+// Reads the model from the derived-data cache, or imports it and caches it
+ImportedModel import_model(
+	const std::filesystem::path& file_path,
+	const ResourceLoader::LoadOptions& options,
+	const std::shared_ptr<DerivedDataCache>& cache,
+	TaskPool& pool)
+{
+	const auto source_hash = cache ? DerivedDataCache::hash_file(file_path) : std::nullopt;
+	if (source_hash)
+		if (auto cached = read_cached_model(*cache, file_path, *source_hash, options))
+			return std::move(*cached);
+	const auto document = load_gltf_document(file_path);
+	auto imported = import_gltf_model(document, options, pool);
+	if (source_hash)
+		store_cached_model(*cache, file_path, *source_hash, document.model, imported, options);
+	return imported;
+}
+
+template<typename Function>
+auto report_invalid_indices(const Function& function)
+{
+	try
+	{
+		return function();
 	}
 	catch (const std::out_of_range& error)
 	{
@@ -520,6 +728,70 @@ ResourceLoader::LoadedModel ResourceLoader::load_model(
 			"ResourceLoader: resource contains an invalid index: {}", error.what()));
 	}
 }
+}
+
+struct ResourceLoader::PendingModel::Import
+{
+	ECS* ecs;
+	std::string filename;
+	LoadOptions options;
+	std::shared_ptr<DerivedDataCache> cache;
+	TaskPool* pool;
+	// Claimed by the pool task or by get(), whichever comes first, so get()
+	// never runs unrelated queued tasks while it waits
+	std::atomic_flag claimed;
+	std::promise<ImportedModel> promise;
+	std::future<ImportedModel> imported = promise.get_future();
+
+	void run()
+	{
+		if (claimed.test_and_set())
+			return;
+		try
+		{
+			promise.set_value(report_invalid_indices([&]()
+			{
+				return import_model(resolve_resource_filename(filename, Utility::get_model), options, cache, *pool);
+			}));
+		}
+		catch (...)
+		{
+			promise.set_exception(std::current_exception());
+		}
+	}
+};
+
+bool ResourceLoader::PendingModel::is_ready() const
+{
+	return import->imported.valid()
+		&& import->imported.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+ResourceLoader::LoadedModel ResourceLoader::PendingModel::get()
+{
+	if (!import->imported.valid())
+		throw std::logic_error("ResourceLoader::PendingModel::get: model was already collected");
+	// imports here if no worker has started it yet
+	import->run();
+	auto imported = import->imported.get();
+	return report_invalid_indices([&]()
+	{
+		return instantiate_model(*import->ecs, imported, import->filename, import->options);
+	});
+}
+
+ResourceLoader::LoadedModel ResourceLoader::load_model(
+	ECS& ecs,
+	const std::string_view filename,
+	const LoadOptions& options)
+{
+	return report_invalid_indices([&]()
+	{
+		auto imported = import_model(resolve_resource_filename(filename, Utility::get_model),
+			options, get_derived_data_cache(), TaskPool::get_shared());
+		return instantiate_model(ecs, imported, std::string(filename), options);
+	});
+}
 
 ResourceLoader::LoadedModel ResourceLoader::load_model(ECS& ecs, const std::string_view filename)
 {
@@ -528,6 +800,37 @@ ResourceLoader::LoadedModel ResourceLoader::load_model(ECS& ecs, const std::stri
 	return load_model(ecs, filename, options);
 }
 
+ResourceLoader::PendingModel ResourceLoader::load_model_async(ECS& ecs, const std::string_view filename)
+{
+	LoadOptions options;
+	options.generate_missing_tangents = true;
+	return load_model_async(ecs, filename, options);
+}
+
+ResourceLoader::PendingModel ResourceLoader::load_model_async(
+	ECS& ecs,
+	const std::string_view filename,
+	const LoadOptions& options)
+{
+	return load_model_async(ecs, filename, options, TaskPool::get_shared());
+}
+
+ResourceLoader::PendingModel ResourceLoader::load_model_async(
+	ECS& ecs,
+	const std::string_view filename,
+	const LoadOptions& options,
+	TaskPool& pool)
+{
+	auto import = std::make_shared<PendingModel::Import>();
+	import->ecs = &ecs;
+	import->filename = std::string(filename);
+	import->options = options;
+	import->cache = get_derived_data_cache();
+	import->pool = &pool;
+	pool.submit([import]() { import->run(); });
+	return PendingModel(std::move(import));
+}
+
 ResourceLoader::LoadedAnimations ResourceLoader::load_animations(
 	ECS& ecs,
 	const std::string_view filename,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderable/material.hpp"
+#include "renderable/texture_processor.hpp"
 #include "entity_component_system/skeletal.hpp"
 #include "renderable/renderable.hpp"
 
@@ -14,20 +15,17 @@
 #include <memory>
 #include <optional>
 #include <filesystem>
+#include <mutex>
 #include <stdexcept>
 
 
 class Object;
 class ECS;
+class DerivedDataCache;
+class TaskPool;
 struct SkeletalComponent;
 struct TextureData;
 
-namespace tinygltf
-{
-	class Model;
-	class Primitive;
-}
-
 class ResourceLoadError : public std::runtime_error
 {
 public:
@@ -69,6 +67,13 @@ public:
 		bool generate_missing_tangents = false;
 		bool allow_non_triangle_primitives = true;
 		bool strict = false;
+		// Builds mesh pick data on the shared task pool instead of on first pick
+		bool prefetch_pick_data = false;
+		// Applies to decoded images; DDS textures keep their authored levels
+		ETextureProcessing texture_processing = ETextureProcessing::DEFAULT;
+		// Reads the model from the derived-data cache, if one is set, and
+		// stores it there on a miss, pick data included
+		bool use_derived_data_cache = true;
 	};
 
 	// Complete result of importing one model scene. It owns the imported
@@ -87,37 +92,57 @@ public:
 		std::vector<ImportWarning> warnings;
 	};
 
+	// A model importing on a task pool. Nothing is added to the ECS until
+	// get() is called, on the thread that owns the ECS.
+	class PendingModel
+	{
+	public:
+		bool is_ready() const;
+		// Waits for the import, or runs it here if no worker has started it,
+		// then adds the model to the ECS. Runs no other pool task. Throws
+		// ResourceLoadError as load_model does. May only be called once.
+		LoadedModel get();
+
+	private:
+		friend class ResourceLoader;
+		struct Import;
+		explicit PendingModel(std::shared_ptr<Import> import) : import(std::move(import)) {}
+
+		std::shared_ptr<Import> import;
+	};
+
 	static MaterialHandle fetch_texture(
 		MaterialSystem& materials,
 		std::string_view logical_resource_name,
-		ETextureSemantic semantic = ETextureSemantic::BASE_COLOR);
+		ETextureSemantic semantic = ETextureSemantic::BASE_COLOR,
+		ETextureProcessing processing = ETextureProcessing::DEFAULT);
 	static LoadedModel load_model(ECS& ecs, std::string_view filename);
 	static LoadedModel load_model(ECS& ecs, std::string_view filename, const LoadOptions& options);
+	// Parses the file, decodes its images and builds its primitives on the
+	// pool, or on the shared pool, while the caller carries on
+	static PendingModel load_model_async(ECS& ecs, std::string_view filename);
+	static PendingModel load_model_async(ECS& ecs, std::string_view filename, const LoadOptions& options);
+	static PendingModel load_model_async(
+		ECS& ecs, std::string_view filename, const LoadOptions& options, TaskPool& pool);
 	static LoadedAnimations load_animations(ECS& ecs, std::string_view filename, SkeletonID target_skeleton);
 
-private:
-	struct LoadedMaterial
-	{
-		MatVec ids;
-		std::vector<std::pair<MaterialID, int>> image_sources;
-	};
+	// Imported models are cached here, keyed by the contents of their sources
+	// and the load options that affect them; nullptr disables caching. Safe to
+	// call while models are importing; imports already started keep the cache
+	// they began with.
+	static void set_derived_data_cache(std::shared_ptr<DerivedDataCache> cache);
+	static std::shared_ptr<DerivedDataCache> get_derived_data_cache();
 
-	MaterialHandle load_texture(
+private:
+	static MaterialHandle load_texture(
 		MaterialSystem& materials,
 		// Resolved filesystem path used to read the texture data.
 		const std::filesystem::path& resolved_file_path,
 		// Caller-facing name retained as TextureMaterial provenance.
 		std::string_view logical_resource_name,
-		ETextureSemantic semantic);
-	LoadedMaterial load_material(
-		MaterialSystem& materials,
-		const tinygltf::Primitive& primitive,
-		const tinygltf::Model& model,
-		std::vector<MaterialHandle>& owners);
-
-private:
-	std::unordered_map<int, LoadedMaterial> gltf_material_to_material;
-	std::unordered_map<uint64_t, MaterialID> gltf_image_to_material;
+		ETextureSemantic semantic,
+		ETextureProcessing processing);
 
-	static ResourceLoader global_resource_loader;
+	static std::mutex derived_data_cache_mutex;
+	static std::shared_ptr<DerivedDataCache> derived_data_cache;
 };
@@ -0,0 +1,489 @@
+#include "resource_loader.hpp"
+#include "imported_model.hpp"
+#include "derived_data_cache.hpp"
+#include "utility.hpp"
+
+#include <tiny_gltf.h>
+#include <quill/LogMacros.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+namespace
+{
+// Bump whenever import or texture processing changes what a model derives to
+constexpr uint64_t MODEL_CACHE_VERSION = 1;
+
+class CacheWriter
+{
+public:
+	template<typename T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	void write_string(const std::string_view text)
+	{
+		write(static_cast<uint32_t>(text.size()));
+		const auto* bytes = reinterpret_cast<const std::byte*>(text.data());
+		data.insert(data.end(), bytes, bytes + text.size());
+	}
+
+	std::vector<std::byte> data;
+};
+
+class CacheReader
+{
+public:
+	explicit CacheReader(const std::span<const std::byte> data) : data(data) {}
+
+	template<typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value;
+		std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+		return value;
+	}
+
+	std::string read_string()
+	{
+		const auto bytes = take(read<uint32_t>());
+		return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	// Reads a count of items each taking at least item_size bytes, so that
+	// corrupt counts fail here instead of in a huge allocation
+	uint32_t read_count(const size_t item_size)
+	{
+		const auto count = read<uint32_t>();
+		if (count > (data.size() - offset) / item_size)
+			throw std::runtime_error("count exceeds the remaining data");
+		return count;
+	}
+
+private:
+	std::span<const std::byte> take(const size_t size)
+	{
+		if (size > data.size() - offset)
+			throw std::runtime_error("data is truncated");
+		offset += size;
+		return data.subspan(offset - size, size);
+	}
+
+	std::span<const std::byte> data;
+	size_t offset = 0;
+};
+
+// Texture levels used in place in the mapped cache entry, which stays mapped
+// while any of its textures are alive
+struct MappedTextureData final : TextureData
+{
+	MappedTextureData(std::shared_ptr<const DerivedDataCache::Entry> entry, const std::span<const std::byte> levels) :
+		entry(std::move(entry)),
+		// entries are mapped copy-on-write, so writes stay private to this process
+		levels(const_cast<std::byte*>(levels.data()))
+	{
+	}
+
+	std::byte* get() override { return levels; }
+
+private:
+	std::shared_ptr<const DerivedDataCache::Entry> entry;
+	std::byte* levels;
+};
+
+std::string decode_uri(const std::string_view uri)
+{
+	std::string decoded;
+	decoded.reserve(uri.size());
+	for (size_t index = 0; index < uri.size(); ++index)
+	{
+		if (uri[index] == '%' && index + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[index + 1]))
+			&& std::isxdigit(static_cast<unsigned char>(uri[index + 2])))
+		{
+			decoded.push_back(static_cast<char>(std::stoi(std::string(uri.substr(index + 1, 2)), nullptr, 16)));
+			index += 2;
+		}
+		else
+			decoded.push_back(uri[index]);
+	}
+	return decoded;
+}
+
+// The files besides the glTF document that a model's derived data depends on
+std::vector<std::string> get_external_uris(const tinygltf::Model& model)
+{
+	std::vector<std::string> uris;
+	const auto add = [&uris](const std::string& uri)
+	{
+		if (!uri.empty() && !uri.starts_with("data:") && std::ranges::find(uris, uri) == uris.end())
+			uris.push_back(uri);
+	};
+	for (const auto& buffer : model.buffers)
+		add(buffer.uri);
+	for (const auto& image : model.images)
+		add(image.uri);
+	return uris;
+}
+
+DerivedDataCache::Key get_manifest_key(const DerivedDataCache::Key& source_hash)
+{
+	return DerivedDataCache::KeyBuilder().add("model sources").add(MODEL_CACHE_VERSION).add(source_hash).build();
+}
+
+// std::nullopt if an external file cannot be read
+std::optional<DerivedDataCache::Key> get_model_key(
+	const std::filesystem::path& file_path,
+	const DerivedDataCache::Key& source_hash,
+	const std::vector<std::string>& external_uris,
+	const ResourceLoader::LoadOptions& options)
+{
+	DerivedDataCache::KeyBuilder builder;
+	builder.add("model").add(MODEL_CACHE_VERSION).add(source_hash);
+	for (const auto& uri : external_uris)
+	{
+		const auto hash = DerivedDataCache::hash_file(file_path.parent_path() / decode_uri(uri));
+		if (!hash)
+			return std::nullopt;
+		builder.add(uri).add(*hash);
+	}
+	builder.add(static_cast<uint64_t>(options.scene_index.has_value()))
+		.add(static_cast<uint64_t>(options.scene_index.value_or(0)))
+		.add(static_cast<uint64_t>(options.generate_missing_normals))
+		.add(static_cast<uint64_t>(options.generate_missing_tangents))
+		.add(static_cast<uint64_t>(options.allow_non_triangle_primitives))
+		.add(static_cast<uint64_t>(options.strict))
+		.add(static_cast<uint64_t>(options.texture_processing));
+	return builder.build();
+}
+
+template<typename T>
+std::span<const std::byte> as_section(const std::vector<T>& values)
+{
+	return std::as_bytes(std::span(values));
+}
+
+template<typename T>
+std::vector<T> read_section(const DerivedDataCache::Entry& entry, const uint32_t section)
+{
+	const auto bytes = entry.get_section(section);
+	if (bytes.size() % sizeof(T) != 0)
+		throw std::runtime_error("section size does not match its contents");
+	std::vector<T> values(bytes.size() / sizeof(T));
+	std::memcpy(values.data(), bytes.data(), bytes.size());
+	return values;
+}
+
+template<typename MeshType>
+MeshPtr read_mesh(const DerivedDataCache::Entry& entry, const uint32_t vertex_section, const uint32_t index_section)
+{
+	auto vertices = read_section<typename MeshType::VertexType>(entry, vertex_section);
+	auto indices = read_section<uint32_t>(entry, index_section);
+	if (std::ranges::any_of(indices, [&vertices](const uint32_t index) { return index >= vertices.size(); }))
+		throw std::runtime_error("mesh index references a missing vertex");
+	return std::make_unique<MeshType>(std::move(vertices), std::move(indices));
+}
+
+void write_transform(CacheWriter& writer, const Maths::Transform& transform)
+{
+	writer.write(transform.get_mat4());
+}
+
+Maths::Transform read_transform(CacheReader& reader)
+{
+	Maths::Transform transform;
+	transform.set_mat4(reader.read<glm::mat4>());
+	return transform;
+}
+
+// Everything but the bulk data goes into the last section, which refers to
+// the other sections by index. Textures and meshes are stored as loaded, and
+// each mesh with the BVH of its pick data.
+void store_cached_model(
+	DerivedDataCache& cache,
+	const std::filesystem::path& file_path,
+	const DerivedDataCache::Key& source_hash,
+	const tinygltf::Model& model,
+	const ImportedModel& imported,
+	const ResourceLoader::LoadOptions& options)
+{
+	const auto external_uris = get_external_uris(model);
+	const auto key = get_model_key(file_path, source_hash, external_uris, options);
+	if (!key)
+		return;
+
+	for (const auto& node : imported.nodes)
+		for (const auto& primitive : node.primitives)
+			primitive.mesh->prefetch_pick_data();
+
+	DerivedDataCache::EntryWriter entry;
+	CacheWriter header;
+	header.write(static_cast<int32_t>(imported.scene_index));
+	header.write(static_cast<uint32_t>(imported.warnings.size()));
+	for (const auto& warning : imported.warnings)
+		header.write_string(warning.message);
+
+	header.write(static_cast<uint32_t>(imported.skins.size()));
+	for (const auto& [skin_index, bones] : imported.skins)
+	{
+		header.write(static_cast<int32_t>(skin_index));
+		header.write(static_cast<uint32_t>(bones.size()));
+		for (const auto& bone : bones)
+		{
+			write_transform(header, bone.original_transform);
+			write_transform(header, bone.relative_transform);
+			write_transform(header, bone.inverse_bind_pose);
+			header.write_string(bone.name);
+			header.write(bone.parent_node);
+		}
+	}
+
+	header.write(static_cast<uint32_t>(imported.materials.size()));
+	for (const auto& [material_index, material] : imported.materials)
+	{
+		header.write(static_cast<int32_t>(material_index));
+		header.write(material.base_color_factor);
+		header.write(material.metallic_factor);
+		header.write(material.roughness_factor);
+		header.write(material.normal_scale);
+		header.write(static_cast<uint32_t>(material.properties.alpha_mode));
+		header.write(material.properties.alpha_cutoff);
+		header.write(static_cast<uint8_t>(material.properties.double_sided));
+		header.write(material.properties.emissive_factor);
+		for (const auto& slot : material.slots)
+		{
+			header.write(static_cast<int32_t>(slot.texture));
+			header.write(static_cast<uint32_t>(slot.sampler.address_mode));
+			header.write(static_cast<uint32_t>(slot.sampler.mipmap_mode));
+		}
+	}
+
+	header.write(static_cast<uint32_t>(imported.textures.size()));
+	for (const auto& [image_index, texture] : imported.textures)
+	{
+		header.write(static_cast<int32_t>(image_index));
+		header.write(static_cast<uint32_t>(texture.semantic));
+		header.write(texture.width);
+		header.write(texture.height);
+		header.write(texture.channels);
+		header.write(static_cast<uint32_t>(texture.format));
+		header.write_string(texture.source);
+		header.write(static_cast<uint32_t>(texture.mip_sizes.size()));
+		for (const size_t size : texture.mip_sizes)
+			header.write(static_cast<uint64_t>(size));
+		header.write(entry.add_section(std::span<const std::byte>(texture.data->get(), texture.data_len)));
+	}
+
+	header.write(static_cast<uint32_t>(imported.nodes.size()));
+	for (const auto& node : imported.nodes)
+	{
+		header.write_string(node.name);
+		header.write(static_cast<int32_t>(node.source_node));
+		header.write(static_cast<int32_t>(node.source_skin));
+		header.write(node.world_transform);
+		header.write(static_cast<uint32_t>(node.primitives.size()));
+		for (const auto& primitive : node.primitives)
+		{
+			const auto& mesh = *primitive.mesh;
+			const auto& pick_data = mesh.get_pick_data();
+			header.write(static_cast<uint32_t>(primitive.render_type));
+			header.write(static_cast<int32_t>(primitive.material));
+			header.write(entry.add_section(std::span(mesh.get_vertices_data(), mesh.get_vertices_data_size())));
+			header.write(entry.add_section(std::span(mesh.get_indices_data(), mesh.get_indices_data_size())));
+			header.write(entry.add_section(as_section(pick_data.get_triangles())));
+			header.write(entry.add_section(as_section(pick_data.get_nodes())));
+		}
+	}
+	entry.add_owned_section(std::move(header.data));
+	if (!cache.store(*key, entry))
+		return;
+
+	const auto manifest_key = get_manifest_key(source_hash);
+	if (cache.contains(manifest_key))
+		return;
+	CacheWriter manifest;
+	manifest.write(static_cast<uint32_t>(external_uris.size()));
+	for (const auto& uri : external_uris)
+		manifest.write_string(uri);
+	DerivedDataCache::EntryWriter manifest_entry;
+	manifest_entry.add_owned_section(std::move(manifest.data));
+	cache.store(manifest_key, manifest_entry);
+}
+
+ImportedModel read_cached_model(const std::shared_ptr<const DerivedDataCache::Entry>& entry)
+{
+	const auto& sections = *entry;
+	if (sections.get_section_count() == 0)
+		throw std::runtime_error("entry has no sections");
+	CacheReader header(sections.get_section(sections.get_section_count() - 1));
+	ImportedModel imported;
+	imported.scene_index = header.read<int32_t>();
+	for (uint32_t count = header.read_count(sizeof(uint32_t)); count > 0; --count)
+		imported.warnings.push_back({ header.read_string() });
+
+	for (uint32_t skin_count = header.read_count(2 * sizeof(uint32_t)); skin_count > 0; --skin_count)
+	{
+		const auto skin_index = header.read<int32_t>();
+		std::vector<Bone> bones(header.read_count(3 * sizeof(glm::mat4)));
+		for (auto& bone : bones)
+		{
+			bone.original_transform = read_transform(header);
+			bone.relative_transform = read_transform(header);
+			bone.inverse_bind_pose = read_transform(header);
+			bone.name = header.read_string();
+			bone.parent_node = header.read<uint32_t>();
+			if (bone.parent_node != Bone::NO_PARENT && bone.parent_node >= bones.size())
+				throw std::runtime_error("bone parent is out of range");
+		}
+		imported.skins.emplace(skin_index, std::move(bones));
+	}
+
+	const auto read_enum = [&header]<typename Enum>(const Enum last)
+	{
+		const auto value = header.read<uint32_t>();
+		if (value > static_cast<uint32_t>(last))
+			throw std::runtime_error("enumeration is out of range");
+		return static_cast<Enum>(value);
+	};
+	const uint32_t material_count = header.read_count(sizeof(int32_t));
+	for (uint32_t material_number = 0; material_number < material_count; ++material_number)
+	{
+		const auto material_index = header.read<int32_t>();
+		ImportedMaterial material;
+		material.base_color_factor = header.read<glm::vec4>();
+		material.metallic_factor = header.read<float>();
+		material.roughness_factor = header.read<float>();
+		material.normal_scale = header.read<float>();
+		material.properties.alpha_mode = read_enum(EAlphaMode::BLEND);
+		material.properties.alpha_cutoff = header.read<float>();
+		material.properties.double_sided = header.read<uint8_t>() != 0;
+		material.properties.emissive_factor = header.read<glm::vec3>();
+		for (auto& slot : material.slots)
+		{
+			slot.texture = header.read<int32_t>();
+			slot.sampler.address_mode = read_enum(PbrMaterial::TextureSampler::AddressMode::CLAMP_TO_EDGE);
+			slot.sampler.mipmap_mode = read_enum(PbrMaterial::TextureSampler::MipmapMode::LINEAR);
+		}
+		imported.materials.emplace(material_index, material);
+	}
+
+	const uint32_t texture_count = header.read_count(sizeof(int32_t));
+	for (uint32_t texture_index = 0; texture_index < texture_count; ++texture_index)
+	{
+		ImportedTexture imported_texture;
+		imported_texture.image_index = header.read<int32_t>();
+		auto& texture = imported_texture.texture;
+		const auto semantic = header.read<uint32_t>();
+		if (semantic >= static_cast<uint32_t>(ETextureSemantic::COUNT))
+			throw std::runtime_error("texture semantic is out of range");
+		texture.semantic = static_cast<ETextureSemantic>(semantic);
+		texture.width = header.read<uint32_t>();
+		texture.height = header.read<uint32_t>();
+		texture.channels = header.read<uint32_t>();
+		texture.format = read_enum(ETextureFormat::BC7);
+		texture.source = header.read_string();
+		for (uint32_t level = header.read_count(sizeof(uint64_t)); level > 0; --level)
+		{
+			texture.mip_sizes.push_back(static_cast<size_t>(header.read<uint64_t>()));
+			texture.data_len += texture.mip_sizes.back();
+		}
+		const auto levels = sections.get_section(header.read<uint32_t>());
+		if (texture.mip_sizes.empty() || levels.size() != texture.data_len)
+			throw std::runtime_error("texture levels do not match their section");
+		texture.data = std::make_unique<MappedTextureData>(entry, levels);
+		imported.textures.push_back(std::move(imported_texture));
+	}
+	for (const auto& [material_index, material] : imported.materials)
+		for (const auto& slot : material.slots)
+			if (slot.texture >= static_cast<int>(imported.textures.size()))
+				throw std::runtime_error("material references a missing texture");
+
+	for (uint32_t node_count = header.read_count(sizeof(uint32_t)); node_count > 0; --node_count)
+	{
+		ImportedNode node;
+		node.name = header.read_string();
+		node.source_node = header.read<int32_t>();
+		node.source_skin = header.read<int32_t>();
+		if (node.source_skin >= 0 && !imported.skins.contains(node.source_skin))
+			throw std::runtime_error("node references a missing skin");
+		node.world_transform = header.read<glm::mat4>();
+		for (uint32_t primitive_count = header.read_count(6 * sizeof(uint32_t)); primitive_count > 0; --primitive_count)
+		{
+			ImportedPrimitive primitive;
+			primitive.render_type = static_cast<ERenderType>(header.read<uint32_t>());
+			primitive.material = header.read<int32_t>();
+			if (primitive.material >= 0 && !imported.materials.contains(primitive.material))
+				throw std::runtime_error("primitive references a missing material");
+			const auto vertex_section = header.read<uint32_t>();
+			const auto index_section = header.read<uint32_t>();
+			switch (primitive.render_type)
+			{
+			case ERenderType::COLOR:
+				primitive.mesh = read_mesh<ColorMesh>(sections, vertex_section, index_section);
+				break;
+			case ERenderType::STANDARD:
+				primitive.mesh = read_mesh<TexMesh>(sections, vertex_section, index_section);
+				break;
+			case ERenderType::SKINNED:
+			case ERenderType::SKINNED_COLOR:
+				primitive.mesh = read_mesh<SkinnedMesh>(sections, vertex_section, index_section);
+				break;
+			default:
+				throw std::runtime_error("primitive has an unexpected render type");
+			}
+			auto triangles = read_section<MeshPickTriangle>(sections, header.read<uint32_t>());
+			auto bvh_nodes = read_section<MeshBvhNode>(sections, header.read<uint32_t>());
+			primitive.mesh->restore_pick_data(std::move(triangles), std::move(bvh_nodes));
+			node.primitives.push_back(std::move(primitive));
+		}
+		imported.nodes.push_back(std::move(node));
+	}
+	return imported;
+}
+
+// std::nullopt on a miss, including when an external file has changed since
+// the model was stored
+std::optional<ImportedModel> read_cached_model(
+	DerivedDataCache& cache,
+	const std::filesystem::path& file_path,
+	const DerivedDataCache::Key& source_hash,
+	const ResourceLoader::LoadOptions& options)
+{
+	const auto manifest = cache.find(get_manifest_key(source_hash));
+	if (!manifest)
+		return std::nullopt;
+	try
+	{
+		CacheReader reader(manifest->get_section(0));
+		std::vector<std::string> external_uris(reader.read_count(sizeof(uint32_t)));
+		for (auto& uri : external_uris)
+			uri = reader.read_string();
+		const auto key = get_model_key(file_path, source_hash, external_uris, options);
+		if (!key)
+			return std::nullopt;
+		const auto entry = cache.find(*key);
+		if (!entry)
+			return std::nullopt;
+		return read_cached_model(entry);
+	}
+	catch (const std::exception& error)
+	{
+		LOG_WARNING(Utility::get_logger(), "ResourceLoader: ignoring unreadable cached model '{}': {}",
+			file_path.string(), error.what());
+		return std::nullopt;
+	}
+}
+}
@@ -1,6 +1,8 @@
 #include "resource_loader.hpp"
+#include "imported_model.hpp"
 #include "renderable/material.hpp"
 #include "entity_component_system/material_system.hpp"
+#include "task_pool.hpp"
 
 #include <stb_image.h>
 #include <tiny_gltf.h>
@@ -154,20 +156,11 @@ bool load_gltf_image_data(
 	{
 		image->mimeType = "application/x-krisp-unsupported-image";
 		image->as_is = true;
-		image->image.assign(bytes, bytes + byte_count);
-		return true;
 	}
-
-	return tinygltf::LoadImageData(
-		image,
-		image_index,
-		error,
-		warning,
-		requested_width,
-		requested_height,
-		bytes,
-		byte_count,
-		user_data);
+	// PNG and JPEG stay encoded until convert_gltf_image, which decodes the
+	// images a scene uses in parallel
+	image->image.assign(bytes, bytes + byte_count);
+	return true;
 }
 
 namespace
@@ -496,160 +489,147 @@ void validate_gltf_materials(
 }
 }
 
-ResourceLoader::LoadedMaterial ResourceLoader::load_material(
-	MaterialSystem& materials,
-	const tinygltf::Primitive& primitive,
-	const tinygltf::Model& model,
-	std::vector<MaterialHandle>& owners)
+// Expands a decoded PNG or JPEG image to RGBA8 and processes it as
+// texture_processing asks
+TextureMaterial convert_gltf_image(
+	const tinygltf::Image& image,
+	const int texture_index,
+	const int image_index,
+	const ETextureSemantic semantic,
+	const ETextureProcessing texture_processing,
+	TaskPool& pool)
 {
-	if (primitive.material >= 0)
-	{
-		if (primitive.material >= static_cast<int>(model.materials.size()))
-			throw ResourceLoadError(fmt::format(
-				"ResourceLoader: primitive references invalid material {}", primitive.material));
-		if (gltf_material_to_material.contains(primitive.material))
-		{
-			const auto& material = gltf_material_to_material.at(primitive.material);
-			for (const auto material_id : material.ids)
-				owners.push_back(materials.acquire(material_id));
-			return material;
-		}
+	if (image.image.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+		throw ResourceLoadError(fmt::format("ResourceLoader: texture {} image is too large", texture_index));
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load_from_memory(
+		image.image.data(), static_cast<int>(image.image.size()), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels)
+		throw ResourceLoadError(fmt::format(
+			"ResourceLoader: texture {} image could not be decoded: {}", texture_index, stbi_failure_reason()));
+
+	TextureMaterial texture;
+	texture.data = std::make_unique<RawTextureDataSTB>(pixels);
+	texture.width = static_cast<uint32_t>(width);
+	texture.height = static_cast<uint32_t>(height);
+	texture.channels = 4;
+	texture.data_len = static_cast<size_t>(texture.width) * texture.height * 4;
+	texture.mip_sizes = {texture.data_len};
+	texture.semantic = semantic;
+	texture.source =
+		image.uri.empty() ? fmt::format("glTF image {}", image_index) : image.uri;
+	if (texture_processing == ETextureProcessing::DEFAULT)
+		TextureProcessor::process(texture, {}, pool);
+	return texture;
+}
 
-		const auto& mat = model.materials[primitive.material];
-		const auto& pbr = mat.pbrMetallicRoughness;
-		PbrMaterial::TextureSlots slots;
-		std::vector<MaterialHandle> texture_owners;
-		std::vector<std::pair<MaterialID, int>> image_sources;
-		const auto load_gltf_texture = [&](const auto &texture_info, const ETextureSemantic semantic) {
-			const int texture_index = texture_info.index;
-			const auto &texture = model.textures.at(texture_index);
-			const auto resolved =
-				resolve_gltf_texture(model, texture, texture_index, gltf_material_label(mat, primitive.material));
-			const uint64_t cache_key =
-				static_cast<uint64_t>(resolved.image_index) * static_cast<uint64_t>(ETextureSemantic::COUNT) +
-				static_cast<uint64_t>(semantic);
-			MaterialHandle owner;
-			if (gltf_image_to_material.contains(cache_key))
-			{
-				owner = materials.acquire(gltf_image_to_material.at(cache_key));
-			}
-			else
-			{
-				const auto &image = model.images.at(resolved.image_index);
-				if (resolved.dds)
-				{
-					auto loaded = load_dds_texture_data(
-						image.image.data(), image.image.size(),
-						image.uri.empty() ? fmt::format("glTF image {}", resolved.image_index) : image.uri);
-					loaded.semantic = semantic;
-					owner = materials.add(std::make_unique<TextureMaterial>(std::move(loaded)));
-				}
-				else
-				{
-					if (image.width <= 0 || image.height <= 0 || image.component < 1 || image.component > 4 ||
-					    image.bits != 8)
-						throw ResourceLoadError(fmt::format(
-							"ResourceLoader: texture {} has unsupported image dimensions or channels", texture_index));
-					if (static_cast<size_t>(image.width) >
-					    std::numeric_limits<size_t>::max() / static_cast<size_t>(image.height))
-						throw ResourceLoadError(fmt::format(
-							"ResourceLoader: texture {} image dimensions overflow address space", texture_index));
-					const size_t pixel_count = static_cast<size_t>(image.width) * static_cast<size_t>(image.height);
-					if (pixel_count > std::numeric_limits<size_t>::max() / 4 ||
-					    image.image.size() < pixel_count * static_cast<size_t>(image.component))
-						throw ResourceLoadError(
-							fmt::format("ResourceLoader: texture {} image data is truncated", texture_index));
-					std::vector<std::byte> rgba(pixel_count * 4);
-					for (size_t pixel = 0; pixel < pixel_count; ++pixel)
-					{
-						const auto *source = image.image.data() + pixel * image.component;
-						auto *destination = rgba.data() + pixel * 4;
-						if (image.component == 1 || image.component == 2)
-							destination[0] = destination[1] = destination[2] = static_cast<std::byte>(source[0]);
-						else
-						{
-							destination[0] = static_cast<std::byte>(source[0]);
-							destination[1] = static_cast<std::byte>(source[1]);
-							destination[2] = static_cast<std::byte>(source[2]);
-						}
-						destination[3] = static_cast<std::byte>(image.component == 2   ? source[1]
-						                                        : image.component == 4 ? source[3]
-						                                                               : 255);
-					}
-					auto texture_material = std::make_unique<TextureMaterial>();
-					texture_material->width = static_cast<uint32_t>(image.width);
-					texture_material->height = static_cast<uint32_t>(image.height);
-					texture_material->channels = 4;
-					texture_material->data_len = rgba.size();
-					texture_material->mip_sizes = {rgba.size()};
-					texture_material->semantic = semantic;
-					texture_material->source =
-						image.uri.empty() ? fmt::format("glTF image {}", resolved.image_index) : image.uri;
-					texture_material->data = std::make_unique<OwnedTextureData>(std::move(rgba));
-					owner = materials.add(std::move(texture_material));
-				}
-				gltf_image_to_material.emplace(cache_key, owner->get_id());
-			}
-			image_sources.emplace_back(owner->get_id(), resolved.image_index);
-			texture_owners.push_back(owner);
-			return PbrMaterial::TextureBinding{owner->get_id(), resolved.sampler};
-		};
+// An image decoded once per semantic for the materials that sample it
+struct GltfTextureSource
+{
+	int texture_index = -1;
+	int image_index = -1;
+	ETextureSemantic semantic = ETextureSemantic::BASE_COLOR;
+	bool dds = false;
+};
 
-		if (pbr.baseColorTexture.index >= 0)
-			slots.base_color = load_gltf_texture(
-				pbr.baseColorTexture, ETextureSemantic::BASE_COLOR);
-		if (pbr.metallicRoughnessTexture.index >= 0)
-			slots.metallic_roughness = load_gltf_texture(
-				pbr.metallicRoughnessTexture, ETextureSemantic::METALLIC_ROUGHNESS);
-		if (mat.normalTexture.index >= 0)
-			slots.normal = load_gltf_texture(mat.normalTexture, ETextureSemantic::NORMAL);
-		if (mat.emissiveTexture.index >= 0)
-			slots.emissive = load_gltf_texture(
-				mat.emissiveTexture, ETextureSemantic::EMISSIVE);
-
-		auto material = std::make_unique<PbrMaterial>(
-			glm::vec4(
-				static_cast<float>(pbr.baseColorFactor[0]),
-				static_cast<float>(pbr.baseColorFactor[1]),
-				static_cast<float>(pbr.baseColorFactor[2]),
-				static_cast<float>(pbr.baseColorFactor[3])),
-			static_cast<float>(pbr.metallicFactor),
-			static_cast<float>(pbr.roughnessFactor),
-			std::move(slots),
-			static_cast<float>(mat.normalTexture.scale),
-			PbrMaterial::Properties{
-				.alpha_mode = gltf_alpha_mode(
-					mat, gltf_material_label(mat, primitive.material)),
-				.alpha_cutoff = static_cast<float>(mat.alphaCutoff),
-				.double_sided = mat.doubleSided,
-				.emissive_factor = glm::vec3(
-					static_cast<float>(mat.emissiveFactor[0]),
-					static_cast<float>(mat.emissiveFactor[1]),
-					static_cast<float>(mat.emissiveFactor[2])),
+TextureMaterial decode_gltf_texture(
+	const tinygltf::Model& model,
+	const GltfTextureSource& source,
+	const ETextureProcessing texture_processing,
+	TaskPool& pool)
+{
+	const auto& image = model.images.at(source.image_index);
+	auto texture = source.dds
+		? load_dds_texture_data(
+			image.image.data(), image.image.size(),
+			image.uri.empty() ? fmt::format("glTF image {}", source.image_index) : image.uri)
+		: convert_gltf_image(image, source.texture_index, source.image_index, source.semantic, texture_processing, pool);
+	texture.semantic = source.semantic;
+	return texture;
+}
+
+// Imports a glTF material the first time a primitive uses it. Its slots
+// index texture_sources, which gains the textures it samples unless another
+// material already sampled them with the same semantic; they are decoded
+// afterwards, into ImportedModel::textures in the same order.
+void import_gltf_material(
+	const tinygltf::Model& model,
+	const int material_index,
+	ImportedModel& imported,
+	std::vector<GltfTextureSource>& texture_sources)
+{
+	if (material_index < 0 || imported.materials.contains(material_index))
+		return;
+	if (material_index >= static_cast<int>(model.materials.size()))
+		throw ResourceLoadError(fmt::format(
+			"ResourceLoader: primitive references invalid material {}", material_index));
+
+	const auto& mat = model.materials[material_index];
+	const auto& pbr = mat.pbrMetallicRoughness;
+	const auto import_gltf_texture = [&](const auto &texture_info, const ETextureSemantic semantic) {
+		const int texture_index = texture_info.index;
+		const auto &texture = model.textures.at(texture_index);
+		const auto resolved =
+			resolve_gltf_texture(model, texture, texture_index, gltf_material_label(mat, material_index));
+		auto source = std::ranges::find_if(texture_sources, [&](const GltfTextureSource &candidate) {
+			return candidate.image_index == resolved.image_index && candidate.semantic == semantic;
+		});
+		if (source == texture_sources.end())
+			source = texture_sources.insert(texture_sources.end(), GltfTextureSource{
+				.texture_index = texture_index,
+				.image_index = resolved.image_index,
+				.semantic = semantic,
+				.dds = resolved.dds,
 			});
-		owners.push_back(materials.add(std::move(material)));
-		LoadedMaterial loaded{
-			.ids = { owners.back()->get_id() },
-			.image_sources = std::move(image_sources),
-		};
-		for (auto& texture_owner : texture_owners)
-		{
-			loaded.ids.push_back(texture_owner->get_id());
-			owners.push_back(std::move(texture_owner));
-		}
-		gltf_material_to_material[primitive.material] = loaded;
-		return loaded;
-	}
+		return ImportedMaterial::Slot{static_cast<int>(source - texture_sources.begin()), resolved.sampler};
+	};
 
-	owners.push_back(materials.add(std::make_unique<PbrMaterial>()));
-	return { .ids = { owners.back()->get_id() } };
+	ImportedMaterial material{
+		.base_color_factor = glm::vec4(
+			static_cast<float>(pbr.baseColorFactor[0]),
+			static_cast<float>(pbr.baseColorFactor[1]),
+			static_cast<float>(pbr.baseColorFactor[2]),
+			static_cast<float>(pbr.baseColorFactor[3])),
+		.metallic_factor = static_cast<float>(pbr.metallicFactor),
+		.roughness_factor = static_cast<float>(pbr.roughnessFactor),
+		.normal_scale = static_cast<float>(mat.normalTexture.scale),
+		.properties = PbrMaterial::Properties{
+			.alpha_mode = gltf_alpha_mode(
+				mat, gltf_material_label(mat, material_index)),
+			.alpha_cutoff = static_cast<float>(mat.alphaCutoff),
+			.double_sided = mat.doubleSided,
+			.emissive_factor = glm::vec3(
+				static_cast<float>(mat.emissiveFactor[0]),
+				static_cast<float>(mat.emissiveFactor[1]),
+				static_cast<float>(mat.emissiveFactor[2])),
+		},
+	};
+	const auto slot = [&material](const ETextureSemantic semantic) -> ImportedMaterial::Slot&
+	{
+		return material.slots[static_cast<size_t>(semantic)];
+	};
+	if (pbr.baseColorTexture.index >= 0)
+		slot(ETextureSemantic::BASE_COLOR) = import_gltf_texture(
+			pbr.baseColorTexture, ETextureSemantic::BASE_COLOR);
+	if (pbr.metallicRoughnessTexture.index >= 0)
+		slot(ETextureSemantic::METALLIC_ROUGHNESS) = import_gltf_texture(
+			pbr.metallicRoughnessTexture, ETextureSemantic::METALLIC_ROUGHNESS);
+	if (mat.normalTexture.index >= 0)
+		slot(ETextureSemantic::NORMAL) = import_gltf_texture(mat.normalTexture, ETextureSemantic::NORMAL);
+	if (mat.emissiveTexture.index >= 0)
+		slot(ETextureSemantic::EMISSIVE) = import_gltf_texture(
+			mat.emissiveTexture, ETextureSemantic::EMISSIVE);
+	imported.materials.emplace(material_index, std::move(material));
 }
 
 MaterialHandle ResourceLoader::load_texture(
 	MaterialSystem& materials,
 	const std::filesystem::path& resolved_file_path,
 	const std::string_view logical_resource_name,
-	const ETextureSemantic semantic)
+	const ETextureSemantic semantic,
+	const ETextureProcessing processing)
 {
 	if (!std::filesystem::exists(resolved_file_path))
 	{
@@ -684,6 +664,8 @@ MaterialHandle ResourceLoader::load_texture(
 	}
 	material.data_len = static_cast<size_t>(material.width) * material.height * material.channels;
 	material.mip_sizes = { material.data_len };
+	if (processing == ETextureProcessing::DEFAULT)
+		TextureProcessor::process(material, {});
 
 	return materials.add(std::make_unique<TextureMaterial>(std::move(material)));
 }
@@ -41,6 +41,17 @@ bool SaveFileStore::remove(const std::string_view name) const
 	return std::filesystem::remove_all(path_for(name)) > 0;
 }
 
+std::filesystem::path SaveFileStore::find_scene(const std::filesystem::path& save_directory)
+{
+	for (const auto name : { BINARY_SCENE_FILE, YAML_SCENE_FILE })
+	{
+		const auto scene = save_directory / name;
+		if (std::filesystem::is_regular_file(scene))
+			return scene;
+	}
+	return {};
+}
+
 std::string SaveFileStore::format_modified(const std::filesystem::file_time_type modified)
 {
 	const auto system_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
@@ -63,8 +74,8 @@ std::vector<SaveFileEntry> SaveFileStore::list() const
 	{
 		if (!item.is_directory() || item.path().filename().string().starts_with(".krisp-save-"))
 			continue;
-		const auto scene = item.path() / "scene.yaml";
-		if (!std::filesystem::is_regular_file(scene))
+		const auto scene = find_scene(item.path());
+		if (scene.empty())
 			continue;
 		const auto modified = std::filesystem::last_write_time(scene);
 		entries.push_back({ item.path().filename().string(), item.path(), modified, format_modified(modified) });
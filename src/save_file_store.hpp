@@ -3,6 +3,7 @@
 #include <chrono>
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct SaveFileEntry
@@ -18,9 +19,16 @@ class SaveFileStore
 public:
 	explicit SaveFileStore(std::filesystem::path root) : root(std::move(root)) {}
 
+	// Saves are written as scene.bin, or as scene.yaml when exported for
+	// debugging; either loads
+	static constexpr std::string_view BINARY_SCENE_FILE = "scene.bin";
+	static constexpr std::string_view YAML_SCENE_FILE = "scene.yaml";
+
 	[[nodiscard]] std::vector<SaveFileEntry> list() const;
 	[[nodiscard]] std::filesystem::path path_for_overwrite(std::string_view name) const;
 	bool remove(std::string_view name) const;
+	// The scene file of a save directory, or an empty path if it has none
+	[[nodiscard]] static std::filesystem::path find_scene(const std::filesystem::path& save_directory);
 
 private:
 	[[nodiscard]] std::filesystem::path path_for(std::string_view name) const;
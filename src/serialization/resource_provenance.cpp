@@ -33,6 +33,7 @@ void ResourceProvenance::register_material(MaterialID id, ImportedResourceProven
 			&& value.primitive == provenance.primitive && value.material == provenance.material
 			&& value.image == provenance.image
 			&& value.texture_semantic == provenance.texture_semantic
+			&& value.texture_processing == provenance.texture_processing
 			&& value.skin == provenance.skin
 			&& value.animation == provenance.animation;
 	};
@@ -79,7 +80,8 @@ std::optional<MaterialID> ResourceProvenance::find_material(
 					&& value.scene == provenance.scene && value.node == provenance.node
 					&& value.primitive == provenance.primitive
 					&& value.material == provenance.material && value.image == provenance.image
-					&& value.texture_semantic == provenance.texture_semantic)
+					&& value.texture_semantic == provenance.texture_semantic
+					&& value.texture_processing == provenance.texture_processing)
 					return id;
 	return std::nullopt;
 }
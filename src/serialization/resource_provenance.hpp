@@ -28,6 +28,8 @@ struct ImportedResourceProvenance
 	int material = -1;
 	int image = -1;
 	int texture_semantic = -1;
+	// ETextureProcessing of texture resources
+	int texture_processing = -1;
 	int skin = -1;
 	int animation = -1;
 };
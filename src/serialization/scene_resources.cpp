@@ -1,16 +1,22 @@
 #include "scene_resources.hpp"
 
+#include "mapped_file.hpp"
 #include "entity_component_system/ecs.hpp"
 #include "resource_loader/resource_loader.hpp"
 #include "serialization/resource_provenance.hpp"
 #include "serialization/serialization_helpers.hpp"
 #include "renderable/composited_texture_material.hpp"
 
+#include <algorithm>
 #include <array>
 #include <bit>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <limits>
 #include <ranges>
+#include <span>
+#include <type_traits>
 
 namespace
 {
@@ -38,7 +44,7 @@ std::filesystem::path resource_path(const std::filesystem::path &directory, cons
                                     const std::string &yaml_path)
 {
 	// Resource names are deliberately restricted to files directly inside the
-	// save directory. A crafted scene.yaml must not escape that directory.
+	// save directory. A crafted scene document must not escape that directory.
 	const std::filesystem::path relative(filename);
 	if (relative.empty() || relative.is_absolute() || relative.has_parent_path() || relative.filename() != relative ||
 	    relative.extension() != ".dat")
@@ -58,6 +64,7 @@ void write_source(Serializer out, const ImportedResourceProvenance &source)
 	out.write("material", source.material);
 	out.write("image", source.image);
 	out.write("texture_semantic", source.texture_semantic);
+	out.write("texture_processing", source.texture_processing);
 	out.write("skin", source.skin);
 	out.write("animation", source.animation);
 }
@@ -67,6 +74,8 @@ ImportedResourceProvenance read_source(const Deserializer &in)
 	const auto kind = in.read<std::string>("kind");
 	if (kind != "model" && kind != "texture")
 		throw SerializationError("Unsupported external resource kind at " + in.path());
+	// scenes saved before textures were processed keep their single RGBA8 level
+	const int unprocessed = kind == "texture" ? static_cast<int>(ETextureProcessing::NONE) : -1;
 	return {
 		.kind = kind == "texture" ? EExternalResourceKind::Texture : EExternalResourceKind::Model,
 		.source = in.read<std::string>("path"),
@@ -76,6 +85,7 @@ ImportedResourceProvenance read_source(const Deserializer &in)
 		.material = in.read<int>("material"),
 		.image = in.read<int>("image"),
 		.texture_semantic = in.read<int>("texture_semantic"),
+		.texture_processing = has_key(in, "texture_processing") ? in.read<int>("texture_processing") : unprocessed,
 		.skin = in.read<int>("skin"),
 		.animation = in.read<int>("animation"),
 	};
@@ -121,6 +131,12 @@ std::string format_name(const ETextureFormat format)
 		return "rgba8";
 	case ETextureFormat::BC3:
 		return "bc3";
+	case ETextureFormat::BC1:
+		return "bc1";
+	case ETextureFormat::BC5:
+		return "bc5";
+	case ETextureFormat::BC7:
+		return "bc7";
 	}
 	throw SerializationError("Unsupported texture format");
 }
@@ -132,6 +148,12 @@ ETextureFormat read_format(const Deserializer &in)
 		return ETextureFormat::RGBA8;
 	if (value == "bc3")
 		return ETextureFormat::BC3;
+	if (value == "bc1")
+		return ETextureFormat::BC1;
+	if (value == "bc5")
+		return ETextureFormat::BC5;
+	if (value == "bc7")
+		return ETextureFormat::BC7;
 	throw SerializationError("Unsupported texture format at " + in.path());
 }
 
@@ -236,9 +258,9 @@ void validate_texture(const TextureMaterial &texture, const std::string &path)
 		    (texture.mip_sizes.empty() && pixels * texture.channels != texture.data_len))
 			throw SerializationError("Invalid RGBA8 texture payload size at " + path);
 	}
-	else if (texture.format == ETextureFormat::BC3 && texture.mip_sizes.empty())
+	else if (texture.mip_sizes.empty())
 	{
-		throw SerializationError("BC3 texture has no mip metadata at " + path);
+		throw SerializationError("Block-compressed texture has no mip metadata at " + path);
 	}
 }
 
@@ -316,10 +338,12 @@ void write_mesh_file(const std::filesystem::path &path, const Mesh &mesh, MeshLa
 		throw SerializationError("Unable to write mesh resource: " + path.string());
 }
 
-class BinaryReader
+// Reads a resource straight out of its mapping. Headers are validated in
+// place; nothing is copied until the mesh or texture is built.
+class MappedReader
 {
 public:
-	explicit BinaryReader(std::vector<std::byte> bytes) : bytes(std::move(bytes)) {}
+	explicit MappedReader(const std::span<const std::byte> bytes) : bytes(bytes) {}
 
 	void require_magic()
 	{
@@ -356,35 +380,92 @@ public:
 		return value;
 	}
 
-	bool finished() const { return offset == bytes.size(); }
+	// A view of the next count bytes of the mapping
+	std::span<const std::byte> view(const std::size_t count)
+	{
+		require(count);
+		const auto result = bytes.subspan(offset, count);
+		offset += count;
+		return result;
+	}
+
 	std::size_t remaining() const { return bytes.size() - offset; }
 
 private:
 	void require(const std::size_t count)
 	{
-		// Check before every scalar read so truncated or malicious files cannot
-		// make the decoder read beyond its owned byte buffer.
+		// Check before every read so truncated or malicious files cannot make
+		// the decoder read beyond the mapping.
 		if (count > bytes.size() - offset)
 			throw SerializationError("Truncated mesh resource");
 	}
 
-	std::vector<std::byte> bytes;
+	std::span<const std::byte> bytes;
 	std::size_t offset = 0;
 };
 
+// Color and textured vertices are tightly packed floats in file order, so on
+// little-endian hosts their file form is already their in-memory form and the
+// whole block is copied at once. Skinned vertices are padded and are decoded
+// field by field.
+template<typename Vertex> constexpr bool is_file_layout(const std::size_t floats_per_vertex)
+{
+	return std::endian::native == std::endian::little && std::is_trivially_copyable_v<Vertex> &&
+	       sizeof(Vertex) == floats_per_vertex * sizeof(float);
+}
+
+static_assert(offsetof(SDS::ColorVertex, pos) == 0 && offsetof(SDS::ColorVertex, normal) == 3 * sizeof(float));
+static_assert(offsetof(SDS::TexVertex, pos) == 0 && offsetof(SDS::TexVertex, normal) == 3 * sizeof(float) &&
+              offsetof(SDS::TexVertex, texCoord) == 6 * sizeof(float) &&
+              offsetof(SDS::TexVertex, tangent) == 8 * sizeof(float));
+
+template<typename Vertex, typename Decode>
+std::vector<Vertex> read_vertices(MappedReader &reader, const std::size_t count, const std::size_t floats_per_vertex,
+                                  Decode decode)
+{
+	std::vector<Vertex> vertices(count);
+	if (is_file_layout<Vertex>(floats_per_vertex))
+	{
+		const auto block = reader.view(count * sizeof(Vertex));
+		if (!block.empty())
+			std::memcpy(vertices.data(), block.data(), block.size());
+	}
+	else
+	{
+		for (auto &vertex : vertices)
+			vertex = decode(reader);
+	}
+	return vertices;
+}
+
+std::vector<std::uint32_t> read_indices(MappedReader &reader, const std::size_t count, const std::size_t vertex_count,
+                                        const std::filesystem::path &path)
+{
+	std::vector<std::uint32_t> indices(count);
+	if constexpr (std::endian::native == std::endian::little)
+	{
+		const auto block = reader.view(count * sizeof(std::uint32_t));
+		if (!block.empty())
+			std::memcpy(indices.data(), block.data(), block.size());
+	}
+	else
+	{
+		for (auto &index : indices)
+			index = reader.u32();
+	}
+	if (std::ranges::any_of(indices, [vertex_count](const auto index) { return index >= vertex_count; }))
+		throw SerializationError("Mesh resource index is out of range: " + path.string());
+	return indices;
+}
+
 std::unique_ptr<Mesh> read_mesh_file(const std::filesystem::path &path)
 {
-	std::ifstream stream(path, std::ios::binary | std::ios::ate);
-	if (!stream)
-		throw SerializationError("Unable to open mesh resource: " + path.string());
-	const auto length = stream.tellg();
-	if (length < 0)
-		throw SerializationError("Unable to size mesh resource: " + path.string());
-	std::vector<std::byte> bytes(static_cast<std::size_t>(length));
-	stream.seekg(0);
-	if (!bytes.empty() && !stream.read(reinterpret_cast<char *>(bytes.data()), bytes.size()))
-		throw SerializationError("Unable to read mesh resource: " + path.string());
-	BinaryReader reader(std::move(bytes));
+	// The mapping only lives until the mesh is built: meshes own their vertex
+	// and index vectors, which picking and uploads read from.
+	const auto file = MappedFile::open(path);
+	if (!file)
+		throw SerializationError("Unable to map mesh resource: " + path.string());
+	MappedReader reader(file->bytes());
 	reader.require_magic();
 	if (reader.u32() != MESH_VERSION)
 		throw SerializationError("Unsupported mesh resource version: " + path.string());
@@ -419,84 +500,57 @@ std::unique_ptr<Mesh> read_mesh_file(const std::filesystem::path &path)
 	if (vertex_bytes > std::numeric_limits<std::size_t>::max() - index_bytes ||
 	    reader.remaining() != vertex_bytes + index_bytes)
 		throw SerializationError("Mesh resource size mismatch: " + path.string());
-	std::vector<std::uint32_t> indices;
-	indices.reserve(index_count);
 	if (layout == MeshLayout::Color)
 	{
-		ColorVertices vertices;
-		vertices.reserve(vertex_count);
-		for (std::size_t index = 0; index < vertex_count; ++index)
-			vertices.push_back({.pos = reader.vec<3>(), .normal = reader.vec<3>()});
-		for (std::size_t index = 0; index < index_count; ++index)
-		{
-			const auto vertex = reader.u32();
-			if (vertex >= vertex_count)
-				throw SerializationError("Mesh resource index is out of range: " + path.string());
-			indices.push_back(vertex);
-		}
-		if (!reader.finished())
-			throw SerializationError("Unexpected trailing mesh resource data: " + path.string());
+		auto vertices = read_vertices<SDS::ColorVertex>(reader, vertex_count, floats_per_vertex, [](auto &in) {
+			return SDS::ColorVertex{.pos = in.template vec<3>(), .normal = in.template vec<3>()};
+		});
+		auto indices = read_indices(reader, index_count, vertex_count, path);
 		return std::make_unique<ColorMesh>(std::move(vertices), std::move(indices));
 	}
 	if (layout == MeshLayout::Textured)
 	{
-		TexVertices vertices;
-		vertices.reserve(vertex_count);
-		for (std::size_t index = 0; index < vertex_count; ++index)
-			vertices.push_back({.pos = reader.vec<3>(),
-			                    .normal = reader.vec<3>(),
-			                    .texCoord = reader.vec<2>(),
-			                    .tangent = reader.vec<4>()});
-		for (std::size_t index = 0; index < index_count; ++index)
-		{
-			const auto vertex = reader.u32();
-			if (vertex >= vertex_count)
-				throw SerializationError("Mesh resource index is out of range: " + path.string());
-			indices.push_back(vertex);
-		}
-		if (!reader.finished())
-			throw SerializationError("Unexpected trailing mesh resource data: " + path.string());
+		auto vertices = read_vertices<SDS::TexVertex>(reader, vertex_count, floats_per_vertex, [](auto &in) {
+			return SDS::TexVertex{.pos = in.template vec<3>(),
+			                      .normal = in.template vec<3>(),
+			                      .texCoord = in.template vec<2>(),
+			                      .tangent = in.template vec<4>()};
+		});
+		auto indices = read_indices(reader, index_count, vertex_count, path);
 		return std::make_unique<TexMesh>(std::move(vertices), std::move(indices));
 	}
-	if (layout == MeshLayout::Skinned)
-	{
-		SkinnedVertices vertices;
-		vertices.reserve(vertex_count);
-		for (std::size_t index = 0; index < vertex_count; ++index)
-		{
-			SDS::SkinnedVertex vertex;
-			vertex.bone_ids = reader.vec<4>();
-			vertex.bone_weights = reader.vec<4>();
-			vertex.pos = reader.vec<3>();
-			vertex.normal = reader.vec<3>();
-			vertex.texCoord = reader.vec<2>();
-			vertex.tangent = reader.vec<4>();
-			vertices.push_back(vertex);
-		}
-		for (std::size_t index = 0; index < index_count; ++index)
-		{
-			const auto vertex = reader.u32();
-			if (vertex >= vertex_count)
-				throw SerializationError("Mesh resource index is out of range: " + path.string());
-			indices.push_back(vertex);
-		}
-		if (!reader.finished())
-			throw SerializationError("Unexpected trailing mesh resource data: " + path.string());
-		return std::make_unique<SkinnedMesh>(std::move(vertices), std::move(indices));
-	}
-	throw SerializationError("Unsupported mesh resource layout: " + path.string());
+	auto vertices = read_vertices<SDS::SkinnedVertex>(reader, vertex_count, floats_per_vertex, [](auto &in) {
+		SDS::SkinnedVertex vertex;
+		vertex.bone_ids = in.template vec<4>();
+		vertex.bone_weights = in.template vec<4>();
+		vertex.pos = in.template vec<3>();
+		vertex.normal = in.template vec<3>();
+		vertex.texCoord = in.template vec<2>();
+		vertex.tangent = in.template vec<4>();
+		return vertex;
+	});
+	auto indices = read_indices(reader, index_count, vertex_count, path);
+	return std::make_unique<SkinnedMesh>(std::move(vertices), std::move(indices));
 }
 
-std::vector<std::byte> read_payload(const std::filesystem::path &path, const std::size_t expected)
+// Restored texture payloads are uploaded straight from the mapped .dat file,
+// which stays mapped for as long as the material holds its data
+struct MappedFileTextureData final : TextureData
+{
+	explicit MappedFileTextureData(MappedFile file) : file(std::move(file)) {}
+
+	std::byte* get() override { return file.data(); }
+
+private:
+	MappedFile file;
+};
+
+std::unique_ptr<TextureData> map_payload(const std::filesystem::path &path, const std::size_t expected)
 {
-	std::ifstream stream(path, std::ios::binary | std::ios::ate);
-	if (!stream || stream.tellg() < 0 || static_cast<std::uintmax_t>(stream.tellg()) != expected)
+	auto file = MappedFile::open(path);
+	if (!file || file->size() != expected)
 		throw SerializationError("Texture resource size mismatch: " + path.string());
-	std::vector<std::byte> bytes(expected);
-	stream.seekg(0);
-	if (expected && !stream.read(reinterpret_cast<char *>(bytes.data()), expected))
-		throw SerializationError("Unable to read texture resource: " + path.string());
-	return bytes;
+	return std::make_unique<MappedFileTextureData>(std::move(*file));
 }
 } // namespace
 
@@ -666,7 +720,7 @@ void SceneResourceWriter::write_generated_material(const MaterialID id)
 		throw SerializationError("Generated texture has no pixel data");
 	const auto filename = "texture_" + std::to_string(id.get_underlying()) + ".dat";
 	// Generated texture payloads are already encoded according to format and mip
-	// metadata. Store those bytes verbatim; scene.yaml carries their interpretation.
+	// metadata. Store those bytes verbatim; the scene document carries their interpretation.
 	std::ofstream stream(directory / filename, std::ios::binary | std::ios::trunc);
 	if (!stream ||
 	    (texture->data_len && !stream.write(reinterpret_cast<const char *>(texture->data->get()), texture->data_len)))
@@ -778,8 +832,8 @@ void SceneResourceReader::prepare(const Deserializer &document)
 			validate_texture(*texture, entry.path());
 			const auto file = resource_path(directory, entry.read<std::string>("file"), entry.child("file").path());
 			// Unlike externally loaded images, this payload has no loader/cache owner.
-			// OwnedTextureData keeps the restored bytes alive with the material.
-			texture->data = std::make_unique<OwnedTextureData>(read_payload(file, texture->data_len));
+			// The mapping is kept alive with the material.
+			texture->data = map_payload(file, texture->data_len);
 			material = std::move(texture);
 		}
 		else if (type == "composited_texture")
@@ -1003,10 +1057,14 @@ MaterialHandle SceneResourceReader::read_material_reference(const Deserializer &
 		const auto semantic = static_cast<ETextureSemantic>(source.texture_semantic);
 		if (semantic < ETextureSemantic::BASE_COLOR || semantic >= ETextureSemantic::COUNT)
 			throw SerializationError("Invalid external texture semantic at " + in.path());
-		const auto key = source.source + "#" + std::to_string(source.texture_semantic);
+		const auto processing = static_cast<ETextureProcessing>(source.texture_processing);
+		if (processing != ETextureProcessing::DEFAULT && processing != ETextureProcessing::NONE)
+			throw SerializationError("Invalid external texture processing at " + in.path());
+		const auto key = source.source + "#" + std::to_string(source.texture_semantic)
+			+ "#" + std::to_string(source.texture_processing);
 		if (!imported_textures.contains(key))
-			imported_textures.emplace(
-				key, ResourceLoader::fetch_texture(ecs.get_material_system(), source.source, semantic));
+			imported_textures.emplace(key, ResourceLoader::fetch_texture(
+				ecs.get_material_system(), source.source, semantic, processing));
 		return imported_textures.at(key);
 	}
 	const auto id = ResourceProvenance::find_material(ecs.get_material_system(), source);
@@ -13,7 +13,7 @@ class ECS;
 // Serializes resources referenced by the scene. Resources with imported
 // provenance remain references to their external model/image; resources that
 // were created inside Krisp are written once to the save directory and
-// referenced by a save-local ID from scene.yaml.
+// referenced by a save-local ID from the scene document.
 class SceneResourceWriter
 {
 public:
@@ -37,7 +37,7 @@ private:
 	std::unordered_map<MaterialID, bool> written_materials;
 };
 
-// Resolves scene.yaml resource references into live ECS handles. prepare()
+// Resolves scene document resource references into live ECS handles. prepare()
 // must run before ECS component deserialization: it imports external models and
 // reconstructs generated resources so later component readers can acquire them.
 class SceneResourceReader
@@ -1,10 +1,114 @@
 #include "serializer.hpp"
 
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cctype>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <unordered_map>
 #include <utility>
 
+namespace serialization_detail
+{
+// Scalars parsed from YAML keep their source text and are converted when
+// read, as yaml-cpp would; written and binary scalars keep their type
+enum class ScalarType : std::uint8_t
+{
+	Bool,
+	Int,
+	UInt,
+	Double,
+	Text,
+};
+
+struct Node
+{
+	static constexpr std::uint32_t NONE = std::numeric_limits<std::uint32_t>::max();
+
+	SerializationKind kind = SerializationKind::Null;
+	ScalarType type = ScalarType::Text;
+	std::uint32_t parent = NONE;
+	// Interned key of a mapping entry, or the index of a sequence element
+	std::uint32_t key = 0;
+	std::uint32_t first_child = NONE;
+	std::uint32_t last_child = NONE;
+	std::uint32_t next_sibling = NONE;
+	std::uint32_t size = 0;
+	union
+	{
+		bool boolean;
+		std::int64_t integer;
+		std::uint64_t unsigned_integer;
+		double floating;
+		std::uint32_t text;
+	} value{};
+};
+
+struct Document
+{
+	std::uint32_t intern(const std::string_view text)
+	{
+		if (const auto found = string_ids.find(text); found != string_ids.end())
+			return found->second;
+		const auto id = store(std::string(text));
+		string_ids.emplace(strings.back(), id);
+		return id;
+	}
+
+	// Scalar text parsed from YAML is rarely repeated, so it skips interning
+	std::uint32_t store(std::string text)
+	{
+		if (strings.size() >= Node::NONE)
+			throw SerializationError("Serialized document has too many strings");
+		strings.push_back(std::move(text));
+		return static_cast<std::uint32_t>(strings.size() - 1);
+	}
+
+	std::optional<std::uint32_t> find(const std::string_view text) const
+	{
+		if (const auto found = string_ids.find(text); found != string_ids.end())
+			return found->second;
+		return std::nullopt;
+	}
+
+	std::uint32_t add(const std::uint32_t parent, const std::uint32_t key, const SerializationKind kind)
+	{
+		if (nodes.size() >= Node::NONE)
+			throw SerializationError("Serialized document has too many nodes");
+		const auto index = static_cast<std::uint32_t>(nodes.size());
+		nodes.push_back({ .kind = kind, .parent = parent, .key = key });
+		if (parent == Node::NONE)
+			return index;
+		auto& owner = nodes[parent];
+		if (owner.last_child == Node::NONE)
+			owner.first_child = index;
+		else
+			nodes[owner.last_child].next_sibling = index;
+		owner.last_child = index;
+		++owner.size;
+		return index;
+	}
+
+	std::string path(std::uint32_t node) const;
+
+	std::vector<Node> nodes;
+	// A deque keeps the interned views stable as strings are added
+	std::deque<std::string> strings;
+	std::unordered_map<std::string_view, std::uint32_t> string_ids;
+};
+}
+
 namespace
 {
+using serialization_detail::Document;
+using serialization_detail::Node;
+using serialization_detail::ScalarType;
+
 std::string mapping_path(const std::string& parent, const std::string_view key)
 {
 	const bool identifier = !key.empty()
@@ -20,63 +124,479 @@ std::string mapping_path(const std::string& parent, const std::string_view key)
 		return parent + "." + std::string(key);
 	return parent + "[\"" + std::string(key) + "\"]";
 }
+
+void assign(Document& document, Node& node, const serialization_detail::ScalarValue& value)
+{
+	std::visit([&](const auto& scalar) {
+		using Value = std::decay_t<decltype(scalar)>;
+		if constexpr (std::same_as<Value, bool>) {
+			node.type = ScalarType::Bool;
+			node.value.boolean = scalar;
+		} else if constexpr (std::same_as<Value, std::int64_t>) {
+			node.type = ScalarType::Int;
+			node.value.integer = scalar;
+		} else if constexpr (std::same_as<Value, std::uint64_t>) {
+			node.type = ScalarType::UInt;
+			node.value.unsigned_integer = scalar;
+		} else if constexpr (std::same_as<Value, double>) {
+			node.type = ScalarType::Double;
+			node.value.floating = scalar;
+		} else {
+			node.type = ScalarType::Text;
+			node.value.text = document.intern(scalar);
+		}
+	}, value);
+}
+
+// Plain decimal text, which is all the engine writes, is converted with
+// from_chars; other YAML spellings (hex, .inf, yes/no) go through yaml-cpp
+template<typename Value>
+std::optional<Value> parse_text(const std::string& text)
+{
+	if constexpr (std::same_as<Value, bool>) {
+		if (text == "true")
+			return true;
+		if (text == "false")
+			return false;
+	} else if (!text.empty() && text.find_first_not_of("0123456789+-.eE") == std::string::npos) {
+		Value value{};
+		const auto* end = text.data() + text.size();
+		const auto [last, error] = std::from_chars(text.data(), end, value);
+		if (error == std::errc() && last == end)
+			return value;
+	}
+	try {
+		return YAML::Node(text).as<Value>();
+	} catch (const YAML::Exception&) {
+		return std::nullopt;
+	}
+}
+
+void emit_yaml(YAML::Emitter& emitter, const Document& document, const std::uint32_t index)
+{
+	const auto& node = document.nodes[index];
+	switch (node.kind) {
+	case SerializationKind::Null:
+		emitter << YAML::Null;
+		break;
+	case SerializationKind::Scalar:
+		switch (node.type) {
+		case ScalarType::Bool:
+			emitter << node.value.boolean;
+			break;
+		case ScalarType::Int:
+			emitter << node.value.integer;
+			break;
+		case ScalarType::UInt:
+			emitter << node.value.unsigned_integer;
+			break;
+		case ScalarType::Double:
+			emitter << node.value.floating;
+			break;
+		case ScalarType::Text:
+			emitter << document.strings[node.value.text];
+			break;
+		}
+		break;
+	case SerializationKind::Sequence:
+		emitter << YAML::BeginSeq;
+		for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling)
+			emit_yaml(emitter, document, child);
+		emitter << YAML::EndSeq;
+		break;
+	case SerializationKind::Mapping:
+		emitter << YAML::BeginMap;
+		for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling) {
+			emitter << YAML::Key << document.strings[document.nodes[child].key] << YAML::Value;
+			emit_yaml(emitter, document, child);
+		}
+		emitter << YAML::EndMap;
+		break;
+	}
+}
+
+void convert_yaml(const YAML::Node& source, Document& document, const std::uint32_t parent, const std::uint32_t key)
+{
+	switch (source.Type()) {
+	case YAML::NodeType::Null:
+		document.add(parent, key, SerializationKind::Null);
+		break;
+	case YAML::NodeType::Scalar: {
+		const auto text = document.store(source.Scalar());
+		const auto index = document.add(parent, key, SerializationKind::Scalar);
+		document.nodes[index].value.text = text;
+		break;
+	}
+	case YAML::NodeType::Sequence: {
+		const auto index = document.add(parent, key, SerializationKind::Sequence);
+		std::uint32_t element = 0;
+		for (const auto& value : source)
+			convert_yaml(value, document, index, element++);
+		break;
+	}
+	case YAML::NodeType::Map: {
+		const auto index = document.add(parent, key, SerializationKind::Mapping);
+		for (const auto& entry : source) {
+			if (!entry.first.IsScalar())
+				throw SerializationError("Invalid mapping key at " + document.path(index));
+			convert_yaml(entry.second, document, index, document.intern(entry.first.Scalar()));
+		}
+		break;
+	}
+	case YAML::NodeType::Undefined:
+		throw SerializationError("Undefined YAML node at "
+			+ (parent == Node::NONE ? std::string("$") : document.path(parent)));
+	}
+}
+
+// Binary documents are versioned and little-endian:
+//
+//   magic[8] version:u32 string_count:u32 (length:u32 bytes)* root:value
+//
+// A value is a one-byte tag and its payload. Strings, mapping keys included,
+// are u32 indices into the string table. Every count is a u32. Mappings in
+// the top two levels are chunked: each entry carries the u64 byte length of
+// its value, so every ECS system is a separately validated chunk.
+constexpr std::array<std::byte, 8> DOCUMENT_MAGIC{std::byte{'K'}, std::byte{'R'}, std::byte{'I'}, std::byte{'S'},
+                                                  std::byte{'P'}, std::byte{'S'}, std::byte{'0'}, std::byte{'1'}};
+constexpr std::uint32_t DOCUMENT_VERSION = 1;
+constexpr std::uint32_t CHUNKED_DEPTH = 2;
+// Far beyond anything the engine writes; bounds recursion on crafted files
+constexpr std::uint32_t MAX_DEPTH = 256;
+
+enum class Tag : std::uint8_t
+{
+	Null,
+	False,
+	True,
+	Int,
+	UInt,
+	Double,
+	String,
+	Sequence,
+	Mapping,
+	ChunkedMapping,
+};
+
+class BinaryWriter
+{
+public:
+	explicit BinaryWriter(const Document& document) : document(document) {}
+
+	std::vector<std::byte> write()
+	{
+		bytes.assign(DOCUMENT_MAGIC.begin(), DOCUMENT_MAGIC.end());
+		u32(DOCUMENT_VERSION);
+		u32(static_cast<std::uint32_t>(document.strings.size()));
+		for (const auto& text : document.strings) {
+			if (text.size() > std::numeric_limits<std::uint32_t>::max())
+				throw SerializationError("Serialized string is too long");
+			u32(static_cast<std::uint32_t>(text.size()));
+			const auto* first = reinterpret_cast<const std::byte*>(text.data());
+			bytes.insert(bytes.end(), first, first + text.size());
+		}
+		value(0, 0);
+		return std::move(bytes);
+	}
+
+private:
+	void value(const std::uint32_t index, const std::uint32_t depth)
+	{
+		const auto& node = document.nodes[index];
+		switch (node.kind) {
+		case SerializationKind::Null:
+			tag(Tag::Null);
+			break;
+		case SerializationKind::Scalar:
+			switch (node.type) {
+			case ScalarType::Bool:
+				tag(node.value.boolean ? Tag::True : Tag::False);
+				break;
+			case ScalarType::Int:
+				tag(Tag::Int);
+				u64(static_cast<std::uint64_t>(node.value.integer));
+				break;
+			case ScalarType::UInt:
+				tag(Tag::UInt);
+				u64(node.value.unsigned_integer);
+				break;
+			case ScalarType::Double:
+				tag(Tag::Double);
+				u64(std::bit_cast<std::uint64_t>(node.value.floating));
+				break;
+			case ScalarType::Text:
+				tag(Tag::String);
+				u32(node.value.text);
+				break;
+			}
+			break;
+		case SerializationKind::Sequence:
+			tag(Tag::Sequence);
+			u32(node.size);
+			for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling)
+				value(child, depth + 1);
+			break;
+		case SerializationKind::Mapping: {
+			const bool chunked = depth < CHUNKED_DEPTH;
+			tag(chunked ? Tag::ChunkedMapping : Tag::Mapping);
+			u32(node.size);
+			for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling) {
+				u32(document.nodes[child].key);
+				if (!chunked) {
+					value(child, depth + 1);
+					continue;
+				}
+				const auto length_offset = bytes.size();
+				u64(0);
+				value(child, depth + 1);
+				const auto length = bytes.size() - length_offset - sizeof(std::uint64_t);
+				for (unsigned byte = 0; byte < 8; ++byte)
+					bytes[length_offset + byte] = static_cast<std::byte>((length >> (byte * 8)) & 0xff);
+			}
+			break;
+		}
+		}
+	}
+
+	void tag(const Tag value) { bytes.push_back(static_cast<std::byte>(value)); }
+
+	void u32(const std::uint32_t value)
+	{
+		for (unsigned shift = 0; shift < 32; shift += 8)
+			bytes.push_back(static_cast<std::byte>((value >> shift) & 0xff));
+	}
+
+	void u64(const std::uint64_t value)
+	{
+		for (unsigned shift = 0; shift < 64; shift += 8)
+			bytes.push_back(static_cast<std::byte>((value >> shift) & 0xff));
+	}
+
+	const Document& document;
+	std::vector<std::byte> bytes;
+};
+
+class BinaryReader
+{
+public:
+	BinaryReader(const std::span<const std::byte> bytes, Document& document) : bytes(bytes), document(document) {}
+
+	void read()
+	{
+		if (bytes.size() < DOCUMENT_MAGIC.size() || !std::equal(DOCUMENT_MAGIC.begin(), DOCUMENT_MAGIC.end(), bytes.begin()))
+			throw SerializationError("Invalid scene document magic");
+		offset = DOCUMENT_MAGIC.size();
+		if (const auto version = u32(); version != DOCUMENT_VERSION)
+			throw SerializationError("Unsupported scene document version " + std::to_string(version));
+		const auto string_count = u32();
+		if (string_count > remaining() / sizeof(std::uint32_t))
+			throw SerializationError("Truncated scene document");
+		for (std::uint32_t index = 0; index < string_count; ++index) {
+			const auto length = u32();
+			require(length);
+			const std::string_view text(reinterpret_cast<const char*>(bytes.data() + offset), length);
+			offset += length;
+			if (document.find(text))
+				throw SerializationError("Duplicate string in scene document");
+			document.intern(text);
+		}
+		key_mappings.assign(document.strings.size(), Node::NONE);
+		value(Node::NONE, 0, 0);
+		if (offset != bytes.size())
+			throw SerializationError("Trailing bytes after scene document");
+	}
+
+private:
+	void value(const std::uint32_t parent, const std::uint32_t key, const std::uint32_t depth)
+	{
+		if (depth > MAX_DEPTH)
+			throw SerializationError("Scene document nests too deeply at " + document.path(parent));
+		const auto tag = static_cast<Tag>(u8());
+		switch (tag) {
+		case Tag::Null:
+			document.add(parent, key, SerializationKind::Null);
+			break;
+		case Tag::False:
+		case Tag::True:
+			scalar(parent, key, ScalarType::Bool).value.boolean = tag == Tag::True;
+			break;
+		case Tag::Int: {
+			const auto value = u64();
+			scalar(parent, key, ScalarType::Int).value.integer = static_cast<std::int64_t>(value);
+			break;
+		}
+		case Tag::UInt: {
+			const auto value = u64();
+			scalar(parent, key, ScalarType::UInt).value.unsigned_integer = value;
+			break;
+		}
+		case Tag::Double: {
+			const auto value = u64();
+			scalar(parent, key, ScalarType::Double).value.floating = std::bit_cast<double>(value);
+			break;
+		}
+		case Tag::String: {
+			const auto text = string_id();
+			scalar(parent, key, ScalarType::Text).value.text = text;
+			break;
+		}
+		case Tag::Sequence: {
+			const auto count = u32();
+			// Every element takes at least its tag byte
+			if (count > remaining())
+				throw SerializationError("Truncated scene document");
+			const auto index = document.add(parent, key, SerializationKind::Sequence);
+			for (std::uint32_t element = 0; element < count; ++element)
+				value(index, element, depth + 1);
+			break;
+		}
+		case Tag::Mapping:
+		case Tag::ChunkedMapping: {
+			const auto count = u32();
+			if (count > remaining() / sizeof(std::uint32_t))
+				throw SerializationError("Truncated scene document");
+			const auto index = document.add(parent, key, SerializationKind::Mapping);
+			for (std::uint32_t entry = 0; entry < count; ++entry) {
+				const auto entry_key = string_id();
+				if (tag == Tag::Mapping) {
+					value(index, entry_key, depth + 1);
+					continue;
+				}
+				const auto length = u64();
+				require(length);
+				const auto end = offset + static_cast<std::size_t>(length);
+				value(index, entry_key, depth + 1);
+				if (offset != end)
+					throw SerializationError("Corrupt scene document chunk at " + document.path(document.nodes[index].last_child));
+			}
+			// Checked once the entries are read, as nested mappings reuse the
+			// stamps while theirs are
+			for (auto child = document.nodes[index].first_child; child != Node::NONE; child = document.nodes[child].next_sibling) {
+				auto& mapping = key_mappings[document.nodes[child].key];
+				if (mapping == index)
+					throw SerializationError("Duplicate mapping key at " + document.path(child));
+				mapping = index;
+			}
+			break;
+		}
+		default:
+			throw SerializationError("Invalid scene document value at "
+				+ (parent == Node::NONE ? std::string("$") : document.path(parent)));
+		}
+	}
+
+	Node& scalar(const std::uint32_t parent, const std::uint32_t key, const ScalarType type)
+	{
+		auto& node = document.nodes[document.add(parent, key, SerializationKind::Scalar)];
+		node.type = type;
+		return node;
+	}
+
+	std::uint32_t string_id()
+	{
+		const auto id = u32();
+		if (id >= document.strings.size())
+			throw SerializationError("Invalid string reference in scene document");
+		return id;
+	}
+
+	std::uint8_t u8()
+	{
+		require(1);
+		return std::to_integer<std::uint8_t>(bytes[offset++]);
+	}
+
+	std::uint32_t u32()
+	{
+		require(4);
+		std::uint32_t value = 0;
+		for (unsigned index = 0; index < 4; ++index)
+			value |= std::to_integer<std::uint32_t>(bytes[offset++]) << (index * 8);
+		return value;
+	}
+
+	std::uint64_t u64()
+	{
+		require(8);
+		std::uint64_t value = 0;
+		for (unsigned index = 0; index < 8; ++index)
+			value |= std::to_integer<std::uint64_t>(bytes[offset++]) << (index * 8);
+		return value;
+	}
+
+	std::size_t remaining() const { return bytes.size() - offset; }
+
+	void require(const std::uint64_t count) const
+	{
+		if (count > remaining())
+			throw SerializationError("Truncated scene document");
+	}
+
+	std::span<const std::byte> bytes;
+	Document& document;
+	std::size_t offset = 0;
+	// The mapping that last used each string as a key
+	std::vector<std::uint32_t> key_mappings;
+};
+}
+
+std::string serialization_detail::Document::path(const std::uint32_t node) const
+{
+	const auto& entry = nodes[node];
+	if (entry.parent == Node::NONE)
+		return "$";
+	if (nodes[entry.parent].kind == SerializationKind::Mapping)
+		return mapping_path(path(entry.parent), strings[entry.key]);
+	return path(entry.parent) + "[" + std::to_string(entry.key) + "]";
 }
 
 Serializer::Serializer()
-	: document_(std::make_shared<YAML::Node>(YAML::NodeType::Map)), node_(*document_), path_("$")
+	: document_(std::make_shared<serialization_detail::Document>()), node_(0)
 {
+	document_->add(Node::NONE, 0, SerializationKind::Mapping);
 }
 
-Serializer::Serializer(std::shared_ptr<YAML::Node> document, YAML::Node node, std::string path)
-	: document_(std::move(document)), node_(std::move(node)), path_(std::move(path))
+Serializer::Serializer(std::shared_ptr<serialization_detail::Document> document, const std::uint32_t node)
+	: document_(std::move(document)), node_(node)
 {
 }
 
 void Serializer::write_null(const std::string_view key)
 {
-	write_node(key, YAML::Node(YAML::NodeType::Null));
+	static_cast<void>(add_entry(key, SerializationKind::Null));
 }
 
 Serializer Serializer::map(const std::string_view key)
 {
-	YAML::Node value(YAML::NodeType::Map);
-	write_node(key, value);
-	return Serializer(document_, node_[std::string(key)], child_path(key));
+	return Serializer(document_, add_entry(key, SerializationKind::Mapping));
 }
 
 Serializer Serializer::sequence(const std::string_view key)
 {
-	YAML::Node value(YAML::NodeType::Sequence);
-	write_node(key, value);
-	return Serializer(document_, node_[std::string(key)], child_path(key));
+	return Serializer(document_, add_entry(key, SerializationKind::Sequence));
 }
 
 void Serializer::append_null()
 {
-	append_node(YAML::Node(YAML::NodeType::Null));
+	static_cast<void>(add_element(SerializationKind::Null));
 }
 
 Serializer Serializer::append_map()
 {
-	require_sequence();
-	const auto index = node_.size();
-	node_.push_back(YAML::Node(YAML::NodeType::Map));
-	return Serializer(document_, node_[index], path_ + "[" + std::to_string(index) + "]");
+	return Serializer(document_, add_element(SerializationKind::Mapping));
 }
 
 Serializer Serializer::append_sequence()
 {
-	require_sequence();
-	const auto index = node_.size();
-	node_.push_back(YAML::Node(YAML::NodeType::Sequence));
-	return Serializer(document_, node_[index], path_ + "[" + std::to_string(index) + "]");
+	return Serializer(document_, add_element(SerializationKind::Sequence));
 }
 
 std::string Serializer::emit() const
 {
 	try {
 		YAML::Emitter emitter;
-		emitter << *document_;
+		emitter.SetDoublePrecision(std::numeric_limits<double>::max_digits10);
+		emit_yaml(emitter, *document_, 0);
 		if (!emitter.good())
 			throw SerializationError("Failed to emit YAML at $: " + emitter.GetLastError());
 		return emitter.c_str();
@@ -85,106 +605,221 @@ std::string Serializer::emit() const
 	}
 }
 
-void Serializer::write_node(const std::string_view key, const YAML::Node& value)
+std::vector<std::byte> Serializer::emit_binary() const
 {
-	require_mapping();
-	for (const auto& entry : node_) {
-		if (entry.first.as<std::string>() == key)
-			throw SerializationError("Duplicate mapping key at " + child_path(key));
-	}
-	node_[std::string(key)] = value;
+	return BinaryWriter(*document_).write();
 }
 
-void Serializer::append_node(const YAML::Node& value)
+void Serializer::write_scalar(const std::string_view key, const serialization_detail::ScalarValue& value)
 {
-	require_sequence();
-	node_.push_back(value);
+	const auto index = add_entry(key, SerializationKind::Scalar);
+	assign(*document_, document_->nodes[index], value);
 }
 
-std::string Serializer::child_path(const std::string_view key) const
+void Serializer::append_scalar(const serialization_detail::ScalarValue& value)
 {
-	return mapping_path(path_, key);
+	const auto index = add_element(SerializationKind::Scalar);
+	assign(*document_, document_->nodes[index], value);
 }
 
-void Serializer::require_mapping() const
+std::uint32_t Serializer::add_entry(const std::string_view key, const SerializationKind kind)
 {
-	if (!node_.IsMap())
-		throw SerializationError("Expected mapping at " + path_);
+	auto& document = *document_;
+	if (document.nodes[node_].kind != SerializationKind::Mapping)
+		throw SerializationError("Expected mapping at " + document.path(node_));
+	const auto id = document.intern(key);
+	for (auto child = document.nodes[node_].first_child; child != Node::NONE; child = document.nodes[child].next_sibling) {
+		if (document.nodes[child].key == id)
+			throw SerializationError("Duplicate mapping key at " + mapping_path(document.path(node_), key));
+	}
+	return document.add(node_, id, kind);
 }
 
-void Serializer::require_sequence() const
+std::uint32_t Serializer::add_element(const SerializationKind kind)
 {
-	if (!node_.IsSequence())
-		throw SerializationError("Expected sequence at " + path_);
+	auto& document = *document_;
+	if (document.nodes[node_].kind != SerializationKind::Sequence)
+		throw SerializationError("Expected sequence at " + document.path(node_));
+	return document.add(node_, document.nodes[node_].size, kind);
 }
 
-Deserializer::Deserializer(std::shared_ptr<YAML::Node> document, YAML::Node node, std::string path)
-	: document_(std::move(document)), node_(std::move(node)), path_(std::move(path))
+Deserializer::Deserializer(std::shared_ptr<const serialization_detail::Document> document, const std::uint32_t node)
+	: document_(std::move(document)), node_(node)
 {
 }
 
 Deserializer Deserializer::parse(const std::string_view yaml)
 {
+	YAML::Node source;
 	try {
-		auto document = std::make_shared<YAML::Node>(YAML::Load(std::string(yaml)));
-		return Deserializer(document, *document, "$");
+		source = YAML::Load(std::string(yaml));
 	} catch (const YAML::Exception& error) {
 		throw SerializationError("Invalid YAML at $: " + std::string(error.what()));
 	}
+	auto document = std::make_shared<serialization_detail::Document>();
+	convert_yaml(source, *document, Node::NONE, 0);
+	return Deserializer(std::move(document), 0);
+}
+
+Deserializer Deserializer::parse_binary(const std::span<const std::byte> bytes)
+{
+	auto document = std::make_shared<serialization_detail::Document>();
+	BinaryReader(bytes, *document).read();
+	return Deserializer(std::move(document), 0);
 }
 
 Deserializer Deserializer::child(const std::string_view key) const
 {
-	const auto path = child_path(key);
-	if (!node_.IsMap())
-		throw SerializationError("Expected mapping at " + path_ + " while reading " + path);
-	const YAML::Node value = node_[std::string(key)];
-	if (!value.IsDefined())
-		throw SerializationError("Missing field at " + path);
-	return Deserializer(document_, value, path);
+	const auto& document = *document_;
+	const auto& node = document.nodes[node_];
+	if (node.kind != SerializationKind::Mapping)
+		throw SerializationError("Expected mapping at " + path() + " while reading " + mapping_path(path(), key));
+	if (const auto id = document.find(key)) {
+		for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling) {
+			if (document.nodes[child].key == *id)
+				return Deserializer(document_, child);
+		}
+	}
+	throw SerializationError("Missing field at " + mapping_path(path(), key));
 }
 
 std::vector<Deserializer> Deserializer::elements() const
 {
-	if (!node_.IsSequence())
-		throw SerializationError("Expected sequence at " + path_);
+	const auto& document = *document_;
+	const auto& node = document.nodes[node_];
+	if (node.kind != SerializationKind::Sequence)
+		throw SerializationError("Expected sequence at " + path());
 	std::vector<Deserializer> result;
-	result.reserve(node_.size());
-	for (std::size_t index = 0; index < node_.size(); ++index)
-		result.push_back(Deserializer(document_, node_[index], path_ + "[" + std::to_string(index) + "]"));
+	result.reserve(node.size);
+	for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling)
+		result.push_back(Deserializer(document_, child));
 	return result;
 }
 
 std::vector<std::string> Deserializer::keys() const
 {
-	if (!node_.IsMap())
-		throw SerializationError("Expected mapping at " + path_);
+	const auto& document = *document_;
+	const auto& node = document.nodes[node_];
+	if (node.kind != SerializationKind::Mapping)
+		throw SerializationError("Expected mapping at " + path());
 	std::vector<std::string> result;
-	result.reserve(node_.size());
-	for (const auto& entry : node_) {
-		try {
-			result.push_back(entry.first.as<std::string>());
-		} catch (const YAML::Exception& error) {
-			throw SerializationError("Invalid mapping key at " + path_ + ": " + error.what());
-		}
-	}
+	result.reserve(node.size);
+	for (auto child = node.first_child; child != Node::NONE; child = document.nodes[child].next_sibling)
+		result.push_back(document.strings[document.nodes[child].key]);
 	return result;
 }
 
 SerializationKind Deserializer::kind() const
 {
-	if (node_.IsNull())
-		return SerializationKind::Null;
-	if (node_.IsScalar())
-		return SerializationKind::Scalar;
-	if (node_.IsSequence())
-		return SerializationKind::Sequence;
-	if (node_.IsMap())
-		return SerializationKind::Mapping;
-	throw SerializationError("Undefined YAML node at " + path_);
+	return document_->nodes[node_].kind;
+}
+
+std::string Deserializer::path() const
+{
+	return document_->path(node_);
+}
+
+std::string Deserializer::read_string() const
+{
+	const auto& node = document_->nodes[node_];
+	switch (node.type) {
+	case ScalarType::Bool:
+		return node.value.boolean ? "true" : "false";
+	case ScalarType::Int:
+		return std::to_string(node.value.integer);
+	case ScalarType::UInt:
+		return std::to_string(node.value.unsigned_integer);
+	case ScalarType::Double: {
+		std::array<char, 32> text{};
+		const auto result = std::to_chars(text.data(), text.data() + text.size(), node.value.floating);
+		return std::string(text.data(), result.ptr);
+	}
+	case ScalarType::Text:
+		break;
+	}
+	return document_->strings[node.value.text];
+}
+
+bool Deserializer::read_bool() const
+{
+	const auto& node = document_->nodes[node_];
+	if (node.type == ScalarType::Bool)
+		return node.value.boolean;
+	if (node.type == ScalarType::Text) {
+		if (const auto value = parse_text<bool>(document_->strings[node.value.text]))
+			return *value;
+	}
+	throw SerializationError("Invalid scalar at " + path() + ": expected a boolean");
+}
+
+std::int64_t Deserializer::read_int64() const
+{
+	const auto& node = document_->nodes[node_];
+	switch (node.type) {
+	case ScalarType::Int:
+		return node.value.integer;
+	case ScalarType::UInt:
+		if (node.value.unsigned_integer > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+			throw SerializationError("Integer out of range at " + path());
+		return static_cast<std::int64_t>(node.value.unsigned_integer);
+	case ScalarType::Double:
+		// YAML writes integral doubles without a fraction, which then read
+		// back as integers
+		if (node.value.floating == std::trunc(node.value.floating) && node.value.floating >= -0x1p63
+			&& node.value.floating < 0x1p63)
+			return static_cast<std::int64_t>(node.value.floating);
+		break;
+	case ScalarType::Text:
+		if (const auto value = parse_text<std::int64_t>(document_->strings[node.value.text]))
+			return *value;
+		break;
+	case ScalarType::Bool:
+		break;
+	}
+	throw SerializationError("Invalid scalar at " + path() + ": expected an integer");
+}
+
+std::uint64_t Deserializer::read_uint64() const
+{
+	const auto& node = document_->nodes[node_];
+	switch (node.type) {
+	case ScalarType::UInt:
+		return node.value.unsigned_integer;
+	case ScalarType::Int:
+		if (node.value.integer >= 0)
+			return static_cast<std::uint64_t>(node.value.integer);
+		break;
+	case ScalarType::Double:
+		if (node.value.floating == std::trunc(node.value.floating) && node.value.floating >= 0.0
+			&& node.value.floating < 0x1p64)
+			return static_cast<std::uint64_t>(node.value.floating);
+		break;
+	case ScalarType::Text:
+		if (const auto value = parse_text<std::uint64_t>(document_->strings[node.value.text]))
+			return *value;
+		break;
+	case ScalarType::Bool:
+		break;
+	}
+	throw SerializationError("Invalid scalar at " + path() + ": expected an unsigned integer");
 }
 
-std::string Deserializer::child_path(const std::string_view key) const
+double Deserializer::read_double() const
 {
-	return mapping_path(path_, key);
+	const auto& node = document_->nodes[node_];
+	switch (node.type) {
+	case ScalarType::Double:
+		return node.value.floating;
+	case ScalarType::Int:
+		return static_cast<double>(node.value.integer);
+	case ScalarType::UInt:
+		return static_cast<double>(node.value.unsigned_integer);
+	case ScalarType::Text:
+		if (const auto value = parse_text<double>(document_->strings[node.value.text]))
+			return *value;
+		break;
+	case ScalarType::Bool:
+		break;
+	}
+	throw SerializationError("Invalid scalar at " + path() + ": expected a number");
 }
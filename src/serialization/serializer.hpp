@@ -1,15 +1,16 @@
 #pragma once
 
-#include <yaml-cpp/yaml.h>
-
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <limits>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <variant>
 #include <vector>
 
 class SerializationError : public std::runtime_error
@@ -26,6 +27,14 @@ enum class SerializationKind
 	Mapping,
 };
 
+// YAML is the readable export and debug format; binary documents are what
+// saves normally use
+enum class SerializationFormat
+{
+	Yaml,
+	Binary,
+};
+
 namespace serialization_detail
 {
 template<typename T>
@@ -41,22 +50,27 @@ concept ReadableScalar = std::same_as<Bare<T>, bool>
 	|| (std::integral<Bare<T>> && !std::same_as<Bare<T>, char>)
 	|| std::floating_point<Bare<T>> || std::same_as<Bare<T>, std::string>;
 
+using ScalarValue = std::variant<bool, std::int64_t, std::uint64_t, double, std::string_view>;
+
 template<Scalar T>
-YAML::Node make_node(const T& value)
+ScalarValue make_scalar(const T& value)
 {
-	YAML::Node node;
 	if constexpr (std::same_as<Bare<T>, bool>)
-		node = value;
+		return value;
 	else if constexpr (std::integral<Bare<T>> && std::is_signed_v<Bare<T>>)
-		node = static_cast<std::int64_t>(value);
+		return static_cast<std::int64_t>(value);
 	else if constexpr (std::integral<Bare<T>>)
-		node = static_cast<std::uint64_t>(value);
+		return static_cast<std::uint64_t>(value);
 	else if constexpr (std::floating_point<Bare<T>>)
-		node = static_cast<double>(value);
+		return static_cast<double>(value);
 	else
-		node = std::string(std::string_view(value));
-	return node;
+		return std::string_view(value);
 }
+
+// Nodes of a serialized document live in one arena shared by every
+// Serializer or Deserializer view onto it; keys and written strings are
+// interned
+struct Document;
 }
 
 class Serializer
@@ -67,7 +81,7 @@ public:
 	template<serialization_detail::Scalar T>
 	void write(const std::string_view key, const T& value)
 	{
-		write_node(key, serialization_detail::make_node(value));
+		write_scalar(key, serialization_detail::make_scalar(value));
 	}
 
 	void write_null(std::string_view key);
@@ -77,7 +91,7 @@ public:
 	template<serialization_detail::Scalar T>
 	void append(const T& value)
 	{
-		append_node(serialization_detail::make_node(value));
+		append_scalar(serialization_detail::make_scalar(value));
 	}
 
 	void append_null();
@@ -85,18 +99,18 @@ public:
 	Serializer append_sequence();
 
 	[[nodiscard]] std::string emit() const;
+	// Versioned little-endian document; see serializer.cpp for the layout
+	[[nodiscard]] std::vector<std::byte> emit_binary() const;
 
 private:
-	Serializer(std::shared_ptr<YAML::Node> document, YAML::Node node, std::string path);
-	void write_node(std::string_view key, const YAML::Node& value);
-	void append_node(const YAML::Node& value);
-	[[nodiscard]] std::string child_path(std::string_view key) const;
-	void require_mapping() const;
-	void require_sequence() const;
-
-	std::shared_ptr<YAML::Node> document_;
-	YAML::Node node_;
-	std::string path_;
+	Serializer(std::shared_ptr<serialization_detail::Document> document, std::uint32_t node);
+	void write_scalar(std::string_view key, const serialization_detail::ScalarValue& value);
+	void append_scalar(const serialization_detail::ScalarValue& value);
+	[[nodiscard]] std::uint32_t add_entry(std::string_view key, SerializationKind kind);
+	[[nodiscard]] std::uint32_t add_element(SerializationKind kind);
+
+	std::shared_ptr<serialization_detail::Document> document_;
+	std::uint32_t node_;
 };
 
 class Deserializer
@@ -105,6 +119,7 @@ public:
 	using Kind = SerializationKind;
 
 	[[nodiscard]] static Deserializer parse(std::string_view yaml);
+	[[nodiscard]] static Deserializer parse_binary(std::span<const std::byte> bytes);
 	[[nodiscard]] Deserializer child(std::string_view key) const;
 
 	template<serialization_detail::ReadableScalar T>
@@ -117,39 +132,41 @@ public:
 	[[nodiscard]] serialization_detail::Bare<T> as() const
 	{
 		if (kind() != SerializationKind::Scalar)
-			throw SerializationError("Expected scalar at " + path_);
-		try {
-			using Value = serialization_detail::Bare<T>;
-			if constexpr (std::same_as<Value, std::string> || std::same_as<Value, bool>) {
-				return node_.as<Value>();
-			} else if constexpr (std::integral<Value> && std::is_signed_v<Value>) {
-				const auto value = node_.as<std::int64_t>();
-				if (value < std::numeric_limits<Value>::min() || value > std::numeric_limits<Value>::max())
-					throw SerializationError("Integer out of range at " + path_);
-				return static_cast<Value>(value);
-			} else if constexpr (std::integral<Value>) {
-				const auto value = node_.as<std::uint64_t>();
-				if (value > std::numeric_limits<Value>::max())
-					throw SerializationError("Integer out of range at " + path_);
-				return static_cast<Value>(value);
-			} else {
-				return node_.as<Value>();
-			}
-		} catch (const YAML::Exception& error) {
-			throw SerializationError("Invalid scalar at " + path_ + ": " + error.what());
+			throw SerializationError("Expected scalar at " + path());
+		using Value = serialization_detail::Bare<T>;
+		if constexpr (std::same_as<Value, std::string>) {
+			return read_string();
+		} else if constexpr (std::same_as<Value, bool>) {
+			return read_bool();
+		} else if constexpr (std::integral<Value> && std::is_signed_v<Value>) {
+			const auto value = read_int64();
+			if (value < std::numeric_limits<Value>::min() || value > std::numeric_limits<Value>::max())
+				throw SerializationError("Integer out of range at " + path());
+			return static_cast<Value>(value);
+		} else if constexpr (std::integral<Value>) {
+			const auto value = read_uint64();
+			if (value > std::numeric_limits<Value>::max())
+				throw SerializationError("Integer out of range at " + path());
+			return static_cast<Value>(value);
+		} else {
+			return static_cast<Value>(read_double());
 		}
 	}
 
 	[[nodiscard]] std::vector<Deserializer> elements() const;
 	[[nodiscard]] std::vector<std::string> keys() const;
 	[[nodiscard]] SerializationKind kind() const;
-	[[nodiscard]] const std::string& path() const { return path_; }
+	// Built on demand from the document, so only error paths pay for it
+	[[nodiscard]] std::string path() const;
 
 private:
-	Deserializer(std::shared_ptr<YAML::Node> document, YAML::Node node, std::string path);
-	[[nodiscard]] std::string child_path(std::string_view key) const;
-
-	std::shared_ptr<YAML::Node> document_;
-	YAML::Node node_;
-	std::string path_;
+	Deserializer(std::shared_ptr<const serialization_detail::Document> document, std::uint32_t node);
+	[[nodiscard]] std::string read_string() const;
+	[[nodiscard]] bool read_bool() const;
+	[[nodiscard]] std::int64_t read_int64() const;
+	[[nodiscard]] std::uint64_t read_uint64() const;
+	[[nodiscard]] double read_double() const;
+
+	std::shared_ptr<const serialization_detail::Document> document_;
+	std::uint32_t node_;
 };
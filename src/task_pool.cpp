@@ -0,0 +1,148 @@
+#include "task_pool.hpp"
+
+#include <algorithm>
+
+
+TaskPool::TaskPool(const uint32_t worker_count)
+{
+	workers.reserve(worker_count);
+	for (uint32_t index = 0; index < worker_count; ++index)
+		workers.emplace_back(&TaskPool::worker_loop, this);
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	task_available.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+bool TaskPool::run_pending_task()
+{
+	std::function<void()> task;
+	{
+		std::lock_guard lock(mutex);
+		if (tasks.empty())
+			return false;
+		task = std::move(tasks.front());
+		tasks.pop_front();
+	}
+	task();
+	return true;
+}
+
+TaskPool& TaskPool::get_shared()
+{
+	static TaskPool pool;
+	return pool;
+}
+
+uint32_t TaskPool::default_worker_count()
+{
+	// hardware_concurrency may report 0 when unknown
+	return std::max(2u, std::thread::hardware_concurrency()) - 1;
+}
+
+void TaskPool::run_range_job(RangeJob& job)
+{
+	const bool shared = job.range_count > 1 && !workers.empty();
+	if (shared)
+	{
+		{
+			std::lock_guard lock(mutex);
+			job.next = range_jobs;
+			range_jobs = &job;
+			job.listed = true;
+		}
+		task_available.notify_all();
+	}
+	run_ranges(job);
+	if (shared)
+	{
+		// workers that joined in may still be running the last ranges
+		std::unique_lock lock(mutex);
+		if (job.listed)
+			unlist(job);
+		range_job_finished.wait(lock, [&job]() { return job.helpers == 0; });
+	}
+	if (job.error)
+		std::rethrow_exception(job.error);
+}
+
+void TaskPool::run_ranges(RangeJob& job)
+{
+	for (size_t range = job.next_range++; range < job.range_count; range = job.next_range++)
+	{
+		const size_t first = range * job.range_size;
+		try
+		{
+			job.run(job.function, first, std::min(first + job.range_size, job.count));
+		}
+		catch (...)
+		{
+			std::lock_guard lock(job.error_mutex);
+			if (!job.error)
+				job.error = std::current_exception();
+		}
+	}
+}
+
+TaskPool::RangeJob* TaskPool::find_open_range_job()
+{
+	while (range_jobs)
+	{
+		if (range_jobs->next_range < range_jobs->range_count)
+			return range_jobs;
+		unlist(*range_jobs);
+	}
+	return nullptr;
+}
+
+void TaskPool::unlist(RangeJob& job)
+{
+	RangeJob** link = &range_jobs;
+	while (*link != &job)
+		link = &(*link)->next;
+	*link = job.next;
+	job.next = nullptr;
+	job.listed = false;
+}
+
+void TaskPool::worker_loop()
+{
+	std::unique_lock lock(mutex);
+	while (true)
+	{
+		task_available.wait(lock, [this]() { return stopping || range_jobs || !tasks.empty(); });
+		// a thread is blocked on every range job, so they come first
+		if (RangeJob* job = find_open_range_job())
+		{
+			++job->helpers;
+			lock.unlock();
+			run_ranges(*job);
+			lock.lock();
+			if (--job->helpers == 0)
+				range_job_finished.notify_all();
+			continue;
+		}
+		if (tasks.empty())
+		{
+			// queued tasks are drained before stopping so that no future is abandoned
+			if (stopping)
+				return;
+			continue;
+		}
+		{
+			// destroyed before relocking, as its captures may submit tasks
+			std::function<void()> task = std::move(tasks.front());
+			tasks.pop_front();
+			lock.unlock();
+			task();
+		}
+		lock.lock();
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+// Fixed set of worker threads servicing a FIFO queue of tasks. Tasks may wait
+// on tasks they submit themselves: wait() runs queued work on the calling
+// thread instead of blocking, so nested fork-join splits cannot starve the pool.
+// parallel_for does not go through the queue: idle workers join in on its
+// ranges ahead of queued tasks, and the caller only ever runs its own ranges.
+class TaskPool
+{
+public:
+	explicit TaskPool(uint32_t worker_count = default_worker_count());
+	~TaskPool();
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	template<typename Function>
+	std::future<std::invoke_result_t<Function>> submit(Function&& function);
+
+	// Blocks until the future is ready, executing other queued tasks meanwhile
+	template<typename Future>
+	void wait(const Future& future);
+
+	// Runs one queued task on the calling thread; returns false if none was queued
+	bool run_pending_task();
+
+	// Calls function(first, last) on consecutive ranges covering [0, count),
+	// a few per thread and none shorter than min_range_size, and returns when
+	// all have run. The calling thread takes ranges too, but never a queued
+	// task, so a frame's jobs cannot pick up long background work, and nothing
+	// is allocated. The first exception thrown by any range is rethrown once
+	// every range has finished.
+	template<typename Function>
+	void parallel_for(size_t count, size_t min_range_size, const Function& function);
+
+	uint32_t get_worker_count() const { return static_cast<uint32_t>(workers.size()); }
+
+	// Process-wide pool for background engine work such as derived mesh data
+	static TaskPool& get_shared();
+	// Leaves one hardware thread for the caller
+	static uint32_t default_worker_count();
+
+private:
+	// One parallel_for call, on the stack of its calling thread
+	struct RangeJob
+	{
+		void (*run)(const void* function, size_t first, size_t last) = nullptr;
+		const void* function = nullptr;
+		size_t count = 0;
+		size_t range_size = 0;
+		size_t range_count = 0;
+		std::atomic<size_t> next_range = 0;
+		std::mutex error_mutex;
+		std::exception_ptr error;
+		// guarded by the pool's mutex
+		RangeJob* next = nullptr;
+		bool listed = false;
+		uint32_t helpers = 0;
+	};
+
+	void worker_loop();
+	void run_range_job(RangeJob& job);
+	// Runs ranges of job until all have been taken
+	static void run_ranges(RangeJob& job);
+	// Unlists jobs whose ranges have all been taken and returns the first
+	// other one; the mutex must be held
+	RangeJob* find_open_range_job();
+	void unlist(RangeJob& job);
+
+	std::mutex mutex;
+	std::condition_variable task_available;
+	std::condition_variable range_job_finished;
+	std::deque<std::function<void()>> tasks;
+	RangeJob* range_jobs = nullptr;
+	std::vector<std::thread> workers;
+	bool stopping = false;
+};
+
+template<typename Function>
+std::future<std::invoke_result_t<Function>> TaskPool::submit(Function&& function)
+{
+	// std::function requires copyable targets, so share the move-only task
+	using Result = std::invoke_result_t<Function>;
+	auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+	std::future<Result> future = task->get_future();
+	{
+		std::lock_guard lock(mutex);
+		tasks.emplace_back([task]() { (*task)(); });
+	}
+	task_available.notify_one();
+	return future;
+}
+
+template<typename Future>
+void TaskPool::wait(const Future& future)
+{
+	while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		if (!run_pending_task())
+			future.wait_for(std::chrono::microseconds(100));
+	}
+}
+
+template<typename Function>
+void TaskPool::parallel_for(const size_t count, const size_t min_range_size, const Function& function)
+{
+	if (count == 0)
+		return;
+	RangeJob job;
+	job.run = [](const void* function, const size_t first, const size_t last)
+	{
+		(*static_cast<const Function*>(function))(first, last);
+	};
+	job.function = &function;
+	job.count = count;
+	// several ranges per thread, so that threads with cheap ranges take more
+	job.range_size = std::max<size_t>(
+		{ min_range_size, count / ((get_worker_count() + 1) * 4), 1 });
+	job.range_count = (count + job.range_size - 1) / job.range_size;
+	run_range_job(job);
+}
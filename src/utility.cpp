@@ -134,6 +134,30 @@ std::filesystem::path Utility::get_user_config_path(std::string_view filename)
 	return config_root / "krisp" / Config::get_project_name() / filename;
 }
 
+std::filesystem::path Utility::get_derived_data_path()
+{
+	std::filesystem::path cache_root;
+	if (get().test_mode)
+	{
+		cache_root = std::filesystem::temp_directory_path();
+	}
+	else if (const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+		xdg_cache_home && *xdg_cache_home)
+	{
+		cache_root = xdg_cache_home;
+	}
+	else if (const char* home = std::getenv("HOME"); home && *home)
+	{
+		cache_root = std::filesystem::path(home) / ".cache";
+	}
+	else
+	{
+		cache_root = std::filesystem::temp_directory_path();
+	}
+
+	return cache_root / "krisp" / Config::get_project_name() / "derived_data";
+}
+
 std::filesystem::path Utility::get_rsrc_path(bool use_default)
 {
 	if (use_default)
@@ -32,6 +32,8 @@ public:
 	static std::filesystem::path get_saves_path() { return get().top_level_dir / ".saves"; }
 	static std::filesystem::path get_config_path(std::string_view filename);
 	static std::filesystem::path get_user_config_path(std::string_view filename);
+	// Where imported resources are cached; disposable, unlike user config
+	static std::filesystem::path get_derived_data_path();
 
 	static std::filesystem::path get_texture(std::string_view filename);
 	static std::filesystem::path get_model(std::string_view filename);
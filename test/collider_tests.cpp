@@ -2,11 +2,14 @@
 
 #include <collision/collider.hpp>
 #include <collision/collision_detector.hpp>
+#include <collision/collider_bvh.hpp>
 #include <entity_component_system/mesh_system.hpp>
 #include <renderable/mesh_factory.hpp>
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 namespace
 {
 MeshHandle add_test_mesh(
@@ -240,3 +243,98 @@ TEST(collider_tests, tiled_quad_with_various_rays)
     result = CollisionDetector::check_collision(&ray, &quad);
     ASSERT_FALSE(result.bCollided);
 }
+
+TEST(collider_tests, collider_bvh_stays_balanced_and_visits_nearer_leaves_first)
+{
+    ColliderBvh bvh;
+    std::vector<uint32_t> leaves;
+    for (uint64_t index = 0; index < 64; ++index)
+    {
+        const glm::vec3 centre(0.0f, 0.0f, static_cast<float>(index) * 2.0f);
+        leaves.push_back(bvh.insert(EntityID(index), AABB(centre - glm::vec3(0.5f), centre + glm::vec3(0.5f))));
+    }
+    ASSERT_EQ(bvh.size(), 64u);
+    // an AVL-balanced tree with 64 leaves has at most 1.44 * log2(127) levels
+    EXPECT_LE(bvh.get_height(), 10u);
+
+    std::vector<uint64_t> visited;
+    bvh.raycast(Maths::Ray(glm::vec3(0.0f, 0.0f, -5.0f), Maths::forward_vec),
+        std::numeric_limits<float>::infinity(),
+        [&visited](const EntityID id, const float max_t)
+        {
+            visited.push_back(id.get_underlying());
+            // stop once the third box along the ray is confirmed
+            return visited.size() == 3 ? 9.0f : max_t;
+        });
+    ASSERT_EQ(visited.size(), 3u);
+    EXPECT_EQ(visited, (std::vector<uint64_t>{ 0, 1, 2 }));
+
+    // small motions stay within the enlarged leaf bounds
+    EXPECT_FALSE(bvh.update(leaves[0], AABB(glm::vec3(-0.45f), glm::vec3(0.55f))));
+    EXPECT_TRUE(bvh.update(leaves[0], AABB(glm::vec3(9.5f), glm::vec3(10.5f))));
+    bvh.remove(leaves[1]);
+    EXPECT_EQ(bvh.size(), 63u);
+}
+
+TEST(collider_tests, mesh_pick_data_matches_a_scalar_scan_of_every_triangle)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for (uint32_t triangle = 0; triangle < 2000; ++triangle)
+    {
+        const glm::vec3 centre(offset(generator) * 10.0f, offset(generator) * 10.0f, offset(generator) * 10.0f);
+        for (int vertex = 0; vertex < 3; ++vertex)
+        {
+            indices.push_back(static_cast<uint32_t>(positions.size()));
+            positions.push_back(centre + glm::vec3(offset(generator), offset(generator), offset(generator)));
+        }
+    }
+    const MeshPickData data(positions, indices);
+    ASSERT_EQ(sizeof(MeshBvhNode), 32u);
+    ASSERT_GT(data.get_nodes().size(), 1u);
+
+    // every leaf covers a contiguous range and together they cover every triangle once
+    uint32_t covered = 0;
+    for (const auto& node : data.get_nodes())
+    {
+        if (!node.is_leaf())
+            continue;
+        ASSERT_LE(node.offset + node.count, data.get_triangles().size());
+        covered += node.count;
+    }
+    ASSERT_EQ(covered, data.get_triangles().size());
+
+    for (int index = 0; index < 500; ++index)
+    {
+        const Maths::Ray ray(
+            glm::vec3(offset(generator) * 12.0f, offset(generator) * 12.0f, -20.0f),
+            index % 5 == 0 ? Maths::forward_vec : glm::vec3(offset(generator) * 0.3f, offset(generator) * 0.3f, 1.0f));
+
+        float expected_t = std::numeric_limits<float>::infinity();
+        for (const auto& triangle : data.get_triangles())
+        {
+            const glm::vec3& p0 = positions[triangle.vertices[0]];
+            const glm::vec3 edge1 = positions[triangle.vertices[1]] - p0;
+            const glm::vec3 edge2 = positions[triangle.vertices[2]] - p0;
+            const glm::vec3 p = glm::cross(ray.direction, edge2);
+            const float determinant = glm::dot(edge1, p);
+            if (Maths::absf(determinant) <= Maths::ACCEPTABLE_FLOATING_PT_DIFF)
+                continue;
+            const glm::vec3 origin_to_triangle = ray.origin - p0;
+            const float u = glm::dot(origin_to_triangle, p) / determinant;
+            const glm::vec3 q = glm::cross(origin_to_triangle, edge1);
+            const float v = glm::dot(ray.direction, q) / determinant;
+            const float t = glm::dot(edge2, q) / determinant;
+            if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f)
+                expected_t = std::min(expected_t, t);
+        }
+
+        float closest_t = std::numeric_limits<float>::infinity();
+        const bool hit = data.raycast(ray, closest_t);
+        ASSERT_EQ(hit, expected_t != std::numeric_limits<float>::infinity());
+        if (hit)
+            ASSERT_NEAR(closest_t, expected_t, 1e-4f);
+    }
+}
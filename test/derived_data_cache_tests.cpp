@@ -0,0 +1,366 @@
+#include <resource_loader/derived_data_cache.hpp>
+#include <resource_loader/resource_loader.hpp>
+#include <entity_component_system/ecs.hpp>
+#include <entity_component_system/mesh_system.hpp>
+#include <utility.hpp>
+
+#include <gtest/gtest.h>
+#include <tiny_gltf.h>
+#include <fmt/core.h>
+
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <typeinfo>
+#include <vector>
+
+
+namespace
+{
+std::vector<std::byte> make_bytes(const size_t size, const uint8_t seed)
+{
+	std::vector<std::byte> bytes(size);
+	for (size_t index = 0; index < size; ++index)
+		bytes[index] = static_cast<std::byte>((index * 31 + seed) & 0xff);
+	return bytes;
+}
+
+bool same_bytes(const std::span<const std::byte> first, const std::span<const std::byte> second)
+{
+	return first.size() == second.size() && std::memcmp(first.data(), second.data(), first.size()) == 0;
+}
+
+// A cache in its own temporary directory, installed as the resource loader's
+// cache for the lifetime of the fixture
+class DerivedDataCacheTest : public testing::Test
+{
+public:
+	DerivedDataCacheTest()
+	{
+		static uint32_t sequence = 0;
+		directory = std::filesystem::temp_directory_path()
+			/ fmt::format("krisp_test_derived_data_{}_{}", ::getpid(), sequence++);
+		std::filesystem::remove_all(directory);
+		cache = std::make_shared<DerivedDataCache>(directory);
+		previous_cache = ResourceLoader::get_derived_data_cache();
+		ResourceLoader::set_derived_data_cache(cache);
+	}
+
+	~DerivedDataCacheTest()
+	{
+		ResourceLoader::set_derived_data_cache(previous_cache);
+		std::error_code error;
+		std::filesystem::remove_all(directory, error);
+	}
+
+	std::filesystem::path directory;
+	std::shared_ptr<DerivedDataCache> cache;
+	std::shared_ptr<DerivedDataCache> previous_cache;
+};
+
+const TextureMaterial* find_texture(const Renderable& renderable, const ETextureSemantic semantic)
+{
+	for (const auto& owner : renderable.material_owners)
+		if (const auto* material = dynamic_cast<const TextureMaterial*>(&owner->get());
+			material && material->semantic == semantic)
+			return material;
+	return nullptr;
+}
+
+void expect_same_renderable(const Renderable& cold, const Renderable& warm)
+{
+	EXPECT_EQ(cold.pipeline_render_type, warm.pipeline_render_type);
+	EXPECT_EQ(cold.local_transform.get_mat4(), warm.local_transform.get_mat4());
+
+	const auto& cold_mesh = cold.mesh_owner->get();
+	const auto& warm_mesh = warm.mesh_owner->get();
+	EXPECT_EQ(typeid(cold_mesh), typeid(warm_mesh));
+	EXPECT_TRUE(same_bytes(std::span(cold_mesh.get_vertices_data(), cold_mesh.get_vertices_data_size()),
+		std::span(warm_mesh.get_vertices_data(), warm_mesh.get_vertices_data_size())));
+	EXPECT_TRUE(same_bytes(std::span(cold_mesh.get_indices_data(), cold_mesh.get_indices_data_size()),
+		std::span(warm_mesh.get_indices_data(), warm_mesh.get_indices_data_size())));
+
+	// the warm mesh's pick data comes from the cache rather than a rebuild
+	EXPECT_TRUE(warm_mesh.is_pick_data_ready());
+	const auto& cold_pick = cold_mesh.get_pick_data();
+	const auto& warm_pick = warm_mesh.get_pick_data();
+	EXPECT_TRUE(same_bytes(std::as_bytes(std::span(cold_pick.get_triangles())),
+		std::as_bytes(std::span(warm_pick.get_triangles()))));
+	EXPECT_TRUE(same_bytes(std::as_bytes(std::span(cold_pick.get_nodes())),
+		std::as_bytes(std::span(warm_pick.get_nodes()))));
+	for (const auto& triangle : cold_pick.get_triangles())
+	{
+		const auto& positions = cold_pick.get_positions();
+		const glm::vec3 centroid = (positions[triangle.vertices[0]] + positions[triangle.vertices[1]]
+			+ positions[triangle.vertices[2]]) / 3.0f;
+		const Maths::Ray ray(centroid + glm::vec3(0.3f, 10.0f, 0.2f), glm::vec3(-0.03f, -1.0f, -0.02f));
+		float cold_t = std::numeric_limits<float>::max();
+		float warm_t = std::numeric_limits<float>::max();
+		EXPECT_EQ(cold_pick.raycast(ray, cold_t), warm_pick.raycast(ray, warm_t));
+		EXPECT_EQ(cold_t, warm_t);
+	}
+
+	ASSERT_EQ(cold.material_owners.size(), warm.material_owners.size());
+	const auto* cold_pbr = dynamic_cast<const PbrMaterial*>(&cold.material_owners.front()->get());
+	const auto* warm_pbr = dynamic_cast<const PbrMaterial*>(&warm.material_owners.front()->get());
+	ASSERT_NE(cold_pbr, nullptr);
+	ASSERT_NE(warm_pbr, nullptr);
+	EXPECT_TRUE(same_bytes(std::as_bytes(std::span(&cold_pbr->data, 1)), std::as_bytes(std::span(&warm_pbr->data, 1))));
+	EXPECT_EQ(cold_pbr->properties.alpha_mode, warm_pbr->properties.alpha_mode);
+	EXPECT_EQ(cold_pbr->properties.double_sided, warm_pbr->properties.double_sided);
+	for (size_t semantic = 0; semantic < static_cast<size_t>(ETextureSemantic::COUNT); ++semantic)
+	{
+		const auto* cold_texture = find_texture(cold, static_cast<ETextureSemantic>(semantic));
+		const auto* warm_texture = find_texture(warm, static_cast<ETextureSemantic>(semantic));
+		ASSERT_EQ(cold_texture == nullptr, warm_texture == nullptr);
+		if (!cold_texture)
+			continue;
+		EXPECT_EQ(cold_texture->width, warm_texture->width);
+		EXPECT_EQ(cold_texture->height, warm_texture->height);
+		EXPECT_EQ(cold_texture->format, warm_texture->format);
+		EXPECT_EQ(cold_texture->source, warm_texture->source);
+		EXPECT_EQ(cold_texture->mip_sizes, warm_texture->mip_sizes);
+		EXPECT_TRUE(same_bytes(std::span(cold_texture->data->get(), cold_texture->data_len),
+			std::span(warm_texture->data->get(), warm_texture->data_len)));
+	}
+}
+
+void expect_same_model(
+	ECS& cold_ecs,
+	const ResourceLoader::LoadedModel& cold,
+	ECS& warm_ecs,
+	const ResourceLoader::LoadedModel& warm)
+{
+	ASSERT_EQ(cold.warnings.size(), warm.warnings.size());
+	for (size_t index = 0; index < cold.warnings.size(); ++index)
+		EXPECT_EQ(cold.warnings[index].message, warm.warnings[index].message);
+
+	ASSERT_EQ(cold.meshes.size(), warm.meshes.size());
+	for (size_t mesh = 0; mesh < cold.meshes.size(); ++mesh)
+	{
+		const auto& cold_mesh = cold.meshes[mesh];
+		const auto& warm_mesh = warm.meshes[mesh];
+		EXPECT_EQ(cold_mesh.name, warm_mesh.name);
+		EXPECT_EQ(cold_mesh.source_node, warm_mesh.source_node);
+		EXPECT_EQ(cold_mesh.source_skin, warm_mesh.source_skin);
+		ASSERT_EQ(cold_mesh.skeleton_id.has_value(), warm_mesh.skeleton_id.has_value());
+		if (cold_mesh.skeleton_id)
+		{
+			const auto& cold_bones = cold_ecs.get_skeletal_component(*cold_mesh.skeleton_id).get_bones();
+			const auto& warm_bones = warm_ecs.get_skeletal_component(*warm_mesh.skeleton_id).get_bones();
+			ASSERT_EQ(cold_bones.size(), warm_bones.size());
+			for (size_t bone = 0; bone < cold_bones.size(); ++bone)
+			{
+				EXPECT_EQ(cold_bones[bone].name, warm_bones[bone].name);
+				EXPECT_EQ(cold_bones[bone].parent_node, warm_bones[bone].parent_node);
+				EXPECT_EQ(cold_bones[bone].relative_transform.get_mat4(), warm_bones[bone].relative_transform.get_mat4());
+				EXPECT_EQ(cold_bones[bone].inverse_bind_pose.get_mat4(), warm_bones[bone].inverse_bind_pose.get_mat4());
+			}
+		}
+		ASSERT_EQ(cold_mesh.renderables.size(), warm_mesh.renderables.size());
+		for (size_t renderable = 0; renderable < cold_mesh.renderables.size(); ++renderable)
+			expect_same_renderable(cold_mesh.renderables[renderable], warm_mesh.renderables[renderable]);
+	}
+}
+
+// A copy of a test model whose buffer is stored beside it rather than embedded
+class ExternalBufferGltf
+{
+public:
+	explicit ExternalBufferGltf(std::string_view template_filename)
+	{
+		static uint32_t sequence = 0;
+		const auto name = fmt::format("krisp_test_external_buffer_{}", sequence++);
+		path = Utility::get_top_level_path()/"test/data" / (name + ".gltf");
+		buffer_path = Utility::get_top_level_path()/"test/data" / (name + ".bin");
+		tinygltf::TinyGLTF loader;
+		std::string error;
+		std::string warning;
+		EXPECT_TRUE(loader.LoadASCIIFromFile(&model, &error, &warning, Utility::get_model(template_filename).string()))
+			<< error;
+		model.buffers.at(0).uri = buffer_path.filename().string();
+		EXPECT_TRUE(loader.WriteGltfSceneToFile(&model, path.string(), true, false, true, false));
+	}
+
+	~ExternalBufferGltf()
+	{
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		std::filesystem::remove(buffer_path, error);
+	}
+
+	// Rewrites the buffer with the first vertex of the first primitive moved
+	void move_first_vertex(const glm::vec3& position)
+	{
+		const auto& accessor = model.accessors.at(model.meshes.at(0).primitives.at(0).attributes.at("POSITION"));
+		const auto& view = model.bufferViews.at(accessor.bufferView);
+		auto& bytes = model.buffers.at(0).data;
+		std::memcpy(bytes.data() + view.byteOffset + accessor.byteOffset, &position, sizeof(position));
+		std::ofstream output(buffer_path, std::ios::binary | std::ios::trunc);
+		output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	tinygltf::Model model;
+	std::filesystem::path path;
+	std::filesystem::path buffer_path;
+	std::string filename() const { return path.filename().string(); }
+};
+}
+
+TEST_F(DerivedDataCacheTest, stores_and_maps_aligned_sections)
+{
+	const auto first = make_bytes(1000, 1);
+	const auto second = make_bytes(3, 2);
+	const auto key = DerivedDataCache::KeyBuilder().add("entry").add(uint64_t{ 7 }).build();
+	DerivedDataCache::EntryWriter writer;
+	EXPECT_EQ(writer.add_section(first), 0u);
+	EXPECT_EQ(writer.add_owned_section(second), 1u);
+	EXPECT_EQ(writer.add_section({}), 2u);
+	ASSERT_TRUE(cache->store(key, writer));
+	EXPECT_TRUE(cache->contains(key));
+
+	const auto entry = cache->find(key);
+	ASSERT_NE(entry, nullptr);
+	ASSERT_EQ(entry->get_section_count(), 3u);
+	EXPECT_TRUE(same_bytes(entry->get_section(0), first));
+	EXPECT_TRUE(same_bytes(entry->get_section(1), second));
+	EXPECT_TRUE(entry->get_section(2).empty());
+	for (size_t section = 0; section < 2; ++section)
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(entry->get_section(section).data()) % DerivedDataCache::SECTION_ALIGNMENT, 0u);
+	EXPECT_THROW(entry->get_section(3), std::out_of_range);
+
+	const auto stats = cache->get_stats();
+	EXPECT_EQ(stats.hits, 1u);
+	EXPECT_EQ(stats.misses, 0u);
+	EXPECT_EQ(stats.stores, 1u);
+}
+
+TEST_F(DerivedDataCacheTest, misses_unknown_keys_and_malformed_entries)
+{
+	const auto key = DerivedDataCache::KeyBuilder().add("entry").build();
+	EXPECT_EQ(cache->find(key), nullptr);
+
+	DerivedDataCache::EntryWriter writer;
+	const auto bytes = make_bytes(256, 3);
+	writer.add_section(bytes);
+	ASSERT_TRUE(cache->store(key, writer));
+	const auto entry_path = directory / (key.to_string() + ".kddc");
+	ASSERT_TRUE(std::filesystem::exists(entry_path));
+	std::filesystem::resize_file(entry_path, 100);
+	EXPECT_EQ(cache->find(key), nullptr);
+
+	// an entry renamed to another key's name is rejected as well
+	ASSERT_TRUE(cache->store(key, writer));
+	const auto other_key = DerivedDataCache::KeyBuilder().add("other entry").build();
+	std::filesystem::copy_file(entry_path, directory / (other_key.to_string() + ".kddc"));
+	EXPECT_EQ(cache->find(other_key), nullptr);
+	EXPECT_NE(cache->find(key), nullptr);
+
+	const auto stats = cache->get_stats();
+	EXPECT_EQ(stats.hits, 1u);
+	EXPECT_EQ(stats.misses, 3u);
+}
+
+TEST(DerivedDataCacheKeys, depend_on_every_field_and_its_boundaries)
+{
+	using KeyBuilder = DerivedDataCache::KeyBuilder;
+	EXPECT_EQ(KeyBuilder().add("model").add(uint64_t{ 1 }).build(), KeyBuilder().add("model").add(uint64_t{ 1 }).build());
+	EXPECT_NE(KeyBuilder().add("ab").add("c").build(), KeyBuilder().add("a").add("bc").build());
+	EXPECT_NE(KeyBuilder().add(uint64_t{ 1 }).build(), KeyBuilder().add(uint64_t{ 2 }).build());
+
+	const auto bytes = make_bytes(100, 4);
+	EXPECT_EQ(DerivedDataCache::hash(bytes), DerivedDataCache::hash(make_bytes(100, 4)));
+	EXPECT_NE(DerivedDataCache::hash(bytes), DerivedDataCache::hash(make_bytes(100, 5)));
+	EXPECT_EQ(DerivedDataCache::hash_file(Utility::get_model("simple_test_model.gltf")),
+		DerivedDataCache::hash_file(Utility::get_model("simple_test_model.gltf")));
+	EXPECT_FALSE(DerivedDataCache::hash_file(Utility::get_top_level_path() / "test/data/missing.gltf"));
+}
+
+TEST_F(DerivedDataCacheTest, warm_model_loads_match_cold_loads)
+{
+	for (const auto* filename : { "static_mesh_textured.gltf", "simple_test_model.gltf", "multi_mesh_multi_primitive.gltf" })
+	{
+		SCOPED_TRACE(filename);
+		const auto stores = cache->get_stats().stores;
+		ECS cold_ecs;
+		const auto cold = ResourceLoader::load_model(cold_ecs, filename);
+		// the model and the list of files it was derived from
+		EXPECT_EQ(cache->get_stats().stores, stores + 2);
+
+		const auto hits = cache->get_stats().hits;
+		ECS warm_ecs;
+		const auto warm = ResourceLoader::load_model(warm_ecs, filename);
+		EXPECT_EQ(cache->get_stats().hits, hits + 2);
+		EXPECT_EQ(cache->get_stats().stores, stores + 2);
+		expect_same_model(cold_ecs, cold, warm_ecs, warm);
+	}
+}
+
+TEST_F(DerivedDataCacheTest, load_options_are_part_of_the_key)
+{
+	ECS ecs;
+	ResourceLoader::LoadOptions options;
+	ResourceLoader::load_model(ecs, "static_mesh_textured.gltf", options);
+	const auto stores = cache->get_stats().stores;
+
+	options.texture_processing = ETextureProcessing::NONE;
+	const auto unprocessed = ResourceLoader::load_model(ecs, "static_mesh_textured.gltf", options);
+	EXPECT_EQ(cache->get_stats().stores, stores + 1);
+	const auto* texture = find_texture(unprocessed.meshes[0].renderables[0], ETextureSemantic::BASE_COLOR);
+	ASSERT_NE(texture, nullptr);
+	EXPECT_EQ(texture->format, ETextureFormat::RGBA8);
+	EXPECT_EQ(texture->mip_sizes.size(), 1u);
+
+	options.use_derived_data_cache = false;
+	ResourceLoader::load_model(ecs, "static_mesh_textured.gltf", options);
+	EXPECT_EQ(cache->get_stats().stores, stores + 1);
+}
+
+TEST_F(DerivedDataCacheTest, changed_external_buffer_invalidates_cached_model)
+{
+	ExternalBufferGltf resource("static_mesh_textured.gltf");
+	ECS ecs;
+	const auto original = ResourceLoader::load_model(ecs, resource.filename());
+	const auto stores = cache->get_stats().stores;
+	const auto cached = ResourceLoader::load_model(ecs, resource.filename());
+	EXPECT_EQ(cache->get_stats().stores, stores);
+	expect_same_model(ecs, original, ecs, cached);
+
+	resource.move_first_vertex(glm::vec3(-0.5f, -0.5f, 0.0f));
+	const auto changed = ResourceLoader::load_model(ecs, resource.filename());
+	EXPECT_EQ(cache->get_stats().stores, stores + 1);
+	const auto& original_mesh = original.meshes[0].renderables[0].mesh_owner->get();
+	const auto& changed_mesh = changed.meshes[0].renderables[0].mesh_owner->get();
+	EXPECT_FALSE(same_bytes(std::span(original_mesh.get_vertices_data(), original_mesh.get_vertices_data_size()),
+		std::span(changed_mesh.get_vertices_data(), changed_mesh.get_vertices_data_size())));
+}
+
+TEST_F(DerivedDataCacheTest, unreadable_cached_model_falls_back_to_import)
+{
+	ECS ecs;
+	const auto original = ResourceLoader::load_model(ecs, "simple_test_model.gltf");
+	for (const auto& file : std::filesystem::directory_iterator(directory))
+	{
+		// a model entry's last section describes the others; fill it with 0xff
+		std::fstream stream(file.path(), std::ios::binary | std::ios::in | std::ios::out);
+		uint64_t section_count = 0;
+		stream.seekg(24);
+		stream.read(reinterpret_cast<char*>(&section_count), sizeof(section_count));
+		if (section_count < 2)
+			continue;
+		uint64_t record[2] = {};
+		stream.seekg(static_cast<std::streamoff>(32 + (section_count - 1) * sizeof(record)));
+		stream.read(reinterpret_cast<char*>(record), sizeof(record));
+		stream.seekp(static_cast<std::streamoff>(record[0]));
+		const std::vector<char> filler(record[1], static_cast<char>(0xff));
+		stream.write(filler.data(), static_cast<std::streamsize>(filler.size()));
+	}
+
+	const auto stores = cache->get_stats().stores;
+	const auto reloaded = ResourceLoader::load_model(ecs, "simple_test_model.gltf");
+	EXPECT_EQ(cache->get_stats().stores, stores + 1);
+	expect_same_model(ecs, original, ecs, reloaded);
+}
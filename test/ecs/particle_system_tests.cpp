@@ -0,0 +1,138 @@
+#include <entity_component_system/ecs.hpp>
+#include <entity_component_system/particle_system.hpp>
+#include <task_pool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+namespace
+{
+std::vector<SDS::ParticleInstanceData> instances_of(const ParticleEmitter& emitter)
+{
+	std::vector<SDS::ParticleInstanceData> instances(emitter.size());
+	emitter.write_instances(instances.data());
+	return instances;
+}
+
+// Half a second of 40 emitters that spawn and lose particles every tick
+std::vector<SDS::ParticleInstanceData> simulate_particles(TaskPool& pool)
+{
+	ECS ecs;
+	ecs.set_particle_task_pool(pool);
+	std::vector<std::unique_ptr<Object>> objects;
+	for (int index = 0; index < 40; ++index)
+	{
+		objects.push_back(std::make_unique<Object>());
+		ecs.add_object(*objects.back());
+		ecs.set_position(objects.back()->get_id(), glm::vec3(index, 0.0f, -index));
+		ParticleEmitterConfig config;
+		config.max_particles = 2000;
+		config.emission_rate = 3000.0f;
+		config.min_lifetime = 0.1f;
+		config.max_lifetime = 0.4f;
+		ecs.spawn_particle_emitter(objects.back()->get_id(), config);
+	}
+
+	ParticleSystem& particles = ecs;
+	for (int tick = 0; tick < 30; ++tick)
+		particles.process(1.0f / 60.0f);
+	std::vector<SDS::ParticleInstanceData> instances;
+	particles.prepare_render_data(instances);
+	return instances;
+}
+}
+
+TEST(ParticleEmitter, integrates_every_particle_including_the_final_partial_batch)
+{
+	ParticleEmitterConfig config;
+	config.max_particles = 11;
+	config.emission_rate = 0.0f;
+	config.min_lifetime = config.max_lifetime = 2.0f;
+	config.min_size = config.max_size = 0.25f;
+	config.velocity_min = config.velocity_max = { 1.0f, 2.0f, -4.0f };
+	config.rotation_speed_min = config.rotation_speed_max = 0.5f;
+	config.start_color = { 1.0f, 0.0f, 0.0f, 1.0f };
+	config.end_color = { 0.0f, 0.0f, 1.0f, 0.0f };
+
+	ParticleEmitter emitter(config, 1);
+	emitter.emit(20, glm::vec3(3.0f, 0.0f, 0.0f));
+	ASSERT_EQ(emitter.size(), 11u);
+	const auto emitted = instances_of(emitter);
+	emitter.process(0.5f, glm::vec3(0.0f));
+
+	const auto instances = instances_of(emitter);
+	ASSERT_EQ(instances.size(), 11u);
+	for (size_t index = 0; index < instances.size(); ++index)
+	{
+		const auto& instance = instances[index];
+		EXPECT_FLOAT_EQ(instance.position.x, 3.5f);
+		EXPECT_FLOAT_EQ(instance.position.y, 1.0f);
+		EXPECT_FLOAT_EQ(instance.position.z, -2.0f);
+		EXPECT_FLOAT_EQ(instance.size, 0.25f);
+		EXPECT_FLOAT_EQ(instance.rotation, emitted[index].rotation + 0.25f);
+		// lerped from start to end by remaining / maximum lifetime
+		EXPECT_FLOAT_EQ(instance.color.r, 0.25f);
+		EXPECT_FLOAT_EQ(instance.color.b, 0.75f);
+		EXPECT_FLOAT_EQ(instance.color.a, 0.25f);
+	}
+}
+
+TEST(ParticleEmitter, swap_removal_keeps_exactly_the_living_particles)
+{
+	// the red channel follows the remaining lifetime
+	ParticleEmitterConfig config;
+	config.max_particles = 1003;
+	config.emission_rate = 0.0f;
+	config.loop = false;
+	config.min_lifetime = 0.05f;
+	config.max_lifetime = 1.0f;
+	config.start_color = glm::vec4(0.0f);
+	config.end_color = glm::vec4(1.0f);
+
+	ParticleEmitter emitter(config, 1);
+	emitter.emit(config.max_particles, glm::vec3(0.0f));
+	// colors are derived from lifetimes as particles are processed
+	emitter.process(0.0f, glm::vec3(0.0f));
+	ASSERT_EQ(emitter.size(), config.max_particles);
+	const float delta_time = 0.1f;
+	while (emitter.size() > 0)
+	{
+		std::vector<float> expected;
+		for (const auto& instance : instances_of(emitter))
+			if (instance.color.r > delta_time)
+				expected.push_back(instance.color.r - delta_time);
+
+		emitter.process(delta_time, glm::vec3(0.0f));
+
+		std::vector<float> remaining;
+		for (const auto& instance : instances_of(emitter))
+			remaining.push_back(instance.color.r);
+		std::ranges::sort(expected);
+		std::ranges::sort(remaining);
+		ASSERT_EQ(remaining.size(), expected.size());
+		for (size_t index = 0; index < remaining.size(); ++index)
+			EXPECT_NEAR(remaining[index], expected[index], 1e-5f);
+	}
+	EXPECT_FALSE(emitter.is_alive());
+}
+
+TEST(ParticleSystem, results_do_not_depend_on_the_thread_count)
+{
+	TaskPool single_pool(1);
+	const auto expected = simulate_particles(single_pool);
+	ASSERT_GT(expected.size(), 10'000u);
+
+	for (const uint32_t worker_count : { 4u, 16u })
+	{
+		TaskPool pool(worker_count);
+		const auto instances = simulate_particles(pool);
+		ASSERT_EQ(instances.size(), expected.size()) << worker_count << " workers";
+		EXPECT_EQ(std::memcmp(instances.data(), expected.data(), expected.size() * sizeof(SDS::ParticleInstanceData)), 0)
+			<< worker_count << " workers";
+	}
+}
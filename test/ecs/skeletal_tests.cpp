@@ -1,9 +1,13 @@
 #include <entity_component_system/ecs.hpp>
 #include <serialization/resource_provenance.hpp>
+#include <task_pool.hpp>
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace
 {
@@ -36,6 +40,50 @@ struct SkeletalAnimationFixture
 	SkeletonID skeleton_id;
 	AnimationID animation_id;
 };
+
+BoneAnimation::TrackKey<glm::vec4> rotation_key(const float secs, const float degrees, const glm::vec3& axis)
+{
+	const auto rotation = glm::angleAxis(glm::radians(degrees), axis);
+	return { secs, glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w), {}, {} };
+}
+
+// Adds a skeleton playing the fixture's clip, skinning a renderable on an
+// object placed at position
+SkeletonID add_animated_skeleton(SkeletalAnimationFixture& fixture,
+	std::vector<std::unique_ptr<Object>>& objects, const glm::vec3& position)
+{
+	Bone bone;
+	bone.name = "root";
+	const SkeletonID skeleton_id = fixture.ecs.add_skeleton({ bone });
+	objects.push_back(std::make_unique<Object>());
+	fixture.ecs.add_object(*objects.back());
+	fixture.ecs.set_position(objects.back()->get_id(), position);
+	auto renderable = Renderable::make_default(fixture.ecs);
+	renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+	fixture.ecs.add_renderable(renderable, objects.back()->get_id(), skeleton_id);
+	fixture.ecs.play_animation(skeleton_id, fixture.animation_id);
+	return skeleton_id;
+}
+
+void expect_pose_matches(const AnimationPose& pose, const size_t bone, const Maths::Transform& expected)
+{
+	const glm::vec3 translation = pose.get_translation(bone);
+	const glm::vec3 scale = pose.get_scale(bone);
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		EXPECT_NEAR(translation[axis], expected.get_pos()[axis], 0.00001f);
+		EXPECT_NEAR(scale[axis], expected.get_scale()[axis], 0.00001f);
+	}
+	// nlerp between keys 20 degrees apart stays close to slerp
+	glm::quat rotation = pose.get_rotation(bone);
+	const glm::quat expected_rotation = glm::normalize(expected.get_orient());
+	if (glm::dot(rotation, expected_rotation) < 0.0f)
+		rotation = -rotation;
+	EXPECT_NEAR(rotation.x, expected_rotation.x, 0.001f);
+	EXPECT_NEAR(rotation.y, expected_rotation.y, 0.001f);
+	EXPECT_NEAR(rotation.z, expected_rotation.z, 0.001f);
+	EXPECT_NEAR(rotation.w, expected_rotation.w, 0.001f);
+}
 }
 
 TEST(SkeletalSystem, exposes_only_const_bone_topology)
@@ -265,3 +313,305 @@ TEST(SkeletalAnimationSystem, aligns_cubic_rotation_keys_and_tangents_to_one_hem
 	EXPECT_NEAR(orientation.x, 0.0f, 0.0001f);
 	EXPECT_NEAR(std::abs(orientation.w), 1.0f, 0.0001f);
 }
+
+TEST(SkeletalAnimationSystem, poses_skeletons_identically_on_any_task_pool)
+{
+	// plays the fixture's clip on many skeletons at different speeds, some
+	// cross-fading, and returns each root bone's position
+	const auto animate = [](const uint32_t worker_count)
+	{
+		TaskPool pool(worker_count);
+		SkeletalAnimationFixture fixture;
+		fixture.ecs.set_skeletal_task_pool(pool);
+		Bone bone;
+		bone.name = "root";
+		std::vector<SkeletonID> skeleton_ids;
+		for (int index = 0; index < 40; ++index)
+		{
+			skeleton_ids.push_back(fixture.ecs.add_skeleton({ bone }));
+			fixture.ecs.play_animation(skeleton_ids.back(), fixture.animation_id, true);
+			fixture.ecs.set_animation_speed(skeleton_ids.back(), 1.0f + 0.05f * static_cast<float>(index));
+		}
+		fixture.ecs.process(0.3f);
+		for (size_t index = 0; index < skeleton_ids.size(); index += 3)
+			fixture.ecs.crossfade_animation(skeleton_ids[index], fixture.animation_id, 0.5f, true);
+		fixture.ecs.process(0.1f);
+
+		std::vector<glm::vec3> positions;
+		for (const SkeletonID id : skeleton_ids)
+			positions.push_back(fixture.ecs.get_skeletal_component(id).get_bones()[0].relative_transform.get_pos());
+		return positions;
+	};
+
+	const auto serial = animate(0);
+	ASSERT_EQ(serial.size(), 40u);
+	EXPECT_FLOAT_EQ(serial[1].x, 2.0f * 0.4f * 1.05f);
+	EXPECT_EQ(animate(4), serial);
+}
+
+TEST(SkeletalAnimationSystem, assigns_animation_lods_by_distance_and_visibility)
+{
+	SkeletalAnimationFixture fixture;
+	std::vector<std::unique_ptr<Object>> objects;
+	fixture.ecs.set_animation_lod_settings({ .enabled = true, .distances = { 10.0f, 30.0f, 50.0f } });
+	fixture.ecs.set_animation_lod_viewpoint({ 0.0f, 0.0f, 5.0f });
+	fixture.ecs.play_animation(fixture.skeleton_id, fixture.animation_id);
+	const SkeletonID near = add_animated_skeleton(fixture, objects, { 0.0f, 0.0f, 0.0f });
+	const SkeletonID reduced = add_animated_skeleton(fixture, objects, { 20.0f, 0.0f, 5.0f });
+	const SkeletonID low = add_animated_skeleton(fixture, objects, { 0.0f, -40.0f, 5.0f });
+	const SkeletonID far = add_animated_skeleton(fixture, objects, { 0.0f, 0.0f, 100.0f });
+	const SkeletonID hidden = add_animated_skeleton(fixture, objects, { 0.0f, 0.0f, 0.0f });
+	for (const RenderableID id : fixture.ecs.get_renderable_ids(objects.back()->get_id()))
+		fixture.ecs.set_renderable_visibility(id, false);
+
+	fixture.ecs.process(0.25f);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(fixture.skeleton_id), EAnimationLod::FULL);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(near), EAnimationLod::FULL);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(reduced), EAnimationLod::REDUCED);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(low), EAnimationLod::LOW);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(far), EAnimationLod::FROZEN);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(hidden), EAnimationLod::FROZEN);
+	const auto& counters = fixture.ecs.get_animation_lod_counters();
+	EXPECT_EQ(counters.skeletons, (std::array<size_t, 4>{ 2, 1, 1, 2 }));
+	EXPECT_EQ(counters.sampled, 4u);
+	const auto bone_x = [&fixture](const SkeletonID id)
+	{
+		return fixture.ecs.get_skeletal_component(id).get_bones()[0].relative_transform.get_pos().x;
+	};
+	EXPECT_FLOAT_EQ(bone_x(near), 0.5f);
+	EXPECT_FLOAT_EQ(bone_x(far), 0.0f);
+	EXPECT_FLOAT_EQ(bone_x(hidden), 0.0f);
+
+	fixture.ecs.set_animation_lod_settings({});
+	fixture.ecs.process(0.25f);
+	EXPECT_EQ(fixture.ecs.get_animation_lod_counters().skeletons, (std::array<size_t, 4>{ 6, 0, 0, 0 }));
+	EXPECT_FLOAT_EQ(bone_x(far), 1.0f);
+}
+
+TEST(SkeletalAnimationSystem, interpolates_between_poses_sampled_every_few_ticks)
+{
+	SkeletalAnimationFixture fixture;
+	std::vector<std::unique_ptr<Object>> objects;
+	AnimationLodSettings settings;
+	settings.enabled = true;
+	settings.distances = { 10.0f, 30.0f, 50.0f };
+	const SkeletonID low = add_animated_skeleton(fixture, objects, { 40.0f, 0.0f, 0.0f });
+	const SkeletonID held = add_animated_skeleton(fixture, objects, { 40.0f, 0.0f, 0.0f });
+	fixture.ecs.set_animation_lod_settings(settings);
+
+	// the clip moves the bone linearly, so blending between samples is exact
+	const auto& low_bone = fixture.ecs.get_skeletal_component(low).get_bones()[0];
+	for (int tick = 1; tick <= 12; ++tick)
+	{
+		fixture.ecs.process(0.05f);
+		EXPECT_NEAR(low_bone.relative_transform.get_pos().x, 0.1f * static_cast<float>(tick), 0.0001f);
+		const auto& counters = fixture.ecs.get_animation_lod_counters();
+		EXPECT_EQ(counters.sampled, tick % 4 == 1 ? 2u : 0u);
+		EXPECT_EQ(counters.interpolated, tick % 4 == 1 ? 0u : 2u);
+	}
+
+	settings.interpolate = false;
+	fixture.ecs.set_animation_lod_settings(settings);
+	const auto& held_bone = fixture.ecs.get_skeletal_component(held).get_bones()[0];
+	for (int tick = 13; tick <= 16; ++tick)
+	{
+		fixture.ecs.process(0.05f);
+		EXPECT_NEAR(held_bone.relative_transform.get_pos().x, 1.3f, 0.0001f);
+	}
+}
+
+TEST(SkeletalAnimationSystem, skips_leaf_bones_at_low_lods)
+{
+	ECS ecs;
+	Bone root;
+	root.name = "root";
+	Bone leaf;
+	leaf.name = "leaf";
+	leaf.parent_node = 0;
+	const SkeletonID skeleton_id = ecs.add_skeleton({ root, leaf });
+	EXPECT_EQ(ecs.get_skeletal_component(skeleton_id).get_inner_bone_mask(), (std::vector<uint8_t>{ 1, 0 }));
+	BoneAnimation bone_animation;
+	bone_animation.animation_start_secs = 0.0f;
+	bone_animation.animation_end_secs = 1.0f;
+	bone_animation.translation_track.keys = {
+		{ 0.0f, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f) },
+		{ 1.0f, glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f) },
+	};
+	const AnimationID animation_id = ecs.add_skeletal_animation(
+		"move", { bone_animation, bone_animation }, make_skeletal_rig_signature({ root, leaf }));
+	Object object;
+	ecs.add_object(object);
+	ecs.set_position(object.get_id(), { 100.0f, 0.0f, 0.0f });
+	auto renderable = Renderable::make_default(ecs);
+	renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+	ecs.add_renderable(renderable, object.get_id(), skeleton_id);
+	ecs.play_animation(skeleton_id, animation_id);
+	ecs.set_animation_lod_settings({ .enabled = true, .distances = { 10.0f, 20.0f, 200.0f }, .interpolate = false });
+
+	ecs.process(0.25f);
+	const auto& bones = ecs.get_skeletal_component(skeleton_id).get_bones();
+	EXPECT_FLOAT_EQ(bones[0].relative_transform.get_pos().x, 0.5f);
+	EXPECT_FLOAT_EQ(bones[1].relative_transform.get_pos().x, 0.0f);
+}
+
+TEST(SkeletalAnimationSystem, defers_samples_beyond_the_tick_budget_without_starving_skeletons)
+{
+	SkeletalAnimationFixture fixture;
+	std::vector<std::unique_ptr<Object>> objects;
+	std::vector<SkeletonID> skeleton_ids;
+	for (int index = 0; index < 10; ++index)
+		skeleton_ids.push_back(add_animated_skeleton(fixture, objects, { static_cast<float>(index), 0.0f, 0.0f }));
+	fixture.ecs.set_animation_lod_settings({ .enabled = true, .max_updates_per_tick = 4 });
+
+	fixture.ecs.process(0.05f);
+	EXPECT_EQ(fixture.ecs.get_animation_lod_counters().sampled, 4u);
+	EXPECT_EQ(fixture.ecs.get_animation_lod_counters().deferred, 6u);
+	// nearest first, then the most overdue
+	for (size_t index = 0; index < skeleton_ids.size(); ++index)
+	{
+		const float x = fixture.ecs.get_skeletal_component(skeleton_ids[index]).get_bones()[0].relative_transform.get_pos().x;
+		EXPECT_FLOAT_EQ(x, index < 4 ? 0.1f : 0.0f);
+	}
+	fixture.ecs.process(0.05f);
+	fixture.ecs.process(0.05f);
+	for (size_t index = 4; index < skeleton_ids.size(); ++index)
+		EXPECT_GT(fixture.ecs.get_skeletal_component(skeleton_ids[index]).get_bones()[0].relative_transform.get_pos().x, 0.0f);
+}
+
+TEST(SkeletalAnimationSystem, budgets_skeletons_brought_nearer_by_how_overdue_they_are)
+{
+	SkeletalAnimationFixture fixture;
+	std::vector<std::unique_ptr<Object>> objects;
+	const SkeletonID nearest = add_animated_skeleton(fixture, objects, { 0.0f, 0.0f, 0.0f });
+	const SkeletonID near = add_animated_skeleton(fixture, objects, { 1.0f, 0.0f, 0.0f });
+	const SkeletonID approaching = add_animated_skeleton(fixture, objects, { 40.0f, 0.0f, 0.0f });
+	const ObjectID approaching_object = objects.back()->get_id();
+	AnimationLodSettings settings{ .enabled = true, .distances = { 10.0f, 30.0f, 50.0f }, .interpolate = false };
+	fixture.ecs.set_animation_lod_settings(settings);
+	fixture.ecs.process(0.05f);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(approaching), EAnimationLod::LOW);
+
+	// one tick into its interval of four, the approaching skeleton becomes due
+	// at FULL, but is no more overdue than the others
+	fixture.ecs.set_position(approaching_object, { 2.0f, 0.0f, 0.0f });
+	settings.max_updates_per_tick = 1;
+	fixture.ecs.set_animation_lod_settings(settings);
+	fixture.ecs.process(0.05f);
+	EXPECT_EQ(fixture.ecs.get_animation_lod(approaching), EAnimationLod::FULL);
+	EXPECT_EQ(fixture.ecs.get_animation_lod_counters().deferred, 2u);
+	const auto bone_x = [&fixture](const SkeletonID id)
+	{
+		return fixture.ecs.get_skeletal_component(id).get_bones()[0].relative_transform.get_pos().x;
+	};
+	EXPECT_FLOAT_EQ(bone_x(nearest), 0.2f);
+	EXPECT_FLOAT_EQ(bone_x(near), 0.1f);
+	EXPECT_FLOAT_EQ(bone_x(approaching), 0.1f);
+}
+
+TEST(CompiledAnimationClip, matches_bone_animation_when_playing_and_seeking)
+{
+	const glm::vec3 z_axis(0.0f, 0.0f, 1.0f);
+	std::vector<BoneAnimation> bone_animations(4);
+
+	auto& linear = bone_animations[0];
+	linear.animation_start_secs = 0.0f;
+	linear.animation_end_secs = 1.0f;
+	linear.translation_track.keys = {
+		{ 0.0f, glm::vec3(0.0f, 1.0f, 2.0f), {}, {} },
+		{ 0.1f, glm::vec3(1.0f, -1.0f, 0.5f), {}, {} },
+		{ 0.45f, glm::vec3(3.0f, 2.0f, -2.0f), {}, {} },
+		{ 1.0f, glm::vec3(-1.0f, 0.0f, 4.0f), {}, {} },
+	};
+	linear.rotation_track.keys = {
+		rotation_key(0.0f, 0.0f, z_axis),
+		rotation_key(0.3f, 20.0f, z_axis),
+		rotation_key(0.6f, 40.0f, z_axis),
+		rotation_key(1.0f, 25.0f, z_axis),
+	};
+	linear.scale_track.interpolation = BoneAnimation::Interpolation::STEP;
+	linear.scale_track.keys = {
+		{ 0.2f, glm::vec3(1.0f), {}, {} },
+		{ 0.5f, glm::vec3(2.0f), {}, {} },
+		{ 0.8f, glm::vec3(0.5f, 1.0f, 3.0f), {}, {} },
+	};
+
+	// ends early, after which the bone returns to its rest pose
+	auto& cubic = bone_animations[1];
+	cubic.animation_start_secs = 0.0f;
+	cubic.animation_end_secs = 0.6f;
+	cubic.base_transform = Maths::Transform(glm::vec3(0.0f), glm::vec3(3.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	cubic.translation_track.interpolation = BoneAnimation::Interpolation::CUBIC_SPLINE;
+	cubic.translation_track.keys = {
+		{ 0.0f, glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, -1.0f) },
+		{ 0.25f, glm::vec3(1.0f, 2.0f, 0.0f), glm::vec3(2.0f, 0.0f, 1.0f), glm::vec3(-1.0f, 3.0f, 0.0f) },
+		{ 0.6f, glm::vec3(0.0f, 1.0f, 1.0f), glm::vec3(0.5f), glm::vec3(0.0f) },
+	};
+	cubic.rotation_track.interpolation = BoneAnimation::Interpolation::CUBIC_SPLINE;
+	cubic.rotation_track.keys = {
+		rotation_key(0.0f, 90.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+		rotation_key(0.6f, 110.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+	};
+
+	// a single key holds for the whole clip
+	auto& held = bone_animations[2];
+	held.animation_start_secs = 0.0f;
+	held.animation_end_secs = 1.0f;
+	held.rotation_track.keys = { rotation_key(0.5f, -60.0f, z_axis) };
+	// bone_animations[3] has no tracks and always shows the rest pose
+
+	AnimationPose rest_pose;
+	rest_pose.resize(bone_animations.size());
+	std::vector<Maths::Transform> rest_transforms;
+	for (size_t bone = 0; bone < bone_animations.size(); ++bone)
+	{
+		const float offset = static_cast<float>(bone);
+		rest_transforms.emplace_back(glm::vec3(offset, 0.5f, -offset), glm::vec3(1.0f + offset),
+			glm::angleAxis(glm::radians(10.0f * offset), glm::vec3(0.0f, 1.0f, 0.0f)));
+		rest_pose.set(bone, rest_transforms.back().get_pos(),
+			rest_transforms.back().get_orient(), rest_transforms.back().get_scale());
+	}
+
+	const CompiledAnimationClip clip(bone_animations);
+	EXPECT_EQ(clip.get_bone_count(), bone_animations.size());
+	AnimationCursor cursor;
+	AnimationPose pose;
+	std::vector<float> times;
+	for (int step = 0; step <= 24; ++step)
+		times.push_back(0.05f * static_cast<float>(step));
+	// seeking backwards must not reuse the cached keys
+	for (const float time : { 0.7f, 0.12f, -0.5f, 0.45f, 0.95f, 0.3f })
+		times.push_back(time);
+
+	for (const float time : times)
+	{
+		clip.sample(time, cursor, rest_pose, pose);
+		ASSERT_EQ(pose.size(), bone_animations.size());
+		for (size_t bone = 0; bone < bone_animations.size(); ++bone)
+		{
+			Maths::Transform expected = rest_transforms[bone];
+			bone_animations[bone].get_transform(time, expected);
+			expect_pose_matches(pose, bone, expected);
+		}
+	}
+}
+
+TEST(CompiledAnimationClip, blends_poses_along_the_shortest_rotation_path)
+{
+	AnimationPose from;
+	AnimationPose to;
+	from.resize(1);
+	to.resize(1);
+	from.set(0, glm::vec3(0.0f), glm::angleAxis(glm::radians(170.0f), glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(1.0f));
+	to.set(0, glm::vec3(2.0f, 4.0f, -2.0f), glm::angleAxis(glm::radians(-170.0f), glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(3.0f));
+
+	AnimationPose blended;
+	blend_poses(from, to, 0.25f, blended);
+	ASSERT_EQ(blended.size(), 1u);
+	EXPECT_FLOAT_EQ(blended.get_translation(0).x, 0.5f);
+	EXPECT_FLOAT_EQ(blended.get_translation(0).y, 1.0f);
+	EXPECT_FLOAT_EQ(blended.get_scale(0).z, 1.5f);
+	const glm::quat rotation = blended.get_rotation(0);
+	// a quarter of the 20 degrees through 180, not of the 340 degrees through 0
+	EXPECT_NEAR(std::abs(rotation.z), std::sin(glm::radians(175.0f) * 0.5f), 0.001f);
+	EXPECT_NEAR(std::abs(rotation.w), std::abs(std::cos(glm::radians(175.0f) * 0.5f)), 0.001f);
+}
@@ -5,8 +5,12 @@
 #include <serialization/serialization_helpers.hpp>
 
 #include <gtest/gtest.h>
+#include <glm/gtc/matrix_transform.hpp>
 
+#include <span>
+#include <stdexcept>
 #include <type_traits>
+#include <vector>
 
 
 static_assert(!std::is_copy_constructible_v<TransformationComponent>);
@@ -130,6 +134,88 @@ TEST(TransformationSystemTests, rejects_self_and_descendant_cycles_without_mutat
 	EXPECT_EQ(transformations.get_parent_id(grandchild), child);
 }
 
+TEST(TransformationSystemTests, batch_update_matches_lazy_reads_after_reparenting_and_slot_reuse)
+{
+	TransformationSystem batched;
+	TransformationSystem lazy;
+	std::vector<EntityID> ids;
+	for (uint64_t index = 1; index <= 8; ++index)
+	{
+		ids.emplace_back(index);
+		for (auto* transformations : { &batched, &lazy })
+		{
+			transformations->add_transformation(ids.back());
+			transformations->set_relative_position(ids.back(), { static_cast<float>(index), 0.0f, 1.0f });
+		}
+	}
+
+	// chain later entities under earlier ones, then hang the root of the chain
+	// beneath the newest entity so that parents follow children in creation order
+	for (auto* transformations : { &batched, &lazy })
+	{
+		for (size_t index = 1; index < 6; ++index)
+			ASSERT_TRUE(transformations->attach_to(ids[index], ids[index - 1]));
+		transformations->remove_transformation(ids[6]);
+		transformations->add_transformation(EntityID(9));
+		ASSERT_TRUE(transformations->attach_to(ids[0], EntityID(9)));
+		transformations->set_relative_rotation(EntityID(9), glm::angleAxis(Maths::PI / 2.0f, Maths::up_vec));
+		transformations->set_relative_position(ids[2], { 0.0f, 2.0f, 0.0f });
+	}
+
+	batched.update_world_transforms();
+	ids[6] = EntityID(9);
+	for (const auto id : ids)
+	{
+		EXPECT_TRUE(glm_equal(batched.get_transform(id), lazy.get_transform(id)));
+		EXPECT_EQ(batched.get_parent_id(id), lazy.get_parent_id(id));
+	}
+	EXPECT_TRUE(glm_equal(batched.get_position(ids[5]), lazy.get_position(ids[5])));
+}
+
+TEST(TransformationSystemTests, batched_poses_match_individual_setters_and_keep_scale)
+{
+	TransformationSystem batched;
+	TransformationSystem individual;
+	const EntityID parent(1);
+	const std::vector<EntityID> ids = { EntityID(2), EntityID(3), EntityID(4) };
+	const std::vector<glm::vec3> positions = { { 1.0f, 2.0f, 3.0f }, { -4.0f, 0.0f, 2.0f }, { 0.0f, 5.0f, -1.0f } };
+	const std::vector<glm::quat> rotations = {
+		glm::angleAxis(0.3f, Maths::up_vec),
+		glm::angleAxis(-1.2f, Maths::right_vec),
+		glm::angleAxis(2.0f, Maths::forward_vec) };
+	for (auto* transformations : { &batched, &individual })
+	{
+		transformations->add_transformation(parent);
+		transformations->set_transform(parent, glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, 0.0f))
+			* glm::mat4_cast(glm::angleAxis(0.7f, Maths::up_vec)));
+		for (const auto id : ids)
+		{
+			transformations->add_transformation(id);
+			transformations->set_scale(id, glm::vec3(1.0f, 2.0f, 3.0f));
+		}
+		ASSERT_TRUE(transformations->attach_to(ids[1], parent));
+	}
+
+	batched.set_poses(ids, positions, rotations);
+	for (size_t index = 0; index < ids.size(); ++index)
+	{
+		individual.set_position(ids[index], positions[index]);
+		individual.set_rotation(ids[index], rotations[index]);
+	}
+	for (size_t index = 0; index < ids.size(); ++index)
+	{
+		EXPECT_TRUE(glm_equal(batched.get_transform(ids[index]), individual.get_transform(ids[index])));
+		EXPECT_TRUE(glm_equal(batched.get_position(ids[index]), positions[index]));
+		EXPECT_TRUE(glm_equal(batched.get_rotation(ids[index]), rotations[index]));
+		EXPECT_TRUE(glm_equal(batched.get_scale(ids[index]), glm::vec3(1.0f, 2.0f, 3.0f)));
+	}
+
+	batched.set_positions(std::span(ids).first(1), std::span(positions).last(1));
+	EXPECT_TRUE(glm_equal(batched.get_position(ids[0]), positions[2]));
+	EXPECT_THROW(batched.set_positions(ids, std::span(positions).first(2)), std::invalid_argument);
+	EXPECT_THROW(batched.set_poses(ids, positions, std::span(rotations).first(1)), std::invalid_argument);
+}
+
 TEST(TransformationSystemSerialization, round_trips_persistent_hierarchy_and_retains_transients)
 {
 	TransformationSystem source;
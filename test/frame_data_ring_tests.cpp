@@ -0,0 +1,71 @@
+#include <graphics_engine/resource_manager/frame_data_ring.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+
+TEST(FrameDataRing, packs_allocations_at_the_alignment)
+{
+	std::vector<std::byte> memory(FrameDataRing::get_buffer_size(1024, 3, 256));
+	FrameDataRing ring(memory.data(), 1024, 3, 256);
+	ring.begin_frame(0);
+
+	EXPECT_EQ(ring.allocate(192).offset, 0);
+	EXPECT_EQ(ring.allocate(192).offset, 256);
+	EXPECT_EQ(ring.allocate(4).offset, 512);
+	EXPECT_EQ(ring.get_region_used(), 516);
+}
+
+TEST(FrameDataRing, gives_each_frame_its_own_region)
+{
+	std::vector<std::byte> memory(FrameDataRing::get_buffer_size(1000, 3, 64));
+	FrameDataRing ring(memory.data(), 1000, 3, 64);
+
+	// regions are rounded up to the alignment so offsets in them stay aligned
+	EXPECT_EQ(ring.get_region_capacity(), 1024);
+	ring.begin_frame(2);
+	EXPECT_EQ(ring.allocate(16).offset, 2048);
+	ring.begin_frame(1);
+	EXPECT_EQ(ring.get_region_used(), 0);
+	EXPECT_EQ(ring.allocate(16).offset, 1024);
+}
+
+TEST(FrameDataRing, writes_data_at_the_returned_offset)
+{
+	std::vector<std::byte> memory(FrameDataRing::get_buffer_size(256, 2, 16));
+	FrameDataRing ring(memory.data(), 256, 2, 16);
+	ring.begin_frame(1);
+	ring.allocate(4);
+
+	const float values[3] = { 1.0f, 2.0f, 3.0f };
+	const uint32_t offset = ring.write(values, sizeof(values));
+
+	ASSERT_EQ(offset, 272);
+	EXPECT_EQ(std::memcmp(memory.data() + offset, values, sizeof(values)), 0);
+}
+
+TEST(FrameDataRing, throws_when_a_frame_region_is_full)
+{
+	std::vector<std::byte> memory(FrameDataRing::get_buffer_size(256, 2, 64));
+	FrameDataRing ring(memory.data(), 256, 2, 64);
+	ring.begin_frame(0);
+	ring.allocate(100);
+
+	// the next region belongs to another frame in flight
+	EXPECT_THROW(ring.allocate(129), std::runtime_error);
+	EXPECT_EQ(ring.allocate(128).offset, 128);
+}
+
+TEST(FrameDataRing, rejects_invalid_arguments)
+{
+	std::vector<std::byte> memory(256);
+	EXPECT_THROW(FrameDataRing(memory.data(), 128, 2, 48), std::invalid_argument);
+	EXPECT_THROW(FrameDataRing(nullptr, 128, 2, 64), std::invalid_argument);
+	EXPECT_THROW(FrameDataRing(memory.data(), 128, 0, 64), std::invalid_argument);
+
+	FrameDataRing ring(memory.data(), 128, 2, 64);
+	EXPECT_THROW(ring.begin_frame(2), std::out_of_range);
+}
@@ -0,0 +1,102 @@
+#include "collision/frustum.hpp"
+#include "graphics_engine/render_draw_list.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+// Looks down +z from the origin with a 90 degree field of view
+Frustum make_camera_frustum()
+{
+	const glm::mat4 view = glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const glm::mat4 projection = glm::perspectiveLH(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+	return Frustum::from_view_projection(projection * view);
+}
+
+AABB box_at(const glm::vec3& centre, const float half_extent = 0.5f)
+{
+	return AABB(centre - glm::vec3(half_extent), centre + glm::vec3(half_extent));
+}
+}
+
+
+TEST(Frustum, perspective_planes_bound_the_view_volume)
+{
+	const Frustum frustum = make_camera_frustum();
+
+	EXPECT_TRUE(frustum.intersects(box_at({ 0.0f, 0.0f, 10.0f })));
+	EXPECT_TRUE(frustum.intersects(box_at({ 9.0f, -9.0f, 10.0f })));
+	EXPECT_FALSE(frustum.intersects(box_at({ 0.0f, 0.0f, -10.0f })));
+	EXPECT_FALSE(frustum.intersects(box_at({ 0.0f, 0.0f, 200.0f })));
+	EXPECT_FALSE(frustum.intersects(box_at({ -20.0f, 0.0f, 10.0f })));
+	EXPECT_FALSE(frustum.intersects(box_at({ 0.0f, 20.0f, 10.0f })));
+	// straddling the far plane and a side plane
+	EXPECT_TRUE(frustum.intersects(box_at({ 0.0f, 0.0f, 100.0f }, 2.0f)));
+	EXPECT_TRUE(frustum.intersects(box_at({ 11.0f, 0.0f, 10.0f }, 2.0f)));
+}
+
+TEST(FrustumCuller, matches_the_scalar_test_for_every_box)
+{
+	const Frustum frustum = make_camera_frustum();
+	std::mt19937 generator(3);
+	std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> half_extent(0.1f, 10.0f);
+
+	FrustumCuller culler;
+	std::vector<AABB> boxes;
+	// not a whole number of batches, so the final one is partial
+	for (int index = 0; index < 1003; ++index)
+	{
+		boxes.push_back(box_at({ position(generator), position(generator), position(generator) }, half_extent(generator)));
+		EXPECT_EQ(culler.add(boxes.back()), static_cast<uint32_t>(index));
+	}
+
+	std::vector<uint32_t> expected;
+	for (uint32_t index = 0; index < boxes.size(); ++index)
+		if (frustum.intersects(boxes[index]))
+			expected.push_back(index);
+	ASSERT_FALSE(expected.empty());
+	ASSERT_LT(expected.size(), boxes.size());
+
+	std::vector<uint32_t> visible{ 42 };
+	culler.cull(frustum, visible);
+	EXPECT_EQ(visible, expected);
+
+	culler.clear();
+	culler.cull(frustum, visible);
+	EXPECT_TRUE(visible.empty());
+}
+
+TEST(FrustumCuller, point_shadow_faces_split_the_space_around_the_light)
+{
+	const glm::vec3 light_position(5.0f, 2.0f, -3.0f);
+	const auto view_projections = make_point_shadow_view_projections(light_position);
+	std::array<Frustum, POINT_SHADOW_FACE_COUNT> faces;
+	for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+		faces[face] = Frustum::from_view_projection(view_projections[face]);
+
+	// faces follow the cube map order +x, -x, +y, -y, +z, -z
+	const std::array<glm::vec3, POINT_SHADOW_FACE_COUNT> directions = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+	};
+	FrustumCuller culler;
+	for (const auto& direction : directions)
+		culler.add(box_at(light_position + direction * 20.0f));
+	// beyond the far plane of the +x face
+	culler.add(box_at(light_position + directions[0] * (POINT_SHADOW_FAR_PLANE + 10.0f)));
+
+	std::vector<uint32_t> visible;
+	for (size_t face = 0; face < POINT_SHADOW_FACE_COUNT; ++face)
+	{
+		culler.cull(faces[face], visible);
+		EXPECT_EQ(visible, std::vector<uint32_t>{ static_cast<uint32_t>(face) }) << "face " << face;
+	}
+}
@@ -670,7 +670,7 @@ TEST_F(GameEngineTests, scene_round_trips_generated_mesh_and_pbr_material)
 	const auto path = save_path(save_name);
 
 	engine.save_scene(save_name);
-	EXPECT_TRUE(std::filesystem::is_regular_file(path / "scene.yaml"));
+	EXPECT_TRUE(std::filesystem::is_regular_file(path / "scene.bin"));
 	EXPECT_EQ(std::ranges::count_if(std::filesystem::directory_iterator(path), [](const auto& entry) {
 		return entry.path().extension() == ".dat";
 	}), 1);
@@ -1097,7 +1097,7 @@ TEST_F(GameEngineTests, scene_round_trips_imported_factor_material_by_provenance
 	const std::string save_name = "krisp_scene_imported_resource_test";
 	const auto path = save_path(save_name);
 
-	engine.save_scene(save_name);
+	engine.save_scene(save_name, SerializationFormat::Yaml);
 	std::ifstream yaml(path / "scene.yaml");
 	const std::string contents((std::istreambuf_iterator<char>(yaml)), {});
 	EXPECT_NE(contents.find("kind: model"), std::string::npos);
@@ -1135,7 +1135,7 @@ TEST_F(GameEngineTests, scene_round_trips_imported_skeleton_and_animation_by_pro
 	const std::string save_name = "krisp_scene_imported_animation_test";
 	const auto path = save_path(save_name);
 
-	engine.save_scene(save_name);
+	engine.save_scene(save_name, SerializationFormat::Yaml);
 	std::ifstream yaml(path / "scene.yaml");
 	const std::string contents((std::istreambuf_iterator<char>(yaml)), {});
 	EXPECT_NE(contents.find("imported_source:"), std::string::npos);
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <vector>
 
 TEST(player_character_tests, maps_resolved_input_to_all_walking_directions)
 {
@@ -255,6 +256,69 @@ TEST(gameplay_collision_tests, transient_colliders_require_an_explicit_candidate
 	EXPECT_EQ(ecs.raycast(ray, candidates).id, transient_id);
 }
 
+TEST(gameplay_collision_tests, raycast_follows_collider_motion_and_removal)
+{
+	ECS ecs;
+	Object parent;
+	Object child;
+	ecs.add_object(parent);
+	ecs.add_object(child);
+	ecs.set_position(child.get_id(), { 0.0f, 0.0f, 2.0f });
+	ecs.add_collider(child.get_id(), std::make_unique<SphereCollider>(Maths::Sphere(Maths::zero_vec, 0.5f)));
+	ASSERT_TRUE(ecs.attach_to(child.get_id(), parent.get_id()));
+	const Maths::Ray ray(Maths::zero_vec, Maths::forward_vec);
+	ASSERT_EQ(ecs.raycast(ray).id, child.get_id());
+
+	ecs.set_position(child.get_id(), { 10.0f, 0.0f, 2.0f });
+	EXPECT_FALSE(ecs.raycast(ray).bCollided);
+
+	// moving the parent moves the child's collider with it
+	ecs.set_position(parent.get_id(), { -10.0f, 0.0f, 0.0f });
+	const auto hit = ecs.raycast(ray);
+	ASSERT_TRUE(hit.bCollided);
+	EXPECT_EQ(hit.id, child.get_id());
+	EXPECT_TRUE(glm_equal(hit.intersection, glm::vec3(0.0f, 0.0f, 1.5f)));
+
+	ecs.remove_collider(child.get_id());
+	EXPECT_FALSE(ecs.raycast(ray).bCollided);
+}
+
+TEST(gameplay_collision_tests, raycast_matches_candidate_scan_over_all_colliders)
+{
+	ECS ecs;
+	std::vector<EntityID> ids;
+	for (int x = 0; x < 12; ++x)
+	{
+		for (int z = 0; z < 12; ++z)
+		{
+			const EntityID id = EntityID::generate_new_id();
+			ecs.add_transformation(id);
+			ecs.set_position(id, { x * 1.5f, (x + z) % 3 * 0.5f, z * 1.5f });
+			ecs.set_scale(id, glm::vec3(0.5f + (x * z) % 4 * 0.25f));
+			if ((x + z) % 2 == 0)
+				ecs.add_collider(id, std::make_unique<BoxCollider>());
+			else
+				ecs.add_collider(id, std::make_unique<SphereCollider>(Maths::Sphere(Maths::zero_vec, 0.5f)));
+			ids.push_back(id);
+		}
+	}
+
+	for (int index = 0; index < 64; ++index)
+	{
+		const glm::vec3 origin(index % 8 * 2.0f, 5.0f, index / 8 * 2.0f - 4.0f);
+		const glm::vec3 direction = glm::normalize(glm::vec3(0.3f, -1.0f, 0.2f + index % 5 * 0.1f));
+		const Maths::Ray ray(origin, direction);
+		const auto expected = ecs.raycast(ray, ids);
+		const auto actual = ecs.raycast(ray);
+		ASSERT_EQ(actual.bCollided, expected.bCollided);
+		if (expected.bCollided)
+		{
+			EXPECT_EQ(actual.id, expected.id);
+			EXPECT_TRUE(glm_equal(actual.intersection, expected.intersection));
+		}
+	}
+}
+
 TEST(skeletal_component_tests, model_space_transforms_compose_parent_hierarchy)
 {
 	Bone root;
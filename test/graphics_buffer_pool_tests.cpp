@@ -0,0 +1,115 @@
+#include <graphics_engine/resource_manager/graphics_buffer_pool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+
+class GraphicsBufferPoolFixture : public testing::Test
+{
+public:
+	GraphicsBufferPool make_pool(const uint32_t block_capacity, const uint32_t max_block_count = 4)
+	{
+		return GraphicsBufferPool("pool", block_capacity, alignment, max_block_count,
+			[this](const size_t capacity, const uint32_t block_alignment, std::string name)
+			{
+				created_capacities.push_back(capacity);
+				return GraphicsBuffer(nullptr, nullptr, capacity, block_alignment, std::move(name));
+			});
+	}
+
+	const uint32_t alignment = 4;
+	std::vector<size_t> created_capacities;
+};
+
+TEST_F(GraphicsBufferPoolFixture, creates_blocks_only_when_needed)
+{
+	auto pool = make_pool(100);
+	EXPECT_EQ(pool.get_stats().block_count, 0);
+
+	EXPECT_EQ(pool.reserve_slot(0, 40).block, 0);
+	EXPECT_EQ(pool.reserve_slot(1, 40).slot.offset, 40);
+	const auto third = pool.reserve_slot(2, 40);
+	EXPECT_EQ(third.block, 1);
+	EXPECT_EQ(third.slot.offset, 0);
+	EXPECT_EQ(created_capacities, (std::vector<size_t>{ 100, 100 }));
+
+	// earlier blocks are filled first
+	EXPECT_EQ(pool.reserve_slot(3, 20).block, 0);
+	pool.destroy(nullptr);
+}
+
+TEST_F(GraphicsBufferPoolFixture, gives_large_slots_a_block_of_their_own)
+{
+	auto pool = make_pool(100);
+	pool.reserve_slot(0, 10);
+
+	const auto large = pool.reserve_slot(1, 250);
+	EXPECT_EQ(large.block, 1);
+	EXPECT_EQ(large.slot.size, 250);
+	EXPECT_EQ(created_capacities.back(), 252);
+	pool.destroy(nullptr);
+}
+
+TEST_F(GraphicsBufferPoolFixture, releases_idle_blocks_and_reuses_their_index)
+{
+	auto pool = make_pool(100);
+	pool.reserve_slot(0, 100);
+	pool.reserve_slot(1, 100);
+	pool.reserve_slot(2, 100);
+	pool.free_slot(1);
+	pool.free_slot(0);
+
+	// the first block is kept for the next slots
+	EXPECT_EQ(pool.release_idle_blocks(nullptr), 1);
+	EXPECT_EQ(pool.get_stats().block_count, 2);
+	EXPECT_EQ(pool.get_location(2).block, 2);
+
+	EXPECT_EQ(pool.reserve_slot(3, 100).block, 0);
+	EXPECT_EQ(pool.reserve_slot(4, 100).block, 1);
+	EXPECT_EQ(pool.get_stats().block_count, 3);
+	pool.destroy(nullptr);
+}
+
+TEST_F(GraphicsBufferPoolFixture, creates_the_first_block_on_request)
+{
+	auto pool = make_pool(100);
+	pool.get_first_buffer();
+	EXPECT_EQ(pool.get_stats().block_count, 1);
+
+	pool.get_first_buffer();
+	EXPECT_EQ(pool.reserve_slot(0, 100).block, 0);
+	EXPECT_EQ(created_capacities.size(), 1);
+	pool.destroy(nullptr);
+}
+
+TEST_F(GraphicsBufferPoolFixture, reports_occupancy_over_all_blocks)
+{
+	auto pool = make_pool(100);
+	pool.reserve_slot(0, 60);
+	pool.reserve_slot(1, 20);
+	pool.reserve_slot(2, 60);
+	pool.free_slot(0);
+
+	const auto stats = pool.get_stats();
+	EXPECT_EQ(stats.block_count, 2);
+	EXPECT_EQ(stats.capacity, 200);
+	EXPECT_EQ(stats.used, 80);
+	EXPECT_EQ(stats.largest_free_block, 60);
+	EXPECT_FLOAT_EQ(stats.get_fragmentation(), 0.5f);
+	pool.destroy(nullptr);
+}
+
+TEST_F(GraphicsBufferPoolFixture, throws_when_out_of_blocks)
+{
+	auto pool = make_pool(100, 2);
+	pool.reserve_slot(0, 100);
+	pool.reserve_slot(1, 100);
+
+	EXPECT_THROW(pool.reserve_slot(2, 4), std::runtime_error);
+	EXPECT_FALSE(pool.has_slot(2));
+	EXPECT_THROW(pool.reserve_slot(1, 4), std::runtime_error);
+	EXPECT_THROW(pool.free_slot(5), std::runtime_error);
+	pool.destroy(nullptr);
+}
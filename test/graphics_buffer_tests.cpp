@@ -108,3 +108,41 @@ TEST_F(GraphicsBufferFixture, alignment)
 
 	ASSERT_EQ(buffer2.reserve_slot(id++, 24), 76);
 }
+
+TEST_F(GraphicsBufferFixture, reports_fragmentation)
+{
+	uint32_t id = 0;
+	ASSERT_EQ(buffer2.reserve_slot(id++, 20), 0);
+	ASSERT_EQ(buffer2.reserve_slot(id++, 30), 20);
+	ASSERT_EQ(buffer2.reserve_slot(id++, 10), 52);
+	buffer2.free_slot(0);
+
+	const auto stats = buffer2.get_stats();
+	EXPECT_EQ(stats.used, 44);
+	EXPECT_EQ(stats.free, 56);
+	EXPECT_EQ(stats.largest_free_block, 36);
+	EXPECT_EQ(stats.free_block_count, 2);
+	EXPECT_GT(stats.get_fragmentation(), 0.0f);
+	EXPECT_EQ(buffer2.get_filled_capacity(), stats.used);
+}
+
+TEST_F(GraphicsBufferFixture, plans_defragmentation_by_slot)
+{
+	uint32_t id = 0;
+	ASSERT_EQ(buffer2.reserve_slot(id++, 20), 0);
+	ASSERT_EQ(buffer2.reserve_slot(id++, 30), 20);
+	ASSERT_EQ(buffer2.reserve_slot(id++, 10), 52);
+	buffer2.free_slot(0);
+
+	const auto moves = buffer2.plan_defragmentation();
+	ASSERT_EQ(moves.size(), 2);
+	EXPECT_EQ(moves[0].id, 1);
+	EXPECT_EQ(moves[0].from, 20);
+	EXPECT_EQ(moves[0].to, 0);
+	EXPECT_EQ(moves[0].size, 32);
+	EXPECT_EQ(moves[1].id, 2);
+	EXPECT_EQ(moves[1].to, 32);
+
+	// only a plan, nothing moved
+	EXPECT_EQ(buffer2.get_offset(1), 20);
+}
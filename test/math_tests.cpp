@@ -87,3 +87,54 @@ TEST(math_tests, updating_component_of_matrix_transform_preserves_other_componen
     EXPECT_TRUE(Maths::is_vec3_equal(transform.get_scale(), original_scale));
     EXPECT_NEAR(glm::abs(glm::dot(transform.get_orient(), original_orientation)), 1.0f, 0.0001f);
 }
+
+TEST(math_tests, setters_on_matrix_transform_match_the_composed_matrix)
+{
+    const glm::quat orientation =
+        glm::angleAxis(glm::radians(40.0f), glm::normalize(glm::vec3(-1.0f, 2.0f, 0.5f)));
+    const glm::quat new_orientation =
+        glm::angleAxis(glm::radians(-75.0f), glm::normalize(glm::vec3(0.0f, 1.0f, 1.0f)));
+    const glm::vec3 new_position(-3.0f, 0.5f, 8.0f);
+    const glm::vec3 new_scale(0.5f, 6.0f, 1.5f);
+    const auto compose = [](const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+    {
+        return glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) *
+            glm::scale(glm::mat4(1.0f), scale);
+    };
+    const glm::mat4 original = compose(glm::vec3(1.0f, 2.0f, 3.0f), orientation, glm::vec3(2.0f, 3.0f, 4.0f));
+
+    // each setter runs straight after set_mat4, before anything was decomposed
+    Maths::Transform transform(original);
+    transform.set_orient(new_orientation);
+    transform.set_scale(new_scale);
+    transform.set_pos(new_position);
+    const glm::mat4 expected = compose(new_position, new_orientation, new_scale);
+    for (int column = 0; column < 4; ++column)
+        EXPECT_TRUE(Maths::is_vec3_equal(glm::vec3(transform.get_mat4()[column]), glm::vec3(expected[column])));
+    EXPECT_TRUE(Maths::is_vec3_equal(transform.get_scale(), new_scale));
+    EXPECT_NEAR(glm::abs(glm::dot(transform.get_orient(), new_orientation)), 1.0f, 0.0001f);
+
+    // collapsing an axis must not lose the orientation of the others
+    transform.set_mat4(original);
+    transform.set_scale(glm::vec3(2.0f, 0.0f, 4.0f));
+    transform.set_scale(glm::vec3(2.0f, 3.0f, 4.0f));
+    for (int column = 0; column < 4; ++column)
+        EXPECT_TRUE(Maths::is_vec3_equal(glm::vec3(transform.get_mat4()[column]), glm::vec3(original[column])));
+}
+
+TEST(math_tests, counter_random_streams_repeat_per_seed)
+{
+    Maths::CounterRandom first(7);
+    Maths::CounterRandom second(7);
+    Maths::CounterRandom other(8);
+    int differences = 0;
+    for (int draw = 0; draw < 1000; ++draw)
+    {
+        const float value = first.uniform(-2.0f, 3.0f);
+        EXPECT_EQ(value, second.uniform(-2.0f, 3.0f));
+        EXPECT_GE(value, -2.0f);
+        EXPECT_LT(value, 3.0f);
+        differences += value != other.uniform(-2.0f, 3.0f);
+    }
+    EXPECT_GT(differences, 990);
+}
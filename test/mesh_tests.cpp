@@ -7,9 +7,12 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <limits>
 #include <ranges>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 
 static_assert(std::is_same_v<
@@ -79,6 +82,49 @@ TEST(MeshFactory, capsule_is_y_aligned_and_rests_at_zero)
 	EXPECT_TRUE(glm_equal(bounds.max_bound, { 0.5f, 2.0f, 0.5f }));
 }
 
+TEST(MeshFactory, pick_data_is_built_lazily_or_prefetched_consistently)
+{
+	auto lazy = MeshFactory::sphere(MeshFactory::EVertexType::COLOR, MeshFactory::GenerationMethod::UV_SPHERE, 4096);
+	auto prefetched = MeshFactory::sphere(MeshFactory::EVertexType::COLOR, MeshFactory::GenerationMethod::UV_SPHERE, 4096);
+	EXPECT_FALSE(lazy->is_pick_data_ready());
+
+	prefetched->prefetch_pick_data();
+	const MeshPickData& prefetched_data = prefetched->get_pick_data();
+	EXPECT_TRUE(prefetched->is_pick_data_ready());
+	const MeshPickData& lazy_data = lazy->get_pick_data();
+	EXPECT_TRUE(lazy->is_pick_data_ready());
+	ASSERT_EQ(lazy_data.get_nodes().size(), prefetched_data.get_nodes().size());
+	ASSERT_EQ(lazy_data.get_triangles().size(), prefetched_data.get_triangles().size());
+
+	float lazy_t = std::numeric_limits<float>::infinity();
+	float prefetched_t = std::numeric_limits<float>::infinity();
+	const Maths::Ray ray(glm::vec3(0.0f, 0.0f, -5.0f), Maths::forward_vec);
+	ASSERT_TRUE(lazy_data.raycast(ray, lazy_t));
+	ASSERT_TRUE(prefetched_data.raycast(ray, prefetched_t));
+	EXPECT_FLOAT_EQ(lazy_t, prefetched_t);
+
+	// replacing the indices discards the stale pick data
+	// one triangle between the first two rings below the pole
+	prefetched->set_indices({ 64, 65, 128 });
+	EXPECT_FALSE(prefetched->is_pick_data_ready());
+	EXPECT_EQ(prefetched->get_pick_data().get_triangles().size(), 1u);
+}
+
+TEST(MeshFactory, concurrent_pick_data_callers_share_one_build)
+{
+	auto mesh = MeshFactory::sphere(MeshFactory::EVertexType::COLOR, MeshFactory::GenerationMethod::UV_SPHERE, 4096);
+	std::array<const MeshPickData*, 4> results{};
+	{
+		std::vector<std::jthread> callers;
+		for (auto& result : results)
+			callers.emplace_back([&mesh, &result]() { result = &mesh->get_pick_data(); });
+	}
+
+	for (const MeshPickData* result : results)
+		EXPECT_EQ(result, results.front());
+	EXPECT_TRUE(mesh->is_pick_data_ready());
+}
+
 TEST(MeshFactory, generated_meshes_have_independent_lifetimes)
 {
 	MeshSystem meshes;
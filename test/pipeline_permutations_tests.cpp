@@ -0,0 +1,69 @@
+#include <graphics_engine/pipeline/pipeline_permutations.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+
+TEST(PipelinePermutations, combines_every_field)
+{
+	const PipelinePermutations permutations{
+		.render_types = { ERenderType::COLOR, ERenderType::STANDARD },
+		.alpha_modes = { EAlphaMode::OPAQUE, EAlphaMode::BLEND },
+		.double_sided = { false, true },
+	};
+
+	const auto ids = permutations.enumerate();
+	EXPECT_EQ(ids.size(), 8);
+	EXPECT_EQ(std::unordered_set<PipelineID>(ids.begin(), ids.end()).size(), ids.size());
+}
+
+TEST(PipelinePermutations, skips_pipelines_that_cannot_be_created)
+{
+	EXPECT_FALSE(PipelinePermutations::is_valid({ .primary_pipeline_type = ERenderType::RAYTRACING }));
+	EXPECT_FALSE(PipelinePermutations::is_valid({ .primary_pipeline_type = ERenderType::UNASSIGNED }));
+	EXPECT_FALSE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::QUAD, .pipeline_modifier = EPipelineModifier::STENCIL }));
+	EXPECT_FALSE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::SKINNED, .instanced = true }));
+	EXPECT_FALSE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::COLOR,
+		.pipeline_modifier = EPipelineModifier::SHADOW_MAP,
+		.instanced = true }));
+
+	EXPECT_TRUE(PipelinePermutations::is_valid({ .primary_pipeline_type = ERenderType::PARTICLE }));
+	EXPECT_TRUE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::SKINNED_COLOR, .pipeline_modifier = EPipelineModifier::WIREFRAME }));
+}
+
+TEST(PipelinePermutations, only_varies_shading_where_renderers_do)
+{
+	EXPECT_TRUE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::STANDARD,
+		.pipeline_modifier = EPipelineModifier::POST_STENCIL,
+		.shading_mode = EShadingMode::UNLIT }));
+	EXPECT_FALSE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::STANDARD,
+		.pipeline_modifier = EPipelineModifier::SHADOW_MAP,
+		.shading_mode = EShadingMode::UNLIT }));
+	EXPECT_FALSE(PipelinePermutations::is_valid({
+		.primary_pipeline_type = ERenderType::QUAD, .shading_mode = EShadingMode::UNLIT }));
+}
+
+TEST(PipelinePermutations, covers_material_pipelines)
+{
+	const auto ids = PipelinePermutations::for_materials().enumerate();
+	// 48 colour/texture, 24 skinned, 24 shadow map
+	EXPECT_EQ(ids.size(), 96);
+
+	const PipelineID instanced_unlit{
+		.primary_pipeline_type = ERenderType::STANDARD,
+		.alpha_mode = EAlphaMode::MASK,
+		.shading_mode = EShadingMode::UNLIT,
+		.double_sided = true,
+		.instanced = true,
+	};
+	EXPECT_NE(std::find(ids.begin(), ids.end(), instanced_unlit), ids.end());
+	EXPECT_TRUE(std::all_of(ids.begin(), ids.end(), PipelinePermutations::is_valid));
+}
@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <memory>
+#include <random>
+#include <stdexcept>
 #include <vector>
 
 
@@ -51,9 +53,9 @@ TEST(RenderDrawList, derives_alpha_and_culling_from_pbr_material)
 	EXPECT_EQ(renderable_alpha_mode(renderable), EAlphaMode::MASK);
 	EXPECT_FLOAT_EQ(renderable_alpha_cutoff(renderable), 0.5f);
 	EXPECT_TRUE(renderable_double_sided(renderable));
-	const auto key = make_render_sort_key(RenderableID(7), renderable);
-	EXPECT_EQ(key.alpha_mode, EAlphaMode::MASK);
-	EXPECT_TRUE(key.double_sided);
+	const auto key = make_render_sort_key(renderable, 0, 0);
+	EXPECT_EQ(key.alpha_mode(), EAlphaMode::MASK);
+	EXPECT_TRUE(key.double_sided());
 }
 
 }
@@ -98,16 +100,85 @@ TEST(RenderDrawList, state_sort_key_is_deterministic)
 	const auto second = make_renderable(
 		ERenderType::STANDARD, EAlphaMode::MASK, true, false);
 
-	std::vector keys{
-		make_render_sort_key(RenderableID(9), second),
-		make_render_sort_key(RenderableID(4), first),
-		make_render_sort_key(RenderableID(3), first),
+	// entries start in renderable ID order, as rebuild sorts them
+	std::vector<DrawSortEntry> entries{
+		{ .key = make_render_sort_key(first, 0, 0).value, .index = 3 },
+		{ .key = make_render_sort_key(first, 0, 0).value, .index = 4 },
+		{ .key = make_render_sort_key(second, 1, 1).value, .index = 9 },
 	};
-	std::sort(keys.begin(), keys.end());
+	std::vector<DrawSortEntry> scratch;
+	radix_sort(entries, scratch);
 
-	EXPECT_EQ(keys[0].render_type, ERenderType::STANDARD);
-	EXPECT_EQ(keys[1].renderable_id, RenderableID(3));
-	EXPECT_EQ(keys[2].renderable_id, RenderableID(4));
+	EXPECT_EQ(RenderSortKey{ entries[0].key }.render_type(), ERenderType::STANDARD);
+	EXPECT_EQ(entries[1].index, 3u);
+	EXPECT_EQ(entries[2].index, 4u);
+}
+
+TEST(RenderDrawList, packed_sort_key_orders_pipeline_state_before_resources)
+{
+	const auto color = make_renderable(
+		ERenderType::COLOR, EAlphaMode::OPAQUE, true, false);
+	const auto unlit = make_renderable(
+		ERenderType::COLOR, EAlphaMode::OPAQUE, true, false, EShadingMode::UNLIT);
+	const auto masked = make_renderable(
+		ERenderType::COLOR, EAlphaMode::MASK, true, false);
+
+	const RenderSortKey key = make_render_sort_key(color, 12, RenderSortKey::MAX_RANK);
+	EXPECT_EQ(key.render_type(), ERenderType::COLOR);
+	EXPECT_EQ(key.shading_mode(), EShadingMode::LIT);
+	EXPECT_EQ(key.alpha_mode(), EAlphaMode::OPAQUE);
+	EXPECT_FALSE(key.double_sided());
+	EXPECT_EQ(key.mesh_rank(), 12u);
+	EXPECT_EQ(key.material_set_rank(), RenderSortKey::MAX_RANK);
+
+	EXPECT_LT(key, make_render_sort_key(unlit, 0, 0));
+	EXPECT_LT(key, make_render_sort_key(masked, 0, 0));
+	EXPECT_LT(key, make_render_sort_key(color, 13, 0));
+	EXPECT_THROW(
+		make_render_sort_key(color, RenderSortKey::MAX_RANK + 1, 0),
+		std::out_of_range);
+}
+
+TEST(RenderDrawList, radix_sort_matches_a_stable_comparison_sort)
+{
+	std::mt19937_64 generator(11);
+	std::vector<DrawSortEntry> entries;
+	for (uint32_t index = 0; index < 5000; ++index)
+	{
+		// few distinct keys, so stability is exercised, with the middle bytes
+		// shared so that passes are skipped
+		const uint64_t key = generator() % 64;
+		entries.push_back({ .key = (key << 56) | 0x00aabbccddeeff00 | (key & 0xf), .index = index });
+	}
+	std::vector<DrawSortEntry> expected = entries;
+	std::ranges::stable_sort(expected, {}, &DrawSortEntry::key);
+
+	std::vector<DrawSortEntry> scratch;
+	radix_sort(entries, scratch);
+	ASSERT_EQ(entries.size(), expected.size());
+	for (size_t position = 0; position < entries.size(); ++position)
+	{
+		EXPECT_EQ(entries[position].key, expected[position].key);
+		EXPECT_EQ(entries[position].index, expected[position].index);
+	}
+}
+
+TEST(RenderDrawList, blended_sort_key_orders_far_to_near_then_by_state)
+{
+	std::vector<DrawSortEntry> entries{
+		{ .key = make_blended_sort_key(1.0f, 0), .index = 0 },
+		{ .key = make_blended_sort_key(400.0f, 2), .index = 1 },
+		{ .key = make_blended_sort_key(0.0f, 1), .index = 2 },
+		{ .key = make_blended_sort_key(400.0f, 1), .index = 3 },
+		{ .key = make_blended_sort_key(2.5f, 7), .index = 4 },
+	};
+	std::vector<DrawSortEntry> scratch;
+	radix_sort(entries, scratch);
+
+	std::vector<uint32_t> order;
+	for (const DrawSortEntry& entry : entries)
+		order.push_back(entry.index);
+	EXPECT_EQ(order, (std::vector<uint32_t>{ 3, 1, 4, 0, 2 }));
 }
 
 TEST(RenderDrawList, shading_is_an_independent_pipeline_and_sort_dimension)
@@ -129,8 +200,8 @@ TEST(RenderDrawList, shading_is_an_independent_pipeline_and_sort_dimension)
 		ERenderType::COLOR, EAlphaMode::OPAQUE, true, false);
 	const auto unlit = make_renderable(
 		ERenderType::COLOR, EAlphaMode::OPAQUE, true, false, EShadingMode::UNLIT);
-	EXPECT_EQ(make_render_sort_key(RenderableID(1), lit).shading_mode, EShadingMode::LIT);
-	EXPECT_EQ(make_render_sort_key(RenderableID(2), unlit).shading_mode, EShadingMode::UNLIT);
+	EXPECT_EQ(make_render_sort_key(lit, 0, 0).shading_mode(), EShadingMode::LIT);
+	EXPECT_EQ(make_render_sort_key(unlit, 0, 0).shading_mode(), EShadingMode::UNLIT);
 }
 
 TEST(RenderDrawList, double_sided_is_an_independent_pipeline_dimension)
@@ -162,3 +233,140 @@ TEST(RenderDrawList, blended_distance_uses_composed_model_transform)
 		renderable_distance_squared({}, model_transform),
 		4.0f);
 }
+
+namespace
+{
+// Draw items over states translated along x by their index, all sharing one
+// sort key unless the definitions differ
+struct BatchingScene
+{
+	void add(const RenderableDefinitionPtr& definition, const bool visible = true)
+	{
+		states.push_back({
+			.definition = definition,
+			.model_transform = glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(states.size()), 0.0f, 0.0f)),
+			.visible = visible,
+		});
+		items.push_back({
+			.graphics_renderable = nullptr,
+			.renderable = definition.get(),
+			.sort_key = make_render_sort_key(*definition, 0, 0),
+			.state_index = static_cast<uint32_t>(states.size() - 1),
+		});
+	}
+
+	std::vector<const GraphicsDrawItem*> list() const
+	{
+		std::vector<const GraphicsDrawItem*> pointers;
+		for (const auto& item : items)
+			pointers.push_back(&item);
+		return pointers;
+	}
+
+	RenderableStateList states;
+	std::vector<GraphicsDrawItem> items;
+};
+
+const auto instance_all = [](const GraphicsDrawItem&) { return true; };
+}
+
+TEST(DrawBatcher, coalesces_runs_of_identical_renderables)
+{
+	const auto tile = std::make_shared<const RenderableDefinition>(
+		make_renderable(ERenderType::STANDARD, EAlphaMode::OPAQUE, true, false));
+	BatchingScene scene;
+	for (int index = 0; index < 3; ++index)
+		scene.add(tile);
+
+	const glm::mat4 view_projection = glm::perspectiveLH(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+	DrawBatcher batcher(16);
+	std::vector<DrawBatch> batches;
+	batcher.batch(scene.list(), scene.states, view_projection, instance_all, batches);
+
+	ASSERT_EQ(batches.size(), 1u);
+	EXPECT_TRUE(batches[0].instanced);
+	EXPECT_EQ(batches[0].item, &scene.items[0]);
+	EXPECT_EQ(batches[0].first_instance, 0u);
+	EXPECT_EQ(batches[0].instance_count, 3u);
+	ASSERT_EQ(batcher.get_instances().size(), 3u);
+	for (uint32_t index = 0; index < 3; ++index)
+	{
+		EXPECT_EQ(batcher.get_instances()[index].model, scene.states[index].model_transform);
+		EXPECT_EQ(batcher.get_instances()[index].mvp, view_projection * scene.states[index].model_transform);
+	}
+}
+
+TEST(DrawBatcher, draws_singletons_and_rejected_items_alone)
+{
+	const auto tile = std::make_shared<const RenderableDefinition>(
+		make_renderable(ERenderType::STANDARD, EAlphaMode::OPAQUE, true, false));
+	const auto other = std::make_shared<const RenderableDefinition>(
+		make_renderable(ERenderType::COLOR, EAlphaMode::OPAQUE, true, false));
+	auto faded_definition = make_renderable(ERenderType::STANDARD, EAlphaMode::OPAQUE, true, false);
+	faded_definition.opacity = 0.5f;
+	const auto faded = std::make_shared<const RenderableDefinition>(std::move(faded_definition));
+	const auto cubemap = std::make_shared<const RenderableDefinition>(RenderableDefinition{
+		.pipeline_render_type = ERenderType::CUBEMAP,
+	});
+
+	BatchingScene scene;
+	scene.add(tile);
+	scene.add(tile, false);		// invisible, so neither drawn nor breaking the run
+	scene.add(tile);
+	scene.add(faded);			// same key, but a different opacity
+	scene.add(other);			// alone between two different renderables
+	scene.add(cubemap);
+	scene.add(cubemap);			// no instanced pipeline
+	scene.add(tile);
+	scene.add(tile);			// rejected by the predicate below
+
+	DrawBatcher batcher(16);
+	std::vector<DrawBatch> batches;
+	const auto not_last = [&](const GraphicsDrawItem& item) { return &item != &scene.items.back(); };
+	batcher.batch(scene.list(), scene.states, glm::mat4(1.0f), not_last, batches);
+
+	ASSERT_EQ(batches.size(), 7u);
+	EXPECT_TRUE(batches[0].instanced);
+	EXPECT_EQ(batches[0].instance_count, 2u);
+	for (size_t index = 1; index < batches.size(); ++index)
+	{
+		EXPECT_FALSE(batches[index].instanced) << "batch " << index;
+		EXPECT_EQ(batches[index].instance_count, 1u) << "batch " << index;
+	}
+	EXPECT_EQ(batches[1].item, &scene.items[3]);
+	EXPECT_EQ(batches[6].item, &scene.items[8]);
+	// only the instanced draw keeps its instances
+	ASSERT_EQ(batcher.get_instances().size(), 2u);
+	EXPECT_EQ(batcher.get_instances()[1].model, scene.states[2].model_transform);
+}
+
+TEST(DrawBatcher, stops_instancing_at_capacity_and_packs_lists_contiguously)
+{
+	const auto tile = std::make_shared<const RenderableDefinition>(
+		make_renderable(ERenderType::COLOR, EAlphaMode::OPAQUE, true, false));
+	BatchingScene scene;
+	for (int index = 0; index < 6; ++index)
+		scene.add(tile);
+	const auto list = scene.list();
+	const std::vector<const GraphicsDrawItem*> first(list.begin(), list.begin() + 2);
+	const std::vector<const GraphicsDrawItem*> second(list.begin() + 2, list.end());
+
+	DrawBatcher batcher(4);
+	std::vector<DrawBatch> first_batches;
+	std::vector<DrawBatch> second_batches;
+	batcher.batch(first, scene.states, glm::mat4(1.0f), instance_all, first_batches);
+	batcher.batch(second, scene.states, glm::mat4(1.0f), instance_all, second_batches);
+
+	ASSERT_EQ(first_batches.size(), 1u);
+	EXPECT_EQ(first_batches[0].instance_count, 2u);
+	ASSERT_EQ(second_batches.size(), 3u);
+	EXPECT_TRUE(second_batches[0].instanced);
+	EXPECT_EQ(second_batches[0].first_instance, 2u);
+	EXPECT_EQ(second_batches[0].instance_count, 2u);
+	EXPECT_FALSE(second_batches[1].instanced);
+	EXPECT_FALSE(second_batches[2].instanced);
+	EXPECT_EQ(batcher.get_instances().size(), 4u);
+
+	batcher.clear();
+	EXPECT_TRUE(batcher.get_instances().empty());
+}
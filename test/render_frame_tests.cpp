@@ -1,14 +1,65 @@
 #include "render_frame.hpp"
+#include "render_frame_builder.hpp"
 
+#include "game_engine.hpp"
+#include "iapplication.hpp"
+#include "mock_graphics_engine.hpp"
+#include "mock_window.hpp"
+#include "entity_component_system/ecs.hpp"
 #include "renderable/material.hpp"
 #include "renderable/mesh_factory.hpp"
+#include "task_pool.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
 #include <memory>
+#include <new>
+#include <string>
 #include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+
+namespace
+{
+// Global allocations made by any thread are counted while enabled, so that
+// those of task pool workers running a tick's ranges are counted too
+std::atomic<bool> counting_allocations = false;
+std::atomic<size_t> counted_allocations = 0;
+
+void* counted_allocate(const size_t size, const size_t alignment)
+{
+	if (counting_allocations.load(std::memory_order_relaxed))
+		counted_allocations.fetch_add(1, std::memory_order_relaxed);
+	const size_t padded_size = (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment;
+	void* memory = alignment <= alignof(std::max_align_t)
+		? std::malloc(padded_size)
+		: std::aligned_alloc(alignment, padded_size);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+}
+
+// The array and nothrow forms forward to these
+void* operator new(const size_t size)
+{
+	return counted_allocate(size, alignof(std::max_align_t));
+}
+void* operator new(const size_t size, const std::align_val_t alignment)
+{
+	return counted_allocate(size, static_cast<size_t>(alignment));
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
 
 
 namespace
@@ -27,6 +78,20 @@ glm::mat4 translation(const glm::vec3& offset)
 {
 	return glm::translate(glm::mat4(1.0f), offset);
 }
+
+// Publishes frames the way main_loop does, without its window and UI work
+class FrameTickGameEngine : public GameEngine
+{
+public:
+	FrameTickGameEngine() :
+		GameEngine(std::make_unique<MockWindow>(),
+				   std::make_unique<DummyApplication>(),
+				   std::make_unique<MockGraphicsEngine>())
+	{
+	}
+
+	using GameEngine::publish_completed_render_frame;
+};
 }
 
 
@@ -87,6 +152,61 @@ TEST(RenderFrame, composes_bone_hierarchy_and_inverse_bind_poses)
 	EXPECT_TRUE(matrices_are_equal(bones[1].final_transform, translation({ 2.0f, 3.0f, 4.0f })));
 }
 
+TEST(RenderFrame, orders_hierarchies_parents_first)
+{
+	const std::vector<uint32_t> parents{ 2, RENDER_FRAME_NO_PARENT, 1, RENDER_FRAME_NO_PARENT, 0 };
+
+	const auto order = make_parent_first_order(parents);
+
+	ASSERT_EQ(order.size(), parents.size());
+	std::vector<size_t> positions(parents.size(), parents.size());
+	for (size_t position = 0; position < order.size(); ++position)
+		positions[order[position]] = position;
+	for (size_t index = 0; index < parents.size(); ++index)
+	{
+		ASSERT_LT(positions[index], parents.size());
+		if (parents[index] != RENDER_FRAME_NO_PARENT)
+			EXPECT_LT(positions[parents[index]], positions[index]);
+	}
+	EXPECT_THROW(make_parent_first_order(std::vector<uint32_t>{ 2, 0, 1 }), std::invalid_argument);
+	EXPECT_THROW(make_parent_first_order(std::vector<uint32_t>{ RENDER_FRAME_NO_PARENT, 5 }), std::invalid_argument);
+}
+
+TEST(RenderFrame, composes_bones_in_place_in_the_definition_order)
+{
+	const RenderSkeletonDefinition definition{
+		.id = SkeletonID(9),
+		.bones = {
+			{ .parent_index = 2, .inverse_bind_pose = translation({ 0.0f, -1.0f, 0.0f }) },
+			{ .parent_index = RENDER_FRAME_NO_PARENT, .inverse_bind_pose = glm::mat4(1.0f) },
+			{ .parent_index = 1, .inverse_bind_pose = translation({ 0.0f, 0.0f, 2.0f }) },
+		},
+		.parent_first_order = { 1, 2, 0 },
+	};
+	const std::vector<glm::mat4> local_pose{
+		translation({ 3.0f, 0.0f, 0.0f }),
+		translation({ 1.0f, 0.0f, 0.0f }),
+		translation({ 2.0f, 0.0f, 0.0f }),
+	};
+
+	std::vector<SDS::Bone> bones(3);
+	compose_bone_transforms(local_pose, definition, bones);
+
+	const auto expected = compose_bone_transforms(local_pose, RenderSkeletonDefinition{
+		.id = definition.id,
+		.bones = definition.bones,
+	});
+	for (size_t index = 0; index < bones.size(); ++index)
+	{
+		EXPECT_TRUE(matrices_are_equal(bones[index].final_transform, expected[index].final_transform));
+		EXPECT_TRUE(matrices_are_equal(bones[index].inverse_transform, expected[index].inverse_transform));
+	}
+	EXPECT_TRUE(matrices_are_equal(bones[0].final_transform, translation({ 6.0f, -1.0f, 0.0f })));
+
+	std::vector<SDS::Bone> too_few(2);
+	EXPECT_THROW(compose_bone_transforms(local_pose, definition, too_few), std::invalid_argument);
+}
+
 TEST(RenderFrame, immutable_definitions_retain_mesh_and_material_assets)
 {
 	MeshSystem meshes;
@@ -151,6 +271,251 @@ TEST(RenderFrame, renderable_state_is_already_composed)
 	EXPECT_EQ(frame.active_light->position, glm::vec3(4.0f, 5.0f, 6.0f));
 }
 
+TEST(RenderFrame, renderable_state_lists_copy_only_the_chunks_they_write)
+{
+	constexpr size_t chunk_size = RenderableStateList::CHUNK_SIZE;
+	const auto definition = std::make_shared<const RenderableDefinition>(
+		RenderableDefinition{ .id = RenderableID(8) });
+	RenderableStateList original;
+	for (size_t index = 0; index < 2 * chunk_size + 1; ++index)
+		original.push_back({ .definition = definition });
+
+	RenderableStateList copy = original;
+	copy.edit(chunk_size).visible = false;
+	EXPECT_TRUE(original[chunk_size].visible);
+	EXPECT_FALSE(copy[chunk_size].visible);
+	EXPECT_EQ(&original[0], &copy[0]);
+	EXPECT_NE(&original[chunk_size], &copy[chunk_size]);
+	EXPECT_EQ(&original[2 * chunk_size], &copy[2 * chunk_size]);
+	EXPECT_TRUE(copy.has_same_definitions(original));
+
+	// appending to a shared partial chunk must not show up in the original
+	copy.push_back({ .definition = definition });
+	EXPECT_EQ(original.size(), 2 * chunk_size + 1);
+	EXPECT_FALSE(copy.has_same_definitions(original));
+	EXPECT_EQ(std::ranges::count_if(copy, [](const RenderableState& state) { return !state.visible; }), 1);
+	EXPECT_THROW((void)copy.at(copy.size()), std::out_of_range);
+}
+
+TEST(RenderFrameBuilder, republishes_only_changed_renderables)
+{
+	ECS ecs;
+	std::vector<std::unique_ptr<Object>> objects;
+	const auto template_renderable = Renderable::make_default(
+		ecs, ecs.get_mesh_system().add(MeshFactory::cube()));
+	for (size_t index = 0; index < 2 * RenderableStateList::CHUNK_SIZE; ++index)
+	{
+		objects.push_back(std::make_unique<Object>());
+		ecs.add_object(*objects.back());
+		ecs.add_renderable(template_renderable, objects.back()->get_id());
+	}
+	RenderFrameBuilder builder;
+	RenderFrame first;
+	builder.build(ecs, first);
+	ASSERT_EQ(first.renderables.size(), objects.size());
+
+	// renderables are ordered by ID, matching the order they were added in
+	const size_t last = objects.size() - 1;
+	ecs.set_position(objects.back()->get_id(), { 1.0f, 2.0f, 3.0f });
+	ecs.update_world_transforms();
+	RenderFrame second;
+	builder.build(ecs, second);
+	EXPECT_EQ(&first.renderables[0], &second.renderables[0]);
+	EXPECT_NE(&first.renderables[last], &second.renderables[last]);
+	EXPECT_TRUE(matrices_are_equal(second.renderables[last].model_transform, translation({ 1.0f, 2.0f, 3.0f })));
+	EXPECT_TRUE(matrices_are_equal(first.renderables[last].model_transform, glm::mat4(1.0f)));
+
+	objects.front()->set_visibility(false);
+	RenderFrame third;
+	builder.build(ecs, third);
+	EXPECT_FALSE(third.renderables[0].visible);
+	EXPECT_TRUE(second.renderables[0].visible);
+
+	const auto added = ecs.add_renderable(template_renderable);
+	RenderFrame fourth;
+	builder.build(ecs, fourth);
+	ASSERT_EQ(fourth.renderables.size(), objects.size() + 1);
+	EXPECT_EQ(fourth.renderables[objects.size()].definition->id, added);
+	EXPECT_EQ(fourth.renderables[0].definition, first.renderables[0].definition);
+	EXPECT_FALSE(fourth.renderables[0].visible);
+	EXPECT_TRUE(matrices_are_equal(fourth.renderables[last].model_transform, translation({ 1.0f, 2.0f, 3.0f })));
+}
+
+TEST(RenderFrameBuilder, derives_world_bounds_from_mesh_bounds)
+{
+	ECS ecs;
+	std::vector<std::unique_ptr<Object>> objects;
+	for (int index = 0; index < 2; ++index)
+	{
+		objects.push_back(std::make_unique<Object>());
+		ecs.add_object(*objects.back());
+	}
+	const auto mesh = ecs.get_mesh_system().add(MeshFactory::cube());
+	ASSERT_TRUE(mesh->get().get_local_bounds());
+	const AABB local_bounds = *mesh->get().get_local_bounds();
+	const auto renderable = Renderable::make_default(ecs, mesh);
+	ecs.add_renderable(renderable, objects[0]->get_id());
+	Bone bone;
+	bone.name = "root";
+	auto skinned_renderable = renderable;
+	skinned_renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+	ecs.add_renderable(skinned_renderable, objects[1]->get_id(), ecs.add_skeleton({ bone }));
+
+	ecs.set_position(objects[0]->get_id(), { 10.0f, 0.0f, 0.0f });
+	ecs.update_world_transforms();
+	RenderFrameBuilder builder;
+	RenderFrame first;
+	builder.build(ecs, first);
+	ASSERT_EQ(first.renderables.size(), 2u);
+	ASSERT_TRUE(first.renderables[0].definition->local_bounds);
+	ASSERT_TRUE(first.renderables[0].world_bounds);
+	EXPECT_EQ(first.renderables[0].world_bounds->min_bound, local_bounds.min_bound + glm::vec3(10.0f, 0.0f, 0.0f));
+	EXPECT_EQ(first.renderables[0].world_bounds->max_bound, local_bounds.max_bound + glm::vec3(10.0f, 0.0f, 0.0f));
+	// skinned poses can leave the bind-pose bounds, so they are never culled
+	EXPECT_FALSE(first.renderables[1].definition->local_bounds);
+	EXPECT_FALSE(first.renderables[1].world_bounds);
+	// bounds come from the vertices, not from a BVH built for them
+	EXPECT_FALSE(mesh->get().is_pick_data_ready());
+
+	ecs.set_position(objects[0]->get_id(), { 0.0f, -4.0f, 0.0f });
+	ecs.update_world_transforms();
+	RenderFrame second;
+	builder.build(ecs, second);
+	ASSERT_TRUE(second.renderables[0].world_bounds);
+	EXPECT_EQ(second.renderables[0].world_bounds->min_bound, local_bounds.min_bound + glm::vec3(0.0f, -4.0f, 0.0f));
+}
+
+TEST(RenderFramePool, steady_state_ticks_build_frames_without_allocating)
+{
+	FrameTickGameEngine engine;
+	ECS& ecs = engine.get_ecs();
+	std::vector<ObjectID> objects;
+	const auto template_renderable = Renderable::make_default(
+		ecs, ecs.get_mesh_system().add(MeshFactory::cube()));
+	for (size_t index = 0; index < 2 * RenderableStateList::CHUNK_SIZE; ++index)
+	{
+		objects.push_back(engine.spawn_object<Object>().get_id());
+		ecs.add_renderable(template_renderable, objects.back());
+	}
+	// enough skeletons for the frame builder to split them across the pool
+	Bone bone;
+	bone.name = "root";
+	auto skinned_renderable = template_renderable;
+	skinned_renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+	std::vector<SkeletonID> skeleton_ids;
+	for (size_t index = 0; index < 2 * RenderFrameBuilder::MIN_SKELETONS_PER_TASK + 1; ++index)
+	{
+		skeleton_ids.push_back(ecs.add_skeleton({ bone }));
+		ecs.add_renderable(skinned_renderable, objects[index], skeleton_ids.back());
+	}
+	// long-lived particles that fill every emitter during the warm-up, more
+	// than one task's worth in total
+	const ParticleEmitterConfig emitter_config{
+		.max_particles = 1024,
+		.emission_rate = 1024.0f * 60.0f / 4.0f,
+		.min_lifetime = 100.0f,
+		.max_lifetime = 100.0f,
+	};
+	constexpr size_t emitter_count = 8;
+	for (size_t index = 0; index < emitter_count; ++index)
+		engine.spawn_particle_emitter(emitter_config);
+	engine.highlight_object(*engine.get_object(objects[0]));
+	engine.highlight_object(*engine.get_object(objects[1]));
+
+	CompletedRenderFramesPtr consumed;
+	// moves one object and a bone, then ticks the ECS, publishes a frame and
+	// consumes it
+	const auto tick = [&](const size_t tick_index)
+	{
+		const float offset = static_cast<float>(tick_index);
+		ecs.set_position(objects[tick_index % objects.size()], { offset, 0.0f, 0.0f });
+		ecs.get_skeletal_component(skeleton_ids[0]).get_bone_local_transform(0).set_pos({ 0.0f, offset, 0.0f });
+		ecs.process(1.0f / 60.0f);
+		engine.publish_completed_render_frame();
+		consumed = engine.get_graphics_engine().load_latest_completed_render_frames();
+	};
+
+	constexpr size_t warm_up_ticks = 16;
+	constexpr size_t counted_ticks = 64;
+	for (size_t tick_index = 0; tick_index < warm_up_ticks; ++tick_index)
+		tick(tick_index);
+	counting_allocations = true;
+	for (size_t tick_index = warm_up_ticks; tick_index < warm_up_ticks + counted_ticks; ++tick_index)
+		tick(tick_index);
+	counting_allocations = false;
+
+	EXPECT_EQ(counted_allocations.load(), 0u);
+	ASSERT_NE(consumed, nullptr);
+	ASSERT_NE(consumed->previous, nullptr);
+	EXPECT_EQ(consumed->current->frame_number, consumed->previous->frame_number + 1);
+	const size_t last_tick = warm_up_ticks + counted_ticks - 1;
+	const size_t moved_index = last_tick % objects.size();
+	const auto moved = std::ranges::find_if(consumed->current->renderables, [&](const auto& renderable)
+	{
+		return renderable.definition->object_id == objects[moved_index];
+	});
+	ASSERT_NE(moved, consumed->current->renderables.end());
+	EXPECT_TRUE(matrices_are_equal(
+		moved->model_transform, translation({ static_cast<float>(last_tick), 0.0f, 0.0f })));
+	ASSERT_EQ(consumed->current->skeletons.size(), skeleton_ids.size());
+	const auto posed = std::ranges::find_if(consumed->current->skeletons, [&](const RenderSkeletonPose& pose)
+	{
+		return pose.definition->id == skeleton_ids[0];
+	});
+	ASSERT_NE(posed, consumed->current->skeletons.end());
+	EXPECT_TRUE(matrices_are_equal(
+		posed->local_transforms[0], translation({ 0.0f, static_cast<float>(last_tick), 0.0f })));
+	EXPECT_EQ(consumed->current->particles.size(), emitter_count * emitter_config.max_particles);
+	EXPECT_EQ(consumed->current->view.stenciled_objects,
+		(std::unordered_set<ObjectID>{ objects[0], objects[1] }));
+}
+
+TEST(RenderFrameBuilder, publishes_skinning_matrices_composed_on_the_task_pool)
+{
+	ECS ecs;
+	Object object;
+	ecs.add_object(object);
+	auto skinned_renderable = Renderable::make_default(
+		ecs, ecs.get_mesh_system().add(MeshFactory::cube()));
+	skinned_renderable.pipeline_render_type = ERenderType::SKINNED_COLOR;
+
+	// enough skeletons to be split across the workers, with children listed
+	// before their parents
+	std::vector<SkeletonID> skeleton_ids;
+	for (int skeleton = 0; skeleton < 50; ++skeleton)
+	{
+		std::vector<Bone> bones(3);
+		bones[0].parent_node = 2;
+		bones[2].parent_node = 1;
+		for (size_t bone = 0; bone < bones.size(); ++bone)
+		{
+			bones[bone].name = "bone" + std::to_string(bone);
+			bones[bone].relative_transform.set_pos({ static_cast<float>(skeleton), static_cast<float>(bone), 0.0f });
+			bones[bone].inverse_bind_pose.set_pos({ 0.0f, 0.0f, -static_cast<float>(bone) });
+		}
+		skeleton_ids.push_back(ecs.add_skeleton(bones));
+		ecs.add_renderable(skinned_renderable, object.get_id(), skeleton_ids.back());
+	}
+
+	TaskPool pool(4);
+	RenderFrameBuilder builder;
+	builder.set_task_pool(pool);
+	RenderFrame frame;
+	builder.build(ecs, frame);
+
+	ASSERT_EQ(frame.skeletons.size(), skeleton_ids.size());
+	for (const auto& pose : frame.skeletons)
+	{
+		const auto expected = ecs.get_skeletal_component(pose.definition->id).get_bones_data();
+		ASSERT_EQ(pose.bones.size(), expected.size());
+		for (size_t bone = 0; bone < expected.size(); ++bone)
+		{
+			EXPECT_TRUE(matrices_are_equal(pose.bones[bone].final_transform, expected[bone].final_transform));
+			EXPECT_TRUE(matrices_are_equal(pose.bones[bone].inverse_transform, expected[bone].inverse_transform));
+		}
+	}
+}
+
 TEST(RenderFrameMailbox, publishes_immutable_latest_completed_frame_pair)
 {
 	static_assert(std::is_same_v<RenderFramePtr::element_type, const RenderFrame>);
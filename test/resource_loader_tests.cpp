@@ -7,13 +7,17 @@
 #include <entity_component_system/mesh_system.hpp>
 #include <renderable/material_factory.hpp>
 #include <serialization/resource_provenance.hpp>
+#include <task_pool.hpp>
 
 #include <gtest/gtest.h>
 #include <nlohmann/json.hpp>
 #include <tiny_gltf.h>
 
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <fstream>
+#include <future>
 
 namespace
 {
@@ -895,6 +899,28 @@ TEST(ResourceLoaderTextures, fetch_same_texture_path_twice_registers_independent
 		general_loader_ecs.get_material_system().get(second->get_id())).source, texture_path);
 }
 
+TEST(ResourceLoaderTextures, processes_decoded_textures_unless_asked_not_to)
+{
+	const auto processed = ResourceLoader::fetch_texture(general_loader_ecs.get_material_system(), "texture.jpg");
+	const auto& texture = dynamic_cast<const TextureMaterial&>(
+		general_loader_ecs.get_material_system().get(processed->get_id()));
+	EXPECT_EQ(texture.format, ETextureFormat::BC7);
+	EXPECT_EQ(texture.mip_sizes.size(), TextureProcessor::get_mip_count(texture.width, texture.height));
+	EXPECT_EQ(texture.mip_sizes.front(), TextureProcessor::get_level_size(
+		ETextureFormat::BC7, texture.width, texture.height));
+	const auto* provenance = ResourceProvenance::material(processed->get_id());
+	ASSERT_NE(provenance, nullptr);
+	EXPECT_EQ(provenance->texture_processing, static_cast<int>(ETextureProcessing::DEFAULT));
+
+	const auto raw = ResourceLoader::fetch_texture(general_loader_ecs.get_material_system(), "texture.jpg",
+		ETextureSemantic::BASE_COLOR, ETextureProcessing::NONE);
+	const auto& raw_texture = dynamic_cast<const TextureMaterial&>(
+		general_loader_ecs.get_material_system().get(raw->get_id()));
+	EXPECT_EQ(raw_texture.format, ETextureFormat::RGBA8);
+	EXPECT_EQ(raw_texture.mip_sizes, (std::vector<size_t>{ raw_texture.data_len }));
+	EXPECT_EQ(raw_texture.data_len, static_cast<size_t>(raw_texture.width) * raw_texture.height * 4);
+}
+
 TEST(ResourceLoaderTextures, loads_texture_variants_by_semantic)
 {
 	constexpr uint32_t DXT5 = 0x35545844;
@@ -1462,3 +1488,121 @@ TEST(ResourceLoaderVariants, strict_mode_turns_import_warnings_into_errors)
 		ResourceLoader::load_model(general_loader_ecs, "import_variants.gltf", options),
 		ResourceLoadError);
 }
+
+TEST(ResourceLoaderAsync, concurrent_imports_match_serial_loads)
+{
+	const std::vector<std::string> models{
+		"simple_test_model.gltf",
+		"static_mesh_textured.gltf",
+		"multi_mesh_multi_primitive.gltf",
+		"skinned_normal_mapped_missing_tangents.gltf",
+		"import_variants.gltf",
+	};
+	ResourceLoader::LoadOptions options;
+	options.generate_missing_tangents = true;
+	options.use_derived_data_cache = false;
+	options.prefetch_pick_data = true;
+	TaskPool pool(4);
+	ECS ecs;
+	std::vector<ResourceLoader::PendingModel> pending;
+	for (int repeat = 0; repeat < 2; ++repeat)
+		for (const auto& model : models)
+			pending.push_back(ResourceLoader::load_model_async(ecs, model, options, pool));
+
+	for (size_t index = 0; index < pending.size(); ++index)
+	{
+		SCOPED_TRACE(models[index % models.size()]);
+		const auto serial = ResourceLoader::load_model(ecs, models[index % models.size()], options);
+		const auto parallel = pending[index].get();
+		// collecting the model consumes the pending import
+		EXPECT_FALSE(pending[index].is_ready());
+		ASSERT_EQ(serial.warnings.size(), parallel.warnings.size());
+		for (size_t warning = 0; warning < serial.warnings.size(); ++warning)
+			EXPECT_EQ(serial.warnings[warning].message, parallel.warnings[warning].message);
+		ASSERT_EQ(serial.meshes.size(), parallel.meshes.size());
+		for (size_t mesh = 0; mesh < serial.meshes.size(); ++mesh)
+		{
+			EXPECT_EQ(serial.meshes[mesh].name, parallel.meshes[mesh].name);
+			EXPECT_EQ(serial.meshes[mesh].skeleton_id.has_value(), parallel.meshes[mesh].skeleton_id.has_value());
+			ASSERT_EQ(serial.meshes[mesh].renderables.size(), parallel.meshes[mesh].renderables.size());
+			for (size_t renderable = 0; renderable < serial.meshes[mesh].renderables.size(); ++renderable)
+			{
+				const auto& expected = serial.meshes[mesh].renderables[renderable];
+				const auto& actual = parallel.meshes[mesh].renderables[renderable];
+				EXPECT_EQ(expected.pipeline_render_type, actual.pipeline_render_type);
+				EXPECT_EQ(expected.material_owners.size(), actual.material_owners.size());
+				const auto& expected_mesh = expected.mesh_owner->get();
+				const auto& actual_mesh = actual.mesh_owner->get();
+				EXPECT_TRUE(actual_mesh.is_pick_data_ready());
+				ASSERT_EQ(expected_mesh.get_vertices_data_size(), actual_mesh.get_vertices_data_size());
+				ASSERT_EQ(expected_mesh.get_indices_data_size(), actual_mesh.get_indices_data_size());
+				EXPECT_EQ(std::memcmp(expected_mesh.get_vertices_data(), actual_mesh.get_vertices_data(),
+					expected_mesh.get_vertices_data_size()), 0);
+				EXPECT_EQ(std::memcmp(expected_mesh.get_indices_data(), actual_mesh.get_indices_data(),
+					expected_mesh.get_indices_data_size()), 0);
+				for (size_t semantic = 0; semantic < static_cast<size_t>(ETextureSemantic::COUNT); ++semantic)
+				{
+					const auto* expected_texture = find_texture_material(expected, static_cast<ETextureSemantic>(semantic));
+					const auto* actual_texture = find_texture_material(actual, static_cast<ETextureSemantic>(semantic));
+					ASSERT_EQ(expected_texture == nullptr, actual_texture == nullptr);
+					if (!expected_texture)
+						continue;
+					EXPECT_EQ(expected_texture->format, actual_texture->format);
+					ASSERT_EQ(expected_texture->data_len, actual_texture->data_len);
+					EXPECT_EQ(std::memcmp(expected_texture->data->get(), actual_texture->data->get(),
+						expected_texture->data_len), 0);
+				}
+			}
+		}
+	}
+}
+
+TEST(ResourceLoaderAsync, errors_are_reported_when_collected)
+{
+	TaskPool pool(2);
+	ECS ecs;
+	auto missing = ResourceLoader::load_model_async(ecs, "does_not_exist.gltf", {}, pool);
+	MutatedGltf invalid_index([](nlohmann::json& document)
+	{
+		document["meshes"][0]["primitives"][0]["attributes"]["POSITION"] = 99;
+	});
+	auto invalid = ResourceLoader::load_model_async(ecs, invalid_index.filename(), {}, pool);
+	ResourceLoader::LoadOptions strict;
+	strict.strict = true;
+	auto warned = ResourceLoader::load_model_async(ecs, "import_variants.gltf", strict, pool);
+
+	EXPECT_THROW(missing.get(), ResourceLoadError);
+	EXPECT_THROW(invalid.get(), ResourceLoadError);
+	EXPECT_THROW(warned.get(), ResourceLoadError);
+	EXPECT_THROW(missing.get(), std::logic_error);
+}
+
+TEST(ResourceLoaderAsync, collecting_runs_only_its_own_import)
+{
+	TaskPool pool(1);
+	ECS ecs;
+	std::promise<void> release;
+	std::promise<void> started;
+	auto blocker = pool.submit([&started, released = release.get_future()]()
+	{
+		started.set_value();
+		released.wait();
+	});
+	started.get_future().wait();
+	// queued ahead of the import, as another model's texture encode might be
+	std::atomic<bool> unrelated_ran = false;
+	auto unrelated = pool.submit([&unrelated_ran]() { unrelated_ran = true; });
+	ResourceLoader::LoadOptions options;
+	options.use_derived_data_cache = false;
+	auto pending = ResourceLoader::load_model_async(ecs, "simple_test_model.gltf", options, pool);
+
+	// the only worker is busy, so the import runs here, and nothing else does
+	const auto loaded = pending.get();
+	EXPECT_FALSE(loaded.meshes.empty());
+	EXPECT_FALSE(unrelated_ran);
+
+	release.set_value();
+	blocker.get();
+	unrelated.get();
+	EXPECT_TRUE(unrelated_ran);
+}
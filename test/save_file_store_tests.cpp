@@ -73,3 +73,17 @@ TEST_F(SaveFileStoreTests, discovers_and_deletes_quicksave_without_escaping_root
 	EXPECT_FALSE(std::filesystem::exists(root / "quicksave"));
 	EXPECT_THROW(store.remove("../outside"), std::invalid_argument);
 }
+
+TEST_F(SaveFileStoreTests, finds_binary_scenes_before_yaml_exports)
+{
+	write("exported");
+	std::filesystem::create_directory(root / "binary");
+	std::ofstream(root / "binary" / "scene.bin") << "KRISPS01";
+	std::ofstream(root / "exported" / "scene.bin") << "KRISPS01";
+
+	EXPECT_EQ(SaveFileStore::find_scene(root / "exported"), root / "exported" / "scene.bin");
+	std::filesystem::remove(root / "exported" / "scene.bin");
+	EXPECT_EQ(SaveFileStore::find_scene(root / "exported"), root / "exported" / "scene.yaml");
+	EXPECT_TRUE(SaveFileStore::find_scene(root / "missing").empty());
+	EXPECT_EQ(SaveFileStore(root).list().size(), 2u);
+}
@@ -12,6 +12,7 @@
 #include <concepts>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 
 namespace
 {
@@ -308,3 +309,77 @@ TEST_F(SceneResourcesTests, rejects_truncated_mesh_data)
 
 	EXPECT_THROW(reader.prepare(saved), SerializationError);
 }
+
+TEST_F(SceneResourcesTests, rejects_out_of_range_mesh_indices)
+{
+	ECS source;
+	auto mesh = source.get_mesh_system().add(MeshFactory::cube());
+	Serializer document;
+	SceneResourceWriter writer(document, source, directory);
+	writer.write_mesh_reference(document.map("mesh"), mesh->get_id());
+	const auto saved = Deserializer::parse(document.emit());
+	const auto file = saved.child("resources").child("meshes").elements()[0].read<std::string>("file");
+	// Indices are last in the file, so this overwrites the final one
+	std::fstream stream(directory / file, std::ios::binary | std::ios::in | std::ios::out);
+	stream.seekp(-4, std::ios::end);
+	stream.write("\xff\xff\xff\x00", 4);
+	stream.close();
+	ECS restored;
+	SceneResourceReader reader(restored, directory);
+
+	EXPECT_THROW(reader.prepare(saved), SerializationError);
+}
+
+TEST_F(SceneResourcesTests, restored_texture_payload_outlives_its_file)
+{
+	ECS source;
+	auto texture = std::make_unique<TextureMaterial>();
+	texture->width = 2;
+	texture->height = 1;
+	texture->channels = 4;
+	texture->data_len = 8;
+	texture->mip_sizes = {8};
+	texture->source = "generated";
+	const std::vector<std::byte> pixels{std::byte{8}, std::byte{7}, std::byte{6}, std::byte{5},
+	                                    std::byte{4}, std::byte{3}, std::byte{2}, std::byte{1}};
+	texture->data = std::make_unique<OwnedTextureData>(pixels);
+	auto texture_owner = source.get_material_system().add(std::move(texture));
+	Serializer document;
+	SceneResourceWriter writer(document, source, directory);
+	writer.write_material_reference(document.map("texture"), texture_owner->get_id());
+	const auto saved = Deserializer::parse(document.emit());
+	ECS restored;
+	SceneResourceReader reader(restored, directory);
+	reader.prepare(saved);
+	const auto restored_texture = reader.read_material_reference(saved.child("texture"));
+	// The payload is mapped rather than read, and the mapping is held by the
+	// material, so deleting the save must not affect it
+	std::filesystem::remove_all(directory);
+
+	const auto &texture_value = dynamic_cast<const TextureMaterial &>(restored_texture->get());
+	ASSERT_EQ(texture_value.data_len, pixels.size());
+	EXPECT_EQ(std::memcmp(texture_value.data->get(), pixels.data(), pixels.size()), 0);
+}
+
+TEST_F(SceneResourcesTests, rejects_texture_payload_of_the_wrong_size)
+{
+	ECS source;
+	auto texture = std::make_unique<TextureMaterial>();
+	texture->width = 1;
+	texture->height = 1;
+	texture->channels = 4;
+	texture->data_len = 4;
+	texture->source = "generated";
+	texture->data = std::make_unique<OwnedTextureData>(std::vector<std::byte>(4, std::byte{9}));
+	auto texture_owner = source.get_material_system().add(std::move(texture));
+	Serializer document;
+	SceneResourceWriter writer(document, source, directory);
+	writer.write_material_reference(document.map("texture"), texture_owner->get_id());
+	const auto saved = Deserializer::parse(document.emit());
+	const auto file = saved.child("resources").child("materials").elements()[0].read<std::string>("file");
+	std::filesystem::resize_file(directory / file, 2);
+	ECS restored;
+	SceneResourceReader reader(restored, directory);
+
+	EXPECT_THROW(reader.prepare(saved), SerializationError);
+}
@@ -8,8 +8,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <limits>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -101,6 +103,151 @@ TEST(Serialization, ReportsPathsForInvalidOperations)
 	EXPECT_THROW(Deserializer::parse("mapping: [unterminated"), SerializationError);
 }
 
+namespace
+{
+Serializer make_scalar_document()
+{
+	Serializer serializer;
+	serializer.write("signed_min", std::numeric_limits<std::int64_t>::min());
+	serializer.write("unsigned_max", std::numeric_limits<std::uint64_t>::max());
+	serializer.write("enabled", true);
+	serializer.write("ratio", 0.1f);
+	serializer.write("name", "brass");
+	serializer.write_null("nothing");
+	auto values = serializer.map("outer").sequence("values");
+	values.append(-3);
+	values.append_null();
+	values.append_sequence().append("last");
+	return serializer;
+}
+
+void expect_scalar_document(const Deserializer& document)
+{
+	EXPECT_EQ(document.keys(), (std::vector<std::string>{
+		"signed_min", "unsigned_max", "enabled", "ratio", "name", "nothing", "outer" }));
+	EXPECT_EQ(document.read<std::int64_t>("signed_min"), std::numeric_limits<std::int64_t>::min());
+	EXPECT_EQ(document.read<std::uint64_t>("unsigned_max"), std::numeric_limits<std::uint64_t>::max());
+	EXPECT_TRUE(document.read<bool>("enabled"));
+	EXPECT_EQ(document.read<float>("ratio"), 0.1f);
+	EXPECT_EQ(document.read<std::string>("name"), "brass");
+	EXPECT_EQ(document.child("nothing").kind(), SerializationKind::Null);
+	const auto elements = document.child("outer").child("values").elements();
+	ASSERT_EQ(elements.size(), 3);
+	EXPECT_EQ(elements[0].as<int>(), -3);
+	EXPECT_EQ(elements[0].as<double>(), -3.0);
+	EXPECT_EQ(elements[1].kind(), SerializationKind::Null);
+	EXPECT_EQ(elements[2].elements()[0].as<std::string>(), "last");
+	EXPECT_EQ(elements[2].elements()[0].path(), "$.outer.values[2][0]");
+}
+}
+
+TEST(Serialization, BinaryAndYamlDocumentsReadTheSame)
+{
+	const auto serializer = make_scalar_document();
+	expect_scalar_document(Deserializer::parse(serializer.emit()));
+	expect_scalar_document(Deserializer::parse_binary(serializer.emit_binary()));
+}
+
+TEST(Serialization, BinaryInternsRepeatedStrings)
+{
+	Serializer serializer;
+	auto materials = serializer.sequence("material_system");
+	for (int index = 0; index < 1'000; ++index) {
+		auto material = materials.append_map();
+		material.write("material_name", "polished_brass");
+		material.write("texture_semantic", "base_color");
+	}
+
+	const auto bytes = serializer.emit_binary();
+	EXPECT_LT(bytes.size(), 1'000 * (sizeof("polished_brass") + sizeof("base_color")));
+	const auto document = Deserializer::parse_binary(bytes);
+	const auto elements = document.child("material_system").elements();
+	ASSERT_EQ(elements.size(), 1'000);
+	EXPECT_EQ(elements.back().read<std::string>("material_name"), "polished_brass");
+}
+
+TEST(Serialization, BinaryRejectsCorruptDocuments)
+{
+	Serializer serializer;
+	serializer.sequence("a").append(7);
+	const auto bytes = serializer.emit_binary();
+	ASSERT_NO_THROW(static_cast<void>(Deserializer::parse_binary(bytes)));
+
+	for (std::size_t length = 0; length < bytes.size(); ++length)
+		EXPECT_THROW(static_cast<void>(Deserializer::parse_binary(std::span(bytes).first(length))), SerializationError);
+
+	auto trailing = bytes;
+	trailing.push_back(std::byte{ 0 });
+	EXPECT_THROW(static_cast<void>(Deserializer::parse_binary(trailing)), SerializationError);
+
+	auto version = bytes;
+	version[8] = std::byte{ 2 };
+	EXPECT_THROW(static_cast<void>(Deserializer::parse_binary(version)), SerializationError);
+
+	// magic, version, one string "a", root tag and count, then the key of the
+	// root's only chunk followed by its length
+	constexpr std::size_t chunk_length = 8 + 4 + 4 + 4 + 1 + 1 + 4 + 4;
+	auto chunk = bytes;
+	chunk[chunk_length] = static_cast<std::byte>(std::to_integer<int>(chunk[chunk_length]) - 1);
+	try {
+		static_cast<void>(Deserializer::parse_binary(chunk));
+		FAIL() << "Expected a chunk length mismatch to fail";
+	} catch (const SerializationError& error) {
+		EXPECT_NE(std::string(error.what()).find("$.a"), std::string::npos);
+	}
+
+	// Flipping any byte must be rejected or decode to some document, never
+	// read out of bounds
+	for (std::size_t index = 0; index < bytes.size(); ++index) {
+		auto flipped = bytes;
+		flipped[index] ^= std::byte{ 0xff };
+		try {
+			static_cast<void>(Deserializer::parse_binary(flipped));
+		} catch (const SerializationError&) {
+		}
+	}
+}
+
+TEST(Serialization, BinaryRejectsDuplicateMappingKeys)
+{
+	Serializer serializer;
+	serializer.write("a", 1);
+	serializer.write("b", 2);
+	auto bytes = serializer.emit_binary();
+	ASSERT_NO_THROW(static_cast<void>(Deserializer::parse_binary(bytes)));
+
+	// magic, version, strings "a" and "b", root tag and count, then the first
+	// chunk's key, length and integer, after which comes the second key
+	constexpr std::size_t first_key = 8 + 4 + 4 + 5 + 5 + 1 + 4;
+	constexpr std::size_t second_key = first_key + 4 + 8 + 9;
+	std::copy_n(bytes.begin() + first_key, 4, bytes.begin() + second_key);
+	try {
+		static_cast<void>(Deserializer::parse_binary(bytes));
+		FAIL() << "Expected a duplicate key to fail";
+	} catch (const SerializationError& error) {
+		EXPECT_NE(std::string(error.what()).find("$.a"), std::string::npos);
+	}
+}
+
+TEST(Serialization, BinaryReportsPathsForInvalidReads)
+{
+	Serializer serializer;
+	auto material = serializer.sequence("material_system").append_map();
+	material.write("material_id", 7);
+	material.write("layer", 300);
+	const auto document = Deserializer::parse_binary(serializer.emit_binary());
+
+	EXPECT_THROW(document.child("missing"), SerializationError);
+	try {
+		document.child("material_system").elements()[0].read<bool>("material_id");
+		FAIL() << "Expected type mismatch to fail";
+	} catch (const SerializationError& error) {
+		EXPECT_NE(std::string(error.what()).find("$.material_system[0].material_id"), std::string::npos);
+	}
+	EXPECT_THROW(document.child("material_system").elements()[0].read<std::uint8_t>("layer"), SerializationError);
+	EXPECT_THROW(document.child("material_system").child("material_id"), SerializationError);
+}
+
 TEST(Serialization, GenericIdCounterCanBeSetExplicitly)
 {
 	using TestID = GenericID<class SerializationCounterTestTag>;
@@ -0,0 +1,87 @@
+#include <task_pool.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+TEST(TaskPool, parallel_for_runs_every_index_once)
+{
+	TaskPool pool(3);
+	std::vector<std::atomic<int>> visits(1000);
+	pool.parallel_for(visits.size(), 1, [&visits](const size_t first, const size_t last)
+	{
+		for (size_t index = first; index < last; ++index)
+			++visits[index];
+	});
+
+	for (const auto& count : visits)
+		EXPECT_EQ(count, 1);
+}
+
+TEST(TaskPool, parallel_for_nests_and_runs_without_workers)
+{
+	for (const uint32_t worker_count : { 0u, 2u })
+	{
+		TaskPool pool(worker_count);
+		std::atomic<size_t> total = 0;
+		pool.parallel_for(8, 1, [&](const size_t first, const size_t last)
+		{
+			for (size_t outer = first; outer < last; ++outer)
+				pool.parallel_for(100, 1, [&total](const size_t inner_first, const size_t inner_last)
+				{
+					total += inner_last - inner_first;
+				});
+		});
+		EXPECT_EQ(total, 800u);
+	}
+}
+
+TEST(TaskPool, parallel_for_rethrows_once_every_range_has_run)
+{
+	TaskPool pool(2);
+	std::atomic<size_t> ran = 0;
+	EXPECT_THROW(pool.parallel_for(64, 1, [&ran](const size_t first, const size_t last)
+	{
+		ran += last - first;
+		if (first == 0)
+			throw std::runtime_error("range failed");
+	}), std::runtime_error);
+	EXPECT_EQ(ran, 64u);
+}
+
+TEST(TaskPool, parallel_for_never_runs_queued_tasks)
+{
+	TaskPool pool(1);
+	std::promise<void> release;
+	std::promise<void> started;
+	auto blocker = pool.submit([&started, released = release.get_future()]()
+	{
+		started.set_value();
+		released.wait();
+	});
+	started.get_future().wait();
+	// such as a model import queued while the worker is busy
+	std::atomic<bool> import_ran = false;
+	auto import = pool.submit([&import_ran]() { import_ran = true; });
+
+	const auto caller = std::this_thread::get_id();
+	std::atomic<size_t> ranges_elsewhere = 0;
+	pool.parallel_for(64, 1, [&](size_t, size_t)
+	{
+		EXPECT_FALSE(import_ran);
+		if (std::this_thread::get_id() != caller)
+			++ranges_elsewhere;
+	});
+	EXPECT_FALSE(import_ran);
+	EXPECT_EQ(ranges_elsewhere, 0u);
+
+	release.set_value();
+	import.get();
+	blocker.get();
+	EXPECT_TRUE(import_ran);
+}
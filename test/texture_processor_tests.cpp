@@ -0,0 +1,220 @@
+#include "renderable/texture_processor.hpp"
+#include "task_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace
+{
+std::vector<std::byte> make_pixels(const uint32_t width, const uint32_t height, const bool translucent)
+{
+	std::vector<std::byte> pixels(static_cast<size_t>(width) * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			std::byte* pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+			pixel[0] = static_cast<std::byte>(x * 255 / std::max(width - 1, 1u));
+			pixel[1] = static_cast<std::byte>(y * 255 / std::max(height - 1, 1u));
+			pixel[2] = static_cast<std::byte>(128 + std::lround(100.0f * std::sin(x * 0.05f + y * 0.03f)));
+			pixel[3] = static_cast<std::byte>(translucent ? (x + y) * 255 / std::max(width + height - 2, 1u) : 255);
+		}
+	}
+	return pixels;
+}
+
+std::vector<std::byte> round_trip(const ETextureFormat format, const std::vector<std::byte>& pixels,
+	const uint32_t width, const uint32_t height, TaskPool& pool)
+{
+	std::vector<std::byte> blocks(TextureProcessor::get_level_size(format, width, height));
+	TextureProcessor::compress_level(format, pixels, width, height, blocks, pool);
+	std::vector<std::byte> decoded(pixels.size());
+	TextureProcessor::decompress_level(format, blocks, width, height, decoded);
+	return decoded;
+}
+
+double psnr(const std::vector<std::byte>& expected, const std::vector<std::byte>& actual, const size_t channels)
+{
+	double squared_error = 0.0;
+	size_t count = 0;
+	for (size_t index = 0; index < expected.size(); ++index)
+	{
+		if (index % 4 >= channels)
+			continue;
+		const double difference = std::to_integer<int>(expected[index]) - std::to_integer<int>(actual[index]);
+		squared_error += difference * difference;
+		++count;
+	}
+	if (squared_error == 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0 * std::log10(255.0 * 255.0 / (squared_error / static_cast<double>(count)));
+}
+
+TextureMaterial make_texture(const ETextureSemantic semantic, const uint32_t width, const uint32_t height,
+	const bool translucent)
+{
+	auto pixels = make_pixels(width, height, translucent);
+	TextureMaterial texture;
+	texture.semantic = semantic;
+	texture.width = width;
+	texture.height = height;
+	texture.data_len = pixels.size();
+	texture.mip_sizes = { pixels.size() };
+	texture.data = std::make_unique<OwnedTextureData>(std::move(pixels));
+	return texture;
+}
+}
+
+TEST(TextureProcessor, counts_and_sizes_levels)
+{
+	EXPECT_EQ(TextureProcessor::get_mip_count(1, 1), 1u);
+	EXPECT_EQ(TextureProcessor::get_mip_count(256, 64), 9u);
+	EXPECT_EQ(TextureProcessor::get_mip_count(300, 200), 9u);
+	EXPECT_EQ(TextureProcessor::get_level_size(ETextureFormat::RGBA8, 3, 5), 60u);
+	EXPECT_EQ(TextureProcessor::get_level_size(ETextureFormat::BC1, 5, 3), 16u);
+	EXPECT_EQ(TextureProcessor::get_level_size(ETextureFormat::BC7, 1, 1), 16u);
+	EXPECT_EQ(TextureProcessor::get_level_size(ETextureFormat::BC5, 8, 8), 64u);
+}
+
+TEST(TextureProcessor, filters_srgb_colour_in_linear_space)
+{
+	TaskPool pool(0);
+	std::vector<std::byte> checker(2 * 2 * 4, std::byte{255});
+	for (const size_t pixel : { 1, 2 })
+		for (size_t channel = 0; channel < 3; ++channel)
+			checker[pixel * 4 + channel] = std::byte{0};
+
+	const auto srgb = TextureProcessor::generate_mips(
+		checker, 2, 2, ETextureSemantic::BASE_COLOR, TextureProcessor::EMipFilter::BOX, pool);
+	ASSERT_EQ(srgb.mip_sizes, (std::vector<size_t>{ 16, 4 }));
+	EXPECT_EQ(std::vector<std::byte>(srgb.data.begin(), srgb.data.begin() + 16), checker);
+	// half the light of white, not half its encoded value
+	EXPECT_EQ(std::to_integer<int>(srgb.data[16]), 188);
+	EXPECT_EQ(std::to_integer<int>(srgb.data[19]), 255);
+
+	const auto linear = TextureProcessor::generate_mips(
+		checker, 2, 2, ETextureSemantic::METALLIC_ROUGHNESS, TextureProcessor::EMipFilter::BOX, pool);
+	EXPECT_EQ(std::to_integer<int>(linear.data[16]), 128);
+}
+
+TEST(TextureProcessor, keeps_constant_images_constant_through_every_level)
+{
+	TaskPool pool(0);
+	for (const int value : { 0, 1, 54, 128, 254, 255 })
+	{
+		const std::vector<std::byte> pixels(7 * 5 * 4, static_cast<std::byte>(value));
+		const auto chain = TextureProcessor::generate_mips(
+			pixels, 7, 5, ETextureSemantic::BASE_COLOR, TextureProcessor::EMipFilter::KAISER, pool);
+		ASSERT_EQ(chain.mip_sizes, (std::vector<size_t>{ 140, 24, 4 }));
+		for (const std::byte byte : chain.data)
+			EXPECT_EQ(std::to_integer<int>(byte), value);
+	}
+}
+
+TEST(TextureProcessor, renormalizes_normal_map_levels)
+{
+	TaskPool pool(2);
+	std::vector<std::byte> normals(8 * 8 * 4);
+	for (size_t pixel = 0; pixel < 64; ++pixel)
+	{
+		const float angle = static_cast<float>(pixel) * 0.7f;
+		const float x = 0.6f * std::cos(angle);
+		const float y = 0.6f * std::sin(angle);
+		normals[pixel * 4] = static_cast<std::byte>(std::lround((x * 0.5f + 0.5f) * 255.0f));
+		normals[pixel * 4 + 1] = static_cast<std::byte>(std::lround((y * 0.5f + 0.5f) * 255.0f));
+		normals[pixel * 4 + 2] = static_cast<std::byte>(std::lround((0.8f * 0.5f + 0.5f) * 255.0f));
+		normals[pixel * 4 + 3] = std::byte{255};
+	}
+
+	const auto chain = TextureProcessor::generate_mips(
+		normals, 8, 8, ETextureSemantic::NORMAL, TextureProcessor::EMipFilter::KAISER, pool);
+	ASSERT_EQ(chain.mip_sizes.size(), 4u);
+	for (size_t offset = chain.mip_sizes[0]; offset < chain.data.size(); offset += 4)
+	{
+		const auto component = [&](const size_t channel)
+		{
+			return std::to_integer<int>(chain.data[offset + channel]) / 255.0f * 2.0f - 1.0f;
+		};
+		const float length = std::sqrt(component(0) * component(0) + component(1) * component(1)
+			+ component(2) * component(2));
+		EXPECT_NEAR(length, 1.0f, 0.02f);
+	}
+}
+
+TEST(TextureProcessor, block_formats_round_trip_gradients)
+{
+	TaskPool pool(2);
+	const auto opaque = make_pixels(64, 64, false);
+	const auto translucent = make_pixels(64, 64, true);
+	EXPECT_GT(psnr(opaque, round_trip(ETextureFormat::BC1, opaque, 64, 64, pool), 3), 35.0);
+	EXPECT_GT(psnr(translucent, round_trip(ETextureFormat::BC3, translucent, 64, 64, pool), 4), 36.0);
+	EXPECT_GT(psnr(opaque, round_trip(ETextureFormat::BC5, opaque, 64, 64, pool), 2), 45.0);
+	EXPECT_GT(psnr(translucent, round_trip(ETextureFormat::BC7, translucent, 64, 64, pool), 4), 38.0);
+}
+
+TEST(TextureProcessor, encodes_partial_edge_blocks)
+{
+	TaskPool pool(0);
+	const auto pixels = make_pixels(6, 3, true);
+	for (const auto format : { ETextureFormat::BC1, ETextureFormat::BC3, ETextureFormat::BC5, ETextureFormat::BC7 })
+	{
+		const auto decoded = round_trip(format, pixels, 6, 3, pool);
+		EXPECT_GT(psnr(pixels, decoded, format == ETextureFormat::BC5 ? 2 : 3), 15.0);
+	}
+
+	const std::vector<std::byte> solid = { std::byte{10}, std::byte{200}, std::byte{77}, std::byte{255} };
+	const auto bc7 = round_trip(ETextureFormat::BC7, solid, 1, 1, pool);
+	for (size_t channel = 0; channel < 4; ++channel)
+		EXPECT_NEAR(std::to_integer<int>(bc7[channel]), std::to_integer<int>(solid[channel]), 1);
+}
+
+TEST(TextureProcessor, rejects_mismatched_levels)
+{
+	TaskPool pool(0);
+	const auto pixels = make_pixels(4, 4, false);
+	std::vector<std::byte> blocks(8);
+	EXPECT_THROW(TextureProcessor::compress_level(ETextureFormat::BC7, pixels, 4, 4, blocks, pool),
+		std::invalid_argument);
+	EXPECT_THROW(TextureProcessor::compress_level(ETextureFormat::RGBA8, pixels, 4, 4, blocks, pool),
+		std::invalid_argument);
+	EXPECT_THROW(TextureProcessor::generate_mips(pixels, 4, 3, ETextureSemantic::BASE_COLOR,
+		TextureProcessor::EMipFilter::BOX, pool), std::invalid_argument);
+}
+
+TEST(TextureProcessor, selects_formats_by_semantic)
+{
+	TaskPool pool(2);
+	auto base_color = make_texture(ETextureSemantic::BASE_COLOR, 20, 12, false);
+	TextureProcessor::process(base_color, {}, pool);
+	EXPECT_EQ(base_color.format, ETextureFormat::BC7);
+	EXPECT_EQ(base_color.mip_sizes, (std::vector<size_t>{ 240, 96, 32, 16, 16 }));
+	EXPECT_EQ(base_color.data_len, 400u);
+
+	auto normal = make_texture(ETextureSemantic::NORMAL, 8, 8, false);
+	TextureProcessor::process(normal, {}, pool);
+	EXPECT_EQ(normal.format, ETextureFormat::BC5);
+	EXPECT_EQ(normal.mip_sizes, (std::vector<size_t>{ 64, 16, 16, 16 }));
+
+	const TextureProcessor::Settings fast { .prefer_bc7 = false };
+	auto opaque = make_texture(ETextureSemantic::EMISSIVE, 8, 8, false);
+	TextureProcessor::process(opaque, fast, pool);
+	EXPECT_EQ(opaque.format, ETextureFormat::BC1);
+	EXPECT_EQ(opaque.mip_sizes, (std::vector<size_t>{ 32, 8, 8, 8 }));
+	auto translucent = make_texture(ETextureSemantic::BASE_COLOR, 8, 8, true);
+	TextureProcessor::process(translucent, fast, pool);
+	EXPECT_EQ(translucent.format, ETextureFormat::BC3);
+
+	auto uncompressed = make_texture(ETextureSemantic::METALLIC_ROUGHNESS, 4, 2, false);
+	TextureProcessor::process(uncompressed, { .compress = false }, pool);
+	EXPECT_EQ(uncompressed.format, ETextureFormat::RGBA8);
+	EXPECT_EQ(uncompressed.mip_sizes, (std::vector<size_t>{ 32, 8, 4 }));
+
+	EXPECT_THROW(TextureProcessor::process(base_color, {}, pool), std::invalid_argument);
+}
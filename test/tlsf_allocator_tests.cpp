@@ -0,0 +1,139 @@
+#include <graphics_engine/resource_manager/tlsf_allocator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+
+TEST(TlsfAllocator, allocates_sequentially_from_an_empty_buffer)
+{
+	TlsfAllocator allocator(100);
+
+	EXPECT_EQ(allocator.allocate(10), 0);
+	EXPECT_EQ(allocator.allocate(30), 10);
+	EXPECT_EQ(allocator.allocate(60), 40);
+	EXPECT_FALSE(allocator.allocate(1));
+}
+
+TEST(TlsfAllocator, merges_freed_neighbours)
+{
+	TlsfAllocator allocator(96);
+	const auto first = allocator.allocate(32);
+	const auto second = allocator.allocate(32);
+	const auto third = allocator.allocate(32);
+	ASSERT_TRUE(first && second && third);
+
+	allocator.free(*first);
+	allocator.free(*third);
+	EXPECT_EQ(allocator.get_stats().free_block_count, 2);
+	EXPECT_FALSE(allocator.allocate(64));
+
+	allocator.free(*second);
+	EXPECT_EQ(allocator.get_stats().free_block_count, 1);
+	EXPECT_EQ(allocator.allocate(96), 0);
+}
+
+TEST(TlsfAllocator, finds_a_fit_the_constant_time_search_rounds_past)
+{
+	// 101 and 102 share a bin, so a search for 101 starts from the next one up
+	TlsfAllocator allocator(202);
+	ASSERT_EQ(allocator.allocate(102), 0);
+	ASSERT_EQ(allocator.allocate(100), 102);
+	allocator.free(0);
+
+	EXPECT_EQ(allocator.allocate(101), 0);
+}
+
+TEST(TlsfAllocator, keeps_alignment_padding_free)
+{
+	TlsfAllocator allocator(256);
+	ASSERT_EQ(allocator.allocate(10), 0);
+
+	EXPECT_EQ(allocator.allocate(16, 64), 64);
+	// the padding between them is still usable
+	EXPECT_EQ(allocator.allocate(54), 10);
+	EXPECT_EQ(allocator.get_stats().used, 80);
+}
+
+TEST(TlsfAllocator, reports_fragmentation)
+{
+	TlsfAllocator allocator(100);
+	std::vector<uint32_t> offsets;
+	for (int i = 0; i < 10; ++i)
+		offsets.push_back(*allocator.allocate(10));
+	for (size_t i = 0; i < offsets.size(); i += 2)
+		allocator.free(offsets[i]);
+
+	const auto stats = allocator.get_stats();
+	EXPECT_EQ(stats.free, 50);
+	EXPECT_EQ(stats.used, 50);
+	EXPECT_EQ(stats.largest_free_block, 10);
+	EXPECT_EQ(stats.free_block_count, 5);
+	EXPECT_EQ(stats.allocation_count, 5);
+	EXPECT_FLOAT_EQ(stats.get_fragmentation(), 0.8f);
+	// enough free space in total, but not in one place
+	EXPECT_FALSE(allocator.allocate(20));
+}
+
+TEST(TlsfAllocator, plans_moves_that_pack_allocations)
+{
+	TlsfAllocator allocator(128);
+	const auto first = *allocator.allocate(16);
+	const auto second = *allocator.allocate(8);
+	const auto third = *allocator.allocate(8, 16);
+	ASSERT_EQ(third, 32);
+	allocator.free(first);
+
+	const auto moves = allocator.plan_defragmentation();
+	ASSERT_EQ(moves.size(), 2);
+	EXPECT_EQ(moves[0].from, second);
+	EXPECT_EQ(moves[0].to, 0);
+	EXPECT_EQ(moves[0].size, 8);
+	// keeps its alignment
+	EXPECT_EQ(moves[1].from, third);
+	EXPECT_EQ(moves[1].to, 16);
+}
+
+TEST(TlsfAllocator, survives_churn)
+{
+	TlsfAllocator allocator(1 << 20);
+	std::mt19937 random(7);
+	std::uniform_int_distribution<uint32_t> sizes(1, 4096);
+	std::vector<std::pair<uint32_t, uint32_t>> live;
+	size_t used = 0;
+	for (int i = 0; i < 20000; ++i)
+	{
+		if (!live.empty() && (random() % 2 == 0 || live.size() > 400))
+		{
+			const size_t index = random() % live.size();
+			allocator.free(live[index].first);
+			used -= live[index].second;
+			live[index] = live.back();
+			live.pop_back();
+			continue;
+		}
+		const uint32_t size = sizes(random);
+		const auto offset = allocator.allocate(size, 1u << (random() % 5));
+		ASSERT_TRUE(offset);
+		live.emplace_back(*offset, size);
+		used += size;
+	}
+	EXPECT_EQ(allocator.get_stats().used, used);
+
+	for (const auto& [offset, _] : live)
+		allocator.free(offset);
+	const auto stats = allocator.get_stats();
+	EXPECT_EQ(stats.free_block_count, 1);
+	EXPECT_EQ(stats.largest_free_block, 1 << 20);
+}
+
+TEST(TlsfAllocator, rejects_invalid_arguments)
+{
+	TlsfAllocator allocator(64);
+
+	EXPECT_THROW(allocator.allocate(0), std::invalid_argument);
+	EXPECT_THROW(allocator.allocate(8, 3), std::invalid_argument);
+	EXPECT_THROW(allocator.free(0), std::out_of_range);
+}
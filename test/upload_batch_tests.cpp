@@ -0,0 +1,133 @@
+#include <graphics_engine/resource_manager/upload_batch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+
+namespace
+{
+VkBuffer fake_buffer(const uintptr_t id)
+{
+	return reinterpret_cast<VkBuffer>(id);
+}
+
+VkBufferCopy region(const VkDeviceSize source, const VkDeviceSize destination, const VkDeviceSize size)
+{
+	return VkBufferCopy{ source, destination, size };
+}
+}
+
+TEST(StagingRing, allocates_aligned_offsets_in_order)
+{
+	StagingRing ring(256);
+
+	EXPECT_EQ(ring.allocate(10), 0);
+	EXPECT_EQ(ring.allocate(8, 16), 16);
+	EXPECT_EQ(ring.allocate(4, 4), 24);
+	EXPECT_EQ(ring.get_used(), 28);
+}
+
+TEST(StagingRing, refuses_space_until_older_allocations_are_released)
+{
+	StagingRing ring(100);
+	ASSERT_EQ(ring.allocate(60), 0);
+	const auto first_batch = ring.get_head();
+	ASSERT_EQ(ring.allocate(30), 60);
+
+	EXPECT_FALSE(ring.allocate(20));
+
+	ring.release_until(first_batch);
+	EXPECT_EQ(ring.get_used(), 30);
+	EXPECT_EQ(ring.allocate(20), 0);
+}
+
+TEST(StagingRing, never_straddles_the_end_of_the_buffer)
+{
+	StagingRing ring(100);
+	ring.allocate(70);
+	ring.release_until(ring.get_head());
+
+	// 40 bytes would run past the end, so the remaining 30 are skipped
+	EXPECT_EQ(ring.allocate(40), 0);
+	EXPECT_EQ(ring.get_used(), 70);
+}
+
+TEST(StagingRing, rejects_requests_larger_than_the_ring)
+{
+	StagingRing ring(64);
+
+	EXPECT_FALSE(ring.allocate(65));
+	EXPECT_EQ(ring.allocate(64), 0);
+}
+
+TEST(StagingRing, rejects_invalid_arguments)
+{
+	EXPECT_THROW(StagingRing(0), std::invalid_argument);
+
+	StagingRing ring(64);
+	EXPECT_THROW(ring.allocate(4, 3), std::invalid_argument);
+	EXPECT_THROW(ring.release_until(1), std::out_of_range);
+}
+
+TEST(UploadBatch, merges_contiguous_copies_between_the_same_buffers)
+{
+	UploadBatch batch;
+	const auto staging = fake_buffer(1);
+	const auto vertices = fake_buffer(2);
+	batch.add_buffer_copy(staging, vertices, region(0, 100, 16));
+	batch.add_buffer_copy(staging, vertices, region(16, 116, 16));
+	batch.add_buffer_copy(staging, vertices, region(32, 200, 16));
+
+	ASSERT_EQ(batch.get_passes().size(), 1);
+	const auto& buffers = batch.get_passes()[0].buffers;
+	ASSERT_EQ(buffers.size(), 1);
+	ASSERT_EQ(buffers[0].regions.size(), 2);
+	EXPECT_EQ(buffers[0].regions[0].size, 32);
+	EXPECT_EQ(buffers[0].regions[1].dstOffset, 200);
+	EXPECT_EQ(batch.get_copy_count(), 3);
+	EXPECT_EQ(batch.get_byte_count(), 48);
+}
+
+TEST(UploadBatch, groups_copies_by_destination)
+{
+	UploadBatch batch;
+	const auto staging = fake_buffer(1);
+	batch.add_buffer_copy(staging, fake_buffer(2), region(0, 0, 8));
+	batch.add_buffer_copy(staging, fake_buffer(3), region(8, 0, 8));
+	batch.add_buffer_copy(staging, fake_buffer(2), region(16, 64, 8));
+
+	ASSERT_EQ(batch.get_passes().size(), 1);
+	const auto& buffers = batch.get_passes()[0].buffers;
+	ASSERT_EQ(buffers.size(), 2);
+	EXPECT_EQ(buffers[0].regions.size(), 2);
+	EXPECT_EQ(buffers[1].regions.size(), 1);
+}
+
+TEST(UploadBatch, starts_a_new_pass_when_a_copy_overwrites_an_earlier_one)
+{
+	UploadBatch batch;
+	const auto staging = fake_buffer(1);
+	const auto uniforms = fake_buffer(2);
+	batch.add_buffer_copy(staging, uniforms, region(0, 0, 64));
+	batch.add_buffer_copy(staging, uniforms, region(64, 64, 64));
+	batch.add_buffer_copy(staging, uniforms, region(128, 96, 16));
+
+	ASSERT_EQ(batch.get_passes().size(), 2);
+	EXPECT_EQ(batch.get_passes()[1].buffers[0].regions[0].srcOffset, 128);
+}
+
+TEST(UploadBatch, skips_empty_copies_and_clears)
+{
+	UploadBatch batch;
+	batch.add_buffer_copy(fake_buffer(1), fake_buffer(2), region(0, 0, 0));
+	EXPECT_TRUE(batch.empty());
+
+	batch.add_image_copy(UploadBatch::ImageCopies{ fake_buffer(1), nullptr, 1, 1, 64, { VkBufferImageCopy{} } });
+	EXPECT_FALSE(batch.empty());
+	EXPECT_EQ(batch.get_copy_count(), 1);
+
+	batch.clear();
+	EXPECT_TRUE(batch.empty());
+	EXPECT_EQ(batch.get_byte_count(), 0);
+}